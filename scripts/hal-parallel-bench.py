@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+"""
+Wall-clock benchmark for threads with parallel helpers (workers1= of
+threads.so, servo_thread_workers= of motmod).
+
+Loads one thread with --chains independent servo loops, each a pid, a
+few biquad stages and a lowpass closing the loop, and reports the
+thread's run time (<thread>.time and .tmax, in CPU clocks) for each
+number of helpers.  Needs halrun in the PATH; on a realtime kernel give
+the helpers CPUs with isolcpus= for meaningful numbers.
+
+    hal-parallel-bench.py --chains 9 --workers 0,1,2,3
+"""
+
+import argparse
+import os
+import subprocess
+import tempfile
+
+
+def hal_config(args, workers):
+    n = args.chains
+    stages = args.stages
+    out = ["loadrt threads name1=bench period1=%d workers1=%d cpus1=%s"
+               % (args.period, workers, args.cpus),
+           "loadrt pid num_chan=%d" % n,
+           "loadrt biquad count=%d" % (n * stages),
+           "loadrt lowpass count=%d" % n]
+    for c in range(n):
+        out.append("setp pid.%d.Pgain 10" % c)
+        out.append("setp pid.%d.enable 1" % c)
+        out.append("setp lowpass.%d.gain 0.1" % c)
+        out.append("net cmd-%d pid.%d.command" % (c, c))
+        src = "pid.%d.output" % c
+        for s in range(stages):
+            b = c * stages + s
+            out.append("setp biquad.%d.enable 1" % b)
+            out.append("net s-%d-%d %s biquad.%d.in" % (c, s, src, b))
+            src = "biquad.%d.out" % b
+        out.append("net s-%d-%d %s lowpass.%d.in" % (c, stages, src, c))
+        out.append("net fb-%d lowpass.%d.out pid.%d.feedback" % (c, c, c))
+    # the functions of one loop together, like a typical servo thread
+    for c in range(n):
+        out.append("addf pid.%d.do-pid-calcs bench" % c)
+        for s in range(stages):
+            out.append("addf biquad.%d bench" % (c * stages + s))
+        out.append("addf lowpass.%d bench" % c)
+    out += ["start",
+            "loadusr -w sleep 1",
+            "setp bench.tmax 0",
+            "loadusr -w sleep %g" % args.seconds,
+            "getp bench.time",
+            "getp bench.tmax"]
+    return "\n".join(out) + "\n"
+
+
+def run(args, workers):
+    with tempfile.NamedTemporaryFile("w", suffix=".hal", delete=False) as f:
+        f.write(hal_config(args, workers))
+    try:
+        result = subprocess.run(["halrun", "-f", f.name], capture_output=True,
+                                text=True, check=True)
+    finally:
+        os.unlink(f.name)
+    values = [int(line) for line in result.stdout.split()
+              if line.lstrip("-").isdigit()]
+    if len(values) < 2:
+        raise SystemExit("unexpected halrun output:\n" + result.stdout +
+                         result.stderr)
+    return values[-2], values[-1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--chains", type=int, default=9)
+    parser.add_argument("--stages", type=int, default=4,
+            help="biquad stages per chain")
+    parser.add_argument("--period", type=int, default=1000000)
+    parser.add_argument("--seconds", type=float, default=5.0)
+    parser.add_argument("--cpus", default="spread",
+            help="CPUs for the thread itself")
+    parser.add_argument("--workers", default="0,1,2,3",
+            help="comma separated numbers of helpers to try")
+    args = parser.parse_args()
+
+    base = None
+    print("helpers      time      tmax   speedup")
+    for workers in [int(w) for w in args.workers.split(",")]:
+        time, tmax = run(args, workers)
+        if base is None:
+            base = time
+        print("%7d %9d %9d %8.2fx" % (workers, time, tmax,
+                                       base / time if time else 0))
+
+
+if __name__ == "__main__":
+    main()
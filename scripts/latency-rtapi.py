@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+"""
+Measures the wakeup latency of realtime threads on this machine with the
+histograms RTAPI keeps for HAL threads (halcmd 'latency').
+
+Creates one empty thread per --thread PERIOD[:CPUS[:SCHED]], placed and
+scheduled like threads(9) cpus1= and sched1= would, runs them for
+--seconds and prints a histogram per thread with the interrupts that came
+in around its worst case.  The latency is taken where rtapi_wait()
+returns, so it is what HAL threads see.  Load the machine as in
+production while this runs.  Needs halrun in the PATH.
+
+    latency-rtapi.py --thread 25000:3 --thread 1000000:3 --seconds 600
+    latency-rtapi.py --thread 1000000:spread:deadline,timerfd --export out.txt
+"""
+
+import argparse
+import os
+import subprocess
+import tempfile
+
+
+def parse_thread(spec):
+    fields = spec.split(":", 2)
+    try:
+        period = int(fields[0])
+    except ValueError:
+        raise argparse.ArgumentTypeError("bad period in %r" % spec)
+    return (period, fields[1] if len(fields) > 1 else "",
+            fields[2] if len(fields) > 2 else "")
+
+
+def hal_config(args):
+    out = []
+    names = []
+    for n, (period, cpus, sched) in enumerate(args.thread):
+        name = "lat%d" % n
+        line = "loadrt threads name1=%s period1=%d" % (name, period)
+        if cpus:
+            line += " cpus1=%s" % cpus
+        if sched:
+            line += " sched1=%s" % sched
+        out.append(line)
+        names.append(name)
+    out += ["start",
+            "loadusr -w sleep 1",
+            "latency watch %g %s" % (args.seconds, " ".join(names))]
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--thread", type=parse_thread, action="append",
+            help="PERIOD[:CPUS[:SCHED]], may be given several times "
+                 "(default: 25000 and 1000000 on the default CPU)")
+    parser.add_argument("--seconds", type=float, default=60.0)
+    parser.add_argument("--export",
+            help="write one value per line (halcmd -s) to this file instead")
+    args = parser.parse_args()
+    if not args.thread:
+        args.thread = [(25000, "", ""), (1000000, "", "")]
+    # sorted fastest first, like threads(9) wants
+    args.thread.sort(key=lambda t: t[0])
+
+    with tempfile.NamedTemporaryFile("w", suffix=".hal", delete=False) as f:
+        f.write(hal_config(args))
+    try:
+        cmd = ["halrun"] + (["-s"] if args.export else []) + ["-f", f.name]
+        result = subprocess.run(cmd, capture_output=True, text=True)
+    finally:
+        os.unlink(f.name)
+    if result.returncode != 0:
+        raise SystemExit(result.stdout + result.stderr)
+    if args.export:
+        with open(args.export, "w") as f:
+            f.write(result.stdout)
+    else:
+        print(result.stdout, end="")
+
+
+if __name__ == "__main__":
+    main()
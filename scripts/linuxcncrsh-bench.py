@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+"""
+Command throughput benchmark for linuxcncrsh.
+
+Opens one or more connections to a running linuxcncrsh and sends the same
+command over and over, keeping up to --depth tagged commands in flight per
+connection ("@<n> get abs_act_pos").  --depth 1 is the classic send/wait
+client.  Prints the achieved commands per second and reply latencies.
+
+    linuxcncrsh-bench.py --depth 1
+    linuxcncrsh-bench.py --depth 32 --clients 4 --command "get joint_pos"
+"""
+
+import argparse
+import selectors
+import socket
+import time
+
+
+class Client:
+    def __init__(self, args):
+        self.sock = socket.create_connection((args.host, args.port))
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.command = args.command.encode()
+        self.pending = b""
+        self.sent = {}
+        self.next_tag = 0
+        self.latencies = []
+        self.sock.sendall(b"hello %s bench 1.1\r\nset echo off\r\n"
+                          % args.password.encode())
+        self.expect(b"HELLO ACK")
+
+    def expect(self, prefix):
+        while b"\r\n" not in self.pending:
+            data = self.sock.recv(4096)
+            if not data:
+                raise SystemExit("linuxcncrsh closed the connection")
+            self.pending += data
+        line, self.pending = self.pending.split(b"\r\n", 1)
+        if not line.startswith(prefix):
+            raise SystemExit("unexpected reply %r" % line)
+
+    def send(self, count):
+        now = time.monotonic()
+        out = []
+        for _ in range(count):
+            tag = b"@%d" % self.next_tag
+            self.sent[tag] = now
+            out.append(tag + b" " + self.command + b"\r\n")
+            self.next_tag += 1
+        self.sock.sendall(b"".join(out))
+
+    def receive(self):
+        """Consume received replies, return how many commands completed"""
+        data = self.sock.recv(65536)
+        if not data:
+            raise SystemExit("linuxcncrsh closed the connection")
+        self.pending += data
+        done = 0
+        now = time.monotonic()
+        *lines, self.pending = self.pending.split(b"\r\n")
+        for line in lines:
+            sent = self.sent.pop(line.split(b" ", 1)[0], None)
+            if sent is None:
+                continue
+            self.latencies.append(now - sent)
+            done += 1
+        return done
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=5007)
+    parser.add_argument("--password", default="EMC")
+    parser.add_argument("--clients", type=int, default=1)
+    parser.add_argument("--depth", type=int, default=16,
+            help="commands in flight per connection")
+    parser.add_argument("--command", default="get abs_act_pos")
+    parser.add_argument("--duration", type=float, default=5.0)
+    args = parser.parse_args()
+
+    sel = selectors.DefaultSelector()
+    clients = [Client(args) for _ in range(args.clients)]
+    start = time.monotonic()
+    for c in clients:
+        sel.register(c.sock, selectors.EVENT_READ, c)
+        c.send(args.depth)
+
+    done = 0
+    while time.monotonic() - start < args.duration:
+        for key, _ in sel.select(timeout=0.1):
+            c = key.data
+            n = c.receive()
+            if n:
+                done += n
+                c.send(n)
+    elapsed = time.monotonic() - start
+
+    latencies = [v for c in clients for v in c.latencies]
+    print("clients:      %d" % len(clients))
+    print("depth:        %d" % args.depth)
+    print("commands/s:   %.1f" % (done / elapsed))
+    print("latency us:   p50 %.0f  p99 %.0f  max %.0f" % (
+        percentile(latencies, .5) * 1e6,
+        percentile(latencies, .99) * 1e6,
+        max(latencies, default=0) * 1e6))
+
+
+if __name__ == "__main__":
+    main()
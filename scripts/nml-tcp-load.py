@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+"""
+Load generator for the NML TCP server (tcp_srv.cc).
+
+Opens many simultaneous connections to a running NML server (for instance
+linuxcncsvr with configs/common/linuxcnc.nml, TCP=5005) and either hammers
+it with synchronous peek requests or subscribes every client to a buffer
+and counts the updates fanned out to them.  It prints the achieved
+request/update rate and the reply latency distribution.
+
+    nml-tcp-load.py --clients 50 --mode read --buffer 2
+    nml-tcp-load.py --clients 50 --mode subscribe --interval 10
+"""
+
+import argparse
+import selectors
+import socket
+import struct
+import time
+
+READ_REQUEST = 1
+SET_SUBSCRIPTION_REQUEST = 9
+PEEK_ACCESS = 3
+POLLED_SUBSCRIPTION = 1
+VARIABLE_SUBSCRIPTION = 3
+
+
+class Client:
+    def __init__(self, host, port, buffer_number):
+        self.sock = socket.create_connection((host, port))
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.buffer_number = buffer_number
+        self.serial = 0
+        self.pending = b""
+        self.want = 20
+        self.header = None
+        self.sent_at = 0.0
+        self.replies = 0
+        self.bytes = 0
+
+    def request(self, words):
+        self.sent_at = time.monotonic()
+        self.sock.sendall(struct.pack(">5I", self.serial, *words))
+
+    def send_read(self):
+        self.request((READ_REQUEST, self.buffer_number, PEEK_ACCESS, 0))
+
+    def subscribe(self, kind, interval):
+        self.request((SET_SUBSCRIPTION_REQUEST, self.buffer_number, kind,
+                      interval))
+        reply = self.sock.recv(8)
+        if len(reply) != 8 or struct.unpack(">2I", reply)[1] != 1:
+            raise SystemExit("subscription refused by server")
+        self.serial += 1
+
+    def feed(self, data):
+        """Consume received bytes, return the number of complete replies"""
+        self.pending += data
+        done = 0
+        while len(self.pending) >= self.want:
+            if self.header is None:
+                self.header = struct.unpack(">5I", self.pending[:20])
+                self.pending = self.pending[20:]
+                self.want = self.header[2]
+                if self.want:
+                    continue
+            else:
+                self.pending = self.pending[self.want:]
+            self.bytes += 20 + self.header[2]
+            self.header = None
+            self.want = 20
+            self.serial += 1
+            self.replies += 1
+            done += 1
+        return done
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=5005)
+    parser.add_argument("--buffer", type=int, default=2,
+            help="NML buffer number (emcStatus is 2)")
+    parser.add_argument("--clients", type=int, default=20)
+    parser.add_argument("--mode", choices=("read", "subscribe"),
+            default="read")
+    parser.add_argument("--interval", type=int, default=0,
+            help="poll interval in ms for subscriptions, 0 = variable")
+    parser.add_argument("--duration", type=float, default=10.0)
+    args = parser.parse_args()
+
+    sel = selectors.DefaultSelector()
+    clients = []
+    for _ in range(args.clients):
+        c = Client(args.host, args.port, args.buffer)
+        if args.mode == "subscribe":
+            if args.interval:
+                c.subscribe(POLLED_SUBSCRIPTION, args.interval)
+            else:
+                c.subscribe(VARIABLE_SUBSCRIPTION, 0)
+        sel.register(c.sock, selectors.EVENT_READ, c)
+        clients.append(c)
+
+    latencies = []
+    start = time.monotonic()
+    if args.mode == "read":
+        for c in clients:
+            c.send_read()
+    while time.monotonic() - start < args.duration:
+        for key, _ in sel.select(timeout=0.1):
+            c = key.data
+            data = c.sock.recv(65536)
+            if not data:
+                raise SystemExit("server closed the connection")
+            if c.feed(data) and args.mode == "read":
+                latencies.append(time.monotonic() - c.sent_at)
+                c.send_read()
+    elapsed = time.monotonic() - start
+
+    replies = sum(c.replies for c in clients)
+    nbytes = sum(c.bytes for c in clients)
+    print("clients:      %d" % len(clients))
+    print("mode:         %s" % args.mode)
+    print("replies/s:    %.1f" % (replies / elapsed))
+    print("MB/s:         %.2f" % (nbytes / elapsed / 1e6))
+    print("min replies:  %d" % min(c.replies for c in clients))
+    if latencies:
+        print("latency us:   p50 %.0f  p99 %.0f  max %.0f" % (
+            percentile(latencies, .5) * 1e6,
+            percentile(latencies, .99) * 1e6,
+            max(latencies) * 1e6))
+
+
+if __name__ == "__main__":
+    main()
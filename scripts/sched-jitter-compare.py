@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+"""
+Compares the wakeup lateness of HAL threads with different scheduling
+(sched1= of threads.so, see rtapi_task_set_sched(3)) on this machine.
+
+For each setting, runs one thread with a sched_jitter component first in
+it for --seconds and prints the lateness statistics.  The settings are
+tried one after the other, with the same period and CPUs, so they see
+the same machine.  Load the machine as in production while this runs.
+Needs halrun in the PATH; deadline needs the realtime rtapi_app.
+
+    sched-jitter-compare.py --period 250000 --cpus 3
+    sched-jitter-compare.py --sched fifo --sched deadline:50000,timerfd
+"""
+
+import argparse
+import os
+import subprocess
+import tempfile
+
+PINS = ["latency-min", "latency-max", "latency-avg", "latency-stddev",
+        "jitter", "missed", "periods"]
+
+
+def hal_config(args, sched):
+    out = ["loadrt threads name1=jt period1=%d" % args.period]
+    if args.cpus:
+        out[0] += " cpus1=%s" % args.cpus
+    if sched:
+        out[0] += " sched1=%s" % sched
+    out += ["loadrt sched_jitter names=jitter",
+            "addf jitter jt",
+            "start",
+            "loadusr -w sleep 1",
+            "setp jitter.reset 1",
+            "loadusr -w sleep 0.1",
+            "setp jitter.reset 0",
+            "loadusr -w sleep %g" % args.seconds]
+    out += ["getp jitter.%s" % pin for pin in PINS]
+    return "\n".join(out) + "\n"
+
+
+def run(args, sched):
+    with tempfile.NamedTemporaryFile("w", suffix=".hal", delete=False) as f:
+        f.write(hal_config(args, sched))
+    try:
+        result = subprocess.run(["halrun", "-f", f.name], capture_output=True,
+                                text=True)
+    finally:
+        os.unlink(f.name)
+    values = []
+    for line in result.stdout.split():
+        try:
+            values.append(float(line))
+        except ValueError:
+            pass
+    if result.returncode != 0 or len(values) < len(PINS):
+        print("%s: failed\n%s%s" % (sched, result.stdout, result.stderr))
+        return None
+    return dict(zip(PINS, values[-len(PINS):]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--period", type=int, default=1000000)
+    parser.add_argument("--seconds", type=float, default=60.0)
+    parser.add_argument("--cpus", default="",
+            help="CPUs for the thread, see threads(9)")
+    parser.add_argument("--sched", action="append",
+            help="a sched1= setting to try, may be given several times "
+                 "(default: fifo, timerfd, deadline, deadline,timerfd)")
+    args = parser.parse_args()
+
+    scheds = args.sched or ["fifo", "timerfd", "deadline", "deadline,timerfd"]
+    width = max(len(s) for s in scheds)
+    print("%-*s %9s %9s %9s %9s %9s %7s" % (width, "sched", "min ns",
+          "max ns", "avg ns", "stddev", "jitter", "missed"))
+    for sched in scheds:
+        r = run(args, sched)
+        if r is None:
+            continue
+        print("%-*s %9d %9d %9.0f %9.0f %9d %7d" % (width, sched,
+              r["latency-min"], r["latency-max"], r["latency-avg"],
+              r["latency-stddev"], r["jitter"], r["missed"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+"""
+Convert a measured volumetric error table to a [TRAJ]VOLUMETRIC_COMP_FILE.
+
+The input has one line per grid node with six numbers, the nominal
+machine position and the correction to add to it:
+
+    x y z dx dy dz
+
+The nodes must form a complete, evenly spaced grid; they may come in
+any order.  Blank lines and lines starting with '#' are ignored.
+
+    volcomp-grid.py measured.txt volcomp.bin
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"LCNCVCMP"
+VERSION = 1
+
+
+def axis_values(values, name):
+    values = sorted(set(values))
+    if len(values) < 2:
+        raise SystemExit("need at least 2 nodes in %s" % name)
+    step = (values[-1] - values[0]) / (len(values) - 1)
+    for n, v in enumerate(values):
+        if abs(v - (values[0] + n * step)) > step * 1e-3:
+            raise SystemExit("%s nodes are not evenly spaced at %g" % (name, v))
+    return values, step
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input")
+    parser.add_argument("output")
+    args = parser.parse_args()
+
+    nodes = []
+    with open(args.input) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            try:
+                x, y, z, dx, dy, dz = map(float, line.split())
+            except ValueError:
+                raise SystemExit("%s:%d: expected x y z dx dy dz" % (args.input, lineno))
+            nodes.append(((x, y, z), (dx, dy, dz)))
+
+    axes = [axis_values([p[n] for p, _ in nodes], "XYZ"[n]) for n in range(3)]
+    size = [len(values) for values, _ in axes]
+    grid = {}
+    for p, corr in nodes:
+        index = tuple(round((p[n] - axes[n][0][0]) / axes[n][1]) for n in range(3))
+        if index in grid:
+            raise SystemExit("node %g %g %g given twice" % p)
+        grid[index] = corr
+    if len(grid) != size[0] * size[1] * size[2]:
+        raise SystemExit("grid of %dx%dx%d nodes is incomplete" % tuple(size))
+
+    with open(args.output, "wb") as f:
+        f.write(MAGIC)
+        f.write(struct.pack("<6I", VERSION, size[0], size[1], size[2], 0, 0))
+        f.write(struct.pack("<3d", *(values[0] for values, _ in axes)))
+        f.write(struct.pack("<3d", *(step for _, step in axes)))
+        for k in range(size[2]):
+            for j in range(size[1]):
+                for i in range(size[0]):
+                    f.write(struct.pack("<3f", *grid[(i, j, k)]))
+    print("%dx%dx%d nodes, set motmod volcomp_nodes=%d or more" % (
+        size[0], size[1], size[2], size[0] * size[1] * size[2]))
+
+
+if __name__ == "__main__":
+    main()
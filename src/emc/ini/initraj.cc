@@ -72,6 +72,9 @@ static int loadKins(EmcIniFile *trajInifile)
   MAX_LINEAR_VELOCITY <float>     max linear velocity
   DEFAULT_LINEAR_ACCELERATION <float> default linear acceleration
   MAX_LINEAR_ACCELERATION <float>     max linear acceleration
+  VOLUMETRIC_COMP_FILE <string>   volumetric compensation grid
+  VOLUMETRIC_COMP_JOINTS <string> grid correction axis per joint, default XYZ
+  JOINT_LIMIT_SAMPLES <int>       points per move checked against joint limits
 
   calls:
 
@@ -81,6 +84,8 @@ static int loadKins(EmcIniFile *trajInifile)
   emcTrajSetAcceleration(double acc);
   emcTrajSetMaxVelocity(double vel);
   emcTrajSetMaxAcceleration(double acc);
+  emcTrajLoadVolComp(const char *file, const char *axes);
+  emcSetJointLimitSamples(int samples);
   */
 
 static int loadTraj(EmcIniFile *trajInifile)
@@ -288,6 +293,18 @@ static int loadTraj(EmcIniFile *trajInifile)
             }
             return -1;
         }
+
+        // 0, the default of motion, is not sent, so the commands of
+        // configurations without the setting stay as they were
+        int jointLimitSamples = 0;
+        trajInifile->Find(&jointLimitSamples, 0, EMCMOT_MAX_JOINT_LIMIT_SAMPLES,
+                          "JOINT_LIMIT_SAMPLES", "TRAJ");
+        if (jointLimitSamples > 0 && 0 != emcSetJointLimitSamples(jointLimitSamples)) {
+            if (emc_debug & EMC_DEBUG_CONFIG) {
+                rcs_print("bad return value from emcSetJointLimitSamples\n");
+            }
+            return -1;
+        }
     }
 
     catch (EmcIniFile::Exception &e) {
@@ -365,6 +382,19 @@ static int loadTraj(EmcIniFile *trajInifile)
             }
             return -1;
         }
+
+        auto volcomp_file = trajInifile->Find("VOLUMETRIC_COMP_FILE", "TRAJ");
+        if (volcomp_file) {
+            std::string volcomp_joints = "XYZ";
+            if (auto s = trajInifile->Find("VOLUMETRIC_COMP_JOINTS", "TRAJ")) {
+                volcomp_joints = *s;
+            }
+            if (0 != emcTrajLoadVolComp(volcomp_file->c_str(), volcomp_joints.c_str())) {
+                rcs_print("can't load [TRAJ]VOLUMETRIC_COMP_FILE %s\n",
+                          volcomp_file->c_str());
+                return -1;
+            }
+        }
      } //try
 
     catch (EmcIniFile::Exception &e) {
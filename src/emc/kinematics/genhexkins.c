@@ -103,6 +103,10 @@
   genhexkins.max-iterations - maximum number of iterations spent for
                     a converged solution during current session.
 
+  genhexkins.jacobian-reuse - relative change of the inverse jacobian
+                    up to which its kept LU factors are used, 0 to
+                    factor it in every iteration.
+
  ----------------------------------------------------------------------------*/
 
 #include "rtapi.h"
@@ -113,6 +117,7 @@
 #include "genhexkins.h"
 #include "motion.h"
 #include "kinematics.h"             /* these decls, KINEMATICS_FORWARD_FLAGS */
+#include "kins_lu6.h"
 #include "switchkins.h"
 
 static struct haldata {
@@ -138,6 +143,7 @@ static struct haldata {
     hal_float_t *tool_offset;
     hal_float_t *spindle_offset;
     hal_bit_t   *fwd_kins_fail;
+    hal_float_t *lu_reuse;
 
     hal_float_t *gui_x;
     hal_float_t *gui_y;
@@ -146,6 +152,7 @@ static struct haldata {
     hal_float_t *gui_b;
     hal_float_t *gui_c;
 
+    struct genhex_lu *lu;       /* kept by the forward kinematics */
 } *haldata;
 
 static int genhex_gui_forward_kins(EmcPose *pos)
@@ -159,106 +166,35 @@ static int genhex_gui_forward_kins(EmcPose *pos)
     return 0;
 } // genhex_gui_forward_kins
 
-/******************************* MatInvert() ***************************/
-
-/*-----------------------------------------------------------------------------
- This is a function that inverts a 6x6 matrix.
------------------------------------------------------------------------------*/
-
-static int MatInvert(double J[][NUM_STRUTS], double InvJ[][NUM_STRUTS])
+/* LU factors of the inverse jacobian, kept across iterations and calls:
+   the forward kinematics reuse them while no element of the inverse
+   jacobian moved by more than the jacobian-reuse pin (GENHEX_LU_REUSE by
+   default) of its size since they were computed and the error shrinks by
+   GENHEX_LU_CONTRACT per iteration, and factor the current one when not */
+#define GENHEX_LU_REUSE 0.01
+#define GENHEX_LU_CONTRACT 0.5
+struct genhex_lu {
+    int valid;
+    double J[NUM_STRUTS][NUM_STRUTS];
+    double LU[NUM_STRUTS][NUM_STRUTS];
+    int piv[NUM_STRUTS];
+};
+
+static int genhex_lu_stale(const struct genhex_lu *jlu, double J[][NUM_STRUTS])
 {
-  double JAug[NUM_STRUTS][12], m, temp;
-  int j, k, n;
-
-  /* This function determines the inverse of a 6x6 matrix using
-     Gauss-Jordan elimination */
-
-  /* Augment the Identity matrix to the Jacobian matrix */
-
-  for (j=0; j<=5; ++j){
-    for (k=0; k<=5; ++k){     /* Assign J matrix to first 6 columns of AugJ */
-      JAug[j][k] = J[j][k];
-    }
-    for(k=6; k<=11; ++k){    /* Assign I matrix to last six columns of AugJ */
-      if (k-6 == j){
-        JAug[j][k]=1;
-      }
-      else{
-        JAug[j][k]=0;
-      }
-    }
-  }
-
-  /* Perform Gauss elimination */
-  for (k=0; k<=4; ++k){               /* Pivot        */
-    if ((JAug[k][k]< 0.01) && (JAug[k][k] > -0.01)){
-      for (j=k+1;j<=5; ++j){
-        if ((JAug[j][k]>0.01) || (JAug[j][k]<-0.01)){
-          for (n=0; n<=11;++n){
-            temp = JAug[k][n];
-            JAug[k][n] = JAug[j][n];
-            JAug[j][n] = temp;
-          }
-          break;
-        }
-      }
-    }
-    for (j=k+1; j<=5; ++j){            /* Pivot */
-      m = -JAug[j][k] / JAug[k][k];
-      for (n=0; n<=11; ++n){
-        JAug[j][n]=JAug[j][n] + m*JAug[k][n];   /* (Row j) + m * (Row k) */
-        if ((JAug[j][n] < 0.000001) && (JAug[j][n] > -0.000001)){
-          JAug[j][n] = 0;
-        }
-      }
-    }
-  }
-
-  /* Normalization of Diagonal Terms */
-  for (j=0; j<=5; ++j){
-    m=1/JAug[j][j];
-    for(k=0; k<=11; ++k){
-      JAug[j][k] = m * JAug[j][k];
-    }
-  }
+  int j, k;
 
-  /* Perform Gauss Jordan Steps */
-  for (k=5; k>=0; --k){
-    for(j=k-1; j>=0; --j){
-      m = -JAug[j][k]/JAug[k][k];
-      for (n=0; n<=11; ++n){
-        JAug[j][n] = JAug[j][n] + m * JAug[k][n];
+  if (!jlu->valid) return 1;
+  for (j = 0; j < NUM_STRUTS; j++) {
+    for (k = 0; k < NUM_STRUTS; k++) {
+      if (fabs(J[j][k] - jlu->J[j][k]) >
+          *haldata->lu_reuse * (1 + fabs(jlu->J[j][k]))) {
+        return 1;
       }
     }
   }
-
-  /* Assign last 6 columns of JAug to InvJ */
-  for (j=0; j<=5; ++j){
-    for (k=0; k<=5; ++k){
-      InvJ[j][k] = JAug[j][k+6];
-
-    }
-  }
-
-  return 0;         /* FIXME-- check divisors for 0 above */
-} // MatInvert()
-
-/******************************** MatMult() *********************************/
-
-/*---------------------------------------------------------------------------
-  This function simply multiplies a 6x6 matrix by a 1x6 vector
-  ---------------------------------------------------------------------------*/
-
-static void MatMult(double J[][6], const double x[], double Ans[])
-{
-  int j, k;
-  for (j=0; j<=5; ++j){
-    Ans[j] = 0;
-    for (k=0; k<=5; ++k){
-      Ans[j] = J[j][k]*x[k]+Ans[j];
-    }
-  }
-} // MatMult()
+  return 0;
+} // genhex_lu_stale()
 
 /* declare arrays for base and platform coordinates */
 static PmCartesian b[NUM_STRUTS];
@@ -335,11 +271,12 @@ static int genhexKinematicsForward(const double * joints,
   PmCartesian InvKinStrutVect,InvKinStrutVectUnit;
   PmCartesian q_trans, RMatrix_a, RMatrix_a_cross_Strut;
 
-  double Jacobian[NUM_STRUTS][NUM_STRUTS];
   double InverseJacobian[NUM_STRUTS][NUM_STRUTS];
   double InvKinStrutLength, StrutLengthDiff[NUM_STRUTS];
   double delta[NUM_STRUTS];
-  double conv_err = 1.0;
+  double conv_err = 1.0, last_err = 0.0;
+  struct genhex_lu *jlu = haldata->lu;
+  int refactored = 0;
   double corr;
 
   PmRotationMatrix RMatrix;
@@ -430,11 +367,32 @@ static int genhexKinematicsForward(const double * joints,
       InverseJacobian[i][5] = RMatrix_a_cross_Strut.z;
     }
 
-    /* invert Inverse Jacobian */
-    MatInvert(InverseJacobian, Jacobian);
+    /* determine value of conv_error (used to determine if no convergence) */
+    last_err = conv_err;
+    conv_err = 0.0;
+    for (i = 0; i < NUM_STRUTS; i++) {
+      conv_err += fabs(StrutLengthDiff[i]);
+    }
 
-    /* multiply Jacobian by LegLengthDiff */
-    MatMult(Jacobian, StrutLengthDiff, delta);
+    /* factor Inverse Jacobian, unless the kept factors still do */
+    if (genhex_lu_stale(jlu, InverseJacobian) ||
+        (iteration > 1 && !refactored &&
+         conv_err > GENHEX_LU_CONTRACT * last_err)) {
+      memcpy(jlu->J, InverseJacobian, sizeof(jlu->J));
+      memcpy(jlu->LU, InverseJacobian, sizeof(jlu->LU));
+      jlu->valid = 0;
+      if (kins_lu6_factor(jlu->LU, jlu->piv)) {
+        *haldata->fwd_kins_fail = 1;
+        return -1;
+      }
+      jlu->valid = 1;
+      refactored = 1;
+    } else {
+      refactored = 0;
+    }
+
+    /* solve Inverse Jacobian * delta = LegLengthDiff */
+    kins_lu6_solve(jlu->LU, jlu->piv, StrutLengthDiff, delta);
 
     /* subtract delta from last iterations pos values */
     q_trans.x -= delta[0];
@@ -444,12 +402,6 @@ static int genhexKinematicsForward(const double * joints,
     q_RPY.p   -= delta[4];
     q_RPY.y   -= delta[5];
 
-    /* determine value of conv_error (used to determine if no convergence) */
-    conv_err = 0.0;
-    for (i = 0; i < NUM_STRUTS; i++) {
-      conv_err += fabs(StrutLengthDiff[i]);
-    }
-
     /* enter loop to determine if a strut needs another iteration */
     iterate = 0;            /*assume iteration is done */
     for (i = 0; i < NUM_STRUTS; i++) {
@@ -549,7 +501,10 @@ int genhexKinematicsSetup(const  int   comp_id,
     int i,res=0;
 
     haldata = hal_malloc(sizeof(struct haldata));
-    if (!haldata) {
+    if (haldata) {
+        haldata->lu = hal_malloc(sizeof(struct genhex_lu));
+    }
+    if (!haldata || !haldata->lu) {
         rtapi_print_msg(RTAPI_MSG_ERR,"genhexKinematicsSetup: hal_malloc fail\n");
         return -1;
     }
@@ -601,6 +556,9 @@ int genhexKinematicsSetup(const  int   comp_id,
     res += hal_pin_u32_newf(HAL_IN, &haldata->iter_limit, comp_id,
         "genhexkins.limit-iterations");
     *haldata->iter_limit = 120;
+    res += hal_pin_float_newf(HAL_IN, &haldata->lu_reuse, comp_id,
+        "genhexkins.jacobian-reuse");
+    *haldata->lu_reuse = GENHEX_LU_REUSE;
     res += hal_pin_float_newf(HAL_IN, &haldata->tool_offset, comp_id,
         "genhexkins.tool-offset");
     *haldata->tool_offset = 0.0;
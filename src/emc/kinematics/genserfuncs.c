@@ -38,6 +38,7 @@
 #include "gomath.h"     /* go_pose */
 #include "genserkins.h" /* these decls */
 #include "kinematics.h"
+#include "kins_lu6.h"
 #include "hal.h"
 
 #ifdef RTAPI
@@ -55,6 +56,7 @@
 static struct haldata {
     hal_u32_t     *max_iterations;
     hal_u32_t     *last_iterations;
+    hal_float_t   *lu_reuse;
     hal_float_t   *a[GENSER_MAX_JOINTS];
     hal_float_t   *alpha[GENSER_MAX_JOINTS];
     hal_float_t   *d[GENSER_MAX_JOINTS];
@@ -79,6 +81,14 @@ double j[GENSER_MAX_JOINTS];
 
 static int genser_hal_inited = 0;
 
+/* the inverse kinematics reuse the LU factors of the jacobian in
+   genser_struct while the joints stay within the jacobian-reuse pin
+   (GENSER_LU_REUSE radians by default, 0 to factor in every iteration)
+   of where they were computed and each step is at most GENSER_LU_CONTRACT
+   of the previous one, and recompute the jacobian only when not */
+#define GENSER_LU_REUSE 0.05
+#define GENSER_LU_CONTRACT 0.5
+
 int genser_kin_init(void) {
     genser_struct *genser = KINS_PTR;
     int t;
@@ -87,6 +97,12 @@ int genser_kin_init(void) {
     /* init them all and make them revolute joints */
     /* FIXME: should allow LINEAR joints based on HAL param too */
     for (t = 0; t < GENSER_MAX_JOINTS; t++) {
+        if (genser->links[t].u.dh.a != A(t)
+            || genser->links[t].u.dh.alpha != ALPHA(t)
+            || genser->links[t].u.dh.d != D(t)) {
+            genser->lu.valid = 0;
+            genser->query_lu.valid = 0;
+        }
         genser->links[t].u.dh.a = A(t);
         genser->links[t].u.dh.alpha = ALPHA(t);
         genser->links[t].u.dh.d = D(t);
@@ -420,10 +436,11 @@ int genserKinematicsInverse(const EmcPose * world,
                             const KINEMATICS_INVERSE_FLAGS * iflags,
                             KINEMATICS_FORWARD_FLAGS * fflags)
 {
-    (void)iflags;
     (void)fflags;
 
     genser_struct *genser = KINS_PTR;
+    int query = iflags && (*iflags & KINEMATICS_INVERSE_QUERY);
+    genser_lu_struct *jlu = query ? &genser->query_lu : &genser->lu;
     GO_MATRIX_DECLARE(Jfwd, Jfwd_stg, 6, GENSER_MAX_JOINTS);
     GO_MATRIX_DECLARE(Jinv, Jinv_stg, GENSER_MAX_JOINTS, 6);
     go_pose T_L_0;
@@ -435,7 +452,9 @@ int genserKinematicsInverse(const EmcPose * world,
     go_rvec rvec;
     go_cart cart;
     go_link linkout[GENSER_MAX_JOINTS];
-    int link;
+    go_real djmax, djlast = 0;
+    int refactored = 0;
+    int link, t;
     int smalls;
     int retval;
 
@@ -475,22 +494,47 @@ int genserKinematicsInverse(const EmcPose * world,
     for (genser->iterations = 0;
          genser->iterations < *haldata->max_iterations;
          genser->iterations++) {
-         *(haldata->last_iterations) = genser->iterations;
-        /* update the Jacobians */
-        for (link = 0; link < genser->link_num; link++) {
-            go_link_joint_set(&genser->links[link], jest[link], &linkout[link]);
+         if (!query) *(haldata->last_iterations) = genser->iterations;
+        /* update the Jacobians, unless the kept LU factors still do */
+        if (genser->link_num == 6) {
+            for (link = 0; link < 6 && jlu->valid; link++) {
+                if (fabs(jest[link] - jlu->joints[link]) > *haldata->lu_reuse)
+                    jlu->valid = 0;
+            }
         }
-        retval = compute_jfwd(linkout, genser->link_num, &Jfwd, &T_L_0);
-        if (GO_RESULT_OK != retval) {
-            rtapi_print("ERR kI - compute_jfwd (joints: %f %f %f %f %f %f), (iterations=%d)\n",
-                 joints[0],joints[1],joints[2],joints[3],joints[4],joints[5], genser->iterations);
-            return retval;
+        if (genser->link_num != 6 || !jlu->valid) {
+            for (link = 0; link < genser->link_num; link++) {
+                go_link_joint_set(&genser->links[link], jest[link], &linkout[link]);
+            }
+            retval = compute_jfwd(linkout, genser->link_num, &Jfwd, &T_L_0);
+            if (GO_RESULT_OK != retval) {
+                rtapi_print("ERR kI - compute_jfwd (joints: %f %f %f %f %f %f), (iterations=%d)\n",
+                     joints[0],joints[1],joints[2],joints[3],joints[4],joints[5], genser->iterations);
+                return retval;
+            }
         }
-        retval = compute_jinv(&Jfwd, &Jinv);
-        if (GO_RESULT_OK != retval) {
-            rtapi_print("ERR kI - compute_jinv (joints: %f %f %f %f %f %f), (iterations=%d)\n",
-                 joints[0],joints[1],joints[2],joints[3],joints[4],joints[5], genser->iterations);
-            return retval;
+        if (genser->link_num == 6) {
+            if (!jlu->valid) {
+                for (link = 0; link < 6; link++) {
+                    jlu->joints[link] = jest[link];
+                    for (t = 0; t < 6; t++)
+                        jlu->LU[link][t] = Jfwd.el[link][t];
+                }
+                if (kins_lu6_factor(jlu->LU, jlu->piv)) {
+                    rtapi_print("ERR kI - singular jacobian (joints: %f %f %f %f %f %f), (iterations=%d)\n",
+                         joints[0],joints[1],joints[2],joints[3],joints[4],joints[5], genser->iterations);
+                    return GO_RESULT_SINGULAR;
+                }
+                jlu->valid = 1;
+                refactored = 1;
+            }
+        } else {
+            retval = compute_jinv(&Jfwd, &Jinv);
+            if (GO_RESULT_OK != retval) {
+                rtapi_print("ERR kI - compute_jinv (joints: %f %f %f %f %f %f), (iterations=%d)\n",
+                     joints[0],joints[1],joints[2],joints[3],joints[4],joints[5], genser->iterations);
+                return retval;
+            }
         }
 
         /* pest is the resulting pose estimate given joint estimate */
@@ -535,7 +579,11 @@ int genserKinematicsInverse(const EmcPose * world,
         dvw[5] = cart.z;
 
         /* push the Cartesian velocity vector through the inverse Jacobian */
-        go_matrix_vector_mult(&Jinv, dvw, dj);
+        if (genser->link_num == 6) {
+            kins_lu6_solve(jlu->LU, jlu->piv, dvw, dj);
+        } else {
+            go_matrix_vector_mult(&Jinv, dvw, dj);
+        }
 
         //pass through 678 as uvw
         if (total_joints > 6) joints[6] = world->u;
@@ -544,7 +592,7 @@ int genserKinematicsInverse(const EmcPose * world,
 
         /* check for small joint increments, if so we're done */
         for (link = 0, smalls = 0; link < genser->link_num; link++) {
-            if (GO_QUANTITY_LENGTH == linkout[link].quantity) {
+            if (GO_QUANTITY_LENGTH == genser->links[link].quantity) {
             if (GO_TRAN_SMALL(dj[link]))
                 smalls++;
             } else {
@@ -566,10 +614,17 @@ int genserKinematicsInverse(const EmcPose * world,
             //     world->tran.x, world->tran.y, world->tran.z, world->a, world->b, world->c);
             return GO_RESULT_OK;
         }
-        /* else keep iterating */
-        for (link = 0; link < genser->link_num; link++) {
+        /* else keep iterating; with kept factors the step must shrink
+           fast enough, or the next iteration computes new ones */
+        for (link = 0, djmax = 0; link < genser->link_num; link++) {
             jest[link] += dj[link]; //still in radians
+            djmax = fmax(djmax, fabs(dj[link]));
         }
+        if (genser->iterations && !refactored
+            && djmax > GENSER_LU_CONTRACT * djlast)
+            jlu->valid = 0;
+        djlast = djmax;
+        refactored = 0;
     } /* for (iterations) */
 
     rtapi_print("ERRkineInverse(joints: %f %f %f %f %f %f), (iterations=%d)\n",
@@ -636,10 +691,13 @@ int genserKinematicsSetup(const int comp_id,
     if (haldata->pos == NULL) {goto error;}
     res += hal_pin_u32_newf(HAL_IN, &haldata->max_iterations, comp_id,
           "%s.max-iterations",kp->halprefix);
+    res += hal_pin_float_newf(HAL_IN, &haldata->lu_reuse, comp_id,
+          "%s.jacobian-reuse",kp->halprefix);
 
     if (res) {goto error;}
 
     *haldata->max_iterations = GENSER_DEFAULT_MAX_ITERATIONS;
+    *haldata->lu_reuse = GENSER_LU_REUSE;
 
     A(0) = DEFAULT_A1;
     A(1) = DEFAULT_A2;
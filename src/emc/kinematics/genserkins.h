@@ -74,10 +74,21 @@
 #define DEFAULT_ALPHA6 -PI_2
 #define DEFAULT_D6 0
 
+/* LU factors of the jacobian of the 6 joint case, which the inverse
+   kinematics keep across iterations and calls */
+typedef struct {
+  int valid;                   /*!< Nonzero if LU and piv are the factors at joints. */
+  double LU[6][6];
+  int piv[6];
+  go_real joints[6];           /*!< Joints the jacobian was computed at, in radians. */
+} genser_lu_struct;
+
 typedef struct {
   go_link links[GENSER_MAX_JOINTS]; /*!< The link description of the device. */
   int link_num;                /*!< How many are actually present. */
   hal_u32_t iterations;        /*!< How many iterations were actually used to compute the inverse kinematics. */
+  genser_lu_struct lu;         /*!< Jacobian factors kept by the inverse kinematics. */
+  genser_lu_struct query_lu;   /*!< The same, for KINEMATICS_INVERSE_QUERY calls. */
 } genser_struct;
 
 extern int genser_kin_size(void);
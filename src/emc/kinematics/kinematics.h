@@ -71,6 +71,13 @@ typedef unsigned long int KINEMATICS_FORWARD_FLAGS;
    indicate this. */
 typedef unsigned long int KINEMATICS_INVERSE_FLAGS;
 
+/* set in the inverse flags by callers other than the servo cycle, like the
+   planner checking moves against the joint limits.  Kinematics that keep
+   state between calls (kept jacobian factors, iteration pins) use a
+   separate copy of it for these, so the servo cycle finds its own state
+   as it left it.  Modules without such state ignore it. */
+#define KINEMATICS_INVERSE_QUERY (1UL << (8 * sizeof(KINEMATICS_INVERSE_FLAGS) - 1))
+
 /* the forward kinematics take joint values and determine world coordinates,
    given forward kinematics flags to resolve any ambiguities. The inverse
    flags are set to indicate their value appropriate to the joint values
@@ -102,6 +109,35 @@ extern int kinematicsHome(struct EmcPose * world,
 
 extern KINEMATICS_TYPE kinematicsType(void);
 
+/* the batch kinematics do the same for n poses at once, for callers like
+   previews that need many of them. Joint set i starts at joint[i * stride].
+   The world positions (forward) or joint values (inverse) already in the
+   output arrays are the starting guesses of iterative kinematics, like for
+   the single pose calls. The flags are used for every pose, and the flags
+   set are those of the last one. When status is not NULL, status[i] gets
+   the result of pose i. Returns the number of poses that failed.
+
+   These are optional: modules that can do better than a loop around the
+   single pose functions (geometry looked up once) export them, kinsuser(3)
+   falls back to such a loop for the others. They must give the results of
+   the single pose functions, so they call the same code for each pose.
+   Motion does not use them. */
+extern int kinematicsForwardBatch(int n,
+                                  const double *joint,
+                                  int stride,
+                                  struct EmcPose * world,
+                                  const KINEMATICS_FORWARD_FLAGS * fflags,
+                                  KINEMATICS_INVERSE_FLAGS * iflags,
+                                  int *status);
+
+extern int kinematicsInverseBatch(int n,
+                                  const struct EmcPose * world,
+                                  double *joint,
+                                  int stride,
+                                  const KINEMATICS_INVERSE_FLAGS * iflags,
+                                  KINEMATICS_FORWARD_FLAGS * fflags,
+                                  int *status);
+
 /* parameters for use with switchkins.c */
 typedef struct kinematics_parms {
   char* sparm;     // module string parameter passed to kins
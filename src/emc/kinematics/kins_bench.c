@@ -0,0 +1,453 @@
+/********************************************************************
+* Description: kins_bench.c
+*   Throughput benchmark for the kinematics modules, through the
+*   userspace build of kinsuser.c.
+*
+*   For each module, the forward kinematics of a reference joint set
+*   give a reference pose.  A smooth path of poses on a circle around
+*   it is run through the batch inverse and back through the batch
+*   forward kinematics, seeded with the reference like a preview would
+*   be, and the time per pose is reported for the batch calls and for
+*   a loop of single pose calls.  The round trip error shows that the
+*   poses were reachable.
+*
+*   With -s the path is run like the servo thread does it instead: one
+*   pose per call, each seeded with the result for the previous one,
+*   and the mean and largest number of iterations of the iterative
+*   kinematics (their <module>.last-iterations pin) is reported.  -r
+*   sets how far the path reaches into the workspace, the step between
+*   poses is 2 pi radius / poses.
+*
+*   With -c nothing is timed: the path is run through the batch calls
+*   and through a loop of single pose calls from the same starting
+*   guesses, and it is an error when their results differ.
+*
+*     kins-bench [-v] [-s] [-c] [-n poses] [-r radius] [-j j0,j1,...]
+*                [-p pin=value]... [module [param=value ...]]
+*
+*   Without a module, a list of the common modules with their default
+*   geometry is measured; one of those named alone starts from its
+*   joints there unless -j is given.
+*
+* License: GPL Version 2
+* System: Linux
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "rtapi.h"
+#include "motion.h"
+#include "kinsuser.h"
+
+#define REPEAT 5
+
+typedef struct {
+    const char *module;
+    const char *args;
+    double joint[EMCMOT_MAX_JOINTS];
+    int by_pose;                /* joint from the inverse of pose */
+    EmcPose pose;
+} bench_t;
+
+/* reference joint sets away from singularities, for the default geometry;
+   for parallel kinematics a reference pose is easier to give */
+static const bench_t defaults[] = {
+    { .module = "trivkins" },
+    { .module = "corexykins" },
+    { .module = "xyzac-trt-kins", .joint = { 10, 20, -30, 15, 30 } },
+    { .module = "5axiskins", .joint = { 10, 20, 30, 15, 30 } },
+    { .module = "lineardeltakins", .joint = { 100, 100, 100 } },
+    { .module = "rotarydeltakins", .joint = { 10, 10, 10 } },
+    { .module = "scarakins", .joint = { 20, 40, 25, 10 } },
+    { .module = "pumakins", .joint = { 10, -60, 30, 10, 40, 10 } },
+    { .module = "genserkins", .joint = { 10, -60, 80, 10, 40, 10 } },
+    { .module = "genhexkins", .by_pose = 1, .pose = { { 0, 0, 20 } } },
+};
+
+static int poses = 100000;
+static double radius = 1.0;
+static int servo;
+static int check;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double pose_error(const EmcPose *a, const EmcPose *b)
+{
+    double e = fabs(a->tran.x - b->tran.x);
+    e = fmax(e, fabs(a->tran.y - b->tran.y));
+    e = fmax(e, fabs(a->tran.z - b->tran.z));
+    e = fmax(e, fabs(a->a - b->a));
+    e = fmax(e, fabs(a->b - b->b));
+    return fmax(e, fabs(a->c - b->c));
+}
+
+/* the iterations pin of the module, or NULL */
+static const char *iterations_pin(kinsuser_t *k, const char *module)
+{
+    const char *name;
+    size_t len = strlen(module);
+    int i;
+
+    for (i = 0; (name = kinsuser_pin_name(k, i)); i++) {
+	if (strncmp(name, module, len) == 0
+	    && strcmp(name + len, ".last-iterations") == 0) {
+	    return name;
+	}
+    }
+    return NULL;
+}
+
+typedef struct {
+    double ns;
+    double it_mean;
+    int it_max;
+    int failed;
+} servo_t;
+
+static void servo_path(kinsuser_t *k, const char *it_pin, const EmcPose *path,
+    const EmcPose *ref, const double *ref_joint, servo_t *inv, servo_t *fwd,
+    double *err)
+{
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    double joint[EMCMOT_MAX_JOINTS], it, t0, inv_ns = 0, fwd_ns = 0;
+    EmcPose world = *ref;
+    int i;
+
+    memset(inv, 0, sizeof(*inv));
+    memset(fwd, 0, sizeof(*fwd));
+    memcpy(joint, ref_joint, sizeof(joint));
+    *err = 0;
+    for (i = 0; i < poses; i++) {
+	t0 = now_ns();
+	inv->failed += kinsuser_inverse(k, &path[i], joint, &iflags, &fflags) != 0;
+	inv_ns += now_ns() - t0;
+	if (it_pin && !kinsuser_get(k, it_pin, &it)) {
+	    inv->it_mean += it;
+	    inv->it_max = fmax(inv->it_max, it);
+	}
+	t0 = now_ns();
+	fwd->failed += kinsuser_forward(k, joint, &world, &fflags, &iflags) != 0;
+	fwd_ns += now_ns() - t0;
+	if (it_pin && !kinsuser_get(k, it_pin, &it)) {
+	    fwd->it_mean += it;
+	    fwd->it_max = fmax(fwd->it_max, it);
+	}
+	*err = fmax(*err, pose_error(&path[i], &world));
+    }
+    inv->ns = inv_ns / poses;
+    fwd->ns = fwd_ns / poses;
+    inv->it_mean /= poses;
+    fwd->it_mean /= poses;
+}
+
+/* the batch calls give what single pose calls from the same starting
+   guesses give; returns -1 if they do not */
+static int check_batch(kinsuser_t *k, const char *module, const EmcPose *path,
+    const EmcPose *ref, const double *ref_joint)
+{
+    const int stride = EMCMOT_MAX_JOINTS;
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    double *joint, *loop_joint, joint_diff = 0, pose_diff = 0;
+    EmcPose *world, *loop_world;
+    int *status, status_diff = 0, i, j;
+
+    joint = malloc((size_t) poses * stride * sizeof(*joint));
+    loop_joint = malloc((size_t) poses * stride * sizeof(*loop_joint));
+    world = malloc(poses * sizeof(*world));
+    loop_world = malloc(poses * sizeof(*loop_world));
+    status = malloc(poses * sizeof(*status));
+    if (!joint || !loop_joint || !world || !loop_world || !status) {
+	fprintf(stderr, "out of memory for %d poses\n", poses);
+	exit(1);
+    }
+    for (i = 0; i < poses; i++) {
+	memcpy(joint + (long) i * stride, ref_joint, stride * sizeof(*joint));
+	memcpy(loop_joint + (long) i * stride, ref_joint,
+	    stride * sizeof(*joint));
+	world[i] = loop_world[i] = *ref;
+    }
+
+    kinsuser_inverse_batch(k, poses, path, joint, stride, &iflags, &fflags,
+	status);
+    for (i = 0; i < poses; i++) {
+	status_diff += status[i] != kinsuser_inverse(k, &path[i],
+	    loop_joint + (long) i * stride, &iflags, &fflags);
+	for (j = 0; j < stride; j++) {
+	    joint_diff = fmax(joint_diff, fabs(joint[(long) i * stride + j]
+		- loop_joint[(long) i * stride + j]));
+	}
+    }
+    kinsuser_forward_batch(k, poses, joint, stride, world, &fflags, &iflags,
+	status);
+    for (i = 0; i < poses; i++) {
+	status_diff += status[i] != kinsuser_forward(k,
+	    joint + (long) i * stride, &loop_world[i], &fflags, &iflags);
+	pose_diff = fmax(pose_diff, pose_error(&world[i], &loop_world[i]));
+    }
+
+    free(joint);
+    free(loop_joint);
+    free(world);
+    free(loop_world);
+    free(status);
+    if (status_diff || joint_diff > 1e-9 || pose_diff > 1e-9) {
+	printf("%-16s batch and single pose calls differ: %d results, "
+	    "joints by %g, poses by %g\n", module, status_diff, joint_diff,
+	    pose_diff);
+	return -1;
+    }
+    printf("%-16s batch and single pose calls agree\n", module);
+    return 0;
+}
+
+static int run(const bench_t *b, char **pins, int npins)
+{
+    const int stride = EMCMOT_MAX_JOINTS;
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    EmcPose ref, *path, *world;
+    double ref_joint[EMCMOT_MAX_JOINTS], *joint, t0, t, err = 0;
+    double inv_batch = 1e99, fwd_batch = 1e99, inv_loop = 1e99, fwd_loop = 1e99;
+    int i, n, rep, inv_failed = 0, fwd_failed = 0, result = 0;
+    kinsuser_t *k;
+
+    fflush(stdout);
+    k = kinsuser_load(b->module, b->args);
+    if (!k) {
+	return -1;
+    }
+    for (i = 0; i < npins; i++) {
+	char *eq = strchr(pins[i], '=');
+	if (!eq) {
+	    fprintf(stderr, "-p %s: expected pin=value\n", pins[i]);
+	    kinsuser_unload(k);
+	    return -1;
+	}
+	*eq = 0;
+	n = kinsuser_set(k, pins[i], atof(eq + 1));
+	*eq = '=';
+	if (n) {
+	    kinsuser_unload(k);
+	    return -1;
+	}
+    }
+
+    memcpy(ref_joint, b->joint, sizeof(ref_joint));
+    ref = b->pose;
+    if (b->by_pose) {
+	EmcPose first = ref;
+	if (kinsuser_inverse(k, &ref, ref_joint, &iflags, &fflags)) {
+	    printf("%-16s reference is not reachable\n", b->module);
+	    kinsuser_unload(k);
+	    return -1;
+	}
+	/* switchkins starts iterative forward kinematics from its last pose
+	   once after loading, not from the one passed in */
+	kinsuser_forward(k, ref_joint, &first, &fflags, &iflags);
+    }
+    if (kinsuser_forward(k, ref_joint, &ref, &fflags, &iflags)) {
+	printf("%-16s reference is not reachable\n", b->module);
+	kinsuser_unload(k);
+	return -1;
+    }
+
+    path = malloc(poses * sizeof(*path));
+    world = malloc(poses * sizeof(*world));
+    joint = malloc((size_t) poses * stride * sizeof(*joint));
+    if (!path || !world || !joint) {
+	fprintf(stderr, "out of memory for %d poses\n", poses);
+	exit(1);
+    }
+    for (i = 0; i < poses; i++) {
+	double a = 2 * M_PI * i / poses;
+	path[i] = ref;
+	path[i].tran.x += radius * cos(a);
+	path[i].tran.y += radius * sin(a);
+	path[i].tran.z += 0.5 * radius * sin(2 * a);
+    }
+
+    if (check) {
+	result = check_batch(k, b->module, path, &ref, ref_joint);
+	goto done;
+    }
+
+    if (servo) {
+	const char *it_pin = iterations_pin(k, b->module);
+	servo_t inv, fwd, best_inv, best_fwd;
+
+	/* the iteration counts are the same every time */
+	for (rep = 0; rep < REPEAT; rep++) {
+	    servo_path(k, it_pin, path, &ref, ref_joint, &inv, &fwd, &err);
+	    if (rep == 0 || inv.ns < best_inv.ns) {
+		best_inv = inv;
+	    }
+	    if (rep == 0 || fwd.ns < best_fwd.ns) {
+		best_fwd = fwd;
+	    }
+	}
+	printf("%-16s %9.1f %9.1f %6.2f %4d %6.2f %4d %8d %8d %9.2g\n",
+	    b->module, best_inv.ns, best_fwd.ns, best_inv.it_mean,
+	    best_inv.it_max, best_fwd.it_mean, best_fwd.it_max,
+	    best_inv.failed, best_fwd.failed, err);
+	goto done;
+    }
+
+    for (rep = 0; rep < REPEAT; rep++) {
+	for (i = 0; i < poses; i++) {
+	    memcpy(joint + (long) i * stride, ref_joint, sizeof(ref_joint));
+	}
+	t0 = now_ns();
+	inv_failed = kinsuser_inverse_batch(k, poses, path, joint, stride,
+	    &iflags, &fflags, NULL);
+	t = now_ns() - t0;
+	inv_batch = fmin(inv_batch, t / poses);
+
+	for (i = 0; i < poses; i++) {
+	    world[i] = ref;
+	}
+	t0 = now_ns();
+	fwd_failed = kinsuser_forward_batch(k, poses, joint, stride, world,
+	    &fflags, &iflags, NULL);
+	t = now_ns() - t0;
+	fwd_batch = fmin(fwd_batch, t / poses);
+
+	if (!kinsuser_batch(k)) {
+	    continue;
+	}
+	for (i = 0; i < poses; i++) {
+	    memcpy(joint + (long) i * stride, ref_joint, sizeof(ref_joint));
+	}
+	t0 = now_ns();
+	for (i = 0; i < poses; i++) {
+	    kinsuser_inverse(k, &path[i], joint + (long) i * stride,
+		&iflags, &fflags);
+	}
+	inv_loop = fmin(inv_loop, (now_ns() - t0) / poses);
+
+	for (i = 0; i < poses; i++) {
+	    world[i] = ref;
+	}
+	t0 = now_ns();
+	for (i = 0; i < poses; i++) {
+	    kinsuser_forward(k, joint + (long) i * stride, &world[i],
+		&fflags, &iflags);
+	}
+	fwd_loop = fmin(fwd_loop, (now_ns() - t0) / poses);
+    }
+    for (i = 0; i < poses; i++) {
+	err = fmax(err, pose_error(&path[i], &world[i]));
+    }
+
+    if (kinsuser_batch(k)) {
+	printf("%-16s %9.1f %9.1f %9.1f %9.1f %8d %8d %9.2g\n", b->module,
+	    inv_batch, fwd_batch, inv_loop, fwd_loop, inv_failed, fwd_failed,
+	    err);
+    } else {
+	printf("%-16s %9.1f %9.1f %9s %9s %8d %8d %9.2g\n", b->module,
+	    inv_batch, fwd_batch, "-", "-", inv_failed, fwd_failed, err);
+    }
+done:
+    free(path);
+    free(world);
+    free(joint);
+    kinsuser_unload(k);
+    return result;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: kins-bench [-v] [-s] [-c] [-n poses] [-r radius] "
+	"[-j j0,j1,...] [-p pin=value]... [module [param=value ...]]\n");
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    bench_t b;
+    char *pins[64], args[1024], *s;
+    int c, i, npins = 0, result = 0, joints_given = 0;
+
+    memset(&b, 0, sizeof(b));
+    while ((c = getopt(argc, argv, "vscn:r:j:p:")) != -1) {
+	switch (c) {
+	case 'v':
+	    rtapi_set_msg_level(RTAPI_MSG_ALL);
+	    break;
+	case 's':
+	    servo = 1;
+	    break;
+	case 'c':
+	    check = 1;
+	    break;
+	case 'n':
+	    poses = atoi(optarg);
+	    if (poses < 1) {
+		usage();
+	    }
+	    break;
+	case 'r':
+	    radius = atof(optarg);
+	    break;
+	case 'j':
+	    for (i = 0, s = optarg; s && i < EMCMOT_MAX_JOINTS; i++) {
+		b.joint[i] = strtod(s, &s);
+		s = *s == ',' ? s + 1 : NULL;
+	    }
+	    joints_given = 1;
+	    break;
+	case 'p':
+	    if (npins == 64) {
+		usage();
+	    }
+	    pins[npins++] = optarg;
+	    break;
+	default:
+	    usage();
+	}
+    }
+
+    if (check) {
+	printf("%d poses\n", poses);
+    } else if (servo) {
+	printf("%d poses, ns per pose\n", poses);
+	printf("%-16s %9s %9s %11s %11s %8s %8s %9s\n", "module", "inv", "fwd",
+	    "inv-it mean/max", "fwd-it", "inv-fail", "fwd-fail", "roundtrip");
+    } else {
+	printf("%d poses, ns per pose\n", poses);
+	printf("%-16s %9s %9s %9s %9s %8s %8s %9s\n", "module", "inv", "fwd",
+	    "inv-loop", "fwd-loop", "inv-fail", "fwd-fail", "roundtrip");
+    }
+    if (optind < argc) {
+	b.module = argv[optind++];
+	/* a module of the defaults starts where it does there */
+	for (i = 0; i < (int) (sizeof(defaults) / sizeof(defaults[0])); i++) {
+	    if (!joints_given && !strcmp(b.module, defaults[i].module)) {
+		memcpy(b.joint, defaults[i].joint, sizeof(b.joint));
+		b.by_pose = defaults[i].by_pose;
+		b.pose = defaults[i].pose;
+	    }
+	}
+	args[0] = 0;
+	for (; optind < argc; optind++) {
+	    strncat(args, argv[optind], sizeof(args) - strlen(args) - 2);
+	    strcat(args, " ");
+	}
+	b.args = args;
+	return run(&b, pins, npins) ? 1 : 0;
+    }
+    for (i = 0; i < (int) (sizeof(defaults) / sizeof(defaults[0])); i++) {
+	result |= run(&defaults[i], pins, npins);
+    }
+    return result ? 1 : 0;
+}
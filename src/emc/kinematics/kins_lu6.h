@@ -0,0 +1,79 @@
+/********************************************************************
+* Description: kins_lu6.h
+*   6x6 LU factorization for the iterative kinematics
+*
+*   genserkins and genhexkins solve a 6x6 Jacobian system in every
+*   Newton iteration.  These are fixed size, with partial pivoting and
+*   no allocation, so a factorization can also be kept and reused for
+*   the following iterations and servo cycles.
+*
+* License: GPL Version 2
+* System: Linux
+*
+********************************************************************/
+
+#ifndef KINS_LU6_H
+#define KINS_LU6_H
+
+#include "rtapi_math.h"
+
+/* pivots smaller than this, relative to the largest element, are
+   taken as singular */
+#define KINS_LU6_TINY 1e-12
+
+/* Factors A = P L U in place, the row permutation goes to piv[].
+   Returns -1 if A is singular. */
+static inline int kins_lu6_factor(double A[6][6], int piv[6])
+{
+    double amax = 0, tiny, t;
+    int i, j, k, p;
+
+    for (i = 0; i < 6; i++) {
+        for (j = 0; j < 6; j++) {
+            amax = fmax(amax, fabs(A[i][j]));
+        }
+    }
+    tiny = amax * KINS_LU6_TINY;
+    if (tiny == 0) return -1;
+
+    for (k = 0; k < 6; k++) {
+        p = k;
+        for (i = k + 1; i < 6; i++) {
+            if (fabs(A[i][k]) > fabs(A[p][k])) p = i;
+        }
+        piv[k] = p;
+        if (fabs(A[p][k]) < tiny) return -1;
+        if (p != k) {
+            for (j = 0; j < 6; j++) {
+                t = A[k][j]; A[k][j] = A[p][j]; A[p][j] = t;
+            }
+        }
+        for (i = k + 1; i < 6; i++) {
+            A[i][k] /= A[k][k];
+            for (j = k + 1; j < 6; j++) {
+                A[i][j] -= A[i][k] * A[k][j];
+            }
+        }
+    }
+    return 0;
+}
+
+/* Solves A x = b with the factors from kins_lu6_factor(); x may be b */
+static inline void kins_lu6_solve(const double LU[6][6], const int piv[6],
+                                  const double b[6], double x[6])
+{
+    double t;
+    int i, j;
+
+    for (i = 0; i < 6; i++) x[i] = b[i];
+    for (i = 0; i < 6; i++) {
+        t = x[piv[i]]; x[piv[i]] = x[i]; x[i] = t;
+        for (j = 0; j < i; j++) x[i] -= LU[i][j] * x[j];
+    }
+    for (i = 5; i >= 0; i--) {
+        for (j = i + 1; j < 6; j++) x[i] -= LU[i][j] * x[j];
+        x[i] /= LU[i][i];
+    }
+}
+
+#endif /* KINS_LU6_H */
@@ -0,0 +1,343 @@
+/********************************************************************
+* Description: kins_table.c
+*   Samples the kinematics of a module into a table for the kinstable=
+*   parameter of the switchkins modules, see kins_table.h.
+*
+*     kins-table [-v] [-f] [-t type] [-F flags] [-e limit]
+*                -g axis=lo:hi:n [-g ...] -j j0,j1,... [-w x,y,z,...]
+*                [-p pin=value]... -o file module [param=value ...]
+*
+*   An inverse table (the default) spans world coordinates, given by
+*   their letter xyzabcuvw in -g, and gives the joints listed with -j;
+*   the joints are also the starting guess of iterative kinematics.  The
+*   world coordinates without -g are those of -w (default 0).  A forward
+*   table (-f) spans joints, given by their number in -g, and gives the
+*   world coordinates; the other joints are those of -j and -w is the
+*   starting guess.  Every grid point is solved starting from a solved
+*   neighbour, so the grid should not cross singularities.
+*
+*   Then every cell is solved at its centre and at one point more
+*   towards each dimension, and compared with the interpolation.  Cells
+*   over the limit of -e, and cells next to a point that could not be
+*   solved, are marked to be solved exactly.  The largest error of the
+*   others is stored in the table and printed.
+*
+* License: GPL Version 2
+* System: Linux
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "rtapi.h"
+#include "motion.h"
+#include "kinsuser.h"
+#include "kins_table.h"
+
+static const char world_axes[] = "xyzabcuvw";
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: kins-table [-v] [-f] [-t type] [-F flags] "
+	"[-e limit] -g axis=lo:hi:n [-g ...]\n"
+	"                  -j j0,j1,... [-w x,y,z,...] [-p pin=value]... "
+	"-o file module [param=value ...]\n");
+    exit(1);
+}
+
+static int parse_list(const char *s, double *v, int max)
+{
+    char *end;
+    int n;
+
+    for (n = 0; s && n < max; n++) {
+	v[n] = strtod(s, &end);
+	if (end == s || (*end && *end != ',')) {
+	    return -1;
+	}
+	s = *end == ',' ? end + 1 : NULL;
+    }
+    return s ? -1 : n;
+}
+
+static void pose_to_array(const EmcPose *pos, double *v)
+{
+    v[0] = pos->tran.x; v[1] = pos->tran.y; v[2] = pos->tran.z;
+    v[3] = pos->a;      v[4] = pos->b;      v[5] = pos->c;
+    v[6] = pos->u;      v[7] = pos->v;      v[8] = pos->w;
+}
+
+static void array_to_pose(const double *v, EmcPose *pos)
+{
+    pos->tran.x = v[0]; pos->tran.y = v[1]; pos->tran.z = v[2];
+    pos->a      = v[3]; pos->b      = v[4]; pos->c      = v[5];
+    pos->u      = v[6]; pos->v      = v[7]; pos->w      = v[8];
+}
+
+/* solves in[nin] into out[nout], starting from seed[nout] */
+static int solve(kinsuser_t *k, const kins_table_hdr_t *h, const double *in,
+    const double *seed, double *out)
+{
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    double joint[EMCMOT_MAX_JOINTS] = { 0 };
+    EmcPose world;
+
+    if (h->direction == KINS_TABLE_INVERSE) {
+	iflags = h->flags;
+	memcpy(joint, seed, h->nout * sizeof(double));
+	array_to_pose(in, &world);
+	if (kinsuser_inverse(k, &world, joint, &iflags, &fflags)) {
+	    return -1;
+	}
+	memcpy(out, joint, h->nout * sizeof(double));
+    } else {
+	fflags = h->flags;
+	memcpy(joint, in, h->nin * sizeof(double));
+	array_to_pose(seed, &world);
+	if (kinsuser_forward(k, joint, &world, &fflags, &iflags)) {
+	    return -1;
+	}
+	pose_to_array(&world, out);
+    }
+    return 0;
+}
+
+static int has_nan(const double *v, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+	if (isnan(v[i])) {
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    kins_table_hdr_t *h;
+    kins_table_t t;
+    kinsuser_t *k;
+    char *pins[64], args[1024], *grids[KINS_TABLE_MAX_DIMS], *s, *eq, *end;
+    const char *output = NULL, *err;
+    double joints[EMCMOT_MAX_JOINTS] = { 0 }, world[9] = { 0 };
+    double in[EMCMOT_MAX_JOINTS], out[EMCMOT_MAX_JOINTS], *seed, *v, *fixed;
+    double e, max_error = 0, sum_sq = 0, limit = HUGE_VAL;
+    long points, cells, p, size, failed = 0, exact = 0;
+    unsigned char *cell_exact;
+    int c, i, d, type = 0, forward = 0, verbose = 0, npins = 0, ngrids = 0;
+    int njoints = -1;
+    unsigned long flags = 0;
+    FILE *f;
+
+    while ((c = getopt(argc, argv, "vft:F:e:g:j:w:p:o:")) != -1) {
+	switch (c) {
+	case 'v':
+	    verbose = 1;
+	    rtapi_set_msg_level(RTAPI_MSG_ALL);
+	    break;
+	case 'f':
+	    forward = 1;
+	    break;
+	case 't':
+	    type = atoi(optarg);
+	    break;
+	case 'F':
+	    flags = strtoul(optarg, NULL, 0);
+	    break;
+	case 'e':
+	    limit = atof(optarg);
+	    break;
+	case 'g':
+	    if (ngrids == KINS_TABLE_MAX_DIMS) {
+		fprintf(stderr, "at most %d -g\n", KINS_TABLE_MAX_DIMS);
+		exit(1);
+	    }
+	    grids[ngrids++] = optarg;
+	    break;
+	case 'j':
+	    njoints = parse_list(optarg, joints, EMCMOT_MAX_JOINTS);
+	    if (njoints < 1) {
+		usage();
+	    }
+	    break;
+	case 'w':
+	    if (parse_list(optarg, world, 9) < 0) {
+		usage();
+	    }
+	    break;
+	case 'p':
+	    if (npins == 64) {
+		usage();
+	    }
+	    pins[npins++] = optarg;
+	    break;
+	case 'o':
+	    output = optarg;
+	    break;
+	default:
+	    usage();
+	}
+    }
+    if (optind >= argc || !output || !ngrids || njoints < 1) {
+	usage();
+    }
+
+    h = calloc(1, sizeof(*h));
+    if (!h) {
+	perror("kins-table");
+	exit(1);
+    }
+    memcpy(h->magic, KINS_TABLE_MAGIC, sizeof(h->magic));
+    h->version = KINS_TABLE_VERSION;
+    h->direction = forward ? KINS_TABLE_FORWARD : KINS_TABLE_INVERSE;
+    h->kinstype = type;
+    h->flags = flags;
+    h->nin = forward ? njoints : 9;
+    h->nout = forward ? 9 : njoints;
+    h->dims = ngrids;
+    h->limit = limit;
+    memcpy(h->fixed, forward ? joints : world, h->nin * sizeof(double));
+    for (d = 0; d < ngrids; d++) {
+	s = grids[d];
+	eq = strchr(s, '=');
+	if (!eq || sscanf(eq + 1, "%lf:%lf:%u", &h->lo[d], &h->hi[d],
+		&h->n[d]) != 3) {
+	    fprintf(stderr, "-g %s: expected axis=lo:hi:n\n", s);
+	    exit(1);
+	}
+	if (forward) {
+	    h->axis[d] = strtoul(s, &end, 10);
+	    if (end != eq || end == s) {
+		h->axis[d] = 99;
+	    }
+	} else if (eq - s == 1 && *s && strchr(world_axes, *s)) {
+	    h->axis[d] = strchr(world_axes, *s) - world_axes;
+	} else {
+	    h->axis[d] = 99;
+	}
+    }
+
+    points = kins_table_points(h, 0);
+    cells = kins_table_points(h, 1);
+    size = sizeof(*h) + points * h->nout * sizeof(double) + cells;
+    if (points <= 0 || points > KINS_TABLE_MAX_POINTS
+	|| !(h = realloc(h, size))) {
+	fprintf(stderr, "kins-table: bad grid\n");
+	exit(1);
+    }
+    memset(h + 1, 0, size - sizeof(*h));
+    err = kins_table_open(&t, h, size);
+    if (err) {
+	fprintf(stderr, "kins-table: %s\n", err);
+	exit(1);
+    }
+    v = (double *) t.values;
+    cell_exact = (unsigned char *) t.exact;
+
+    args[0] = 0;
+    for (i = optind + 1; i < argc; i++) {
+	strncat(args, argv[i], sizeof(args) - strlen(args) - 2);
+	strcat(args, " ");
+    }
+    k = kinsuser_load(argv[optind], args);
+    if (!k) {
+	exit(1);
+    }
+    for (i = 0; i < npins; i++) {
+	eq = strchr(pins[i], '=');
+	if (!eq) {
+	    fprintf(stderr, "-p %s: expected pin=value\n", pins[i]);
+	    exit(1);
+	}
+	*eq = 0;
+	if (kinsuser_set(k, pins[i], atof(eq + 1))) {
+	    exit(1);
+	}
+    }
+    if (type && kinsuser_switch(k, type)) {
+	fprintf(stderr, "kins-table: cannot switch to type %d\n", type);
+	exit(1);
+    }
+    fixed = forward ? world : joints;
+
+    /* the grid points, each from the neighbour before it */
+    for (p = 0; p < points; p++) {
+	memcpy(in, h->fixed, h->nin * sizeof(double));
+	seed = fixed;
+	for (d = ngrids - 1; d >= 0; d--) {
+	    i = p / t.stride[d] % h->n[d];
+	    in[h->axis[d]] = h->lo[d] + i * (h->hi[d] - h->lo[d]) / (h->n[d] - 1);
+	    if (i && !has_nan(v + (p - t.stride[d]) * h->nout, h->nout)) {
+		seed = v + (p - t.stride[d]) * h->nout;
+	    }
+	}
+	if (solve(k, h, in, seed, v + p * h->nout)) {
+	    for (i = 0; i < (int) h->nout; i++) {
+		v[p * h->nout + i] = NAN;
+	    }
+	    failed++;
+	}
+    }
+
+    /* the cells, at their centre and at a point towards each dimension */
+    for (p = 0; p < cells; p++) {
+	double exact_out[EMCMOT_MAX_JOINTS];
+	int cidx[KINS_TABLE_MAX_DIMS], q;
+	long base = 0, corner;
+	unsigned cn;
+
+	for (d = 0; d < ngrids; d++) {
+	    cidx[d] = p / t.cstride[d] % (h->n[d] - 1);
+	    base += cidx[d] * t.stride[d];
+	}
+	for (cn = 0; cn < 1u << ngrids && !cell_exact[p]; cn++) {
+	    for (d = 0, corner = base; d < ngrids; d++) {
+		corner += cn & (1u << d) ? t.stride[d] : 0;
+	    }
+	    cell_exact[p] = has_nan(v + corner * h->nout, h->nout);
+	}
+	for (q = 0, e = 0; q <= ngrids && !cell_exact[p]; q++) {
+	    memcpy(in, h->fixed, h->nin * sizeof(double));
+	    for (d = 0; d < ngrids; d++) {
+		in[h->axis[d]] = h->lo[d] + (cidx[d]
+		    + (q == 0 ? 0.5 : q - 1 == d ? 0.75 : 0.25))
+		    * (h->hi[d] - h->lo[d]) / (h->n[d] - 1);
+	    }
+	    cell_exact[p] = solve(k, h, in, v + base * h->nout, exact_out)
+		|| kins_table_lookup(&t, in, out);
+	    for (i = 0; !cell_exact[p] && i < (int) h->nout; i++) {
+		e = fmax(e, fabs(out[i] - exact_out[i]));
+	    }
+	}
+	if (e > limit) {
+	    cell_exact[p] = 1;
+	}
+	if (!cell_exact[p]) {
+	    max_error = fmax(max_error, e);
+	    sum_sq += e * e;
+	} else if (verbose) {
+	    printf("cell %ld solved exactly, error %g\n", p, e);
+	}
+	exact += cell_exact[p];
+    }
+    h->max_error = max_error;
+    kinsuser_unload(k);
+
+    f = fopen(output, "wb");
+    if (!f || fwrite(h, size, 1, f) != 1 || fclose(f)) {
+	perror(output);
+	exit(1);
+    }
+    printf("%s: %ld points, %ld unreachable, %ld cells, %ld solved exactly\n",
+	output, points, failed, cells, exact);
+    printf("error in the cells: max %g, rms %g; %ld bytes\n",
+	max_error, cells > exact ? sqrt(sum_sq / (cells - exact)) : 0.0,
+	size);
+    free(h);
+    return 0;
+}
@@ -0,0 +1,182 @@
+/********************************************************************
+* Description: kins_table.h
+*   Precomputed kinematics tables
+*
+*   kins-table samples the inverse or forward kinematics of a module on
+*   a regular grid over a part of the workspace.  A switchkins module
+*   given the file with kinstable= interpolates in it instead of solving,
+*   in a fixed number of steps.  Inputs outside the grid, or in a cell next to
+*   a grid point the kinematics could not reach, or in a cell whose error
+*   was over the limit given to kins-table, are solved exactly.
+*
+* License: GPL Version 2
+* System: Linux
+*
+********************************************************************/
+
+#ifndef KINS_TABLE_H
+#define KINS_TABLE_H
+
+#include "rtapi_math.h"
+#include "rtapi_stdint.h"
+#include "rtapi_string.h"
+#include "emcmotcfg.h"          /* EMCMOT_MAX_JOINTS */
+
+#define KINS_TABLE_MAGIC "KINSTBL"
+#define KINS_TABLE_VERSION 1
+#define KINS_TABLE_MAX_DIMS 6
+#define KINS_TABLE_MAX_POINTS (1L << 28)
+/* inputs outside the grid must be this close to the sampled value */
+#define KINS_TABLE_FIXED_TOL 1e-9
+
+#define KINS_TABLE_INVERSE 0    /* world x y z a b c u v w to joints */
+#define KINS_TABLE_FORWARD 1    /* joints to world x y z a b c u v w */
+
+/* The file is this header, then the outputs for every grid point as
+   doubles, dimension 0 varying fastest, then one byte per cell,
+   nonzero for the cells that are solved exactly.  Native byte order. */
+typedef struct {
+    char magic[8];
+    rtapi_u32 version;
+    rtapi_u32 direction;
+    rtapi_u32 kinstype;         /* switchkins_type it was sampled with */
+    rtapi_u32 nin;              /* inputs: 9 world coordinates or joints */
+    rtapi_u32 nout;             /* outputs per grid point */
+    rtapi_u32 dims;             /* inputs spanned by the grid */
+    rtapi_u64 flags;            /* inverse or forward flags passed in */
+    rtapi_u32 axis[KINS_TABLE_MAX_DIMS];  /* input of each dimension */
+    rtapi_u32 n[KINS_TABLE_MAX_DIMS];     /* grid points along it */
+    double lo[KINS_TABLE_MAX_DIMS];
+    double hi[KINS_TABLE_MAX_DIMS];
+    double fixed[EMCMOT_MAX_JOINTS];      /* value of the other inputs */
+    double max_error;           /* largest error kins-table measured */
+    double limit;               /* cells over this are solved exactly */
+} kins_table_hdr_t;
+
+typedef struct {
+    const kins_table_hdr_t *hdr;
+    const double *values;
+    const unsigned char *exact;
+    long stride[KINS_TABLE_MAX_DIMS];   /* grid points */
+    long cstride[KINS_TABLE_MAX_DIMS];  /* cells */
+    double scale[KINS_TABLE_MAX_DIMS];  /* grid steps per input unit */
+    int nfixed;
+    int fixed[EMCMOT_MAX_JOINTS];       /* inputs not in the grid */
+} kins_table_t;
+
+static inline long kins_table_points(const kins_table_hdr_t *h, int cells)
+{
+    long points = 1;
+    rtapi_u32 d;
+
+    for (d = 0; d < h->dims; d++) {
+        points *= h->n[d] - cells;
+    }
+    return points;
+}
+
+/* Checks the table in data and fills in t.  Returns NULL, or what is
+   wrong with it. */
+static inline const char *kins_table_open(kins_table_t *t,
+                                          const void *data, long size)
+{
+    const kins_table_hdr_t *h = data;
+    long points = 1, cells = 1;
+    rtapi_u32 d, i;
+    int used;
+
+    if (size < (long)sizeof(*h)
+        || memcmp(h->magic, KINS_TABLE_MAGIC, sizeof(h->magic))) {
+        return "not a kinematics table";
+    }
+    if (h->version != KINS_TABLE_VERSION) return "unsupported version";
+    if (h->direction > KINS_TABLE_FORWARD) return "bad direction";
+    if (h->nin < 1 || h->nin > EMCMOT_MAX_JOINTS
+        || h->nout < 1 || h->nout > EMCMOT_MAX_JOINTS) {
+        return "bad number of inputs or outputs";
+    }
+    if (h->dims < 1 || h->dims > KINS_TABLE_MAX_DIMS) {
+        return "bad number of dimensions";
+    }
+    for (d = 0; d < h->dims; d++) {
+        if (h->axis[d] >= h->nin || h->n[d] < 2 || !(h->hi[d] > h->lo[d])) {
+            return "bad grid";
+        }
+        for (i = 0; i < d; i++) {
+            if (h->axis[i] == h->axis[d]) return "bad grid";
+        }
+        t->stride[d] = points;
+        t->cstride[d] = cells;
+        t->scale[d] = (h->n[d] - 1) / (h->hi[d] - h->lo[d]);
+        points *= h->n[d];
+        cells *= h->n[d] - 1;
+        if (points > KINS_TABLE_MAX_POINTS) return "too large";
+    }
+    if (size != (long)sizeof(*h) + points * h->nout * (long)sizeof(double)
+                + cells) {
+        return "wrong size";
+    }
+    t->nfixed = 0;
+    for (i = 0; i < h->nin; i++) {
+        for (d = 0, used = 0; d < h->dims; d++) {
+            used |= h->axis[d] == i;
+        }
+        if (!used) t->fixed[t->nfixed++] = i;
+    }
+    t->hdr = h;
+    t->values = (const double *)(h + 1);
+    t->exact = (const unsigned char *)(t->values + points * h->nout);
+    return 0;
+}
+
+/* Interpolates the outputs for the nin inputs in.  Returns 0, or 1 when
+   the input must be solved exactly; out is only written on 0.
+
+   The cell is split into dims! simplices along its diagonal, and the
+   interpolation is linear in the one holding the input, so only
+   dims + 1 grid points are read instead of all 2^dims corners. */
+static inline int kins_table_lookup(const kins_table_t *t, const double *in,
+                                    double *out)
+{
+    const kins_table_hdr_t *h = t->hdr;
+    double f[KINS_TABLE_MAX_DIMS], u, w;
+    int order[KINS_TABLE_MAX_DIMS];
+    const double *v;
+    long base = 0, cell = 0;
+    rtapi_u32 d, j;
+    int i, k;
+
+    for (i = 0; i < t->nfixed; i++) {
+        if (fabs(in[t->fixed[i]] - h->fixed[t->fixed[i]]) > KINS_TABLE_FIXED_TOL) {
+            return 1;
+        }
+    }
+    for (d = 0; d < h->dims; d++) {
+        u = (in[h->axis[d]] - h->lo[d]) * t->scale[d];
+        if (!(u >= 0 && u <= h->n[d] - 1)) return 1;
+        i = (int)u;
+        if (i > (int)h->n[d] - 2) i = h->n[d] - 2;
+        f[d] = u - i;
+        base += i * t->stride[d];
+        cell += i * t->cstride[d];
+        /* dimensions by decreasing fraction */
+        for (k = d; k > 0 && f[order[k - 1]] < f[d]; k--) {
+            order[k] = order[k - 1];
+        }
+        order[k] = d;
+    }
+    if (t->exact[cell]) return 1;
+
+    v = t->values + base * h->nout;
+    w = 1 - f[order[0]];
+    for (j = 0; j < h->nout; j++) out[j] = w * v[j];
+    for (d = 0; d < h->dims; d++) {
+        base += t->stride[order[d]];
+        v = t->values + base * h->nout;
+        w = f[order[d]] - (d + 1 < h->dims ? f[order[d + 1]] : 0);
+        for (j = 0; j < h->nout; j++) out[j] += w * v[j];
+    }
+    return 0;
+}
+
+#endif /* KINS_TABLE_H */
@@ -0,0 +1,833 @@
+/********************************************************************
+* Description: kinsuser.c
+*
+*   Kinematics modules in userspace programs, see kinsuser.h
+*
+*   The uspace kinematics modules are shared objects that leave the
+*   RTAPI and HAL functions they call to be resolved when they are
+*   loaded.  rtapi_app provides the real ones; this library provides
+*   the few a kinematics module needs, keeping pins and hal_malloc
+*   memory in the process.  Module parameters are set the way
+*   rtapi_app sets them, through the rtapi_info_* symbols.
+*
+*   Not thread safe.  A program using this cannot also use the HAL
+*   library (liblinuxcnchal) directly, the names would collide; the
+*   python hal module is fine, python loads it with RTLD_LOCAL.
+*
+* License: GPL Version 2
+* System: Linux
+*
+********************************************************************/
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "config.h"
+#include "rtapi.h"
+#include "hal.h"
+#include "rtapi_firmware.h"
+#include "kinematics.h"
+#include "kinsuser.h"
+
+typedef int (*fwd_fn)(const double *, EmcPose *,
+        const KINEMATICS_FORWARD_FLAGS *, KINEMATICS_INVERSE_FLAGS *);
+typedef int (*inv_fn)(const EmcPose *, double *,
+        const KINEMATICS_INVERSE_FLAGS *, KINEMATICS_FORWARD_FLAGS *);
+typedef int (*fwd_batch_fn)(int, const double *, int, EmcPose *,
+        const KINEMATICS_FORWARD_FLAGS *, KINEMATICS_INVERSE_FLAGS *, int *);
+typedef int (*inv_batch_fn)(int, const EmcPose *, double *, int,
+        const KINEMATICS_INVERSE_FLAGS *, KINEMATICS_FORWARD_FLAGS *, int *);
+
+struct kinsuser {
+    char name[HAL_NAME_LEN + 1];
+    void *dll;
+    int comp_id;
+    fwd_fn forward;
+    inv_fn inverse;
+    fwd_batch_fn forward_batch;
+    inv_batch_fn inverse_batch;
+    KINEMATICS_TYPE (*type)(void);
+    int (*sw)(int);
+    void (*app_exit)(void);
+    struct kinsuser *next;
+};
+
+typedef struct kins_pin {
+    char name[HAL_NAME_LEN + 1];
+    int comp_id;
+    hal_type_t type;
+    void *data;                 /* value below for pins, the module's for params */
+    union {
+        hal_bit_t b;
+        hal_s32_t s;
+        hal_u32_t u;
+        real_t f;
+    } value;
+    struct kins_pin *next;
+} kins_pin_t;
+
+typedef struct kins_mem {
+    int comp_id;
+    struct kins_mem *next;
+    double data[];              /* aligned like hal_malloc memory */
+} kins_mem_t;
+
+static kinsuser_t *loaded;
+static kinsuser_t *loading;     /* while its rtapi_app_main runs */
+static kins_pin_t *pins;
+static kins_mem_t *mems;
+static int next_comp_id = 1;
+static msg_level_t msg_level = RTAPI_MSG_ERR;
+
+/***********************************************************************
+*                  RTAPI and HAL for the modules                       *
+************************************************************************/
+
+/* the setup chatter of the modules only when asked for */
+void rtapi_print(const char *fmt, ...)
+{
+    va_list args;
+
+    if (msg_level < RTAPI_MSG_INFO) {
+	return;
+    }
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...)
+{
+    va_list args;
+
+    if (level > msg_level) {
+	return;
+    }
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+int rtapi_set_msg_level(int level)
+{
+    if (level < RTAPI_MSG_NONE || level > RTAPI_MSG_ALL) {
+	return -EINVAL;
+    }
+    msg_level = level;
+    return 0;
+}
+
+int rtapi_get_msg_level(void)
+{
+    return msg_level;
+}
+
+int rtapi_vsnprintf(char *buf, unsigned long size, const char *fmt,
+    va_list ap)
+{
+    return vsnprintf(buf, size, fmt, ap);
+}
+
+int rtapi_snprintf(char *buf, unsigned long size, const char *fmt, ...)
+{
+    va_list args;
+    int result;
+
+    va_start(args, fmt);
+    result = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return result;
+}
+
+int rtapi_exit(int module_id)
+{
+    (void) module_id;
+    return 0;
+}
+
+/* for the kinstable= files of switchkins modules; like rtapi_app, the
+   name is absolute or in /lib/firmware */
+int rtapi_request_firmware(const struct rtapi_firmware **fw,
+    const char *name, struct rtapi_device *device)
+{
+    struct rtapi_firmware *lfw;
+    char path[PATH_MAX];
+    struct stat st;
+    void *data;
+    int fd;
+
+    (void) device;
+    snprintf(path, sizeof(path), "%s%s",
+	name[0] == '/' ? "" : "/lib/firmware/", name);
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "Could not open \"%s\" (%s)\n",
+	    path, strerror(errno));
+	if (fd >= 0) {
+	    close(fd);
+	}
+	return -ENOENT;
+    }
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "Failed to mmap file %s\n", path);
+	return -1;
+    }
+    lfw = malloc(sizeof(*lfw));
+    if (!lfw) {
+	munmap(data, st.st_size);
+	return -ENOMEM;
+    }
+    lfw->size = st.st_size;
+    lfw->data = data;
+    *fw = lfw;
+    return 0;
+}
+
+void rtapi_release_firmware(const struct rtapi_firmware *fw)
+{
+    munmap((void *) fw->data, fw->size);
+    free((void *) fw);
+}
+
+int hal_init(const char *name)
+{
+    int comp_id = next_comp_id++;
+
+    (void) name;
+    if (loading && loading->comp_id < 0) {
+	loading->comp_id = comp_id;
+    }
+    return comp_id;
+}
+
+int hal_ready(int comp_id)
+{
+    (void) comp_id;
+    return 0;
+}
+
+int hal_exit(int comp_id)
+{
+    kins_pin_t **pp = &pins, *p;
+    kins_mem_t **mp = &mems, *m;
+
+    while ((p = *pp)) {
+	if (p->comp_id == comp_id) {
+	    *pp = p->next;
+	    free(p);
+	} else {
+	    pp = &p->next;
+	}
+    }
+    while ((m = *mp)) {
+	if (m->comp_id == comp_id) {
+	    *mp = m->next;
+	    free(m);
+	} else {
+	    mp = &m->next;
+	}
+    }
+    return 0;
+}
+
+void *hal_malloc(long int size)
+{
+    kins_mem_t *m;
+
+    if (size <= 0) {
+	return NULL;
+    }
+    m = calloc(1, sizeof(*m) + size);
+    if (!m) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: insufficient memory\n");
+	return NULL;
+    }
+    m->comp_id = loading ? loading->comp_id : 0;
+    m->next = mems;
+    mems = m;
+    return m->data;
+}
+
+static kins_pin_t *find_pin(const char *name)
+{
+    kins_pin_t *p;
+
+    for (p = pins; p; p = p->next) {
+	if (strcmp(p->name, name) == 0) {
+	    return p;
+	}
+    }
+    return NULL;
+}
+
+static kins_pin_t *new_object(const char *name, hal_type_t type, int comp_id)
+{
+    kins_pin_t *p, **pp;
+
+    if (strlen(name) > HAL_NAME_LEN) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: name '%s' is too long\n",
+	    name);
+	return NULL;
+    }
+    if (find_pin(name)) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: duplicate name '%s'\n",
+	    name);
+	return NULL;
+    }
+    p = calloc(1, sizeof(*p));
+    if (!p) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: insufficient memory\n");
+	return NULL;
+    }
+    strcpy(p->name, name);
+    p->type = type;
+    p->comp_id = comp_id;
+    /* in creation order, like halcmd shows them */
+    for (pp = &pins; *pp; pp = &(*pp)->next);
+    *pp = p;
+    return p;
+}
+
+static int new_pin(const char *name, hal_type_t type, void **data_ptr_addr,
+    int comp_id)
+{
+    kins_pin_t *p = new_object(name, type, comp_id);
+
+    if (!p) {
+	return -EINVAL;
+    }
+    p->data = &p->value;
+    *data_ptr_addr = p->data;
+    return 0;
+}
+
+static int new_param(const char *name, hal_type_t type, void *data_addr,
+    int comp_id)
+{
+    kins_pin_t *p = new_object(name, type, comp_id);
+
+    if (!p) {
+	return -EINVAL;
+    }
+    p->data = data_addr;
+    return 0;
+}
+
+#define NEWF(call) do { \
+	char name[HAL_NAME_LEN + 1]; \
+	va_list args; \
+	int sz; \
+	va_start(args, fmt); \
+	sz = vsnprintf(name, sizeof(name), fmt, args); \
+	va_end(args); \
+	if (sz < 0 || sz > HAL_NAME_LEN) { \
+	    rtapi_print_msg(RTAPI_MSG_ERR, \
+		"HAL: ERROR: name '%s' is too long\n", name); \
+	    return -ENOMEM; \
+	} \
+	return call; \
+    } while (0)
+
+int hal_pin_bit_new(const char *name, hal_pin_dir_t dir,
+    hal_bit_t ** data_ptr_addr, int comp_id)
+{
+    (void) dir;
+    return new_pin(name, HAL_BIT, (void **) data_ptr_addr, comp_id);
+}
+
+int hal_pin_float_new(const char *name, hal_pin_dir_t dir,
+    hal_float_t ** data_ptr_addr, int comp_id)
+{
+    (void) dir;
+    return new_pin(name, HAL_FLOAT, (void **) data_ptr_addr, comp_id);
+}
+
+int hal_pin_u32_new(const char *name, hal_pin_dir_t dir,
+    hal_u32_t ** data_ptr_addr, int comp_id)
+{
+    (void) dir;
+    return new_pin(name, HAL_U32, (void **) data_ptr_addr, comp_id);
+}
+
+int hal_pin_s32_new(const char *name, hal_pin_dir_t dir,
+    hal_s32_t ** data_ptr_addr, int comp_id)
+{
+    (void) dir;
+    return new_pin(name, HAL_S32, (void **) data_ptr_addr, comp_id);
+}
+
+int hal_pin_bit_newf(hal_pin_dir_t dir,
+    hal_bit_t ** data_ptr_addr, int comp_id, const char *fmt, ...)
+{
+    NEWF(hal_pin_bit_new(name, dir, data_ptr_addr, comp_id));
+}
+
+int hal_pin_float_newf(hal_pin_dir_t dir,
+    hal_float_t ** data_ptr_addr, int comp_id, const char *fmt, ...)
+{
+    NEWF(hal_pin_float_new(name, dir, data_ptr_addr, comp_id));
+}
+
+int hal_pin_u32_newf(hal_pin_dir_t dir,
+    hal_u32_t ** data_ptr_addr, int comp_id, const char *fmt, ...)
+{
+    NEWF(hal_pin_u32_new(name, dir, data_ptr_addr, comp_id));
+}
+
+int hal_pin_s32_newf(hal_pin_dir_t dir,
+    hal_s32_t ** data_ptr_addr, int comp_id, const char *fmt, ...)
+{
+    NEWF(hal_pin_s32_new(name, dir, data_ptr_addr, comp_id));
+}
+
+int hal_param_bit_new(const char *name, hal_param_dir_t dir,
+    hal_bit_t * data_addr, int comp_id)
+{
+    (void) dir;
+    return new_param(name, HAL_BIT, (void *) data_addr, comp_id);
+}
+
+int hal_param_float_new(const char *name, hal_param_dir_t dir,
+    hal_float_t * data_addr, int comp_id)
+{
+    (void) dir;
+    return new_param(name, HAL_FLOAT, (void *) data_addr, comp_id);
+}
+
+int hal_param_u32_new(const char *name, hal_param_dir_t dir,
+    hal_u32_t * data_addr, int comp_id)
+{
+    (void) dir;
+    return new_param(name, HAL_U32, (void *) data_addr, comp_id);
+}
+
+int hal_param_s32_new(const char *name, hal_param_dir_t dir,
+    hal_s32_t * data_addr, int comp_id)
+{
+    (void) dir;
+    return new_param(name, HAL_S32, (void *) data_addr, comp_id);
+}
+
+int hal_param_bit_newf(hal_param_dir_t dir,
+    hal_bit_t * data_addr, int comp_id, const char *fmt, ...)
+{
+    NEWF(hal_param_bit_new(name, dir, data_addr, comp_id));
+}
+
+int hal_param_float_newf(hal_param_dir_t dir,
+    hal_float_t * data_addr, int comp_id, const char *fmt, ...)
+{
+    NEWF(hal_param_float_new(name, dir, data_addr, comp_id));
+}
+
+int hal_param_u32_newf(hal_param_dir_t dir,
+    hal_u32_t * data_addr, int comp_id, const char *fmt, ...)
+{
+    NEWF(hal_param_u32_new(name, dir, data_addr, comp_id));
+}
+
+int hal_param_s32_newf(hal_param_dir_t dir,
+    hal_s32_t * data_addr, int comp_id, const char *fmt, ...)
+{
+    NEWF(hal_param_s32_new(name, dir, data_addr, comp_id));
+}
+
+/***********************************************************************
+*                        Loading modules                               *
+************************************************************************/
+
+/* The modules find the functions above in the global scope.  When this
+   library was itself loaded with dlopen() (python ctypes), it is not in
+   it yet. */
+static int make_global(void)
+{
+    static int done;
+    Dl_info info;
+
+    if (done) {
+	return 0;
+    }
+    if (!dladdr((void *) make_global, &info) || !info.dli_fname) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "kinsuser: dladdr failed\n");
+	return -1;
+    }
+    if (!dlopen(info.dli_fname, RTLD_NOW | RTLD_NOLOAD | RTLD_GLOBAL)) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "kinsuser: %s\n", dlerror());
+	return -1;
+    }
+    done = 1;
+    return 0;
+}
+
+static int set_one_item(char type, const char *name, const char *value,
+    void *item, int idx)
+{
+    char *endp;
+
+    switch (type) {
+    case 'l':
+	(*(long **) item)[idx] = strtol(value, &endp, 0);
+	break;
+    case 'i':
+	(*(int **) item)[idx] = strtol(value, &endp, 0);
+	break;
+    case 's':
+	(*(char ***) item)[idx] = strdup(value);
+	return 0;
+    default:
+	rtapi_print_msg(RTAPI_MSG_ERR, "%s: Invalid type character `%c'\n",
+	    name, type);
+	return -1;
+    }
+    if (*endp) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "`%s' invalid for parameter `%s'\n",
+	    value, name);
+	return -1;
+    }
+    return 0;
+}
+
+/* name=value[,value...] */
+static int set_arg(void *dll, char *arg)
+{
+    char sym[HAL_NAME_LEN + 32], *value, *next;
+    char **type;
+    void *item;
+    int *size, i;
+
+    value = strchr(arg, '=');
+    if (!value) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "Invalid parameter `%s'\n", arg);
+	return -1;
+    }
+    *value++ = 0;
+    snprintf(sym, sizeof(sym), "rtapi_info_address_%s", arg);
+    item = dlsym(dll, sym);
+    snprintf(sym, sizeof(sym), "rtapi_info_type_%s", arg);
+    type = dlsym(dll, sym);
+    if (!item || !type || !*type) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "Unknown parameter `%s'\n", arg);
+	return -1;
+    }
+    snprintf(sym, sizeof(sym), "rtapi_info_size_%s", arg);
+    size = dlsym(dll, sym);
+    if (!size) {
+	return set_one_item(**type, arg, value, item, 0);
+    }
+    for (i = 0; value; i++, value = next) {
+	if (i == *size) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"%s: can only take %d arguments\n", arg, *size);
+	    return -1;
+	}
+	next = strchr(value, ',');
+	if (next) {
+	    *next++ = 0;
+	}
+	if (set_one_item(**type, arg, value, item, i)) {
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+static int set_args(void *dll, const char *args)
+{
+    char *copy, *arg, *save;
+    int result = 0;
+
+    if (!args) {
+	return 0;
+    }
+    copy = strdup(args);
+    if (!copy) {
+	return -1;
+    }
+    for (arg = strtok_r(copy, " \t", &save); arg && !result;
+	arg = strtok_r(NULL, " \t", &save)) {
+	result = set_arg(dll, arg);
+    }
+    free(copy);
+    return result;
+}
+
+static kinsuser_t *load(const char *module, const char *args, int kins)
+{
+    char path[PATH_MAX];
+    const char *name;
+    kinsuser_t *k;
+    int (*start)(void);
+    int result;
+
+    if (make_global()) {
+	return NULL;
+    }
+    name = strrchr(module, '/');
+    name = name ? name + 1 : module;
+    for (k = loaded; k; k = k->next) {
+	if (strcmp(k->name, name) == 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR, "%s: already loaded\n", name);
+	    return NULL;
+	}
+    }
+    if (strchr(module, '/')) {
+	snprintf(path, sizeof(path), "%s", module);
+    } else {
+	snprintf(path, sizeof(path), "%s/%s.so", EMC2_RTLIB_DIR, module);
+    }
+
+    k = calloc(1, sizeof(*k));
+    if (!k) {
+	return NULL;
+    }
+    snprintf(k->name, sizeof(k->name), "%s", name);
+    k->comp_id = -1;
+    /* local, so that modules loaded side by side keep their own
+       kinematicsForward(); other modules are global, like rtapi_app
+       loads them, so that the ones loaded after them can call them */
+    k->dll = dlopen(path, RTLD_NOW | (kins ? RTLD_LOCAL : RTLD_GLOBAL));
+    if (!k->dll) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "%s: dlopen: %s\n", name, dlerror());
+	free(k);
+	return NULL;
+    }
+    k->forward = (fwd_fn) dlsym(k->dll, "kinematicsForward");
+    k->inverse = (inv_fn) dlsym(k->dll, "kinematicsInverse");
+    k->type = (KINEMATICS_TYPE (*)(void)) dlsym(k->dll, "kinematicsType");
+    k->forward_batch = (fwd_batch_fn) dlsym(k->dll, "kinematicsForwardBatch");
+    k->inverse_batch = (inv_batch_fn) dlsym(k->dll, "kinematicsInverseBatch");
+    k->sw = (int (*)(int)) dlsym(k->dll, "kinematicsSwitch");
+    k->app_exit = (void (*)(void)) dlsym(k->dll, "rtapi_app_exit");
+    start = (int (*)(void)) dlsym(k->dll, "rtapi_app_main");
+    if (!start) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "%s: not a realtime module\n", name);
+	goto fail;
+    }
+    if (kins && (!k->forward || !k->inverse || !k->type)) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "%s: not a kinematics module\n", name);
+	goto fail;
+    }
+    if (set_args(k->dll, args)) {
+	goto fail;
+    }
+
+    loading = k;
+    result = start();
+    loading = NULL;
+    if (result < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "%s: rtapi_app_main: %s (%d)\n",
+	    name, strerror(-result), result);
+	if (k->comp_id > 0) {
+	    hal_exit(k->comp_id);
+	}
+	goto fail;
+    }
+    k->next = loaded;
+    loaded = k;
+    return k;
+
+fail:
+    dlclose(k->dll);
+    free(k);
+    return NULL;
+}
+
+kinsuser_t *kinsuser_load(const char *module, const char *args)
+{
+    return load(module, args, 1);
+}
+
+kinsuser_t *kinsuser_load_module(const char *module, const char *args)
+{
+    return load(module, args, 0);
+}
+
+void kinsuser_unload(kinsuser_t *k)
+{
+    kinsuser_t **kp;
+
+    if (!k) {
+	return;
+    }
+    for (kp = &loaded; *kp; kp = &(*kp)->next) {
+	if (*kp == k) {
+	    *kp = k->next;
+	    break;
+	}
+    }
+    if (k->app_exit) {
+	k->app_exit();
+    }
+    /* whatever it did not free itself */
+    hal_exit(k->comp_id);
+    dlclose(k->dll);
+    free(k);
+}
+
+KINEMATICS_TYPE kinsuser_type(kinsuser_t *k)
+{
+    return k->type();
+}
+
+int kinsuser_switch(kinsuser_t *k, int switchkins_type)
+{
+    return k->sw ? k->sw(switchkins_type) : -1;
+}
+
+/***********************************************************************
+*                         Kinematics                                   *
+************************************************************************/
+
+int kinsuser_forward(kinsuser_t *k, const double *joint, EmcPose * world,
+    const KINEMATICS_FORWARD_FLAGS * fflags,
+    KINEMATICS_INVERSE_FLAGS * iflags)
+{
+    return k->forward(joint, world, fflags, iflags);
+}
+
+int kinsuser_inverse(kinsuser_t *k, const EmcPose * world, double *joint,
+    const KINEMATICS_INVERSE_FLAGS * iflags,
+    KINEMATICS_FORWARD_FLAGS * fflags)
+{
+    return k->inverse(world, joint, iflags, fflags);
+}
+
+int kinsuser_forward_batch(kinsuser_t *k, int n, const double *joint,
+    int stride, EmcPose * world, const KINEMATICS_FORWARD_FLAGS * fflags,
+    KINEMATICS_INVERSE_FLAGS * iflags, int *status)
+{
+    int i, r, failed = 0;
+
+    if (k->forward_batch) {
+	return k->forward_batch(n, joint, stride, world, fflags, iflags,
+	    status);
+    }
+    for (i = 0; i < n; i++) {
+	r = k->forward(joint + (long) i * stride, &world[i], fflags, iflags);
+	if (status) {
+	    status[i] = r;
+	}
+	failed += r != 0;
+    }
+    return failed;
+}
+
+int kinsuser_inverse_batch(kinsuser_t *k, int n, const EmcPose * world,
+    double *joint, int stride, const KINEMATICS_INVERSE_FLAGS * iflags,
+    KINEMATICS_FORWARD_FLAGS * fflags, int *status)
+{
+    int i, r, failed = 0;
+
+    if (k->inverse_batch) {
+	return k->inverse_batch(n, world, joint, stride, iflags, fflags,
+	    status);
+    }
+    for (i = 0; i < n; i++) {
+	r = k->inverse(&world[i], joint + (long) i * stride, iflags, fflags);
+	if (status) {
+	    status[i] = r;
+	}
+	failed += r != 0;
+    }
+    return failed;
+}
+
+int kinsuser_batch(kinsuser_t *k)
+{
+    return k->forward_batch && k->inverse_batch;
+}
+
+/***********************************************************************
+*                      Pins and parameters                             *
+************************************************************************/
+
+static kins_pin_t *module_pin(kinsuser_t *k, const char *name)
+{
+    kins_pin_t *p = find_pin(name);
+
+    if (!p || p->comp_id != k->comp_id) {
+	rtapi_print_msg(RTAPI_MSG_ERR, "%s: no pin or parameter '%s'\n",
+	    k->name, name);
+	return NULL;
+    }
+    return p;
+}
+
+const char *kinsuser_pin_name(kinsuser_t *k, int n)
+{
+    kins_pin_t *p;
+
+    for (p = pins; p; p = p->next) {
+	if (p->comp_id == k->comp_id && n-- == 0) {
+	    return p->name;
+	}
+    }
+    return NULL;
+}
+
+void *kinsuser_pin_ptr(kinsuser_t *k, const char *name)
+{
+    kins_pin_t *p = module_pin(k, name);
+
+    return p ? p->data : NULL;
+}
+
+int kinsuser_set(kinsuser_t *k, const char *name, double value)
+{
+    kins_pin_t *p = module_pin(k, name);
+
+    if (!p) {
+	return -EINVAL;
+    }
+    switch (p->type) {
+    case HAL_BIT:
+	*(hal_bit_t *) p->data = value != 0;
+	break;
+    case HAL_S32:
+	*(hal_s32_t *) p->data = (rtapi_s32) value;
+	break;
+    case HAL_U32:
+	*(hal_u32_t *) p->data = (rtapi_u32) value;
+	break;
+    default:
+	*(hal_float_t *) p->data = value;
+	break;
+    }
+    return 0;
+}
+
+int kinsuser_get(kinsuser_t *k, const char *name, double *value)
+{
+    kins_pin_t *p = module_pin(k, name);
+
+    if (!p) {
+	return -EINVAL;
+    }
+    switch (p->type) {
+    case HAL_BIT:
+	*value = *(hal_bit_t *) p->data;
+	break;
+    case HAL_S32:
+	*value = *(hal_s32_t *) p->data;
+	break;
+    case HAL_U32:
+	*value = *(hal_u32_t *) p->data;
+	break;
+    default:
+	*value = *(hal_float_t *) p->data;
+	break;
+    }
+    return 0;
+}
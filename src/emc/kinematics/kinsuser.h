@@ -0,0 +1,90 @@
+/********************************************************************
+* Description: kinsuser.h
+*
+*   Kinematics modules in userspace programs
+*
+*   Loads a kinematics module built for the uspace realtime system
+*   (rtlib/<name>.so) into an ordinary program and calls it through
+*   the functions of kinematics.h, one pose or many at a time.  The
+*   HAL pins and parameters the module creates live in the program,
+*   not in HAL shared memory, so this works whether or not LinuxCNC
+*   is running; copy the geometry pins over with kinsuser_set().
+*
+* License: GPL Version 2
+* System: Linux
+*
+********************************************************************/
+
+#ifndef KINSUSER_H
+#define KINSUSER_H
+
+#include "kinematics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct kinsuser kinsuser_t;
+
+/* Loads module (a name in the rtlib directory, or a path to a .so) with
+   the module parameters in args, e.g. "coordinates=xyzac".  Returns NULL
+   after printing an error. */
+extern kinsuser_t *kinsuser_load(const char *module, const char *args);
+extern void kinsuser_unload(kinsuser_t *k);
+
+/* Loads any other module the same way, into the global scope so that
+   the modules loaded after it can use its functions, as they do under
+   rtapi_app.  Load a kinematics module that others need, for motmod,
+   with this too.  Only kinsuser_unload() and the pin functions below
+   may be used on what it returns.  Functions the module needs that
+   are not among those this library provides (threads, shared memory,
+   time) must be provided by the program. */
+extern kinsuser_t *kinsuser_load_module(const char *module, const char *args);
+
+extern KINEMATICS_TYPE kinsuser_type(kinsuser_t *k);
+extern int kinsuser_switch(kinsuser_t *k, int switchkins_type);
+
+extern int kinsuser_forward(kinsuser_t *k,
+                            const double *joint,
+                            EmcPose * world,
+                            const KINEMATICS_FORWARD_FLAGS * fflags,
+                            KINEMATICS_INVERSE_FLAGS * iflags);
+
+extern int kinsuser_inverse(kinsuser_t *k,
+                            const EmcPose * world,
+                            double *joint,
+                            const KINEMATICS_INVERSE_FLAGS * iflags,
+                            KINEMATICS_FORWARD_FLAGS * fflags);
+
+/* like kinematicsForwardBatch()/kinematicsInverseBatch(), for every
+   module; kinsuser_batch() is 1 when the module has its own */
+extern int kinsuser_forward_batch(kinsuser_t *k, int n,
+                                  const double *joint, int stride,
+                                  EmcPose * world,
+                                  const KINEMATICS_FORWARD_FLAGS * fflags,
+                                  KINEMATICS_INVERSE_FLAGS * iflags,
+                                  int *status);
+
+extern int kinsuser_inverse_batch(kinsuser_t *k, int n,
+                                  const EmcPose * world,
+                                  double *joint, int stride,
+                                  const KINEMATICS_INVERSE_FLAGS * iflags,
+                                  KINEMATICS_FORWARD_FLAGS * fflags,
+                                  int *status);
+
+extern int kinsuser_batch(kinsuser_t *k);
+
+/* The pins and parameters of the module, by their HAL names.  Bit, s32
+   and u32 values are converted from and to double. */
+extern const char *kinsuser_pin_name(kinsuser_t *k, int n);
+extern int kinsuser_set(kinsuser_t *k, const char *name, double value);
+extern int kinsuser_get(kinsuser_t *k, const char *name, double *value);
+/* where the value of a pin or parameter is kept, NULL if there is no
+   such pin; for a program that reads or drives pins every cycle */
+extern void *kinsuser_pin_ptr(kinsuser_t *k, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KINSUSER_H */
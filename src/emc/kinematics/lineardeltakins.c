@@ -47,6 +47,36 @@ int kinematicsInverse(const EmcPose *pos, double *joints,
     return kinematics_inverse(pos, joints);
 }
 
+int kinematicsForwardBatch(int n, const double *joints, int stride,
+        EmcPose *pos, const KINEMATICS_FORWARD_FLAGS *fflags,
+        KINEMATICS_INVERSE_FLAGS *iflags, int *status) {
+    int i, r, failed = 0;
+    (void)fflags;
+    (void)iflags;
+    set_geometry(*haldata->r, *haldata->l);
+    for(i = 0; i < n; i++) {
+        r = kinematics_forward(joints + (long)i * stride, &pos[i]);
+        if(status) status[i] = r;
+        failed += r != 0;
+    }
+    return failed;
+}
+
+int kinematicsInverseBatch(int n, const EmcPose *pos, double *joints,
+        int stride, const KINEMATICS_INVERSE_FLAGS *iflags,
+        KINEMATICS_FORWARD_FLAGS *fflags, int *status) {
+    int i, r, failed = 0;
+    (void)iflags;
+    (void)fflags;
+    set_geometry(*haldata->r, *haldata->l);
+    for(i = 0; i < n; i++) {
+        r = kinematics_inverse(&pos[i], joints + (long)i * stride);
+        if(status) status[i] = r;
+        failed += r != 0;
+    }
+    return failed;
+}
+
 KINEMATICS_TYPE kinematicsType()
 {
     return KINEMATICS_BOTH;
@@ -95,4 +125,6 @@ KINS_NOT_SWITCHABLE
 EXPORT_SYMBOL(kinematicsType);
 EXPORT_SYMBOL(kinematicsForward);
 EXPORT_SYMBOL(kinematicsInverse);
+EXPORT_SYMBOL(kinematicsForwardBatch);
+EXPORT_SYMBOL(kinematicsInverseBatch);
 MODULE_LICENSE("GPL");
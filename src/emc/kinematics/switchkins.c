@@ -31,6 +31,8 @@
 #include "rtapi_app.h"
 #include "kinematics.h"
 #include "switchkins.h"
+#include "kins_table.h"
+#include "rtapi_firmware.h"
 
 //*********************************************************************
 // kinematic functions (default=0 for err detection):
@@ -56,6 +58,13 @@ static struct swdata {
     hal_float_t *gui_a;
     hal_float_t *gui_b;
     hal_float_t *gui_c;
+
+    struct {
+        hal_bit_t   *enable;
+        hal_u32_t   *hits;
+        hal_u32_t   *exact;
+        hal_float_t *max_error;
+    } table[SWITCHKINS_MAX_TYPES][2];
 } *swdata;
 
 // Note: parallel kinematics (like genhexkins) often
@@ -93,16 +102,19 @@ static void get_lastpose(int ktype, EmcPose* pos)
     pos->w      = lastpose[ktype].w;
 } // get_lastpose()
 
-static int gui_forward_kins(const double *joints)
+static int gui_forward_kins(const double *joints, EmcPose *pos)
 {
     // the hexapod vismach gui uses these hal pins to
     // display platform position/orientation in both
     // genhexkins and identity kinematic types
     // (similar needs for many parallel kinemtic machines)
-    int res;
+    int res = 0;
     KINEMATICS_FORWARD_FLAGS  fflags = 0;
     KINEMATICS_INVERSE_FLAGS  iflags;
-    switch (kp.gui_kinstype) {
+    if (kp.gui_kinstype == (int)switchkins_type) {
+        // pos is what the gui type computes, don't iterate twice
+        save_lastpose(kp.gui_kinstype, pos);
+    } else switch (kp.gui_kinstype) {
         case 0: res = kfwd0(joints, &lastpose[0], &fflags, &iflags);break;
         case 1: res = kfwd1(joints, &lastpose[1], &fflags, &iflags);break;
         case 2: res = kfwd2(joints, &lastpose[2], &fflags, &iflags);break;
@@ -120,6 +132,44 @@ static int gui_forward_kins(const double *joints)
     return res;
 } // gui_forward_kins
 
+//*********************************************************************
+// precomputed tables (see kins_table.h), for each type and direction
+static kins_table_t tables[SWITCHKINS_MAX_TYPES][2];
+static const struct rtapi_firmware *table_fw[SWITCHKINS_MAX_TYPES * 2];
+
+static void pose_to_array(const EmcPose *pos, double *v)
+{
+    v[0] = pos->tran.x; v[1] = pos->tran.y; v[2] = pos->tran.z;
+    v[3] = pos->a;      v[4] = pos->b;      v[5] = pos->c;
+    v[6] = pos->u;      v[7] = pos->v;      v[8] = pos->w;
+} // pose_to_array()
+
+static void array_to_pose(const double *v, EmcPose *pos)
+{
+    pos->tran.x = v[0]; pos->tran.y = v[1]; pos->tran.z = v[2];
+    pos->a      = v[3]; pos->b      = v[4]; pos->c      = v[5];
+    pos->u      = v[6]; pos->v      = v[7]; pos->w      = v[8];
+} // array_to_pose()
+
+// returns 0 if the table of the current type answered; the hits and
+// exact pins count only the calls with 'count' set
+static int table_kins(int dir, const double *in, double *out,
+                      unsigned long flags, int count)
+{
+    kins_table_t *t = &tables[switchkins_type][dir];
+
+    if (!t->hdr || !*swdata->table[switchkins_type][dir].enable
+        || flags != t->hdr->flags) {
+        return -1;
+    }
+    if (kins_table_lookup(t, in, out)) {
+        if (count) (*swdata->table[switchkins_type][dir].exact)++;
+        return -1;
+    }
+    if (count) (*swdata->table[switchkins_type][dir].hits)++;
+    return 0;
+} // table_kins()
+
 //*********************************************************************
 int kinematicsSwitchable() {return 1;}
 
@@ -168,6 +218,7 @@ int kinematicsForward(const double *joint,
                       KINEMATICS_INVERSE_FLAGS * iflags)
 {
     int r;
+    double world[9];
 
     if (fwd_iterates[switchkins_type] && use_lastpose[switchkins_type]) {
         // initialize iterative forward kins (ok for identity too)
@@ -175,7 +226,10 @@ int kinematicsForward(const double *joint,
         use_lastpose[switchkins_type] = 0;
     }
 
-    switch (switchkins_type) {
+    if (!table_kins(KINS_TABLE_FORWARD, joint, world, fflags ? *fflags : 0, 1)) {
+        array_to_pose(world, pos);
+        r = 0;
+    } else switch (switchkins_type) {
        case 0: r = kfwd0(joint, pos, fflags, iflags); break;
        case 1: r = kfwd1(joint, pos, fflags, iflags); break;
        case 2: r = kfwd2(joint, pos, fflags, iflags); break;
@@ -196,7 +250,7 @@ int kinematicsForward(const double *joint,
         // currently the skgui pins are only needed for
         // the hexagui vismach program (as it needs
         // world coords for switchkin-types
-        r = gui_forward_kins(joint);
+        r = gui_forward_kins(joint, pos);
     }
 
     return r;
@@ -208,7 +262,15 @@ int kinematicsInverse(const EmcPose * pos,
                       KINEMATICS_FORWARD_FLAGS * fflags)
 {
     int r;
-
+    double world[9];
+    KINEMATICS_INVERSE_FLAGS flags = iflags ? *iflags : 0;
+
+    pose_to_array(pos, world);
+    if (!table_kins(KINS_TABLE_INVERSE, world, joint,
+                    flags & ~KINEMATICS_INVERSE_QUERY,
+                    !(flags & KINEMATICS_INVERSE_QUERY))) {
+        return 0;
+    }
     switch (switchkins_type) {
        case 0: r = kinv0(pos, joint, iflags, fflags); break;
        case 1: r = kinv1(pos, joint, iflags, fflags); break;
@@ -231,6 +293,9 @@ static char *coordinates;
 RTAPI_MP_STRING(coordinates, "Axes-to-joints-ordering");
 static char *sparm;
 RTAPI_MP_STRING(sparm,  "switchkins module-specific parameter");
+static char *kinstable[SWITCHKINS_MAX_TYPES * 2];
+RTAPI_MP_ARRAY_STRING(kinstable, SWITCHKINS_MAX_TYPES * 2,
+                      "tables made by kins-table");
 
 EXPORT_SYMBOL(kinematicsSwitchable);
 EXPORT_SYMBOL(kinematicsSwitch);
@@ -240,6 +305,85 @@ EXPORT_SYMBOL(kinematicsInverse);
 MODULE_LICENSE("GPL");
 
 static int    comp_id;
+
+#ifdef __KERNEL__
+static int load_tables(void)
+{
+    int i;
+
+    for (i = 0; i < SWITCHKINS_MAX_TYPES * 2; i++) {
+        if (kinstable[i] && *kinstable[i]) {
+            rtapi_print_msg(RTAPI_MSG_ERR,
+                "switchkins: kinstable needs the uspace realtime system\n");
+            return -1;
+        }
+    }
+    return 0;
+} // load_tables()
+
+static void release_tables(void) {}
+#else
+static int load_tables(void)
+{
+    int i, type, dir, res = 0;
+    const char *err;
+    kins_table_t t;
+
+    for (i = 0; i < SWITCHKINS_MAX_TYPES * 2; i++) {
+        if (!kinstable[i] || !*kinstable[i]) continue;
+        if (rtapi_request_firmware(&table_fw[i], kinstable[i], NULL)) {
+            return -1;
+        }
+        err = kins_table_open(&t, table_fw[i]->data, table_fw[i]->size);
+        if (!err && t.hdr->kinstype >= SWITCHKINS_MAX_TYPES) {
+            err = "bad switchkins type";
+        }
+        if (!err && (t.hdr->direction == KINS_TABLE_INVERSE
+                     ? t.hdr->nin : t.hdr->nout) != 9) {
+            err = "needs the 9 world coordinates";
+        }
+        if (!err && tables[t.hdr->kinstype][t.hdr->direction].hdr) {
+            err = "second table for the same type and direction";
+        }
+        if (err) {
+            rtapi_print_msg(RTAPI_MSG_ERR,
+                "switchkins: %s: %s\n", kinstable[i], err);
+            return -1;
+        }
+        type = t.hdr->kinstype;
+        dir  = t.hdr->direction;
+        tables[type][dir] = t;
+
+        res += hal_pin_bit_newf(HAL_IN, &swdata->table[type][dir].enable,
+                   comp_id, "%s.table.%d.%s.enable", kp.halprefix, type,
+                   dir == KINS_TABLE_INVERSE ? "inverse" : "forward");
+        res += hal_pin_u32_newf(HAL_OUT, &swdata->table[type][dir].hits,
+                   comp_id, "%s.table.%d.%s.hits", kp.halprefix, type,
+                   dir == KINS_TABLE_INVERSE ? "inverse" : "forward");
+        res += hal_pin_u32_newf(HAL_OUT, &swdata->table[type][dir].exact,
+                   comp_id, "%s.table.%d.%s.exact", kp.halprefix, type,
+                   dir == KINS_TABLE_INVERSE ? "inverse" : "forward");
+        res += hal_pin_float_newf(HAL_OUT, &swdata->table[type][dir].max_error,
+                   comp_id, "%s.table.%d.%s.max-error", kp.halprefix, type,
+                   dir == KINS_TABLE_INVERSE ? "inverse" : "forward");
+        if (res) return res;
+        *swdata->table[type][dir].enable = 1;
+        *swdata->table[type][dir].max_error = t.hdr->max_error;
+        rtapi_print("switchkins: %s: type %d %s table\n", kinstable[i],
+                    type, dir == KINS_TABLE_INVERSE ? "inverse" : "forward");
+    }
+    return 0;
+} // load_tables()
+
+static void release_tables(void)
+{
+    int i;
+    for (i = 0; i < SWITCHKINS_MAX_TYPES * 2; i++) {
+        if (table_fw[i]) rtapi_release_firmware(table_fw[i]);
+    }
+} // release_tables()
+#endif
+
 //*********************************************************************
 int rtapi_app_main(void)
 {
@@ -318,6 +462,8 @@ int rtapi_app_main(void)
         if (res) {emsg = "hal pin create fail";goto error;}
     }
 
+    if (load_tables()) {emsg = "kinstable"; goto error;}
+
     switchkins_type = 0; // startup with default type
     kinematicsSwitch(switchkins_type);
 
@@ -333,8 +479,9 @@ int rtapi_app_main(void)
 error:
     rtapi_print_msg(RTAPI_MSG_ERR,
         "\nSwitchkins FAIL %s:<%s>\n",kp.kinsname,emsg);
+    release_tables();
     hal_exit(comp_id);
     return -1;
 } // rtapi_app_main()
 
-void rtapi_app_exit(void) { hal_exit(comp_id); }
+void rtapi_app_exit(void) { release_tables(); hal_exit(comp_id); }
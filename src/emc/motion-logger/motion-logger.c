@@ -36,6 +36,7 @@
 #include "motion_types.h"
 #include "mot_priv.h"
 #include "axis.h"
+#include "motion_capture.h"
 
 static struct motion_logger_data_t {
     hal_bit_t *reopen;
@@ -44,7 +45,12 @@ static struct motion_logger_data_t {
 FILE *logfile = NULL;
 char *logfile_name = NULL;
 
+static FILE *capture = NULL;
+static struct timespec capture_start;
+
 emcmot_struct_t *emcmotStruct = 0;
+/* staging area for EMCMOT_LOAD_JOINT_COMP, the tables are not kept */
+emcmot_comp_tables_t *emcmotCompTables = 0;
 
 struct emcmot_command_t *c = 0;
 struct emcmot_status_t *emcmotStatus = 0;
@@ -68,6 +74,7 @@ void emcmot_config_change(void) {
 }
 
 static int shmem_id;
+static int comp_shmem_id;
 
 static volatile int quit;
 
@@ -78,7 +85,7 @@ static void sighandler(int sig)
 }
 
 static int init_comm_buffers(void) {
-    int joint_num, axis_num, n;
+    int joint_num, axis_num;
     emcmot_joint_t *joint;
     int retval;
 
@@ -105,6 +112,24 @@ static int init_comm_buffers(void) {
 	return -1;
     }
 
+    /* usrmotLoadComp() stages comp tables here, take as many as motmod
+       does by default */
+    comp_shmem_id = rtapi_shmem_new(COMP_SHMEM_KEY(DEFAULT_SHMEM_KEY), mot_comp_id,
+	EMCMOT_COMP_TABLES_SIZE(EMCMOT_COMP_SIZE, num_joints));
+    if (comp_shmem_id < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: rtapi_shmem_new failed, returned %d\n", comp_shmem_id);
+	return -1;
+    }
+    retval = rtapi_shmem_getptr(comp_shmem_id, (void **) &emcmotCompTables);
+    if (retval < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: rtapi_shmem_getptr failed, returned %d\n", retval);
+	return -1;
+    }
+    emcmotCompTables->entries_max = EMCMOT_COMP_SIZE;
+    emcmotCompTables->num_joints = num_joints;
+
     /* we'll reference emcmotStruct directly */
     c = &emcmotStruct->command;
     emcmotStatus = &emcmotStruct->status;
@@ -114,6 +139,7 @@ static int init_comm_buffers(void) {
 
     emcmotConfig->numJoints = num_joints;
     emcmotConfig->numSpindles = num_spindles;
+    emcmotConfig->compEntries = EMCMOT_COMP_SIZE;
 
     emcmotStatus->vel = DEFAULT_VELOCITY;
     emcmotConfig->limitVel = DEFAULT_VELOCITY;
@@ -145,23 +171,6 @@ static int init_comm_buffers(void) {
 	joint->min_ferror = 0.01;
 	joint->max_ferror = 1.0;
 
-	joint->comp.entry = &(joint->comp.array[0]);
-	/* the compensation code has -DBL_MAX at one end of the table
-	   and +DBL_MAX at the other so _all_ commanded positions are
-	   guaranteed to be covered by the table */
-	joint->comp.array[0].nominal = -DBL_MAX;
-	joint->comp.array[0].fwd_trim = 0.0;
-	joint->comp.array[0].rev_trim = 0.0;
-	joint->comp.array[0].fwd_slope = 0.0;
-	joint->comp.array[0].rev_slope = 0.0;
-	for ( n = 1 ; n < EMCMOT_COMP_SIZE+2 ; n++ ) {
-	    joint->comp.array[n].nominal = DBL_MAX;
-	    joint->comp.array[n].fwd_trim = 0.0;
-	    joint->comp.array[n].rev_trim = 0.0;
-	    joint->comp.array[n].fwd_slope = 0.0;
-	    joint->comp.array[n].rev_slope = 0.0;
-	}
-
 	/* init status info */
 	joint->ferror_limit = joint->min_ferror;
 
@@ -266,17 +275,73 @@ void log_print(const char *fmt, ...) {
     fflush(logfile);
 }
 
+static void open_capture(const char *name) {
+    motion_capture_hdr_t h;
+
+    capture = fopen(name, "wb");
+    if (capture == NULL) {
+        fprintf(stderr, "error opening %s: %s\n", name, strerror(errno));
+        exit(1);
+    }
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MOTION_CAPTURE_MAGIC, sizeof(h.magic));
+    h.version = MOTION_CAPTURE_VERSION;
+    h.command_size = sizeof(emcmot_command_t);
+    if (fwrite(&h, sizeof(h), 1, capture) != 1) {
+        fprintf(stderr, "error writing %s: %s\n", name, strerror(errno));
+        exit(1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &capture_start);
+}
+
+// the command as it arrived, for motion-replay
+static void capture_command(void) {
+    motion_capture_rec_t rec;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    memset(&rec, 0, sizeof(rec));
+    rec.time = (now.tv_sec - capture_start.tv_sec) * 1000000000LL
+        + now.tv_nsec - capture_start.tv_nsec;
+    if (c->command == EMCMOT_LOAD_JOINT_COMP
+        && c->comp_count > 0 && c->comp_count <= emcmotCompTables->entries_max) {
+        rec.extra = c->comp_count * sizeof(emcmot_comp_entry_t);
+    }
+    if (fwrite(&rec, sizeof(rec), 1, capture) != 1
+        || fwrite(c, sizeof(*c), 1, capture) != 1
+        || (rec.extra
+            && fwrite(emcmotCompTables->entry, rec.extra, 1, capture) != 1)
+        || fflush(capture) != 0) {
+        fprintf(stderr, "motion-logger: error writing capture: %s\n", strerror(errno));
+        exit(1);
+    }
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: motion-logger [-b CAPTURE] [LOGFILE]\n");
+    exit(1);
+}
 
 int main(int argc, char* argv[]) {
-    if (argc == 1) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:")) != -1) {
+        switch (opt) {
+            case 'b':
+                open_capture(optarg);
+                break;
+            default:
+                usage();
+        }
+    }
+    if (optind == argc) {
         logfile = stdout;
         logfile_name = NULL;
-    } else if (argc == 2) {
+    } else if (optind == argc - 1) {
         logfile = NULL;
-        logfile_name = argv[1];
+        logfile_name = argv[optind];
     } else {
-        fprintf(stderr, "usage: motion-logger [LOGFILE]\n");
-        exit(1);
+        usage();
     }
 
     signal(SIGINT,  sighandler); // ^C interrupt
@@ -328,6 +393,10 @@ int main(int argc, char* argv[]) {
 
         emcmotStatus->head++;
 
+        if (capture) {
+            capture_command();
+        }
+
         switch (c->command) {
             case EMCMOT_ABORT:
                 log_print("ABORT\n");
@@ -682,6 +751,14 @@ int main(int argc, char* argv[]) {
                 log_print("SET_JOINT_COMP\n");
                 break;
 
+            case EMCMOT_LOAD_JOINT_COMP:
+                log_print("LOAD_JOINT_COMP joint=%d, entries=%d\n", c->joint, c->comp_count);
+                break;
+
+            case EMCMOT_SET_VOLCOMP:
+                log_print("SET_VOLCOMP mode=%d\n", c->mode);
+                break;
+
             case EMCMOT_SET_OFFSET:
                 log_print(
                     "SET_OFFSET x=%.6g, y=%.6g, z=%.6g, a=%.6g, b=%.6g, c=%.6g u=%.6g, v=%.6g, w=%.6g\n",
@@ -705,6 +782,10 @@ int main(int argc, char* argv[]) {
                           c->probe_home_err_inhibit);
                 break;
 
+            case EMCMOT_SET_JOINT_LIMIT_SAMPLES:
+                log_print("SET_JOINT_LIMIT_SAMPLES %d\n", c->jointLimitSamples);
+                break;
+
 
             default:
                 log_print("ERROR: unknown command %d\n", c->command);
@@ -721,6 +802,13 @@ int main(int argc, char* argv[]) {
         rtapi_mutex_give(&emcmotStruct->command_mutex);
     }
 
+    if (capture) {
+        fclose(capture);
+    }
+    if((r = rtapi_shmem_delete(comp_shmem_id, mot_comp_id)) < 0) {
+        errno = -r;
+        perror("rtapi_shmem_delete");
+    }
     if((r = rtapi_shmem_delete(shmem_id, mot_comp_id)) < 0) {
         errno = -r;
         perror("rtapi_shmem_delete");
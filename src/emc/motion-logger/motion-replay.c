@@ -0,0 +1,824 @@
+//
+// motion-replay: runs a capture of motion-logger -b through the motion
+//     controller and trajectory planner, headless and faster than real
+//     time, for benchmarking changes to them on real jobs
+//
+// The real motmod, homemod, tpmod and kinematics modules of a uspace
+// build are loaded with kinsuser (see kinsuser(3)), which keeps their
+// pins in this program.  This program provides the rest of what motmod
+// asks of RTAPI and HAL: shared memory is plain memory, the servo
+// thread is never started and its functions are called from the loop
+// below instead, and the time is simulated, one servo period per
+// cycle.  Only the functions in motion-replay.syms are exported to the
+// modules.
+//
+// Each cycle, the next command of the capture is written to the
+// command struct when Task would have sent it, the command handler
+// and the controller run, and the motor and spindle feedback pins are
+// set to what was commanded, like in a sim config.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rtapi.h"
+#include "hal.h"
+#include "motion.h"
+#include "motion_struct.h"
+#include "dbuf.h"
+#include "stashf.h"
+#include "kinsuser.h"
+#include "motion_capture.h"
+#ifdef HAL_TRACING
+#include "hal_trace.h"
+#endif
+
+#define MAX_SHMEM 4
+#define MAX_FUNCTS 8
+
+/***********************************************************************
+*              RTAPI and HAL for motmod, see motion-replay.syms        *
+************************************************************************/
+
+static long long sim_ns;        /* simulated time */
+
+static struct {
+    int key;
+    void *mem;
+} shmem[MAX_SHMEM];
+
+static struct {
+    char name[HAL_NAME_LEN + 1];
+    void (*funct)(void *, long);
+    void *arg;
+} functs[MAX_FUNCTS];
+static int nfuncts;
+
+static char thread_name[HAL_NAME_LEN + 1];
+static long thread_period;
+
+static rtapi_msg_handler_t msg_handler;
+
+extern void rtapi_set_msg_handler(rtapi_msg_handler_t handler);
+extern rtapi_msg_handler_t rtapi_get_msg_handler(void);
+
+int rtapi_shmem_new(int key, int module_id, unsigned long int size)
+{
+    int n;
+
+    (void) module_id;
+    for (n = 0; n < MAX_SHMEM; n++) {
+        if (shmem[n].mem && shmem[n].key == key) {
+            return n + 1;
+        }
+    }
+    for (n = 0; n < MAX_SHMEM; n++) {
+        if (!shmem[n].mem) {
+            shmem[n].mem = calloc(1, size);
+            if (!shmem[n].mem) {
+                return -ENOMEM;
+            }
+            shmem[n].key = key;
+            return n + 1;
+        }
+    }
+    return -ENOMEM;
+}
+
+int rtapi_shmem_getptr(int shmem_id, void **ptr)
+{
+    if (shmem_id < 1 || shmem_id > MAX_SHMEM || !shmem[shmem_id - 1].mem) {
+        return -EINVAL;
+    }
+    *ptr = shmem[shmem_id - 1].mem;
+    return 0;
+}
+
+int rtapi_shmem_delete(int shmem_id, int module_id)
+{
+    (void) module_id;
+    if (shmem_id < 1 || shmem_id > MAX_SHMEM || !shmem[shmem_id - 1].mem) {
+        return -EINVAL;
+    }
+    free(shmem[shmem_id - 1].mem);
+    shmem[shmem_id - 1].mem = NULL;
+    return 0;
+}
+
+long long int rtapi_get_time(void)
+{
+    return sim_ns;
+}
+
+long long int rtapi_get_clocks(void)
+{
+    return sim_ns;
+}
+
+void rtapi_set_msg_handler(rtapi_msg_handler_t handler)
+{
+    msg_handler = handler;
+}
+
+rtapi_msg_handler_t rtapi_get_msg_handler(void)
+{
+    return msg_handler;
+}
+
+int hal_create_thread_cpus(const char *name, unsigned long period_nsec,
+    int uses_fp, const char *cpus)
+{
+    (void) uses_fp;
+    (void) cpus;
+    /* motmod only makes a base thread when asked to, and nothing runs
+       in it here; the servo thread is the one that matters */
+    if (strcmp(name, "servo-thread") == 0 || !thread_name[0]) {
+        snprintf(thread_name, sizeof(thread_name), "%s", name);
+        thread_period = period_nsec;
+    }
+    return 0;
+}
+
+int hal_create_thread(const char *name, unsigned long period_nsec,
+    int uses_fp)
+{
+    return hal_create_thread_cpus(name, period_nsec, uses_fp, NULL);
+}
+
+int hal_thread_parallel(const char *name, int workers, const char *cpus)
+{
+    (void) name;
+    (void) workers;
+    (void) cpus;
+    return 0;
+}
+
+int hal_start_threads(void)
+{
+    return 0;
+}
+
+int hal_stop_threads(void)
+{
+    return 0;
+}
+
+int hal_export_funct(const char *name, void (*funct) (void *, long),
+    void *arg, int uses_fp, int reentrant, int comp_id)
+{
+    (void) uses_fp;
+    (void) reentrant;
+    (void) comp_id;
+    if (nfuncts == MAX_FUNCTS) {
+        return -ENOMEM;
+    }
+    snprintf(functs[nfuncts].name, sizeof(functs[nfuncts].name), "%s", name);
+    functs[nfuncts].funct = funct;
+    functs[nfuncts].arg = arg;
+    nfuncts++;
+    return 0;
+}
+
+#ifdef HAL_TRACING
+int hal_trace_register(const char *name)
+{
+    (void) name;
+    return 0;
+}
+
+void hal_trace(int event, int phase, long arg)
+{
+    (void) event;
+    (void) phase;
+    (void) arg;
+}
+#endif
+
+/***********************************************************************
+*                           The capture                                *
+************************************************************************/
+
+typedef struct {
+    long long time;             /* since the first command */
+    const emcmot_command_t *cmd;
+    const void *extra;
+    unsigned extra_size;
+} capture_cmd_t;
+
+static capture_cmd_t *cmds;
+static int ncmds;
+
+static int read_capture(const char *name)
+{
+    const motion_capture_hdr_t *h;
+    const motion_capture_rec_t *rec;
+    long size, pos, room = 0;
+    char *data;
+    FILE *f;
+
+    f = fopen(name, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", name, strerror(errno));
+        return -1;
+    }
+    if (fseek(f, 0, SEEK_END) < 0 || (size = ftell(f)) < 0
+        || fseek(f, 0, SEEK_SET) < 0) {
+        fprintf(stderr, "%s: %s\n", name, strerror(errno));
+        fclose(f);
+        return -1;
+    }
+    data = malloc(size ? size : 1);
+    if (!data || fread(data, 1, size, f) != (size_t) size) {
+        fprintf(stderr, "%s: could not read it\n", name);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    h = (const motion_capture_hdr_t *) data;
+    if ((size_t) size < sizeof(*h)
+        || memcmp(h->magic, MOTION_CAPTURE_MAGIC, sizeof(h->magic)) != 0) {
+        fprintf(stderr, "%s: not a motion-logger capture\n", name);
+        return -1;
+    }
+    if (h->version != MOTION_CAPTURE_VERSION) {
+        fprintf(stderr, "%s: capture version %u, expected %u\n", name,
+            h->version, MOTION_CAPTURE_VERSION);
+        return -1;
+    }
+    if (h->command_size != sizeof(emcmot_command_t)) {
+        fprintf(stderr, "%s: written by a different build of LinuxCNC "
+            "(command size %u, here %zu)\n", name, h->command_size,
+            sizeof(emcmot_command_t));
+        return -1;
+    }
+
+    for (pos = sizeof(*h); pos < size; ) {
+        if (size - pos < (long) (sizeof(*rec) + sizeof(emcmot_command_t))) {
+            fprintf(stderr, "%s: last command cut short, ignored\n", name);
+            break;
+        }
+        rec = (const motion_capture_rec_t *) (data + pos);
+        pos += sizeof(*rec);
+        if (rec->extra % sizeof(emcmot_comp_entry_t)
+            || size - pos < (long) (sizeof(emcmot_command_t) + rec->extra)) {
+            fprintf(stderr, "%s: bad record at offset %ld\n", name,
+                pos - (long) sizeof(*rec));
+            return -1;
+        }
+        if (ncmds == room) {
+            room = room ? 2 * room : 1024;
+            cmds = realloc(cmds, room * sizeof(*cmds));
+            if (!cmds) {
+                fprintf(stderr, "out of memory\n");
+                return -1;
+            }
+        }
+        cmds[ncmds].time = rec->time;
+        cmds[ncmds].cmd = (const emcmot_command_t *) (data + pos);
+        cmds[ncmds].extra = data + pos + sizeof(emcmot_command_t);
+        cmds[ncmds].extra_size = rec->extra;
+        pos += sizeof(emcmot_command_t) + rec->extra;
+        ncmds++;
+    }
+    if (ncmds) {
+        long long t0 = cmds[0].time;
+        int n;
+
+        for (n = 0; n < ncmds; n++) {
+            cmds[n].time -= t0;
+        }
+    }
+    return 0;
+}
+
+/* The commands Task only sends once motion is done, see
+   emcTaskCheckPreconditions(); moves wait for room in the queue. */
+static int waits_for_idle(const emcmot_command_t *cmd)
+{
+    switch (cmd->command) {
+    case EMCMOT_PROBE:
+    case EMCMOT_RIGID_TAP:
+    case EMCMOT_CLEAR_PROBE_FLAGS:
+    case EMCMOT_SET_OFFSET:
+    case EMCMOT_SPINDLE_ON:
+    case EMCMOT_SPINDLE_OFF:
+    case EMCMOT_SPINDLE_ORIENT:
+    case EMCMOT_SPINDLE_BRAKE_ENGAGE:
+    case EMCMOT_SPINDLE_BRAKE_RELEASE:
+    case EMCMOT_AF_ENABLE:
+    case EMCMOT_JOINT_HOME:
+        return 1;
+    case EMCMOT_SET_DOUT:
+    case EMCMOT_SET_AOUT:
+        return cmd->now;
+    default:
+        return 0;
+    }
+}
+
+static int waits_for_room(const emcmot_command_t *cmd)
+{
+    return cmd->command == EMCMOT_SET_LINE
+        || cmd->command == EMCMOT_SET_CIRCLE;
+}
+
+/***********************************************************************
+*                        Timing statistics                             *
+************************************************************************/
+
+typedef struct {
+    const char *name;
+    unsigned *ns;
+    long n, room;
+    double sum;
+} samples_t;
+
+static int add_sample(samples_t *s, long long ns)
+{
+    if (s->n == s->room) {
+        s->room = s->room ? 2 * s->room : 65536;
+        s->ns = realloc(s->ns, s->room * sizeof(*s->ns));
+        if (!s->ns) {
+            fprintf(stderr, "out of memory for timing samples\n");
+            return -1;
+        }
+    }
+    s->ns[s->n++] = ns;
+    s->sum += ns;
+    return 0;
+}
+
+static int cmp_unsigned(const void *a, const void *b)
+{
+    unsigned x = *(const unsigned *) a, y = *(const unsigned *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+static unsigned percentile(const samples_t *s, double p)
+{
+    long i = (long) (p / 100 * (s->n - 1) + 0.5);
+
+    return s->ns[i];
+}
+
+static void print_samples(FILE *out, samples_t *s)
+{
+    if (!s->n) {
+        return;
+    }
+    qsort(s->ns, s->n, sizeof(*s->ns), cmp_unsigned);
+    fprintf(out, "%-16s %8u %8.0f %8u %8u %8u %8u\n", s->name, s->ns[0],
+        s->sum / s->n, percentile(s, 50), percentile(s, 99),
+        percentile(s, 99.9), s->ns[s->n - 1]);
+}
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/***********************************************************************
+*                           Simulation                                 *
+************************************************************************/
+
+/* the pins of motmod a sim config connects */
+static struct {
+    hal_float_t *cmd, *fb;
+} jpins[EMCMOT_MAX_JOINTS];
+
+static struct {
+    hal_float_t *speed_out_rps, *speed_in, *revs;
+    hal_bit_t *index_enable, *orient, *is_oriented;
+} spins[EMCMOT_MAX_SPINDLES];
+
+static int find_pins(kinsuser_t *mot)
+{
+    const char *name;
+    char what[HAL_NAME_LEN + 1];
+    int i, n, found = 0;
+
+    for (i = 0; (name = kinsuser_pin_name(mot, i)); i++) {
+        if (sscanf(name, "joint.%d.%s", &n, what) == 2
+            && n >= 0 && n < EMCMOT_MAX_JOINTS) {
+            if (strcmp(what, "motor-pos-cmd") == 0) {
+                jpins[n].cmd = kinsuser_pin_ptr(mot, name);
+                found++;
+            } else if (strcmp(what, "motor-pos-fb") == 0) {
+                jpins[n].fb = kinsuser_pin_ptr(mot, name);
+            }
+        } else if (sscanf(name, "spindle.%d.%s", &n, what) == 2
+            && n >= 0 && n < EMCMOT_MAX_SPINDLES) {
+            void *p = kinsuser_pin_ptr(mot, name);
+
+            if (strcmp(what, "speed-out-rps") == 0) {
+                spins[n].speed_out_rps = p;
+            } else if (strcmp(what, "speed-in") == 0) {
+                spins[n].speed_in = p;
+            } else if (strcmp(what, "revs") == 0) {
+                spins[n].revs = p;
+            } else if (strcmp(what, "index-enable") == 0) {
+                spins[n].index_enable = p;
+            } else if (strcmp(what, "orient") == 0) {
+                spins[n].orient = p;
+            } else if (strcmp(what, "is-oriented") == 0) {
+                spins[n].is_oriented = p;
+            }
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "motmod has no joint pins\n");
+        return -1;
+    }
+    if (kinsuser_set(mot, "motion.enable", 1)
+        || kinsuser_set(mot, "motion.adaptive-feed", 1)) {
+        return -1;
+    }
+    return 0;
+}
+
+/* what the motors and spindles of a sim config do */
+static void feedback(double period)
+{
+    int n;
+
+    for (n = 0; n < EMCMOT_MAX_JOINTS; n++) {
+        if (jpins[n].cmd && jpins[n].fb) {
+            *jpins[n].fb = *jpins[n].cmd;
+        }
+    }
+    for (n = 0; n < EMCMOT_MAX_SPINDLES; n++) {
+        if (!spins[n].speed_out_rps || !spins[n].speed_in || !spins[n].revs) {
+            continue;
+        }
+        *spins[n].speed_in = *spins[n].speed_out_rps;
+        *spins[n].revs += *spins[n].speed_in * period;
+        if (spins[n].index_enable && *spins[n].index_enable) {
+            *spins[n].revs -= (long) *spins[n].revs;
+            *spins[n].index_enable = 0;
+        }
+        if (spins[n].orient && spins[n].is_oriented) {
+            *spins[n].is_oriented = *spins[n].orient;
+        }
+    }
+}
+
+static int motion_idle(const emcmot_struct_t *s)
+{
+    int n;
+
+    if (s->status.depth != 0 || !(s->status.motionFlag & EMCMOT_MOTION_INPOS_BIT)) {
+        return 0;
+    }
+    for (n = 0; n < EMCMOT_MAX_JOINTS; n++) {
+        if (s->status.joint_status[n].homing) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int print_errors(emcmot_struct_t *s, int verbose)
+{
+    char data[EMCMOT_ERROR_LEN], msg[EMCMOT_ERROR_LEN];
+    rtapi_msgring_slot_t *slot;
+    struct dbuf d;
+    struct dbuf_iter di;
+    int count = 0;
+
+    while ((slot = rtapi_msgring_peek(&s->error.ring))) {
+        dbuf_init(&d, (unsigned char *) data, EMCMOT_ERROR_LEN);
+        memcpy(data, rtapi_msgring_payload(slot), EMCMOT_ERROR_LEN);
+        rtapi_msgring_release(&s->error.ring, slot);
+        dbuf_iter_init(&di, &d);
+        if (snprintdbuf(msg, sizeof(msg), &di) < 0) {
+            snprintf(msg, sizeof(msg), "(unreadable message)");
+        }
+        if (verbose) {
+            fprintf(stderr, "%.3f: %s\n", sim_ns * 1e-9, msg);
+        }
+        count++;
+    }
+    return count;
+}
+
+static void write_trace(FILE *f, long cycle, const emcmot_struct_t *s,
+    int joints)
+{
+    const EmcPose *p = &s->status.carte_pos_cmd;
+    int n;
+
+    fprintf(f, "%ld %.6f %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g",
+        cycle, sim_ns * 1e-9, p->tran.x, p->tran.y, p->tran.z,
+        p->a, p->b, p->c, p->u, p->v, p->w, s->status.current_vel);
+    for (n = 0; n < joints; n++) {
+        fprintf(f, " %.9g %.9g", s->status.joint_status[n].pos_cmd,
+            s->status.joint_status[n].vel_cmd);
+    }
+    fputc('\n', f);
+}
+
+/***********************************************************************
+*                               Main                                   *
+************************************************************************/
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: motion-replay [-v] [-t] [-j] [-o TRACE] [-d N] "
+        "[-l SECONDS]\n"
+        "                     [-k 'KINS [ARGS]'] [-m 'MOTMOD ARGS'] "
+        "[-H HOMEMOD] [-T TPMOD]\n"
+        "                     [-p PIN=VALUE]... CAPTURE\n");
+    exit(1);
+}
+
+/* pin=value, for a pin of any of the modules */
+static int set_pin(kinsuser_t **mods, int nmods, const char *spec)
+{
+    char name[HAL_NAME_LEN + 1], *end;
+    const char *pin, *eq = strchr(spec, '=');
+    double value;
+    int m, i;
+
+    if (!eq || eq == spec || eq - spec > HAL_NAME_LEN) {
+        fprintf(stderr, "-p %s: expected pin=value\n", spec);
+        return -1;
+    }
+    memcpy(name, spec, eq - spec);
+    name[eq - spec] = 0;
+    value = strtod(eq + 1, &end);
+    if (end == eq + 1 || *end) {
+        fprintf(stderr, "-p %s: bad value\n", spec);
+        return -1;
+    }
+    for (m = 0; m < nmods; m++) {
+        for (i = 0; (pin = kinsuser_pin_name(mods[m], i)); i++) {
+            if (strcmp(pin, name) == 0) {
+                return kinsuser_set(mods[m], name, value);
+            }
+        }
+    }
+    fprintf(stderr, "-p %s: no such pin\n", spec);
+    return -1;
+}
+
+/* "name param=value ..." */
+static kinsuser_t *load(const char *spec)
+{
+    char name[PATH_MAX];
+    const char *args;
+    size_t len;
+
+    len = strcspn(spec, " \t");
+    if (len == 0 || len >= sizeof(name)) {
+        fprintf(stderr, "bad module '%s'\n", spec);
+        return NULL;
+    }
+    memcpy(name, spec, len);
+    name[len] = 0;
+    args = spec + len;
+    return kinsuser_load_module(name, *args ? args : NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *kins = "trivkins", *homemod = "homemod", *tpmod = "tpmod";
+    const char *motargs = "", *trace_name = NULL;
+    char motspec[PATH_MAX + 16];
+    kinsuser_t *kmod, *hmod, *tmod, *mot;
+    const char *pins[64];
+    int npins = 0;
+    void (*handler)(void *, long) = NULL;
+    void (*controller)(void *, long) = NULL;
+    void *handler_arg = NULL, *controller_arg = NULL;
+    emcmot_struct_t *s;
+    emcmot_comp_tables_t *comp;
+    samples_t t_handler = { .name = "command handler" };
+    samples_t t_controller = { .name = "controller" };
+    samples_t t_total = { .name = "total" };
+    FILE *trace = NULL, *out = stdout;
+    int verbose = 0, timed = 0, joints = 0, decimate = 1, i, c;
+    double limit = 600;
+    int next = 0, pending = 0, errors = 0, rejected = 0, stuck = 0, num;
+    long long busy_since = -1, wall0, wall, t0, t1, t2;
+    long cycle;
+    const EmcPose *p;
+
+    while ((c = getopt(argc, argv, "vtjo:d:l:k:m:H:T:p:")) != -1) {
+        switch (c) {
+        case 'v': verbose = 1; break;
+        case 't': timed = 1; break;
+        case 'j': joints = 1; break;
+        case 'o': trace_name = optarg; break;
+        case 'd': decimate = atoi(optarg); break;
+        case 'l': limit = atof(optarg); break;
+        case 'k': kins = optarg; break;
+        case 'm': motargs = optarg; break;
+        case 'H': homemod = optarg; break;
+        case 'T': tpmod = optarg; break;
+        case 'p':
+            if (npins == (int) (sizeof(pins) / sizeof(pins[0]))) {
+                usage();
+            }
+            pins[npins++] = optarg;
+            break;
+        default: usage();
+        }
+    }
+    if (optind != argc - 1 || decimate < 1 || limit <= 0) {
+        usage();
+    }
+    if (read_capture(argv[optind])) {
+        return 1;
+    }
+    if (verbose) {
+        rtapi_set_msg_level(RTAPI_MSG_INFO);
+    }
+
+    /* in the order motmod needs them */
+    snprintf(motspec, sizeof(motspec), "motmod %s", motargs);
+    if (!(kmod = load(kins)) || !(hmod = kinsuser_load_module(homemod, NULL))
+        || !(tmod = kinsuser_load_module(tpmod, NULL))
+        || !(mot = load(motspec))) {
+        return 1;
+    }
+    for (i = 0; i < nfuncts; i++) {
+        if (strcmp(functs[i].name, "motion-command-handler") == 0) {
+            handler = functs[i].funct;
+            handler_arg = functs[i].arg;
+        } else if (strcmp(functs[i].name, "motion-controller") == 0) {
+            controller = functs[i].funct;
+            controller_arg = functs[i].arg;
+        }
+    }
+    /* motmod asks for emcmot_struct_t first, then the comp tables */
+    if (!handler || !controller || thread_period <= 0
+        || rtapi_shmem_getptr(1, (void **) &s) < 0
+        || rtapi_shmem_getptr(2, (void **) &comp) < 0) {
+        fprintf(stderr, "motmod did not set up its thread\n");
+        return 1;
+    }
+    if (find_pins(mot)) {
+        return 1;
+    }
+    for (i = 0; i < npins; i++) {
+        kinsuser_t *mods[] = { kmod, mot, hmod, tmod };
+
+        if (set_pin(mods, 4, pins[i])) {
+            return 1;
+        }
+    }
+    if (joints) {
+        joints = s->config.numJoints;
+    }
+
+    if (trace_name) {
+        if (strcmp(trace_name, "-") == 0) {
+            trace = stdout;
+            out = stderr;
+        } else if (!(trace = fopen(trace_name, "w"))) {
+            fprintf(stderr, "%s: %s\n", trace_name, strerror(errno));
+            return 1;
+        }
+        fprintf(trace, "# cycle time x y z a b c u v w vel");
+        for (i = 0; i < joints; i++) {
+            fprintf(trace, " j%d.pos j%d.vel", i, i);
+        }
+        fputc('\n', trace);
+    }
+
+    num = s->status.commandNumEcho;
+    wall0 = now_ns();
+    for (cycle = 0; ; cycle++) {
+        int busy;
+
+        sim_ns = cycle * thread_period;
+
+        if (pending && s->status.commandNumEcho == num) {
+            if (s->status.commandStatus != EMCMOT_COMMAND_OK) {
+                rejected++;
+                if (verbose) {
+                    fprintf(stderr, "%.3f: command %d (type %d) rejected, "
+                        "status %d\n", sim_ns * 1e-9, next - 1,
+                        s->command.command, s->status.commandStatus);
+                }
+            }
+            pending = 0;
+        }
+
+        /* the next command, when Task would send it */
+        if (!pending) {
+            const capture_cmd_t *cc = next < ncmds ? &cmds[next] : NULL;
+
+            if (cc) {
+                busy = (waits_for_idle(cc->cmd) && !motion_idle(s))
+                    || (waits_for_room(cc->cmd) && s->status.queueFull);
+            } else {
+                busy = !motion_idle(s);
+                if (!busy) {
+                    break;
+                }
+            }
+            if (!busy) {
+                busy_since = -1;
+                if (!timed || sim_ns >= cc->time) {
+                    s->command = *cc->cmd;
+                    s->command.commandNum = ++num;
+                    if (cc->extra_size) {
+                        if (cc->extra_size > comp->entries_max
+                            * sizeof(emcmot_comp_entry_t)) {
+                            fprintf(stderr, "command %d loads %zu comp "
+                                "entries, motmod has room for %d, see "
+                                "comp_entries=\n", next,
+                                cc->extra_size / sizeof(emcmot_comp_entry_t),
+                                comp->entries_max);
+                            return 1;
+                        }
+                        memcpy(comp->entry, cc->extra, cc->extra_size);
+                    }
+                    next++;
+                    pending = 1;
+                }
+            } else if (busy_since < 0) {
+                busy_since = sim_ns;
+            } else if (sim_ns - busy_since > limit * 1e9) {
+                if (cc) {
+                    fprintf(stderr, "waited %g s for motion before command "
+                        "%d (type %d), giving up\n", limit, next,
+                        cc->cmd->command);
+                } else {
+                    fprintf(stderr, "motion still busy %g s after the last "
+                        "command, giving up\n", limit);
+                }
+                stuck = 1;
+                break;
+            }
+        }
+
+        t0 = now_ns();
+        handler(handler_arg, thread_period);
+        t1 = now_ns();
+        controller(controller_arg, thread_period);
+        t2 = now_ns();
+        if (add_sample(&t_handler, t1 - t0)
+            || add_sample(&t_controller, t2 - t1)
+            || add_sample(&t_total, t2 - t0)) {
+            return 1;
+        }
+
+        feedback(thread_period * 1e-9);
+        errors += print_errors(s, verbose);
+        if (trace && cycle % decimate == 0) {
+            write_trace(trace, cycle, s, joints);
+        }
+    }
+    wall = now_ns() - wall0;
+    if (trace && trace != stdout) {
+        fclose(trace);
+    }
+
+    fprintf(out, "%d of %d commands sent, %d rejected, %d motion errors\n",
+        next, ncmds, rejected, errors);
+    fprintf(out, "%ld cycles of %ld ns, %.3f s simulated in %.3f s, "
+        "%.1f times real time\n", cycle, thread_period, sim_ns * 1e-9,
+        wall * 1e-9, wall ? (double) sim_ns / wall : 0);
+    fprintf(out, "%-16s %8s %8s %8s %8s %8s %8s\n", "ns per cycle", "min",
+        "mean", "50%", "99%", "99.9%", "max");
+    print_samples(out, &t_handler);
+    print_samples(out, &t_controller);
+    print_samples(out, &t_total);
+    p = &s->status.carte_pos_cmd;
+    fprintf(out, "final position %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f "
+        "%.6f\n", p->tran.x, p->tran.y, p->tran.z, p->a, p->b, p->c,
+        p->u, p->v, p->w);
+
+    kinsuser_unload(mot);
+    kinsuser_unload(tmod);
+    kinsuser_unload(hmod);
+    kinsuser_unload(kmod);
+    return stuck || rejected ? 2 : 0;
+}
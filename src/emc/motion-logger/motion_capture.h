@@ -0,0 +1,43 @@
+/********************************************************************
+* Description: motion_capture.h
+*   Binary captures of the motion command stream
+*
+*   motion-logger -b writes every command Task sends to Motion, as it
+*   arrived, to a capture file; motion-replay feeds a capture to the
+*   real motion controller and trajectory planner.  Unlike the text
+*   log, a capture holds the whole emcmot_command_t, so it only makes
+*   sense to the same build of LinuxCNC that wrote it: the reader
+*   checks the size of the command against its own.
+*
+* License: GPL Version 2
+* System: Linux
+*
+********************************************************************/
+
+#ifndef MOTION_CAPTURE_H
+#define MOTION_CAPTURE_H
+
+#include "rtapi_stdint.h"
+
+#define MOTION_CAPTURE_MAGIC "LCNCMCAP"
+#define MOTION_CAPTURE_VERSION 1
+
+/* The file is this header, then one record per command.  Native byte
+   order. */
+typedef struct {
+    char magic[8];
+    rtapi_u32 version;
+    rtapi_u32 command_size;     /* sizeof(emcmot_command_t) */
+    rtapi_u32 reserved[2];
+} motion_capture_hdr_t;
+
+/* A record is this, then the emcmot_command_t, then 'extra' bytes:
+   for EMCMOT_LOAD_JOINT_COMP the comp_count staged comp entries,
+   nothing for the other commands. */
+typedef struct {
+    rtapi_u64 time;             /* ns since the capture started */
+    rtapi_u32 extra;
+    rtapi_u32 reserved;
+} motion_capture_rec_t;
+
+#endif /* MOTION_CAPTURE_H */
@@ -322,6 +322,48 @@ int emcmotGetRotaryIsUnlocked(int jnum) {
     return *(emcmot_hal_data->joint[jnum].is_unlocked);
 }
 
+/* joint positions for the coordinated position 'pos', for the planner
+   to check moves against the joint limits.  If 'guess' is set,
+   'joint_pos' holds the joints of a nearby position on entry, for
+   iterative kinematics; otherwise the commanded joint positions are used
+   for that.  The kinematics are asked as a query, so they leave the state
+   they keep for the servo cycle alone. */
+int emcmotJointPos(EmcPose const *pos, double *joint_pos, int guess)
+{
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    KINEMATICS_INVERSE_FLAGS iflags = KINEMATICS_INVERSE_QUERY;
+    int joint_num;
+
+    if (!guess) {
+	for (joint_num = 0; joint_num < ALL_JOINTS; joint_num++) {
+	    joint_pos[joint_num] = joints[joint_num].pos_cmd;
+	}
+    }
+    if (kinematicsInverse(pos, joint_pos, &iflags, &fflags) != 0) {
+	return -1;
+    }
+    for (joint_num = 0; joint_num < ALL_JOINTS; joint_num++) {
+	if (!isfinite(joint_pos[joint_num])) {
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+/* velocity and acceleration limits of a joint for the planner, 0 for
+   joints that are not active */
+double emcmotJointVelLimit(int joint_num)
+{
+    emcmot_joint_t *joint = &joints[joint_num];
+    return GET_JOINT_ACTIVE_FLAG(joint) ? joint->vel_limit : 0;
+}
+
+double emcmotJointAccLimit(int joint_num)
+{
+    emcmot_joint_t *joint = &joints[joint_num];
+    return GET_JOINT_ACTIVE_FLAG(joint) ? joint->acc_limit : 0;
+}
+
 /*! \function emcmotDioWrite()
 
   sets or clears a HAL DIO pin,
@@ -401,6 +443,8 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
 	emcmotStatus->head++;
 	emcmotInternal->head++;
 
+	HAL_TRACE_INSTANT(emcmot_trace_command, emcmotCommand->command);
+
 	/* got a new command-- echo command and number... */
 	emcmotStatus->commandEcho = emcmotCommand->command;
 	emcmotStatus->commandNumEcho = emcmotCommand->commandNum;
@@ -1839,7 +1883,7 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
 	    if (joint == 0) {
 		break;
 	    }
-	    if (joint->comp.entries >= EMCMOT_COMP_SIZE) {
+	    if (joint->comp.entries >= joint->comp.entries_max) {
 		reportError(_("joint %d: too many compensation entries"), joint_num);
 		break;
 	    }
@@ -1869,6 +1913,41 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
 	    joint->comp.entries++;
 	    break;
 
+	case EMCMOT_LOAD_JOINT_COMP:
+	    rtapi_print_msg(RTAPI_MSG_DBG, "LOAD_JOINT_COMP for joint %d, %d entries",
+		joint_num, emcmotCommand->comp_count);
+	    if (joint == 0) {
+		break;
+	    }
+	    if ((emcmotCommand->comp_count < 0) ||
+		(emcmotCommand->comp_count > joint->comp.entries_max)) {
+		reportError(_("joint %d: too many compensation entries"), joint_num);
+		emcmotStatus->commandStatus = EMCMOT_COMMAND_BAD_EXEC;
+		break;
+	    }
+	    if (emcmotCompLoad(&joint->comp, emcmotCompTables->entry,
+		    emcmotCommand->comp_count) != 0) {
+		reportError(_("joint %d: compensation values must increase"), joint_num);
+		emcmotStatus->commandStatus = EMCMOT_COMMAND_BAD_EXEC;
+	    }
+	    break;
+
+	case EMCMOT_SET_VOLCOMP:
+	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_VOLCOMP %d", emcmotCommand->mode);
+	    if (!emcmotCommand->mode) {
+		/* the grid may be rewritten after this, the joints
+		   slew back to no correction */
+		volcomp.grid = 0;
+		break;
+	    }
+	    if (emcmotVolCompPrepare(&volcomp, emcmotVolComp) != 0) {
+		reportError(emcmotVolComp ?
+		    _("volumetric compensation grid is not valid") :
+		    _("no room for a volumetric compensation grid, set motmod volcomp_nodes="));
+		emcmotStatus->commandStatus = EMCMOT_COMMAND_BAD_EXEC;
+	    }
+	    break;
+
         case EMCMOT_SET_OFFSET:
             emcmotStatus->tool_offset = emcmotCommand->tool_offset;
             break;
@@ -1954,6 +2033,14 @@ void emcmotCommandHandler_locked(void *arg, long servo_period)
             emcmotConfig->inhibit_probe_jog_error = emcmotCommand->probe_jog_err_inhibit;
             emcmotConfig->inhibit_probe_home_error = emcmotCommand->probe_home_err_inhibit;
             break;
+        case EMCMOT_SET_JOINT_LIMIT_SAMPLES:
+            if (emcmotCommand->jointLimitSamples < 0
+                || emcmotCommand->jointLimitSamples > EMCMOT_MAX_JOINT_LIMIT_SAMPLES) {
+                emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
+                break;
+            }
+            emcmotConfig->jointLimitSamples = emcmotCommand->jointLimitSamples;
+            break;
 
 	}			/* end of: command switch */
 	if (emcmotStatus->commandStatus != EMCMOT_COMMAND_OK) {
@@ -60,6 +60,9 @@ static unsigned long last_period = 0;
 /* servo cycle time */
 static double servo_period;
 
+/* volumetric compensation lookup state, set up by EMCMOT_SET_VOLCOMP */
+emcmot_volcomp_state_t volcomp;
+
 extern struct emcmot_status_t *emcmotStatus;
 
 // *pcmd_p[0] is shorthand for emcmotStatus->carte_pos_cmd.tran.x
@@ -173,6 +176,19 @@ static void get_pos_cmds(long period);
 */
 static void compute_screw_comp(void);
 
+/* 'compute_volcomp()' is called at the end of get_pos_cmds(), once
+   the commanded Cartesian position and the joint positions from the
+   inverse kinematics are known.  It looks up the correction vector for
+   the commanded X, Y, Z in the volumetric compensation grid and
+   puts the component each joint is mapped to in volcomp_corr, which
+   is added to motor_pos_cmd and subtracted from motor_pos_fb just
+   like the screw comp.  While there is no grid, no valid Cartesian
+   command or the machine is not homed the correction goes to zero.
+   Changes are slewed at a tenth of the joint velocity limit, so
+   turning the compensation on does not make the motors jump.
+*/
+static void compute_volcomp(void);
+
 /* 'output_to_hal()' writes the handles the final stages of the
    control function.  It applies screw comp and writes the
    final motor position to the HAL (which routes it to the PID
@@ -457,9 +473,10 @@ static void process_inputs(void)
 	       to match the commanded value instead. */
 	    joint->pos_fb = joint->pos_cmd;
 	} else {
-	    /* normal case: subtract backlash comp and motor offset */
+	    /* normal case: subtract backlash comp, volumetric comp and
+	       motor offset */
 	    joint->pos_fb = joint->motor_pos_fb -
-		(joint->backlash_filt + joint->motor_offset);
+		(joint->backlash_filt + joint->volcomp_corr + joint->motor_offset);
 	}
 	/* calculate following error */
 	if ( IS_EXTRA_JOINT(joint_num) && get_homed(joint_num) ) {
@@ -1344,7 +1361,9 @@ static void get_pos_cmds(long period)
 	    /* they're empty, pull next point(s) off Cartesian planner */
 	    /* run coordinated trajectory planning cycle */
 
+	    HAL_TRACE_BEGIN(emcmot_trace_tp, 0);
 	    tpRunCycle(&emcmotInternal->coord_tp, period);
+	    HAL_TRACE_END(emcmot_trace_tp, 0);
             /* get new commanded traj pos */
             tpGetPos(&emcmotInternal->coord_tp, &emcmotStatus->carte_pos_cmd);
 
@@ -1504,6 +1523,7 @@ static void get_pos_cmds(long period)
     default:
 	break;
     }
+    compute_volcomp();
     /* check command against soft limits */
     /* This is a backup check, it should be impossible to command
 	a move outside the soft limits.  However there is at least
@@ -1683,6 +1703,39 @@ Their exact contents and meaning are as follows:
 
 */
 
+static void compute_volcomp(void)
+{
+    int joint_num, axis;
+    emcmot_joint_t *joint;
+    double pos[3], corr[3] = {0.0, 0.0, 0.0};
+    double target, step;
+    int active;
+
+    active = volcomp.grid && emcmotStatus->carte_pos_cmd_ok && get_allhomed();
+    if (active) {
+	pos[0] = emcmotStatus->carte_pos_cmd.tran.x;
+	pos[1] = emcmotStatus->carte_pos_cmd.tran.y;
+	pos[2] = emcmotStatus->carte_pos_cmd.tran.z;
+	emcmotVolCompEval(&volcomp, pos, corr);
+    }
+    for (joint_num = 0; joint_num < ALL_JOINTS; joint_num++) {
+	joint = &joints[joint_num];
+	axis = active ? volcomp.grid->joint_axis[joint_num] : -1;
+	target = axis >= 0 ? corr[axis] : 0.0;
+	if (target == joint->volcomp_corr) {
+	    continue;
+	}
+	step = 0.1 * joint->vel_limit * servo_period;
+	if (target > joint->volcomp_corr + step) {
+	    joint->volcomp_corr += step;
+	} else if (target < joint->volcomp_corr - step) {
+	    joint->volcomp_corr -= step;
+	} else {
+	    joint->volcomp_corr = target;
+	}
+    }
+}
+
 static void compute_screw_comp(void)
 {
     int joint_num;
@@ -1705,12 +1758,7 @@ static void compute_screw_comp(void)
 	if ( comp->entries > 0 ) {
 	    /* there is data in the comp table, use it */
 	    /* first make sure we're in the right spot in the table */
-	    while ( joint->pos_cmd < comp->entry->nominal ) {
-		comp->entry--;
-	    }
-	    while ( joint->pos_cmd >= (comp->entry+1)->nominal ) {
-		comp->entry++;
-	    }
+	    comp->entry = emcmotCompFind(comp, joint->pos_cmd);
 	    /* now interpolate */
 	    dpos = joint->pos_cmd - comp->entry->nominal;
 	    if (joint->vel_cmd > 0.0) {
@@ -2037,9 +2085,9 @@ static void output_to_hal(void)
 	joint = &joints[joint_num];
 	joint_data = &(emcmot_hal_data->joint[joint_num]);
 
-	/* apply backlash and motor offset to output */
-	joint->motor_pos_cmd =
-	    joint->pos_cmd + joint->backlash_filt + joint->motor_offset;
+	/* apply backlash, volumetric comp and motor offset to output */
+	joint->motor_pos_cmd = joint->pos_cmd + joint->backlash_filt +
+	    joint->volcomp_corr + joint->motor_offset;
 	/* point to HAL data */
 	/* write to HAL pins */
 	*(joint_data->motor_offset) = joint->motor_offset;
@@ -2055,6 +2103,7 @@ static void output_to_hal(void)
 	*(joint_data->backlash_corr) = joint->backlash_corr;
 	*(joint_data->backlash_filt) = joint->backlash_filt;
 	*(joint_data->backlash_vel) = joint->backlash_vel;
+	*(joint_data->volcomp_corr) = joint->volcomp_corr;
 	*(joint_data->f_error) = joint->ferror;
 	*(joint_data->f_error_lim) = joint->ferror_limit;
 
@@ -39,6 +39,12 @@
 #error A 64 bit bitmask is used in the planner.  Don't increase these until that's fixed.
 #endif
 
+/* most points per move the planner checks against the joint limits,
+   see [TRAJ]JOINT_LIMIT_SAMPLES.  Each is an inverse kinematics call in
+   the command handler; 17 calls of genserkins, seeded from the previous
+   point, take about 150 us. */
+#define EMCMOT_MAX_JOINT_LIMIT_SAMPLES 16
+
 #define EMCMOT_ERROR_NUM 32	/* how many errors we can queue */
 #define EMCMOT_ERROR_LEN 1024	/* how long error string can be */
 
@@ -47,6 +53,10 @@
   values need to be computed, since operating system does this for us
   */
 #define DEFAULT_SHMEM_KEY 100
+/* the volumetric compensation grid and the screw comp tables have
+   blocks of their own, next to it */
+#define VOLCOMP_SHMEM_KEY(key) ((key) + 1)
+#define COMP_SHMEM_KEY(key) ((key) + 2)
 
 /* default comm timeout, in seconds */
 #define DEFAULT_EMCMOT_COMM_TIMEOUT 1.0
@@ -11,6 +11,7 @@
 * Copyright (c) 2004 All rights reserved.
 ********************************************************************/
 
+#include <float.h>		/* DBL_MAX */
 #include "emcmotcfg.h"		/* EMCMOT_ERROR_NUM,LEN */
 #include "motion.h"		/* these decls */
 #include "dbuf.h"
@@ -22,35 +23,31 @@ int emcmotErrorInit(emcmot_error_t * errlog)
 	return -1;
     }
 
-    errlog->head = 0;
-    errlog->start = 0;
-    errlog->end = 0;
-    errlog->num = 0;
-    errlog->tail = 0;
-
-    return 0;
+    return rtapi_msgring_init(&errlog->ring, EMCMOT_ERROR_NUM, EMCMOT_ERROR_LEN);
 }
 
 int emcmotErrorPutfv(emcmot_error_t * errlog, const char *fmt, va_list ap)
 {
+    rtapi_msgring_slot_t *slot;
     struct dbuf errbuf;
     struct dbuf_iter it;
 
-    if (errlog == 0 || errlog->num == EMCMOT_ERROR_NUM) {
-	/* full */
+    if (errlog == 0 || (slot = rtapi_msgring_claim(&errlog->ring)) == 0) {
+	/* full, counted in ring.lost */
 	return -1;
     }
 
-    errlog->head++;
-
-    dbuf_init(&errbuf, (unsigned char*)errlog->error[errlog->end], EMCMOT_ERROR_LEN);
+#ifdef RTAPI
+    slot->time = rtapi_get_time();
+#else
+    slot->time = 0;
+#endif
+    slot->level = RTAPI_MSG_ERR;
+    dbuf_init(&errbuf, (unsigned char*)rtapi_msgring_payload(slot), EMCMOT_ERROR_LEN);
     dbuf_iter_init(&it, &errbuf);
     vstashf(&it, fmt, ap);
 
-    errlog->end = (errlog->end + 1) % EMCMOT_ERROR_NUM;
-    errlog->num++;
-
-    errlog->tail = errlog->head;
+    rtapi_msgring_publish(slot);
 
     return 0;
 }
@@ -72,16 +69,215 @@ int emcmotErrorPut(emcmot_error_t *errlog, const char *error)
 
 int emcmotErrorGet(emcmot_error_t * errlog, char *error)
 {
-    if (errlog == 0 || errlog->num == 0) {
+    rtapi_msgring_slot_t *slot;
+
+    if (errlog == 0 || (slot = rtapi_msgring_peek(&errlog->ring)) == 0) {
 	/* empty */
 	return -1;
     }
 
-    errlog->head++;
-    memcpy(error, errlog->error[errlog->start], EMCMOT_ERROR_LEN);
-    errlog->start = (errlog->start + 1) % EMCMOT_ERROR_NUM;
-    errlog->num--;
-    errlog->tail = errlog->head;
+    memcpy(error, rtapi_msgring_payload(slot), EMCMOT_ERROR_LEN);
+    rtapi_msgring_release(&errlog->ring, slot);
 
     return 0;
 }
+
+/* Sets up an empty table in 'array', which has room for entries_max+2
+   entries. */
+void emcmotCompInit(emcmot_comp_t *comp, emcmot_comp_entry_t *array,
+    int entries_max)
+{
+    int n;
+
+    comp->array = array;
+    comp->entries_max = entries_max;
+    comp->entries = 0;
+    comp->entry = &(comp->array[0]);
+    /* the compensation code has -DBL_MAX at one end of the table
+       and +DBL_MAX at the other so _all_ commanded positions are
+       guaranteed to be covered by the table */
+    comp->array[0].nominal = -DBL_MAX;
+    comp->array[0].fwd_trim = 0.0;
+    comp->array[0].rev_trim = 0.0;
+    comp->array[0].fwd_slope = 0.0;
+    comp->array[0].rev_slope = 0.0;
+    for ( n = 1 ; n < entries_max+2 ; n++ ) {
+	comp->array[n].nominal = DBL_MAX;
+	comp->array[n].fwd_trim = 0.0;
+	comp->array[n].rev_trim = 0.0;
+	comp->array[n].fwd_slope = 0.0;
+	comp->array[n].rev_slope = 0.0;
+    }
+}
+
+/* Replaces the table with 'count' entries from 'src', of which only
+   nominal, fwd_trim and rev_trim are used. The whole table is checked
+   first, so a bad table leaves the old one in place. Returns 0, or -1
+   if the nominal values do not increase. */
+int emcmotCompLoad(emcmot_comp_t *comp, const emcmot_comp_entry_t *src, int count)
+{
+    emcmot_comp_entry_t *dst;
+    double dnom;
+    int n, old;
+
+    if (count < 0 || count > comp->entries_max) {
+	return -1;
+    }
+    for (n = 1; n < count; n++) {
+	if (src[n].nominal <= src[n-1].nominal) {
+	    return -1;
+	}
+    }
+    old = comp->entries;
+    dst = &comp->array[1];
+    for (n = 0; n < count; n++) {
+	dst[n].nominal = src[n].nominal;
+	dst[n].fwd_trim = src[n].fwd_trim;
+	dst[n].rev_trim = src[n].rev_trim;
+	dst[n].fwd_slope = 0.0;
+	dst[n].rev_slope = 0.0;
+	if (n > 0) {
+	    /* slopes between the previous entry and this one */
+	    dnom = dst[n].nominal - dst[n-1].nominal;
+	    dst[n-1].fwd_slope = (dst[n].fwd_trim - dst[n-1].fwd_trim) / dnom;
+	    dst[n-1].rev_slope = (dst[n].rev_trim - dst[n-1].rev_trim) / dnom;
+	}
+    }
+    /* below the table the first trims apply */
+    comp->array[0].fwd_trim = count ? dst[0].fwd_trim : 0.0;
+    comp->array[0].rev_trim = count ? dst[0].rev_trim : 0.0;
+    /* restore the end markers after a longer previous table */
+    for (n = count + 1; n <= old + 1; n++) {
+	comp->array[n].nominal = DBL_MAX;
+	comp->array[n].fwd_trim = 0.0;
+	comp->array[n].rev_trim = 0.0;
+	comp->array[n].fwd_slope = 0.0;
+	comp->array[n].rev_slope = 0.0;
+    }
+    comp->entry = &comp->array[0];
+    comp->entries = count;
+    return 0;
+}
+
+/* Returns the table entry at or below 'pos'. From one servo cycle to
+   the next the position moves at most an entry or two, so step from the
+   previous entry; bigger jumps (homing, a new table) use a binary search,
+   which keeps the cost bounded for tables with thousands of entries. */
+emcmot_comp_entry_t *emcmotCompFind(emcmot_comp_t *comp, double pos)
+{
+    emcmot_comp_entry_t *entry = comp->entry;
+    int n, lo, hi, mid;
+
+    for (n = 0; n < 4; n++) {
+	if (pos < entry->nominal) {
+	    entry--;
+	} else if (pos >= (entry+1)->nominal) {
+	    entry++;
+	} else {
+	    return entry;
+	}
+    }
+    /* array[0] is at -DBL_MAX and array[entries+1] at +DBL_MAX */
+    lo = 0;
+    hi = comp->entries + 1;
+    while (hi - lo > 1) {
+	mid = (lo + hi) / 2;
+	if (pos < comp->array[mid].nominal) {
+	    hi = mid;
+	} else {
+	    lo = mid;
+	}
+    }
+    return &comp->array[lo];
+}
+
+/* Checks the grid header and gets ready to look up corrections in it.
+   Returns 0, or -1 if the grid is not usable, in which case 'vc' is
+   left alone. */
+int emcmotVolCompPrepare(emcmot_volcomp_state_t *vc, emcmot_volcomp_t *grid)
+{
+    int n;
+
+    if (grid == 0 || grid->nx < 2 || grid->ny < 2 || grid->nz < 2 ||
+	grid->nx > grid->nodes_max || grid->ny > grid->nodes_max ||
+	grid->nz > grid->nodes_max ||
+	(long long) grid->nx * grid->ny * grid->nz > grid->nodes_max) {
+	return -1;
+    }
+    for (n = 0; n < 3; n++) {
+	if (!(grid->step[n] > 0.0) || grid->step[n] > DBL_MAX) {
+	    return -1;
+	}
+    }
+    for (n = 0; n < EMCMOT_MAX_JOINTS; n++) {
+	if (grid->joint_axis[n] < -1 || grid->joint_axis[n] > 2) {
+	    return -1;
+	}
+    }
+    for (n = 0; n < 3; n++) {
+	vc->inv_step[n] = 1.0 / grid->step[n];
+    }
+    vc->cell[0] = -1;
+    vc->grid = grid;
+    return 0;
+}
+
+/* Trilinear interpolation of the correction at machine position 'pos'.
+   Outside the grid the values at its faces apply. The cell index comes
+   from the precomputed 1/step, and the 8 corners are copied out of the
+   grid only when the position has moved to another cell, which during
+   normal motion is once every few hundred servo cycles. */
+void emcmotVolCompEval(emcmot_volcomp_state_t *vc, const double pos[3], double corr[3])
+{
+    const emcmot_volcomp_t *grid = vc->grid;
+    const float (*c)[3];
+    int size[3], cell[3];
+    double u, f[3], c00, c10, c01, c11, c0, c1;
+    long base, dy, dz, k;
+    int n;
+
+    size[0] = grid->nx;
+    size[1] = grid->ny;
+    size[2] = grid->nz;
+    for (n = 0; n < 3; n++) {
+	u = (pos[n] - grid->origin[n]) * vc->inv_step[n];
+	/* written so that NaN ends up at the low face */
+	if (!(u > 0.0)) {
+	    u = 0.0;
+	} else if (u > size[n] - 1) {
+	    u = size[n] - 1;
+	}
+	cell[n] = (int) u;
+	if (cell[n] > size[n] - 2) {
+	    cell[n] = size[n] - 2;
+	}
+	f[n] = u - cell[n];
+    }
+
+    if (cell[0] != vc->cell[0] || cell[1] != vc->cell[1] || cell[2] != vc->cell[2]) {
+	dy = grid->nx;
+	dz = (long) grid->nx * grid->ny;
+	base = cell[2] * dz + cell[1] * dy + cell[0];
+	for (k = 0; k < 8; k++) {
+	    const float *node = grid->node[base + (k & 1) +
+		((k >> 1) & 1) * dy + ((k >> 2) & 1) * dz];
+	    vc->corner[k][0] = node[0];
+	    vc->corner[k][1] = node[1];
+	    vc->corner[k][2] = node[2];
+	}
+	vc->cell[0] = cell[0];
+	vc->cell[1] = cell[1];
+	vc->cell[2] = cell[2];
+    }
+
+    c = (const float (*)[3]) vc->corner;
+    for (n = 0; n < 3; n++) {
+	c00 = c[0][n] + (c[1][n] - c[0][n]) * f[0];
+	c10 = c[2][n] + (c[3][n] - c[2][n]) * f[0];
+	c01 = c[4][n] + (c[5][n] - c[4][n]) * f[0];
+	c11 = c[6][n] + (c[7][n] - c[6][n]) * f[0];
+	c0 = c00 + (c10 - c00) * f[1];
+	c1 = c01 + (c11 - c01) * f[1];
+	corr[n] = c0 + (c1 - c0) * f[2];
+    }
+}
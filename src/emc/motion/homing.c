@@ -1232,7 +1232,7 @@ static int base_1joint_state_machine(int joint_num)
             /* set the current position to 'home_offset' */
             joint->motor_offset = - H[joint_num].home_offset;
             joint->pos_fb = joint->motor_pos_fb -
-                (joint->backlash_filt + joint->motor_offset);
+                (joint->backlash_filt + joint->volcomp_corr + joint->motor_offset);
             joint->pos_cmd = joint->pos_fb;
             joint->free_tp.curr_pos = joint->pos_fb;
 
@@ -28,6 +28,7 @@
 
 /* joint data */
 #include "hal.h"
+#include "hal_trace.h"
 #include "../motion/motion.h"
 
 typedef struct {
@@ -80,6 +81,7 @@ typedef struct {
     hal_float_t *backlash_corr;	/* RPI: correction for backlash */
     hal_float_t *backlash_filt;	/* RPI: filtered backlash correction */
     hal_float_t *backlash_vel;	/* RPI: backlash speed variable */
+    hal_float_t *volcomp_corr;	/* RPI: volumetric compensation */
     hal_float_t *motor_offset;	/* RPI: motor offset, for checking homing stability */
     hal_float_t *motor_pos_cmd;	/* WPI: commanded position, with comp */
     hal_float_t *motor_pos_fb;	/* RPI: position feedback, with comp */
@@ -225,6 +227,15 @@ extern struct emcmot_status_t *emcmotStatus;
 extern struct emcmot_config_t *emcmotConfig;
 extern struct emcmot_internal_t *emcmotInternal;
 extern struct emcmot_error_t *emcmotError;
+extern emcmot_volcomp_t *emcmotVolComp;
+extern emcmot_comp_tables_t *emcmotCompTables;
+
+/* volumetric compensation lookup state, NULL grid when not in use */
+extern emcmot_volcomp_state_t volcomp;
+
+/* trace events, see hal_trace.h */
+HAL_TRACE_EXTERN(emcmot_trace_command);	/* instant: a new command */
+HAL_TRACE_EXTERN(emcmot_trace_tp);	/* slice: one planner cycle */
 
 /***********************************************************************
 *                    PUBLIC FUNCTION PROTOTYPES                        *
@@ -242,6 +253,11 @@ extern void emcmotAioWrite(int index, double value);
 extern void emcmotSetRotaryUnlock(int axis, int unlock);
 extern int emcmotGetRotaryIsUnlocked(int axis);
 
+/* these let the planner check moves against the joint limits */
+extern int emcmotJointPos(EmcPose const *pos, double *joint_pos, int guess);
+extern double emcmotJointVelLimit(int joint_num);
+extern double emcmotJointAccLimit(int joint_num);
+
 //
 // Try to change the Motion mode to Teleop.
 //
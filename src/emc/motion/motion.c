@@ -46,8 +46,14 @@ static long base_period_nsec = 0;	/* fastest thread period */
 RTAPI_MP_LONG(base_period_nsec, "fastest thread period (nsecs)");
 int base_thread_fp = 0;	/* default is no floating point in base thread */
 RTAPI_MP_INT(base_thread_fp, "floating point in base thread?");
+static char *base_thread_cpus = NULL;	/* default is all threads on one CPU */
+RTAPI_MP_STRING(base_thread_cpus, "CPU list for the base thread, or spread");
 static long servo_period_nsec = 1000000;	/* servo thread period */
 RTAPI_MP_LONG(servo_period_nsec, "servo thread period (nsecs)");
+static char *servo_thread_cpus = NULL;
+RTAPI_MP_STRING(servo_thread_cpus, "CPU list for the servo thread, or spread");
+static int servo_thread_workers = 0;	/* default is no parallel helpers */
+RTAPI_MP_INT(servo_thread_workers, "helpers running servo thread functions in parallel");
 static long traj_period_nsec = 0;	/* trajectory planner period */
 RTAPI_MP_LONG(traj_period_nsec, "trajectory planner period (nsecs)");
 static int num_spindles = 1; /* default number of spindles is 1 */
@@ -79,6 +85,12 @@ RTAPI_MP_ARRAY_STRING(names_misc_errors, EMCMOT_MAX_MISC_ERROR, "names of errors
 
 static int unlock_joints_mask = 0;/* mask to select joints for unlock pins */
 RTAPI_MP_INT(unlock_joints_mask, "mask to select joints for unlock pins");
+
+static int volcomp_nodes = 0;	/* default is no volumetric compensation */
+RTAPI_MP_INT(volcomp_nodes, "room for this many volumetric compensation grid nodes");
+
+static int comp_entries = EMCMOT_COMP_SIZE;
+RTAPI_MP_INT(comp_entries, "room for this many screw compensation entries per joint");
 /***********************************************************************
 *                  GLOBAL VARIABLE DEFINITIONS                         *
 ************************************************************************/
@@ -108,6 +120,13 @@ struct emcmot_status_t *emcmotStatus = 0;
 struct emcmot_config_t *emcmotConfig = 0;
 struct emcmot_internal_t *emcmotInternal = 0;
 struct emcmot_error_t *emcmotError = 0;	/* unused for RT_FIFO */
+/* volumetric compensation grid, in a shmem block of its own */
+emcmot_volcomp_t *emcmotVolComp = 0;
+/* screw compensation tables, in a shmem block of their own */
+emcmot_comp_tables_t *emcmotCompTables = 0;
+
+HAL_TRACE_GLOBAL(emcmot_trace_command);
+HAL_TRACE_GLOBAL(emcmot_trace_tp);
 
 /***********************************************************************
 *                  LOCAL VARIABLE DECLARATIONS                         *
@@ -115,6 +134,8 @@ struct emcmot_error_t *emcmotError = 0;	/* unused for RT_FIFO */
 
 /* RTAPI shmem ID - for comms with higher level user space stuff */
 static int emc_shmem_id;	/* the shared memory ID */
+static int volcomp_shmem_id = -1;	/* the volumetric comp grid, if any */
+static int comp_shmem_id = -1;	/* the screw comp tables */
 
 static int mot_comp_id;	/* component ID for motion module */
 
@@ -241,6 +262,9 @@ static int module_intfc() {
                   ,emcmotGetRotaryIsUnlocked
                   ,axis_get_vel_limit
                   ,axis_get_acc_limit
+                  ,emcmotJointPos
+                  ,emcmotJointVelLimit
+                  ,emcmotJointAccLimit
                   );
 
     tpMotData(emcmotStatus
@@ -307,6 +331,13 @@ int rtapi_app_main(void)
     }
     motion_num_spindles = num_spindles;
 
+    if (comp_entries < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    _("MOTION: comp_entries is %d, must not be negative\n"), comp_entries);
+	hal_exit(mot_comp_id);
+	return -1;
+    }
+
     if (num_dio != NOT_INITIALIZED && (names_dout[0] || names_din[0])) {
       rtapi_print_msg(RTAPI_MSG_ERR, _("MOTION: Can't specify both names and number for digital pins\n"));
       return -1;
@@ -434,6 +465,12 @@ void rtapi_app_exit(void)
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    _("MOTION: rtapi_shmem_delete() failed, returned %d\n"), retval);
     }
+    if (volcomp_shmem_id >= 0) {
+	rtapi_shmem_delete(volcomp_shmem_id, mot_comp_id);
+    }
+    if (comp_shmem_id >= 0) {
+	rtapi_shmem_delete(comp_shmem_id, mot_comp_id);
+    }
     /* disconnect from HAL and RTAPI */
     retval = hal_exit(mot_comp_id);
     if (retval < 0) {
@@ -761,6 +798,7 @@ static int export_joint(int num, joint_hal_t * addr)
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->backlash_corr), mot_comp_id, "joint.%d.backlash-corr", num)) != 0) return retval;
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->backlash_filt), mot_comp_id, "joint.%d.backlash-filt", num)) != 0) return retval;
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->backlash_vel), mot_comp_id, "joint.%d.backlash-vel", num)) != 0) return retval;
+    if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->volcomp_corr), mot_comp_id, "joint.%d.volcomp-corr", num)) != 0) return retval;
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->f_error), mot_comp_id, "joint.%d.f-error", num)) != 0) return retval;
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->f_error_lim), mot_comp_id, "joint.%d.f-error-lim", num)) != 0) return retval;
     if ((retval = hal_pin_float_newf(HAL_OUT, &(addr->free_pos_cmd), mot_comp_id, "joint.%d.free-pos-cmd", num)) != 0) return retval;
@@ -805,7 +843,7 @@ static int export_extrajoint(int num, extrajoint_hal_t * addr)
 */
 static int init_comm_buffers(void)
 {
-    int joint_num, spindle_num, n;
+    int joint_num, spindle_num;
     emcmot_joint_t *joint;
     int retval;
 
@@ -831,6 +869,45 @@ static int init_comm_buffers(void)
 	return -1;
     }
 
+    /* the screw comp tables are sized by comp_entries=, which keeps
+       long tables from growing joints[] for every configuration */
+    comp_shmem_id = rtapi_shmem_new(COMP_SHMEM_KEY(key), mot_comp_id,
+	EMCMOT_COMP_TABLES_SIZE(comp_entries, num_joints));
+    if (comp_shmem_id < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: rtapi_shmem_new failed for %d comp entries, returned %d\n",
+	    comp_entries, comp_shmem_id);
+	return -1;
+    }
+    retval = rtapi_shmem_getptr(comp_shmem_id, (void **) &emcmotCompTables);
+    if (retval < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: rtapi_shmem_getptr failed, returned %d\n", retval);
+	return -1;
+    }
+    emcmotCompTables->entries_max = comp_entries;
+    emcmotCompTables->num_joints = num_joints;
+
+    /* the volumetric compensation grid is allocated only when asked for,
+       a big grid would otherwise cost every configuration its memory */
+    if (volcomp_nodes > 0) {
+	volcomp_shmem_id = rtapi_shmem_new(VOLCOMP_SHMEM_KEY(key), mot_comp_id,
+	    sizeof(emcmot_volcomp_t) + (size_t) volcomp_nodes * sizeof(emcmotVolComp->node[0]));
+	if (volcomp_shmem_id < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"MOTION: rtapi_shmem_new failed for %d volcomp nodes, returned %d\n",
+		volcomp_nodes, volcomp_shmem_id);
+	    return -1;
+	}
+	retval = rtapi_shmem_getptr(volcomp_shmem_id, (void **) &emcmotVolComp);
+	if (retval < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"MOTION: rtapi_shmem_getptr failed, returned %d\n", retval);
+	    return -1;
+	}
+	emcmotVolComp->nodes_max = volcomp_nodes;
+    }
+
     /* we'll reference emcmotStruct directly */
     emcmotCommand = &emcmotStruct->command;
     emcmotStatus = &emcmotStruct->status;
@@ -841,6 +918,9 @@ static int init_comm_buffers(void)
     /* init error struct */
     emcmotErrorInit(emcmotError);
 
+    HAL_TRACE_REGISTER(emcmot_trace_command, "motion.command");
+    HAL_TRACE_REGISTER(emcmot_trace_tp, "motion.tp-cycle");
+
     /*
      * DO NOT init the command struct!
      * This is a reader process and the writer (f.ex. milltask) may already
@@ -877,6 +957,8 @@ static int init_comm_buffers(void)
     emcmotConfig->numDIO = num_dio;
     emcmotConfig->numAIO = num_aio;
     emcmotConfig->numMiscError = num_misc_error;
+    emcmotConfig->volcompNodes = emcmotVolComp ? volcomp_nodes : 0;
+    emcmotConfig->compEntries = comp_entries;
 
     ZERO_EMC_POSE(emcmotStatus->carte_pos_cmd);
     ZERO_EMC_POSE(emcmotStatus->carte_pos_fb);
@@ -924,23 +1006,8 @@ static int init_comm_buffers(void)
 	joint->max_ferror = 1.0;
 	joint->backlash = 0.0;
 
-	joint->comp.entries = 0;
-	joint->comp.entry = &(joint->comp.array[0]);
-	/* the compensation code has -DBL_MAX at one end of the table
-	   and +DBL_MAX at the other so _all_ commanded positions are
-	   guaranteed to be covered by the table */
-	joint->comp.array[0].nominal = -DBL_MAX;
-	joint->comp.array[0].fwd_trim = 0.0;
-	joint->comp.array[0].rev_trim = 0.0;
-	joint->comp.array[0].fwd_slope = 0.0;
-	joint->comp.array[0].rev_slope = 0.0;
-	for ( n = 1 ; n < EMCMOT_COMP_SIZE+2 ; n++ ) {
-	    joint->comp.array[n].nominal = DBL_MAX;
-	    joint->comp.array[n].fwd_trim = 0.0;
-	    joint->comp.array[n].rev_trim = 0.0;
-	    joint->comp.array[n].fwd_slope = 0.0;
-	    joint->comp.array[n].rev_slope = 0.0;
-	}
+	emcmotCompInit(&joint->comp,
+	    EMCMOT_COMP_TABLE(emcmotCompTables, joint_num), comp_entries);
 
 	/* init joint flags */
 	joint->flag = 0;
@@ -954,6 +1021,7 @@ static int init_comm_buffers(void)
 	joint->backlash_corr = 0.0;
 	joint->backlash_filt = 0.0;
 	joint->backlash_vel = 0.0;
+	joint->volcomp_corr = 0.0;
 	joint->motor_pos_cmd = 0.0;
 	joint->motor_pos_fb = 0.0;
 	joint->pos_fb = 0.0;
@@ -1005,7 +1073,8 @@ static int init_threads(void)
     /* create HAL threads for each period */
     /* only create base thread if it is faster than servo thread */
     if (servo_base_ratio > 1) {
-	retval = hal_create_thread("base-thread", base_period_nsec, base_thread_fp);
+	retval = hal_create_thread_cpus("base-thread", base_period_nsec, base_thread_fp,
+	    base_thread_cpus);
 	if (retval < 0) {
 	    rtapi_print_msg(RTAPI_MSG_ERR,
 		"MOTION: failed to create %ld nsec base thread\n",
@@ -1013,13 +1082,21 @@ static int init_threads(void)
 	    return -1;
 	}
     }
-    retval = hal_create_thread("servo-thread", servo_period_nsec, 1);
+    retval = hal_create_thread_cpus("servo-thread", servo_period_nsec, 1,
+	servo_thread_cpus);
     if (retval < 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "MOTION: failed to create %ld nsec servo thread\n",
 	    servo_period_nsec);
 	return -1;
     }
+    retval = hal_thread_parallel("servo-thread", servo_thread_workers, NULL);
+    if (retval < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: failed to start %d servo thread helpers\n",
+	    servo_thread_workers);
+	return -1;
+    }
     /* export realtime functions that do the real work */
     retval = hal_export_funct("motion-controller", emcmotController, 0	/* arg
 	 */ , 1 /* uses_fp */ , 0 /* reentrant */ , mot_comp_id);
@@ -67,6 +67,7 @@ to another.
 #include "kinematics.h"
 #include "simple_tp.h"
 #include "rtapi_limits.h"
+#include "rtapi_msgring.h"
 #include <stdarg.h>
 #include "rtapi_bool.h"
 #include "state_tag.h"
@@ -145,6 +146,7 @@ extern "C" {
         EMCMOT_SETUP_ARC_BLENDS,
 
 	EMCMOT_SET_PROBE_ERR_INHIBIT,
+	EMCMOT_SET_JOINT_LIMIT_SAMPLES, /* points per move to check joint vel/acc at */
 	EMCMOT_ENABLE_WATCHDOG,         /* enable watchdog sound, parport */
 	EMCMOT_DISABLE_WATCHDOG,        /* enable watchdog sound, parport */
 	EMCMOT_JOG_CONT,	/* continuous jog */
@@ -167,6 +169,8 @@ extern "C" {
 	EMCMOT_UPDATE_JOINT_HOMING_PARAMS, /* updates some joint homing parameters */
 	EMCMOT_SET_JOINT_MOTOR_OFFSET,  /* set the offset between joint and motor */
 	EMCMOT_SET_JOINT_COMP,          /* set a compensation triplet for a joint (nominal, forw., rev.) */
+	EMCMOT_LOAD_JOINT_COMP,         /* replace joint comp table with the staged one */
+	EMCMOT_SET_VOLCOMP,             /* mode 1: use the volumetric comp grid, 0: stop using it */
 
         EMCMOT_SET_AXIS_POSITION_LIMITS, /* set the axis position +/- limits */
         EMCMOT_SET_AXIS_VEL_LIMIT,      /* set the max axis vel */
@@ -245,12 +249,14 @@ extern "C" {
 	unsigned char now, out, start, end;	/* these are related to synched AOUT/DOUT. now=whether now or synched, out = which gets set, start=start value, end=end value */
 	unsigned char mode;	/* used for turning overrides etc. on/off */
 	double comp_nominal, comp_forward, comp_reverse; /* compensation triplet, nominal, forward, reverse */
+	int comp_count;		/* number of triplets staged in the comp tables */
     unsigned char probe_type; /* ~1 = error if probe operation is unsuccessful (ngc default)
                                  |1 = suppress error, report in # instead
                                  ~2 = move until probe trips (ngc default)
                                  |2 = move until probe clears */
     int probe_jog_err_inhibit;  // setting to inhibit probe tripped while jogging error.
     int probe_home_err_inhibit;  // setting to inhibit probe tripped while homeing error.
+    int jointLimitSamples;	/* points per move at which the planner checks joint vel/acc */
     EmcPose tool_offset;        /* TLO */
     double  orientation;    /* angle for spindle orient */
     int state; /*spindle state  seems to just be 0 for off and 1 for on andypugh 2025-04-03*/
@@ -390,14 +396,60 @@ Suggestion: Split this in to an Error and a Status flag register..
     } emcmot_comp_entry_t;
 
 
-#define EMCMOT_COMP_SIZE 256
+#define EMCMOT_COMP_SIZE 256	/* default for motmod comp_entries= */
     typedef struct {
 	int entries;		/* number of entries in the array */
+	int entries_max;	/* room in the array, from comp_entries= */
 	emcmot_comp_entry_t *entry;  /* current entry in array */
-	emcmot_comp_entry_t array[EMCMOT_COMP_SIZE+2];
+	emcmot_comp_entry_t *array;  /* entries_max+2 entries in the
+				   comp tables shmem block */
 	/* +2 because array has -HUGE_VAL and +HUGE_VAL entries at the ends */
     } emcmot_comp_t;
 
+/* Screw compensation tables. They live in their own RTAPI shmem block
+   (key COMP_SHMEM_KEY(key)) sized by the motmod comp_entries= parameter,
+   so a config only pays for the table length it asks for. entry[]
+   starts with entries_max entries staged by usrmotLoadComp() for
+   EMCMOT_LOAD_JOINT_COMP, followed by the num_joints tables of
+   entries_max+2 entries each. */
+    typedef struct {
+	int entries_max;	/* room per table */
+	int num_joints;		/* number of tables after the staging area */
+	emcmot_comp_entry_t entry[];
+    } emcmot_comp_tables_t;
+
+#define EMCMOT_COMP_TABLES_SIZE(entries_max, joints) \
+    (sizeof(emcmot_comp_tables_t) + sizeof(emcmot_comp_entry_t) * \
+	((size_t) (entries_max) + (size_t) (joints) * ((entries_max) + 2)))
+#define EMCMOT_COMP_TABLE(tables, joint) \
+    (&(tables)->entry[(tables)->entries_max + \
+	(size_t) (joint) * ((tables)->entries_max + 2)])
+
+/* Volumetric compensation grid. It lives in its own RTAPI shmem block
+   (key VOLCOMP_SHMEM_KEY(key)) with room for the number of nodes given
+   by the motmod volcomp_nodes= parameter. User space fills it in while
+   compensation is off and then sends EMCMOT_SET_VOLCOMP. */
+    typedef struct {
+	int nodes_max;		/* room in node[], set by motion */
+	int nx, ny, nz;		/* nodes per axis, at least 2 each */
+	double origin[3];	/* machine X, Y, Z of node 0 */
+	double step[3];		/* node spacing per axis */
+	signed char joint_axis[EMCMOT_MAX_JOINTS]; /* correction component
+				   (0..2 = X..Z) added to each joint, -1 = none */
+	float node[][4];	/* X, Y, Z correction and one pad float so a
+				   node is 16 bytes; X index runs fastest */
+    } emcmot_volcomp_t;
+
+/* what the servo thread keeps between lookups: the 8 corners of the
+   cell the position was in last cycle, so a lookup only touches the
+   grid when the position moves into another cell */
+    typedef struct {
+	emcmot_volcomp_t *grid;	/* NULL when compensation is off */
+	double inv_step[3];	/* 1 / grid->step */
+	int cell[3];		/* cell of corner[], cell[0] = -1 for none */
+	float corner[8][3];	/* corner k is at cell + (k&1, k>>1&1, k>>2&1) */
+    } emcmot_volcomp_state_t;
+
 /* motion controller states */
 
     typedef enum {
@@ -461,6 +513,7 @@ Suggestion: Split this in to an Error and a Status flag register..
 	double backlash_corr;	/* correction for backlash */
 	double backlash_filt;	/* filtered backlash correction */
 	double backlash_vel;	/* backlash velocity variable */
+	double volcomp_corr;	/* volumetric compensation for this joint */
 	double motor_pos_cmd;	/* commanded position, with comp */
 	double motor_pos_fb;	/* position feedback, with comp */
 	double pos_fb;		/* position feedback, comp removed */
@@ -714,6 +767,12 @@ Suggestion: Split this in to an Error and a Status flag register..
         int numMiscError;     /* userdefined number of Misc Errors. default is 0.
                                   but can be altered at motmod insmod time */
 
+        int volcompNodes;       /* room in the volumetric comp grid, from the
+                                   motmod volcomp_nodes= parameter, 0 = none */
+
+        int compEntries;        /* room in each screw comp table, from the
+                                   motmod comp_entries= parameter */
+
 /*! \todo FIXME - all structure members beyond this point are in limbo */
 
 	double trajCycleTime;	/* the rate at which the trajectory loop
@@ -736,16 +795,17 @@ Suggestion: Split this in to an Error and a Status flag register..
         double maxFeedScale;
         int inhibit_probe_jog_error;
         int inhibit_probe_home_error;
+        int jointLimitSamples;	/* points per move at which the planner checks
+				   joint vel/acc through the inverse kinematics,
+				   0 = only the axis limits apply */
     } emcmot_config_t;
 
-/* error structure - A ring buffer used to pass formatted printf strings to usr space */
+/* error structure - A ring buffer used to pass printf formats and their
+   arguments, stashed by stashf, to usr space.  Any realtime thread can
+   put into it without locks; ring.lost counts errors that did not fit. */
     typedef struct emcmot_error_t {
-	unsigned char head;	/* flag count for mutex detect */
-	char error[EMCMOT_ERROR_NUM][EMCMOT_ERROR_LEN];
-	int start;		/* index of oldest error */
-	int end;		/* index of newest error */
-	int num;		/* number of items */
-	unsigned char tail;	/* flag count for mutex detect */
+	rtapi_msgring_t ring;
+	char slots[EMCMOT_ERROR_NUM][RTAPI_MSGRING_SLOT_SIZE(EMCMOT_ERROR_LEN)];
     } emcmot_error_t;
 
 
@@ -769,6 +829,16 @@ typedef struct emcmot_internal_t {
     extern int emcmotErrorPutf(emcmot_error_t * errlog, const char *fmt, ...);
     extern int emcmotErrorGet(emcmot_error_t * errlog, char *error);
 
+/* screw compensation table functions */
+    extern void emcmotCompInit(emcmot_comp_t *comp, emcmot_comp_entry_t *array,
+	int entries_max);
+    extern int emcmotCompLoad(emcmot_comp_t *comp, const emcmot_comp_entry_t *src, int count);
+    extern emcmot_comp_entry_t *emcmotCompFind(emcmot_comp_t *comp, double pos);
+
+/* volumetric compensation functions */
+    extern int emcmotVolCompPrepare(emcmot_volcomp_state_t *vc, emcmot_volcomp_t *grid);
+    extern void emcmotVolCompEval(emcmot_volcomp_state_t *vc, const double pos[3], double corr[3]);
+
 #define GET_JOINT_ACTIVE_FLAG(joint) ((joint)->flag & EMCMOT_JOINT_ACTIVE_BIT ? 1 : 0)
 #define GET_JOINT_INPOS_FLAG(joint) ((joint)->flag & EMCMOT_JOINT_INPOS_BIT ? 1 : 0)
 
@@ -0,0 +1,145 @@
+/********************************************************************
+* Description: screwcomp_bench.c
+*   Benchmark for the screw compensation table code in emcmotutil.c.
+*
+*   Builds a table of 10000 entries and reports the time to
+*   load it entry by entry (as EMCMOT_SET_JOINT_COMP does) and in one
+*   go (EMCMOT_LOAD_JOINT_COMP), and the cost of one table lookup per
+*   servo cycle for smooth motion and for random jumps.
+*
+*     screwcomp-bench [entries]
+*
+* Author:
+* License: GPL Version 2
+* System: Linux
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+#include <time.h>
+#include "motion.h"
+
+static emcmot_comp_t comp;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* the per-entry path of EMCMOT_SET_JOINT_COMP in command.c */
+static void append_entry(emcmot_comp_t *c, const emcmot_comp_entry_t *src)
+{
+    emcmot_comp_entry_t *e = &c->array[c->entries];
+    double d;
+
+    e[1].nominal = src->nominal;
+    e[1].fwd_trim = src->fwd_trim;
+    e[1].rev_trim = src->rev_trim;
+    if (e[0].nominal != -DBL_MAX) {
+	d = e[1].nominal - e[0].nominal;
+	e[0].fwd_slope = (e[1].fwd_trim - e[0].fwd_trim) / d;
+	e[0].rev_slope = (e[1].rev_trim - e[0].rev_trim) / d;
+    } else {
+	e[0].fwd_trim = e[1].fwd_trim;
+	e[0].rev_trim = e[1].rev_trim;
+    }
+    c->entries++;
+}
+
+/* the lookup compute_screw_comp() used before, walking one entry at a time */
+static emcmot_comp_entry_t *walk_entry(emcmot_comp_t *c, double pos)
+{
+    while (pos < c->entry->nominal) {
+	c->entry--;
+    }
+    while (pos >= (c->entry + 1)->nominal) {
+	c->entry++;
+    }
+    return c->entry;
+}
+
+static double lookup_ns(int walk, const double *pos, int count)
+{
+    volatile double sum = 0;
+    double t0;
+    int n;
+
+    comp.entry = &comp.array[0];
+    t0 = now_ns();
+    for (n = 0; n < count; n++) {
+	comp.entry = walk ? walk_entry(&comp, pos[n]) : emcmotCompFind(&comp, pos[n]);
+	sum += comp.entry->fwd_trim;
+    }
+    return (now_ns() - t0) / count;
+}
+
+int main(int argc, char **argv)
+{
+    int entries = argc > 1 ? atoi(argv[1]) : 10000;
+    int cycles = 1000000;
+    emcmot_comp_entry_t *upload, *array;
+    double *smooth, *jumps;
+    double t0, t_append, t_load;
+    int n;
+
+    if (entries < 2) {
+	fprintf(stderr, "usage: %s [entries, at least 2]\n", argv[0]);
+	return 1;
+    }
+    /* the table as motion keeps it in the comp tables shmem block */
+    upload = malloc(entries * sizeof(*upload));
+    array = malloc((entries + 2) * sizeof(*array));
+    if (!upload || !array) {
+	fprintf(stderr, "out of memory\n");
+	return 1;
+    }
+
+    /* 1 mm spacing with a periodic pitch error */
+    for (n = 0; n < entries; n++) {
+	upload[n].nominal = n;
+	upload[n].fwd_trim = 0.01 * sin(n * 0.1) + 0.002;
+	upload[n].rev_trim = 0.01 * sin(n * 0.1) - 0.002;
+    }
+
+    emcmotCompInit(&comp, array, entries);
+    t0 = now_ns();
+    for (n = 0; n < entries; n++) {
+	append_entry(&comp, &upload[n]);
+    }
+    t_append = now_ns() - t0;
+
+    emcmotCompInit(&comp, array, entries);
+    t0 = now_ns();
+    emcmotCompLoad(&comp, upload, entries);
+    t_load = now_ns() - t0;
+
+    printf("entries:               %d\n", entries);
+    printf("append one by one:     %.1f us (plus one servo cycle handshake "
+	"per entry)\n", t_append * 1e-3);
+    printf("bulk load:             %.1f us (one command)\n", t_load * 1e-3);
+
+    /* 10 m/min at 1 kHz servo rate, back and forth over the table */
+    smooth = malloc(cycles * sizeof(double));
+    jumps = malloc(cycles * sizeof(double));
+    if (!smooth || !jumps) {
+	fprintf(stderr, "out of memory\n");
+	return 1;
+    }
+    for (n = 0; n < cycles; n++) {
+	smooth[n] = (entries - 1) * 0.5 * (1.0 - cos(n * 0.1667 * 2.0 / (entries - 1)));
+	jumps[n] = (entries - 1) * (double) rand() / RAND_MAX;
+    }
+    printf("lookup, smooth motion: walk %.1f ns  find %.1f ns\n",
+	lookup_ns(1, smooth, cycles), lookup_ns(0, smooth, cycles));
+    printf("lookup, random jumps:  walk %.1f ns  find %.1f ns\n",
+	lookup_ns(1, jumps, cycles / 100), lookup_ns(0, jumps, cycles / 100));
+    free(smooth);
+    free(jumps);
+    free(upload);
+    free(array);
+    return 0;
+}
@@ -16,6 +16,12 @@
 #include "emc/linuxcnc.h"     	/* LINELEN definition */
 #include <stdlib.h>		/* exit() */
 #include <sys/stat.h>
+#include <sys/mman.h>		/* mmap() */
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <ctype.h>		/* toupper() */
+#include <math.h>		/* isfinite() */
 #include <string.h>		/* memcpy() */
 #include <float.h>		/* DBL_MIN */
 #include "motion.h"		/* emcmot_status_t,CMD */
@@ -43,7 +49,10 @@ static emcmot_status_t *emcmotStatus = 0;
 static emcmot_config_t *emcmotConfig = 0;
 static emcmot_internal_t *emcmotInternal = 0;
 static emcmot_error_t *emcmotError = 0;
+static unsigned emcmotErrorLost = 0;	/* ring.lost already reported */
 static emcmot_struct_t *emcmotStruct = 0;
+static emcmot_volcomp_t *emcmotVolComp = 0;
+static emcmot_comp_tables_t *emcmotCompTables = 0;
 
 /* usrmotIniLoad() loads params (SHMEM_KEY, COMM_TIMEOUT)
    from named INI file */
@@ -206,7 +215,14 @@ int usrmotReadEmcmotError(char *e)
 
     /* returns 0 if something, -1 if not */
     int result = emcmotErrorGet(emcmotError, data);
-    if(result < 0) return result;
+    if(result < 0) {
+	/* once the queue is drained, say if errors were dropped */
+	unsigned lost = rtapi_msgring_lost(&emcmotError->ring);
+	if(lost == emcmotErrorLost) return result;
+	snprintf(e, EMCMOT_ERROR_LEN, "%u motion errors lost", lost - emcmotErrorLost);
+	emcmotErrorLost = lost;
+	return 0;
+    }
 
     struct dbuf_iter di;
     dbuf_iter_init(&di, &d);
@@ -558,6 +574,8 @@ void usrmotPrintEmcmotStatus(emcmot_status_t *s, int which)
 
 static int module_id;
 static int shmem_id;
+static int volcomp_shmem_id = -1;
+static int comp_shmem_id = -1;
 
 int usrmotInit(const char *modname)
 {
@@ -591,6 +609,7 @@ int usrmotInit(const char *modname)
     emcmotInternal = &(emcmotStruct->internal);
     emcmotConfig = &(emcmotStruct->config);
     emcmotError = &(emcmotStruct->error);
+    emcmotErrorLost = rtapi_msgring_lost(&emcmotError->ring);
 
     inited = 1;
 
@@ -600,11 +619,21 @@ int usrmotInit(const char *modname)
 int usrmotExit(void)
 {
     if (NULL != emcmotStruct) {
+	if (volcomp_shmem_id >= 0) {
+	    rtapi_shmem_delete(volcomp_shmem_id, module_id);
+	    volcomp_shmem_id = -1;
+	}
+	if (comp_shmem_id >= 0) {
+	    rtapi_shmem_delete(comp_shmem_id, module_id);
+	    comp_shmem_id = -1;
+	}
 	rtapi_shmem_delete(shmem_id, module_id);
 	rtapi_exit(module_id);
     }
 
     emcmotStruct = 0;
+    emcmotVolComp = 0;
+    emcmotCompTables = 0;
     emcmotCommand = 0;
     emcmotStatus = 0;
     emcmotError = 0;
@@ -625,13 +654,16 @@ int usrmotExit(void)
    However if type != 0, it expects nominal, forward_trim & reverse_trim
 	(where forward_trim = nominal - forward
 	       reverse_trim = nominal - reverse)
+   The whole table is staged in the comp tables shmem block and handed to
+   motion with a single EMCMOT_LOAD_JOINT_COMP command.
 */
 int usrmotLoadComp(int joint, const char *file, int type)
 {
     FILE *fp;
     char buffer[LINELEN];
     double nom, fwd, rev;
-    int ret = 0;
+    int count = 0;
+    emcmot_comp_entry_t *entry;
     emcmot_command_t emcmotCommand;
 
     /* check joint range */
@@ -640,6 +672,23 @@ int usrmotLoadComp(int joint, const char *file, int type)
 	return -1;
     }
 
+    if (0 == emcmotStruct) {
+	fprintf(stderr, "can't connect to shared memory\n");
+	return -1;
+    }
+
+    if (0 == emcmotCompTables) {
+	comp_shmem_id = rtapi_shmem_new(COMP_SHMEM_KEY(SHMEM_KEY), module_id,
+	    EMCMOT_COMP_TABLES_SIZE(emcmotConfig->compEntries, emcmotConfig->numJoints));
+	if (comp_shmem_id < 0 ||
+	    rtapi_shmem_getptr(comp_shmem_id, (void **) &emcmotCompTables) < 0) {
+	    fprintf(stderr, "can't connect to compensation shared memory\n");
+	    comp_shmem_id = -1;
+	    emcmotCompTables = 0;
+	    return -1;
+	}
+    }
+
     /* open input comp file */
     if (NULL == (fp = fopen(file, "r"))) {
 	fprintf(stderr, "can't open compensation file %s\n", file);
@@ -652,33 +701,177 @@ int usrmotLoadComp(int joint, const char *file, int type)
 	}
 	if (3 != sscanf(buffer, "%lf %lf %lf", &nom, &fwd, &rev)) {
 	    break;
+	}
+	// got a triplet
+	if (count >= emcmotCompTables->entries_max) {
+	    fprintf(stderr, "compensation file %s has more than %d entries, "
+		"load motmod with a larger comp_entries=\n",
+		file, emcmotCompTables->entries_max);
+	    fclose(fp);
+	    return -1;
+	}
+	entry = &emcmotCompTables->entry[count++];
+	entry->nominal = nom;
+	if (type == 0) {
+	    /* expecting nominal-forward-reverse triplets, e.g.,
+		0.000000 0.000000 -0.001279
+		0.100000 0.098742  0.051632
+		0.200000 0.171529  0.194216 */
+	    entry->fwd_trim = nom - fwd; //convert to diffs
+	    entry->rev_trim = nom - rev; //convert to diffs
 	} else {
-	    // got a triplet
-	    if (type == 0) {
-		/* expecting nominal-forward-reverse triplets, e.g.,
-		    0.000000 0.000000 -0.001279
-		    0.100000 0.098742  0.051632
-		    0.200000 0.171529  0.194216 */
-    		emcmotCommand.comp_nominal = nom;
-    		emcmotCommand.comp_forward = nom - fwd; //convert to diffs
-    		emcmotCommand.comp_reverse = nom - rev; //convert to diffs
-	    } else {
-		/* expecting nominal-forw_trim-rev_trim triplets */
-    		emcmotCommand.comp_nominal = nom;
-    		emcmotCommand.comp_forward = fwd;
-    		emcmotCommand.comp_reverse = rev;
-	    }
-	    emcmotCommand.joint = joint;
-	    emcmotCommand.command = EMCMOT_SET_JOINT_COMP;
-	    ret |= usrmotWriteEmcmotCommand(&emcmotCommand);
+	    /* expecting nominal-forw_trim-rev_trim triplets */
+	    entry->fwd_trim = fwd;
+	    entry->rev_trim = rev;
 	}
     }
     fclose(fp);
 
-    return ret;
+    emcmotCommand.joint = joint;
+    emcmotCommand.comp_count = count;
+    emcmotCommand.command = EMCMOT_LOAD_JOINT_COMP;
+    return usrmotWriteEmcmotCommand(&emcmotCommand);
 }
 
 
+/* header of a volumetric compensation grid file, followed by
+   nx * ny * nz nodes of X, Y, Z correction as 32 bit floats, X index
+   running fastest. All values are little endian. */
+#define VOLCOMP_MAGIC "LCNCVCMP"
+#define VOLCOMP_VERSION 1
+typedef struct {
+    char magic[8];		/* VOLCOMP_MAGIC, not terminated */
+    uint32_t version;		/* VOLCOMP_VERSION */
+    uint32_t nx, ny, nz;	/* nodes per axis */
+    uint32_t reserved[2];	/* zero */
+    double origin[3];		/* machine X, Y, Z of the first node */
+    double step[3];		/* node spacing per axis */
+} volcomp_file_header_t;
+
+int usrmotLoadVolComp(const char *file, const char *axes)
+{
+    emcmot_command_t emcmotCommand;
+    volcomp_file_header_t hdr;
+    struct stat st;
+    const float *data;
+    void *map;
+    size_t nodes, n;
+    int fd, joint, retval;
+
+    if (0 == emcmotStruct) {
+	fprintf(stderr, "can't connect to shared memory\n");
+	return -1;
+    }
+    if (emcmotConfig->volcompNodes <= 0) {
+	fprintf(stderr, "no room for volumetric compensation, "
+	    "load motmod with volcomp_nodes=\n");
+	return -1;
+    }
+    if (0 == emcmotVolComp) {
+	volcomp_shmem_id = rtapi_shmem_new(VOLCOMP_SHMEM_KEY(SHMEM_KEY), module_id,
+	    sizeof(emcmot_volcomp_t) +
+	    (size_t) emcmotConfig->volcompNodes * sizeof(emcmotVolComp->node[0]));
+	if (volcomp_shmem_id < 0 ||
+	    rtapi_shmem_getptr(volcomp_shmem_id, (void **) &emcmotVolComp) < 0) {
+	    fprintf(stderr, "can't connect to volumetric compensation shared memory\n");
+	    volcomp_shmem_id = -1;
+	    emcmotVolComp = 0;
+	    return -1;
+	}
+    }
+
+    /* the grid can be large, map it instead of reading it */
+    if ((fd = open(file, O_RDONLY)) < 0 || fstat(fd, &st) < 0) {
+	fprintf(stderr, "can't open volumetric compensation file %s\n", file);
+	if (fd >= 0) {
+	    close(fd);
+	}
+	return -1;
+    }
+    if ((size_t) st.st_size < sizeof(hdr)) {
+	fprintf(stderr, "%s is not a volumetric compensation file\n", file);
+	close(fd);
+	return -1;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+	fprintf(stderr, "can't map volumetric compensation file %s\n", file);
+	return -1;
+    }
+    memcpy(&hdr, map, sizeof(hdr));
+    data = (const float *) ((const char *) map + sizeof(hdr));
+    nodes = (size_t) hdr.nx * hdr.ny * hdr.nz;
+    retval = -1;
+    if (memcmp(hdr.magic, VOLCOMP_MAGIC, sizeof(hdr.magic)) != 0 ||
+	hdr.version != VOLCOMP_VERSION) {
+	fprintf(stderr, "%s is not a version %d volumetric compensation file\n",
+	    file, VOLCOMP_VERSION);
+	goto out;
+    }
+    if (hdr.nx < 2 || hdr.ny < 2 || hdr.nz < 2 ||
+	hdr.nx > (uint32_t) emcmotConfig->volcompNodes ||
+	hdr.ny > (uint32_t) emcmotConfig->volcompNodes ||
+	hdr.nz > (uint32_t) emcmotConfig->volcompNodes ||
+	nodes > (size_t) emcmotConfig->volcompNodes) {
+	fprintf(stderr, "%s: a %ux%ux%u grid does not fit in %d nodes "
+	    "(motmod volcomp_nodes=)\n", file, hdr.nx, hdr.ny, hdr.nz,
+	    emcmotConfig->volcompNodes);
+	goto out;
+    }
+    if ((size_t) st.st_size != sizeof(hdr) + nodes * 3 * sizeof(float)) {
+	fprintf(stderr, "%s: file size does not match a %ux%ux%u grid\n",
+	    file, hdr.nx, hdr.ny, hdr.nz);
+	goto out;
+    }
+    for (n = 0; n < 3; n++) {
+	if (!(hdr.step[n] > 0.0) || !isfinite(hdr.step[n]) || !isfinite(hdr.origin[n])) {
+	    fprintf(stderr, "%s: bad grid origin or spacing\n", file);
+	    goto out;
+	}
+    }
+    for (n = 0; n < nodes * 3; n++) {
+	if (!isfinite(data[n])) {
+	    fprintf(stderr, "%s: node %zu is not a number\n", file, n / 3);
+	    goto out;
+	}
+    }
+
+    /* motion must not look at the grid while it is rewritten */
+    emcmotCommand.command = EMCMOT_SET_VOLCOMP;
+    emcmotCommand.mode = 0;
+    if (usrmotWriteEmcmotCommand(&emcmotCommand) != 0) {
+	goto out;
+    }
+    emcmotVolComp->nx = hdr.nx;
+    emcmotVolComp->ny = hdr.ny;
+    emcmotVolComp->nz = hdr.nz;
+    for (n = 0; n < 3; n++) {
+	emcmotVolComp->origin[n] = hdr.origin[n];
+	emcmotVolComp->step[n] = hdr.step[n];
+    }
+    /* one letter per joint, X, Y or Z, anything else for none */
+    for (joint = 0; joint < EMCMOT_MAX_JOINTS; joint++) {
+	static const char letters[] = "XYZ";
+	const char *c = (axes && joint < (int) strlen(axes)) ?
+	    strchr(letters, toupper(axes[joint])) : NULL;
+	emcmotVolComp->joint_axis[joint] = (c && *c) ? c - letters : -1;
+    }
+    for (n = 0; n < nodes; n++) {
+	emcmotVolComp->node[n][0] = data[n * 3];
+	emcmotVolComp->node[n][1] = data[n * 3 + 1];
+	emcmotVolComp->node[n][2] = data[n * 3 + 2];
+	emcmotVolComp->node[n][3] = 0.0;
+    }
+    emcmotCommand.command = EMCMOT_SET_VOLCOMP;
+    emcmotCommand.mode = 1;
+    retval = usrmotWriteEmcmotCommand(&emcmotCommand);
+
+out:
+    munmap(map, st.st_size);
+    return retval;
+}
+
 int usrmotPrintComp(int /*joint*/)
 {
 /* FIXME-AJ: comp isn't in shmem atm
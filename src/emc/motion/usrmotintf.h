@@ -75,6 +75,11 @@ extern "C" {
 /* usrmotLoadComp() loads the compensation data in file into the joint */
     extern int usrmotLoadComp(int joint, const char *file, int type);
 
+/* usrmotLoadVolComp() loads the volumetric compensation grid in file,
+   axes has one letter (X, Y, Z, '-' for none) per joint telling which
+   correction component is added to it */
+    extern int usrmotLoadVolComp(const char *file, const char *axes);
+
 /* usrmotPrintComp() prints the joint compensation data for the specified joint */
     extern int usrmotPrintComp(int joint);
 
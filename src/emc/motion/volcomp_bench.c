@@ -0,0 +1,136 @@
+/********************************************************************
+* Description: volcomp_bench.c
+*   Benchmark for the volumetric compensation lookup in emcmotutil.c.
+*
+*   Builds grids of n x n x n nodes over a 2000 x 1000 x 500 mm work
+*   volume and reports the cost of one lookup per servo cycle for
+*   smooth motion (10 m/min at 1 kHz along a space diagonal) and for
+*   random jumps, which miss the cached cell every time.
+*
+*     volcomp-bench [nodes-per-axis ...]
+*
+* Author:
+* License: GPL Version 2
+* System: Linux
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "motion.h"
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static const double size[3] = { 2000.0, 1000.0, 500.0 };
+
+static double lookup_ns(emcmot_volcomp_state_t *vc, const double (*pos)[3], int count)
+{
+    volatile double sum = 0;
+    double corr[3], t0;
+    int n;
+
+    vc->cell[0] = -1;
+    t0 = now_ns();
+    for (n = 0; n < count; n++) {
+	emcmotVolCompEval(vc, pos[n], corr);
+	sum += corr[0];
+    }
+    return (now_ns() - t0) / count;
+}
+
+static int run(int nodes, const double (*smooth)[3], const double (*jumps)[3], int cycles)
+{
+    emcmot_volcomp_state_t vc;
+    emcmot_volcomp_t *grid;
+    size_t count = (size_t) nodes * nodes * nodes;
+    size_t bytes = sizeof(*grid) + count * sizeof(grid->node[0]);
+    int i, j, k, n;
+    float *node;
+
+    grid = malloc(bytes);
+    if (!grid) {
+	fprintf(stderr, "out of memory for %d^3 nodes\n", nodes);
+	return -1;
+    }
+    grid->nodes_max = count;
+    grid->nx = grid->ny = grid->nz = nodes;
+    for (n = 0; n < 3; n++) {
+	grid->origin[n] = 0.0;
+	grid->step[n] = size[n] / (nodes - 1);
+    }
+    for (n = 0; n < EMCMOT_MAX_JOINTS; n++) {
+	grid->joint_axis[n] = n < 3 ? n : -1;
+    }
+    /* a few tens of microns of smooth squareness and sag error */
+    for (k = 0; k < nodes; k++) {
+	for (j = 0; j < nodes; j++) {
+	    for (i = 0; i < nodes; i++) {
+		node = grid->node[((size_t) k * nodes + j) * nodes + i];
+		node[0] = 2e-5 * j * grid->step[1];
+		node[1] = 1e-5 * k * grid->step[2];
+		node[2] = -0.03 * sin(M_PI * i / (nodes - 1));
+		node[3] = 0.0;
+	    }
+	}
+    }
+    if (emcmotVolCompPrepare(&vc, grid) != 0) {
+	fprintf(stderr, "grid rejected\n");
+	free(grid);
+	return -1;
+    }
+    printf("%4d^3 nodes %9.1f MB   smooth %6.1f ns   random %6.1f ns\n",
+	nodes, bytes / 1e6, lookup_ns(&vc, smooth, cycles),
+	lookup_ns(&vc, jumps, cycles / 10));
+    free(grid);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const int sizes[] = { 10, 25, 50, 100, 200 };
+    int cycles = 1000000;
+    double (*smooth)[3], (*jumps)[3];
+    double s, len;
+    int n, k, ret = 0;
+
+    smooth = malloc(cycles * sizeof(*smooth));
+    jumps = malloc(cycles * sizeof(*jumps));
+    if (!smooth || !jumps) {
+	fprintf(stderr, "out of memory\n");
+	return 1;
+    }
+    /* back and forth along the diagonal, 10 m/min at a 1 kHz servo rate */
+    len = sqrt(size[0] * size[0] + size[1] * size[1] + size[2] * size[2]);
+    for (n = 0; n < cycles; n++) {
+	s = 0.5 * (1.0 - cos(n * 0.1667 * 2.0 / len));
+	for (k = 0; k < 3; k++) {
+	    smooth[n][k] = s * size[k];
+	    jumps[n][k] = size[k] * (double) rand() / RAND_MAX;
+	}
+    }
+
+    if (argc > 1) {
+	for (n = 1; n < argc && ret == 0; n++) {
+	    k = atoi(argv[n]);
+	    if (k < 2) {
+		fprintf(stderr, "usage: %s [nodes-per-axis (>= 2) ...]\n", argv[0]);
+		ret = -1;
+	    } else {
+		ret = run(k, (const double (*)[3]) smooth, (const double (*)[3]) jumps, cycles);
+	    }
+	}
+    } else {
+	for (n = 0; n < (int) (sizeof(sizes) / sizeof(sizes[0])) && ret == 0; n++) {
+	    ret = run(sizes[n], (const double (*)[3]) smooth, (const double (*)[3]) jumps, cycles);
+	}
+    }
+    free(smooth);
+    free(jumps);
+    return ret ? 1 : 0;
+}
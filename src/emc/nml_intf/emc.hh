@@ -377,6 +377,7 @@ extern int emcTrajSetTermCond(int cond, double tolerance);
 extern int emcTrajSetSpindleSync(int spindle, double feed_per_revolution, bool wait_for_index);
 extern int emcTrajSetOffset(const EmcPose& tool_offset);
 extern int emcTrajSetHome(const EmcPose& home);
+extern int emcTrajLoadVolComp(const char *file, const char *axes);
 extern int emcTrajClearProbeTrippedFlag();
 extern int emcTrajProbe(const EmcPose& pos, int type, double vel,
                         double ini_maxvel, double acc, double ini_maxjerk, unsigned char probe_type);
@@ -454,6 +455,7 @@ int emcSetupArcBlends(int arcBlendEnable,
         double arcBlendRampFreq,
         double arcBlendTangentKinkRatio);
 int emcSetProbeErrorInhibit(int j_inhibit, int h_inhibit);
+int emcSetJointLimitSamples(int samples);
 int emcGetExternalOffsetApplied(void);
 EmcPose emcGetExternalOffsets(void);
 
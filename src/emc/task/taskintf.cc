@@ -919,6 +919,11 @@ int emcJointLoadComp(int joint, const char *file, int type)
     return usrmotLoadComp(joint, file, type);
 }
 
+int emcTrajLoadVolComp(const char *file, const char *axes)
+{
+    return usrmotLoadVolComp(file, axes);
+}
+
 static emcmot_config_t emcmotConfig;
 int get_emcmot_internal_info = 0;  // debug usage
 
@@ -2173,6 +2178,12 @@ int emcSetProbeErrorInhibit(int j_inhibit, int h_inhibit) {
     return usrmotWriteEmcmotCommand(&emcmotCommand);
 }
 
+int emcSetJointLimitSamples(int samples) {
+    emcmotCommand.command = EMCMOT_SET_JOINT_LIMIT_SAMPLES;
+    emcmotCommand.jointLimitSamples = samples;
+    return usrmotWriteEmcmotCommand(&emcmotCommand);
+}
+
 int emcGetExternalOffsetApplied(void) {
     return emcmotStatus.external_offsets_applied;
 }
@@ -1878,3 +1878,44 @@ double pmCircleEffectiveMinRadius(PmCircle const * circle)
     return effective_radius;
 }
 
+/**
+ * Find the largest path velocity and acceleration of a segment that keep
+ * each joint within its own limits.
+ * For joint j, q_s[j] is the largest |dq/ds| and q_ss[j] the largest
+ * |d^2q/ds^2| along the segment, where s is the path length the planner
+ * uses. The joint then moves at q_s * v and accelerates at up to
+ * q_s * a + q_ss * v^2. As with the normal acceleration on arcs, the v^2
+ * term may use only part of the joint's acceleration, the rest is left for
+ * speeding up and slowing down.
+ * v_max and a_max are lowered as needed; joints with a zero limit are not
+ * checked.
+ */
+int findJointLimitedVelAcc(double const * const q_s,
+        double const * const q_ss,
+        double const * const joint_vel,
+        double const * const joint_acc,
+        int joints,
+        double * const v_max,
+        double * const a_max)
+{
+    double v = *v_max;
+    double a = *a_max;
+    int j;
+
+    for (j = 0; j < joints; ++j) {
+        if (joint_vel[j] > 0.0 && q_s[j] > TP_POS_EPSILON) {
+            v = fmin(v, joint_vel[j] / q_s[j]);
+        }
+        if (joint_acc[j] > 0.0 && q_ss[j] > TP_POS_EPSILON) {
+            v = fmin(v, pmSqrt((1.0 - BLEND_ACC_RATIO_TANGENTIAL) * joint_acc[j] / q_ss[j]));
+        }
+    }
+    for (j = 0; j < joints; ++j) {
+        if (joint_acc[j] > 0.0 && q_s[j] > TP_POS_EPSILON) {
+            a = fmin(a, (joint_acc[j] - q_ss[j] * pmSq(v)) / q_s[j]);
+        }
+    }
+    *v_max = v;
+    *a_max = a;
+    return TP_ERR_OK;
+}
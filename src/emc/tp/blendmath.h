@@ -251,6 +251,14 @@ int pmCircleAngleFromProgress(PmCircle const * const circle,
         double * const angle);
 double pmCircleEffectiveMinRadius(const PmCircle *circle);
 
+int findJointLimitedVelAcc(double const * const q_s,
+        double const * const q_ss,
+        double const * const joint_vel,
+        double const * const joint_acc,
+        int joints,
+        double * const v_max,
+        double * const a_max);
+
 static inline double findVPeak(double a_t_max, double distance)
 {
     return pmSqrt(a_t_max * distance);
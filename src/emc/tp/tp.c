@@ -39,6 +39,7 @@
  */
 
 #include "tp_debug.h"
+#include "hal_trace.h"
 #include "sp_scurve.h"
 #include <stdio.h>
 // FIXME: turn off this feature, which causes blends between rapids to
@@ -78,6 +79,9 @@ static void(  *_SetRotaryUnlock)(int,int);
 static int (  *_GetRotaryIsUnlocked)(int);
 static double(*_axis_get_vel_limit)(int);
 static double(*_axis_get_acc_limit)(int);
+static int (  *_joint_pos)(EmcPose const *,double *,int);
+static double(*_joint_get_vel_limit)(int);
+static double(*_joint_get_acc_limit)(int);
 
 void tpMotFunctions(void(  *pDioWrite)(int,char)
                    ,void(  *pAioWrite)(int,double)
@@ -85,6 +89,9 @@ void tpMotFunctions(void(  *pDioWrite)(int,char)
                    ,int (  *pGetRotaryIsUnlocked)(int)
                    ,double(*paxis_get_vel_limit)(int)
                    ,double(*paxis_get_acc_limit)(int)
+                   ,int (  *pjoint_pos)(EmcPose const *,double *,int)
+                   ,double(*pjoint_get_vel_limit)(int)
+                   ,double(*pjoint_get_acc_limit)(int)
                    )
 {
     _DioWrite            = pDioWrite;
@@ -93,6 +100,9 @@ void tpMotFunctions(void(  *pDioWrite)(int,char)
     _GetRotaryIsUnlocked = pGetRotaryIsUnlocked;
     _axis_get_vel_limit  = paxis_get_vel_limit;
     _axis_get_acc_limit  = paxis_get_acc_limit;
+    _joint_pos           = pjoint_pos;
+    _joint_get_vel_limit = pjoint_get_vel_limit;
+    _joint_get_acc_limit = pjoint_get_acc_limit;
 }
 
 void tpMotData(emcmot_status_t *pstatus
@@ -216,6 +226,113 @@ STATIC int tpGetMachineVelBounds(PmCartesian  * const vel_bound) {
     return TP_ERR_OK;
 }
 
+/**
+ * Lower the velocity and acceleration limits of a new segment so that no
+ * joint exceeds its own limits.
+ * The axis limits bound the segment in Cartesian space only; with
+ * non-trivial kinematics a joint may have to move much faster than any
+ * axis. The segment is sampled at emcmotConfig->jointLimitSamples + 1
+ * evenly spaced points, each run through the inverse kinematics, and the
+ * joint motion per unit of path length (and its change) is estimated
+ * from the differences between neighbouring points. Peaks between the
+ * points are missed, so use enough of them for the longest moves.
+ * Spindle-synchronized segments keep their speed.
+ * The first point starts from the joints found for the end of the
+ * previous segment while it is still queued, the commanded joint
+ * positions otherwise; each following one from the point before it.
+ * Fails if some point has no inverse kinematics; the segment must not be
+ * queued then, since its joint limits are unknown.
+ */
+STATIC int tpCheckJointLimits(TP_STRUCT * const tp, TC_STRUCT * const tc)
+{
+    int samples = emcmotConfig->jointLimitSamples;
+    int joints = emcmotConfig->numJoints;
+
+    if (samples <= 0 || !_joint_pos
+            || emcmotConfig->kinType == KINEMATICS_IDENTITY
+            || tc->synchronized) {
+        return TP_ERR_NO_ACTION;
+    }
+
+    double q[3][EMCMOT_MAX_JOINTS];
+    double q_s[EMCMOT_MAX_JOINTS] = {0};
+    double q_ss[EMCMOT_MAX_JOINTS] = {0};
+    double joint_vel[EMCMOT_MAX_JOINTS];
+    double joint_acc[EMCMOT_MAX_JOINTS];
+    double h = tc->target / samples;
+    EmcPose pos, diff;
+    double dist;
+    int i, j, guess;
+
+    for (i = 0; i <= samples; ++i) {
+        double *cur = q[i % 3];
+        double const *prev = q[(i + 2) % 3];
+        double const *prev2 = q[(i + 1) % 3];
+
+        tc->progress = i < samples ? i * h : tc->target;
+        if (tcGetPosReal(tc, TC_GET_PROGRESS, &pos) != TP_ERR_OK) {
+            tc->progress = 0.0;
+            return TP_ERR_FAIL;
+        }
+        if (i > 0) {
+            for (j = 0; j < joints; ++j) {
+                cur[j] = prev[j];
+            }
+            guess = 1;
+        } else {
+            // the machine is only at the commanded joints when nothing
+            // is queued before this segment; the end of the previous one
+            // only has to be near, it is a starting guess
+            emcPoseSub(&pos, &tp->jointCheckPos, &diff);
+            emcPoseMagnitude(&diff, &dist);
+            guess = tp->jointCheckValid && tcqLen(&tp->queue) > 0
+                && dist < 1e-6;
+            for (j = 0; j < joints && guess; ++j) {
+                cur[j] = tp->jointCheckJoints[j];
+            }
+        }
+        if (_joint_pos(&pos, cur, guess) != 0) {
+            rtapi_print_msg(RTAPI_MSG_ERR,
+                    "joint limit check: no inverse kinematics %f from the start of the move\n",
+                    tc->progress);
+            tc->progress = 0.0;
+            return TP_ERR_FAIL;
+        }
+        for (j = 0; j < joints && i >= 1; ++j) {
+            q_s[j] = fmax(q_s[j], fabs(cur[j] - prev[j]) / h);
+        }
+        for (j = 0; j < joints && i >= 2; ++j) {
+            // iterative kinematics (genserkins) solve to about 1e-6, which
+            // would look like a lot of curvature on short segments
+            double d2 = fabs(cur[j] - 2.0 * prev[j] + prev2[j]) - 4e-6;
+            if (d2 > 0.0) {
+                q_ss[j] = fmax(q_ss[j], d2 / (h * h));
+            }
+        }
+    }
+    tc->progress = 0.0;
+    tp->jointCheckPos = pos;
+    for (j = 0; j < joints; ++j) {
+        tp->jointCheckJoints[j] = q[samples % 3][j];
+    }
+    tp->jointCheckValid = 1;
+
+    for (j = 0; j < joints; ++j) {
+        joint_vel[j] = _joint_get_vel_limit(j);
+        joint_acc[j] = _joint_get_acc_limit(j);
+    }
+    double v_max = tc->maxvel;
+    double a_max = tc->maxaccel;
+    findJointLimitedVelAcc(q_s, q_ss, joint_vel, joint_acc, joints, &v_max, &a_max);
+    if (v_max < tc->maxvel || a_max < tc->maxaccel) {
+        tp_debug_print("joint limits: maxvel %f -> %f, maxaccel %f -> %f\n",
+                tc->maxvel, v_max, tc->maxaccel, a_max);
+    }
+    tc->maxvel = v_max;
+    tc->maxaccel = a_max;
+    return TP_ERR_OK;
+}
+
 STATIC int tpGetMachineActiveLimit(double * const act_limit, PmCartesian const * const bounds) {
     if (!act_limit) {
         return TP_ERR_FAIL;
@@ -414,6 +531,10 @@ error:
 }
 #endif // }
 
+HAL_TRACE_EVENT(trace_segment);
+HAL_TRACE_EVENT(trace_blend);
+HAL_TRACE_EVENT(trace_split);
+
 int tpCreate(TP_STRUCT * const tp, int _queueSize,int id)
 {
     (void)id;
@@ -421,6 +542,10 @@ int tpCreate(TP_STRUCT * const tp, int _queueSize,int id)
         return TP_ERR_FAIL;
     }
 
+    HAL_TRACE_REGISTER(trace_segment, "tp.segment");
+    HAL_TRACE_REGISTER(trace_blend, "tp.blend");
+    HAL_TRACE_REGISTER(trace_split, "tp.split-cycle");
+
     if (_queueSize <= 0) {
         tp->queueSize = TP_DEFAULT_QUEUE_SIZE;
     } else {
@@ -478,6 +603,7 @@ int tpClear(TP_STRUCT * const tp)
     tcqInit(&tp->queue);
     tp->queueSize = 0;
     tp->goalPos = tp->currentPos;
+    tp->jointCheckValid = 0;
     // Clear out status ID's
     tp->nextId = 0;
     tp->execId = 0;
@@ -2162,6 +2288,9 @@ int tpAddLine(TP_STRUCT * const tp, EmcPose end, int canon_motion_type,
     }
     tc.nominal_length = tc.target;
     tcClampVelocityByLength(&tc);
+    if (tpCheckJointLimits(tp, &tc) == TP_ERR_FAIL) {
+        return TP_ERR_FAIL;
+    }
 
     // For linear move, set joint corresponding to a locking indexer axis
     tc.indexer_jnum = indexer_jnum;
@@ -2257,6 +2386,9 @@ int tpAddCircle(TP_STRUCT * const tp,
 
     //Reduce max velocity to match sample rate
     tcClampVelocityByLength(&tc);
+    if (tpCheckJointLimits(tp, &tc) == TP_ERR_FAIL) {
+        return TP_ERR_FAIL;
+    }
 
     // Apply acceleration and jerk limits for circular motion
     tcUpdateArcLimits(&tc);
@@ -3323,6 +3455,7 @@ STATIC tp_err_t tpActivateSegment(TP_STRUCT * const tp, TC_STRUCT * const tc) {
             tc->target);
 
     tc->active = 1;
+    HAL_TRACE_INSTANT(trace_segment, tc->id);
     //Do not change initial velocity here, since tangent blending already sets this up
     tp->motionType = tc->canon_motion_type;
     tc->blending_next = 0;
@@ -3742,6 +3875,7 @@ STATIC int tpHandleSplitCycle(TP_STRUCT * const tp, TC_STRUCT * const tc,
     tcGetPos(tc, &before);
 
     tp_debug_print("tc id %d splitting\n",tc->id);
+    HAL_TRACE_INSTANT(trace_split, tc->id);
     //Shortcut tc update by assuming we arrive at end
     tc->progress = tcGetTarget(tc,tp->reverse_run);
     //Get displacement from prev. position
@@ -3851,7 +3985,11 @@ STATIC int tpHandleRegularCycle(TP_STRUCT * const tp,
         nexttc->blend_vel = v_next;
     }
 
+    int was_blending = tc->blending_next;
     if (nexttc && tcIsBlending(tc)) {
+        if (!was_blending) {
+            HAL_TRACE_INSTANT(trace_blend, tc->id);
+        }
         tpDoParabolicBlending(tp, tc, nexttc);
     } else {
         //Update status for a normal step
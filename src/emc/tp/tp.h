@@ -81,6 +81,9 @@ void tpMotFunctions(void(*pDioWrite)(int,char)
                    ,int( *pGetRotaryUnlock)(int)
                    ,double(*paxis_get_vel_limit)(int)
                    ,double(*paxis_get_acc_limit)(int)
+                   ,int(  *pjoint_pos)(EmcPose const *,double *,int)
+                   ,double(*pjoint_get_vel_limit)(int)
+                   ,double(*pjoint_get_acc_limit)(int)
                    );
 
 void tpMotData(emcmot_status_t *
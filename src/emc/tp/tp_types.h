@@ -96,6 +96,11 @@ typedef struct {
 
     EmcPose currentPos;
     EmcPose goalPos;
+    /* end of the last move checked against the joint limits and its
+       joint positions, the starting guess for checking the next one */
+    EmcPose jointCheckPos;
+    double jointCheckJoints[EMCMOT_MAX_JOINTS];
+    int jointCheckValid;
 
     int queueSize;
     double cycleTime;
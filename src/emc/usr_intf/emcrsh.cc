@@ -17,11 +17,20 @@
 #define _REENTRANT
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <signal.h>
+#include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <getopt.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 #include "emcglb.h"		// EMC_NMLFILE, TRAJ_MAX_VELOCITY, etc.
 #include "inifile.hh"		// INIFILE
@@ -48,7 +57,7 @@
             Make sure to include the final slash (/).
   With -- -ini <INI file>, uses specified INI file instead of default emc.ini.
 
-  There are six commands supported, Where the commands set and get contain LinuxCNC
+  There are eight commands supported, Where the commands set and get contain LinuxCNC
   specific sub-commands based on the commands supported by linuxcncrsh, but where the
   usual prefix ( "emc_") is omitted. Commands and most parameters are not case sensitive.
   The exceptions are passwords, file paths and text strings.
@@ -89,6 +98,17 @@
   connection has control of the CNC (see enable sub-command below). This command
   has no parameters.
 
+  ==> Watch <==
+
+  The watch command takes the same parameters as get, and answers like get.
+  Afterwards the get is repeated periodically and its reply is sent again
+  whenever it changes.
+
+  ==> Unwatch <==
+
+  Unwatch with the parameters of a previous watch command removes that watch,
+  without parameters all watches of the connection are removed.
+
   ==> Help <==
 
   The help command will return help information in text format over the telnet
@@ -98,6 +118,12 @@
   successfully negotiated.
 
 
+  Commands may be sent without waiting for the reply to the previous one, they
+  are executed in order. A command line may start with a tag "@<word>", all
+  replies to that command then start with the same tag. A set command is
+  answered once LinuxCNC received or finished it (see wait_mode), the next
+  commands of that connection are executed after that.
+
   LinuxCNC sub-commands:
 
   echo on | off
@@ -401,7 +427,8 @@
 // EMC_STAT *emcStatus;
 
 typedef enum {
-  cmdHello, cmdSet, cmdGet, cmdQuit, cmdShutdown, cmdHelp, cmdUnknown} cmdType;
+  cmdHello, cmdSet, cmdGet, cmdQuit, cmdShutdown, cmdHelp, cmdWatch, cmdUnwatch,
+  cmdUnknown} cmdType;
 
 typedef enum {
   scEcho, scVerbose, scEnable, scConfig, scCommMode, scCommProt, scIniFile,
@@ -423,6 +450,12 @@ typedef enum {
   rtNoError, rtHandledNoError, rtStandardError, rtCustomError, rtCustomHandledError
   } cmdResponseType;
 
+typedef struct {
+  std::string args;             // get sub-command and parameters
+  std::string tag;              // tag of the watch command, may be empty
+  std::string last;             // last reply sent to the client
+} watchRecType;
+
 typedef struct {
   int cliSock;
   char hostName[80];
@@ -435,7 +468,20 @@ typedef struct {
   int commProt;
   char inBuf[256];
   char outBuf[4096];
-  char progName[PATH_MAX];} connectionRecType;
+  char progName[PATH_MAX];
+  char tag[32];                 // "@tag" of the command being answered
+  bool closing;                 // disconnect once outQueue is flushed
+  bool eof;                     // the client sent all its commands
+  std::string inQueue;          // received, not yet handled command lines
+  std::string outQueue;         // replies not yet written to cliSock
+  bool waiting;                 // a set command waits for task, see waitReplies()
+  EMC_WAIT_TYPE waitFor;        // ... until received or done
+  int waitSerial;               // serial number of the command sent to task
+  double waitStart;             // when it was sent, for the timeout
+  char waitCmd[32];             // set sub-command answered once it is over
+  char waitTag[sizeof(tag)];    // tag of the set command
+  std::string *capture;         // collects replies instead of outQueue
+  std::vector<watchRecType> watches;} connectionRecType;
 
 int port = 5007;
 int server_sockfd;
@@ -452,6 +498,11 @@ char serverName[24] = "EMCNETSVR\0";
 int sessions = 0;
 int maxSessions = -1;
 
+// set commands are answered once task received or finished them, the
+// connection that sent one stops handling its next commands until then.
+// shcom itself does not wait (emcWaitType is EMC_WAIT_NONE).
+EMC_WAIT_TYPE waitMode = EMC_WAIT_RECEIVED;
+
 const char *cmdTokens[] = {
   "ECHO", "VERBOSE", "ENABLE", "CONFIG", "COMM_MODE", "COMM_PROT", "INIFILE", "PLAT", "INI", "DEBUG",
   "WAIT_MODE", "WAIT", "TIMEOUT", "UPDATE", "ERROR", "OPERATOR_DISPLAY", "OPERATOR_TEXT",
@@ -467,7 +518,14 @@ const char *cmdTokens[] = {
   "PROBE_VALUE", "PROBE", "TELEOP_ENABLE", "KINEMATICS_TYPE", "OVERRIDE_LIMITS",
   "SPINDLE_OVERRIDE", "OPTIONAL_STOP", "SET_WAIT", ""};
 
-const char *commands[] = {"HELLO", "SET", "GET", "QUIT", "SHUTDOWN", "HELP", ""};
+const char *commands[] = {"HELLO", "SET", "GET", "QUIT", "SHUTDOWN", "HELP", "WATCH",
+  "UNWATCH", ""};
+
+// how often watched get commands are re-evaluated, in seconds
+#define WATCH_PERIOD 0.05
+// how often the status is checked while set commands wait for task
+#define WAIT_PERIOD_MIN 0.001
+#define WAIT_PERIOD_MAX 0.1
 
 struct option longopts[] = {
   {"help", 0, NULL, 'h'},
@@ -482,6 +540,33 @@ struct option longopts[] = {
 /* format string to outputbuffer (will be presented to user as result of command) */
 #define OUT(...) snprintf(context->outBuf, sizeof(context->outBuf), __VA_ARGS__)
 
+/* queue a reply for the client, it is written out by the main loop once the
+   socket is writable. Replies to a tagged command carry the same tag. */
+static void reply(connectionRecType *context, const char *fmt, ...)
+  __attribute__((format(printf, 2, 3)));
+static void reply(connectionRecType *context, const char *fmt, ...)
+{
+  char buf[8192];
+  va_list ap;
+  int len;
+
+  va_start(ap, fmt);
+  len = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (len < 0) return;
+  if (len >= (int)sizeof(buf)) len = sizeof(buf) - 1;
+
+  if (context->capture) {
+    context->capture->append(buf, len);
+    return;
+  }
+  if (context->tag[0]) {
+    context->outQueue += context->tag;
+    context->outQueue += ' ';
+  }
+  context->outQueue.append(buf, len);
+}
+
 
 static void thisQuit()
 {
@@ -761,11 +846,11 @@ static cmdResponseType setWaitMode(connectionRecType *context)
   switch (checkReceivedDoneNone(s)) {
     case -1: return rtStandardError;
     case 0: {
-      emcWaitType = EMC_WAIT_RECEIVED;
+      waitMode = EMC_WAIT_RECEIVED;
       break;
     }
     case 1: {
-      emcWaitType = EMC_WAIT_DONE;
+      waitMode = EMC_WAIT_DONE;
       break;
     }
     case 2: {
@@ -779,7 +864,7 @@ static cmdResponseType setWaitMode(connectionRecType *context)
 /* compatibility wrapper to deprecate set_wait command token - @todo remove at some point */
 static cmdResponseType setSetWait(connectionRecType *context)
 {
-  dprintf(context->cliSock, "WARNING: \"set_wait\" command is depreciated and will be removed in the future. Please use \"wait_mode\" instead.\n");
+  reply(context, "WARNING: \"set_wait\" command is depreciated and will be removed in the future. Please use \"wait_mode\" instead.\n");
   return setWaitMode(context);
 }
 
@@ -817,20 +902,22 @@ static cmdResponseType setEStop(connectionRecType * /*context*/)
     return rtNoError;
 }
 
-static cmdResponseType setWait(connectionRecType * /*context*/)
+// the reply is sent once the last command sent is received or done
+static cmdResponseType setWait(connectionRecType *context)
 {
   char *s = strtok(NULL, delims);
   switch (checkReceivedDoneNone(s)) {
     case -1: return rtStandardError;
     case 0:
-      if (emcCommandWaitReceived() != 0) return rtStandardError;
+      context->waitFor = EMC_WAIT_RECEIVED;
       break;
     case 1:
-      if (emcCommandWaitDone() != 0) return rtStandardError;
+      context->waitFor = EMC_WAIT_DONE;
       break;
     case 2: ;
     default: return rtStandardError;
     }
+  context->waiting = true;
   return rtNoError;
 }
 
@@ -1430,17 +1517,18 @@ int commandSet(connectionRecType *context)
 {
   cmdTokenType cmd;
   cmdResponseType ret = rtNoError;
+  int serial = emcCommandSerialNumber;
 
   // parse cmd token
   char *tokenStr = strtok(NULL, delims);
   if (!tokenStr) {
-    dprintf(context->cliSock, "SET NAK\r\n");
+    reply(context, "SET NAK\r\n");
     return -1;
   }
   strupr(tokenStr);
   cmd = lookupCommandToken(tokenStr);
   if ((cmd >= scIniFile) && (context->cliSock != enabledConn)) {
-    dprintf(context->cliSock, "SET %s NAK\r\n", tokenStr);
+    reply(context, "SET %s NAK\r\n", tokenStr);
     return -1;
   }
 
@@ -1449,7 +1537,7 @@ int commandSet(connectionRecType *context)
     //  sending a set command when the machine state is off. This condition is detected
     //  and appropriate error messages are generated, however erratic behavior has been
     //  seen when doing certain set commands when the Machine state is other than 'On
-    dprintf(context->cliSock, "SET %s NAK\r\n", tokenStr);
+    reply(context, "SET %s NAK\r\n", tokenStr);
     return -1;
   }
 
@@ -1534,8 +1622,20 @@ int commandSet(connectionRecType *context)
   switch (ret) {
 
     case rtNoError:
+      // a command went to task, answer from the main loop once it is over
+      if (!context->waiting && (emcCommandSerialNumber != serial)) {
+        context->waitFor = waitMode;
+        context->waiting = true;
+      }
+      if (context->waiting) {
+        context->waitSerial = emcCommandSerialNumber;
+        context->waitStart = etime();
+        snprintf(context->waitCmd, sizeof(context->waitCmd), "%s", tokenStr);
+        rtapi_strxcpy(context->waitTag, context->tag);
+        return -1;
+      }
       if (context->verbose) {
-        dprintf(context->cliSock, "SET %s ACK\r\n", tokenStr);
+        reply(context, "SET %s ACK\r\n", tokenStr);
       }
       return -1;
 
@@ -1544,12 +1644,12 @@ int commandSet(connectionRecType *context)
       break;
 
     case rtStandardError:
-      dprintf(context->cliSock, "SET %s NAK\r\n", tokenStr);
+      reply(context, "SET %s NAK\r\n", tokenStr);
       return -1;
 
     // Custom error response entered in buffer
     case rtCustomError:
-      dprintf(context->cliSock, "error: %s\r\n", context->outBuf);
+      reply(context, "error: %s\r\n", context->outBuf);
       return -1;
 
     // Custom error response handled, take no action
@@ -1611,7 +1711,7 @@ static cmdResponseType getDebug(connectionRecType *context)
 
 static cmdResponseType getWaitMode(connectionRecType *context)
 {
-  switch (emcWaitType) {
+  switch (waitMode) {
     case EMC_WAIT_RECEIVED: OUT("WAIT_MODE RECEIVED"); break;
     case EMC_WAIT_DONE: OUT("WAIT_MODE DONE"); break;
     default: return rtStandardError;
@@ -1622,7 +1722,7 @@ static cmdResponseType getWaitMode(connectionRecType *context)
 /* compatibility wrapper to deprecate set_wait command token  - @todo remove at some point */
 static cmdResponseType getSetWait(connectionRecType *context)
 {
-  dprintf(context->cliSock, "WARNING: \"set_wait\" command is depreciated and will be removed in the future. Please use \"wait_mode\" instead.\n");
+  reply(context, "WARNING: \"set_wait\" command is depreciated and will be removed in the future. Please use \"wait_mode\" instead.\n");
   return getWaitMode(context);
 }
 
@@ -2575,14 +2675,12 @@ int commandGet(connectionRecType *context)
 
   pch = strtok(NULL, delims);
   if (!pch) {
-    dprintf(context->cliSock, "GET NAK\r\n");
+    reply(context, "GET NAK\r\n");
     return -1;
   }
   if (emcUpdateType == EMC_UPDATE_AUTO) updateStatus();
   strupr(pch);
   cmd = lookupCommandToken(pch);
-  if (cmd > scIni)
-    if (emcUpdateType == EMC_UPDATE_AUTO) updateStatus();
   switch (cmd) {
     case scEcho: ret = getEcho(context); break;
     case scVerbose: ret = getVerbose(context); break;
@@ -2663,31 +2761,116 @@ int commandGet(connectionRecType *context)
     }
   switch (ret) {
     case rtNoError: // Standard ok response, just write value in buffer
-      dprintf(context->cliSock, "%s\r\n", context->outBuf);
+      reply(context, "%s\r\n", context->outBuf);
       break;
     case rtHandledNoError: // Custom ok response already handled, take no action
       break;
     case rtStandardError: // Standard error response
-      dprintf(context->cliSock, setCmdNakStr, pch);
+      reply(context, setCmdNakStr, pch);
       break;
     case rtCustomError: // Custom error response entered in buffer
-      dprintf(context->cliSock, "error: %s\r\n", context->outBuf);
+      reply(context, "error: %s\r\n", context->outBuf);
       break;  
     case rtCustomHandledError: ;// Custom error response handled, take no action
     }
-  return 0;
+  return ((ret == rtNoError) || (ret == rtHandledNoError)) ? 0 : -1;
 }
 
 int commandQuit(connectionRecType *context)
 {
   printf("Closing connection with %s\n", context->hostName);
+  context->closing = true;
   return -1;
 }
 
+int parseCommand(connectionRecType *context);
+
+// evaluate a watched get command, the reply is collected in *out
+static int evalWatch(connectionRecType *context, const watchRecType &w, std::string *out)
+{
+  int ret;
+
+  snprintf(context->inBuf, sizeof(context->inBuf), "GET %s", w.args.c_str());
+  context->capture = out;
+  ret = parseCommand(context);
+  context->capture = NULL;
+  return ret;
+}
+
+int commandWatch(connectionRecType *context)
+{
+  watchRecType w;
+  char *s = strtok(NULL, "\r\n");
+
+  while (s && (*s == ' ')) s++;
+  if (!s || !*s || (context->watches.size() >= 64)) {
+    reply(context, "WATCH NAK\r\n");
+    return -1;
+  }
+  w.args = s;
+  w.tag = context->tag;
+  // the first evaluation is answered right away, later ones only on change
+  if (evalWatch(context, w, &w.last) != 0) {
+    reply(context, "%s", w.last.c_str());
+    return -1;
+  }
+  reply(context, "%s", w.last.c_str());
+  context->watches.push_back(w);
+  return 0;
+}
+
+int commandUnwatch(connectionRecType *context)
+{
+  char *s = strtok(NULL, "\r\n");
+  size_t n = context->watches.size();
+
+  while (s && (*s == ' ')) s++;
+  if (!s || !*s) {
+    context->watches.clear();
+  } else {
+    for (size_t i = 0; i < context->watches.size(); ) {
+      if (strcasecmp(context->watches[i].args.c_str(), s) == 0)
+        context->watches.erase(context->watches.begin() + i);
+      else
+        i++;
+    }
+  }
+  if (context->watches.size() == n) {
+    reply(context, "UNWATCH NAK\r\n");
+    return -1;
+  }
+  reply(context, "UNWATCH ACK\r\n");
+  return 0;
+}
+
+// queue the changed replies of watched get commands
+static void updateWatches(connectionRecType *context)
+{
+  std::string out;
+
+  for (size_t i = 0; i < context->watches.size(); i++) {
+    watchRecType &w = context->watches[i];
+    out.clear();
+    evalWatch(context, w, &out);
+    if (out == w.last) continue;
+    w.last = out;
+    if (!w.tag.empty()) {
+      context->outQueue += w.tag;
+      context->outQueue += ' ';
+    }
+    context->outQueue += out;
+  }
+}
+
+static int flushClient(connectionRecType *context);
+
 int commandShutdown(connectionRecType *context)
 {
   if (context->cliSock == enabledConn) {
     printf("Shutting down\n");
+    // the replies to the previous commands go out first
+    fcntl(context->cliSock, F_SETFL, fcntl(context->cliSock, F_GETFL) & ~O_NONBLOCK);
+    flushClient(context);
     thisQuit();
     return -1;
     }
@@ -2697,13 +2880,15 @@ int commandShutdown(connectionRecType *context)
 
 static int helpGeneral(connectionRecType *context)
 {
-  dprintf(
-    context->cliSock,
+  reply(
+    context,
     "Available commands:\r\n"
     "  Hello <password> <client name> <protocol version>\r\n"
     "  Get <LinuxCNC command>\r\n"
     "  Set <LinuxCNC command>\r\n"
     "  Shutdown\r\n"
+    "  Watch <Get sub-command>\r\n"
+    "  Unwatch {<Get sub-command>}\r\n"
     "  Help <command>\r\n"
   );
   return 0;
@@ -2711,8 +2896,8 @@ static int helpGeneral(connectionRecType *context)
 
 static int helpHello(connectionRecType *context)
 {
-  dprintf(
-    context->cliSock,
+  reply(
+    context,
     "Usage:\r\n"
     "  Hello <Password> <Client Name> <Protocol Version>\r\nWhere:\r\n"
     "  Password is the connection password to allow communications with the CNC server.\r\n"
@@ -2732,8 +2917,8 @@ static int helpHello(connectionRecType *context)
 
 static int helpGet(connectionRecType *context)
 {
-  dprintf(
-    context->cliSock,
+  reply(
+    context,
     "Usage:\r\nGet <LinuxCNC command>\r\n"
     "  Get commands require that a hello has been successfully negotiated.\r\n"
     "  LinuxCNC command may be one of:\r\n"
@@ -2800,8 +2985,8 @@ static int helpGet(connectionRecType *context)
 
 static int helpSet(connectionRecType *context)
 {
-  dprintf(
-    context->cliSock,
+  reply(
+    context,
     "Usage:\r\n  Set <LinuxCNC command>\r\n"
     "  Set commands require that a hello has been successfully negotiated,\r\n"
     "  in most instances requires that control be enabled by the connection.\r\n"
@@ -2853,8 +3038,8 @@ static int helpSet(connectionRecType *context)
 
 static int helpQuit(connectionRecType *context)
 {
-  dprintf(
-    context->cliSock,
+  reply(
+    context,
     "Usage:\r\n"
     "  The quit command has the server initiate a disconnect from the client,\r\n"
     "  the command has no parameters and no requirements to have negotiated\r\n"
@@ -2865,8 +3050,8 @@ static int helpQuit(connectionRecType *context)
 
 static int helpShutdown(connectionRecType *context)
 {
-  dprintf(
-    context->cliSock,
+  reply(
+    context,
     "Usage:\r\n"
     "  The shutdown command terminates the connection with all clients,\r\n"
     "  and initiates a shutdown of LinuxCNC. The command has no parameters, and\r\n"
@@ -2875,10 +3060,24 @@ static int helpShutdown(connectionRecType *context)
   return 0;
 }
 
+static int helpWatch(connectionRecType *context)
+{
+  reply(
+    context,
+    "Usage:\r\n"
+    "  Watch <Get sub-command>\r\n"
+    "  Answers like the get command, then keeps sending the get reply\r\n"
+    "  whenever its value changes, until the connection is closed or the\r\n"
+    "  watch is removed with Unwatch. Unwatch without parameters removes\r\n"
+    "  all watches of the connection.\r\n"
+  );
+  return 0;
+}
+
 static int helpHelp(connectionRecType *context)
 {
-  dprintf(
-    context->cliSock,
+  reply(
+    context,
     "If you need help on help, it is time to look into another line of work.\r\n"
   );
   return 0;
@@ -2894,8 +3093,10 @@ int commandHelp(connectionRecType *context)
   if (strcmp(s, "SET") == 0) return (helpSet(context));
   if (strcmp(s, "QUIT") == 0) return (helpQuit(context));
   if (strcmp(s, "SHUTDOWN") == 0) return (helpShutdown(context));
+  if (strcmp(s, "WATCH") == 0) return (helpWatch(context));
+  if (strcmp(s, "UNWATCH") == 0) return (helpWatch(context));
   if (strcmp(s, "HELP") == 0) return (helpHelp(context));
-  dprintf(context->cliSock, "%s is not a valid command.", s);
+  reply(context, "%s is not a valid command.", s);
   return 0;
 }
 
@@ -2928,9 +3129,9 @@ int parseCommand(connectionRecType *context)
 
     case cmdHello:
       if ((ret = commandHello(context)) < 0)
-        dprintf(context->cliSock, "HELLO NAK\r\n");
+        reply(context, "HELLO NAK\r\n");
       else
-        dprintf(context->cliSock, "HELLO ACK %s 1.1\r\n", serverName);
+        reply(context, "HELLO ACK %s 1.1\r\n", serverName);
       break;
 
     case cmdGet:
@@ -2939,7 +3140,7 @@ int parseCommand(connectionRecType *context)
 
     case cmdSet:
       if (!context->linked) {
-        dprintf(context->cliSock, "SET NAK\r\n");
+        reply(context, "SET NAK\r\n");
         ret = -1;
         break;
       }
@@ -2952,7 +3153,7 @@ int parseCommand(connectionRecType *context)
 
     case cmdShutdown:
       if((ret = commandShutdown(context)) < 0) {
-        dprintf(context->cliSock, "SHUTDOWN NAK\r\n");
+        reply(context, "SHUTDOWN NAK\r\n");
       }
       break;
 
@@ -2960,6 +3161,14 @@ int parseCommand(connectionRecType *context)
       ret = commandHelp(context);
       break;
 
+    case cmdWatch:
+      ret = commandWatch(context);
+      break;
+
+    case cmdUnwatch:
+      ret = commandUnwatch(context);
+      break;
+
     default:
       ret = -2;
   }
@@ -2967,115 +3176,316 @@ int parseCommand(connectionRecType *context)
   return ret;
 }
 
-void *readClient(void *arg)
+// handle the complete command line in context->inBuf, an optional leading
+// "@<tag>" word is stripped and echoed back in front of every reply
+static void handleLine(connectionRecType *context)
 {
-  char buf[1600];
-  int context_index;
-  int i;
-  int len;
-  connectionRecType *context = (connectionRecType *)arg;
+  size_t n;
+
+  context->tag[0] = 0;
+  if (context->inBuf[0] == '@') {
+    n = strcspn(context->inBuf, " \t");
+    snprintf(context->tag, sizeof(context->tag), "%.*s", (int)n, context->inBuf);
+    memmove(context->inBuf, context->inBuf + n, strlen(context->inBuf + n) + 1);
+  }
 
-  context_index = 0;
+  // The return value from parseCommand was meant to indicate
+  // success or error, but it is unusable.  Some paths return
+  // the return value of write(2) and some paths return small
+  // positive integers (cmdResponseType) to indicate failure.
+  // We're best off just ignoring it.
+  (void)parseCommand(context);
 
-  while (1) {
-    // We always start this loop with an empty buf, though there may be one
-    // partial line in context->inBuf[0..context_index].
-    len = read(context->cliSock, buf, sizeof(buf));
-    if (len < 0) {
-      fprintf(stderr, "linuxcncrsh: error reading from client: %s\n", strerror(errno));
-      goto finished;
-    }
-    if (len == 0) {
-      printf("linuxcncrsh: eof from client\n");
-      goto finished;
-    }
+  context->tag[0] = 0;
+}
+
+// true when the command line is a set command, it may send a command to task
+static bool isSetLine(const char *line)
+{
+  if (line[0] == '@') line += strcspn(line, " \t");
+  line += strspn(line, " \t");
+  return (strncasecmp(line, "SET", 3) == 0) && strchr(" \t", line[3]);
+}
 
-    if (context->echo && context->linked)
-      if(write(context->cliSock, buf, len) != (ssize_t)len) {
-        fprintf(stderr, "linuxcncrsh: write() failed: %s", strerror(errno));
+// true when task has read the last command sent, the next one can be written
+static bool commandReceived()
+{
+  if (emcStatus->echo_serial_number - emcCommandSerialNumber < 0) updateStatus();
+  return emcStatus->echo_serial_number - emcCommandSerialNumber >= 0;
+}
+
+// handle the complete command lines received, in order. Several pipelined
+// commands are handled in one go and their replies go out together. This
+// stops at a set command until task has read the previous command, and after
+// a set command until its reply has been sent. Returns the number of lines
+// handled.
+static int handleLines(connectionRecType *context)
+{
+  size_t n;
+  int handled = 0;
+
+  while (!context->waiting && !context->closing) {
+    n = context->inQueue.find_first_of("\r\n");
+    if (n == std::string::npos) break;
+    if (n == 0) {
+      context->inQueue.erase(0, 1);
+      continue;
+    }
+    // overlong lines are truncated
+    snprintf(context->inBuf, sizeof(context->inBuf), "%.*s", (int)n, context->inQueue.data());
+    if (isSetLine(context->inBuf) && !commandReceived()) break;
+    context->inQueue.erase(0, n + 1);
+    handleLine(context);
+    handled++;
+  }
+  return handled;
+}
+
+// send the replies of the set commands task has received or finished,
+// returns how many were answered
+static int waitReplies(std::vector<connectionRecType *> &clients)
+{
+  bool updated = false;
+  int serial_diff;
+  bool failed;
+  int answered = 0;
+
+  for (size_t i = 0; i < clients.size(); i++) {
+    connectionRecType *context = clients[i];
+    if (!context->waiting) continue;
+    if (!updated) {
+      updateStatus();
+      updated = true;
+    }
+    serial_diff = emcStatus->echo_serial_number - context->waitSerial;
+    failed = false;
+    if (context->waitFor == EMC_WAIT_RECEIVED) {
+      if (serial_diff < 0) {
+        if ((emcTimeout <= 0.0) || (etime() - context->waitStart < emcTimeout)) continue;
+        failed = true;
       }
+    } else if ((serial_diff < 0) ||
+        ((serial_diff == 0) && (emcStatus->status != RCS_STATUS::DONE))) {
+      if ((serial_diff == 0) && (emcStatus->status == RCS_STATUS::ERROR)) failed = true;
+      else if ((emcTimeout > 0.0) && (etime() - context->waitStart >= emcTimeout)) failed = true;
+      else continue;
+    }
+
+    context->waiting = false;
+    rtapi_strxcpy(context->tag, context->waitTag);
+    if (failed)
+      reply(context, "SET %s NAK\r\n", context->waitCmd);
+    else if (context->verbose)
+      reply(context, "SET %s ACK\r\n", context->waitCmd);
+    context->tag[0] = 0;
+    // report what the command changed before handling the next ones
+    updateWatches(context);
+    answered++;
+  }
+  return answered;
+}
 
-    for (i = 0; i < len; i ++) {
-        if ((buf[i] != '\n') && (buf[i] != '\r')) {
-            context->inBuf[context_index] = buf[i];
-            context_index ++;
-            continue;
-        }
+// read what the client sent and handle all complete command lines,
+// returns -1 when the connection failed
+static int readClient(connectionRecType *context)
+{
+  char buf[1600];
+  int len;
+
+  len = read(context->cliSock, buf, sizeof(buf));
+  if (len < 0) {
+    if ((errno == EAGAIN) || (errno == EINTR)) return 0;
+    fprintf(stderr, "linuxcncrsh: error reading from client: %s\n", strerror(errno));
+    context->outQueue.clear();
+    return -1;
+  }
+  if (len == 0) {
+    // the commands still queued are handled before disconnecting
+    printf("linuxcncrsh: eof from client\n");
+    context->eof = true;
+    return 0;
+  }
 
-        // if we get here, i is the index of a line terminator in buf
+  if (context->echo && context->linked)
+    context->outQueue.append(buf, len);
 
-        if (context_index > 0) {
-            // we have some bytes in the context buffer, parse them now
-            context->inBuf[context_index] = '\0';
+  // a client is not allowed to pile up commands either
+  context->inQueue.append(buf, len);
+  if (context->inQueue.size() > 1024 * 1024) {
+    fprintf(stderr, "linuxcncrsh: too many commands queued by client\n");
+    return -1;
+  }
+  handleLines(context);
+  return 0;
+}
 
-            // The return value from parseCommand was meant to indicate
-            // success or error, but it is unusable.  Some paths return
-            // the return value of write(2) and some paths return small
-            // positive integers (cmdResponseType) to indicate failure.
-            // We're best off just ignoring it.
-            (void)parseCommand(context);
+// write as much of the queued replies as the socket takes
+static int flushClient(connectionRecType *context)
+{
+  ssize_t len;
 
-            context_index = 0;
-        }
+  while (!context->outQueue.empty()) {
+    len = write(context->cliSock, context->outQueue.data(), context->outQueue.size());
+    if (len < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) return 0;
+      fprintf(stderr, "linuxcncrsh: write() failed: %s\n", strerror(errno));
+      context->outQueue.clear();
+      return -1;
     }
+    context->outQueue.erase(0, len);
   }
+  return 0;
+}
+
+static connectionRecType *newClient(int client_sockfd)
+{
+  connectionRecType *context = new connectionRecType();
+  int optval = 1;
 
-finished:
+  fcntl(client_sockfd, F_SETFL, fcntl(client_sockfd, F_GETFL) | O_NONBLOCK);
+  setsockopt(client_sockfd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+  context->cliSock = client_sockfd;
+  context->linked = false;
+  context->echo = true;
+  context->verbose = false;
+  rtapi_strxcpy(context->version, "1.0");
+  rtapi_strxcpy(context->hostName, "Default");
+  context->enabled = false;
+  context->commMode = 0;
+  context->commProt = 0;
+  context->inBuf[0] = 0;
+  context->tag[0] = 0;
+  context->closing = false;
+  context->eof = false;
+  context->capture = NULL;
+  context->waiting = false;
+  return context;
+}
+
+static void closeClient(connectionRecType *context)
+{
   printf("linuxcncrsh: disconnecting client %s (%s)\n", context->hostName, context->version);
+  if (enabledConn == context->cliSock)
+    enabledConn = -1;
   close(context->cliSock);
-  free(context);
-  pthread_exit((void *)0);
-  sessions--;  // FIXME: not reached
+  delete context;
+  sessions--;
 }
 
+// All clients are served from this single thread: commands are executed in
+// the order they arrive, so a client may send several commands without
+// waiting for each reply, and watched values are polled every WATCH_PERIOD.
+// While set commands wait for task, the status is polled from WAIT_PERIOD_MIN
+// with an exponential backoff up to WAIT_PERIOD_MAX.
 int sockMain()
 {
-    int res;
+    std::vector<connectionRecType *> clients;
+    std::vector<struct pollfd> fds;
+    double nextWatch = etime();
+    double waitPeriod = WAIT_PERIOD_MIN;
+
+    fcntl(server_sockfd, F_SETFL, fcntl(server_sockfd, F_GETFL) | O_NONBLOCK);
 
     while (1) {
-        int client_sockfd;
-        client_len = sizeof(client_address);
-        client_sockfd = accept(server_sockfd, (struct sockaddr *)&client_address, &client_len);
-        if (client_sockfd < 0) exit(0);
-        // count connected clients
-        sessions++;
-        // enforce limited amount of clients that can connect simultaneously
-        if ((maxSessions == -1) || (sessions <= maxSessions)) {
-            pthread_t *thrd;
-            connectionRecType *context;
-
-            thrd = (pthread_t *)calloc(1, sizeof(pthread_t));
-            if (!thrd) {
-                fprintf(stderr, "linuxcncrsh: out of memory\n");
-                exit(1);
-            }
+        struct pollfd pfd;
+        bool watching = false;
+        bool waiting = false;
+        int timeout = -1;
+        size_t i;
+
+        fds.clear();
+        pfd.fd = server_sockfd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        fds.push_back(pfd);
+        for (i = 0; i < clients.size(); i++) {
+            pfd.fd = clients[i]->cliSock;
+            pfd.events = ((clients[i]->closing || clients[i]->eof) ? 0 : POLLIN) |
+                (clients[i]->outQueue.empty() ? 0 : POLLOUT);
+            fds.push_back(pfd);
+            if (!clients[i]->watches.empty()) watching = true;
+            // a set command waits for task, or a line waits for a set command
+            if (clients[i]->waiting || (!clients[i]->closing &&
+                (clients[i]->inQueue.find_first_of("\r\n") != std::string::npos)))
+                waiting = true;
+        }
+        if (watching) {
+            double delay = nextWatch - etime();
+            timeout = (delay > 0.0) ? (int)(delay * 1000.0) + 1 : 0;
+        }
+        if (waiting) {
+            if ((timeout < 0) || (timeout > (int)(waitPeriod * 1000.0)))
+                timeout = (int)(waitPeriod * 1000.0);
+            waitPeriod = std::min(waitPeriod * 2.0, WAIT_PERIOD_MAX);
+        } else {
+            waitPeriod = WAIT_PERIOD_MIN;
+        }
 
-            context = (connectionRecType *)malloc(sizeof(connectionRecType));
-            if (!context) {
-                fprintf(stderr, "linuxcncrsh: out of memory\n");
-                exit(1);
+        if (poll(fds.data(), fds.size(), timeout) < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "linuxcncrsh: poll() failed: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int client_sockfd;
+            client_len = sizeof(client_address);
+            client_sockfd = accept(server_sockfd, (struct sockaddr *)&client_address, &client_len);
+            if (client_sockfd < 0) {
+                if ((errno != EAGAIN) && (errno != EINTR) && (errno != ECONNABORTED))
+                    exit(0);
+            } else if ((maxSessions != -1) && (sessions >= maxSessions)) {
+                // enforce limited amount of clients that can connect simultaneously
+                fprintf(stderr, "linuxcncrsh: maximum amount of sessions exceeded: %d\n", maxSessions);
+                close(client_sockfd);
+            } else {
+                // count connected clients
+                sessions++;
+                clients.push_back(newClient(client_sockfd));
             }
+        }
 
-            context->cliSock = client_sockfd;
-            context->linked = false;
-            context->echo = true;
-            context->verbose = false;
-            rtapi_strxcpy(context->version, "1.0");
-            rtapi_strxcpy(context->hostName, "Default");
-            context->enabled = false;
-            context->commMode = 0;
-            context->commProt = 0;
-            context->inBuf[0] = 0;
-
-            res = pthread_create(thrd, NULL, readClient, (void *)context);
-        } else {
-            fprintf(stderr, "linuxcncrsh: maximum amount of sessions exceeded: %d\n", maxSessions);
-            res = -1;
+        // clients accepted above have no entry in fds yet
+        for (i = 1; i < fds.size(); i++) {
+            connectionRecType *context = clients[i - 1];
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                if (!context->closing && !context->eof && (readClient(context) < 0))
+                    context->closing = true;
         }
-        // discard connection upon error
-        if (res != 0) {
-            close(client_sockfd);
-            sessions--;
+
+        // start again from WAIT_PERIOD_MIN when a set command is over
+        if (waiting) {
+            int progress = waitReplies(clients);
+            for (i = 0; i < clients.size(); i++) progress += handleLines(clients[i]);
+            if (progress) waitPeriod = WAIT_PERIOD_MIN;
+        }
+
+        if (watching && (etime() >= nextWatch)) {
+            // a set command in flight updates them once it is answered
+            for (i = 0; i < clients.size(); i++)
+                if (!clients[i]->closing && !clients[i]->waiting) updateWatches(clients[i]);
+            nextWatch += WATCH_PERIOD;
+            if (nextWatch < etime()) nextWatch = etime() + WATCH_PERIOD;
+        }
+
+        for (i = 0; i < clients.size(); ) {
+            connectionRecType *context = clients[i];
+            if (context->eof && !context->waiting &&
+                (context->inQueue.find_first_of("\r\n") == std::string::npos))
+                context->closing = true;
+            // a client that stops reading is not allowed to pile up replies
+            if ((flushClient(context) < 0) || (context->outQueue.size() > 1024 * 1024)) {
+                context->outQueue.clear();
+                context->closing = true;
+            }
+            if (context->closing && context->outQueue.empty()) {
+                closeClient(context);
+                clients.erase(clients.begin() + i);
+            } else {
+                i++;
+            }
         }
     }
     return 0;
@@ -3103,7 +3513,7 @@ int main(int argc, char *argv[])
     int opt;
 
     // initialize default values
-    emcWaitType = EMC_WAIT_RECEIVED;
+    emcWaitType = EMC_WAIT_NONE;
     emcCommandSerialNumber = 0;
     emcTimeout = 0.0;
     emcUpdateType = EMC_UPDATE_AUTO;
@@ -268,31 +268,41 @@ int updateError()
     return 0;
 }
 
-#define EMC_COMMAND_DELAY   0.1	// how long to sleep between checks
+#define EMC_COMMAND_DELAY   0.1	// longest sleep between checks
+#define EMC_COMMAND_DELAY_MIN 0.001	// first sleep between checks
+
+// Most commands are received and done within a few task cycles, so check
+// often at first and back off to EMC_COMMAND_DELAY for long running ones.
+static double emcCommandDelay(double delay)
+{
+    delay *= 2.0;
+    return delay < EMC_COMMAND_DELAY ? delay : EMC_COMMAND_DELAY;
+}
 
 int emcCommandWaitDone()
 {
     double end;
-    for (end = 0.0; emcTimeout <= 0.0 || end < emcTimeout; end += EMC_COMMAND_DELAY) {
+    double delay = EMC_COMMAND_DELAY_MIN;
+    for (end = 0.0; emcTimeout <= 0.0 || end < emcTimeout;) {
 	updateStatus();
 	int serial_diff = emcStatus->echo_serial_number - emcCommandSerialNumber;
-	if (serial_diff < 0) {
-	    continue;
-	}
-
 	if (serial_diff > 0) {
 	    return 0;
 	}
 
-	if (emcStatus->status == RCS_STATUS::DONE) {
-	    return 0;
-	}
+	if (serial_diff == 0) {
+	    if (emcStatus->status == RCS_STATUS::DONE) {
+		return 0;
+	    }
 
-	if (emcStatus->status == RCS_STATUS::ERROR) {
-	    return -1;
+	    if (emcStatus->status == RCS_STATUS::ERROR) {
+		return -1;
+	    }
 	}
 
-	esleep(EMC_COMMAND_DELAY);
+	esleep(delay);
+	end += delay;
+	delay = emcCommandDelay(delay);
     }
 
     return -1;
@@ -301,7 +311,8 @@ int emcCommandWaitDone()
 int emcCommandWaitReceived()
 {
     double end;
-    for (end = 0.0; emcTimeout <= 0.0 || end < emcTimeout; end += EMC_COMMAND_DELAY) {
+    double delay = EMC_COMMAND_DELAY_MIN;
+    for (end = 0.0; emcTimeout <= 0.0 || end < emcTimeout;) {
 	updateStatus();
 
 	int serial_diff = emcStatus->echo_serial_number - emcCommandSerialNumber;
@@ -309,7 +320,9 @@ int emcCommandWaitReceived()
 	    return 0;
 	}
 
-	esleep(EMC_COMMAND_DELAY);
+	esleep(delay);
+	end += delay;
+	delay = emcCommandDelay(delay);
     }
 
     return -1;
@@ -317,6 +330,13 @@ int emcCommandWaitReceived()
 
 int emcCommandSend(RCS_CMD_MSG & cmd)
 {
+    // with EMC_WAIT_NONE the previous command may not have been read by
+    // task yet, writing now would overwrite it
+    if (emcWaitType == EMC_WAIT_NONE &&
+	emcStatus->echo_serial_number - emcCommandSerialNumber < 0 &&
+	emcCommandWaitReceived() != 0) {
+	return -1;
+    }
     // write command
     if (emcCommandBuffer->write(&cmd)) {
         return -1;
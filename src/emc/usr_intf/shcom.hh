@@ -75,7 +75,8 @@ enum EMC_UPDATE_TYPE {
 extern EMC_UPDATE_TYPE emcUpdateType;
 
 enum EMC_WAIT_TYPE {
-    EMC_WAIT_RECEIVED = 2,
+    EMC_WAIT_NONE = 1,		// the caller checks echo_serial_number itself
+    EMC_WAIT_RECEIVED,
     EMC_WAIT_DONE
 };
 extern EMC_WAIT_TYPE emcWaitType;
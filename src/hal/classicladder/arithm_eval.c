@@ -710,3 +710,563 @@ char * VerifySyntaxForMakeCalc(char * StringToVerify)
 	return VerifyErrorDesc;
 }
 
+
+
+/* Compiled expressions */
+/* -------------------- */
+/* The user space part compiles the expressions of the compare and operate */
+/* blocks each time the program is loaded or edited, so that the realtime */
+/* task no longer parses their strings at each scan. The compiler follows the grammar of the functions */
+/* above and gives a postfix code, run on a small stack. If an expression */
+/* has a syntax error, it is not compiled and still evaluated from its */
+/* string, so that it gives the same results as before. */
+
+#define CODE_CONST 1		/* value */
+#define CODE_VAR 2		/* type, offset */
+#define CODE_INDEXED_VAR 3	/* type, offset, index type, index offset */
+#define CODE_NOT 4
+#define CODE_POW 5
+#define CODE_MUL 6
+#define CODE_DIV 7
+#define CODE_MOD 8
+#define CODE_ADD 9
+#define CODE_SUB 10
+#define CODE_AND 11
+#define CODE_XOR 12
+#define CODE_OR 13
+#define CODE_ABS 14
+#define CODE_MINI 15		/* number of values */
+#define CODE_MAXI 16		/* number of values */
+#define CODE_AVG 17		/* number of values */
+#define CODE_COMPARE 18		/* COMPARE_xxx flags */
+#define CODE_STORE 19		/* type, offset */
+#define CODE_STORE_INDEXED 20	/* type, offset, index type, index offset */
+
+#define COMPARE_GREATER 1
+#define COMPARE_LESS 2
+#define COMPARE_DIFFERENT 4
+#define COMPARE_EQUAL 8
+
+#define ARITHM_STACK_SIZE 32
+
+#ifndef RTAPI
+static StrArithmCode * CodeUnderCompile;
+static int CompileStackDepth;
+
+static void CompileOr(void);
+
+/* Pops, then pushes Pushed values */
+static void EmitCode(int Length, int * Values, int Popped, int Pushed)
+{
+	int Scan;
+	if ( CodeUnderCompile->Length+Length>ARITHM_CODE_SIZE )
+	{
+		ErrorDesc = "Expression too long to compile";
+		return;
+	}
+	for ( Scan=0; Scan<Length; Scan++ )
+		CodeUnderCompile->Code[ CodeUnderCompile->Length++ ] = Values[ Scan ];
+	CompileStackDepth = CompileStackDepth-Popped+Pushed;
+	if ( CompileStackDepth>ARITHM_STACK_SIZE )
+		ErrorDesc = "Expression too deep to compile";
+}
+static void EmitOperator(int Operator)
+{
+	EmitCode( 1, &Operator, 2, 1 );
+}
+
+static void CompileVariable(void)
+{
+	int Values[ 5 ];
+	if ( IdentifyVarIndexedOrNot( Expr, &Values[1], &Values[2], &Values[3], &Values[4] ) )
+	{
+		/* flush var found, as Variable() */
+		Expr++;
+		do
+		{
+			Expr++;
+		}
+		while( (*Expr!='@') && (*Expr!='\0') );
+		if ( *Expr=='\0' )
+		{
+			ErrorDesc = "Missing end @ of variable";
+			return;
+		}
+		Expr++;
+		if ( Values[3]!=-1 && Values[4]!=-1 )
+		{
+			Values[0] = CODE_INDEXED_VAR;
+			EmitCode( 5, Values, 0, 1 );
+		}
+		else
+		{
+			Values[0] = CODE_VAR;
+			EmitCode( 3, Values, 0, 1 );
+		}
+	}
+}
+
+static void CompileFunction(void)
+{
+	char tcFonc[ 20 ], *pFonc;
+	int Values[ 2 ];
+
+	pFonc = tcFonc;
+	while((unsigned int)(pFonc-tcFonc)<sizeof(tcFonc)-1 && *Expr>='A' && *Expr<='Z')
+	{
+		*pFonc++ = *Expr;
+		Expr++;
+	}
+	*pFonc = '\0';
+
+	if ( !strcmp(tcFonc, "ABS") )
+	{
+		Expr++; /* ( */
+		CompileVariable( );
+		if ( *Expr!=')' )
+		{
+			ErrorDesc = "Missing end ) after the only variable in ABS() function";
+			return;
+		}
+		Expr++; /* ) */
+		Values[ 0 ] = CODE_ABS;
+		EmitCode( 1, Values, 1, 1 );
+		return;
+	}
+	if ( !strcmp(tcFonc, "MINI") )
+		Values[ 0 ] = CODE_MINI;
+	else if ( !strcmp(tcFonc, "MAXI") )
+		Values[ 0 ] = CODE_MAXI;
+	else if ( !strcmp(tcFonc, "MOY") || !strcmp(tcFonc, "AVG") )
+		Values[ 0 ] = CODE_AVG;
+	else
+	{
+		ErrorDesc = "Unknown function";
+		return;
+	}
+	Values[ 1 ] = 0;
+	do
+	{
+		Expr++; /* ( -or- , */
+		CompileVariable( );
+		if ( ErrorDesc )
+			return;
+		if ( *Expr=='\0' )
+		{
+			ErrorDesc = "Missing end ) of function";
+			return;
+		}
+		Values[ 1 ]++;
+	}
+	while( *Expr!=')' );
+	Expr++; /* ) */
+	EmitCode( 2, Values, Values[ 1 ], 1 );
+}
+
+static void CompileTerm(void)
+{
+	int Values[ 2 ];
+	if (*Expr=='(')
+	{
+		Expr++;
+		CompileOr();
+		if (*Expr!=')')
+		{
+			ErrorDesc = "Missing parenthesis";
+			return;
+		}
+		Expr++;
+	}
+	else if ( (*Expr>='0' && *Expr<='9') || (*Expr=='$') || (*Expr=='-') || (*Expr=='\'') )
+	{
+		Values[ 0 ] = CODE_CONST;
+		Values[ 1 ] = Constant();
+		EmitCode( 2, Values, 0, 1 );
+	}
+	else if (*Expr>='A' && *Expr<='Z')
+		CompileFunction();
+	else if (*Expr=='@')
+		CompileVariable();
+	else if (*Expr=='!')
+	{
+		Expr++;
+		CompileTerm();
+		Values[ 0 ] = CODE_NOT;
+		EmitCode( 1, Values, 1, 1 );
+	}
+	else
+	{
+		ErrorDesc = "Unknown term";
+	}
+}
+
+static void CompilePow(void)
+{
+	CompileTerm();
+	while(*Expr=='^')
+	{
+		if ( ErrorDesc )
+			break;
+		Expr++;
+		CompilePow();
+		EmitOperator( CODE_POW );
+	}
+}
+
+static void CompileMulDivMod(void)
+{
+	CompilePow();
+	while(1)
+	{
+		if ( ErrorDesc )
+			break;
+		if (*Expr=='*')
+		{
+			Expr++;
+			CompilePow();
+			EmitOperator( CODE_MUL );
+		}
+		else if (*Expr=='/')
+		{
+			Expr++;
+			CompilePow();
+			EmitOperator( CODE_DIV );
+		}
+		else if (*Expr=='%')
+		{
+			Expr++;
+			CompilePow();
+			EmitOperator( CODE_MOD );
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+static void CompileAddSub(void)
+{
+	CompileMulDivMod();
+	while(1)
+	{
+		if ( ErrorDesc )
+			break;
+		if (*Expr=='+')
+		{
+			Expr++;
+			CompileMulDivMod();
+			EmitOperator( CODE_ADD );
+		}
+		else if (*Expr=='-')
+		{
+			Expr++;
+			CompileMulDivMod();
+			EmitOperator( CODE_SUB );
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+static void CompileAnd(void)
+{
+	CompileAddSub();
+	while( !ErrorDesc && *Expr=='&' )
+	{
+		Expr++;
+		CompileAddSub();
+		EmitOperator( CODE_AND );
+	}
+}
+static void CompileXor(void)
+{
+	CompileAnd();
+	while( !ErrorDesc && *Expr=='^' )
+	{
+		Expr++;
+		CompileAnd();
+		EmitOperator( CODE_XOR );
+	}
+}
+static void CompileOr(void)
+{
+	CompileXor();
+	while( !ErrorDesc && *Expr=='|' )
+	{
+		Expr++;
+		CompileXor();
+		EmitOperator( CODE_OR );
+	}
+}
+
+static void CompileExpression(char * ExprString)
+{
+	Expr = ExprString;
+	CompileOr();
+}
+
+/* start and end of a compile, return TRUE if the code can be used */
+static void StartCompile(StrArithmCode * pCode)
+{
+	CodeUnderCompile = pCode;
+	CodeUnderCompile->Length = 0;
+	CompileStackDepth = 0;
+	ErrorDesc = NULL;
+	/* errors are reported when the expression is evaluated from its string */
+	UnderVerify = TRUE;
+	VerifyErrorDesc = NULL;
+}
+static int EndCompile(void)
+{
+	UnderVerify = FALSE;
+	if ( ErrorDesc )
+	{
+		CodeUnderCompile->Length = -1;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* Compile an expression for EvalCompiledCompare(), as EvalCompare() parses it */
+int CompileEvalCompare(char * CompareString,StrArithmCode * pCode)
+{
+	char * FirstExpr,* SecondExpr = NULL;
+	char StrCopy[ARITHM_EXPR_SIZE+1];
+	char * SearchSep;
+	char * CutFirst;
+	int Found = FALSE;
+	int Values[ 2 ];
+
+	StartCompile( pCode );
+	/* null expression ? always false */
+	if (*CompareString=='\0' || *CompareString=='#')
+	{
+		Values[ 0 ] = CODE_CONST;
+		Values[ 1 ] = 0;
+		EmitCode( 2, Values, 0, 1 );
+		return EndCompile( );
+	}
+
+	rtapi_strxcpy(StrCopy,CompareString);
+	CutFirst = FirstExpr = StrCopy;
+	SearchSep = CompareString;
+	do
+	{
+		if ( (*SearchSep=='>') || (*SearchSep=='<') || (*SearchSep=='=') )
+		{
+			Found = TRUE;
+			*CutFirst = '\0';
+			CutFirst++;
+			SecondExpr = CutFirst;
+			if ( *CutFirst=='=' || *CutFirst=='>')
+			{
+				CutFirst++;
+				SecondExpr = CutFirst;
+			}
+		}
+		else
+		{
+			SearchSep++;
+			CutFirst++;
+		}
+	}
+	while (*SearchSep!='\0' && !Found);
+	if (!Found)
+	{
+		ErrorDesc = "Missing < or > or = or ... to make compare";
+		return EndCompile( );
+	}
+	CompileExpression( FirstExpr );
+	if ( !ErrorDesc )
+		CompileExpression( SecondExpr );
+	Values[ 0 ] = CODE_COMPARE;
+	Values[ 1 ] = 0;
+	if ( *SearchSep=='>' )
+		Values[ 1 ] |= COMPARE_GREATER;
+	if ( *SearchSep=='<' && *(SearchSep+1)!='>' )
+		Values[ 1 ] |= COMPARE_LESS;
+	if ( *SearchSep=='<' && *(SearchSep+1)=='>' )
+		Values[ 1 ] |= COMPARE_DIFFERENT;
+	if ( *SearchSep=='=' || *(SearchSep+1)=='=' )
+		Values[ 1 ] |= COMPARE_EQUAL;
+	EmitCode( 2, Values, 2, 1 );
+	return EndCompile( );
+}
+
+/* Compile an expression for MakeCompiledCalc(), as MakeCalc() parses it */
+int CompileMakeCalc(char * CalcString,StrArithmCode * pCode)
+{
+	char StrCopy[ARITHM_EXPR_SIZE+1];
+	int Values[ 5 ];
+	int Found = FALSE;
+
+	StartCompile( pCode );
+	/* null expression ? nothing to do */
+	if (*CalcString=='\0' || *CalcString=='#')
+		return EndCompile( );
+
+	rtapi_strxcpy(StrCopy,CalcString);
+	Expr = StrCopy;
+	if ( !IdentifyVarIndexedOrNot( Expr, &Values[1], &Values[2], &Values[3], &Values[4] ) )
+		return EndCompile( );
+	Values[ 0 ] = ( Values[3]!=-1 && Values[4]!=-1 )?CODE_STORE_INDEXED:CODE_STORE;
+	Expr++;
+	do
+	{
+		Expr++;
+	}
+	while( (*Expr!='@') && (*Expr!='\0') );
+	if ( *Expr=='\0' )
+	{
+		ErrorDesc = "Missing end @ of variable";
+		return EndCompile( );
+	}
+	Expr++;
+	do
+	{
+		if (*Expr==':')
+			Expr++;
+		if (*Expr=='=')
+		{
+			Found = TRUE;
+			Expr++;
+		}
+		if (*Expr==' ')
+			Expr++;
+	}
+	while( !Found && *Expr!='\0' );
+	while( *Expr==' ')
+		Expr++;
+	if (!Found)
+	{
+		ErrorDesc = "Missing := to make operate";
+		return EndCompile( );
+	}
+	CompileExpression( Expr );
+	EmitCode( Values[0]==CODE_STORE?3:5, Values, 1, 0 );
+	return EndCompile( );
+}
+#endif
+
+static int ReadCodeVar(int * Code, int Indexed)
+{
+	int VarOffset = Code[ 1 ];
+	if ( Indexed )
+		VarOffset += ReadVar( Code[ 2 ], Code[ 3 ] );
+	return ReadVar( Code[ 0 ], VarOffset );
+}
+
+/* Run a compiled code, return the value left on the stack if any */
+static arithmtype RunArithmCode(StrArithmCode * pCode)
+{
+	arithmtype Stack[ ARITHM_STACK_SIZE ];
+	int Top = -1;
+	int * Code = pCode->Code;
+	int * End = Code+pCode->Length;
+	int Op, VarOffset, NbrValues, Scan;
+	arithmtype Res;
+
+	while( Code<End )
+	{
+		Op = *Code++;
+		switch( Op )
+		{
+			case CODE_CONST:
+				Stack[ ++Top ] = *Code++;
+				break;
+			case CODE_VAR:
+				Stack[ ++Top ] = ReadCodeVar( Code, FALSE );
+				Code += 2;
+				break;
+			case CODE_INDEXED_VAR:
+				Stack[ ++Top ] = ReadCodeVar( Code, TRUE );
+				Code += 4;
+				break;
+			case CODE_NOT:
+				Stack[ Top ] = Stack[ Top ]?0:1;
+				break;
+			case CODE_ABS:
+				if ( Stack[ Top ]<0 )
+					Stack[ Top ] = Stack[ Top ] * -1;
+				break;
+			case CODE_MINI:
+			case CODE_MAXI:
+			case CODE_AVG:
+				NbrValues = *Code++;
+				Top -= NbrValues-1;
+				if ( Op==CODE_MINI )
+					Res = 0x7FFFFFFF;
+				else if ( Op==CODE_MAXI )
+					Res = 0x80000000;
+				else
+					Res = 0;
+				for ( Scan=Top; Scan<Top+NbrValues; Scan++ )
+				{
+					if ( Op==CODE_MINI && Stack[ Scan ]<Res )
+						Res = Stack[ Scan ];
+					if ( Op==CODE_MAXI && Stack[ Scan ]>Res )
+						Res = Stack[ Scan ];
+					if ( Op==CODE_AVG )
+						Res = Res + Stack[ Scan ];
+				}
+				if ( Op==CODE_AVG )
+					Res = Res/NbrValues;
+				Stack[ Top ] = Res;
+				break;
+			case CODE_COMPARE:
+				Top--;
+				Res = 0;
+				if ( (*Code & COMPARE_GREATER) && Stack[ Top ]>Stack[ Top+1 ] )
+					Res = 1;
+				if ( (*Code & COMPARE_LESS) && Stack[ Top ]<Stack[ Top+1 ] )
+					Res = 1;
+				if ( (*Code & COMPARE_DIFFERENT) && Stack[ Top ]!=Stack[ Top+1 ] )
+					Res = 1;
+				if ( (*Code & COMPARE_EQUAL) && Stack[ Top ]==Stack[ Top+1 ] )
+					Res = 1;
+				Stack[ Top ] = Res;
+				Code++;
+				break;
+			case CODE_STORE:
+			case CODE_STORE_INDEXED:
+				VarOffset = Code[ 1 ];
+				if ( Op==CODE_STORE_INDEXED )
+					VarOffset += ReadVar( Code[ 2 ], Code[ 3 ] );
+				WriteVar( Code[ 0 ], VarOffset, (int)Stack[ Top-- ] );
+				Code += ( Op==CODE_STORE_INDEXED )?4:2;
+				break;
+			default:
+				/* binary operators */
+				Top--;
+				Res = Stack[ Top ];
+				switch( Op )
+				{
+					case CODE_POW: Res = pow_int( Res, Stack[ Top+1 ] ); break;
+					case CODE_MUL: Res = Res * Stack[ Top+1 ]; break;
+					case CODE_DIV: Res = Res / Stack[ Top+1 ]; break;
+					case CODE_MOD: Res = Res % Stack[ Top+1 ]; break;
+					case CODE_ADD: Res = Res + Stack[ Top+1 ]; break;
+					case CODE_SUB: Res = Res - Stack[ Top+1 ]; break;
+					case CODE_AND: Res = Res & Stack[ Top+1 ]; break;
+					case CODE_XOR: Res = Res ^ Stack[ Top+1 ]; break;
+					case CODE_OR: Res = Res | Stack[ Top+1 ]; break;
+				}
+				Stack[ Top ] = Res;
+				break;
+		}
+	}
+	return ( Top>=0 )?Stack[ Top ]:0;
+}
+
+int EvalCompiledCompare(StrArithmCode * pCode)
+{
+	return RunArithmCode( pCode );
+}
+
+void MakeCompiledCalc(StrArithmCode * pCode)
+{
+	RunArithmCode( pCode );
+}
@@ -24,5 +24,9 @@ arithmtype AddSub(void);
 arithmtype Or(void);
 char * VerifySyntaxForEvalCompare(char * StringToVerify);
 char * VerifySyntaxForMakeCalc(char * StringToVerify);
+int CompileEvalCompare(char * CompareString,StrArithmCode * pCode);
+int CompileMakeCalc(char * CalcString,StrArithmCode * pCode);
+int EvalCompiledCompare(StrArithmCode * pCode);
+void MakeCompiledCalc(StrArithmCode * pCode);
 
 
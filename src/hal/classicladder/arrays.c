@@ -79,10 +79,13 @@ StrMonostable * MonostableArray;
 StrCounter * CounterArray;
 StrTimerIEC * NewTimerArray;
 StrArithmExpr * ArithmExpr;
+StrCompiledRung * CompiledRungArray;
+StrArithmCode * ArithmCode;
 StrInfosGene * InfosGene;
 StrSection * SectionArray;
 #ifdef SEQUENTIAL_SUPPORT
 StrSequential * Sequential;
+StrCompiledSequential * CompiledSequential;
 #endif
 StrSymbol * SymbolArray;
 
@@ -143,6 +146,12 @@ void InitInfosGene( void )
 
 	InfosGene->DurationOfLastScan = 0;
 	InfosGene->CurrentSection = 0;
+#ifdef RTAPI
+	// only when the realtime module starts: the user space part attaching
+	// again finds the bank still scanned
+	InfosGene->CompiledBankPublished = -1;
+	InfosGene->CompiledBankInUse = -1;
+#endif
 
 	InitIOConf( );
 	InfosGene->AskConfirmationToQuit = FALSE;
@@ -171,6 +180,33 @@ void InitInfosGene( void )
 // -set each element pointer to it's user space shared memory address
 // -Initialize user space Infosgene and return
 
+// Program compiled by the user space part for the realtime scan, rounded up so
+// that the variables after it keep the same alignment. There are two banks of
+// it: one is compiled while the realtime task scans with the other.
+static unsigned long SizeOfCompiledProgram( plc_sizeinfo_s *pSizesInfos )
+{
+    unsigned long bytes = pSizesInfos->nbr_rungs * sizeof(StrCompiledRung);
+    bytes += pSizesInfos->nbr_arithm_expr * sizeof(StrArithmCode);
+#ifdef SEQUENTIAL_SUPPORT
+    bytes += sizeof(StrCompiledSequential);
+#endif
+    return (bytes + 7) & ~7UL;
+}
+
+static unsigned char * CompiledProgramBanks;
+
+// Set CompiledRungArray, ArithmCode and CompiledSequential on a bank (0 or 1)
+void SelectCompiledProgram( int Bank )
+{
+    plc_sizeinfo_s *pSizesInfos = &InfosGene->GeneralParams.SizesInfos;
+    unsigned char *pByte = CompiledProgramBanks + Bank * SizeOfCompiledProgram(pSizesInfos);
+    CompiledRungArray = (StrCompiledRung *) pByte;
+    ArithmCode = (StrArithmCode *) (pByte + pSizesInfos->nbr_rungs * sizeof(StrCompiledRung));
+#ifdef SEQUENTIAL_SUPPORT
+    CompiledSequential = (StrCompiledSequential *) (ArithmCode + pSizesInfos->nbr_arithm_expr);
+#endif
+}
+
 int ClassicLadder_AllocAll()
 {
    	 unsigned char *pByte; 
@@ -201,6 +237,7 @@ int ClassicLadder_AllocAll()
 #ifdef SEQUENTIAL_SUPPORT
     bytes += sizeof(StrSequential);
 #endif
+    bytes += 2 * SizeOfCompiledProgram(pSizesInfos);
     bytes += numWords * sizeof(int);
     bytes += numFloats * sizeof(double);
     bytes += numBits * sizeof(TYPE_FOR_BOOL_VAR);
@@ -313,6 +350,8 @@ int ClassicLadder_AllocAll()
     Sequential = (StrSequential *) pByte;	
   	  pByte += sizeof(StrSequential);
 #endif
+    CompiledProgramBanks = pByte;
+	   pByte += 2 * SizeOfCompiledProgram(pSizesInfos);
     VarWordArray = (int *) pByte;
  	   pByte += SIZE_VAR_WORD_ARRAY * sizeof(int);
     VarFloatArray =(double *)(void *)pByte;
@@ -358,6 +397,8 @@ void ClassicLadder_InitAllDatas( void )
 #endif
 	InitSymbols( );
 	//InitSystemVars( TRUE );
+	// the compiled program is no more for these datas
+	InfosGene->CompiledBankPublished = -1;
 
 	//InitLog( );
 	//InitVarsArrayLogTags( );
@@ -41,6 +41,7 @@
 #endif
 #include "calc.h"
 #include <rtapi_string.h>
+#include <rtapi_atomic.h>
 
 void InitRungs()
 {
@@ -307,22 +308,31 @@ char StateOnLeft(int x,int y,StrRung * TheRung)
 }
 
 /* Elements : -| |- and -|/|- */
-char CalcTypeInput(int x,int y,StrRung * UpdateRung,char IsNot,char OnlyFronts)
+/* state of the contact itself, without the state on its left */
+char CalcContactState(StrElement * pElem,char IsNot,char OnlyFronts)
 {
-    char State;
     char StateElement;
     char StateVar;
 
-    StateElement = ReadVarForElement( &UpdateRung->Element[x][y] );
+    StateElement = ReadVarForElement( pElem );
     if (IsNot)
         StateElement = !StateElement;
     StateVar = StateElement;
     if (OnlyFronts)
     {
-        if (StateElement && UpdateRung->Element[x][y].DynamicVarBak)
+        if (StateElement && pElem->DynamicVarBak)
             StateElement = 0;
     }
-    UpdateRung->Element[x][y].DynamicState = StateElement;
+    pElem->DynamicState = StateElement;
+    pElem->DynamicVarBak = StateVar;
+    return StateElement;
+}
+char CalcTypeInput(int x,int y,StrRung * UpdateRung,char IsNot,char OnlyFronts)
+{
+    char State;
+    char StateElement;
+
+    StateElement = CalcContactState( &UpdateRung->Element[x][y], IsNot, OnlyFronts );
     if (x==0)
     {
         State = StateElement;
@@ -333,7 +343,6 @@ char CalcTypeInput(int x,int y,StrRung * UpdateRung,char IsNot,char OnlyFronts)
         State = StateElement && UpdateRung->Element[x][y].DynamicInput;
     }
     UpdateRung->Element[x][y].DynamicOutput = State;
-    UpdateRung->Element[x][y].DynamicVarBak = StateVar;
     return State;
 }
 /* Element : --- */
@@ -356,32 +365,36 @@ char CalcTypeConnection(int x,int y,StrRung * UpdateRung)
     return State;
 }
 /* Elements : -( )- and -(/)- */
+void CalcCoil(StrElement * pElem,char State,char IsNot)
+{
+    pElem->DynamicInput = State;
+    pElem->DynamicState = State;
+    if (IsNot)
+        State = !State;
+    WriteVarForElement( pElem, State );
+}
 char CalcTypeOutput(int x,int y,StrRung * UpdateRung,char IsNot)
 {
     char State;
     State = StateOnLeft(x,y,UpdateRung);
-    UpdateRung->Element[x][y].DynamicInput = State;
-    UpdateRung->Element[x][y].DynamicState = State;
-    if (IsNot)
-        State = !State;
-    WriteVarForElement( &UpdateRung->Element[x][y], State );
-    return State;
+    CalcCoil( &UpdateRung->Element[x][y], State, IsNot );
+    return IsNot?!State:State;
 }
 /* Elements : -(S)- and -(R)- */
+void CalcCoilSetReset(StrElement * pElem,char State,char IsReset)
+{
+    pElem->DynamicInput = State;
+    pElem->DynamicState = State;
+    if (State)
+        WriteVarForElement( pElem, IsReset?0:1 );
+}
 char CalcTypeOutputSetReset(int x,int y,StrRung * UpdateRung,char IsReset)
 {
     char State;
-    UpdateRung->Element[x][y].DynamicInput = StateOnLeft(x,y,UpdateRung);
-    State = UpdateRung->Element[x][y].DynamicInput;
-    UpdateRung->Element[x][y].DynamicState = State;
-    if (State)
-    {
-        if (IsReset)
-            State = 0;  /* reset */
-        else
-            State = 1;  /* set */
-        WriteVarForElement( &UpdateRung->Element[x][y], State );
-    }
+    State = StateOnLeft(x,y,UpdateRung);
+    CalcCoilSetReset( &UpdateRung->Element[x][y], State, IsReset );
+    if (State && IsReset)
+        State = 0;
     return State;
 }
 /* Element : -(J)- */
@@ -408,36 +421,19 @@ int CalcTypeOutputCall(int x,int y,StrRung * UpdateRung)
     UpdateRung->Element[x][y].DynamicState = State;
     return CallSrSection;
 }
+/* The blocks get their alive element and the states on left of their */
+/* inputs, pElem[n] is the element n rows below the alive one. */
 #ifdef OLD_TIMERS_MONOS_SUPPORT
 /* Element : Timer (2x2 Blocks) */
 // Marc added a control pin to the old timers to add features
 // For EMC, force (C) control pin to always be true so it doesn't
 // break older programs
-void CalcTypeTimer(int x,int y,StrRung * UpdateRung)
+void CalcTimerBlock(StrElement * pElem,char InputEnable,char InputControl)
 {
     StrTimer * Timer;
-    Timer = &TimerArray[UpdateRung->Element[x][y].VarNum];
-    // directly connected to the "left"? if yes, ON !
-    if (x==0)
-    {
-        Timer->InputEnable = 1;
-    }
-    else
-    {
-        Timer->InputEnable = StateOnLeft(x-1,y,UpdateRung);
-    }
-    if (x==0)
-    {
-        Timer->InputControl = 1;
-    }
-    else
-    {
-#ifdef FORCE_INP_CONTROL_OLD_TIMERS
-        Timer->InputControl = 1;
-#else
-        Timer->InputControl = StateOnLeft(x-1,y+1,UpdateRung);
-#endif
-    }
+    Timer = &TimerArray[pElem->VarNum];
+    Timer->InputEnable = InputEnable;
+    Timer->InputControl = InputControl;
     if (!Timer->InputEnable)
     {
         Timer->OutputRunning = 0;
@@ -461,23 +457,41 @@ void CalcTypeTimer(int x,int y,StrRung * UpdateRung)
             Timer->OutputDone = 1;
         }
     }
-    UpdateRung->Element[x][y].DynamicOutput = Timer->OutputDone;
-    UpdateRung->Element[x][y+1].DynamicOutput = Timer->OutputRunning;
+    pElem[0].DynamicOutput = Timer->OutputDone;
+    pElem[1].DynamicOutput = Timer->OutputRunning;
 }
-/* Element : Monostable (2x2 Blocks) */
-void CalcTypeMonostable(int x,int y,StrRung * UpdateRung)
+void CalcTypeTimer(int x,int y,StrRung * UpdateRung)
 {
-    StrMonostable * Monostable;
-    Monostable = &MonostableArray[UpdateRung->Element[x][y].VarNum];
+    char InputEnable, InputControl;
     // directly connected to the "left"? if yes, ON !
     if (x==0)
     {
-        Monostable->Input = 1;
+        InputEnable = 1;
+    }
+    else
+    {
+        InputEnable = StateOnLeft(x-1,y,UpdateRung);
+    }
+    if (x==0)
+    {
+        InputControl = 1;
     }
     else
     {
-        Monostable->Input = StateOnLeft(x-1,y,UpdateRung);
+#ifdef FORCE_INP_CONTROL_OLD_TIMERS
+        InputControl = 1;
+#else
+        InputControl = StateOnLeft(x-1,y+1,UpdateRung);
+#endif
     }
+    CalcTimerBlock( &UpdateRung->Element[x][y], InputEnable, InputControl );
+}
+/* Element : Monostable (2x2 Blocks) */
+void CalcMonostableBlock(StrElement * pElem,char Input)
+{
+    StrMonostable * Monostable;
+    Monostable = &MonostableArray[pElem->VarNum];
+    Monostable->Input = Input;
     /* detecting impulse on input, the monostable is not retriggerable */
     if (Monostable->Input && !Monostable->InputBak && (Monostable->Value==0) )
     {
@@ -489,34 +503,28 @@ void CalcTypeMonostable(int x,int y,StrRung * UpdateRung)
     else
         Monostable->OutputRunning = 0;
     Monostable->InputBak = Monostable->Input;
-    UpdateRung->Element[x][y].DynamicOutput = Monostable->OutputRunning;
+    pElem->DynamicOutput = Monostable->OutputRunning;
+}
+void CalcTypeMonostable(int x,int y,StrRung * UpdateRung)
+{
+    // directly connected to the "left"? if yes, ON !
+    CalcMonostableBlock( &UpdateRung->Element[x][y], (x==0)?1:StateOnLeft(x-1,y,UpdateRung) );
 }
 #endif
 /* Element : Counter (2x4 Blocks) */
-void CalcTypeCounter(int x,int y,StrRung * UpdateRung)
+void CalcCounterBlock(StrElement * pElem,char * Inputs)
 {
-	int CounterNbr = UpdateRung->Element[x][y].VarNum;
+	int CounterNbr = pElem->VarNum;
 	StrCounter * Counter = &CounterArray[ CounterNbr ];
 	char DoneResult, EmptyResult, FullResult;
 	int PresetValue = ReadVar( VAR_COUNTER_PRESET, CounterNbr );
 	int CurrentValue = ReadVar( VAR_COUNTER_VALUE, CounterNbr );
 	int ValueSave = CurrentValue; /* to detect value changed from user... */
 	int CurrentValueNow;
-	// directly connected to the "left"? if yes, ON !
-	if ( x==0 )
-	{
-		Counter->InputReset = 1;
-		Counter->InputPreset = 1;
-		Counter->InputCountUp = 1;
-		Counter->InputCountDown = 1;
-	}
-	else
-	{
-		Counter->InputReset = StateOnLeft(x-1,y,UpdateRung);
-		Counter->InputPreset = StateOnLeft(x-1,y+1,UpdateRung);
-		Counter->InputCountUp = StateOnLeft(x-1,y+2,UpdateRung);
-		Counter->InputCountDown = StateOnLeft(x-1,y+3,UpdateRung);
-	}
+	Counter->InputReset = Inputs[ 0 ];
+	Counter->InputPreset = Inputs[ 1 ];
+	Counter->InputCountUp = Inputs[ 2 ];
+	Counter->InputCountDown = Inputs[ 3 ];
 	if ( Counter->InputCountUp && Counter->InputCountUpBak==0 )
 	{
 		Counter->ValueBak = CurrentValue;
@@ -547,9 +555,9 @@ void CalcTypeCounter(int x,int y,StrRung * UpdateRung)
 	DoneResult = ( CurrentValue==PresetValue )?1:0;
 	EmptyResult = ( CurrentValue==9999 && Counter->ValueBak==0 )?1:0;
 	FullResult = ( CurrentValue==0 && Counter->ValueBak==9999 )?1:0;
-	UpdateRung->Element[x][y + 1].DynamicOutput = DoneResult;
-	UpdateRung->Element[x][y].DynamicOutput = EmptyResult;
-	UpdateRung->Element[x][y + 2].DynamicOutput = FullResult;
+	pElem[1].DynamicOutput = DoneResult;
+	pElem[0].DynamicOutput = EmptyResult;
+	pElem[2].DynamicOutput = FullResult;
 
 	// detect current value changed from user between start and here? not sure...?
 	CurrentValueNow = ReadVar( VAR_COUNTER_VALUE, CounterNbr );
@@ -564,25 +572,26 @@ void CalcTypeCounter(int x,int y,StrRung * UpdateRung)
 	WriteVar( VAR_COUNTER_EMPTY, CounterNbr, EmptyResult );
 	WriteVar( VAR_COUNTER_FULL, CounterNbr, FullResult );
 }
+void CalcTypeCounter(int x,int y,StrRung * UpdateRung)
+{
+	char Inputs[ 4 ];
+	int Scan;
+	// directly connected to the "left"? if yes, ON !
+	for ( Scan=0; Scan<4; Scan++ )
+		Inputs[ Scan ] = ( x==0 )?1:StateOnLeft(x-1,y+Scan,UpdateRung);
+	CalcCounterBlock( &UpdateRung->Element[x][y], Inputs );
+}
 /* Element : New IEC Timer with many modes (2x2 Blocks) */
-void CalcTypeTimerIEC(int x,int y,StrRung * UpdateRung)
+void CalcTimerIECBlock(StrElement * pElem,char Input)
 {
-	int TimerNbr = UpdateRung->Element[x][y].VarNum;
+	int TimerNbr = pElem->VarNum;
 	StrTimerIEC * TimerIEC = &NewTimerArray[ TimerNbr ];
 	int CurrentValue = ReadVar( VAR_TIMER_IEC_VALUE, TimerNbr );
 	int PresetValue = ReadVar( VAR_TIMER_IEC_PRESET, TimerNbr );
 	char OutputResult = ReadVar( VAR_TIMER_IEC_DONE, TimerNbr );
 
 	char DoIncTime = FALSE;
-	// directly connected to the "left"? if yes, ON !
-	if (x==0)
-	{
-		TimerIEC->Input = 1;
-	}
-	else
-	{
-		TimerIEC->Input = StateOnLeft(x-1,y,UpdateRung);
-	}
+	TimerIEC->Input = Input;
 	switch( TimerIEC->TimerMode )
 	{
 		case TIMER_IEC_MODE_ON:
@@ -650,7 +659,7 @@ void CalcTypeTimerIEC(int x,int y,StrRung * UpdateRung)
 		}
 	}
 	TimerIEC->InputBak = TimerIEC->Input;
-	UpdateRung->Element[x][y].DynamicOutput = OutputResult;
+	pElem->DynamicOutput = OutputResult;
 	// now update public vars
 	// (we could have directly written in the IEC Timer structure)
 	// (but on another project, vars can be mapped in another way)
@@ -658,6 +667,11 @@ void CalcTypeTimerIEC(int x,int y,StrRung * UpdateRung)
 	WriteVar( VAR_TIMER_IEC_PRESET, TimerNbr, PresetValue );
 	WriteVar( VAR_TIMER_IEC_VALUE, TimerNbr, CurrentValue );
 }
+void CalcTypeTimerIEC(int x,int y,StrRung * UpdateRung)
+{
+	// directly connected to the "left"? if yes, ON !
+	CalcTimerIECBlock( &UpdateRung->Element[x][y], (x==0)?1:StateOnLeft(x-1,y,UpdateRung) );
+}
 
 /* Element : Compar (3 Horizontal Blocks) */
 char CalcTypeCompar(int x,int y,StrRung * UpdateRung)
@@ -692,6 +706,14 @@ char CalcTypeOutputOperate(int x,int y,StrRung * UpdateRung)
     return State;
 }
 
+void RefreshSubRoutine( int SectionToCall )
+{
+	StrSection * pSubRoutineSection = &SectionArray[ SectionToCall ];
+	if ( pSubRoutineSection->Used && pSubRoutineSection->SubRoutineNumber>=0 )
+		RefreshASection( pSubRoutineSection ); //recursive call! ;-)
+	else
+		debug_printf("Refresh rungs aborted - call to a sub-routine undefined or programmed as main !!!");
+}
 
 int RefreshRung(StrRung * Rung, int * JumpTo)
 {
@@ -765,13 +787,7 @@ int RefreshRung(StrRung * Rung, int * JumpTo)
 				case ELE_OUTPUT_CALL:
 					SectionToCall = CalcTypeOutputCall(x,y,Rung);
 					if ( SectionToCall!=-1 )
-					{
-						StrSection * pSubRoutineSection = &SectionArray[ SectionToCall ];
-						if ( pSubRoutineSection->Used && pSubRoutineSection->SubRoutineNumber>=0 )
-							RefreshASection( pSubRoutineSection ); //recursive call! ;-)
-						else
-							debug_printf("Refresh rungs aborted - call to a sub-routine undefined or programmed as main !!!");
-					}
+						RefreshSubRoutine( SectionToCall );
 					break;
 				case ELE_OUTPUT_OPERATE:
 					CalcTypeOutputOperate(x,y,Rung);
@@ -789,6 +805,293 @@ int RefreshRung(StrRung * Rung, int * JumpTo)
 }
 
 
+/* Compiled rungs */
+/* -------------- */
+/* The user space part compiles the rungs each time the program is loaded */
+/* or edited: the rows on the left of each element are found once by */
+/* following the vertical connections, and only the elements that do */
+/* something are kept, so the scan does not walk the whole grid. */
+/* The results are the same as RefreshRung(), Dynamic* states included, */
+/* except for the free cells not drawn with a vertical connection. */
+/* The compiled program has two banks in the shared memory: a new one is */
+/* compiled in the bank not scanned, then published to the realtime task */
+/* which swaps to it at the start of its next period. */
+static char UseCompiledProgram = FALSE;
+
+#ifndef RTAPI
+/* rows of column x-1 whose outputs are ORed by StateOnLeft(x,y) */
+static unsigned char RowsOnLeft(int x,int y,StrRung * TheRung)
+{
+	unsigned char Rows;
+	int PosY;
+	if (x==0)
+		return ROWS_LEFT_RAIL;
+	Rows = 1<<y;
+	/* Up */
+	for( PosY=y; PosY>0 && TheRung->Element[x][PosY].ConnectedWithTop; PosY-- )
+		Rows |= 1<<(PosY-1);
+	/* Down */
+	for( PosY=y+1; PosY<RUNG_HEIGHT && TheRung->Element[x][PosY].ConnectedWithTop; PosY++ )
+		Rows |= 1<<PosY;
+	return Rows;
+}
+
+#endif
+
+static inline char CompiledStateOnLeft(StrRung * TheRung,StrCompiledElement * pComp,int Input)
+{
+	unsigned char Rows = pComp->LeftRows[ Input ];
+	StrElement * pLeft;
+	if ( Rows & ROWS_LEFT_RAIL )
+		return 1;
+	pLeft = TheRung->Element[ (int)pComp->LeftX ];
+	for( ; Rows; Rows>>=1, pLeft++ )
+	{
+		if ( (Rows & 1) && pLeft->DynamicOutput )
+			return 1;
+	}
+	return 0;
+}
+
+#ifndef RTAPI
+/* return FALSE if the rung can not be compiled (a block that does not fit */
+/* in it), it is then refreshed with RefreshRung() */
+int CompileRung(StrRung * Rung, StrCompiledRung * Compiled)
+{
+	int x,y,Row;
+	int NbrInputs;
+	StrElement * pElem;
+	StrCompiledElement * pComp = Compiled->Element;
+	Compiled->NbrElements = -1;
+	for (x=0;x<RUNG_WIDTH;x++)
+	{
+		for (y=0;y<RUNG_HEIGHT;y++)
+		{
+			pElem = &Rung->Element[x][y];
+			pComp->Type = pElem->Type;
+			pComp->PosiX = x;
+			pComp->PosiY = y;
+			pComp->LeftX = x-1;
+			pComp->LeftRows[ 0 ] = RowsOnLeft(x,y,Rung);
+			switch(pElem->Type)
+			{
+				case ELE_FREE:
+				case ELE_UNUSABLE:
+					/* state on left only used to draw the vertical connection */
+					if ( !pElem->ConnectedWithTop )
+						continue;
+					break;
+				case ELE_INPUT:
+				case ELE_INPUT_NOT:
+				case ELE_RISING_INPUT:
+				case ELE_FALLING_INPUT:
+				case ELE_CONNECTION:
+				case ELE_OUTPUT:
+				case ELE_OUTPUT_NOT:
+				case ELE_OUTPUT_SET:
+				case ELE_OUTPUT_RESET:
+				case ELE_OUTPUT_JUMP:
+				case ELE_OUTPUT_CALL:
+					break;
+#ifdef OLD_TIMERS_MONOS_SUPPORT
+				case ELE_TIMER:
+				case ELE_MONOSTABLE:
+#endif
+				case ELE_COUNTER:
+				case ELE_TIMER_IEC:
+					/* inputs on the left of the block, from its alive element down */
+					NbrInputs = (pElem->Type==ELE_COUNTER)?4:(pElem->Type==ELE_TIMER)?2:1;
+					if ( y+NbrInputs>RUNG_HEIGHT )
+						return FALSE;
+					pComp->LeftX = x-2;
+					for (Row=0;Row<NbrInputs;Row++)
+						pComp->LeftRows[ Row ] = (x==0)?ROWS_LEFT_RAIL:RowsOnLeft(x-1,y+Row,Rung);
+#ifdef FORCE_INP_CONTROL_OLD_TIMERS
+					if ( pElem->Type==ELE_TIMER )
+						pComp->LeftRows[ 1 ] = ROWS_LEFT_RAIL;
+#endif
+					break;
+				case ELE_COMPAR:
+				case ELE_OUTPUT_OPERATE:
+					if ( x<2 || pElem->VarNum<0 || pElem->VarNum>=NBR_ARITHM_EXPR )
+						return FALSE;
+					pComp->LeftX = x-3;
+					pComp->LeftRows[ 0 ] = RowsOnLeft(x-2,y,Rung);
+					if ( pElem->Type==ELE_COMPAR )
+						CompileEvalCompare( ArithmExpr[ pElem->VarNum ].Expr, &ArithmCode[ pElem->VarNum ] );
+					else
+						CompileMakeCalc( ArithmExpr[ pElem->VarNum ].Expr, &ArithmCode[ pElem->VarNum ] );
+					break;
+				default:
+					continue;
+			}
+			pComp++;
+		}
+	}
+	Compiled->NbrElements = pComp-Compiled->Element;
+	return TRUE;
+}
+#endif
+
+int RefreshCompiledRung(StrRung * Rung, StrCompiledRung * Compiled, int * JumpTo)
+{
+	StrCompiledElement * pComp = Compiled->Element;
+	StrCompiledElement * pEnd = pComp+Compiled->NbrElements;
+	StrElement * pElem;
+	StrElement * pInputElem;
+	StrArithmCode * pCode;
+	char State;
+	char Inputs[ 4 ];
+	int JumpToRung = -1;
+	int Row;
+
+	for( ; pComp<pEnd && JumpToRung==-1; pComp++ )
+	{
+		pElem = &Rung->Element[ (int)pComp->PosiX ][ (int)pComp->PosiY ];
+		/* rung just edited, not yet compiled again */
+		if ( pElem->Type!=pComp->Type )
+			continue;
+		switch(pComp->Type)
+		{
+			case ELE_FREE:
+			case ELE_UNUSABLE:
+				pElem->DynamicInput = CompiledStateOnLeft(Rung,pComp,0);
+				break;
+			case ELE_INPUT:
+			case ELE_INPUT_NOT:
+			case ELE_RISING_INPUT:
+			case ELE_FALLING_INPUT:
+				State = CalcContactState( pElem, pComp->Type==ELE_INPUT_NOT || pComp->Type==ELE_FALLING_INPUT,
+							pComp->Type==ELE_RISING_INPUT || pComp->Type==ELE_FALLING_INPUT );
+				if ( !(pComp->LeftRows[ 0 ] & ROWS_LEFT_RAIL) )
+				{
+					pElem->DynamicInput = CompiledStateOnLeft(Rung,pComp,0);
+					State = State && pElem->DynamicInput;
+				}
+				pElem->DynamicOutput = State;
+				break;
+			case ELE_CONNECTION:
+				State = 1;
+				if ( !(pComp->LeftRows[ 0 ] & ROWS_LEFT_RAIL) )
+				{
+					pElem->DynamicInput = CompiledStateOnLeft(Rung,pComp,0);
+					State = pElem->DynamicInput;
+				}
+				pElem->DynamicState = State;
+				pElem->DynamicOutput = State;
+				break;
+			case ELE_OUTPUT:
+			case ELE_OUTPUT_NOT:
+				CalcCoil( pElem, CompiledStateOnLeft(Rung,pComp,0), pComp->Type==ELE_OUTPUT_NOT );
+				break;
+			case ELE_OUTPUT_SET:
+			case ELE_OUTPUT_RESET:
+				CalcCoilSetReset( pElem, CompiledStateOnLeft(Rung,pComp,0), pComp->Type==ELE_OUTPUT_RESET );
+				break;
+			case ELE_OUTPUT_JUMP:
+			case ELE_OUTPUT_CALL:
+				State = CompiledStateOnLeft(Rung,pComp,0);
+				pElem->DynamicInput = State;
+				pElem->DynamicState = State;
+				if ( State && pComp->Type==ELE_OUTPUT_JUMP )
+					JumpToRung = pElem->VarNum;
+				if ( State && pComp->Type==ELE_OUTPUT_CALL )
+				{
+					int SectionToCall = SearchSubRoutineWithItsNumber( pElem->VarNum );
+					if ( SectionToCall!=-1 )
+						RefreshSubRoutine( SectionToCall );
+				}
+				break;
+#ifdef OLD_TIMERS_MONOS_SUPPORT
+			case ELE_TIMER:
+				CalcTimerBlock( pElem, CompiledStateOnLeft(Rung,pComp,0), CompiledStateOnLeft(Rung,pComp,1) );
+				break;
+			case ELE_MONOSTABLE:
+				CalcMonostableBlock( pElem, CompiledStateOnLeft(Rung,pComp,0) );
+				break;
+#endif
+			case ELE_COUNTER:
+				for (Row=0;Row<4;Row++)
+					Inputs[ Row ] = CompiledStateOnLeft(Rung,pComp,Row);
+				CalcCounterBlock( pElem, Inputs );
+				break;
+			case ELE_TIMER_IEC:
+				CalcTimerIECBlock( pElem, CompiledStateOnLeft(Rung,pComp,0) );
+				break;
+			case ELE_COMPAR:
+				pCode = &ArithmCode[ pElem->VarNum ];
+				if ( pCode->Length>=0 )
+					State = EvalCompiledCompare( pCode );
+				else
+					State = EvalCompare( ArithmExpr[ pElem->VarNum ].Expr );
+				pElem->DynamicState = State;
+				if ( !(pComp->LeftRows[ 0 ] & ROWS_LEFT_RAIL) )
+				{
+					pInputElem = &Rung->Element[ pComp->PosiX-2 ][ (int)pComp->PosiY ];
+					pInputElem->DynamicInput = CompiledStateOnLeft(Rung,pComp,0);
+					State = State && pInputElem->DynamicInput;
+				}
+				pElem->DynamicOutput = State;
+				break;
+			case ELE_OUTPUT_OPERATE:
+				State = CompiledStateOnLeft(Rung,pComp,0);
+				if (State)
+				{
+					pCode = &ArithmCode[ pElem->VarNum ];
+					if ( pCode->Length>=0 )
+						MakeCompiledCalc( pCode );
+					else
+						MakeCalc( ArithmExpr[ pElem->VarNum ].Expr, FALSE /* verify mode */ );
+				}
+				pElem->DynamicInput = State;
+				pElem->DynamicState = State;
+				break;
+		}
+	}
+	*JumpTo = JumpToRung;
+	return TRUE;
+}
+
+#ifndef RTAPI
+/* compile the program in the bank not scanned and publish it */
+void CompileProgram( void )
+{
+	int NumRung;
+	int Bank;
+	int Wait = 0;
+	/* the realtime task can still scan with the bank published before */
+	/* until its next period, wait for it (if it is running...) */
+	while( atomic_load_explicit( &InfosGene->CompiledBankInUse, memory_order_acquire )!=InfosGene->CompiledBankPublished
+			&& InfosGene->CompiledBankPublished!=-1 && Wait++<100 )
+		DoPauseMilliSecs( 10 );
+	Bank = ( InfosGene->CompiledBankInUse==0 )?1:0;
+	SelectCompiledProgram( Bank );
+	for ( NumRung=0; NumRung<NBR_RUNGS; NumRung++ )
+	{
+		CompiledRungArray[ NumRung ].NbrElements = -1;
+		if ( RungArray[ NumRung ].Used )
+			CompileRung( &RungArray[ NumRung ], &CompiledRungArray[ NumRung ] );
+	}
+#ifdef SEQUENTIAL_SUPPORT
+	CompileSequential( );
+#endif
+	atomic_store_explicit( &InfosGene->CompiledBankPublished, Bank, memory_order_release );
+}
+#endif
+
+/* called by the realtime task at each period, swap to the last bank published */
+void TakeCompiledProgram( void )
+{
+	int Bank = atomic_load_explicit( &InfosGene->CompiledBankPublished, memory_order_acquire );
+	if ( Bank!=InfosGene->CompiledBankInUse )
+	{
+		if ( Bank!=-1 )
+			SelectCompiledProgram( Bank );
+		atomic_store_explicit( &InfosGene->CompiledBankInUse, Bank, memory_order_release );
+	}
+}
+
+
 // we refresh all the rungs of this section.
 // we can (J)ump to another rung in this section.
 // we can arrive here with a sub-routine (C)all coil (another section, recursively) !
@@ -800,7 +1103,10 @@ void RefreshASection( StrSection * pSection )
 	int MadLoopBreak = 0;
 	do
 	{
-		RefreshRung(&RungArray[NumRung], &Goto);
+		if ( UseCompiledProgram && CompiledRungArray[ NumRung ].NbrElements>=0 )
+			RefreshCompiledRung(&RungArray[NumRung], &CompiledRungArray[NumRung], &Goto);
+		else
+			RefreshRung(&RungArray[NumRung], &Goto);
 
 		if ( Goto!=-1 )
 		{
@@ -830,12 +1136,15 @@ void RefreshASection( StrSection * pSection )
 }
 
 // All the sections 'main' are refreshed in the order defined.
+// With CompiledScan, with the compiled program if one has been published.
 #define SR_STACK 25
-void ClassicLadder_RefreshAllSections()
+void ClassicLadder_RefreshAllSections( char CompiledScan )
 {
 	int ScanMainSection;
 	StrSection * pScanSection;
 
+	UseCompiledProgram = CompiledScan && InfosGene->CompiledBankInUse!=-1;
+
 	CycleStart();
 
 	for ( ScanMainSection=0; ScanMainSection<NBR_SECTIONS; ScanMainSection++ )
@@ -854,7 +1163,10 @@ void ClassicLadder_RefreshAllSections()
 		// current section defined and is in sequential language
 		if ( pScanSection->Used && pScanSection->Language==SECTION_IN_SEQUENTIAL )
 		{
-			RefreshSequentialPage( pScanSection->SequentialPage );
+			if ( UseCompiledProgram )
+				RefreshCompiledSequentialPage( pScanSection->SequentialPage );
+			else
+				RefreshSequentialPage( pScanSection->SequentialPage );
 		}
 #endif
 
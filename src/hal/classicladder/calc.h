@@ -29,6 +29,20 @@ void InitArithmExpr(void);
 void InitIOConf( void );
 int ReadVarForElement( StrElement * pElem );
 void WriteVarForElement( StrElement *pElem, int Value );
+char CalcContactState(StrElement * pElem,char IsNot,char OnlyFronts);
+void CalcCoil(StrElement * pElem,char State,char IsNot);
+void CalcCoilSetReset(StrElement * pElem,char State,char IsReset);
+#ifdef OLD_TIMERS_MONOS_SUPPORT
+void CalcTimerBlock(StrElement * pElem,char InputEnable,char InputControl);
+void CalcMonostableBlock(StrElement * pElem,char Input);
+#endif
+void CalcCounterBlock(StrElement * pElem,char * Inputs);
+void CalcTimerIECBlock(StrElement * pElem,char Input);
+void RefreshSubRoutine( int SectionToCall );
+int CompileRung(StrRung * Rung, StrCompiledRung * Compiled);
+int RefreshCompiledRung(StrRung * Rung, StrCompiledRung * Compiled, int * JumpTo);
+void CompileProgram( void );
+void TakeCompiledProgram( void );
 void RefreshASection( StrSection * pSection );
-void ClassicLadder_RefreshAllSections(void);
+void ClassicLadder_RefreshAllSections( char CompiledScan );
 void CopyRungToRung(StrRung * RungSrc,StrRung * RungDest);
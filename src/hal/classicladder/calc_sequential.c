@@ -180,3 +180,67 @@ void RefreshSequentialPage( int PageNbr )
 	RefreshStepsVars( );
 }
 
+#ifndef RTAPI
+/* list the transitions of each page and the steps used */
+/* (done by the user space part when the program changes, see calc.c) */
+void CompileSequential( void )
+{
+	int NumPage;
+	int ScanTransi;
+	int NumStep;
+	int NbrTransi = 0;
+	for( NumPage=0; NumPage<NBR_SEQUENTIAL_PAGES; NumPage++ )
+	{
+		CompiledSequential->FirstTransi[ NumPage ] = NbrTransi;
+		for( ScanTransi=0; ScanTransi<NBR_TRANSITIONS; ScanTransi++ )
+		{
+			if( Sequential->Transition[ ScanTransi ].NumPage==NumPage )
+				CompiledSequential->Transi[ NbrTransi++ ] = ScanTransi;
+		}
+	}
+	CompiledSequential->FirstTransi[ NBR_SEQUENTIAL_PAGES ] = NbrTransi;
+	CompiledSequential->NbrSteps = 0;
+	for( NumStep=0; NumStep<NBR_STEPS; NumStep++ )
+	{
+		if ( Sequential->Step[ NumStep ].NumPage!=-1 )
+			CompiledSequential->Step[ CompiledSequential->NbrSteps++ ] = NumStep;
+	}
+}
+#endif
+
+/* same as RefreshSequentialPage(), with the lists of CompileSequential() */
+void RefreshCompiledSequentialPage( int PageNbr )
+{
+	int ScanTransi;
+	int ScanStep;
+	StrStep * pStep;
+	int StateChanged;
+	int LoopSecurity = 0;
+	if ( PageNbr<0 || PageNbr>=NBR_SEQUENTIAL_PAGES )
+	{
+		RefreshSequentialPage( PageNbr );
+		return;
+	}
+	/* we loop here while some transitions have changed of state */
+	do
+	{
+		StateChanged = FALSE;
+		for( ScanTransi=CompiledSequential->FirstTransi[ PageNbr ]; ScanTransi<CompiledSequential->FirstTransi[ PageNbr+1 ]; ScanTransi++ )
+		{
+			if ( RefreshTransi( &Sequential->Transition[ CompiledSequential->Transi[ ScanTransi ] ] ) )
+				StateChanged = TRUE;
+		}
+		LoopSecurity++;
+	}
+	while( StateChanged && LoopSecurity<50 );
+	for( ScanStep=0; ScanStep<CompiledSequential->NbrSteps; ScanStep++ )
+	{
+		pStep = &Sequential->Step[ CompiledSequential->Step[ ScanStep ] ];
+		if ( pStep->Activated )
+			pStep->TimeActivated += InfosGene->GeneralParams.PeriodicRefreshMilliSecs;
+		else
+			pStep->TimeActivated = 0;
+		WriteVar( VAR_STEP_ACTIVITY, pStep->StepNumber, pStep->Activated );
+		WriteVar( VAR_STEP_TIME, pStep->StepNumber, pStep->TimeActivated/1000 );
+	}
+}
@@ -16,3 +16,5 @@
 void InitSequential( void );
 void PrepareSequential( void );
 void RefreshSequentialPage( int PageNbr );
+void CompileSequential( void );
+void RefreshCompiledSequentialPage( int PageNbr );
@@ -245,6 +245,25 @@ typedef struct StrRung
 	StrElement Element[RUNG_WIDTH][RUNG_HEIGHT];
 }StrRung;
 
+/* A rung compiled for the scan : the elements to refresh, in the order */
+/* RefreshRung() visits them, each with the rows on its left it depends on. */
+/* The free cells are only kept where a vertical connection is drawn. */
+#define ROWS_LEFT_RAIL 0x80	/* directly connected to the "left" */
+typedef struct StrCompiledElement
+{
+	char Type;
+	char PosiX;
+	char PosiY;
+	char LeftX;	/* column whose outputs are the states on left */
+	unsigned char LeftRows[ 4 ];	/* rows ORed for each input of the element */
+}StrCompiledElement;
+
+typedef struct StrCompiledRung
+{
+	int NbrElements;	/* -1 if not compiled, refreshed with RefreshRung() */
+	StrCompiledElement Element[ RUNG_WIDTH*RUNG_HEIGHT ];
+}StrCompiledRung;
+
 #ifdef OLD_TIMERS_MONOS_SUPPORT
 typedef struct StrTimer
 {
@@ -304,6 +323,14 @@ typedef struct StrArithmExpr
 	char Expr[ARITHM_EXPR_SIZE];
 }StrArithmExpr;
 
+/* An arithmetic expression compiled to a postfix code (see arithm_eval.c) */
+#define ARITHM_CODE_SIZE (2*ARITHM_EXPR_SIZE+8)
+typedef struct StrArithmCode
+{
+	int Length;	/* -1 if not compiled, evaluated from the string */
+	int Code[ ARITHM_CODE_SIZE ];
+}StrArithmCode;
+
 #define DEVICE_TYPE_NONE -1 //added in 0.9.4 because now we can have DEVICE_TYPE_DIRECT_CONFIG and FirstClassicLadderIO at -1 !!!
 #define DEVICE_TYPE_DIRECT_ACCESS 0	/* use inb( ) and outb( ) calls to read/write local inputs/outputs */
 #define DEVICE_TYPE_COMEDI 100	/* /dev/comedi0 and following */
@@ -351,6 +378,12 @@ typedef struct StrInfosGene
 	
 	int CurrentSection;
 
+	/* bank of the compiled program published by the user space part */
+	/* each time the program is loaded or edited (0 or 1, -1 if none), */
+	/* and the bank the realtime task scans with, taken at each period */
+	int CompiledBankPublished;
+	int CompiledBankInUse;
+
 	StrGeneralParams GeneralParams;
 	StrIOConf InputsConf[ NBR_INPUTS_CONF ];
 	StrIOConf OutputsConf[ NBR_OUTPUTS_CONF ];
@@ -491,6 +524,7 @@ void RunBackIfStopped( void );
 
 void ClassicLadder_InitAllDatas( void );
 int ClassicLadder_AllocAll( void );
+void SelectCompiledProgram( int Bank );
 void ClassicLadder_FreeAll( char CleanAndRemoveTmpDir );
 
 void UpdateSizesOfConvVarNameTable( void );
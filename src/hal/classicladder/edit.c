@@ -965,6 +965,7 @@ void ApplyRungEdited()
 RedrawSignalDrawingArea( );
 	autorize_prevnext_buttons(TRUE);
 	InfosGene->AskConfirmationToQuit = TRUE;
+	CompileProgram( );
 	InfosGene->HasBeenModifiedForExitCode = TRUE;
 }
 
@@ -35,6 +35,7 @@
 #include "edit.h"
 #include "editproperties_gtk.h"
 #include "classicladder_gtk.h"
+#include "calc.h"
 #include "calc_sequential.h"
 #include "vars_names.h"
 #include "edit_sequential.h"
@@ -144,6 +145,7 @@ void ApplySeqPageEdited()
 //	autorize_prevnext_buttons(TRUE);
 	PrepareSequential( );
 	InfosGene->AskConfirmationToQuit = TRUE;
+	CompileProgram( );
 	InfosGene->HasBeenModifiedForExitCode = TRUE;
 }
 
@@ -1508,6 +1508,7 @@ void LoadAllLadderDatas(char * DatasDirectory)
 #endif	
 
 //printf("Prepare all data before run...\n");
+	CompileProgram( );
 	PrepareAllDatasBeforeRun( );
 	// update the tags list of the variables that the user want to log (after to have load the config file...)
 	//InitVarsArrayLogTags( );
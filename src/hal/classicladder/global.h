@@ -41,11 +41,14 @@ extern StrMonostable * MonostableArray;
 extern StrCounter * CounterArray;
 extern StrTimerIEC * NewTimerArray;
 extern StrArithmExpr * ArithmExpr;
+extern StrCompiledRung * CompiledRungArray;
+extern StrArithmCode * ArithmCode;
 extern StrInfosGene * InfosGene;
 extern StrSection * SectionArray;
 #ifdef SEQUENTIAL_SUPPORT
 extern StrSequential *Sequential;
 extern StrSequential EditSeqDatas;
+extern StrCompiledSequential * CompiledSequential;
 #endif
 extern StrSymbol * SymbolArray;
 
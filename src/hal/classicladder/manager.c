@@ -29,6 +29,7 @@
 
 #include "classicladder.h"
 #include "global.h"
+#include "calc.h"
 #ifdef GTK_INTERFACE
 #include "edit.h"
 #endif
@@ -197,6 +198,7 @@ int AddSection( char * NewSectionName, int TypeLanguageSection, int SubRoutineNb
 		}
 #endif
 		InfosGene->AskConfirmationToQuit = TRUE;
+		CompileProgram( );
 		InfosGene->HasBeenModifiedForExitCode = TRUE;
 	}
 	return FreeFound;
@@ -262,6 +264,7 @@ void DelSection( int NumSec /*char * SectionNameToErase*/ )
 			RungArray[ InfosGene->LastRung ].Used = FALSE;
 		}
 		InfosGene->AskConfirmationToQuit = TRUE;
+		CompileProgram( );
 		InfosGene->HasBeenModifiedForExitCode = TRUE;
 	}
 }
@@ -302,6 +305,7 @@ void SwapSections( int SectionNbr1, int SectionNbr2 /*char * SectionName1, char
 		memcpy( pSection2, pSectionTemp, sizeof(StrSection) );
 		
 		InfosGene->AskConfirmationToQuit = TRUE;
+		CompileProgram( );
 		InfosGene->HasBeenModifiedForExitCode = TRUE;
 	}
 }
@@ -72,6 +72,7 @@ hal_bit_t **hal_outputs;
 hal_s32_t **hal_s32_inputs;
 hal_s32_t **hal_s32_outputs;
 hal_s32_t *hal_state;
+hal_bit_t *hal_compiled_scan;
 hal_float_t **hal_float_inputs;
 hal_float_t **hal_float_outputs;
 
@@ -144,6 +145,7 @@ static void hal_task(void *arg, long period) {
 		InfosGene->GeneralParams.PeriodicRefreshMilliSecs=milliseconds;
 		*hal_state = InfosGene->LadderState;
 		t0 = rtapi_get_time();
+		TakeCompiledProgram();
 		if (InfosGene->LadderState==STATE_RUN)
 			{
 				HalReadPhysicalInputs();
@@ -154,7 +156,7 @@ static void hal_task(void *arg, long period) {
 
 				InfosGene->HideGuiState = *hide_gui[0];
 
-				ClassicLadder_RefreshAllSections();
+				ClassicLadder_RefreshAllSections( *hal_compiled_scan );
 		
 				HalWritePhysicalOutputs();
 
@@ -192,6 +194,12 @@ error:
 		 return result;
 	}
 
+	hal_compiled_scan = hal_malloc(sizeof(hal_bit_t));
+	if(!hal_compiled_scan) { result = -ENOMEM; goto error; }
+	*hal_compiled_scan = 1;
+	result = hal_param_bit_new("classicladder.compiled-scan", HAL_RW, hal_compiled_scan, compId);
+	if(result < 0) goto error;
+
 	hal_inputs = hal_malloc(sizeof(hal_bit_t*) * numPhysInputs);
 	if(!hal_inputs) { result = -ENOMEM; goto error; }
 	hide_gui = hal_malloc(sizeof(hal_bit_t*));
@@ -116,4 +116,14 @@ typedef struct StrSequential
 	StrSeqComment SeqComment[ NBR_SEQ_COMMENTS ];
 }StrSequential;
 
+/* The transitions of each page and the steps used, listed when the */
+/* program is compiled, so that the scan does not look at the others */
+typedef struct StrCompiledSequential
+{
+	short int FirstTransi[ NBR_SEQUENTIAL_PAGES+1 ];
+	short int Transi[ NBR_TRANSITIONS ];
+	short int NbrSteps;
+	short int Step[ NBR_STEPS ];
+}StrCompiledSequential;
+
 
@@ -167,8 +167,16 @@ static void sample(void *arg, long period)
     }
     /* point at pins in hal shmem */
     pptr = samp->pins;
-    union hal_stream_data data[HAL_STREAM_MAX_PINS], *dptr=data;
-    /* copy data from HAL pins to fifo */
+    /* copy data from HAL pins straight into the fifo record */
+    union hal_stream_data *dptr;
+    if ( hal_stream_write_span(&samp->fifo, &dptr, 1) < 1 ) {
+	/* fifo is full, data is lost */
+        /* log the overrun */
+	(*samp->overruns)++;
+	*(samp->full) = 1;
+	*(samp->curr_depth) = hal_stream_maxdepth(&samp->fifo);
+	return;
+    }
     int num_pins = hal_stream_element_count(&samp->fifo);
     for ( n = 0 ; n < num_pins ; n++ ) {
 	switch ( hal_stream_element_type(&samp->fifo, n) ) {
@@ -194,16 +202,9 @@ static void sample(void *arg, long period)
 	dptr++;
 	pptr++;
     }
-    if ( hal_stream_write(&samp->fifo, data) < 0) {
-	/* fifo is full, data is lost */
-        /* log the overrun */
-	(*samp->overruns)++;
-	*(samp->full) = 1;
-	*(samp->curr_depth) = hal_stream_maxdepth(&samp->fifo);
-    } else {
-	*(samp->full) = 0;
-	*(samp->curr_depth) = hal_stream_depth(&samp->fifo);
-    }
+    hal_stream_write_commit(&samp->fifo, 1);
+    *(samp->full) = 0;
+    *(samp->curr_depth) = hal_stream_depth(&samp->fifo);
 }
 
 /***********************************************************************
@@ -61,6 +61,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <ctype.h>
 #include <string.h>
 #include <unistd.h>
@@ -107,7 +108,7 @@ static void quit(int sig)
 
 int main(int argc, char **argv)
 {
-    int n, channel, tag;
+    int n, channel, tag, binary;
     long int samples;
     unsigned this_sample, last_sample=0;
     char *cp, *cp2;
@@ -117,6 +118,7 @@ int main(int argc, char **argv)
     exitval = 1;
     channel = 0;
     tag = 0;
+    binary = 0;
     samples = -1;  /* -1 means run forever */
     /* FIXME - if I wasn't so lazy I'd learn how to use getopt() here */
     for ( n = 1 ; n < argc ; n++ ) {
@@ -148,6 +150,9 @@ int main(int argc, char **argv)
 	case 't':
 	    tag = 1;
 	    break;
+	case 'b':
+	    binary = 1;
+	    break;
 	default:
 	    fprintf(stderr,"ERROR: unknown option '%s'\n", cp );
 	    exit(1);
@@ -190,50 +195,68 @@ int main(int argc, char **argv)
 	goto out;
     }
     int num_pins = hal_stream_element_count(&stream);
+    int stride = hal_stream_stride(&stream);
     while ( samples != 0 ) {
-	union hal_stream_data buf[num_pins];
+	union hal_stream_data *buf;
+	int i, count;
 	hal_stream_wait_readable(&stream, &stop);
 	if(stop) break;
-	int res = hal_stream_read(&stream, buf, &this_sample);
-	if (res < 0) {
-	    errno = -res;
-	    perror("hal_stream_read");
-	    goto out;
-	}
-	++last_sample;
-	if ( this_sample != last_sample ) {
-	    printf ( "overrun\n");
-	    last_sample = this_sample;
-	}
-	if ( tag ) {
-	    printf ( "%u ", this_sample-1 );
-	}
-	for ( n = 0 ; n < num_pins; n++ ) {
-	    switch ( hal_stream_element_type(&stream, n) ) {
-	    case HAL_FLOAT:
-		printf ( "%f ", buf[n].f);
-		break;
-	    case HAL_BIT:
-		if ( buf[n].b ) {
-		    printf ( "1 " );
+	/* take everything that is waiting, up to the end of the fifo */
+	count = hal_stream_read_span(&stream, &buf,
+	    ( samples > 0 && samples < UINT_MAX ) ? samples : UINT_MAX);
+	for ( i = 0 ; i < count ; i++, buf += stride ) {
+	    this_sample = buf[num_pins].s;
+	    ++last_sample;
+	    if ( this_sample != last_sample ) {
+		if ( binary ) {
+		    fprintf ( stderr, "overrun\n");
 		} else {
-		    printf ( "0 " );
+		    printf ( "overrun\n");
+		}
+		last_sample = this_sample;
+	    }
+	    if ( binary ) {
+		/* the elements as they are in the fifo, native byte order */
+		if ( tag ) {
+		    union hal_stream_data tagdata;
+		    memset(&tagdata, 0, sizeof(tagdata));
+		    tagdata.u = this_sample-1;
+		    fwrite(&tagdata, sizeof(tagdata), 1, stdout);
+		}
+		fwrite(buf, sizeof(*buf), num_pins, stdout);
+		continue;
+	    }
+	    if ( tag ) {
+		printf ( "%u ", this_sample-1 );
+	    }
+	    for ( n = 0 ; n < num_pins; n++ ) {
+		switch ( hal_stream_element_type(&stream, n) ) {
+		case HAL_FLOAT:
+		    printf ( "%f ", buf[n].f);
+		    break;
+		case HAL_BIT:
+		    if ( buf[n].b ) {
+			printf ( "1 " );
+		    } else {
+			printf ( "0 " );
+		    }
+		    break;
+		case HAL_U32:
+		    printf ( "%lu ", (unsigned long)buf[n].u);
+		    break;
+		case HAL_S32:
+		    printf ( "%ld ", (long)buf[n].s);
+		    break;
+		default:
+		    /* better not happen */
+		    goto out;
 		}
-		break;
-	    case HAL_U32:
-		printf ( "%lu ", (unsigned long)buf[n].u);
-		break;
-	    case HAL_S32:
-		printf ( "%ld ", (long)buf[n].s);
-		break;
-	    default:
-		/* better not happen */
-		goto out;
 	    }
+	    printf ( "\n" );
 	}
-	printf ( "\n" );
+	hal_stream_read_commit(&stream, count);
 	if ( samples > 0 ) {
-	    samples--;
+	    samples -= count;
 	}
     }
     /* run was successful */
@@ -221,14 +221,14 @@ static void update(void *arg, long period)
 	(*str->underruns)++;
 	return;
     }
-    union hal_stream_data data[HAL_STREAM_MAX_PINS];
-    if(hal_stream_read(&str->fifo, data, NULL) < 0)
+    /* copy straight out of the fifo record, no intermediate buffer */
+    union hal_stream_data *dptr;
+    if(hal_stream_read_span(&str->fifo, &dptr, 1) < 1)
     {
         /* should not happen (single reader invariant) */
 	(*str->underruns)++;
 	return;
     }
-    union hal_stream_data *dptr = data;
     int num_pins = hal_stream_element_count(&str->fifo);
     /* copy data from fifo to HAL pins */
     for ( n = 0 ; n < num_pins ; n++ ) {
@@ -255,6 +255,7 @@ static void update(void *arg, long period)
 	dptr++;
 	pptr++;
     }
+    hal_stream_read_commit(&str->fifo, 1);
 }
 
 static int init_streamer(int num, streamer_t *str)
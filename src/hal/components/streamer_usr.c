@@ -64,6 +64,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <errno.h>
 
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "hal.h"                /* HAL public API decls */
@@ -73,6 +74,8 @@
 *                  LOCAL FUNCTION DECLARATIONS                         *
 ************************************************************************/
 
+static int stream_binary(hal_stream_t *stream);
+
 /***********************************************************************
 *                         GLOBAL VARIABLES                             *
 ************************************************************************/
@@ -99,10 +102,11 @@ static void quit(int sig)
 }
 
 #define BUF_SIZE 4000
+#define BIN_BUF_SIZE 65536
 
 int main(int argc, char **argv)
 {
-    int n, channel, line=0;
+    int n, channel, binary, line=0;
     char *cp, *cp2;
     hal_stream_t stream;
     char buf[BUF_SIZE];
@@ -111,6 +115,7 @@ int main(int argc, char **argv)
     /* set return code to "fail", clear it later if all goes well */
     exitval = 1;
     channel = 0;
+    binary = 0;
     for ( n = 1 ; n < argc ; n++ ) {
 	cp = argv[n];
 	if ( *cp != '-' ) {
@@ -127,6 +132,9 @@ int main(int argc, char **argv)
 		exit(1);
 	    }
 	    break;
+	case 'b':
+	    binary = 1;
+	    break;
 	default:
 	    fprintf(stderr,"ERROR: unknown option '%s'\n", cp );
 	    exit(1);
@@ -169,6 +177,13 @@ int main(int argc, char **argv)
 	perror("hal_stream_attach");
 	goto out;
     }
+    if ( binary ) {
+	if ( stream_binary(&stream) < 0 ) {
+	    goto out;
+	}
+	exitval = 0;
+	goto out;
+    }
     int num_pins = hal_stream_element_count(&stream);
     while ( fgets(buf, BUF_SIZE, stdin) ) {
 	/* skip comment lines */
@@ -255,3 +270,58 @@ out:
     }
     return exitval;
 }
+
+/***********************************************************************
+*                   LOCAL FUNCTION DEFINITIONS                         *
+************************************************************************/
+
+/* Binary input is records of hal_stream_element_count() elements of
+   union hal_stream_data, in native byte order.  Whatever read() returns
+   is copied into the fifo a span at a time, so the realtime side sees it
+   with one index update per span instead of one per record. */
+static int stream_binary(hal_stream_t *stream)
+{
+    static char buf[BIN_BUF_SIZE];
+    int num_pins = hal_stream_element_count(stream);
+    int stride = hal_stream_stride(stream);
+    size_t recsize = sizeof(union hal_stream_data) * num_pins;
+    size_t have = 0, done;
+    ssize_t len;
+    int n, count;
+
+    while ( 1 ) {
+	len = read(0, buf + have, sizeof(buf) - have);
+	if ( len < 0 ) {
+	    if ( errno == EINTR && !stop ) {
+		continue;
+	    }
+	    perror("read");
+	    return -1;
+	}
+	if ( len == 0 ) {
+	    if ( have != 0 ) {
+		fprintf(stderr, "ERROR: %zu bytes of incomplete record at end of input\n", have);
+		return -1;
+	    }
+	    return 0;
+	}
+	have += len;
+	done = 0;
+	while ( have - done >= recsize ) {
+	    union hal_stream_data *dptr;
+	    hal_stream_wait_writable(stream, &stop);
+	    if ( stop ) {
+		return 0;
+	    }
+	    count = hal_stream_write_span(stream, &dptr, (have - done) / recsize);
+	    for ( n = 0 ; n < count ; n++ ) {
+		memcpy(dptr, buf + done, recsize);
+		dptr += stride;
+		done += recsize;
+	    }
+	    hal_stream_write_commit(stream, count);
+	}
+	memmove(buf, buf + done, have - done);
+	have -= done;
+    }
+}
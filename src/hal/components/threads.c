@@ -16,7 +16,8 @@
     It will mostly be used for testing - when EMC is run normally,
     the motion module creates all the necessary threads.
     
-    The module has three pairs of parameters, "name1, period1", etc.
+    The module has three sets of parameters, "name1, period1, fp1,
+    cpus1, workers1, sched1", etc.
 */
 
 /** Copyright (C) 2003 John Kasunich
@@ -63,18 +64,36 @@ static int fp1 = 1;		/* use floating point? default = yes */
 RTAPI_MP_INT(fp1, "thread1 uses floating point");
 static long period1 = 1000000;	/* thread period - default = 1ms thread */
 RTAPI_MP_LONG(period1,  "thread1 period (nsecs)");
+static char *cpus1 = NULL;	/* CPUs to run on - default = same as the others */
+RTAPI_MP_STRING(cpus1, "thread1 CPU list, or spread");
+static int workers1 = 0;	/* helpers running functions in parallel - default = none */
+RTAPI_MP_INT(workers1, "thread1 parallel helpers");
+static char *sched1 = NULL;	/* scheduling - default = fifo, or RTAPI_SCHED */
+RTAPI_MP_STRING(sched1, "thread1 scheduling, e.g. deadline or timerfd");
 static char *name2 = NULL;	/* name of thread */
 RTAPI_MP_STRING(name2, "name of thread 2");
 static int fp2 = 1;		/* use floating point? default = yes */
 RTAPI_MP_INT(fp2, "thread2 uses floating point");
 static long period2 = 0;	/* thread period - default = no thread */
 RTAPI_MP_LONG(period2, "thread2 period (nsecs)");
+static char *cpus2 = NULL;	/* CPUs to run on - default = same as the others */
+RTAPI_MP_STRING(cpus2, "thread2 CPU list, or spread");
+static int workers2 = 0;	/* helpers running functions in parallel - default = none */
+RTAPI_MP_INT(workers2, "thread2 parallel helpers");
+static char *sched2 = NULL;	/* scheduling - default = fifo, or RTAPI_SCHED */
+RTAPI_MP_STRING(sched2, "thread2 scheduling, e.g. deadline or timerfd");
 static char *name3 = NULL;	/* name of thread */
 RTAPI_MP_STRING(name3, "name of thread 3");
 static int fp3 = 1;		/* use floating point? default = yes */
 RTAPI_MP_INT(fp3, "thread3 uses floating point");
 static long period3 = 0;	/* thread period - default = no thread */
 RTAPI_MP_LONG(period3, "thread3 period (nsecs)");
+static char *cpus3 = NULL;	/* CPUs to run on - default = same as the others */
+RTAPI_MP_STRING(cpus3, "thread3 CPU list, or spread");
+static int workers3 = 0;	/* helpers running functions in parallel - default = none */
+RTAPI_MP_INT(workers3, "thread3 parallel helpers");
+static char *sched3 = NULL;	/* scheduling - default = fifo, or RTAPI_SCHED */
+RTAPI_MP_STRING(sched3, "thread3 scheduling, e.g. deadline or timerfd");
 
 /***********************************************************************
 *                STRUCTURES AND GLOBAL VARIABLES                       *
@@ -107,7 +126,7 @@ int rtapi_app_main(void)
     /* was 'period' specified in the insmod command? */
     if ((period1 > 0) && (name1 != NULL) && (*name1 != '\0')) {
 	/* create a thread */
-	thread1_id = hal_create_thread(name1, period1, fp1);
+	thread1_id = hal_create_thread_cpus(name1, period1, fp1, cpus1);
 	if (thread1_id < 0) {
 	    rtapi_print_msg(RTAPI_MSG_ERR,
 		"THREADS: ERROR: could not create thread '%s'\n", name1);
@@ -116,10 +135,18 @@ int rtapi_app_main(void)
 	} else {
 	    rtapi_print_msg(RTAPI_MSG_INFO, "THREADS: created %ld uS thread\n", period1 / 1000);
 	}
+	if (hal_thread_parallel(name1, workers1, NULL) < 0
+	    || hal_thread_sched(name1, sched1) < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"THREADS: ERROR: could not set up thread '%s'\n", name1);
+        hal_exit(thread1_id);
+	    hal_exit(comp_id);
+	    return -1;
+	}
     }
     if ((period2 > 0) && (name2 != NULL) && (*name2 != '\0')) {
 	/* create a thread */
-	thread2_id = hal_create_thread(name2, period2, fp2);
+	thread2_id = hal_create_thread_cpus(name2, period2, fp2, cpus2);
 	if (thread2_id < 0) {
 	    rtapi_print_msg(RTAPI_MSG_ERR,
 		"THREADS: ERROR: could not create thread '%s'\n", name2);
@@ -129,10 +156,19 @@ int rtapi_app_main(void)
 	} else {
 	    rtapi_print_msg(RTAPI_MSG_INFO, "THREADS: created %ld uS thread\n", period2 / 1000);
 	}
+	if (hal_thread_parallel(name2, workers2, NULL) < 0
+	    || hal_thread_sched(name2, sched2) < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"THREADS: ERROR: could not set up thread '%s'\n", name2);
+        hal_exit(thread1_id);
+        hal_exit(thread2_id);
+	    hal_exit(comp_id);
+	    return -1;
+	}
     }
     if ((period3 > 0) && (name3 != NULL) && (*name3 != '\0')) {
 	/* create a thread */
-	thread3_id = hal_create_thread(name3, period3, fp3);
+	thread3_id = hal_create_thread_cpus(name3, period3, fp3, cpus3);
 	if (thread3_id < 0) {
 	    rtapi_print_msg(RTAPI_MSG_ERR,
 		"THREADS: ERROR: could not create thread '%s'\n", name3);
@@ -143,6 +179,16 @@ int rtapi_app_main(void)
 	} else {
 	    rtapi_print_msg(RTAPI_MSG_INFO, "THREADS: created %ld uS thread\n", period3 / 1000);
 	}
+	if (hal_thread_parallel(name3, workers3, NULL) < 0
+	    || hal_thread_sched(name3, sched3) < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"THREADS: ERROR: could not set up thread '%s'\n", name3);
+        hal_exit(thread1_id);
+        hal_exit(thread2_id);
+        hal_exit(thread3_id);
+	    hal_exit(comp_id);
+	    return -1;
+	}
     }
     hal_ready(comp_id);
     return 0;
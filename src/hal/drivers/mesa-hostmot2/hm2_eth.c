@@ -20,6 +20,7 @@
 #include <sys/fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <linux/sockios.h>
 #include <net/if_arp.h>
 #include <netinet/in.h>
@@ -642,6 +643,12 @@ int ioctl_siocdarp(void *arg) {
     return ioctl(board->sockfd, SIOCDARP, &board->req);
 }
 
+// an LBP16 emulator on this machine, as used by the tests: there is no ARP
+// on the loopback interface and nothing to keep away from the board
+static bool is_loopback(hm2_eth_t *board) {
+    return (ntohl(board->server_addr.sin_addr.s_addr) >> 24) == 127;
+}
+
 static int init_board(hm2_eth_t *board, const char *board_ip) {
     int ret;
 
@@ -663,7 +670,7 @@ static int init_board(hm2_eth_t *board, const char *board_ip) {
         return -errno;
     }
 
-    if(!use_iptables()) {
+    if(!is_loopback(board) && !use_iptables()) {
         LL_PRINT(\
 "WARNING: Unable to restrict other access to the hm2-eth device.\n"
 "This means that other software using the same network interface can violate\n"
@@ -687,6 +694,12 @@ static int init_board(hm2_eth_t *board, const char *board_ip) {
         return -errno;
     }
 
+    board->write_packet_ptr = board->write_packet;
+    board->read_packet_ptr = board->read_packet;
+
+    if(is_loopback(board))
+        return 0;
+
     memset(&board->req, 0, sizeof(board->req));
     struct sockaddr_in *sin;
 
@@ -715,9 +728,6 @@ static int init_board(hm2_eth_t *board, const char *board_ip) {
         if(ret < 0) return ret;
     }
 
-    board->write_packet_ptr = board->write_packet;
-    board->read_packet_ptr = board->read_packet;
-
     return 0;
 }
 
@@ -809,6 +819,8 @@ static int hm2_eth_read(hm2_lowlevel_io_t *this, rtapi_u32 addr, void *buffer, i
     return 1;  // success
 }
 
+static int hm2_eth_flush_writes(hm2_eth_t *board);
+
 static int hm2_eth_send_queued_reads(hm2_lowlevel_io_t *this) {
     hm2_eth_t *board = this->private;
     int send;
@@ -837,7 +849,26 @@ static int hm2_eth_send_queued_reads(hm2_lowlevel_io_t *this) {
     board->queue_reads_count++;
     board->queue_buff_size += 8;
 
-    send = eth_socket_send(board->sockfd, (void*) &board->read_packet, board->read_packet_ptr - board->read_packet, 0);
+    int read_size = board->read_packet_ptr - board->read_packet;
+    if(board->write_pending
+            && board->write_packet_size + read_size <= HM2_ETH_MAX_PACKET) {
+        // the writes of the last cycle go first in the same datagram, the
+        // board executes the commands in order
+        struct iovec iov[2] = {
+            { board->write_packet, board->write_packet_size },
+            { board->read_packet, read_size },
+        };
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+        send = sendmsg(board->sockfd, &msg, 0);
+        board->write_packet_ptr = board->write_packet;
+        board->write_packet_size = 0;
+        board->write_pending = false;
+    } else {
+        if(board->write_pending && !hm2_eth_flush_writes(board))
+            return 0;
+        send = eth_socket_send(board->sockfd, (void*) &board->read_packet, read_size, 0);
+    }
+    board->read_sent_time = rtapi_get_time();
     if(send < 0) {
         LL_PRINT("ERROR: sending packet: %s\n", strerror(errno));
         return 0;
@@ -873,6 +904,17 @@ static void decrement_soft_error(hm2_eth_t *board) {
     *board->hal->packet_error_exceeded = 0;
 }
 
+static long hm2_eth_read_timeout(hm2_eth_t *board) {
+    long read_timeout = board->hal ? board->hal->read_timeout : 1600000;
+    if(read_timeout <= 0)//less than or equal to 0, use 80% of the thread period.
+        read_timeout = 80;
+    if(read_timeout < 100)//less than 100 is interpreted as a percentage of the thread period.
+        read_timeout = rtapi_div_s64(read_timeout * (unsigned long long)board->llio.period, 100);
+    if(read_timeout < 100000)//Interpret as nanoseconds
+        read_timeout = 100000;
+    return read_timeout;
+}
+
 static int hm2_eth_receive_queued_reads(hm2_lowlevel_io_t *this) {
     hm2_eth_t *board = this->private;
     int recv, i = 0;
@@ -888,16 +930,8 @@ static int hm2_eth_receive_queued_reads(hm2_lowlevel_io_t *this) {
         board->comm_error_counter = 0;
     }
 
-    long read_timeout = board->hal ? board->hal->read_timeout : 1600000;
-    if(read_timeout <= 0)//less than or equal to 0, use 80% of the thread period.
-        read_timeout = 80;
-    if(read_timeout < 100)//less than 100 is interpreted as a percentage of the thread period.
-        read_timeout = rtapi_div_s64(read_timeout * (unsigned long long)board->llio.period, 100);
-    if(read_timeout < 100000)//Interpret as nanoseconds
-        read_timeout = 100000;
- 
     if(!board->hal) this->read_time = t1;
-    unsigned long long read_deadline = this->read_time + read_timeout;
+    unsigned long long read_deadline = this->read_time + hm2_eth_read_timeout(board);
     do {
 do_recv_packet:
         errno = 0;
@@ -927,6 +961,13 @@ do_recv_packet:
     board->queue_reads_count = 0;
     board->queue_buff_size = 0;
 
+    if(board->hal) {
+        rtapi_u32 rtt = t2 - board->read_sent_time;
+        *board->hal->round_trip_time = rtt;
+        if(rtt > *board->hal->round_trip_time_max)
+            *board->hal->round_trip_time_max = rtt;
+    }
+
     int result = 1;
     // (this means that one in 2^32 lost writes will not be diagnosed,
     // each time board->write_cnt overflows)
@@ -938,6 +979,18 @@ do_recv_packet:
     return result;
 }
 
+// true when hm2_eth_receive_queued_reads would not wait: the reply is
+// there, or it is too late for it
+static int hm2_eth_queued_reads_ready(hm2_lowlevel_io_t *this) {
+    hm2_eth_t *board = this->private;
+    unsigned long long read_deadline = this->read_time + hm2_eth_read_timeout(board);
+    rtapi_u8 peek;
+
+    if(eth_socket_recv(board->sockfd, &peek, 1, MSG_PEEK | MSG_DONTWAIT) >= 0)
+        return 1;
+    return (unsigned long long)rtapi_get_time() >= read_deadline;
+}
+
 static int hm2_eth_reset(hm2_lowlevel_io_t *this) {
     LL_PRINT("in hm2_eth_reset\n");
 
@@ -996,8 +1049,6 @@ static int hm2_eth_write(hm2_lowlevel_io_t *this, rtapi_u32 addr, const void *bu
 }
 
 static int hm2_eth_send_queued_writes(hm2_lowlevel_io_t *this) {
-    int send;
-    long long t0, t1;
     hm2_eth_t *board = this->private;
 
     board->write_cnt++;
@@ -1008,7 +1059,19 @@ static int hm2_eth_send_queued_writes(hm2_lowlevel_io_t *this) {
     memcpy(board->write_packet_ptr, &board->write_cnt, 4);
     board->write_packet_ptr += 4;
     board->write_packet_size += (sizeof(*packet) + 4);
-    
+
+    // in the servo thread, keep the packet for the next read request
+    if(board->hal && board->hal->combine_writes && rtapi_task_self() >= 0) {
+        board->write_pending = true;
+        return 1;
+    }
+    return hm2_eth_flush_writes(board);
+}
+
+static int hm2_eth_flush_writes(hm2_eth_t *board) {
+    int send;
+    long long t0, t1;
+
     t0 = rtapi_get_time();
     send = eth_socket_send(board->sockfd, (void*) &board->write_packet, board->write_packet_size, 0);
     if(send < 0) {
@@ -1019,6 +1082,7 @@ static int hm2_eth_send_queued_writes(hm2_lowlevel_io_t *this) {
     LL_PRINT_IF(debug, "enqueue_write(%d) : PACKET SEND [SIZE: %d | TIME: %llu]\n", board->write_cnt, send, t1 - t0);
     board->write_packet_ptr = board->write_packet;
     board->write_packet_size = 0;
+    board->write_pending = false;
     return 1;
 }
 
@@ -1026,6 +1090,8 @@ static int hm2_eth_enqueue_write(hm2_lowlevel_io_t *this, rtapi_u32 addr, const
     hm2_eth_t *board = this->private;
     if (comm_active == 0) return 1;
     if (size == 0) return 1;
+    // the last packet never went out with a read request
+    if (board->write_pending && !hm2_eth_flush_writes(board)) return 0;
     lbp16_cmd_addr *packet = (lbp16_cmd_addr *) board->write_packet_ptr;
 
     // XXX this is missing a check for exceeding the maximum packet size!
@@ -1455,6 +1521,7 @@ static int hm2_eth_probe(hm2_eth_t *board) {
     board->llio.queue_read = hm2_eth_enqueue_read;
     board->llio.send_queued_reads = hm2_eth_send_queued_reads;
     board->llio.receive_queued_reads = hm2_eth_receive_queued_reads;
+    board->llio.queued_reads_ready = hm2_eth_queued_reads_ready;
     board->llio.queue_write = hm2_eth_enqueue_write;
     board->llio.send_queued_writes = hm2_eth_send_queued_writes;
     if (strncmp(board_name, "litehm2", 7) == 0)
@@ -1541,9 +1608,41 @@ static int hm2_eth_items(hm2_eth_t *board) {
         return r;
     *board->hal->packet_error_exceeded = 0;
 
+    if((r = hal_param_bit_newf(HAL_RW,
+            &board->hal->combine_writes,
+            board->llio.comp_id,
+            "%s.combine-writes",
+            board->llio.name)) < 0)
+        return r;
+    board->hal->combine_writes = 0;
+
+    if((r = hal_pin_u32_newf(HAL_OUT,
+            &board->hal->round_trip_time,
+            board->llio.comp_id,
+            "%s.round-trip-time",
+            board->llio.name)) < 0)
+        return r;
+    *board->hal->round_trip_time = 0;
+
+    if((r = hal_pin_u32_newf(HAL_IO,
+            &board->hal->round_trip_time_max,
+            board->llio.comp_id,
+            "%s.round-trip-time-max",
+            board->llio.name)) < 0)
+        return r;
+    *board->hal->round_trip_time_max = 0;
+
     return 0;
 }
 
+static hm2_lowlevel_io_t *board_llio[MAX_ETH_BOARDS];
+
+// the .read of all the boards, their round trips overlap
+static void hm2_eth_read_all(void *arg, long period) {
+    (void)arg;
+    hm2_read_boards(board_llio, boards_count, period);
+}
+
 int rtapi_app_main(void) {
     RTAPI_INIT_LIST_HEAD(&ifnames);
     RTAPI_INIT_LIST_HEAD(&board_num);
@@ -1581,16 +1680,23 @@ int rtapi_app_main(void) {
 
         if (ret < 0)
             goto error;
+
+        board_llio[i] = &boards[i].llio;
     }
 
+    ret = hal_export_funct(HM2_LLIO_NAME ".read-all", hm2_eth_read_all, NULL, 1, 0, comp_id);
+    if (ret < 0)
+        goto error;
+
     for(i = 0; i<num_boards; i++) {
         char ifbuf[64]; // more than enough for eth0
+        boards[i].read_cnt = boards[i].write_cnt = 0;
+        if(is_loopback(&boards[i])) continue;
         char *ifptr = fetch_ifname(boards[i].sockfd, ifbuf, sizeof(ifbuf));
         if(!ifptr) {
             LL_PRINT("failed to retrieve interface name for board");
             continue;
         } 
-        boards[i].read_cnt = boards[i].write_cnt = 0;
         int *added = kvlist_lookup(&ifnames, ifptr);
         if(!added)
             goto error;
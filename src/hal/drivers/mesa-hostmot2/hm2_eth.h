@@ -29,6 +29,10 @@
 
 #define MAX_ETH_READS 64
 
+// largest LBP16 datagram sent, a write packet and a read packet are only
+// combined into one datagram when they fit
+#define HM2_ETH_MAX_PACKET 1400
+
 typedef struct {
     void *buffer;
     int size;
@@ -42,20 +46,25 @@ typedef struct {
     struct sockaddr_in local_addr;
     struct sockaddr_in server_addr;
 
-    rtapi_u8 read_packet[1400];
+    rtapi_u8 read_packet[HM2_ETH_MAX_PACKET];
     rtapi_u8 *read_packet_ptr;
     hm2_read_queue_entry_t queue_reads[MAX_ETH_READS];
     int queue_reads_count;
     int queue_buff_size;
 
-    rtapi_u8 write_packet[1400];
+    rtapi_u8 write_packet[HM2_ETH_MAX_PACKET];
     rtapi_u8 *write_packet_ptr;
     int write_packet_size;
+    // the write packet waits to go out with the next read request
+    bool write_pending;
     uint32_t read_cnt, write_cnt;
     // these two fields must be kept together, they're read by a single
     // read-request
     uint32_t confirm_read_cnt, confirm_write_cnt;
 
+    // when the read request was sent, for the round trip time
+    unsigned long long read_sent_time;
+
     int comm_error_counter;
     uint16_t old_rxudpcount, rxudpcount;
     struct arpreq req;
@@ -69,6 +78,9 @@ typedef struct {
         hal_u32_t *packet_error_total;
         hal_s32_t *packet_error_level;
         hal_bit_t *packet_error_exceeded;
+        hal_bit_t combine_writes;
+        hal_u32_t *round_trip_time;
+        hal_u32_t *round_trip_time_max;
     } *hal;
 } hm2_eth_t;
 
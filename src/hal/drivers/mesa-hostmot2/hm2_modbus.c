@@ -207,6 +207,9 @@ typedef struct {
 	hal_bit_t *reset;		// Reset errors and re-enable on rising edge
 	hal_u32_t *error;		// Command error counter
 	hal_u32_t *errorcode;	// Last error code
+	hal_float_t *rate;		// Achieved completions per second
+	hal_u32_t *latency;		// Microseconds from due to completion
+	hal_u32_t *latencymax;	// Largest latency since reset
 } mbt_cmd_hal_t;
 
 typedef struct {
@@ -233,6 +236,10 @@ typedef struct {
 	hm2_modbus_mbccb_cmds_t cmd;	// In host order
 	hm2_modbus_mbccb_type_t *typeptr;	// The types for this command
 	rtapi_s64	interval;			// The running interval of this command
+	rtapi_s64	due;	// When the command became ripe (see inst->now)
+	rtapi_s64	done;	// When the command last completed, 0 if never
+	double		avgperiod;	// Filtered time between completions
+	unsigned	pickseq;	// Last scheduling round that tried this command
 	int pinref;		// What pin to start with
 	bool disabled;	// Skipped if set
 	bool prevreset;	// To track the rising edge
@@ -271,6 +278,9 @@ typedef struct {
 	hm2_modbus_cmd_t *_cmds;	// List of commands sent in loop
 	hm2_modbus_cmd_t *cmds;		// List of commands sent in loop *or* inits at startup
 	unsigned cmdidx;			// Where are we in the list
+	bool sequential;			// Run the list in order, it has delay commands
+	unsigned pickseq;			// Scheduling round counter
+	rtapi_s64 now;				// Nanoseconds since start
 
 	hm2_pktuart_config_t cfg_rx;	// Receiver config
 	hm2_pktuart_config_t cfg_tx;	// Transmitter config
@@ -585,6 +595,42 @@ static void write_flush(hm2_modbus_inst_t *inst)
 	inst->cmds = oldcmds;
 }
 
+//
+// Handle the rising edges of a command's reset and disable pins.
+//
+static void check_cmd_pins(hm2_modbus_inst_t *inst, unsigned i)
+{
+	// Reset the individual commands on request.
+	bool b = !!*(inst->hal->cmds[i].reset);
+	if(inst->cmds[i].prevreset != b) {
+		inst->cmds[i].prevreset = !inst->cmds[i].prevreset;
+		if(inst->cmds[i].prevreset) {
+			inst->cmds[i].disabled = 0;
+			inst->cmds[i].errors   = 0;
+			*(inst->hal->cmds[i].disabled)  = 0;
+			*(inst->hal->cmds[i].error)     = 0;
+			*(inst->hal->cmds[i].errorcode) = 0;
+			*(inst->hal->cmds[i].latencymax) = 0;
+			// Honor the writeflush flag when coming out of disable.
+			write_flush_cmd(inst, i);
+		}
+	}
+
+	// The run-time disabling of a command takes precedens over reset.
+	// Set it on the rising edge of the 'disable' pin
+	b = !!*(inst->hal->cmds[i].disable);
+	if(inst->cmds[i].prevdisable != b) {
+		inst->cmds[i].prevdisable = !inst->cmds[i].prevdisable;
+		if(inst->cmds[i].prevdisable) {
+			inst->cmds[i].disabled = 1;
+			inst->cmds[i].errors   = 0;
+			*(inst->hal->cmds[i].disabled)  = 1;
+			*(inst->hal->cmds[i].error)     = 0;
+			*(inst->hal->cmds[i].errorcode) = EAGAIN;
+		}
+	}
+}
+
 //
 // Advance to the next command in the list
 // A switch to the normal command list is made when it is the end of initlist.
@@ -604,40 +650,15 @@ static inline int next_command(hm2_modbus_inst_t *inst)
 		return 0;
 	}
 
+	// The scheduler picks the commands itself, see pick_command()
+	if(!inst->sequential)
+		return 0;
+
 	// Find the next non-disabled command
 	do {
 		inst->cmdidx++;
-
-		// Reset the individual commands on request.
 		// Using modulo index ensures we also reset index zero when we wrap.
-		unsigned i = inst->cmdidx % inst->ncmds;
-		bool b = !!*(inst->hal->cmds[i].reset);
-		if(inst->cmds[i].prevreset != b) {
-			inst->cmds[i].prevreset = !inst->cmds[i].prevreset;
-			if(inst->cmds[i].prevreset) {
-				inst->cmds[i].disabled = 0;
-				inst->cmds[i].errors   = 0;
-				*(inst->hal->cmds[i].disabled)  = 0;
-				*(inst->hal->cmds[i].error)     = 0;
-				*(inst->hal->cmds[i].errorcode) = 0;
-				// Honor the writeflush flag when coming out of disable.
-				write_flush_cmd(inst, i);
-			}
-		}
-
-		// The run-time disabling of a command takes precedens over reset.
-		// Set it on the rising edge of the 'disable' pin
-		b = !!*(inst->hal->cmds[i].disable);
-		if(inst->cmds[i].prevdisable != b) {
-			inst->cmds[i].prevdisable = !inst->cmds[i].prevdisable;
-			if(inst->cmds[i].prevdisable) {
-				inst->cmds[i].disabled = 1;
-				inst->cmds[i].errors   = 0;
-				*(inst->hal->cmds[i].disabled)  = 1;
-				*(inst->hal->cmds[i].error)     = 0;
-				*(inst->hal->cmds[i].errorcode) = EAGAIN;
-			}
-		}
+		check_cmd_pins(inst, inst->cmdidx % inst->ncmds);
 	} while(inst->cmdidx < inst->ncmds && inst->cmds[inst->cmdidx].disabled);
 
 	if(inst->cmdidx >= inst->ncmds) {
@@ -728,6 +749,140 @@ static void do_timeout(hm2_modbus_inst_t *inst)
 	}
 }
 
+//
+// Select the command to send next.
+// Of the ripe commands, the one with a repeat interval that is closest to
+// missing its next period is chosen (earliest deadline first). The 'once'
+// commands are due immediately. Commands with a zero interval are sent as
+// fast as possible, but only when no other command is ripe, and the one
+// waiting longest goes first. That way, slow commands never hold up fast ones.
+// Each command is tried only once per scheduling round (inst->pickseq).
+// Returns the command index, -EAGAIN if nothing is ripe or -ENODATA if all
+// commands are disabled.
+//
+static int pick_command(hm2_modbus_inst_t *inst)
+{
+	int best = -1;
+	bool bestrate = false;
+	rtapi_s64 bestdl = 0;
+	bool enabled = false;
+
+	for(unsigned i = 0; i < inst->ncmds; i++) {
+		check_cmd_pins(inst, i);
+		const hm2_modbus_cmd_t *cc = &inst->cmds[i];
+		if(cc->disabled)
+			continue;
+		enabled = true;
+		if(cc->interval >= 0 || cc->pickseq == inst->pickseq)
+			continue;
+		bool hasrate = cc->cmd.cinterval != 0;
+		rtapi_s64 dl = cc->interval;
+		if(hasrate && cc->cmd.cinterval != 0xffffffff)
+			dl += (rtapi_s64)cc->cmd.cinterval * 1000;
+		if(best >= 0 && bestrate && !hasrate)
+			continue;
+		if(best < 0 || hasrate != bestrate || dl < bestdl) {
+			best = i;
+			bestrate = hasrate;
+			bestdl = dl;
+		}
+	}
+	if(best < 0)
+		return enabled ? -EAGAIN : -ENODATA;
+	return best;
+}
+
+//
+// Prepare and send the current command.
+// Returns 1 if the command was sent, 0 if there was nothing to send and the
+// next command may be tried, or -1 if the PktUART is being reset.
+//
+static int start_command(hm2_modbus_inst_t *inst)
+{
+	hm2_modbus_cmd_t *cc = current_cmd(inst);
+	int r;
+
+	// Remember when the command became due to measure its latency
+	cc->due = inst->now + cc->interval;
+
+	// Reset the command's interval timer. The 'once' commands will
+	// repeat every 292 years or so. If the command fails and needs a
+	// resend, then the interval is patched (see force_resend()).
+	// Reset to asap if the interval is shorter than the previous
+	// experienced delay.
+	if(cc->cmd.cinterval == 0xffffffff)
+		cc->interval = RTAPI_INT64_MAX;
+	else if((cc->interval += cc->cmd.cinterval * 1000) < 0)
+		cc->interval = -1;
+
+	if((r = build_data_frame(inst)) < 0) {
+		// We cannot recover from data frames that cannot be build. The
+		// next round would end in the same error. Therefore, disabling
+		// the command is our only option.
+		MSG_ERR("%s: error: Build data frame failed command %d, disabling\n", inst->name, inst->cmdidx);
+		cc->disabled = 1;
+		set_error(inst, -r);
+		return 0; // Just try next command
+	}
+	if(!r && !hasresend(cc))
+		return 0; // Nothing to do for this command, try next
+
+	// Data has changed or sending is forced
+	if((r = send_modbus_pkt(inst)) < 0) {
+		if(r == -EMSGSIZE) {
+			// We cannot recover if the error occurred because the
+			// buffer overflowed (no room for CRC). Resetting would
+			// just give us an infinite stream of errors because it
+			// would overflow in the next round too.
+			// We disable this particular command so it will not
+			// give problems again. It will probably cause havoc in
+			// the application, but that should be OK.
+			MSG_ERR("%s: error: Command %d disabled\n", inst->name, inst->cmdidx);
+			cc->disabled = 1;
+			set_error(inst, EMSGSIZE);
+			return 0; // Just try next command
+		}
+		MSG_ERR("%s: error: Send PDU failed (error %d) command %d, resetting\n", inst->name, r, inst->cmdidx);
+		force_resend(inst);
+		queue_reset(inst);
+		return -1;
+	}
+	set_state(inst, STATE_WAIT_FOR_SEND_COMPLETE);
+	return 1;
+}
+
+//
+// Update the rate and latency pins of the current command when it completed.
+//
+static void command_done(hm2_modbus_inst_t *inst)
+{
+	if(handling_inits(inst))
+		return;
+
+	hm2_modbus_cmd_t *cc = current_cmd(inst);
+	mbt_cmd_hal_t *hc = &inst->hal->cmds[inst->cmdidx];
+	rtapi_s64 lat = (inst->now - cc->due) / 1000;
+
+	if(lat < 0)
+		lat = 0;
+	else if(lat > 0xffffffff)
+		lat = 0xffffffff;
+	*(hc->latency) = lat;
+	if(*(hc->latency) > *(hc->latencymax))
+		*(hc->latencymax) = *(hc->latency);
+
+	// The period is filtered over the last few completions
+	if(cc->done && inst->now > cc->done) {
+		rtapi_s64 dt = inst->now - cc->done;
+		if(cc->avgperiod > 0)
+			cc->avgperiod += (dt - cc->avgperiod) * 0.25;
+		else
+			cc->avgperiod = dt;
+		*(hc->rate) = 1e9 / cc->avgperiod;
+	}
+	cc->done = inst->now;
+}
+
 //
 // The main process Modbus state-machine.
 //
@@ -764,10 +919,17 @@ static void process(void *arg, long period)
 	rtapi_u32 rxstatus = hm2_pktuart_get_rx_status(inst->uart);
 	rtapi_u32 txstatus = hm2_pktuart_get_tx_status(inst->uart);
 
+	inst->now += period;
+
 	if(!handling_inits(inst)) {
 		// Only count timeout when running the command list
 		for(unsigned i = 0; i < inst->ncmds; i++) {
-			inst->cmds[i].interval -= period;	// Keep counting nanoseconds
+			hm2_modbus_cmd_t *cc = &inst->cmds[i];
+			cc->interval -= period;	// Keep counting nanoseconds
+			// Let the rate drop when a command stops completing
+			rtapi_s64 idle = inst->now - cc->done;
+			if(cc->done && cc->avgperiod > 0 && idle > 2 * cc->avgperiod)
+				*(inst->hal->cmds[i].rate) = 1e9 / idle;
 		}
 
 		// Re-enable all commands on rising edge of global reset pin
@@ -783,6 +945,7 @@ static void process(void *arg, long period)
 					}
 					*(inst->hal->cmds[i].errorcode) = 0;
 					*(inst->hal->cmds[i].error)     = 0;
+					*(inst->hal->cmds[i].latencymax) = 0;
 					inst->cmds[i].errors = 0;
 				}
 			}
@@ -856,6 +1019,23 @@ retry_next_init:
 
 		// Handling normal commands loop
 
+		if(!inst->sequential) {
+			// Try the ripe commands by deadline until one is sent
+			inst->pickseq++;
+			while((r = pick_command(inst)) >= 0) {
+				inst->cmdidx = r;
+				current_cmd(inst)->pickseq = inst->pickseq;
+				if(start_command(inst))
+					break;
+			}
+			if(r == -ENODATA) {
+				*(inst->hal->lasterror) = ENODATA;
+				*(inst->hal->fault) = 1;
+				*(inst->hal->faultcmd) = 0;
+			}
+			break;
+		}
+
 		if(!inst->cmdidx) {
 			// We are at the start of a cycle. If the first command message is
 			// disabled, then try the next.
@@ -887,49 +1067,8 @@ retry_next_init:
 			if(cc->interval >= 0)
 				continue;
 
-			// Reset the command's interval timer. The 'once' commands will
-			// repeat every 292 years or so. If the command fails and needs a
-			// resend, then the interval is patched (see force_resend()).
-			// Reset to asap if the interval is shorter than the previous
-			// experienced delay.
-			if(cc->cmd.cinterval == 0xffffffff)
-				cc->interval = RTAPI_INT64_MAX;
-			else if((cc->interval += cc->cmd.cinterval * 1000) < 0)
-				cc->interval = -1;
-
-			if((r = build_data_frame(inst)) < 0) {
-				// We cannot recover from data frames that cannot be build. The
-				// next round would end in the same error. Therefore, disabling
-				// the command is our only option.
-				MSG_ERR("%s: error: Build data frame failed command %d, disabling\n", inst->name, inst->cmdidx);
-				cc->disabled = 1;
-				set_error(inst, -r);
-				continue; // Just try next command
-			}
-			if(r || hasresend(cc)) { // if data has changed or forced
-				if((r = send_modbus_pkt(inst)) < 0) {
-					if(r == -EMSGSIZE) {
-						// We cannot recover if the error occurred because the
-						// buffer overflowed (no room for CRC). Resetting would
-						// just give us an infinite stream of errors because it
-						// would overflow in the next round too.
-						// We disable this particular command so it will not
-						// give problems again. It will probably cause havoc in
-						// the application, but that should be OK.
-						MSG_ERR("%s: error: Command %d disabled\n", inst->name, inst->cmdidx);
-						cc->disabled = 1;
-						set_error(inst, EMSGSIZE);
-						continue; // Just try next command
-					}
-					MSG_ERR("%s: error: Send PDU failed (error %d) command %d, resetting\n", inst->name, r, inst->cmdidx);
-					force_resend(inst);
-					queue_reset(inst);
-					break;
-				} else {
-					set_state(inst, STATE_WAIT_FOR_SEND_COMPLETE);
-					break;
-				}
-			}
+			if(start_command(inst))
+				break;
 			// Nothing to do for this command, try next
 		} while(!next_command(inst));	// Until we wrap the command list
 
@@ -982,6 +1121,7 @@ retry_next_init:
 				// Broadcasts have no reply. Unless the equipment is badly
 				// behaved and we have set flag to handle the case. Or,
 				// non-broadcasts which are marked to produce no answer.
+				command_done(inst);
 				set_state(inst, STATE_START);
 			} else {
 				set_state(inst, STATE_WAIT_FOR_DATA_FRAME);
@@ -1070,6 +1210,7 @@ fetch_more_data:
 		if(!inst->ignoredata) {
 			if(parse_data_frame(inst) >= 0) {
 				current_cmd(inst)->errors = 0;
+				command_done(inst);
 			}
 		}
 		if(inst->frameidx < 16-1 && HM2_PKTUART_RCR_NBYTES_VAL(inst->fsizes[++(inst->frameidx)]) > 0) {
@@ -2780,6 +2921,9 @@ int rtapi_app_main(void)
 		// Copy the loop command control structure data
 		for(unsigned i = 0; i < inst->ncmds; i++) {
 			inst->_cmds[i].cmd = inst->cmdsptr[i];
+			// Delay commands only make sense in a fixed sequence
+			if(!inst->cmdsptr[i].func)
+				inst->sequential = 1;
 			if(inst->cmdsptr[i].ctypeptr)
 				inst->_cmds[i].typeptr = (hm2_modbus_mbccb_type_t *)(inst->dataptr + inst->cmdsptr[i].ctypeptr + 1);
 		}
@@ -2942,6 +3086,12 @@ int rtapi_app_main(void)
 					comp_id, "%s.command.%02d.error-code", inst->name, c));
 			CHECK(hal_pin_bit_newf(HAL_IN, &(inst->hal->cmds[c].reset),
 					comp_id, "%s.command.%02d.reset", inst->name, c));
+			CHECK(hal_pin_float_newf(HAL_OUT, &(inst->hal->cmds[c].rate),
+					comp_id, "%s.command.%02d.rate", inst->name, c));
+			CHECK(hal_pin_u32_newf(HAL_OUT, &(inst->hal->cmds[c].latency),
+					comp_id, "%s.command.%02d.latency", inst->name, c));
+			CHECK(hal_pin_u32_newf(HAL_OUT, &(inst->hal->cmds[c].latencymax),
+					comp_id, "%s.command.%02d.latency-max", inst->name, c));
 
 			hm2_modbus_cmd_t *cc = &inst->_cmds[c];
 
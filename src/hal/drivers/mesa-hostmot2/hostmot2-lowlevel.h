@@ -98,6 +98,12 @@ struct hm2_lowlevel_io_struct {
     int (*send_queued_reads)(hm2_lowlevel_io_t *self);
     int (*receive_queued_reads)(hm2_lowlevel_io_t *self);
 
+    // optional with receive_queued_reads: returns TRUE when
+    // receive_queued_reads would not have to wait, because the reply is
+    // there or because it would time out.  hostmot2.read-all uses it to
+    // process the boards in the order their replies arrive.
+    int (*queued_reads_ready)(hm2_lowlevel_io_t *self);
+
     // similarly, it is useful to divide the work of bulk writes into two groups
     //   * queueing the writes
     //   * actually performing the writes
@@ -179,6 +185,9 @@ struct hm2_lowlevel_io_struct {
 int hm2_register(hm2_lowlevel_io_t *llio, char *config);
 void hm2_unregister(hm2_lowlevel_io_t *llio);
 
+// does the .read of several registered boards at once, see hostmot2.c
+void hm2_read_boards(hm2_lowlevel_io_t **llio, int num_llio, long period);
+
 
 #endif //  HOSTMOT2_LOWLEVEL_H
 
@@ -200,6 +200,54 @@ static void hm2_write_gpio(void *void_hm2, long period) {
 }
 
 
+static hostmot2_t *hm2_find(hm2_lowlevel_io_t *llio) {
+    struct rtapi_list_head *ptr;
+
+    rtapi_list_for_each(ptr, &hm2_list) {
+        hostmot2_t *hm2 = rtapi_list_entry(ptr, hostmot2_t, list);
+        if (hm2->llio == llio) return hm2;
+    }
+    return NULL;
+}
+
+
+//
+// for llio drivers with several boards behind one funct: send the read
+// requests of all the boards first, then process each board as soon as
+// its reply is in, so the round trips overlap instead of adding up
+//
+
+// pause between polls of boards whose replies are not in yet, so that
+// the sender of the replies gets the CPU if it is on the same one
+#define HM2_READ_POLL_DELAY_NS 10000
+
+EXPORT_SYMBOL_GPL(hm2_read_boards);
+void hm2_read_boards(hm2_lowlevel_io_t **llio, int num_llio, long period) {
+    int i, pending, done;
+
+    for (i = 0; i < num_llio; i++) {
+        hostmot2_t *hm2 = hm2_find(llio[i]);
+        if (hm2 && !llio[i]->read_requested) hm2_read_request(hm2, period);
+    }
+
+    // read_requested stays clear for a board with an io_error
+    do {
+        pending = 0;
+        done = 0;
+        for (i = 0; i < num_llio; i++) {
+            if (!llio[i]->read_requested) continue;
+            if (llio[i]->queued_reads_ready && !llio[i]->queued_reads_ready(llio[i])) {
+                pending = 1;
+                continue;
+            }
+            hm2_read(hm2_find(llio[i]), period);
+            done = 1;
+        }
+        if (pending && !done) rtapi_delay(HM2_READ_POLL_DELAY_NS);
+    } while (pending);
+}
+
+
 
 
 //
@@ -104,6 +104,7 @@ CONFIGDEFAULT= {'baudrate'  : '9600',
                 'drivedelay': 'AUTO',
                 'icdelay'   : 'AUTO',
                 'interval'  : '0',
+                'merge'     : '0',
                 'suspend'   : '0',
                 'writeflush': '1',
                 'timeout'   : 'AUTO' }
@@ -127,6 +128,7 @@ CONFIGLIMITS = {'baudrate'  : [1200, 1000000],
                 'drivedelay': [0, 31],
                 'icdelay'   : [0, 255], # 0 signals auto
                 'interval'  : [0, MAXINTERVAL],  # As-fast-as possible to ... seconds
+                'merge'     : [0, 1],   # Merge adjacent reads
                 'suspend'   : [0, 1],   # Set to start suspended
                 'writeflush': [0, 1],
                 'timeout'   : [10000, 10000000] } # 10 milliseconds to 10 seconds (can override in <command>)
@@ -287,6 +289,7 @@ FUNCNAMES = { R_COILS: 'R_COILS', R_INPUTREGS: 'R_INPUTREGS', R_INPUTS: 'R_INPUT
               W_COIL:  'W_COIL',  W_REGISTER:  'W_REGISTER',  W_COILS:  'W_COILS',  W_REGISTERS: 'W_REGISTERS' }
 
 WRITEFUNCTIONS = [ W_COIL, W_REGISTER, W_COILS, W_REGISTERS ]
+READFUNCTIONS  = [ R_COILS, R_INPUTS, R_REGISTERS, R_INPUTREGS ]
 
 # These functions always use HAL_BIT
 # Also, the function is a register function if /not/ in this set
@@ -313,14 +316,15 @@ MBCCB_CMDF_MASK     = 0x003f # sum of allowed normal command flags
 
 # Allowed attributes in <mesamodbus>
 MESAATTRIB = [ 'baudrate', 'drivedelay', 'duplex',   'icdelay', 'interval',
-               'parity',   'rxdelay',    'stopbits', 'suspend', 'timeout',
-               'txdelay',  'writeflush' ]
+               'merge',    'parity',     'rxdelay',  'stopbits', 'suspend',
+               'timeout',  'txdelay',    'writeflush' ]
 
 # Allowed attributes in <commands>/<command>
 CMDSATTRIB = [ 'address',    'bcanswer',    'clamp',    'count',     'delay',
                'device',     'disabled',    'function', 'haltype',   'interval',
-               'modbustype', 'name',        'noanswer', 'resend',    'scale',
-               'timeout',    'timeoutbits', 'timesout', 'unaligned', 'writeflush' ]
+               'merge',      'modbustype',  'name',     'noanswer',  'resend',
+               'scale',      'timeout',     'timeoutbits', 'timesout', 'unaligned',
+               'writeflush' ]
 
 # Allowed attributes in <commands>/<command>/<pin>
 PINSATTRIB = [ 'clamp', 'name', 'haltype', 'modbustype', 'scale' ]
@@ -543,6 +547,10 @@ def verifyConfigParams(cfg):
     b = getBoolean(cfg, 'writeflush')
     cfg['writeflush'] = '1' if True == b else '0'
 
+    # Fixup merge boolean
+    b = getBoolean(cfg, 'merge')
+    cfg['merge'] = '1' if True == b else '0'
+
     # Set timeout to zero for auto calculation
     if 'AUTO' == cfg['timeout']:
         cfg['timeout'] = '0'
@@ -1206,6 +1214,11 @@ def handleCommands(commands):
         if function not in WRITEFUNCTIONS:
             cflags &= ~MBCCB_CMDF_WFLUSH
 
+        # Adjacent reads may be merged, unless told not to
+        merge = getBoolean(cmd.attrib, 'merge')
+        if None == merge:
+            merge = 0 != configparams['merge']
+
         cmdname = cmd.attrib['name'] if 'name' in cmd.attrib else None
         if None != cmdname:
             if not pinpattern.match(cmdname):
@@ -1390,13 +1403,15 @@ def handleCommands(commands):
             perr("Reading {} registers from address {} wraps the address counter in {}".format(regofs, address, lcl))
             continue
 
-        if 0 == timeout:
+        autotimeout = 0 == timeout
+        if autotimeout:
             timeout = calcTimeout(function, regofs, MBT_AB, configparams);
 
         cmdlist.append({'device': device, 'mbid': devices[device], 'function': function,
                         'timeout': timeout, 'address': address, 'count': count,
                         'regcnt': regofs, 'pins': pinlist, 'flags': cflags,
-                        'interval': interval })
+                        'interval': interval, 'merge': merge, 'autotimeout': autotimeout,
+                        'index': [len(cmdlist) + 1] })
         if verbose:
             print("Command {:2}: {} {}({}) addr=0x{:04x} flags={} interval={} timeout={}"
                 .format(len(cmdlist), device, FUNCNAMES[function], function, address, cflagList(cflags),
@@ -1423,6 +1438,92 @@ def handleCommands(commands):
 
     return cmdlist
 
+#
+# Test whether two read commands can be sent as one. They must read the same
+# kind of data from the same device at the same interval and with the same
+# flags. The address ranges must be adjacent and the combined range must fit in
+# one request.
+#
+def canMerge(a, b):
+    if a is b or not a['merge'] or not b['merge']:
+        return False
+    if a['function'] not in READFUNCTIONS:
+        return False
+    for k in ['device', 'function', 'flags', 'interval']:
+        if a[k] != b[k]:
+            return False
+    if a['address'] + a['regcnt'] != b['address'] and b['address'] + b['regcnt'] != a['address']:
+        return False
+    maxcount = 2000 if a['function'] in BITFUNCTIONS else 125
+    return a['regcnt'] + b['regcnt'] <= maxcount
+
+#
+# Merge command 'b' into command 'a'. The pins of the command with the lower
+# address come first and the register offsets of the other are moved up.
+#
+def joinCommands(a, b):
+    lo, hi = (a, b) if a['address'] < b['address'] else (b, a)
+    pins = [dict(p) for p in lo['pins']]
+    for p in hi['pins']:
+        q = dict(p)
+        q['regofs'] += lo['regcnt']
+        pins.append(q)
+    regcnt = lo['regcnt'] + hi['regcnt']
+    # Automatic timeouts are recalculated for the combined reply. Explicit
+    # timeouts are kept, but never shorter than the automatic one.
+    if a['autotimeout'] and b['autotimeout']:
+        timeout = calcTimeout(a['function'], regcnt, MBT_AB, configparams)
+    else:
+        timeout = max([c['timeout'] for c in [a, b] if not c['autotimeout']])
+        timeout = max(timeout, calcTimeout(a['function'], regcnt, MBT_AB, configparams))
+    a.update({'address': lo['address'], 'count': lo['count'] + hi['count'], 'regcnt': regcnt,
+              'pins': pins, 'timeout': timeout, 'autotimeout': a['autotimeout'] and b['autotimeout'],
+              'index': sorted(a['index'] + b['index']) })
+
+#
+# Merge adjacent reads into as few commands as possible. A merged command takes
+# the place of the first of its parts in the list. Commands are not merged
+# across a delay command so that the sequence around the delay is unchanged.
+#
+def mergeCommands(cmdlist):
+    result = []
+    group = []  # Merge candidates since the last delay
+    for c in cmdlist:
+        if 'delay' in c:
+            group = []
+            result.append(c)
+            continue
+        if not c['merge'] or c['function'] not in READFUNCTIONS:
+            result.append(c)
+            continue
+        result.append(c)
+        group.append(c)
+        # A merge may make the result adjacent to another candidate, repeat
+        # until nothing more can be merged.
+        cur = c
+        while True:
+            m = next((m for m in group if canMerge(m, cur)), None)
+            if None == m:
+                break
+            a, b = (m, cur) if result.index(m) < result.index(cur) else (cur, m)
+            joinCommands(a, b)
+            group.remove(b)
+            result.remove(b)
+            cur = a
+
+    if verbose:
+        for n in range(len(result)):
+            c = result[n]
+            if 'delay' in c or len(c['index']) < 2:
+                continue
+            print("Command {:2}: merged from commands {}: {} {}({}) addr=0x{:04x} count={} timeout={}"
+                    .format(n + 1, ','.join([str(i) for i in c['index']]), c['device'], FUNCNAMES[c['function']],
+                            c['function'], c['address'], c['regcnt'], c['timeout']))
+            for p in range(len(c['pins'])):
+                pin = c['pins'][p]
+                print("  pin {:2}: {:24} addr=0x{:04x}".format(p+1, pin['pin'], c['address'] + pin['regofs']))
+    return result
+
 #
 # Main program
 #
@@ -1489,6 +1590,7 @@ def main():
         print("  drivedelay: {}".format(getAutoFmt(configparams['drivedelay'], "bits")))
         print("  timeout   : {}".format(getAutoFmt(configparams['timeout'], "microseconds")))
         print("  suspend   : {}".format("true" if configparams['suspend'] else "false"))
+        print("  merge     : {}".format("true" if configparams['merge'] else "false"))
 
     # Parse the nodes
     global devices
@@ -1524,6 +1626,7 @@ def main():
                 if None == commands:
                     errorflag = True
                     continue
+                commands = mergeCommands(commands)
             else:
                 perr("Invalid/unknown tag '{}'".format(node.tag))
 
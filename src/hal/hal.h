@@ -137,6 +137,7 @@ RTAPI_BEGIN_DECLS
 #include <rtapi_errno.h>
 
 #define HAL_NAME_LEN     47	/* length for pin, signal, etc, names */
+#define HAL_THREAD_WORKERS 8	/* max helpers of a thread, see hal_thread_parallel() */
 
 /** These locking codes define the state of HAL locking, are used by most functions */
 /** The functions locked will return a -EPERM error message **/
@@ -771,6 +772,47 @@ extern int hal_export_functf(void (*funct) (void *, long),
 extern int hal_create_thread(const char *name, unsigned long period_nsec,
     int uses_fp);
 
+/** hal_create_thread_cpus() is hal_create_thread() with a choice of the
+    CPUs the thread runs on.  'cpus' is a list of CPU numbers and ranges
+    like "3" or "2,4-5", or "spread" to give each such thread its own CPU
+    from the isolated ones, see rtapi_task_set_cpus().  NULL or "" is the
+    same as hal_create_thread(), which puts all threads on one CPU.
+    Not all realtime systems support this, they fail with -ENOSYS.
+*/
+extern int hal_create_thread_cpus(const char *name, unsigned long period_nsec,
+    int uses_fp, const char *cpus);
+
+/** hal_thread_parallel() lets up to 'workers' helper tasks run the
+    functions of thread 'name' alongside the thread itself.  Which
+    functions may run at the same time is worked out from the signals
+    their pins are linked to: a function waits for every function
+    earlier in the thread that writes a signal it reads or writes, or
+    reads a signal it writes.  Functions of the same component instance
+    never run at the same time.  The result each period is the same as
+    running the functions one after the other.
+    The helpers are placed on 'cpus' like hal_create_thread_cpus(),
+    NULL or "" means "spread", and busy-wait for work, so they should
+    have isolated CPUs to themselves.  Only realtime systems that
+    support CPU placement can do this, others fail with -ENOSYS.
+    'workers' may be at most HAL_THREAD_WORKERS, 0 does nothing.
+    Call only from realtime init code, not from user space or
+    realtime code.
+*/
+extern int hal_thread_parallel(const char *name, int workers, const char *cpus);
+
+/** hal_thread_sched() chooses how thread 'name' is scheduled, see
+    rtapi_task_set_sched(): "fifo" (the default) or "deadline" with an
+    optional ":runtime:deadline" in ns for SCHED_DEADLINE, and
+    "nanosleep" (the default) or "timerfd" for how it waits for the
+    next period, e.g. "deadline:200000,timerfd".  NULL or "" keeps the
+    default, which is taken from RTAPI_SCHED.  Helpers of a parallel
+    thread keep the default.  Not all realtime systems support this,
+    they fail with -ENOSYS.
+    Call only from realtime init code, not from user space or
+    realtime code.
+*/
+extern int hal_thread_sched(const char *name, const char *sched);
+
 /** hal_thread_delete() deletes a realtime thread.
     'name' is the name of the thread, which must have been created
     by 'hal_create_thread()'.
@@ -833,6 +875,17 @@ extern int hal_start_threads(void);
 */
 extern int hal_stop_threads(void);
 
+/** hal_thread_latency() makes thread 'name' record how late it wakes up
+    each period in a histogram of 1 us bins in HAL shared memory, or
+    starts that over.  The latency is measured by RTAPI right after the
+    wakeup, see rtapi_task_wakeup_latency(), where the realtime system
+    can do that, otherwise it is the time between two periods minus the
+    period.  The histogram is read with halcmd 'latency show'.
+    On success it returns 0, on failure a negative error code.
+    May be called from user space or realtime init code.
+*/
+extern int hal_thread_latency(const char *name);
+
 /** HAL 'constructor' typedef
     If it is not NULL, this points to a function which can construct a new
     instance of its component.  Return value is >=0 for success,
@@ -989,6 +1042,21 @@ extern bool hal_stream_writable(hal_stream_t *stream);
 extern void hal_stream_wait_writable(hal_stream_t *stream, sig_atomic_t *stop);
 #endif
 
+/** span access: the records in the fifo are used in place, instead of
+ * being copied one at a time.  A record is hal_stream_stride() elements,
+ * the first hal_stream_element_count() of them are the pins.
+ *
+ * *_span() points buf at the first of the returned number of contiguous
+ * records (at most max) that can be read or filled.  A span ends where the
+ * fifo wraps, so a second call may return more.  *_commit() then releases
+ * the first count of them to the other side with a single index update.
+ */
+extern int hal_stream_stride(hal_stream_t *stream);
+extern int hal_stream_read_span(hal_stream_t *stream, union hal_stream_data **buf, unsigned max);
+extern int hal_stream_read_commit(hal_stream_t *stream, unsigned count);
+extern int hal_stream_write_span(hal_stream_t *stream, union hal_stream_data **buf, unsigned max);
+extern int hal_stream_write_commit(hal_stream_t *stream, unsigned count);
+
 RTAPI_END_DECLS
 
 #endif /* HAL_H */
@@ -56,9 +56,11 @@
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "hal.h"		/* HAL public API decls */
 #include "hal_priv.h"		/* HAL private decls */
+#include "hal_trace.h"		/* trace points */
 
 #include "rtapi_string.h"
 #include "rtapi_atomic.h"
+#include "rtapi_slab.h"
 
 #ifdef RTAPI
 #include "rtapi_app.h"
@@ -78,6 +80,10 @@ char *hal_shmem_base = 0;
 hal_data_t *hal_data = 0;
 static int lib_module_id = -1;	/* RTAPI module ID for library module */
 static int lib_mem_id = 0;	/* RTAPI shmem ID for library module */
+#ifdef RTAPI
+static int trace_mem_id = 0;	/* RTAPI shmem ID for the trace buffers */
+static hal_trace_t *hal_trace_data = 0;	/* trace buffers, if any */
+#endif
 
 /***********************************************************************
 *                  LOCAL FUNCTION DECLARATIONS                         *
@@ -100,7 +106,8 @@ static int init_hal_data(void);
     These functions do not test a mutex - they are called from
     within the hal library by code that already has the mutex.
     (The public function 'hal_malloc()' is a wrapper that gets the
-    mutex and then calls 'shmalloc_up()'.)
+    mutex and then calls 'block_alloc()', which gets new memory from
+    'shmalloc_up()'.)
     The only difference between the two functions is the location
     of the allocated memory.  'shmalloc_up()' allocates from the
     base of shared memory and works upward, while 'shmalloc_dn()'
@@ -115,6 +122,18 @@ static int init_hal_data(void);
 static void *shmalloc_up(long int size);
 static void *shmalloc_dn(long int size);
 
+/** 'block_alloc()' is what hal_malloc() uses: it hands out a block of
+    'size' bytes for component 'owner' (0 for none), from the free lists
+    if a freed block of about the right size is there, otherwise from
+    'shmalloc_up()'.  'free_comp_blocks()' puts all blocks of a
+    component on the free lists, when it exits.  Blocks without an
+    owner come straight from 'shmalloc_up()' and are never freed.  Both
+    assume that the caller has the hal_data mutex; they are not for
+    realtime code.
+*/
+static void *block_alloc(long int size, int owner);
+static void free_comp_blocks(int owner);
+
 /** The alloc_xxx_struct() functions allocate a structure of the
     appropriate type and return a pointer to it, or 0 if they fail.
     They attempt to re-use freed structs first, if none are
@@ -157,6 +176,41 @@ static void free_thread_struct(hal_thread_t * thread);
     and calling each function in turn.
 */
 static void thread_task(void *arg);
+
+/** 'worker_task()' is the realtime task of a helper that runs functions
+    of a thread in parallel with it, see hal_thread_parallel().
+*/
+static void worker_task(void *arg);
+
+/** trace_init() sets up the trace buffers, if the library was built
+    with HAL_TRACING.  trace_attach() gives the realtime task 'task_id'
+    a buffer, called 'name', and trace_detach() lets another task have
+    it, keeping the events for 'haltrace' until then.
+*/
+static void trace_init(void);
+static void trace_attach(int task_id, const char *name);
+static void trace_detach(int task_id);
+#endif /* RTAPI */
+
+/** thread_plan_invalidate() stops parallel execution of 'thread' and
+    waits until the cycle that may be running has finished, so its
+    function list can be changed.  If that takes more than a few
+    periods, it puts the plan back and returns -EBUSY, and the list must
+    be left alone.  thread_plan_update() works out again
+    which functions of a parallel thread have to wait for which, if the
+    threads are running; otherwise that is done by hal_start_threads().
+    halpr_thread_plans_update() (see hal_priv.h) does that for all
+    threads.  All assume that the caller has the hal_data mutex.
+*/
+static int thread_plan_invalidate(hal_thread_t * thread);
+static void thread_plan_update(hal_thread_t * thread);
+#ifdef RTAPI
+/** threads_invalidate_comp() does thread_plan_invalidate() for every
+    thread that runs a function of 'comp', before they are removed; if
+    one of them does not finish its cycle, the others go back to their
+    plans and it returns -EBUSY.
+*/
+static int threads_invalidate_comp(hal_comp_t * comp);
 #endif /* RTAPI */
 
 /***********************************************************************
@@ -321,12 +375,24 @@ int hal_exit(int comp_id)
 	}
 	comp = SHMPTR(next);
     }
+#ifdef RTAPI
+    /* its functions are taken off parallel threads between cycles */
+    if (threads_invalidate_comp(comp) != 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: component '%s' is still running\n", comp->name);
+	return -EBUSY;
+    }
+#endif /* RTAPI */
     /* found our component, unlink it from the list */
     *prev = comp->next_ptr;
     /* save component name for later */
     rtapi_snprintf(name, sizeof(name), "%s", comp->name);
     /* get rid of the component */
     free_comp_struct(comp);
+#ifdef RTAPI
+    halpr_thread_plans_update();
+#endif /* RTAPI */
 /*! \todo Another #if 0 */
 #if 0
     /*! \todo FIXME - this is the beginning of a two pronged approach to managing
@@ -368,6 +434,36 @@ int hal_exit(int comp_id)
     return 0;
 }
 
+/* the component a hal_malloc() block belongs to: the one component of
+   this process (of rtapi_app, for realtime code) that is being set up,
+   i.e. has called hal_init() but not hal_ready() yet.  If there is none,
+   or more than one, the block gets no owner and is never freed, which
+   is what happened to all blocks before. */
+static int malloc_owner(void)
+{
+    SHMFIELD(hal_comp_t) next;
+    hal_comp_t *comp;
+    int owner = 0;
+
+    next = hal_data->comp_list_ptr;
+    while (next != 0) {
+	comp = SHMPTR(next);
+#ifdef RTAPI
+	if (!comp->ready && comp->type == COMPONENT_TYPE_REALTIME) {
+#else /* ULAPI */
+	if (!comp->ready && comp->type == COMPONENT_TYPE_USER
+		&& comp->pid == getpid()) {
+#endif
+	    if (owner != 0) {
+		return 0;
+	    }
+	    owner = comp->comp_id;
+	}
+	next = comp->next_ptr;
+    }
+    return owner;
+}
+
 void *hal_malloc(long int size)
 {
     void *retval;
@@ -380,7 +476,7 @@ void *hal_malloc(long int size)
     /* get the mutex */
     rtapi_mutex_get(&(hal_data->mutex));
     /* allocate memory */
-    retval = shmalloc_up(size);
+    retval = block_alloc(size, malloc_owner());
     /* release the mutex */
     rtapi_mutex_give(&(hal_data->mutex));
     /* check return value */
@@ -963,11 +1059,8 @@ int hal_pin_alias(const char *pin_name, const char *alias)
 
 int hal_signal_new(const char *name, hal_type_t type)
 {
-
-    rtapi_intptr_t *prev, next;
-    int cmp;
-    hal_sig_t *new, *ptr;
-    void *data_addr;
+    hal_sig_t *new;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -996,6 +1089,18 @@ int hal_signal_new(const char *name, hal_type_t type)
 	    "HAL: ERROR: duplicate signal '%s'\n", name);
 	return -EINVAL;
     }
+    retval = halpr_signal_new(name, type, &new);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return retval;
+}
+
+int halpr_signal_new(const char *name, hal_type_t type, hal_sig_t **sigp)
+{
+    rtapi_intptr_t *prev, next;
+    int cmp;
+    hal_sig_t *new, *ptr;
+    void *data_addr;
+
     /* allocate memory for the signal value */
 /*
 because accesses will later be through pointer of type hal_data_u,
@@ -1018,7 +1123,6 @@ with the C standard.
         data_addr = shmalloc_up(sizeof(hal_data_u));
     break;
     default:
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: illegal signal type %d'\n", type);
 	return -EINVAL;
@@ -1028,7 +1132,6 @@ with the C standard.
     new = alloc_sig_struct();
     if ((new == 0) || (data_addr == 0)) {
 	/* alloc failed */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: insufficient memory for signal '%s'\n", name);
 	return -ENOMEM;
@@ -1072,24 +1175,24 @@ with the C standard.
     while (1) {
 	if (next == 0) {
 	    /* reached end of list, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
+	    break;
 	}
 	ptr = SHMPTR(next);
 	cmp = strcmp(ptr->name, new->name);
 	if (cmp > 0) {
 	    /* found the right place for it, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
+	    break;
 	}
 	/* didn't find it yet, look at next one */
 	prev = &(ptr->next_ptr);
 	next = *prev;
     }
+    new->next_ptr = next;
+    *prev = SHMOFF(new);
+    if (sigp) {
+	*sigp = new;
+    }
+    return 0;
 }
 
 int hal_signal_delete(const char *name)
@@ -1141,8 +1244,7 @@ int hal_link(const char *pin_name, const char *sig_name)
 {
     hal_pin_t *pin;
     hal_sig_t *sig;
-    hal_comp_t *comp;
-    void **data_ptr_addr, *data_addr;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -1187,59 +1289,66 @@ int hal_link(const char *pin_name, const char *sig_name)
 	    "HAL: ERROR: signal '%s' not found\n", sig_name);
 	return -EINVAL;
     }
-    /* found both pin and signal, are they already connected? */
+    retval = halpr_link(pin, sig);
+    if (retval == 0) {
+	/* functions in parallel threads may have to wait for others now */
+	halpr_thread_plans_update();
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    return retval;
+}
+
+int halpr_link(hal_pin_t *pin, hal_sig_t *sig)
+{
+    hal_comp_t *comp;
+    void **data_ptr_addr, *data_addr;
+
+    /* are they already connected? */
     if (SHMPTR(pin->signal) == sig) {
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_WARN,
-	    "HAL: Warning: pin '%s' already linked to '%s'\n", pin_name, sig_name);
+	    "HAL: Warning: pin '%s' already linked to '%s'\n", pin->name, sig->name);
 	return 0;
     }
     /* is the pin connected to something else? */
     if(pin->signal) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	sig = SHMPTR(pin->signal);
+	hal_sig_t *osig = SHMPTR(pin->signal);
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: pin '%s' is linked to '%s', cannot link to '%s'\n",
-	    pin_name, sig->name, sig_name);
+	    pin->name, osig->name, sig->name);
 	return -EINVAL;
     }
     /* check types */
     if (pin->type != sig->type) {
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: type mismatch '%s' <- '%s'\n", pin_name, sig_name);
+	    "HAL: ERROR: type mismatch '%s' <- '%s'\n", pin->name, sig->name);
 	return -EINVAL;
     }
     /* linking output pin to sig that already has output or I/O pins? */
     if ((pin->dir == HAL_OUT) && ((sig->writers > 0) || (sig->bidirs > 0 ))) {
 	/* yes, can't do that */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: signal '%s' already has output or I/O pin(s)\n", sig_name);
+	    "HAL: ERROR: signal '%s' already has output or I/O pin(s)\n", sig->name);
 	return -EINVAL;
     }
     /* linking bidir pin to sig that is a port?*/
     if ((pin->dir == HAL_IO) && (pin->type == HAL_PORT)) {
-    rtapi_mutex_give(&(hal_data->mutex));
     rtapi_print_msg(RTAPI_MSG_ERR,
-        "HAL: ERROR: signal '%s' is a port and cannot have I/O pin(s)\n", sig_name);
+        "HAL: ERROR: signal '%s' is a port and cannot have I/O pin(s)\n", sig->name);
     return -EINVAL;
     }
     /* linking bidir pin to sig that already has output pin? */
     if ((pin->dir == HAL_IO) && (sig->writers > 0)) {
 	/* yes, can't do that */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: signal '%s' already has output pin\n", sig_name);
+	    "HAL: ERROR: signal '%s' already has output pin\n", sig->name);
 	return -EINVAL;
     }
 
     /* linking input pin to port sig that already has an input port? */
     if ((pin->type == HAL_PORT) && (pin->dir == HAL_IN) && (sig->readers > 0)) {
 	/* ports can only have one reader */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: signal '%s' can only have one input pin\n", sig_name);
+	    "HAL: ERROR: signal '%s' can only have one input pin\n", sig->name);
 	return -EINVAL;
     }
     
@@ -1303,8 +1412,6 @@ int hal_link(const char *pin_name, const char *sig_name)
     }
     /* and update the pin */
     pin->signal = SHMOFF(sig);
-    /* done, release the mutex and return */
-    rtapi_mutex_give(&(hal_data->mutex));
     return 0;
 }
 
@@ -1343,6 +1450,7 @@ int hal_unlink(const char *pin_name)
     }
     /* found pin, unlink it */
     unlink_pin(pin);
+    halpr_thread_plans_update();
     /* done, release the mutex and return */
     rtapi_mutex_give(&(hal_data->mutex));
     return 0;
@@ -2006,6 +2114,7 @@ int hal_export_funct(const char *name, void (*funct) (void *, long),
     }
     /* at this point we have a new function and can yield the mutex */
     rtapi_mutex_give(&(hal_data->mutex));
+    new->trace = hal_trace_register(name);
 
     /* create a pin with the function's runtime in it */
     if (hal_pin_s32_newf(HAL_OUT, &(new->runtime), comp_id,"%s.time",name)) {
@@ -2032,6 +2141,12 @@ int hal_export_funct(const char *name, void (*funct) (void *, long),
 }
 
 int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
+{
+    return hal_create_thread_cpus(name, period_nsec, uses_fp, NULL);
+}
+
+int hal_create_thread_cpus(const char *name, unsigned long period_nsec,
+    int uses_fp, const char *cpus)
 {
     int next, cmp, prev_priority;
     int retval, n;
@@ -2057,6 +2172,14 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
 	    "HAL: ERROR: thread name '%s' is too long\n", name);
 	return -EINVAL;
     }
+    if (cpus == 0) {
+	cpus = "";
+    }
+    if (strlen(cpus) > HAL_NAME_LEN) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: CPU list '%s' is too long\n", cpus);
+	return -EINVAL;
+    }
     if (hal_data->lock & HAL_LOCK_CONFIG) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: create_thread called while HAL is locked\n");
@@ -2092,6 +2215,7 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
     /* initialize the structure */
     new->uses_fp = uses_fp;
     rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
+    rtapi_snprintf(new->cpus, sizeof(new->cpus), "%s", cpus);
     /* have to create and start a task to run the thread */
     if (hal_data->thread_list_ptr == 0) {
 	/* this is the first thread created */
@@ -2160,9 +2284,21 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
 	return -EINVAL;
     }
     new->task_id = retval;
+    /* place it, before it starts running */
+    retval = rtapi_task_set_cpus(new->task_id, cpus);
+    if (retval < 0) {
+	rtapi_task_delete(new->task_id);
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL_LIB: could not put thread %s on CPUs '%s': %d\n", name, cpus, retval);
+	return retval;
+    }
+    new->trace = hal_trace_register(name);
+    trace_attach(new->task_id, name);
     /* start task */
     retval = rtapi_task_start(new->task_id, new->period);
     if (retval < 0) {
+	trace_detach(new->task_id);
 	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL_LIB: could not start task for thread %s: %d\n", name, retval);
@@ -2196,6 +2332,15 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
         return -EINVAL;
     }
     *(new->runtime) = 0;
+
+    if (hal_pin_s32_newf(HAL_OUT, &(new->latency), new->comp_id,"%s.latency",new->name)
+	|| hal_pin_s32_newf(HAL_IO, &(new->latency_max), new->comp_id,"%s.latency-max",new->name)) {
+        rtapi_print_msg(RTAPI_MSG_ERR,
+           "HAL: ERROR: fail to create latency pins for '%s'\n", new->name);
+        return -EINVAL;
+    }
+    *(new->latency) = 0;
+    *(new->latency_max) = 0;
     hal_ready(new->comp_id);
 
     rtapi_print_msg(RTAPI_MSG_DBG, "HAL: thread created\n");
@@ -2251,15 +2396,139 @@ extern int hal_thread_delete(const char *name)
     return -EINVAL;
 }
 
+int hal_thread_parallel(const char *name, int workers, const char *cpus)
+{
+    hal_thread_t *thread;
+    char buf[HAL_NAME_LEN + 8];
+    int n, retval;
+
+    if (hal_data == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread_parallel called before init\n");
+	return -EINVAL;
+    }
+    if (workers < 0 || workers > HAL_THREAD_WORKERS) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: %d helpers for thread '%s', at most %d\n",
+	    workers, name, HAL_THREAD_WORKERS);
+	return -EINVAL;
+    }
+    if (workers == 0) {
+	return 0;
+    }
+    if (cpus == 0 || *cpus == '\0') {
+	cpus = "spread";
+    }
+    if (hal_data->lock & HAL_LOCK_CONFIG) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread_parallel called while HAL is locked\n");
+	return -EPERM;
+    }
+
+    /* get mutex before accessing shared data */
+    rtapi_mutex_get(&(hal_data->mutex));
+    thread = halpr_find_thread_by_name(name);
+    if (thread == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread '%s' not found\n", name);
+	return -EINVAL;
+    }
+    if (thread->workers != 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread '%s' already has helpers\n", name);
+	return -EINVAL;
+    }
+    /* the helpers have to be placed before they start running */
+    retval = 0;
+    for (n = 0; n < workers; n++) {
+	retval = rtapi_task_new(worker_task, thread, thread->priority,
+	    lib_module_id, HAL_STACKSIZE, thread->uses_fp);
+	if (retval < 0) {
+	    break;
+	}
+	thread->worker_task[n] = retval;
+	rtapi_snprintf(buf, sizeof(buf), "%s.%d", name, n);
+	trace_attach(thread->worker_task[n], buf);
+	retval = rtapi_task_set_cpus(thread->worker_task[n], cpus);
+	if (retval == 0) {
+	    retval = rtapi_task_start(thread->worker_task[n], thread->period);
+	}
+	if (retval < 0) {
+	    rtapi_task_delete(thread->worker_task[n]);
+	    trace_detach(thread->worker_task[n]);
+	    break;
+	}
+    }
+    if (retval < 0) {
+	thread->workers_exit = 1;
+	while (n-- > 0) {
+	    rtapi_task_delete(thread->worker_task[n]);
+	    trace_detach(thread->worker_task[n]);
+	}
+	thread->workers_exit = 0;
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL_LIB: could not start helpers for thread %s on CPUs '%s': %d\n",
+	    name, cpus, retval);
+	return retval;
+    }
+    thread->workers = workers;
+    thread_plan_update(thread);
+    rtapi_mutex_give(&(hal_data->mutex));
+    rtapi_print_msg(RTAPI_MSG_INFO,
+	"HAL: thread '%s' runs functions on %d helpers\n", name, workers);
+    return 0;
+}
+
+int hal_thread_sched(const char *name, const char *sched)
+{
+    hal_thread_t *thread;
+    int retval;
+
+    if (hal_data == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread_sched called before init\n");
+	return -EINVAL;
+    }
+    if (sched == 0 || *sched == '\0') {
+	return 0;
+    }
+    if (hal_data->lock & HAL_LOCK_CONFIG) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread_sched called while HAL is locked\n");
+	return -EPERM;
+    }
+
+    /* get mutex before accessing shared data */
+    rtapi_mutex_get(&(hal_data->mutex));
+    thread = halpr_find_thread_by_name(name);
+    if (thread == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread '%s' not found\n", name);
+	return -EINVAL;
+    }
+    /* the task picks this up at the end of its current period */
+    retval = rtapi_task_set_sched(thread->task_id, sched);
+    rtapi_mutex_give(&(hal_data->mutex));
+    if (retval < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL_LIB: could not set scheduling '%s' for thread %s: %d\n",
+	    sched, name, retval);
+	return retval;
+    }
+    return 0;
+}
+
 #endif /* RTAPI */
 
 int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int position)
 {
     hal_thread_t *thread;
     hal_funct_t *funct;
-    hal_list_t *list_root, *list_entry;
-    int n;
-    hal_funct_entry_t *funct_entry;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -2308,13 +2577,6 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    "HAL: ERROR: function '%s' not found\n", funct_name);
 	return -EINVAL;
     }
-    /* found the function, is it available? */
-    if ((funct->users > 0) && (funct->reentrant == 0)) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: function '%s' may only be added to one thread\n", funct_name);
-	return -EINVAL;
-    }
     /* search thread list for thread_name */
     thread = halpr_find_thread_by_name(thread_name);
     if (thread == 0) {
@@ -2324,11 +2586,28 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    "HAL: ERROR: thread '%s' not found\n", thread_name);
 	return -EINVAL;
     }
+    retval = halpr_add_funct_to_thread(funct, thread, position);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return retval;
+}
+
+int halpr_add_funct_to_thread(hal_funct_t *funct, hal_thread_t *thread,
+    int position)
+{
+    hal_list_t *list_root, *list_entry;
+    int n;
+    hal_funct_entry_t *funct_entry;
+
+    /* found the function, is it available? */
+    if ((funct->users > 0) && (funct->reentrant == 0)) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: function '%s' may only be added to one thread\n", funct->name);
+	return -EINVAL;
+    }
     /* ok, we have thread and function, are they compatible? */
     if ((funct->uses_fp) && (!thread->uses_fp)) {
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: function '%s' needs FP\n", funct_name);
+	    "HAL: ERROR: function '%s' needs FP\n", funct->name);
 	return -EINVAL;
     }
     /* find insertion point */
@@ -2342,7 +2621,6 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    list_entry = list_next(list_entry);
 	    if (list_entry == list_root) {
 		/* reached end of list */
-		rtapi_mutex_give(&(hal_data->mutex));
 		rtapi_print_msg(RTAPI_MSG_ERR,
 		    "HAL: ERROR: position '%d' is too high\n", position);
 		return -EINVAL;
@@ -2355,7 +2633,6 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    list_entry = list_prev(list_entry);
 	    if (list_entry == list_root) {
 		/* reached end of list */
-		rtapi_mutex_give(&(hal_data->mutex));
 		rtapi_print_msg(RTAPI_MSG_ERR,
 		    "HAL: ERROR: position '%d' is too low\n", position);
 		return -EINVAL;
@@ -2368,11 +2645,15 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
     funct_entry = alloc_funct_entry_struct();
     if (funct_entry == 0) {
 	/* alloc failed */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: insufficient memory for thread->function link\n");
 	return -ENOMEM;
     }
+    /* the list of a parallel thread is changed between cycles */
+    if (thread_plan_invalidate(thread) != 0) {
+	free_funct_entry_struct(funct_entry);
+	return -EBUSY;
+    }
     /* init struct contents */
     funct_entry->funct_ptr = SHMOFF(funct);
     funct_entry->arg = funct->arg;
@@ -2381,7 +2662,7 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
     list_add_after((hal_list_t *) funct_entry, list_entry);
     /* update the function usage count */
     funct->users++;
-    rtapi_mutex_give(&(hal_data->mutex));
+    thread_plan_update(thread);
     return 0;
 }
 
@@ -2462,10 +2743,16 @@ int hal_del_funct_from_thread(const char *funct_name, const char *thread_name)
 	}
 	funct_entry = (hal_funct_entry_t *) list_entry;
 	if (SHMPTR(funct_entry->funct_ptr) == funct) {
-	    /* this funct entry points to our funct, unlink */
+	    /* this funct entry points to our funct, unlink it between
+	       cycles of a parallel thread */
+	    if (thread_plan_invalidate(thread) != 0) {
+		rtapi_mutex_give(&(hal_data->mutex));
+		return -EBUSY;
+	    }
 	    list_remove_entry(list_entry);
 	    /* and delete it */
 	    free_funct_entry_struct(funct_entry);
+	    thread_plan_update(thread);
 	    /* done */
 	    rtapi_mutex_give(&(hal_data->mutex));
 	    return 0;
@@ -2477,7 +2764,9 @@ int hal_del_funct_from_thread(const char *funct_name, const char *thread_name)
 
 int hal_start_threads(void)
 {
-    /* a trivial function for a change! */
+    int next;
+    hal_thread_t *thread;
+
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: start_threads called before init\n");
@@ -2492,7 +2781,16 @@ int hal_start_threads(void)
 
 
     rtapi_print_msg(RTAPI_MSG_DBG, "HAL: starting threads\n");
+    /* the parallel threads' plans are made with the latest links */
+    rtapi_mutex_get(&(hal_data->mutex));
     hal_data->threads_running = 1;
+    next = hal_data->thread_list_ptr;
+    while (next != 0) {
+	thread = SHMPTR(next);
+	thread_plan_update(thread);
+	next = thread->next_ptr;
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
     return 0;
 }
 
@@ -2516,6 +2814,46 @@ int hal_stop_threads(void)
     return 0;
 }
 
+int hal_thread_latency(const char *name)
+{
+    hal_thread_t *thread;
+    hal_latency_hist_t *hist;
+
+    if (hal_data == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread_latency called before init\n");
+	return -EINVAL;
+    }
+
+    /* get mutex before accessing shared data */
+    rtapi_mutex_get(&(hal_data->mutex));
+    thread = halpr_find_thread_by_name(name);
+    if (thread == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread '%s' not found\n", name);
+	return -EINVAL;
+    }
+    if (thread->hist == 0) {
+	hist = shmalloc_dn(sizeof(hal_latency_hist_t));
+	if (hist == 0) {
+	    rtapi_mutex_give(&(hal_data->mutex));
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: insufficient memory for latency histogram of '%s'\n",
+		name);
+	    return -ENOMEM;
+	}
+	memset(hist, 0, sizeof(hal_latency_hist_t));
+	thread->hist = SHMOFF(hist);
+    }
+    hist = SHMPTR(thread->hist);
+    /* the thread itself clears it, at its next period */
+    __sync_fetch_and_add(&hist->reset_req, 1);
+    atomic_store_explicit(&thread->hist_enabled, 1, memory_order_release);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
+}
+
 /***********************************************************************
 *                    PRIVATE FUNCTION CODE                             *
 ************************************************************************/
@@ -2961,6 +3299,7 @@ int rtapi_app_main(void)
 	rtapi_exit(lib_module_id);
 	return -EINVAL;
     }
+    trace_init();
     /* done */
     rtapi_print_msg(RTAPI_MSG_DBG,
 	"HAL_LIB: kernel lib installed successfully\n");
@@ -2987,6 +3326,10 @@ void rtapi_app_exit(void)
     /* release mutex */
     rtapi_mutex_give(&(hal_data->mutex));
     /* release RTAPI resources */
+    if (hal_trace_data != 0) {
+	hal_trace_data = 0;
+	rtapi_shmem_delete(trace_mem_id, lib_module_id);
+    }
     rtapi_shmem_delete(lib_mem_id, lib_module_id);
     rtapi_exit(lib_module_id);
     /* done */
@@ -2994,19 +3337,195 @@ void rtapi_app_exit(void)
 	"HAL_LIB: kernel lib removed successfully\n");
 }
 
-/* this is the task function that implements threads in realtime */
+/* the function timing data shown by 'show funct' */
+static void update_funct_time(hal_funct_t * funct, long long int clocks)
+{
+    *(funct->runtime) = (hal_s32_t) clocks;
+    if ( *(funct->runtime) > funct->maxtime) {
+	funct->maxtime = *(funct->runtime);
+	funct->maxtime_increased = 1;
+    } else {
+	funct->maxtime_increased = 0;
+    }
+}
 
-static void thread_task(void *arg)
+/* parallel cycle numbers wrap, 'seen' is at least 'cycle' if it is not
+   more than 2^31 behind */
+static inline int cycle_reached(unsigned int seen, unsigned int cycle)
 {
-    hal_thread_t *thread;
-    hal_funct_t *funct;
-    hal_funct_entry_t *funct_root, *funct_entry;
-    long long int start_time, end_time;
-    long long int thread_start_time;
+    return (int) (seen - cycle) >= 0;
+}
+
+static inline void spin_pause(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/* can 'entry' run in 'cycle'?  'first' is the earliest entry that has
+   not finished yet, or later */
+static int funct_entry_ready(hal_funct_entry_t * entry,
+    hal_funct_entry_t * first, unsigned int cycle)
+{
+    hal_funct_entry_t *dep;
+    int n;
+
+    if (entry->wait_all) {
+	return entry == first;
+    }
+    for (n = 0; n < HAL_FUNCT_DEPS && entry->deps[n] != 0; n++) {
+	dep = SHMPTR(entry->deps[n]);
+	if (!cycle_reached(atomic_load_explicit(&dep->done,
+		    memory_order_acquire), cycle)) {
+	    return 0;
+	}
+    }
+    return 1;
+}
+
+/* Run functions of a parallel thread that are ready, one at a time in
+   list order, until every one has been taken in this cycle, or if
+   'wait' is set, until every one has finished.  The thread and its
+   helpers all do this; an entry is taken by swapping the cycle number
+   into its 'claim', and a finished one gets it in 'done'. */
+static void thread_run_ready(hal_thread_t * thread, unsigned int cycle,
+    int wait)
+{
+    hal_funct_entry_t *funct_root, *first, *entry;
+    long long int start_time;
+    unsigned int claim;
+    int found, taken;
+
+    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
+    first = SHMPTR(funct_root->links.next);
+    while (first != funct_root) {
+	if (cycle_reached(atomic_load_explicit(&first->done,
+		    memory_order_acquire), cycle)) {
+	    first = SHMPTR(first->links.next);
+	    continue;
+	}
+	found = 0;
+	taken = 1;
+	for (entry = first; entry != funct_root;
+	    entry = SHMPTR(entry->links.next)) {
+	    claim = atomic_load_explicit(&entry->claim, memory_order_acquire);
+	    if (cycle_reached(claim, cycle)) {
+		continue;
+	    }
+	    taken = 0;
+	    if (!funct_entry_ready(entry, first, cycle)) {
+		continue;
+	    }
+	    if (__sync_bool_compare_and_swap(&entry->claim, claim, cycle)) {
+		HAL_TRACE_BEGIN(((hal_funct_t *)
+			SHMPTR(entry->funct_ptr))->trace, cycle);
+		start_time = rtapi_get_clocks();
+		entry->funct(entry->arg, thread->period);
+		update_funct_time(SHMPTR(entry->funct_ptr),
+		    rtapi_get_clocks() - start_time);
+		HAL_TRACE_END(((hal_funct_t *)
+			SHMPTR(entry->funct_ptr))->trace, cycle);
+		atomic_store_explicit(&entry->done, cycle, memory_order_release);
+		found = 1;
+		break;
+	    }
+	}
+	if (!found) {
+	    if (taken && !wait) {
+		/* the rest is being run by others */
+		return;
+	    }
+	    spin_pause();
+	}
+    }
+}
+
+/* this is the task function that implements threads in realtime */
+
+/* only the thread itself writes its histogram, see hal_latency_hist_t */
+static void record_latency(hal_thread_t * thread, long latency, long long now)
+{
+    hal_latency_hist_t *hist;
+    unsigned int req;
+    long bin;
+
+    hist = SHMPTR(thread->hist);
+    req = atomic_load_explicit(&hist->reset_req, memory_order_acquire);
+    hist->seq++;
+    __sync_synchronize();
+    if (req != hist->reset_done) {
+	hist->samples = 0;
+	hist->sum = 0;
+	hist->max_seq = 0;
+	hist->early = 0;
+	hist->overflow = 0;
+	memset(hist->bins, 0, sizeof(hist->bins));
+	hist->reset_done = req;
+    }
+    if (hist->samples == 0 || latency < hist->min) {
+	hist->min = latency;
+    }
+    if (hist->samples == 0 || latency > hist->max) {
+	hist->max = latency;
+	hist->max_time = now;
+	hist->max_seq++;
+    }
+    hist->samples++;
+    hist->sum += latency;
+    if (latency < 0) {
+	hist->early++;
+    } else {
+	bin = latency / 1000;
+	if (bin < HAL_LATENCY_BINS) {
+	    hist->bins[bin]++;
+	} else {
+	    hist->overflow++;
+	}
+    }
+    __sync_synchronize();
+    hist->seq++;
+}
+
+static void thread_task(void *arg)
+{
+    hal_thread_t *thread;
+    hal_funct_entry_t *funct_root, *funct_entry;
+    long long int start_time, end_time;
+    long long int thread_start_time;
+    long long int now, last_start = 0;
+    long int latency, wakeup;
+    unsigned int cycle;
+    int parallel;
 
     thread = arg;
     while (1) {
 	if (hal_data->threads_running > 0) {
+	    /* how late this period started; the pins are created after
+	       the task is started, so they may not be there yet */
+	    now = rtapi_get_time();
+	    if (last_start != 0 && thread->latency_max != 0) {
+		latency = (long int)(now - last_start - thread->period);
+		*(thread->latency) = latency;
+		if (latency < 0) {
+		    latency = -latency;
+		}
+		if (latency > *(thread->latency_max)) {
+		    *(thread->latency_max) = latency;
+		}
+	    }
+	    if (last_start != 0
+		&& atomic_load_explicit(&thread->hist_enabled, memory_order_acquire)) {
+		wakeup = (long int)(now - last_start - thread->period);
+#ifdef RTAPI_TASK_PLL_SUPPORT
+		/* measured right at the wakeup, where RTAPI can */
+		rtapi_task_wakeup_latency(&wakeup);
+#endif
+		record_latency(thread, wakeup, now);
+	    }
+	    HAL_TRACE_BEGIN(thread->trace,
+		last_start != 0 ? now - last_start - thread->period : 0);
+	    last_start = now;
 	    /* point at first function on function list */
 	    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
 	    funct_entry = SHMPTR(funct_root->links.next);
@@ -3014,22 +3533,38 @@ static void thread_task(void *arg)
 	    start_time = rtapi_get_clocks();
 	    end_time = start_time;
 	    thread_start_time = start_time;
+	    /* a parallel cycle, unless the plan is being changed, see
+	       thread_plan_invalidate() */
+	    parallel = 0;
+	    if (thread->workers > 0) {
+		__sync_fetch_and_add(&thread->parallel_busy, 1);
+		parallel = atomic_load(&thread->plan_valid);
+		if (!parallel) {
+		    __sync_fetch_and_sub(&thread->parallel_busy, 1);
+		}
+	    }
+	    if (parallel) {
+		/* start the helpers, and be done when all functs are */
+		cycle = thread->cycle + 1;
+		atomic_store_explicit(&thread->cycle, cycle, memory_order_release);
+		thread_run_ready(thread, cycle, 1);
+		__sync_fetch_and_sub(&thread->parallel_busy, 1);
+		end_time = rtapi_get_clocks();
+		funct_entry = funct_root;
+	    }
 	    /* run thru function list */
 	    while (funct_entry != funct_root) {
+		HAL_TRACE_BEGIN(((hal_funct_t *)
+			SHMPTR(funct_entry->funct_ptr))->trace, 0);
 		/* call the function */
 		funct_entry->funct(funct_entry->arg, thread->period);
 		/* capture execution time */
 		end_time = rtapi_get_clocks();
-		/* point to function structure */
-		funct = SHMPTR(funct_entry->funct_ptr);
+		HAL_TRACE_END(((hal_funct_t *)
+			SHMPTR(funct_entry->funct_ptr))->trace, 0);
 		/* update execution time data */
-		*(funct->runtime) = (hal_s32_t)(end_time - start_time);
-		if ( *(funct->runtime) > funct->maxtime) {
-		    funct->maxtime = *(funct->runtime);
-		    funct->maxtime_increased = 1;
-		} else {
-		    funct->maxtime_increased = 0;
-		}
+		update_funct_time(SHMPTR(funct_entry->funct_ptr),
+		    end_time - start_time);
 		/* point to next next entry in list */
 		funct_entry = SHMPTR(funct_entry->links.next);
 		/* prepare to measure time for next funct */
@@ -3040,19 +3575,535 @@ static void thread_task(void *arg)
 	    if ( *(thread->runtime) > thread->maxtime) {
 	        thread->maxtime = *(thread->runtime);
 	    }
+	    HAL_TRACE_END(thread->trace, 0);
+	} else {
+	    last_start = 0;
 	}
 	/* wait until next period */
 	rtapi_wait();
     }
 }
+
+/* A helper of a parallel thread waits for the thread to start a cycle
+   and runs the functions that are ready.  On a realtime system it
+   busy-waits, so it should have an isolated CPU; if the thread has not
+   started a cycle for two periods, or threads are stopped, it sleeps
+   for a period instead, which also lets it be deleted. */
+static void worker_task(void *arg)
+{
+    hal_thread_t *thread;
+    unsigned int cycle, seen;
+    long long int idle_since;
+    int spin;
+
+    thread = arg;
+    spin = rtapi_is_realtime();
+    seen = atomic_load(&thread->cycle);
+    idle_since = rtapi_get_time();
+    while (!thread->workers_exit) {
+	cycle = atomic_load_explicit(&thread->cycle, memory_order_acquire);
+	if (cycle != seen) {
+	    seen = cycle;
+	    __sync_fetch_and_add(&thread->parallel_busy, 1);
+	    if (atomic_load(&thread->plan_valid)) {
+		thread_run_ready(thread, cycle, 0);
+	    }
+	    __sync_fetch_and_sub(&thread->parallel_busy, 1);
+	    idle_since = rtapi_get_time();
+	} else if (spin && hal_data->threads_running > 0
+	    && rtapi_get_time() - idle_since < 2 * thread->period) {
+	    spin_pause();
+	} else {
+	    rtapi_wait();
+	    idle_since = rtapi_get_time();
+	}
+    }
+    while (1) {
+	rtapi_wait();
+    }
+}
+
+/***********************************************************************
+*                          TRACE POINTS                                *
+************************************************************************/
+
+/* the buffer of each realtime task, by task ID, see hal_trace.h */
+#define TRACE_TASKS 65
+static hal_trace_buf_t *trace_task_buf[TRACE_TASKS];
+
+static void trace_init(void)
+{
+#ifdef HAL_TRACING
+    void *mem;
+    int n;
+
+    trace_mem_id = rtapi_shmem_new(HAL_TRACE_KEY, lib_module_id,
+	sizeof(hal_trace_t));
+    if (trace_mem_id < 0 || rtapi_shmem_getptr(trace_mem_id, &mem) < 0) {
+	rtapi_print_msg(RTAPI_MSG_WARN,
+	    "HAL_LIB: WARNING: could not get memory for trace buffers\n");
+	if (trace_mem_id >= 0) {
+	    rtapi_shmem_delete(trace_mem_id, lib_module_id);
+	}
+	return;
+    }
+    hal_trace_data = mem;
+    memset(hal_trace_data, 0, sizeof(hal_trace_t));
+    hal_trace_data->nnames = 1;
+    for (n = 0; n < HAL_TRACE_BUFS; n++) {
+	hal_trace_data->bufs[n].task_id = -1;
+    }
+    hal_trace_data->version = HAL_TRACE_VERSION;
+#endif
+}
+
+int hal_trace_register(const char *name)
+{
+    int n;
+
+    if (hal_trace_data == 0 || name == 0) {
+	return 0;
+    }
+    rtapi_mutex_get(&(hal_trace_data->mutex));
+    for (n = 1; n < hal_trace_data->nnames; n++) {
+	if (strcmp(hal_trace_data->names[n], name) == 0) {
+	    break;
+	}
+    }
+    if (n == hal_trace_data->nnames) {
+	if (n < HAL_TRACE_NAMES) {
+	    rtapi_snprintf(hal_trace_data->names[n], HAL_NAME_LEN + 1,
+		"%s", name);
+	    hal_trace_data->nnames++;
+	} else {
+	    rtapi_print_msg(RTAPI_MSG_WARN,
+		"HAL: WARNING: no room to trace '%s'\n", name);
+	    n = 0;
+	}
+    }
+    rtapi_mutex_give(&(hal_trace_data->mutex));
+    return n;
+}
+
+/* a buffer nobody used yet, or else the one left longest ago */
+static void trace_attach(int task_id, const char *name)
+{
+    hal_trace_buf_t *buf, *found = 0;
+    int n;
+
+    if (hal_trace_data == 0 || task_id < 0 || task_id >= TRACE_TASKS) {
+	return;
+    }
+    rtapi_mutex_get(&(hal_trace_data->mutex));
+    for (n = 0; n < HAL_TRACE_BUFS; n++) {
+	buf = &(hal_trace_data->bufs[n]);
+	if (buf->name[0] == '\0') {
+	    found = buf;
+	    break;
+	}
+	if (buf->task_id < 0 && (found == 0 || buf->head == 0
+		|| (found->head != 0 && buf->events[(buf->head - 1)
+			% HAL_TRACE_EVENTS].time < found->events[(found->head
+			    - 1) % HAL_TRACE_EVENTS].time))) {
+	    found = buf;
+	}
+    }
+    if (found != 0) {
+	rtapi_snprintf(found->name, sizeof(found->name), "%s", name);
+	found->head = 0;
+	found->start = 0;
+	found->task_id = task_id;
+    } else {
+	rtapi_print_msg(RTAPI_MSG_WARN,
+	    "HAL: WARNING: no trace buffer left for '%s'\n", name);
+    }
+    trace_task_buf[task_id] = found;
+    rtapi_mutex_give(&(hal_trace_data->mutex));
+}
+
+static void trace_detach(int task_id)
+{
+    if (hal_trace_data == 0 || task_id < 0 || task_id >= TRACE_TASKS
+	|| trace_task_buf[task_id] == 0) {
+	return;
+    }
+    rtapi_mutex_get(&(hal_trace_data->mutex));
+    trace_task_buf[task_id]->task_id = -1;
+    trace_task_buf[task_id] = 0;
+    rtapi_mutex_give(&(hal_trace_data->mutex));
+}
+
+/* only the task that owns a buffer writes it */
+void hal_trace(int event, int phase, long arg)
+{
+    hal_trace_buf_t *buf;
+    hal_trace_event_t *ev;
+    rtapi_u32 head;
+    int task_id;
+
+    if (event <= 0 || hal_trace_data == 0 || !hal_trace_data->enabled) {
+	return;
+    }
+    task_id = rtapi_task_self();
+    if (task_id < 0 || task_id >= TRACE_TASKS
+	|| (buf = trace_task_buf[task_id]) == 0) {
+	return;
+    }
+    head = buf->head;
+    ev = &(buf->events[head % HAL_TRACE_EVENTS]);
+    ev->time = rtapi_get_time();
+    ev->event = event;
+    ev->phase = phase;
+    ev->arg = arg;
+    atomic_store_explicit(&buf->head, head + 1, memory_order_release);
+}
+#endif /* RTAPI */
+
+/***********************************************************************
+*                  PARALLEL THREAD DEPENDENCIES                        *
+************************************************************************/
+
+/* a pin linked to a signal, used by a function of a parallel thread */
+typedef struct {
+    rtapi_intptr_t sig;		/* the signal */
+    int entry;			/* position of the function in the thread */
+    int writes;			/* nonzero unless it only reads the signal */
+} plan_use_t;
+
+#define PLAN_BIT(set, n) ((set)[(n) / 32] & (1u << ((n) % 32)))
+#define PLAN_SET(set, n) ((set)[(n) / 32] |= (1u << ((n) % 32)))
+
+/* does 'pin' belong to the component instance of 'funct'?  'len' is the
+   length of the instance name in the function name, 0 for the whole
+   component.  Aliased pins are known by their original name. */
+static int pin_of_funct(hal_pin_t * pin, hal_funct_t * funct, int len)
+{
+    hal_oldname_t *oldname;
+    char *name;
+
+    if (pin->owner_ptr != funct->owner_ptr) {
+	return 0;
+    }
+    if (len == 0) {
+	return 1;
+    }
+    name = pin->name;
+    if (pin->oldname != 0) {
+	oldname = SHMPTR(pin->oldname);
+	name = oldname->name;
+    }
+    return strncmp(name, funct->name, len) == 0 && name[len] == '.';
+}
+
+/* The instance name in the name of a function is the longest leading
+   part, ending before a '.', that pin names of its component start with:
+   "pid.0" for "pid.0.do-pid-calcs", "scale.0" for "scale.0".  Returns
+   its length, or 0 if there is none, as for "motion-controller".  The
+   function's own <name>.time pin does not count. */
+static int funct_instance_len(hal_funct_t * funct)
+{
+    hal_pin_t *pin;
+    rtapi_intptr_t next;
+    int len;
+
+    len = strlen(funct->name);
+    while (len > 0) {
+	next = hal_data->pin_list_ptr;
+	while (next != 0) {
+	    pin = SHMPTR(next);
+	    if (pin->data_ptr_addr != SHMOFF(&(funct->runtime))
+		&& pin_of_funct(pin, funct, len)) {
+		return len;
+	    }
+	    next = pin->next_ptr;
+	}
+	do {
+	    len--;
+	} while (len > 0 && funct->name[len] != '.');
+    }
+    return 0;
+}
+
+/* Work out which earlier functions each function of 'thread' has to wait
+   for: those of the same component instance, and those that share a
+   signal with it, unless both only read it.  A parallel cycle then gives
+   the same results as running the functions in list order.  Only the
+   direct dependencies are kept, at most HAL_FUNCT_DEPS; an entry with
+   more waits for all earlier ones.  Needs the mutex, and no parallel
+   cycle running. */
+static int thread_plan_build(hal_thread_t * thread)
+{
+    hal_list_t *list_root, *list_entry;
+    hal_funct_entry_t **entry;
+    hal_funct_t **funct;
+    hal_pin_t *pin;
+    plan_use_t *use, tmp;
+    unsigned int *direct, *reach, *cover;
+    int *len, *depth;
+    int count, uses, words, longest;
+    int i, j, k, gap, n;
+    rtapi_intptr_t next;
+
+    count = 0;
+    list_root = &(thread->funct_list);
+    for (list_entry = list_next(list_root); list_entry != list_root;
+	list_entry = list_next(list_entry)) {
+	count++;
+    }
+    if (count == 0) {
+	return 0;
+    }
+    words = (count + 31) / 32;
+    entry = rtapi_kzalloc(count * sizeof(*entry), RTAPI_GFP_KERNEL);
+    funct = rtapi_kzalloc(count * sizeof(*funct), RTAPI_GFP_KERNEL);
+    len = rtapi_kzalloc(count * sizeof(*len), RTAPI_GFP_KERNEL);
+    depth = rtapi_kzalloc(count * sizeof(*depth), RTAPI_GFP_KERNEL);
+    direct = rtapi_kzalloc(count * words * sizeof(*direct), RTAPI_GFP_KERNEL);
+    reach = rtapi_kzalloc(count * words * sizeof(*reach), RTAPI_GFP_KERNEL);
+    cover = rtapi_kzalloc(words * sizeof(*cover), RTAPI_GFP_KERNEL);
+    use = 0;
+    if (!entry || !funct || !len || !depth || !direct || !reach || !cover) {
+	goto fail;
+    }
+    i = 0;
+    for (list_entry = list_next(list_root); list_entry != list_root;
+	list_entry = list_next(list_entry)) {
+	entry[i] = (hal_funct_entry_t *) list_entry;
+	funct[i] = SHMPTR(entry[i]->funct_ptr);
+	len[i] = funct_instance_len(funct[i]);
+	i++;
+    }
+
+    /* functions of the same instance, or of a component without
+       instances, keep their order */
+    for (i = 0; i < count; i++) {
+	for (j = 0; j < i; j++) {
+	    if (funct[i]->owner_ptr == funct[j]->owner_ptr
+		&& (len[i] == 0 || len[j] == 0 || (len[i] == len[j]
+			&& strncmp(funct[i]->name, funct[j]->name, len[i]) == 0))) {
+		PLAN_SET(&direct[i * words], j);
+	    }
+	}
+    }
+
+    /* collect the linked pins of each function, sorted by signal */
+    for (n = 0; n < 2; n++) {
+	uses = 0;
+	next = hal_data->pin_list_ptr;
+	while (next != 0) {
+	    pin = SHMPTR(next);
+	    next = pin->next_ptr;
+	    if (pin->signal == 0) {
+		continue;
+	    }
+	    for (i = 0; i < count; i++) {
+		if (!pin_of_funct(pin, funct[i], len[i])) {
+		    continue;
+		}
+		if (use) {
+		    use[uses].sig = pin->signal;
+		    use[uses].entry = i;
+		    /* reading from a port takes the data out */
+		    use[uses].writes = pin->dir != HAL_IN || pin->type == HAL_PORT;
+		}
+		uses++;
+	    }
+	}
+	if (use || uses == 0) {
+	    break;
+	}
+	use = rtapi_kzalloc(uses * sizeof(*use), RTAPI_GFP_KERNEL);
+	if (!use) {
+	    goto fail;
+	}
+    }
+    for (gap = uses / 2; gap > 0; gap /= 2) {
+	for (i = gap; i < uses; i++) {
+	    tmp = use[i];
+	    for (j = i; j >= gap && (use[j - gap].sig > tmp.sig
+		    || (use[j - gap].sig == tmp.sig
+			&& use[j - gap].entry > tmp.entry)); j -= gap) {
+		use[j] = use[j - gap];
+	    }
+	    use[j] = tmp;
+	}
+    }
+    /* a writer waits for earlier readers and writers of its signals, a
+       reader for earlier writers */
+    for (i = 0; i < uses; i = k) {
+	for (k = i + 1; k < uses && use[k].sig == use[i].sig; k++) {
+	}
+	for (j = i; j < k; j++) {
+	    for (n = i; n < j; n++) {
+		if (use[n].entry != use[j].entry
+		    && (use[n].writes || use[j].writes)) {
+		    PLAN_SET(&direct[use[j].entry * words], use[n].entry);
+		}
+	    }
+	}
+    }
+
+    /* drop the dependencies that follow from others */
+    longest = 0;
+    for (i = 0; i < count; i++) {
+	memset(cover, 0, words * sizeof(*cover));
+	depth[i] = 1;
+	for (j = 0; j < i; j++) {
+	    if (PLAN_BIT(&direct[i * words], j)) {
+		for (n = 0; n < words; n++) {
+		    reach[i * words + n] |= reach[j * words + n];
+		    cover[n] |= reach[j * words + n];
+		}
+		PLAN_SET(&reach[i * words], j);
+		if (depth[j] + 1 > depth[i]) {
+		    depth[i] = depth[j] + 1;
+		}
+	    }
+	}
+	if (depth[i] > longest) {
+	    longest = depth[i];
+	}
+	memset(entry[i]->deps, 0, sizeof(entry[i]->deps));
+	entry[i]->wait_all = 0;
+	n = 0;
+	for (j = 0; j < i; j++) {
+	    if (PLAN_BIT(&direct[i * words], j) && !PLAN_BIT(cover, j)) {
+		if (n == HAL_FUNCT_DEPS) {
+		    entry[i]->wait_all = 1;
+		    break;
+		}
+		entry[i]->deps[n++] = SHMOFF(entry[j]);
+	    }
+	}
+	/* nothing to do for the cycle that is over */
+	entry[i]->claim = thread->cycle;
+	entry[i]->done = thread->cycle;
+    }
+    rtapi_print_msg(RTAPI_MSG_INFO,
+	"HAL: thread '%s': %d functions, %d in the longest chain\n",
+	thread->name, count, longest);
+    n = 0;
+    goto done;
+
+fail:
+    rtapi_print_msg(RTAPI_MSG_ERR,
+	"HAL: ERROR: insufficient memory to plan thread '%s'\n", thread->name);
+    n = -ENOMEM;
+done:
+    rtapi_kfree(entry);
+    rtapi_kfree(funct);
+    rtapi_kfree(len);
+    rtapi_kfree(depth);
+    rtapi_kfree(direct);
+    rtapi_kfree(reach);
+    rtapi_kfree(cover);
+    rtapi_kfree(use);
+    return n;
+}
+
+static int thread_plan_invalidate(hal_thread_t * thread)
+{
+    long int waited;
+    int valid;
+
+    if (thread->workers == 0) {
+	return 0;
+    }
+    valid = __sync_lock_test_and_set(&thread->plan_valid, 0);
+    /* a cycle that saw the plan valid has raised parallel_busy first;
+       the mutex is held, so give it no more than a few periods */
+    for (waited = 0; atomic_load(&thread->parallel_busy) != 0;
+	waited += rtapi_delay_max()) {
+	if (waited > 4 * thread->period) {
+	    atomic_store(&thread->plan_valid, valid);
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: thread '%s' does not finish its cycle\n",
+		thread->name);
+	    return -EBUSY;
+	}
+	rtapi_delay(rtapi_delay_max());
+    }
+    return 0;
+}
+
+static void thread_plan_update(hal_thread_t * thread)
+{
+    if (thread->workers == 0) {
+	return;
+    }
+    if (thread_plan_invalidate(thread) != 0) {
+	/* the old plan does not fit the links any more */
+	atomic_store(&thread->plan_valid, 0);
+	return;
+    }
+    if (hal_data->threads_running == 0) {
+	return;
+    }
+    if (thread_plan_build(thread) != 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: thread '%s' runs its functions one after the other\n",
+	    thread->name);
+	return;
+    }
+    atomic_store(&thread->plan_valid, 1);
+}
+
+#ifdef RTAPI
+static int threads_invalidate_comp(hal_comp_t * comp)
+{
+    hal_thread_t *thread;
+    hal_list_t *list_root, *list_entry;
+    hal_funct_t *funct;
+    rtapi_intptr_t next;
+
+    next = hal_data->thread_list_ptr;
+    while (next != 0) {
+	thread = SHMPTR(next);
+	list_root = &(thread->funct_list);
+	for (list_entry = list_next(list_root); list_entry != list_root;
+	    list_entry = list_next(list_entry)) {
+	    funct = SHMPTR(((hal_funct_entry_t *) list_entry)->funct_ptr);
+	    if (SHMPTR(funct->owner_ptr) != comp) {
+		continue;
+	    }
+	    if (thread_plan_invalidate(thread) == 0) {
+		break;
+	    }
+	    /* the ones before it go back to their plans */
+	    next = hal_data->thread_list_ptr;
+	    while (SHMPTR(next) != thread) {
+		thread_plan_update(SHMPTR(next));
+		next = ((hal_thread_t *) SHMPTR(next))->next_ptr;
+	    }
+	    return -EBUSY;
+	}
+	next = thread->next_ptr;
+    }
+    return 0;
+}
 #endif /* RTAPI */
 
+void halpr_thread_plans_update(void)
+{
+    hal_thread_t *thread;
+    rtapi_intptr_t next;
+
+    next = hal_data->thread_list_ptr;
+    while (next != 0) {
+	thread = SHMPTR(next);
+	thread_plan_update(thread);
+	next = thread->next_ptr;
+    }
+}
+
 /* see the declarations of these functions (near top of file) for
    a description of what they do.
 */
 
 static int init_hal_data(void)
 {
+    int n;
+
     /* has the hal_data block already been initialized? */
 
     /* Lock hal_data by taking the mutex, so that two processes
@@ -3098,6 +4149,11 @@ static int init_hal_data(void)
     hal_data->constructor_prefix[0] = 0;
     list_init_entry(&(hal_data->funct_entry_free));
     hal_data->thread_free_ptr = 0;
+    hal_data->block_list_ptr = 0;
+    for (n = 0; n < HAL_BLOCK_CLASSES; n++) {
+	hal_data->block_free_ptr[n] = 0;
+    }
+    hal_data->block_kept = 0;
     hal_data->exact_base_period = 0;
     /* set up for shmalloc_xx() */
     hal_data->shmem_bot = sizeof(hal_data_t);
@@ -3175,6 +4231,130 @@ static void *shmalloc_dn(long int size)
     return retval;
 }
 
+/* hal_malloc() blocks are sorted into free lists by size: in steps of
+   16 bytes up to 256, then in four steps per power of two.  A freed block
+   goes to the class of its size rounded down, so any block on a list
+   of a bigger class than that of a request is big enough for it.  A
+   bigger block is also aligned at least as well as a new one would be,
+   see shmalloc_up(). */
+static int block_class(long int size)
+{
+    int k, c;
+
+    if (size < 32) {
+	return 0;
+    }
+    if (size < 256) {
+	return size / 16 - 1;
+    }
+    for (k = 8; (size >> (k + 1)) != 0; k++) {
+    }
+    c = 15 + (k - 8) * 4 + ((size >> (k - 2)) & 3);
+    return c < HAL_BLOCK_CLASSES ? c : HAL_BLOCK_CLASSES - 1;
+}
+
+/* takes the first block of at least 'size' bytes off free list 'c' */
+static hal_block_t *block_take(int c, long int size)
+{
+    SHMFIELD(hal_block_t) *prev, next;
+    hal_block_t *block;
+
+    prev = &(hal_data->block_free_ptr[c]);
+    next = *prev;
+    while (next != 0) {
+	block = SHMPTR(next);
+	if (block->size >= size) {
+	    *prev = block->next_ptr;
+	    return block;
+	}
+	prev = &(block->next_ptr);
+	next = *prev;
+    }
+    return 0;
+}
+
+static void *block_alloc(long int size, int owner)
+{
+    hal_block_t *block = 0;
+    void *data;
+    int c, first;
+
+    if (owner == 0) {
+	/* nobody will give it back, no need to keep track of it */
+	data = shmalloc_up(size);
+	if (data != 0) {
+	    hal_data->block_kept += size;
+	}
+	return data;
+    }
+    /* a freed block of the same size: that is what a component that is
+       loaded again asks for */
+    first = block_class(size);
+    block = block_take(first, size);
+    /* otherwise one of a slightly bigger class */
+    for (c = first + 1; block == 0 && c < HAL_BLOCK_CLASSES && c <= first + 4; c++) {
+	block = block_take(c, 0);
+    }
+    if (block != 0) {
+	/* new blocks from shmalloc_up() are zeroed, these must be too */
+	memset(SHMPTR(block->data_ptr), 0, block->size);
+    } else {
+	data = shmalloc_up(size);
+	if (data != 0) {
+	    block = shmalloc_dn(sizeof(hal_block_t));
+	    if (block == 0) {
+		/* no room to keep track of it, it can't be given back */
+		hal_data->block_kept += size;
+		return data;
+	    }
+	    block->data_ptr = SHMOFF(data);
+	    block->size = size;
+	}
+    }
+    /* when shared memory runs out, even a much bigger block will do */
+    for (; block == 0 && c < HAL_BLOCK_CLASSES; c++) {
+	block = block_take(c, 0);
+	if (block != 0) {
+	    memset(SHMPTR(block->data_ptr), 0, block->size);
+	}
+    }
+    if (block == 0) {
+	return 0;
+    }
+    block->owner = owner;
+    block->next_ptr = hal_data->block_list_ptr;
+    hal_data->block_list_ptr = SHMOFF(block);
+    return SHMPTR(block->data_ptr);
+}
+
+static void free_comp_blocks(int owner)
+{
+    SHMFIELD(hal_block_t) *prev, next;
+    hal_block_t *block;
+    int c;
+
+    if (owner == 0) {
+	return;
+    }
+    prev = &(hal_data->block_list_ptr);
+    next = *prev;
+    while (next != 0) {
+	block = SHMPTR(next);
+	if (block->owner == owner) {
+	    /* unlink it from the list of blocks in use */
+	    *prev = block->next_ptr;
+	    /* and add it to the free list of its size class */
+	    c = block_class(block->size);
+	    block->owner = 0;
+	    block->next_ptr = hal_data->block_free_ptr[c];
+	    hal_data->block_free_ptr[c] = SHMOFF(block);
+	} else {
+	    prev = &(block->next_ptr);
+	}
+	next = *prev;
+    }
+}
+
 hal_comp_t *halpr_alloc_comp_struct(void)
 {
     hal_comp_t *p;
@@ -3334,6 +4514,7 @@ static hal_funct_t *alloc_funct_struct(void)
 	p->arg = 0;
 	p->funct = 0;
 	p->name[0] = '\0';
+	p->trace = 0;
     }
     return p;
 }
@@ -3362,6 +4543,10 @@ static hal_funct_entry_t *alloc_funct_entry_struct(void)
 	p->funct_ptr = 0;
 	p->arg = 0;
 	p->funct = 0;
+	p->claim = 0;
+	p->done = 0;
+	p->wait_all = 0;
+	memset(p->deps, 0, sizeof(p->deps));
     }
     return p;
 }
@@ -3381,6 +4566,10 @@ static hal_thread_t *alloc_thread_struct(void)
     } else {
 	/* nothing on free list, allocate a brand new one */
 	p = shmalloc_dn(sizeof(hal_thread_t));
+	if (p) {
+	    /* a reused struct keeps its histogram */
+	    p->hist = 0;
+	}
     }
     if (p) {
 	/* make sure it's empty */
@@ -3391,6 +4580,16 @@ static hal_thread_t *alloc_thread_struct(void)
 	p->task_id = 0;
 	list_init_entry(&(p->funct_list));
 	p->name[0] = '\0';
+	p->cpus[0] = '\0';
+	p->latency = 0;
+	p->latency_max = 0;
+	p->workers = 0;
+	p->workers_exit = 0;
+	p->plan_valid = 0;
+	p->parallel_busy = 0;
+	p->cycle = 0;
+	p->hist_enabled = 0;
+	p->trace = 0;
     }
     return p;
 }
@@ -3457,6 +4656,8 @@ static void free_comp_struct(hal_comp_t * comp)
 	}
 	next = *prev;
     }
+    /* nothing of the component uses its memory any more */
+    free_comp_blocks(comp->comp_id);
     /* now we can delete the component itself */
     /* clear contents of struct */
     comp->comp_id = 0;
@@ -3627,7 +4828,9 @@ static void free_funct_struct(hal_funct_t * funct)
 		funct_entry = (hal_funct_entry_t *) list_entry;
 		/* test it */
 		if (SHMPTR(funct_entry->funct_ptr) == funct) {
-		    /* this funct entry points to our funct, unlink */
+		    /* this funct entry points to our funct, unlink; the
+		       caller has stopped the parallel cycles, see
+		       threads_invalidate_comp() */
 		    list_entry = list_remove_entry(list_entry);
 		    /* and delete it */
 		    free_funct_entry_struct(funct_entry);
@@ -3677,6 +4880,7 @@ static void free_thread_struct(hal_thread_t * thread)
 {
     hal_funct_entry_t *funct_entry;
     hal_list_t *list_root, *list_entry;
+    int n;
 /*! \todo Another #if 0 */
 #if 0
     rtapi_intptr_t *prev, next;
@@ -3689,11 +4893,23 @@ static void free_thread_struct(hal_thread_t * thread)
     /* and stop the task associated with this thread */
     rtapi_task_pause(thread->task_id);
     rtapi_task_delete(thread->task_id);
+    trace_detach(thread->task_id);
+    /* and the helpers, which wait for the end in rtapi_wait() */
+    thread->workers_exit = 1;
+    for (n = 0; n < thread->workers; n++) {
+	rtapi_task_pause(thread->worker_task[n]);
+	rtapi_task_delete(thread->worker_task[n]);
+	trace_detach(thread->worker_task[n]);
+    }
     /* clear contents of struct */
     thread->uses_fp = 0;
     thread->period = 0;
     thread->priority = 0;
     thread->task_id = 0;
+    thread->workers = 0;
+    thread->workers_exit = 0;
+    thread->plan_valid = 0;
+    thread->hist_enabled = 0;
     /* clear the function entry list */
     list_root = &(thread->funct_list);
     list_entry = list_next(list_root);
@@ -4243,6 +5459,75 @@ int hal_stream_read(hal_stream_t *stream, union hal_stream_data *buf, unsigned *
     return 0;
 }
 
+int hal_stream_stride(hal_stream_t *stream) {
+    return stream->fifo->num_pins + 1;
+}
+
+/* records from 'in' up to the end of the fifo or the slot before 'out' */
+static unsigned hal_stream_write_avail(hal_stream_t *stream, unsigned in) {
+    unsigned out = hal_stream_atomic_load_out(stream);
+    if(in < out) return out - in - 1;
+    if(out == 0) return stream->fifo->depth - in - 1;
+    return stream->fifo->depth - in;
+}
+
+/* records from 'out' up to the end of the fifo or to 'in' */
+static unsigned hal_stream_read_avail(hal_stream_t *stream, unsigned out) {
+    unsigned in = hal_stream_atomic_load_in(stream);
+    if(out <= in) return in - out;
+    return stream->fifo->depth - out;
+}
+
+int hal_stream_write_span(hal_stream_t *stream, union hal_stream_data **buf, unsigned max) {
+    unsigned in = stream->fifo->in;
+    unsigned count = hal_stream_write_avail(stream, in);
+    if(count == 0) {
+        stream->fifo->num_overruns++;
+        return 0;
+    }
+    if(count > max) count = max;
+    *buf = &stream->fifo->data[in * hal_stream_stride(stream)];
+    return count;
+}
+
+int hal_stream_write_commit(hal_stream_t *stream, unsigned count) {
+    unsigned in = stream->fifo->in;
+    if(count > hal_stream_write_avail(stream, in)) return -EINVAL;
+    int num_pins = stream->fifo->num_pins;
+    int stride = num_pins + 1;
+    union hal_stream_data *dptr = &stream->fifo->data[in * stride];
+    unsigned i;
+    for(i = 0; i < count; i++) {
+        dptr[num_pins].s = ++stream->fifo->this_sample;
+        dptr += stride;
+    }
+    in += count;
+    if(in >= stream->fifo->depth) in = 0;
+    hal_stream_atomic_store_in(stream, in);
+    return 0;
+}
+
+int hal_stream_read_span(hal_stream_t *stream, union hal_stream_data **buf, unsigned max) {
+    unsigned out = stream->fifo->out;
+    unsigned count = hal_stream_read_avail(stream, out);
+    if(count == 0) {
+        stream->fifo->num_underruns++;
+        return 0;
+    }
+    if(count > max) count = max;
+    *buf = &stream->fifo->data[out * hal_stream_stride(stream)];
+    return count;
+}
+
+int hal_stream_read_commit(hal_stream_t *stream, unsigned count) {
+    unsigned out = stream->fifo->out;
+    if(count > hal_stream_read_avail(stream, out)) return -EINVAL;
+    out += count;
+    if(out >= stream->fifo->depth) out = 0;
+    hal_stream_atomic_store_out(stream, out);
+    return 0;
+}
+
 int hal_stream_attach(hal_stream_t *stream, int comp_id, int key, const char *typestring) {
     int i;
 
@@ -4392,11 +5677,17 @@ EXPORT_SYMBOL(hal_export_funct);
 EXPORT_SYMBOL(hal_export_functf);
 
 EXPORT_SYMBOL(hal_create_thread);
+EXPORT_SYMBOL(hal_create_thread_cpus);
+EXPORT_SYMBOL(hal_thread_parallel);
+EXPORT_SYMBOL(hal_thread_sched);
 
 EXPORT_SYMBOL(hal_add_funct_to_thread);
 EXPORT_SYMBOL(hal_del_funct_from_thread);
 
 EXPORT_SYMBOL(hal_start_threads);
+EXPORT_SYMBOL(hal_thread_latency);
+EXPORT_SYMBOL(hal_trace_register);
+EXPORT_SYMBOL(hal_trace);
 EXPORT_SYMBOL(hal_stop_threads);
 
 EXPORT_SYMBOL(hal_shmem_base);
@@ -4435,6 +5726,10 @@ EXPORT_SYMBOL_GPL(hal_stream_depth);
 EXPORT_SYMBOL_GPL(hal_stream_maxdepth);
 EXPORT_SYMBOL_GPL(hal_stream_write);
 EXPORT_SYMBOL_GPL(hal_stream_read);
+EXPORT_SYMBOL_GPL(hal_stream_write_span);
+EXPORT_SYMBOL_GPL(hal_stream_write_commit);
+EXPORT_SYMBOL_GPL(hal_stream_read_span);
+EXPORT_SYMBOL_GPL(hal_stream_read_commit);
 EXPORT_SYMBOL_GPL(hal_stream_attach);
 EXPORT_SYMBOL_GPL(hal_stream_detach);
 EXPORT_SYMBOL_GPL(hal_stream_element_count);
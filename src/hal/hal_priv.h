@@ -118,7 +118,7 @@
 */
 
 #define HAL_KEY   0x48414C32	/* key used to open HAL shared memory */
-#define HAL_VER   0x00000010	/* version code */
+#define HAL_VER   0x00000014	/* version code */
 #define HAL_SIZE  (256*4096)
 #define HAL_PSEUDO_COMP_PREFIX "__" /* prefix to identify a pseudo component */
 
@@ -229,6 +229,24 @@ typedef struct hal_oldname_t {
     char name[HAL_NAME_LEN + 1];	/* the original name */
 } hal_oldname_t;
 
+/** HAL "block" data structure.
+    hal_malloc() memory has no header, so realtime data is packed as
+    tightly as ever.  A block that belongs to a component gets one of
+    these descriptors instead, allocated with the other structures at
+    the top of shared memory.  It is on 'block_list_ptr' while the block
+    is in use; when the component exits, it goes to one of the free
+    lists 'block_free_ptr[]', by size class, to be handed out again by
+    a later hal_malloc().  Blocks without an owner are not tracked.
+*/
+#define HAL_BLOCK_CLASSES 64
+
+typedef struct hal_block_t {
+    SHMFIELD(hal_block_t) next_ptr;		/* next block in the list */
+    SHMFIELD(void) data_ptr;		/* the memory hal_malloc() returned */
+    int owner;			/* comp_id of the owner */
+    int size;			/* size of the memory */
+} hal_block_t;
+
 typedef struct hal_comp_t hal_comp_t;
 typedef struct hal_pin_t hal_pin_t;
 typedef struct hal_sig_t hal_sig_t;
@@ -273,6 +291,10 @@ typedef struct hal_data_t {
     SHMFIELD(hal_funct_t) funct_free_ptr;		/* list of free function structs */
     hal_list_t funct_entry_free;	/* list of free funct entry structs */
     SHMFIELD(hal_thread_t) thread_free_ptr;	/* list of free thread structs */
+    SHMFIELD(hal_block_t) block_list_ptr;	/* hal_malloc() blocks in use */
+    SHMFIELD(hal_block_t) block_free_ptr[HAL_BLOCK_CLASSES];
+				/* free hal_malloc() blocks, by size class */
+    int block_kept;		/* hal_malloc() bytes without an owner */
     int exact_base_period;      /* if set, pretend that rtapi satisfied our
 				   period request exactly */
     unsigned char lock;         /* hal locking, can be one of the HAL_LOCK_* types */
@@ -375,17 +397,47 @@ struct hal_funct_t {
     hal_s32_t maxtime;	/* (param) duration of longest run, in CPU cycles */
     hal_bit_t maxtime_increased;	/* on last call, maxtime increased */
     char name[HAL_NAME_LEN + 1];	/* function name */
+    int trace;			/* trace event, see hal_trace.h */
 };
 
+#define HAL_FUNCT_DEPS 4	/* dependencies kept per function entry */
+
 struct hal_funct_entry_t {
     hal_list_t links;		/* linked list data */
     void *arg;			/* argument for function */
     void (*funct) (void *, long);	/* ptr to function code */
     SHMFIELD(hal_funct_t) funct_ptr;		/* pointer to function */
+    /* parallel execution, see hal_thread_parallel() */
+    unsigned int claim;		/* last cycle a worker took this entry */
+    unsigned int done;		/* last cycle this entry finished */
+    int wait_all;		/* wait for all earlier entries, not deps */
+    SHMFIELD(hal_funct_entry_t) deps[HAL_FUNCT_DEPS];
+				/* earlier entries that must finish first */
 };
 
 #define HAL_STACKSIZE 16384	/* realtime task stacksize */
 
+/** The wakeup latency histogram of a thread, see hal_thread_latency().
+    Only the thread itself writes it, once per period; 'seq' is odd
+    while it does, so readers can tell they got a consistent copy.
+*/
+#define HAL_LATENCY_BINS 1000	/* 1 us bins, later ones go to overflow */
+
+typedef struct {
+    unsigned int seq;		/* odd while the thread updates the data */
+    unsigned int reset_req;	/* incremented to ask for a reset */
+    unsigned int reset_done;	/* the last request the thread acted on */
+    unsigned int samples;	/* periods seen since the reset */
+    long min;			/* smallest latency, in nsec */
+    long max;			/* largest latency, in nsec */
+    long long sum;		/* of all latencies, for the average */
+    long long max_time;		/* rtapi_get_time() when max was seen */
+    unsigned int max_seq;	/* incremented whenever max goes up */
+    unsigned int early;		/* periods that started early */
+    unsigned int overflow;	/* periods HAL_LATENCY_BINS us or more late */
+    unsigned int bins[HAL_LATENCY_BINS];	/* bins[n]: n to n+1 us late */
+} hal_latency_hist_t;
+
 struct hal_thread_t {
     SHMFIELD(hal_thread_t) next_ptr;		/* next thread in linked list */
     int uses_fp;		/* floating point flag */
@@ -397,6 +449,20 @@ struct hal_thread_t {
     hal_list_t funct_list;	/* list of functions to run */
     char name[HAL_NAME_LEN + 1];	/* thread name */
     int comp_id;
+    char cpus[HAL_NAME_LEN + 1];	/* CPU list or policy, "" for the default */
+    hal_s32_t* latency;	/* (pin) start of last run minus one period after
+				   the previous start, in nsec */
+    hal_s32_t* latency_max;	/* (pin) largest latency magnitude, set to 0 to reset */
+    int workers;		/* number of helper tasks, 0 if not parallel */
+    int worker_task[HAL_THREAD_WORKERS];	/* task IDs of the helpers */
+    int workers_exit;		/* nonzero tells the helpers to stop */
+    int plan_valid;		/* nonzero if the entries' deps are current */
+    int parallel_busy;		/* nonzero while running a parallel cycle */
+    unsigned int cycle;		/* number of the last parallel cycle */
+    int hist_enabled;		/* nonzero if the thread fills 'hist' */
+    SHMFIELD(hal_latency_hist_t) hist;	/* latency histogram, kept when
+				   the struct is freed and reused */
+    int trace;			/* trace event, see hal_trace.h */
 };
 
 /***********************************************************************
@@ -483,6 +549,23 @@ extern hal_funct_t *halpr_find_funct_by_owner(hal_comp_t * owner,
 */
 extern hal_pin_t *halpr_find_pin_by_sig(hal_sig_t * sig, hal_pin_t * start);
 
+/** These do the work of hal_signal_new(), hal_link() and
+    hal_add_funct_to_thread() on objects the caller has already looked
+    up, so that a program making many connections can take the mutex
+    once and find names its own way.  The caller must have the hal_data
+    mutex and check HAL_LOCK_CONFIG.  'halpr_signal_new()' does not check
+    for an existing signal of the same name; it stores the new signal in
+    '*sigp'.  'halpr_link()' does not update the plans of parallel
+    threads, call 'halpr_thread_plans_update()' once after the links
+    were made.
+*/
+extern int halpr_signal_new(const char *name, hal_type_t type,
+    hal_sig_t **sigp);
+extern int halpr_link(hal_pin_t *pin, hal_sig_t *sig);
+extern int halpr_add_funct_to_thread(hal_funct_t *funct,
+    hal_thread_t *thread, int position);
+extern void halpr_thread_plans_update(void);
+
 
 /** hal_port_alloc allocates a new empty hal_port having a buffer of size bytes. 
     Returns a negative value on failure. On success zero (0) is returned and
@@ -0,0 +1,157 @@
+#ifndef HAL_TRACE_H
+#define HAL_TRACE_H
+/** This file, 'hal_trace.h', declares the HAL trace points.
+
+    A trace point records a timestamped event in a buffer that belongs
+    to the realtime task running it, so what the HAL threads, their
+    functions and anything those call do in a period can be looked at
+    afterwards with 'haltrace', which exports the buffers for the
+    Perfetto / Chrome trace viewer or as CTF.
+
+    Trace points are only compiled in when HAL_TRACING is defined,
+    which './configure --enable-hal-trace' does for the whole tree.
+    Otherwise the macros below expand to nothing, so they can be left
+    in the hottest code.  Even when compiled in, nothing is recorded
+    until 'haltrace start'.
+
+    An event has a name, registered once from init code:
+
+	HAL_TRACE_EVENT(trace_segment);
+	...
+	HAL_TRACE_REGISTER(trace_segment, "tp.segment");
+
+    and is recorded from realtime code as the begin or end of a slice
+    of time, or as an instant, with one integer argument:
+
+	HAL_TRACE_INSTANT(trace_segment, tc->id);
+
+    An event used by more than one file is defined once with
+    HAL_TRACE_GLOBAL(var) and declared with HAL_TRACE_EXTERN(var).
+
+    Events are recorded from HAL threads only; called from anywhere
+    else the macros do nothing.  The HAL itself records the start and
+    end of each period of a thread, and of each function it runs.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to https://linuxcnc.org.
+*/
+
+#include "rtapi.h"
+#include "rtapi_stdint.h"
+#include "rtapi_mutex.h"
+#include "hal.h"
+
+RTAPI_BEGIN_DECLS
+
+/***********************************************************************
+*                    SHARED MEMORY LAYOUT                              *
+************************************************************************/
+
+/* The realtime part of the HAL library creates this block of shared
+   memory when it is built with HAL_TRACING.  Each realtime task of a
+   HAL thread, including the helpers of a parallel thread, gets one of
+   the buffers and is the only writer of it.  A buffer is a ring that
+   keeps the last HAL_TRACE_EVENTS events; readers copy it and then
+   drop the events that were overwritten while they did, see
+   hal_trace_buf_t.head.
+*/
+
+#define HAL_TRACE_KEY 0x48414C54	/* "HALT" */
+#define HAL_TRACE_VERSION 1
+#define HAL_TRACE_BUFS 16		/* realtime tasks that can be traced */
+#define HAL_TRACE_EVENTS 16384		/* per buffer, a power of two */
+#define HAL_TRACE_NAMES 512		/* event names */
+
+#define HAL_TRACE_PH_BEGIN 0		/* a slice of time starts */
+#define HAL_TRACE_PH_END 1		/* the slice ends */
+#define HAL_TRACE_PH_INSTANT 2		/* something happened */
+
+typedef struct {
+    rtapi_s64 time;		/* rtapi_get_time() */
+    rtapi_u16 event;		/* index in hal_trace_t.names */
+    rtapi_u16 phase;		/* HAL_TRACE_PH_xxx */
+    rtapi_s32 arg;		/* depends on the event */
+} hal_trace_event_t;
+
+typedef struct {
+    char name[HAL_NAME_LEN + 8];	/* thread, thread.N for its helpers,
+					   "" if never used */
+    int task_id;		/* realtime task, -1 once it is gone */
+    rtapi_u32 head;		/* events written since the buffer was
+				   taken; event n is in events[n % size]
+				   once head is past n, and stays until
+				   head gets to n + HAL_TRACE_EVENTS - 1 */
+    rtapi_u32 start;		/* 'haltrace clear' ignores older ones */
+    hal_trace_event_t events[HAL_TRACE_EVENTS];
+} hal_trace_buf_t;
+
+typedef struct {
+    int version;		/* HAL_TRACE_VERSION, 0 if not set up */
+    int enabled;		/* nonzero to record events */
+    rtapi_mutex_t mutex;	/* protects names and taking buffers */
+    int nnames;			/* names[0] is "", no event */
+    char names[HAL_TRACE_NAMES][HAL_NAME_LEN + 1];
+    hal_trace_buf_t bufs[HAL_TRACE_BUFS];
+} hal_trace_t;
+
+/***********************************************************************
+*                          FUNCTIONS                                   *
+************************************************************************/
+
+/** hal_trace_register() returns the number of the event called 'name',
+    registering it if needed.  Registering the same name again gives
+    the same number.  It returns 0, which hal_trace() ignores, if the
+    HAL library was built without tracing or there is no room.  Only
+    call it from init code.
+*/
+extern int hal_trace_register(const char *name);
+
+/** hal_trace() records 'event' with 'phase' and 'arg' in the buffer of
+    the calling task, if tracing is on.  It may be called from
+    realtime code.  Use the macros below instead.
+*/
+extern void hal_trace(int event, int phase, long arg);
+
+#ifdef HAL_TRACING
+#define HAL_TRACE_EVENT(var) static int var
+#define HAL_TRACE_GLOBAL(var) int var
+#define HAL_TRACE_EXTERN(var) extern int var
+#define HAL_TRACE_REGISTER(var, name) ((var) = hal_trace_register(name))
+#define HAL_TRACE_BEGIN(var, arg) hal_trace((var), HAL_TRACE_PH_BEGIN, (arg))
+#define HAL_TRACE_END(var, arg) hal_trace((var), HAL_TRACE_PH_END, (arg))
+#define HAL_TRACE_INSTANT(var, arg) hal_trace((var), HAL_TRACE_PH_INSTANT, (arg))
+#else
+#define HAL_TRACE_EVENT(var) extern int hal_trace_unused_
+#define HAL_TRACE_GLOBAL(var) extern int hal_trace_unused_
+#define HAL_TRACE_EXTERN(var) extern int hal_trace_unused_
+#define HAL_TRACE_REGISTER(var, name) ((void)0)
+#define HAL_TRACE_BEGIN(var, arg) ((void)0)
+#define HAL_TRACE_END(var, arg) ((void)0)
+#define HAL_TRACE_INSTANT(var, arg) ((void)0)
+#endif
+
+RTAPI_END_DECLS
+
+#endif /* HAL_TRACE_H */
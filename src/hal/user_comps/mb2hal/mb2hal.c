@@ -127,8 +127,13 @@ QUIT_CLEANUP:
 void *link_loop_and_logic(void *thrd_link_num)
 {
     char *fnct_name = "link_loop_and_logic";
-    int ret, ret_available, ret_connected;
-    int tx_counter;
+    int ret_connected;
+    int tx_counter, n_batch;
+    int batch[MB2HAL_MAX_TCP_PIPELINE];
+    mb_tx_t   *batch_mb_tx[MB2HAL_MAX_TCP_PIPELINE];
+    retCode    batch_ret[MB2HAL_MAX_TCP_PIPELINE];
+    retCode    ret;
+    double     wait_time;
     mb_tx_t   *this_mb_tx = NULL;
     int        this_mb_tx_num;
     mb_link_t *this_mb_link = NULL;
@@ -147,51 +152,63 @@ void *link_loop_and_logic(void *thrd_link_num)
 
     while (1) {
 
-        for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        if (gbl.quit_flag != 0) {
+            return NULL;
+        }
 
-            if (gbl.quit_flag != 0) {
-                return NULL;
+        //corresponding link and time (update_rate), most urgent first
+        this_mb_tx_num = select_next_tx(this_mb_link_num, NULL, 0, 0, &wait_time);
+        if (this_mb_tx_num < 0) {
+            //sleep until the next tx is due, but keep an eye on quit_flag
+            if (wait_time > 0.1) {
+                wait_time = 0.1;
             }
+            usleep(wait_time * 1000 * 1000 + 1);
+            continue;
+        }
+        this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
 
-            this_mb_tx_num = tx_counter;
-            this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
+        DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST connection",
+            this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
 
-            DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST availability",
+        //first time connection or reconnection, run time parameters setting
+        if (get_tx_connection(this_mb_tx_num, &ret_connected) != retOK) {
+            ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] get_tx_connection ERR",
                 this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-
-            //corresponding link and time (update_rate)
-            if (is_this_tx_ready(this_mb_link_num, this_mb_tx_num, &ret_available) != retOK) {
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] is_this_tx_ready ERR",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                return NULL;
-            }
-            if (ret_available == 0) {
-                DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT available",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                usleep(1000);
-                continue;
-            }
-
-            DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST connection",
+            return NULL;
+        }
+        if (ret_connected == 0) {
+            DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT connected",
                 this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+            set_tx_result(this_mb_tx_num, this_mb_link_num, retERR);
+            usleep(1000);
+            continue;
+        }
 
-            //first time connection or reconnection, run time parameters setting
-            if (get_tx_connection(this_mb_tx_num, &ret_connected) != retOK) {
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] get_tx_connection ERR",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                return NULL;
-            }
-            if (ret_connected == 0) {
-                DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT connected",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                usleep(1000);
-                continue;
+        //tcp pipelining, more ready reads go in the same batch
+        batch[0] = this_mb_tx_num;
+        n_batch = 1;
+        if (this_mb_link->lp_link_type == linkTCP && this_mb_link->lp_tcp_pipeline > 1 && is_read_tx(this_mb_tx)) {
+            while (n_batch < this_mb_link->lp_tcp_pipeline) {
+                batch[n_batch] = select_next_tx(this_mb_link_num, batch, n_batch, 1, &wait_time);
+                if (batch[n_batch] < 0) {
+                    break;
+                }
+                n_batch++;
             }
+        }
 
-            DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] lk_dbg[%d] going to EXECUTE transaction",
-                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                this_mb_tx->protocol_debug);
+        DBGMAX(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] lk_dbg[%d] going to EXECUTE transaction, batch[%d]",
+            this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+            this_mb_tx->protocol_debug, n_batch);
 
+        if (n_batch > 1) {
+            for (tx_counter = 0; tx_counter < n_batch; tx_counter++) {
+                batch_mb_tx[tx_counter] = &gbl.mb_tx[batch[tx_counter]];
+            }
+            fnct_read_pipelined(batch_mb_tx, batch_ret, n_batch, this_mb_link);
+        }
+        else {
             switch (this_mb_tx->mb_tx_fnct) {
 
             case mbtx_01_READ_COILS:
@@ -219,59 +236,166 @@ void *link_loop_and_logic(void *thrd_link_num)
                 ret = fnct_16_write_multiple_registers(this_mb_tx, this_mb_link);
                 break;
             default:
-                ret = -1;
+                ret = retERR;
                 ERR(this_mb_tx->cfg_debug, "case error with mb_tx_fnct %d [%s] in mb_tx_num[%d]",
                     this_mb_tx->mb_tx_fnct, this_mb_tx->mb_tx_fnct_name, this_mb_tx_num);
                 break;
             }
+            batch_ret[0] = ret;
+        }
 
-            if (gbl.quit_flag != 0) {
-                return NULL;
-            }
+        if (gbl.quit_flag != 0) {
+            return NULL;
+        }
+
+        for (tx_counter = 0; tx_counter < n_batch; tx_counter++) {
+            set_tx_result(batch[tx_counter], this_mb_link_num, batch_ret[tx_counter]);
+        }
+
+        //wait time for serial lines
+        if (this_mb_tx->cfg_link_type == linkRTU) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] SERIAL_DELAY_MS activated [%d]",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+                this_mb_tx->cfg_serial_delay_ms);
+            usleep(this_mb_tx->cfg_serial_delay_ms * 1000);
+        }
+
+        //wait time to gbl.slowdown activity (debugging)
+        if (gbl.slowdown > 0) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] gbl.slowdown activated [%0.3f]",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), gbl.slowdown);
+            usleep(gbl.slowdown * 1000 * 1000);
+        }
+
+    } //end while
+
+    return NULL;
+}
+
+/*
+ * Pick the next tx to run on this link, skipping the ones in skip_tx[].
+ * Among the ready tx with a MAX_UPDATE_RATE the one with the earliest
+ * deadline (next_time + time_increment) goes first, so the faster ones
+ * keep their rate when the link is busy. The tx without a rate only
+ * run when no other is ready, the one waiting for longest first.
+ * Returns -1 if none is ready, then *ret_wait is the time (s) until
+ * the next one is.
+ */
+
+int select_next_tx(const int this_mb_link_num, const int *skip_tx, const int n_skip_tx, const int only_reads, double *ret_wait)
+{
+    char *fnct_name = "select_next_tx";
+    int tx_counter, skip_counter, ret_available;
+    int best_tx = -1, best_rated = 0;
+    double best_deadline = 0, deadline, now;
+    mb_tx_t *this_mb_tx;
 
-            if (ret != retOK && modbus_get_socket(this_mb_link->modbus) < 0) { //link failure
-                (**this_mb_tx->num_errors)++;
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] link failure, going to close link",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                modbus_close(this_mb_link->modbus);
+    now = get_time();
+    *ret_wait = 1.0;
+
+    for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        this_mb_tx = &gbl.mb_tx[tx_counter];
+
+        for (skip_counter = 0; skip_counter < n_skip_tx; skip_counter++) {
+            if (skip_tx[skip_counter] == tx_counter) {
+                break;
             }
-            else if (ret != retOK) {  //transaction failure but link OK
-                (**this_mb_tx->num_errors)++;
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction failure, num_errors[%u]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), **this_mb_tx->num_errors);
-                // Clear any unread data. Otherwise the link might get out of sync
-                modbus_flush(this_mb_link->modbus);
+        }
+        if (skip_counter < n_skip_tx || (only_reads && !is_read_tx(this_mb_tx))) {
+            continue;
+        }
+
+        if (is_this_tx_ready(this_mb_link_num, tx_counter, &ret_available) != retOK) {
+            ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] is_this_tx_ready ERR",
+                tx_counter, this_mb_tx->mb_link_num);
+            continue;
+        }
+        if (ret_available == 0) {
+            //own link and group leader, but not now
+            if (this_mb_tx->mb_link_num == this_mb_link_num && this_mb_tx->mb_tx_group == tx_counter &&
+                this_mb_tx->next_time - now < *ret_wait) {
+                *ret_wait = this_mb_tx->next_time - now;
             }
-            else { //transaction and link OK
-                OK(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction OK, update_HZ[%0.03f]",
-                   this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                   1.0/(get_time()-this_mb_tx->last_time_ok));
-                this_mb_tx->last_time_ok = get_time();
-                (**this_mb_tx->num_errors) = 0;
+            continue;
+        }
+
+        deadline = this_mb_tx->next_time + this_mb_tx->time_increment;
+        if (this_mb_tx->time_increment > 0) { //rated tx
+            if (!best_rated || deadline < best_deadline) {
+                best_tx = tx_counter;
+                best_rated = 1;
+                best_deadline = deadline;
             }
+        }
+        else if (!best_rated && (best_tx < 0 || deadline < best_deadline)) {
+            best_tx = tx_counter;
+            best_deadline = deadline;
+        }
+    }
 
-            //set the next (waiting) time for update rate
-            this_mb_tx->next_time = get_time() + this_mb_tx->time_increment;
+    if (*ret_wait < 0) {
+        *ret_wait = 0;
+    }
+    return best_tx;
+}
 
-            //wait time for serial lines
-            if (this_mb_tx->cfg_link_type == linkRTU) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] SERIAL_DELAY_MS activated [%d]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                    this_mb_tx->cfg_serial_delay_ms);
-                usleep(this_mb_tx->cfg_serial_delay_ms * 1000);
-            }
+/*
+ * Account the result of a tx (and of the tx merged into it),
+ * and set its next time
+ */
 
-            //wait time to gbl.slowdown activity (debugging)
-            if (gbl.slowdown > 0) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] gbl.slowdown activated [%0.3f]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), gbl.slowdown);
-                usleep(gbl.slowdown * 1000 * 1000);
-            }
-        }  //end for
+void set_tx_result(const int this_mb_tx_num, const int this_mb_link_num, const retCode ret)
+{
+    char *fnct_name = "set_tx_result";
+    int tx_counter;
+    double now;
+    mb_tx_t   *this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
+    mb_tx_t   *grp_mb_tx;
+    mb_link_t *this_mb_link = &gbl.mb_links[this_mb_link_num];
+
+    now = get_time();
+
+    //the whole group shares the result
+    for (tx_counter = this_mb_tx_num; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        grp_mb_tx = &gbl.mb_tx[tx_counter];
+        if (grp_mb_tx->mb_tx_group != this_mb_tx_num) {
+            continue;
+        }
+        if (ret != retOK) {
+            (**grp_mb_tx->num_errors)++;
+        }
+        else {
+            (**grp_mb_tx->num_errors) = 0;
+        }
+    }
 
-    } //end while
+    if (ret != retOK && modbus_get_socket(this_mb_link->modbus) < 0) { //link failure
+        ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] link failure, going to close link",
+            this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+        modbus_close(this_mb_link->modbus);
+    }
+    else if (ret != retOK) {  //transaction failure but link OK
+        ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction failure, num_errors[%u]",
+            this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), **this_mb_tx->num_errors);
+        // Clear any unread data. Otherwise the link might get out of sync
+        modbus_flush(this_mb_link->modbus);
+    }
+    else { //transaction and link OK
+        OK(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction OK, update_HZ[%0.03f]",
+           this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+           1.0/(now-this_mb_tx->last_time_ok));
+        this_mb_tx->last_time_ok = now;
+    }
 
-    return NULL;
+    //set the next (waiting) time for update rate, keeping the pace
+    //unless it is late by more than one period or it failed
+    this_mb_tx->next_time += this_mb_tx->time_increment;
+    if (ret != retOK) {
+        this_mb_tx->next_time = now + this_mb_tx->time_increment;
+    }
+    else if (this_mb_tx->next_time < now) {
+        this_mb_tx->next_time = now;
+    }
 }
 
 /*
@@ -308,6 +432,11 @@ retCode is_this_tx_ready(const int this_mb_link_num, const int this_mb_tx_num, i
         return retOK;
     }
 
+    //the tx is read by the leader of its group
+    if (this_mb_tx->mb_tx_group != this_mb_tx_num) {
+        return retOK;
+    }
+
     //not now
     if (get_time() < this_mb_tx->next_time) {
         return retOK;
@@ -354,7 +483,6 @@ retCode get_tx_connection(const int this_mb_tx_num, int *ret_connected)
         ret = modbus_connect(this_mb_link->modbus);
         if (ret != 0 || modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_set_socket(this_mb_link->modbus, -1); //some times ret was < 0 and fd > 0
-            (**this_mb_tx->num_errors)++;
             ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] cannot connect to link, ret[%d] fd[%d]",
                 this_mb_tx_num, this_mb_tx->mb_link_num, ret, modbus_get_socket(this_mb_link->modbus));
             return retOK; //not connected
@@ -412,6 +540,7 @@ void set_init_gbl_params()
     gbl.init_dbg     = debugERR; //until read in config file
     gbl.version      = 1000;     //defaults to 1000 (= 1.000) if not set
     gbl.slowdown     = 0;        //until read in config file
+    gbl.merge_reads  = 0;        //reads are merged only when asked for
     gbl.mb_tx_fncts[mbtxERR]                         = "";
     gbl.mb_tx_fncts[mbtx_01_READ_COILS]              = "fnct_01_read_coils";
     gbl.mb_tx_fncts[mbtx_02_READ_DISCRETE_INPUTS]    = "fnct_02_read_discrete_inputs";
@@ -30,6 +30,9 @@
 #define MB2HAL_MAX_FNCT06_ELEMENTS 1
 #define MB2HAL_MAX_FNCT15_ELEMENTS 100
 #define MB2HAL_MAX_FNCT16_ELEMENTS 100
+#define MB2HAL_DEFAULT_TCP_PIPELINE 1
+#define MB2HAL_MAX_TCP_PIPELINE    16
+#define MB2HAL_MAX_TCP_ADU         260
 
 #ifdef MODULE_VERBOSE
 MODULE_VERBOSE(emc2, "component:mb2hal:Userspace HAL component to communicate with one or more Modbus devices");
@@ -78,6 +81,7 @@ typedef struct {
     int  cfg_serial_delay_ms;  //delay between tx in serial lines
     char cfg_tcp_ip[17];       //tcp address
     int  cfg_tcp_port;         //tcp port number
+    int  cfg_tcp_pipeline;     //max tcp requests in flight
     //mb_* are Modbus transaction protocol related params
     int        mb_tx_slave_id; //MB device id
     mb_tx_fnct mb_tx_fnct;     //MB function code id
@@ -95,6 +99,10 @@ typedef struct {
     //internal processing values
     int mb_tx_num;         //each tx know it's own number
     int mb_link_num;       //each tx know it's own link
+    //coalesced reads: the group leader reads the registers of all the group
+    int mb_tx_group;        //tx number of the group leader (itself if not merged)
+    int mb_tx_grp_1st_addr; //MB first register of the whole group
+    int mb_tx_grp_nelem;    //MB n registers of the whole group
     //internal processing values
     double time_increment; //wait time between tx
     double next_time;      //next time for this tx
@@ -126,8 +134,10 @@ typedef struct {
     int  lp_serial_delay_ms;  //delay between tx in serial lines
     char lp_tcp_ip[17];       //tcp address
     int  lp_tcp_port;         //tcp port number
+    int  lp_tcp_pipeline;     //max tcp requests in flight
     //run time processing values
     int mb_link_num;       //corresponding number of this link/thread
+    uint16_t tcp_tid;      //next Modbus/TCP transaction identifier (pipelining)
     modbus_t *modbus;
     pthread_t thrd;
 } mb_link_t;
@@ -142,6 +152,7 @@ typedef struct {
     int   init_dbg;
     int   version;
     double slowdown;
+    int   merge_reads;
     //HAL related
     int   hal_mod_id;
     char *hal_mod_name;
@@ -161,6 +172,8 @@ extern gbl_t gbl;
 //mb2hal.c
 void *link_loop_and_logic(void *thrd_link_num);
 retCode is_this_tx_ready(const int this_mb_link_num, const int this_mb_tx_num, int *ret_available);
+int select_next_tx(const int this_mb_link_num, const int *skip_tx, const int n_skip_tx, const int only_reads, double *ret_wait);
+void set_tx_result(const int this_mb_tx_num, const int this_mb_link_num, const retCode ret);
 retCode get_tx_connection(const int mb_tx_num, int *ret_connected);
 void set_init_gbl_params();
 double get_time();
@@ -178,6 +191,7 @@ retCode check_int_in(int n_args, const int int_value, ...);
 retCode check_str_in(int n_args, const char *str_value, ...);
 retCode init_mb_links();
 retCode init_mb_tx();
+retCode init_mb_tx_groups();
 
 //mb2hal_hal.c
 retCode create_HAL_pins();
@@ -192,3 +206,8 @@ retCode fnct_05_write_single_coil(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
 retCode fnct_06_write_single_register(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
 retCode fnct_15_write_multiple_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
 retCode fnct_16_write_multiple_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
+retCode fnct_read_pipelined(mb_tx_t **mb_txs, retCode *rets, const int n_txs, mb_link_t *this_mb_link);
+int is_read_tx(const mb_tx_t *this_mb_tx);
+int max_tx_elements(const mb_tx_fnct fnct);
+void set_read_bits(const mb_tx_t *this_mb_tx, const uint8_t *bits);
+void set_read_registers(const mb_tx_t *this_mb_tx, const uint16_t *data);
@@ -111,6 +111,10 @@ retCode parse_common_section()
     iniFindDouble(gbl.ini_file_ptr, tag, section, &gbl.slowdown);
     DBG(gbl.init_dbg, "[%s] [%s] [%0.3f]", section, tag, gbl.slowdown);
 
+    tag     = "MERGE_READS"; //optional
+    iniFindInt(gbl.ini_file_ptr, tag, section, &gbl.merge_reads);
+    DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, gbl.merge_reads);
+
     tag     = "TOTAL_TRANSACTIONS"; //required
     if (iniFindInt(gbl.ini_file_ptr, tag, section, &gbl.tot_mb_tx) != 0) {
         ERR(gbl.init_dbg, "required [%s] [%s] not found", section, tag);
@@ -435,6 +439,21 @@ retCode parse_tcp_subsection(const char *section, const int mb_tx_num)
     }
     DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, this_mb_tx->cfg_tcp_port);
 
+    tag = "TCP_PIPELINE_DEPTH"; //optional
+    this_mb_tx->cfg_tcp_pipeline = MB2HAL_DEFAULT_TCP_PIPELINE; //default
+    if (iniFindInt(gbl.ini_file_ptr, tag, section, &this_mb_tx->cfg_tcp_pipeline) != 0) { //not found
+        if (mb_tx_num > 0) { //previous value?
+            if (strcasecmp(this_mb_tx->cfg_link_type_str, gbl.mb_tx[mb_tx_num-1].cfg_link_type_str) == 0) {
+                this_mb_tx->cfg_tcp_pipeline = gbl.mb_tx[mb_tx_num-1].cfg_tcp_pipeline;
+            }
+        }
+    }
+    if (this_mb_tx->cfg_tcp_pipeline < 1 || this_mb_tx->cfg_tcp_pipeline > MB2HAL_MAX_TCP_PIPELINE) {
+        ERR(gbl.init_dbg, "[%s] [%s] [%d] out of range", section, tag, this_mb_tx->cfg_tcp_pipeline);
+        return retERR;
+    }
+    DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, this_mb_tx->cfg_tcp_pipeline);
+
     return retOK;
 }
 
@@ -712,6 +731,7 @@ retCode init_mb_links()
                 }
                 rtapi_strlcpy(this_mb_link->lp_tcp_ip, this_mb_tx->cfg_tcp_ip, sizeof(this_mb_tx->cfg_tcp_ip));
                 this_mb_link->lp_tcp_port=this_mb_tx->cfg_tcp_port;
+                this_mb_link->lp_tcp_pipeline=this_mb_tx->cfg_tcp_pipeline;
 
                 this_mb_link->modbus = modbus_new_tcp(this_mb_link->lp_tcp_ip, this_mb_link->lp_tcp_port);
                 if (this_mb_link->modbus == NULL) {
@@ -739,9 +759,9 @@ retCode init_mb_links()
                 this_mb_link->lp_serial_stop_bit, modbus_get_socket(this_mb_link->modbus));
         }
         else { //tcp
-            DBG(gbl.init_dbg, "LINK %d (TCP) link_type[%d] IP[%s] port[%d] fd[%d]",
+            DBG(gbl.init_dbg, "LINK %d (TCP) link_type[%d] IP[%s] port[%d] pipeline[%d] fd[%d]",
                 lk_counter, this_mb_link->lp_link_type, this_mb_link->lp_tcp_ip,
-                this_mb_link->lp_tcp_port, modbus_get_socket(this_mb_link->modbus));
+                this_mb_link->lp_tcp_port, this_mb_link->lp_tcp_pipeline, modbus_get_socket(this_mb_link->modbus));
         }
     }
 
@@ -774,10 +794,86 @@ retCode init_mb_tx()
         }
         this_mb_tx->next_time = 0; //next time for this tx
 
+        //each tx reads its own registers until merged
+        this_mb_tx->mb_tx_group = tx_counter;
+        this_mb_tx->mb_tx_grp_1st_addr = this_mb_tx->mb_tx_1st_addr;
+        this_mb_tx->mb_tx_grp_nelem = this_mb_tx->mb_tx_nelem;
+
         DBG(gbl.init_dbg, "MB_TX %d lk_n[%d] tx_n[%d] cfg_dbg[%d] lk_dbg[%d] t_inc[%0.3f] nxt_t[%0.3f]",
             tx_counter, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_num, this_mb_tx->cfg_debug,
             this_mb_tx->protocol_debug, this_mb_tx->time_increment, this_mb_tx->next_time);
     }
 
+    if (gbl.merge_reads != 0) {
+        return init_mb_tx_groups();
+    }
+
+    return retOK;
+}
+
+/*
+ * Merge read transactions of the same link, slave and function code,
+ * and with adjacent or overlapping addresses, into one request.
+ * The lowest tx number of each group (the leader) reads the registers
+ * of the whole group, the others are never executed on their own.
+ * Only tx with the same update rate and timeouts are merged, and the
+ * group never goes beyond the element limit of the function code.
+ */
+retCode init_mb_tx_groups()
+{
+    char *fnct_name="init_mb_tx_groups";
+    int tx_counter, grp_counter, counter, merged;
+    int first, last;
+    mb_tx_t *this_mb_tx, *grp_mb_tx;
+
+    do {
+        merged = 0;
+        for (grp_counter = 0; grp_counter < gbl.tot_mb_tx; grp_counter++) {
+            grp_mb_tx = &gbl.mb_tx[grp_counter];
+            if (grp_mb_tx->mb_tx_group != grp_counter || !is_read_tx(grp_mb_tx)) {
+                continue;
+            }
+            for (tx_counter = grp_counter + 1; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+                this_mb_tx = &gbl.mb_tx[tx_counter];
+                if (this_mb_tx->mb_tx_group != tx_counter ||
+                    this_mb_tx->mb_link_num != grp_mb_tx->mb_link_num ||
+                    this_mb_tx->mb_tx_slave_id != grp_mb_tx->mb_tx_slave_id ||
+                    this_mb_tx->mb_tx_fnct != grp_mb_tx->mb_tx_fnct ||
+                    this_mb_tx->time_increment != grp_mb_tx->time_increment ||
+                    this_mb_tx->mb_response_timeout_ms != grp_mb_tx->mb_response_timeout_ms ||
+                    this_mb_tx->mb_byte_timeout_ms != grp_mb_tx->mb_byte_timeout_ms) {
+                    continue;
+                }
+                //nothing in between, the slave may not have it
+                if (this_mb_tx->mb_tx_grp_1st_addr > grp_mb_tx->mb_tx_grp_1st_addr + grp_mb_tx->mb_tx_grp_nelem ||
+                    grp_mb_tx->mb_tx_grp_1st_addr > this_mb_tx->mb_tx_grp_1st_addr + this_mb_tx->mb_tx_grp_nelem) {
+                    continue;
+                }
+                first = grp_mb_tx->mb_tx_grp_1st_addr;
+                if (this_mb_tx->mb_tx_grp_1st_addr < first) {
+                    first = this_mb_tx->mb_tx_grp_1st_addr;
+                }
+                last = grp_mb_tx->mb_tx_grp_1st_addr + grp_mb_tx->mb_tx_grp_nelem;
+                if (this_mb_tx->mb_tx_grp_1st_addr + this_mb_tx->mb_tx_grp_nelem > last) {
+                    last = this_mb_tx->mb_tx_grp_1st_addr + this_mb_tx->mb_tx_grp_nelem;
+                }
+                if (last - first > max_tx_elements(grp_mb_tx->mb_tx_fnct)) {
+                    continue;
+                }
+
+                for (counter = tx_counter; counter < gbl.tot_mb_tx; counter++) { //with its own group
+                    if (gbl.mb_tx[counter].mb_tx_group == tx_counter) {
+                        gbl.mb_tx[counter].mb_tx_group = grp_counter;
+                    }
+                }
+                grp_mb_tx->mb_tx_grp_1st_addr = first;
+                grp_mb_tx->mb_tx_grp_nelem = last - first;
+                merged = 1;
+                DBG(gbl.init_dbg, "MB_TX %d merged into MB_TX %d 1st_addr[%d] nelem[%d]",
+                    tx_counter, grp_counter, grp_mb_tx->mb_tx_grp_1st_addr, grp_mb_tx->mb_tx_grp_nelem);
+            }
+        }
+    } while (merged != 0); //a bigger group may reach more tx
+
     return retOK;
 }
@@ -1,24 +1,27 @@
 #include <sys/time.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <errno.h>
 #include "mb2hal.h"
 
 retCode fnct_01_read_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 {
     char *fnct_name = "fnct_01_read_coils";
-    int counter, ret;
+    int ret;
     uint8_t bits[MB2HAL_MAX_FNCT01_ELEMENTS];
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
     }
-    if (this_mb_tx->mb_tx_nelem > MB2HAL_MAX_FNCT01_ELEMENTS) {
+    if (this_mb_tx->mb_tx_grp_nelem > MB2HAL_MAX_FNCT01_ELEMENTS) {
         return retERR;
     }
 
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id, modbus_get_socket(this_mb_link->modbus),
-        this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
+        this_mb_tx->mb_tx_grp_1st_addr, this_mb_tx->mb_tx_grp_nelem);
 
-    ret = modbus_read_bits(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, bits);
+    ret = modbus_read_bits(this_mb_link->modbus, this_mb_tx->mb_tx_grp_1st_addr, this_mb_tx->mb_tx_grp_nelem, bits);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -29,10 +32,7 @@ retCode fnct_01_read_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
         return retERR;
     }
 
-    for (counter = 0; counter < this_mb_tx->mb_tx_nelem; counter++) {
-        *(this_mb_tx->bit[counter]) = bits[counter];
-        *(this_mb_tx->bit_inv[counter]) = !bits[counter];
-    }
+    set_read_bits(this_mb_tx, bits);
 
     return retOK;
 }
@@ -40,21 +40,21 @@ retCode fnct_01_read_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 retCode fnct_02_read_discrete_inputs(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 {
     char *fnct_name = "fnct_02_read_discrete_inputs";
-    int counter, ret;
+    int ret;
     uint8_t bits[MB2HAL_MAX_FNCT02_ELEMENTS];
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
     }
-    if (this_mb_tx->mb_tx_nelem > MB2HAL_MAX_FNCT02_ELEMENTS) {
+    if (this_mb_tx->mb_tx_grp_nelem > MB2HAL_MAX_FNCT02_ELEMENTS) {
         return retERR;
     }
 
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id, modbus_get_socket(this_mb_link->modbus),
-        this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
+        this_mb_tx->mb_tx_grp_1st_addr, this_mb_tx->mb_tx_grp_nelem);
 
-    ret = modbus_read_input_bits(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, bits);
+    ret = modbus_read_input_bits(this_mb_link->modbus, this_mb_tx->mb_tx_grp_1st_addr, this_mb_tx->mb_tx_grp_nelem, bits);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -65,11 +65,7 @@ retCode fnct_02_read_discrete_inputs(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
         return retERR;
     }
 
-    for (counter = 0; counter < this_mb_tx->mb_tx_nelem; counter++) {
-        *(this_mb_tx->bit[counter]) = bits[counter];
-        if (gbl.version > 1000)
-            *(this_mb_tx->bit_inv[counter]) = !bits[counter];
-    }
+    set_read_bits(this_mb_tx, bits);
 
     return retOK;
 }
@@ -77,21 +73,21 @@ retCode fnct_02_read_discrete_inputs(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
 retCode fnct_03_read_holding_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 {
     char *fnct_name = "fnct_03_read_holding_registers";
-    int counter, ret;
+    int ret;
     uint16_t data[MB2HAL_MAX_FNCT03_ELEMENTS];
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
     }
-    if (this_mb_tx->mb_tx_nelem > MB2HAL_MAX_FNCT03_ELEMENTS) {
+    if (this_mb_tx->mb_tx_grp_nelem > MB2HAL_MAX_FNCT03_ELEMENTS) {
         return retERR;
     }
 
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
-        modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
+        modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_grp_1st_addr, this_mb_tx->mb_tx_grp_nelem);
 
-    ret = modbus_read_registers(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, data);
+    ret = modbus_read_registers(this_mb_link->modbus, this_mb_tx->mb_tx_grp_1st_addr, this_mb_tx->mb_tx_grp_nelem, data);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -102,13 +98,7 @@ retCode fnct_03_read_holding_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_l
         return retERR;
     }
 
-    for (counter = 0; counter < this_mb_tx->mb_tx_nelem; counter++) {
-        float val = data[counter];
-        //val *= this_mb_tx->scale[counter];
-        //val += this_mb_tx->offset[counter];
-        *(this_mb_tx->float_value[counter]) = val;
-        *(this_mb_tx->int_value[counter]) = data[counter];
-    }
+    set_read_registers(this_mb_tx, data);
 
     return retOK;
 }
@@ -116,21 +106,21 @@ retCode fnct_03_read_holding_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_l
 retCode fnct_04_read_input_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 {
     char *fnct_name = "fnct_04_read_input_registers";
-    int counter, ret;
+    int ret;
     uint16_t data[MB2HAL_MAX_FNCT04_ELEMENTS];
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
     }
-    if (this_mb_tx->mb_tx_nelem > MB2HAL_MAX_FNCT04_ELEMENTS) {
+    if (this_mb_tx->mb_tx_grp_nelem > MB2HAL_MAX_FNCT04_ELEMENTS) {
         return retERR;
     }
 
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
-        modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
+        modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_grp_1st_addr, this_mb_tx->mb_tx_grp_nelem);
 
-    ret = modbus_read_input_registers(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, data);
+    ret = modbus_read_input_registers(this_mb_link->modbus, this_mb_tx->mb_tx_grp_1st_addr, this_mb_tx->mb_tx_grp_nelem, data);
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -141,13 +131,7 @@ retCode fnct_04_read_input_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
         return retERR;
     }
 
-    for (counter = 0; counter < this_mb_tx->mb_tx_nelem; counter++) {
-        float val = data[counter];
-        //val += this_mb_tx->offset[counter];
-        //val *= this_mb_tx->scale[counter];
-        *(this_mb_tx->float_value[counter]) = val;
-        *(this_mb_tx->int_value[counter]) = data[counter];
-    }
+    set_read_registers(this_mb_tx, data);
 
     return retOK;
 }
@@ -300,3 +284,326 @@ retCode fnct_16_write_multiple_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb
 
     return retOK;
 }
+
+int is_read_tx(const mb_tx_t *this_mb_tx)
+{
+    switch (this_mb_tx->mb_tx_fnct) {
+    case mbtx_01_READ_COILS:
+    case mbtx_02_READ_DISCRETE_INPUTS:
+    case mbtx_03_READ_HOLDING_REGISTERS:
+    case mbtx_04_READ_INPUT_REGISTERS:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+int max_tx_elements(const mb_tx_fnct fnct)
+{
+    switch (fnct) {
+    case mbtx_01_READ_COILS:
+        return MB2HAL_MAX_FNCT01_ELEMENTS;
+    case mbtx_02_READ_DISCRETE_INPUTS:
+        return MB2HAL_MAX_FNCT02_ELEMENTS;
+    case mbtx_03_READ_HOLDING_REGISTERS:
+        return MB2HAL_MAX_FNCT03_ELEMENTS;
+    case mbtx_04_READ_INPUT_REGISTERS:
+        return MB2HAL_MAX_FNCT04_ELEMENTS;
+    case mbtx_05_WRITE_SINGLE_COIL:
+        return MB2HAL_MAX_FNCT05_ELEMENTS;
+    case mbtx_06_WRITE_SINGLE_REGISTER:
+        return MB2HAL_MAX_FNCT06_ELEMENTS;
+    case mbtx_15_WRITE_MULTIPLE_COILS:
+        return MB2HAL_MAX_FNCT15_ELEMENTS;
+    case mbtx_16_WRITE_MULTIPLE_REGISTERS:
+        return MB2HAL_MAX_FNCT16_ELEMENTS;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Copy the bits read by a group leader (from mb_tx_grp_1st_addr on)
+ * to the HAL pins of every tx of its group
+ */
+void set_read_bits(const mb_tx_t *this_mb_tx, const uint8_t *bits)
+{
+    int tx_counter, counter, offset;
+    mb_tx_t *grp_mb_tx;
+
+    for (tx_counter = this_mb_tx->mb_tx_num; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        grp_mb_tx = &gbl.mb_tx[tx_counter];
+        if (grp_mb_tx->mb_tx_group != this_mb_tx->mb_tx_num) {
+            continue;
+        }
+        offset = grp_mb_tx->mb_tx_1st_addr - this_mb_tx->mb_tx_grp_1st_addr;
+        for (counter = 0; counter < grp_mb_tx->mb_tx_nelem; counter++) {
+            *(grp_mb_tx->bit[counter]) = bits[offset + counter];
+            if (grp_mb_tx->mb_tx_fnct == mbtx_01_READ_COILS || gbl.version > 1000)
+                *(grp_mb_tx->bit_inv[counter]) = !bits[offset + counter];
+        }
+    }
+}
+
+/*
+ * Same for registers
+ */
+void set_read_registers(const mb_tx_t *this_mb_tx, const uint16_t *data)
+{
+    int tx_counter, counter, offset;
+    mb_tx_t *grp_mb_tx;
+
+    for (tx_counter = this_mb_tx->mb_tx_num; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        grp_mb_tx = &gbl.mb_tx[tx_counter];
+        if (grp_mb_tx->mb_tx_group != this_mb_tx->mb_tx_num) {
+            continue;
+        }
+        offset = grp_mb_tx->mb_tx_1st_addr - this_mb_tx->mb_tx_grp_1st_addr;
+        for (counter = 0; counter < grp_mb_tx->mb_tx_nelem; counter++) {
+            float val = data[offset + counter];
+            //val *= grp_mb_tx->scale[counter];
+            //val += grp_mb_tx->offset[counter];
+            *(grp_mb_tx->float_value[counter]) = val;
+            *(grp_mb_tx->int_value[counter]) = data[offset + counter];
+        }
+    }
+}
+
+/*
+ * Read len bytes from the socket, waiting at most timeout_ms for each of them.
+ * Returns len, 0 if nothing came in time, or -1 if the link failed or
+ * the frame was cut (the stream is out of sync then).
+ */
+static int recv_bytes(int fd, uint8_t *buf, int len, int timeout_ms)
+{
+    struct timeval timeout;
+    fd_set rfds;
+    int done = 0, ret;
+
+    while (done < len) {
+        FD_ZERO(&rfds);
+        FD_SET(fd, &rfds);
+        timeout.tv_sec  = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+        ret = select(fd + 1, &rfds, NULL, NULL, &timeout);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret == 0) {
+            return done == 0 ? 0 : -1;
+        }
+        if (ret < 0) {
+            return -1;
+        }
+        ret = recv(fd, buf + done, len - done, 0);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return -1;
+        }
+        done += ret;
+    }
+
+    return len;
+}
+
+static void print_frame(const char *prefix, const uint8_t *buf, int len)
+{
+    int counter;
+
+    fprintf(stdout, "%s", prefix);
+    for (counter = 0; counter < len; counter++) {
+        fprintf(stdout, "[%.2X]", buf[counter]);
+    }
+    fprintf(stdout, "\n");
+}
+
+/*
+ * Modbus/TCP pipelining: send the read requests of several tx of the
+ * same link at once, each with its own transaction identifier, then
+ * collect the responses. libmodbus only keeps one request in flight,
+ * so the frames are built and parsed here on the socket of the link.
+ * rets[] gets the result of each tx, the return value is retOK only
+ * if all of them are OK.
+ */
+retCode fnct_read_pipelined(mb_tx_t **mb_txs, retCode *rets, const int n_txs, mb_link_t *this_mb_link)
+{
+    char *fnct_name = "fnct_read_pipelined";
+    uint8_t req[MB2HAL_MAX_TCP_PIPELINE * 12];
+    uint8_t rsp[MB2HAL_MAX_TCP_ADU];
+    uint8_t bits[MB2HAL_MAX_TCP_ADU * 8];
+    uint16_t data[MB2HAL_MAX_TCP_ADU / 2];
+    uint16_t tid[MB2HAL_MAX_TCP_PIPELINE];
+    int fnct_code[MB2HAL_MAX_TCP_PIPELINE];
+    int pending[MB2HAL_MAX_TCP_PIPELINE];
+    int counter, elem, fd, ret, len, sent, n_pending, nbytes, rsp_tid;
+    int response_timeout_ms = 0, byte_timeout_ms = 0, protocol_debug = 0;
+    retCode ret_all = retOK;
+    mb_tx_t *this_mb_tx;
+    uint8_t *p;
+
+    if (mb_txs == NULL || rets == NULL || this_mb_link == NULL || n_txs < 1 || n_txs > MB2HAL_MAX_TCP_PIPELINE) {
+        return retERR;
+    }
+
+    fd = modbus_get_socket(this_mb_link->modbus);
+    for (counter = 0; counter < n_txs; counter++) {
+        this_mb_tx = mb_txs[counter];
+        rets[counter] = retERR;
+        pending[counter] = 0;
+        if (!is_read_tx(this_mb_tx) || this_mb_tx->mb_tx_grp_nelem > max_tx_elements(this_mb_tx->mb_tx_fnct)) {
+            return retERR;
+        }
+        switch (this_mb_tx->mb_tx_fnct) {
+        case mbtx_01_READ_COILS:
+            fnct_code[counter] = 0x01;
+            break;
+        case mbtx_02_READ_DISCRETE_INPUTS:
+            fnct_code[counter] = 0x02;
+            break;
+        case mbtx_03_READ_HOLDING_REGISTERS:
+            fnct_code[counter] = 0x03;
+            break;
+        default:
+            fnct_code[counter] = 0x04;
+            break;
+        }
+        if (this_mb_tx->mb_response_timeout_ms > response_timeout_ms) {
+            response_timeout_ms = this_mb_tx->mb_response_timeout_ms;
+        }
+        if (this_mb_tx->mb_byte_timeout_ms > byte_timeout_ms) {
+            byte_timeout_ms = this_mb_tx->mb_byte_timeout_ms;
+        }
+        protocol_debug |= this_mb_tx->protocol_debug;
+
+        //MBAP header: transaction id, protocol id (0), length, unit id; then the PDU
+        tid[counter] = this_mb_link->tcp_tid++;
+        p = req + counter * 12;
+        p[0] = tid[counter] >> 8;
+        p[1] = tid[counter] & 0xff;
+        p[2] = 0;
+        p[3] = 0;
+        p[4] = 0;
+        p[5] = 6;
+        p[6] = this_mb_tx->mb_tx_slave_id;
+        p[7] = fnct_code[counter];
+        p[8] = this_mb_tx->mb_tx_grp_1st_addr >> 8;
+        p[9] = this_mb_tx->mb_tx_grp_1st_addr & 0xff;
+        p[10] = this_mb_tx->mb_tx_grp_nelem >> 8;
+        p[11] = this_mb_tx->mb_tx_grp_nelem & 0xff;
+
+        DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d] tid[%d]",
+            this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id, fd,
+            this_mb_tx->mb_tx_grp_1st_addr, this_mb_tx->mb_tx_grp_nelem, tid[counter]);
+    }
+
+    if (fd < 0) {
+        return retERR;
+    }
+
+    len = n_txs * 12;
+    if (protocol_debug) {
+        print_frame("", req, len);
+    }
+    for (sent = 0; sent < len; sent += ret) {
+        ret = send(fd, req + sent, len - sent, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR) {
+            ret = 0;
+            continue;
+        }
+        if (ret <= 0) {
+            ERR(mb_txs[0]->cfg_debug, "mb_links[%d] fd[%d] send failed [%s]",
+                this_mb_link->mb_link_num, fd, strerror(errno));
+            modbus_close(this_mb_link->modbus);
+            modbus_set_socket(this_mb_link->modbus, -1);
+            return retERR;
+        }
+    }
+    for (counter = 0; counter < n_txs; counter++) {
+        pending[counter] = 1;
+    }
+    n_pending = n_txs;
+
+    //responses come in any order, match them by transaction id
+    while (n_pending > 0) {
+        ret = recv_bytes(fd, rsp, 7, response_timeout_ms);
+        if (ret == 7) {
+            len = (rsp[4] << 8) | rsp[5];
+            if (len < 2 || len > MB2HAL_MAX_TCP_ADU - 6 || rsp[2] != 0 || rsp[3] != 0) {
+                ret = -1;
+            }
+            else {
+                ret = recv_bytes(fd, rsp + 7, len - 1, byte_timeout_ms) == len - 1 ? 7 : -1;
+            }
+        }
+        if (ret == 0) { //late responses would be taken by the next libmodbus request
+            ERR(mb_txs[0]->cfg_debug, "mb_links[%d] fd[%d] timeout, %d of %d responses missing, going to close link",
+                this_mb_link->mb_link_num, fd, n_pending, n_txs);
+            modbus_close(this_mb_link->modbus);
+            modbus_set_socket(this_mb_link->modbus, -1);
+            return retERR;
+        }
+        if (ret < 0) { //link failure or out of sync
+            ERR(mb_txs[0]->cfg_debug, "mb_links[%d] fd[%d] bad or missing response, going to close link",
+                this_mb_link->mb_link_num, fd);
+            modbus_close(this_mb_link->modbus);
+            modbus_set_socket(this_mb_link->modbus, -1);
+            return retERR;
+        }
+        if (protocol_debug) {
+            print_frame("<", rsp, len + 6);
+        }
+
+        rsp_tid = (rsp[0] << 8) | rsp[1];
+        for (counter = 0; counter < n_txs; counter++) {
+            if (pending[counter] && tid[counter] == rsp_tid) {
+                break;
+            }
+        }
+        if (counter == n_txs) { //late response of an older request
+            DBG(mb_txs[0]->cfg_debug, "mb_links[%d] fd[%d] unexpected tid[%d] dropped",
+                this_mb_link->mb_link_num, fd, rsp_tid);
+            continue;
+        }
+        pending[counter] = 0;
+        n_pending--;
+        this_mb_tx = mb_txs[counter];
+
+        if (rsp[7] == (fnct_code[counter] | 0x80) && len >= 3) {
+            ERR(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] = exception[%d] fd[%d]",
+                this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id, rsp[8], fd);
+            ret_all = retERR;
+            continue;
+        }
+        if (fnct_code[counter] <= 0x02) {
+            nbytes = (this_mb_tx->mb_tx_grp_nelem + 7) / 8;
+        }
+        else {
+            nbytes = this_mb_tx->mb_tx_grp_nelem * 2;
+        }
+        if (rsp[6] != this_mb_tx->mb_tx_slave_id || rsp[7] != fnct_code[counter] ||
+            len < 3 || rsp[8] != nbytes || len != nbytes + 3) {
+            ERR(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] = bad response fd[%d]",
+                this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id, fd);
+            ret_all = retERR;
+            continue;
+        }
+
+        if (fnct_code[counter] <= 0x02) {
+            for (elem = 0; elem < this_mb_tx->mb_tx_grp_nelem; elem++) {
+                bits[elem] = (rsp[9 + elem / 8] >> (elem % 8)) & 1;
+            }
+            set_read_bits(this_mb_tx, bits);
+        }
+        else {
+            for (elem = 0; elem < this_mb_tx->mb_tx_grp_nelem; elem++) {
+                data[elem] = (rsp[9 + 2 * elem] << 8) | rsp[10 + 2 * elem];
+            }
+            set_read_registers(this_mb_tx, data);
+        }
+        rets[counter] = retOK;
+    }
+
+    return ret_all;
+}
@@ -87,6 +87,7 @@ int hal_flag = 0;	/* used to indicate that halcmd might have the
 int halcmd_done = 0;		/* used to break out of processing loop */
 int scriptmode = 0;	/* used to make output "script friendly" (suppress headers) */
 int echo_mode = 0;
+int batch_mode = 0;	/* queue commands for halcmd_batch_flush() */
 char comp_name[HAL_NAME_LEN+1];	/* name for this instance of halcmd */
 
 static void quit(int);
@@ -147,6 +148,7 @@ struct halcmd_command halcmd_commands[] = {
     {"ptype",   FUNCT(do_ptype_cmd, cp),       A_ONE },
     {"stype",   FUNCT(do_stype_cmd, cp),       A_ONE },
     {"help",    FUNCT(do_help_cmd, cp),        A_ONE | A_OPTIONAL },
+    {"latency", FUNCT(do_latency_cmd, cp_cpp), A_ONE | A_PLUS },
     {"linkpp",  FUNCT(do_linkpp_cmd, cp_cp),   A_TWO | A_REMOVE_ARROWS },
     {"linkps",  FUNCT(do_linkps_cmd, cp_cp),   A_TWO | A_REMOVE_ARROWS },
     {"linksp",  FUNCT(do_linksp_cmd, cp_cp),   A_TWO | A_REMOVE_ARROWS },
@@ -49,9 +49,17 @@ extern void halcmd_shutdown();
 extern int halcmd_parse_cmd(char * tokens[]);
 extern int halcmd_parse_line(char * line);
 extern void halcmd_shutdown(void);
-extern int prompt_mode, echo_mode, errorcount, halcmd_done;
+extern int prompt_mode, echo_mode, batch_mode, errorcount, halcmd_done;
+extern int hal_flag;
 extern int halcmd_preprocess_line ( char *line, char **tokens);
 
+/* halcmd_batch_queue() returns 1 if the command was queued for batch
+   mode, 0 if it has to be run on its own, after halcmd_batch_flush().
+   halcmd_batch_flush() carries out the queued commands and returns the
+   number that failed. */
+extern int halcmd_batch_queue(char *tokens[]);
+extern int halcmd_batch_flush(int keep_going);
+
 void halcmd_info(const char *format,...) __attribute__((format(printf,1,2)));
 void halcmd_output(const char *format,...) __attribute__((format(printf,1,2)));
 void halcmd_warning(const char *format,...) __attribute__((format(printf,1,2)));
@@ -57,6 +57,11 @@
 #include <time.h>
 #include <fnmatch.h>
 #include <vector>
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
 
 static int unloadrt_comp(char *mod_name);
 static void print_comp_info(char **patterns);
@@ -76,6 +81,7 @@ static void print_funct_names(char **patterns);
 static void print_thread_names(char **patterns);
 static void print_lock_status();
 static void print_mem_status();
+static void print_block_status();
 static const char *data_type(int type);
 static const char *data_type2(int type);
 static const char *pin_data_dir(int dir);
@@ -278,9 +284,24 @@ int do_source_cmd(char *hal_filename) {
             result = -EINVAL;
             break;
         }
-        result = halcmd_parse_line(buf);
+        if(batch_mode) {
+            char *tokens[MAX_TOK+1];
+            result = halcmd_preprocess_line(buf, tokens);
+            if(result == 0 && !halcmd_batch_queue(tokens)) {
+                if(halcmd_batch_flush(0) != 0) {
+                    result = -EINVAL;
+                } else {
+                    result = halcmd_parse_cmd(tokens);
+                }
+            }
+        } else {
+            result = halcmd_parse_line(buf);
+        }
         if(result != 0) break;
     }
+    if(batch_mode && halcmd_batch_flush(0) != 0 && result == 0) {
+        result = -EINVAL;
+    }
 
     halcmd_set_linenumber(lineno_save);
     halcmd_set_filename(filename_save);
@@ -974,6 +995,568 @@ int do_gets_cmd(char *name)
     return 0;
 }
 
+/* Batch mode ('halcmd -b'): runs of consecutive 'net', 'linkps',
+   'linksp', 'newsig', 'setp', 'sets' and 'addf' commands are queued by
+   halcmd_batch_queue() and carried out by halcmd_batch_flush() under a
+   single acquisition of the HAL mutex.  Names are looked up in hash
+   tables made once per run instead of walking the object lists for
+   every one, and the plans of parallel threads are worked out once at
+   the end instead of after every link.
+
+   Every command of the run is checked against the tables before any is
+   carried out, and the tables are updated as if it had been, so later
+   commands see the signals and links made by earlier ones.  If a command
+   fails, the error is reported with its own file and line, and none of
+   the run is carried out; with -k the commands that passed still are.
+*/
+
+struct batch_cmd {
+    std::string filename;
+    int linenumber;
+    std::vector<std::string> args;
+    bool ok;
+};
+
+static std::vector<batch_cmd> batch_cmds;
+
+struct batch_sig {
+    std::string name;
+    hal_sig_t *sig;		/* 0 until a new signal is created */
+    hal_type_t type;
+    int readers, writers, bidirs;
+    const char *writer, *bidir;	/* pin names for messages */
+};
+
+struct batch_pin {
+    hal_pin_t *pin;
+    batch_sig *sig;
+};
+
+struct batch_funct {
+    hal_funct_t *funct;
+    int users;
+};
+
+struct batch_thread {
+    hal_thread_t *thread;
+    int functs;
+};
+
+struct batch_index {
+    std::deque<batch_sig> sigs;
+    std::deque<batch_pin> pins;
+    std::unordered_map<std::string, batch_sig *> sig;
+    std::unordered_map<std::string, batch_pin *> pin;
+    std::unordered_map<std::string, hal_param_t *> param;
+    std::unordered_map<std::string, batch_funct> funct;
+    std::unordered_map<std::string, batch_thread> thread;
+    std::unordered_set<const void *> ports;	/* allocated by the batch */
+    long port_bytes = 0;		/* shared memory they take */
+};
+
+template<class T>
+static T batch_find(const std::unordered_map<std::string, T> &m,
+                    const std::string &name) {
+    auto it = m.find(name);
+    return it == m.end() ? T() : it->second;
+}
+
+static void batch_index_build(batch_index &ix)
+{
+    // This function assumes that the mutex is held
+    SHMFIELD(hal_sig_t) snext;
+    SHMFIELD(hal_pin_t) pnext;
+    SHMFIELD(hal_param_t) anext;
+    SHMFIELD(hal_funct_t) fnext;
+    SHMFIELD(hal_thread_t) tnext;
+    hal_sig_t *sig;
+    hal_pin_t *pin;
+    hal_param_t *param;
+    hal_funct_t *funct;
+    hal_thread_t *thread;
+    hal_list_t *entry;
+
+    for(snext = hal_data->sig_list_ptr; snext; snext = sig->next_ptr) {
+        sig = SHMPTR(snext);
+        ix.sigs.push_back({sig->name, sig, sig->type, sig->readers,
+                sig->writers, sig->bidirs, 0, 0});
+        ix.sig[sig->name] = &ix.sigs.back();
+    }
+    for(pnext = hal_data->pin_list_ptr; pnext; pnext = pin->next_ptr) {
+        batch_sig *s = 0;
+        pin = SHMPTR(pnext);
+        if(pin->signal) {
+            s = ix.sig[SHMPTR(pin->signal)->name];
+            if(pin->dir == HAL_OUT) s->writer = pin->name;
+            if(pin->dir == HAL_IO) s->bidir = s->writer = pin->name;
+        }
+        ix.pins.push_back({pin, s});
+        ix.pin[pin->name] = &ix.pins.back();
+        if(pin->oldname) ix.pin[SHMPTR(pin->oldname)->name] = &ix.pins.back();
+    }
+    for(anext = hal_data->param_list_ptr; anext; anext = param->next_ptr) {
+        param = SHMPTR(anext);
+        ix.param[param->name] = param;
+        if(param->oldname) ix.param[SHMPTR(param->oldname)->name] = param;
+    }
+    for(fnext = hal_data->funct_list_ptr; fnext; fnext = funct->next_ptr) {
+        funct = SHMPTR(fnext);
+        ix.funct[funct->name] = {funct, funct->users};
+    }
+    for(tnext = hal_data->thread_list_ptr; tnext; tnext = thread->next_ptr) {
+        int n = 0;
+        thread = SHMPTR(tnext);
+        for(entry = list_next(&thread->funct_list);
+                entry != &thread->funct_list; entry = list_next(entry)) {
+            n++;
+        }
+        ix.thread[thread->name] = {thread, n};
+    }
+}
+
+/* the checks of preflight_net_cmd() and hal_link() */
+static int batch_check_link(batch_index &ix, const std::string &signal,
+        batch_sig *s, const std::vector<std::string> &names)
+{
+    std::vector<batch_pin *> pins;
+    int type = -1, writers = 0, bidirs = 0, readers = 0;
+    const char *writer_name = 0, *bidir_name = 0;
+
+    if(s) {
+        type = s->type;
+        writers = s->writers;
+        bidirs = s->bidirs;
+        readers = s->readers;
+        writer_name = s->writer;
+        bidir_name = s->bidir;
+    }
+    for(const std::string &name : names) {
+        batch_pin *p = batch_find(ix.pin, name);
+        hal_pin_t *pin;
+        if(!p) {
+            halcmd_error("Pin '%s' does not exist\n", name.c_str());
+            return -ENOENT;
+        }
+        pin = p->pin;
+        if((s && p->sig == s)
+                || std::find(pins.begin(), pins.end(), p) != pins.end()) {
+            /* already on this signal */
+            continue;
+        }
+        if(p->sig) {
+            halcmd_error("Pin '%s' was already linked to signal '%s'\n",
+                    pin->name, p->sig->name.c_str());
+            return -EINVAL;
+        }
+        if(type == -1) {
+            type = pin->type;
+        }
+        if(type != pin->type) {
+            halcmd_error(
+                "Signal '%s' of type '%s' cannot add pin '%s' of type '%s'\n",
+                signal.c_str(), data_type2(type), pin->name,
+                data_type2(pin->type));
+            return -EINVAL;
+        }
+        if((pin->dir == HAL_OUT && (writers || bidirs))
+                || (pin->dir == HAL_IO && writers)) {
+            halcmd_error(
+                "Signal '%s' can not add %s pin '%s', "
+                "it already has %s pin '%s'\n",
+                    signal.c_str(), pin_data_dir(pin->dir), pin->name,
+                    bidir_name ? pin_data_dir(HAL_IO):pin_data_dir(HAL_OUT),
+                    bidir_name ? bidir_name : writer_name);
+            return -EINVAL;
+        }
+        if(pin->type == HAL_PORT && pin->dir == HAL_IO) {
+            halcmd_error("Signal '%s' is a port and cannot have I/O pin '%s'\n",
+                    signal.c_str(), pin->name);
+            return -EINVAL;
+        }
+        if(pin->type == HAL_PORT && pin->dir == HAL_IN && readers) {
+            halcmd_error("Signal '%s' is a port and can only have one "
+                    "input pin\n", signal.c_str());
+            return -EINVAL;
+        }
+        if(pin->dir == HAL_OUT) {
+            writer_name = pin->name;
+            writers++;
+        }
+        if(pin->dir == HAL_IO) {
+            bidir_name = writer_name = pin->name;
+            bidirs++;
+        }
+        if(pin->dir & HAL_IN) {
+            readers++;
+        }
+        pins.push_back(p);
+    }
+
+    if(!s) {
+        if(pins.empty()) {
+            halcmd_error("'net' requires at least one pin, none given\n");
+            return -EINVAL;
+        }
+        ix.sigs.push_back({signal, 0, (hal_type_t)type, 0, 0, 0, 0, 0});
+        s = ix.sig[signal] = &ix.sigs.back();
+    }
+    s->readers = readers;
+    s->writers = writers;
+    s->bidirs = bidirs;
+    s->writer = writer_name;
+    s->bidir = bidir_name;
+    for(batch_pin *p : pins) {
+        p->sig = s;
+    }
+    return 0;
+}
+
+/* set_common() allocates a port, so this checks what it would: the
+   size, that the port has no buffer yet and that there is room for
+   it.  'port' is what setp or sets writes, 0 for a signal the batch
+   creates; 'key' tells the ports of the batch apart. */
+static int batch_check_port(batch_index &ix, const void *key,
+                            hal_port_t *port, const std::string &value) {
+    char *cp;
+    unsigned size = strtoul(value.c_str(), &cp, 0);
+
+    if((*cp != '\0') && (!isspace(*cp))) {
+        halcmd_error("value '%s' invalid for PORT\n", value.c_str());
+        return -EINVAL;
+    }
+    if(port && *port != 0 && hal_port_buffer_size(port) > 0) {
+        halcmd_error("port is already allocated with %u bytes.\n",
+                hal_port_buffer_size(port));
+        return -EINVAL;
+    }
+    if(!ix.ports.insert(key).second) {
+        halcmd_error("port is already allocated by this batch\n");
+        return -EINVAL;
+    }
+    /* shmalloc_up() aligns to 16 bytes */
+    ix.port_bytes += sizeof(hal_port_shm_t) + size + 15;
+    if(ix.port_bytes > hal_data->shmem_avail) {
+        halcmd_error("failed to allocate PORT with size %u\n", size);
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+static int batch_check_value(batch_index &ix, hal_type_t type, const void *key,
+                             void *target, const std::string &value) {
+    hal_data_u scratch;
+    if(type == HAL_PORT) {
+        return batch_check_port(ix, key, (hal_port_t *)target, value);
+    }
+    return set_common(type, &scratch, const_cast<char *>(value.c_str()));
+}
+
+static int batch_signal_type(const std::string &type, hal_type_t *t) {
+    static const struct { const char *name; hal_type_t type; } types[] = {
+        {"bit", HAL_BIT}, {"float", HAL_FLOAT}, {"u32", HAL_U32},
+        {"s32", HAL_S32}, {"u64", HAL_U64}, {"s64", HAL_S64},
+        {"port", HAL_PORT},
+    };
+    for(auto &it : types) {
+        if(strcasecmp(type.c_str(), it.name) == 0) {
+            *t = it.type;
+            return 0;
+        }
+    }
+    return -EINVAL;
+}
+
+static int batch_check(batch_index &ix, batch_cmd &c)
+{
+    const std::string &cmd = c.args[0];
+
+    if(cmd != "setp" && cmd != "sets" && (hal_data->lock & HAL_LOCK_CONFIG)) {
+        halcmd_error("%s not allowed while HAL is locked\n", cmd.c_str());
+        return -EPERM;
+    }
+    if(cmd == "net" || cmd == "linkps" || cmd == "linksp") {
+        const std::string &signal = cmd == "linkps" ? c.args[2] : c.args[1];
+        batch_sig *s = batch_find(ix.sig, signal);
+        std::vector<std::string> pins;
+        int retval;
+        if(cmd == "net") {
+            pins.assign(c.args.begin() + 2, c.args.end());
+            if(batch_find(ix.pin, signal)) {
+                halcmd_error(
+                        "Signal name '%s' must not be the same as a pin.  "
+                        "Did you omit the signal name?\n", signal.c_str());
+                return -ENOENT;
+            }
+            if(!s && signal.size() > HAL_NAME_LEN) {
+                halcmd_error("signal name '%s' is too long\n", signal.c_str());
+                return -EINVAL;
+            }
+        } else {
+            pins.push_back(cmd == "linkps" ? c.args[1] : c.args[2]);
+            if(!s) {
+                halcmd_error("signal '%s' not found\n", signal.c_str());
+                halcmd_error("link failed\n");
+                return -EINVAL;
+            }
+        }
+        retval = batch_check_link(ix, signal, s, pins);
+        if(retval < 0 && cmd != "net") {
+            halcmd_error("link failed\n");
+        }
+        return retval;
+    } else if(cmd == "newsig") {
+        const std::string &name = c.args[1];
+        hal_type_t type;
+        if(batch_signal_type(c.args[2], &type) < 0) {
+            halcmd_error("Unknown signal type '%s'\n", c.args[2].c_str());
+        } else if(batch_find(ix.sig, name)) {
+            halcmd_error("duplicate signal '%s'\n", name.c_str());
+        } else if(name.size() > HAL_NAME_LEN) {
+            halcmd_error("signal name '%s' is too long\n", name.c_str());
+        } else {
+            ix.sigs.push_back({name, 0, type, 0, 0, 0, 0, 0});
+            ix.sig[name] = &ix.sigs.back();
+            return 0;
+        }
+        halcmd_error("newsig failed\n");
+        return -EINVAL;
+    } else if(cmd == "setp") {
+        const std::string &name = c.args[1];
+        hal_param_t *param = batch_find(ix.param, name);
+        batch_pin *p;
+        hal_type_t type;
+        void *target;
+        if(param) {
+            if(param->dir == HAL_RO) {
+                halcmd_error("param '%s' is not writable\n", name.c_str());
+                return -EINVAL;
+            }
+            type = param->type;
+            target = SHMPTR(param->data_ptr);
+        } else if((p = batch_find(ix.pin, name))) {
+            if(p->pin->dir == HAL_OUT) {
+                halcmd_error("pin '%s' is not writable\n", name.c_str());
+                return -EINVAL;
+            }
+            if(p->sig) {
+                halcmd_error("pin '%s' is connected to a signal\n",
+                        name.c_str());
+                return -EINVAL;
+            }
+            type = p->pin->type;
+            target = &p->pin->dummysig;
+        } else {
+            halcmd_error("parameter or pin '%s' not found\n", name.c_str());
+            return -EINVAL;
+        }
+        if(batch_check_value(ix, type, target, target, c.args[2]) < 0) {
+            halcmd_error("setp failed\n");
+            return -EINVAL;
+        }
+        return 0;
+    } else if(cmd == "sets") {
+        const std::string &name = c.args[1];
+        batch_sig *s = batch_find(ix.sig, name);
+        if(!s) {
+            halcmd_error("signal '%s' not found\n", name.c_str());
+            return -EINVAL;
+        }
+        if(s->type != HAL_PORT && s->writers > 0) {
+            halcmd_error("signal '%s' already has writer(s)\n", name.c_str());
+            return -EINVAL;
+        }
+        if(batch_check_value(ix, s->type, s,
+                             s->sig ? SHMPTR(s->sig->data_ptr) : 0, c.args[2]) < 0) {
+            halcmd_error("sets failed\n");
+            return -EINVAL;
+        }
+        return 0;
+    } else if(cmd == "addf") {
+        auto f = ix.funct.find(c.args[1]);
+        auto t = ix.thread.find(c.args[2]);
+        int position = c.args.size() > 3 && !c.args[3].empty()
+            ? atoi(c.args[3].c_str()) : -1;
+        if(f == ix.funct.end()) {
+            halcmd_error("function '%s' not found\n", c.args[1].c_str());
+        } else if(t == ix.thread.end()) {
+            halcmd_error("thread '%s' not found\n", c.args[2].c_str());
+        } else if(f->second.users > 0 && !f->second.funct->reentrant) {
+            halcmd_error("function '%s' may only be added to one thread\n",
+                    c.args[1].c_str());
+        } else if(f->second.funct->uses_fp && !t->second.thread->uses_fp) {
+            halcmd_error("function '%s' needs FP\n", c.args[1].c_str());
+        } else if(position == 0 || position > t->second.functs + 1
+                || position < -(t->second.functs + 1)) {
+            halcmd_error("bad position: %d\n", position);
+        } else {
+            f->second.users++;
+            t->second.functs++;
+            return 0;
+        }
+        halcmd_error("addf failed\n");
+        return -EINVAL;
+    }
+    halcmd_error("BUG: '%s' cannot be batched\n", cmd.c_str());
+    return -EINVAL;
+}
+
+static int batch_apply(batch_index &ix, batch_cmd &c, int *linked)
+{
+    // This function assumes that the mutex is held
+    const std::string &cmd = c.args[0];
+    int retval = 0;
+
+    if(cmd == "net" || cmd == "linkps" || cmd == "linksp") {
+        const std::string &signal = cmd == "linkps" ? c.args[2] : c.args[1];
+        batch_sig *s = ix.sig[signal];
+        std::vector<std::string>::iterator first, last;
+        if(cmd == "net") {
+            first = c.args.begin() + 2;
+            last = c.args.end();
+        } else {
+            first = c.args.begin() + (cmd == "linkps" ? 1 : 2);
+            last = first + 1;
+        }
+        if(!s->sig) {
+            retval = halpr_signal_new(signal.c_str(), s->type, &s->sig);
+        }
+        for(; retval == 0 && first != last; ++first) {
+            hal_pin_t *pin = ix.pin[*first]->pin;
+            if(SHMPTR(pin->signal) == s->sig) continue;
+            retval = halpr_link(pin, s->sig);
+            if(retval == 0) {
+                (*linked)++;
+                halcmd_info("Pin '%s' linked to signal '%s'\n",
+                        first->c_str(), signal.c_str());
+            }
+        }
+    } else if(cmd == "newsig") {
+        batch_sig *s = ix.sig[c.args[1]];
+        retval = halpr_signal_new(c.args[1].c_str(), s->type, &s->sig);
+    } else if(cmd == "setp") {
+        const std::string &name = c.args[1];
+        hal_param_t *param = batch_find(ix.param, name);
+        char *value = const_cast<char *>(c.args[2].c_str());
+        if(param) {
+            retval = set_common(param->type, SHMPTR(param->data_ptr), value);
+        } else {
+            hal_pin_t *pin = ix.pin[name]->pin;
+            retval = set_common(pin->type, (void*)&pin->dummysig, value);
+        }
+        if(retval == 0) {
+            halcmd_info("%s '%s' set to %s\n", param ? "Parameter" : "Pin",
+                    name.c_str(), value);
+        }
+    } else if(cmd == "sets") {
+        hal_sig_t *sig = ix.sig[c.args[1]]->sig;
+        retval = set_common(sig->type, SHMPTR(sig->data_ptr),
+                const_cast<char *>(c.args[2].c_str()));
+    } else if(cmd == "addf") {
+        int position = c.args.size() > 3 && !c.args[3].empty()
+            ? atoi(c.args[3].c_str()) : -1;
+        retval = halpr_add_funct_to_thread(ix.funct[c.args[1]].funct,
+                ix.thread[c.args[2]].thread, position);
+        if(retval == 0) {
+            halcmd_info("Function '%s' added to thread '%s'\n",
+                    c.args[1].c_str(), c.args[2].c_str());
+        }
+    }
+    if(retval != 0) {
+        halcmd_error("%s failed\n", cmd.c_str());
+    }
+    return retval;
+}
+
+int halcmd_batch_queue(char *tokens[])
+{
+    std::vector<std::string> args;
+    int i;
+
+    for(i = 0; tokens[i] && *tokens[i]; i++) {
+        if(!strcmp(tokens[i], "<=") || !strcmp(tokens[i], "=>")
+                || !strcmp(tokens[i], "<=>")) {
+            continue;
+        }
+        args.push_back(tokens[i]);
+    }
+    if(args.empty()) {
+        /* blank lines and comments do not end a run */
+        return 1;
+    }
+    const std::string &cmd = args[0];
+    if(args.size() == 3 && !strcmp(tokens[1], "=")) {
+        /* pin/param = value, unless it is a command */
+        for(i = 0; i < halcmd_ncommands; i++) {
+            if(cmd == halcmd_commands[i].name) return 0;
+        }
+        args.erase(args.begin() + 1);
+        args.insert(args.begin(), "setp");
+    } else if(cmd == "net") {
+        if(args.size() < 3) return 0;
+    } else if(cmd == "linkps" || cmd == "linksp" || cmd == "newsig"
+            || cmd == "setp" || cmd == "sets") {
+        if(args.size() != 3) return 0;
+        /* arrows are only removed for the link commands */
+        if((cmd == "newsig" || cmd == "setp" || cmd == "sets")
+                && i != 3) return 0;
+    } else if(cmd == "addf") {
+        if(args.size() < 3 || i != (int)args.size()) return 0;
+    } else {
+        return 0;
+    }
+    batch_cmds.push_back({halcmd_get_filename(), halcmd_get_linenumber(),
+            args, false});
+    return 1;
+}
+
+int halcmd_batch_flush(int keep_going)
+{
+    std::string filename_save = halcmd_get_filename();
+    int lineno_save = halcmd_get_linenumber();
+    int failed = 0, linked = 0;
+
+    if(batch_cmds.empty()) {
+        return 0;
+    }
+    hal_flag = 1;
+    rtapi_mutex_get(&(hal_data->mutex));
+    {
+        batch_index ix;
+        batch_index_build(ix);
+        for(batch_cmd &c : batch_cmds) {
+            if(c.filename != halcmd_get_filename()) {
+                halcmd_set_filename(c.filename.c_str());
+            }
+            halcmd_set_linenumber(c.linenumber);
+            c.ok = batch_check(ix, c) == 0;
+            if(!c.ok) failed++;
+        }
+        if(failed == 0 || keep_going) {
+            for(batch_cmd &c : batch_cmds) {
+                if(!c.ok) continue;
+                if(c.filename != halcmd_get_filename()) {
+                    halcmd_set_filename(c.filename.c_str());
+                }
+                halcmd_set_linenumber(c.linenumber);
+                if(batch_apply(ix, c, &linked) != 0) {
+                    failed++;
+                    if(!keep_going) break;
+                }
+            }
+        }
+    }
+    if(linked) {
+        /* functions in parallel threads may have to wait for others now */
+        halpr_thread_plans_update();
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    hal_flag = 0;
+    batch_cmds.clear();
+    halcmd_set_filename(filename_save.c_str());
+    halcmd_set_linenumber(lineno_save);
+    return failed;
+}
+
 static int get_type(char ***patterns) {
     char *typestr = 0;
     if(!(*patterns)) return -1;
@@ -1117,6 +1700,280 @@ int do_status_cmd(char *type)
     return 0;
 }
 
+/* the histogram of a thread that records its latency, or NULL.  Call
+   with the HAL mutex held.  The histogram stays valid after the mutex
+   is released, even if the thread is deleted; copy it then, see
+   copy_latency_hist() */
+static hal_latency_hist_t *find_latency_hist(const char *name, long *period)
+{
+    hal_thread_t *tptr = halpr_find_thread_by_name(name);
+
+    if (!tptr || !tptr->hist_enabled) {
+	return NULL;
+    }
+    if (period) {
+	*period = tptr->period;
+    }
+    return (hal_latency_hist_t *) SHMPTR(tptr->hist);
+}
+
+/* a consistent copy of a thread's histogram, see hal_latency_hist_t.
+   It may wait for the thread, so do not hold the HAL mutex. */
+static int copy_latency_hist(hal_latency_hist_t *hist, hal_latency_hist_t *copy)
+{
+    unsigned int seq;
+    int tries;
+
+    for (tries = 0; tries < 1000; tries++) {
+	seq = __atomic_load_n(&hist->seq, __ATOMIC_ACQUIRE);
+	if ((seq & 1) == 0) {
+	    memcpy(copy, hist, sizeof(*copy));
+	    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+	    if (__atomic_load_n(&hist->seq, __ATOMIC_RELAXED) == seq) {
+		return 0;
+	    }
+	}
+	usleep(10);
+    }
+    return -EAGAIN;
+}
+
+/* names of the threads matching 'patterns' that record their latency,
+   or all of them for 'all_threads' */
+static std::vector<std::string> latency_threads(char **patterns, int all_threads)
+{
+    std::vector<std::string> names;
+    SHMFIELD(hal_thread_t) next_thread;
+    hal_thread_t *tptr;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    next_thread = hal_data->thread_list_ptr;
+    while (next_thread != 0) {
+	tptr = (hal_thread_t *) SHMPTR(next_thread);
+	if (match(patterns, tptr->name) && (all_threads || tptr->hist_enabled)) {
+	    names.push_back(tptr->name);
+	}
+	next_thread = tptr->next_ptr;
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    return names;
+}
+
+/* the per-CPU counts of /proc/interrupts, by IRQ */
+struct irq_counts {
+    std::vector<std::string> irqs, descs;
+    std::vector<std::vector<unsigned long> > counts;
+};
+
+static void read_interrupts(irq_counts &result)
+{
+    FILE *f = fopen("/proc/interrupts", "r");
+    char line[1024];
+    int cpus = 0;
+
+    result = irq_counts();
+    if (!f) {
+	return;
+    }
+    if (fgets(line, sizeof(line), f)) {
+	for (char *tok = strtok(line, " \t\n"); tok; tok = strtok(NULL, " \t\n")) {
+	    cpus++;
+	}
+    }
+    while (fgets(line, sizeof(line), f)) {
+	char *p = line, *end;
+	std::vector<unsigned long> counts;
+	while (isspace((unsigned char) *p)) p++;
+	end = strchr(p, ':');
+	if (!end) continue;
+	result.irqs.push_back(std::string(p, end - p));
+	p = end + 1;
+	for (int cpu = 0; cpu < cpus; cpu++) {
+	    unsigned long n = strtoul(p, &end, 10);
+	    if (end == p) break;
+	    counts.push_back(n);
+	    p = end;
+	}
+	while (isspace((unsigned char) *p)) p++;
+	end = p + strlen(p);
+	while (end > p && isspace((unsigned char) end[-1])) end--;
+	result.descs.push_back(std::string(p, end - p));
+	result.counts.push_back(counts);
+    }
+    fclose(f);
+}
+
+/* the interrupts between two snapshots, one IRQ per line */
+static std::string interrupts_between(const irq_counts &before, const irq_counts &after)
+{
+    std::string result;
+    char buf[64];
+
+    for (size_t i = 0; i < after.irqs.size() && i < before.irqs.size(); i++) {
+	std::string counts;
+	if (after.irqs[i] != before.irqs[i]) continue;
+	for (size_t cpu = 0; cpu < after.counts[i].size()
+		&& cpu < before.counts[i].size(); cpu++) {
+	    unsigned long n = after.counts[i][cpu] - before.counts[i][cpu];
+	    if (n == 0) continue;
+	    snprintf(buf, sizeof(buf), " cpu%d:%lu", (int) cpu, n);
+	    counts += buf;
+	}
+	if (counts.empty()) continue;
+	result += "    " + after.irqs[i] + " (" + after.descs[i] + ")" + counts + "\n";
+    }
+    return result;
+}
+
+static void print_latency_hist(const char *name, const char *worst_irqs)
+{
+    hal_latency_hist_t *shm, hist;
+    long period = 0;
+    int n;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    shm = find_latency_hist(name, &period);
+    rtapi_mutex_give(&(hal_data->mutex));
+    if (!shm || copy_latency_hist(shm, &hist) < 0) {
+	halcmd_error("no latency data for thread '%s'\n", name);
+	return;
+    }
+    if (hist.reset_done != hist.reset_req) {
+	/* the thread has not run since the reset */
+	hist.samples = 0;
+    }
+
+    if (scriptmode) {
+	halcmd_output("%s samples %u\n", name, hist.samples);
+	if (hist.samples == 0) {
+	    return;
+	}
+	halcmd_output("%s min %ld\n", name, hist.min);
+	halcmd_output("%s max %ld\n", name, hist.max);
+	halcmd_output("%s avg %.0f\n", name, (double) hist.sum / hist.samples);
+	halcmd_output("%s max-time %lld\n", name, hist.max_time);
+	halcmd_output("%s early %u\n", name, hist.early);
+	for (n = 0; n < HAL_LATENCY_BINS; n++) {
+	    if (hist.bins[n]) {
+		halcmd_output("%s bin %d %u\n", name, n, hist.bins[n]);
+	    }
+	}
+	halcmd_output("%s overflow %u\n", name, hist.overflow);
+	return;
+    }
+
+    halcmd_output("Wakeup latency of thread %s (period %ld ns), %u periods:\n",
+	name, period, hist.samples);
+    if (hist.samples == 0) {
+	return;
+    }
+    halcmd_output("  min %ld ns, avg %.0f ns, max %ld ns, %.3f s ago\n",
+	hist.min, (double) hist.sum / hist.samples, hist.max,
+	(rtapi_get_time() - hist.max_time) * 1e-9);
+    if (hist.early) {
+	halcmd_output("     early %10u\n", hist.early);
+    }
+    for (n = 0; n < HAL_LATENCY_BINS; n++) {
+	if (hist.bins[n]) {
+	    halcmd_output("  %5d us %10u\n", n, hist.bins[n]);
+	}
+    }
+    if (hist.overflow) {
+	halcmd_output("  >=%4d us %9u\n", HAL_LATENCY_BINS, hist.overflow);
+    }
+    if (worst_irqs) {
+	halcmd_output("  interrupts in the %d ms around the worst case:\n%s",
+	    100, *worst_irqs ? worst_irqs : "    none\n");
+    }
+}
+
+/* resets the histograms, then watches them and /proc/interrupts */
+static int watch_latency(const std::vector<std::string> &names, double seconds)
+{
+    std::vector<unsigned int> max_seq(names.size(), 0);
+    std::vector<std::string> worst_irqs(names.size());
+    std::vector<hal_latency_hist_t *> shm(names.size());
+    irq_counts before, after;
+    hal_latency_hist_t hist;
+    struct timespec ts = { 0, 100000000 };
+    int ticks = (int)(seconds * 10 + 0.5);
+
+    for (size_t i = 0; i < names.size(); i++) {
+	if (hal_thread_latency(names[i].c_str()) < 0) {
+	    return -EINVAL;
+	}
+    }
+    read_interrupts(before);
+    for (int tick = 0; tick < ticks; tick++) {
+	nanosleep(&ts, NULL);
+	read_interrupts(after);
+	rtapi_mutex_get(&(hal_data->mutex));
+	for (size_t i = 0; i < names.size(); i++) {
+	    shm[i] = find_latency_hist(names[i].c_str(), NULL);
+	}
+	rtapi_mutex_give(&(hal_data->mutex));
+	for (size_t i = 0; i < names.size(); i++) {
+	    if (!shm[i] || copy_latency_hist(shm[i], &hist) < 0
+		|| hist.reset_done != hist.reset_req) {
+		continue;
+	    }
+	    if (hist.max_seq != max_seq[i]) {
+		max_seq[i] = hist.max_seq;
+		worst_irqs[i] = interrupts_between(before, after);
+	    }
+	}
+	std::swap(before, after);
+    }
+    for (size_t i = 0; i < names.size(); i++) {
+	print_latency_hist(names[i].c_str(), scriptmode ? NULL : worst_irqs[i].c_str());
+    }
+    return 0;
+}
+
+int do_latency_cmd(char *action, char **args)
+{
+    std::vector<std::string> names;
+    double seconds = 0;
+    char *end;
+
+    if (strcmp(action, "watch") == 0) {
+	if (!args[0] || !*args[0]) {
+	    halcmd_error("'latency watch' needs the number of seconds\n");
+	    return -1;
+	}
+	seconds = strtod(args[0], &end);
+	if (*end != '\0' || seconds <= 0) {
+	    halcmd_error("'%s' is not a number of seconds\n", args[0]);
+	    return -1;
+	}
+	args++;
+    } else if (strcmp(action, "reset") != 0 && strcmp(action, "show") != 0) {
+	halcmd_error("Unknown 'latency' action '%s'\n", action);
+	return -1;
+    }
+
+    names = latency_threads(args, strcmp(action, "show") != 0);
+    if (names.empty()) {
+	halcmd_error("no matching threads\n");
+	return -1;
+    }
+    if (strcmp(action, "reset") == 0) {
+	for (size_t i = 0; i < names.size(); i++) {
+	    if (hal_thread_latency(names[i].c_str()) < 0) {
+		return -1;
+	    }
+	}
+	halcmd_info("Recording the latency of %d threads\n", (int) names.size());
+    } else if (strcmp(action, "show") == 0) {
+	for (size_t i = 0; i < names.size(); i++) {
+	    print_latency_hist(names[i].c_str(), NULL);
+	}
+    } else if (watch_latency(names, seconds) < 0) {
+	return -1;
+    }
+    return 0;
+}
+
 int do_loadrt_cmd(char *mod_name, char *args[])
 {
     char arg_string[MAX_CMD_LEN+1];
@@ -1980,6 +2837,25 @@ static void print_funct_info(char **patterns)
     halcmd_output("\n");
 }
 
+/* value of the s32 pin <thread>.<suffix>, 0 if there is none */
+static long thread_pin_s32(hal_thread_t *tptr, const char *suffix)
+{
+    char name[HAL_NAME_LEN+1];
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+
+    if (snprintf(name, sizeof(name), "%s.%s", tptr->name, suffix) >= (int)sizeof(name))
+        return 0;
+    pin = halpr_find_pin_by_name(name);
+    if (!pin)
+        return 0;
+    if (pin->signal != 0) {
+        sig = SHMPTR(pin->signal);
+        return *(hal_s32_t *)SHMPTR(sig->data_ptr);
+    }
+    return pin->dummysig.s;
+}
+
 static void print_thread_info(char **patterns)
 {
     SHMFIELD(hal_thread_t) next_thread;
@@ -1991,7 +2867,7 @@ static void print_thread_info(char **patterns)
 
     if (scriptmode == 0) {
 	halcmd_output("Realtime Threads:\n");
-	halcmd_output("     Period  FP     Name               (     Time, Max-Time )\n");
+	halcmd_output("     Period  FP     Name               (     Time, Max-Time )  Latency  Max-Lat  CPUs (+helpers)\n");
     }
     rtapi_mutex_get(&(hal_data->mutex));
     next_thread = hal_data->thread_list_ptr;
@@ -2020,13 +2896,28 @@ static void print_thread_info(char **patterns)
                     dptr = &(pin->dummysig);
                 }
 
-                halcmd_output(((scriptmode == 0) ? "%11ld  %-3s  %20s ( %8ld, %8ld )\n"
-                                                 : "%ld %s %s %8ld %ld"),
+                if (scriptmode == 0) {
+                    halcmd_output("%11ld  %-3s  %20s ( %8ld, %8ld ) %8ld %8ld  %s",
+                              tptr->period,
+                              (tptr->uses_fp ? "YES" : "NO"),
+                              tptr->name,
+                              (long)*(long*)dptr,
+                              (long)tptr->maxtime,
+                              thread_pin_s32(tptr, "latency"),
+                              thread_pin_s32(tptr, "latency-max"),
+                              tptr->cpus[0] ? tptr->cpus : "default");
+                    if (tptr->workers > 0) {
+                        halcmd_output(" +%d", tptr->workers);
+                    }
+                    halcmd_output("\n");
+                } else {
+                    halcmd_output("%ld %s %s %8ld %ld",
                               tptr->period,
                               (tptr->uses_fp ? "YES" : "NO"),
                               tptr->name,
                               (long)*(long*)dptr,
                               (long)tptr->maxtime);
+                }
             } else {
                 rtapi_print_msg(RTAPI_MSG_ERR,
                      "unexpected: cannot find time pin for %s thread",tptr->name);
@@ -2207,6 +3098,50 @@ int count_list(SHMFIELD(T) list_root)
     return n;
 }
 
+struct block_usage {
+    int owner;
+    long bytes;
+};
+
+// hal_malloc() memory, in use by each component and free for reuse
+static void print_block_status()
+{
+    std::vector<block_usage> usage;
+    long free_bytes = 0, used_bytes = 0;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    for (SHMFIELD(hal_block_t) next = hal_data->block_list_ptr; next != 0;) {
+	hal_block_t *block = SHMPTR(next);
+	size_t i;
+	for (i = 0; i < usage.size() && usage[i].owner != block->owner; i++) {
+	}
+	if (i == usage.size()) usage.push_back(block_usage{block->owner, 0});
+	usage[i].bytes += block->size;
+	used_bytes += block->size;
+	next = block->next_ptr;
+    }
+    for (int c = 0; c < HAL_BLOCK_CLASSES; c++) {
+	for (SHMFIELD(hal_block_t) next = hal_data->block_free_ptr[c]; next != 0;) {
+	    hal_block_t *block = SHMPTR(next);
+	    free_bytes += block->size;
+	    next = block->next_ptr;
+	}
+    }
+    halcmd_output("  realtime data/structures:   %d/%d\n",
+	hal_data->shmem_bot, HAL_SIZE - hal_data->shmem_top);
+    halcmd_output("  hal_malloc in use/reusable: %ld/%ld\n",
+	used_bytes + hal_data->block_kept, free_bytes);
+    for (const block_usage &u : usage) {
+	hal_comp_t *comp = halpr_find_comp_by_id(u.owner);
+	halcmd_output("    %-31s %8ld\n", comp ? comp->name : "?", u.bytes);
+    }
+    if (hal_data->block_kept) {
+	halcmd_output("    %-31s %8ld\n", "(kept until HAL exits)",
+	    (long) hal_data->block_kept);
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+}
+
 static void print_mem_status()
 {
     int active, recycled;
@@ -2215,6 +3150,7 @@ static void print_mem_status()
 
     halcmd_output("HAL memory status\n");
     halcmd_output("  used/total shared memory:   %ld/%d\n", (long)(HAL_SIZE - hal_data->shmem_avail), HAL_SIZE);
+    print_block_status();
     // count components
     active = count_list(hal_data->comp_list_ptr);
     recycled = count_list(hal_data->comp_free_ptr);
@@ -3039,6 +3975,16 @@ int do_help_cmd(char *command)
 	printf("  'type' is 'lock', 'mem', or 'all'. \n");
 	printf("  If 'type' is omitted, it assumes\n");
 	printf("  'all'.\n");
+    } else if (strcmp(command, "latency") == 0) {
+	printf("latency reset [thread ...]\n");
+	printf("latency show [thread ...]\n");
+	printf("latency watch seconds [thread ...]\n");
+	printf("  Records how late threads wake up each period, in 1 us bins.\n");
+	printf("  'reset' starts recording, or starts over, 'show' prints\n");
+	printf("  the histograms, 'watch' resets, waits 'seconds', and then\n");
+	printf("  shows them with the interrupts that came in around the\n");
+	printf("  worst case.  Without thread names, all threads (for 'show',\n");
+	printf("  all threads that record).  With -s, prints one value per line.\n");
     } else if (strcmp(command, "debug")==0){
     printf("debug [level]\n");
     printf("   set the messaging level for the realtime API (calls rtapi_set_msg_level)\n");
@@ -3135,6 +4081,7 @@ static void print_help_commands(void)
     printf("  list                Display names of HAL objects\n");
     printf("  source              Execute commands from another .hal file\n");
     printf("  status              Display status information\n");
+    printf("  latency             Record and show thread wakeup latency\n");
     printf("  debug               Set the rtapi message level\n");
     printf("  save                Print config as commands\n");
     printf("  start, stop         Start/stop realtime threads\n");
@@ -52,7 +52,7 @@ static const char *command_table[] = {
     "loadrt", "loadusr", "unload", "lock", "unlock",
     "linkps", "linksp", "linkpp", "unlinkp",
     "net", "newsig", "delsig", "getp", "gets", "setp", "sets", "ptype", "stype",
-    "addf", "delf", "show", "list", "status", "save", "source",
+    "addf", "delf", "show", "list", "status", "latency", "save", "source",
     "start", "stop", "quit", "exit", "help", "alias", "unalias", 
     NULL,
 };
@@ -113,7 +113,7 @@ int main(int argc, char **argv)
     keep_going = 0;
     /* start parsing the command line, options first */
     while(1) {
-        c = getopt(argc, argv, "+RCfi:kqQsvVhe");
+        c = getopt(argc, argv, "+RCbfi:kqQsvVhe");
         if(c == -1) break;
         switch(c) {
             case 'R':
@@ -133,6 +133,10 @@ int main(int argc, char **argv)
                 }
 		return 0;
 		break;
+	    case 'b':
+		/* -b = batch connections, see halcmd_batch_queue() */
+		batch_mode = 1;
+		break;
 	    case 'k':
 		/* -k = keep going */
 		keep_going = 1;
@@ -309,8 +313,19 @@ int main(int argc, char **argv)
 		     ( strcasecmp(tokens[0],"exit") == 0 ) ) {
 		    break;
 		}
-		/* process command */
-		retval = halcmd_parse_cmd(tokens);
+		if (batch_mode && halcmd_batch_queue(tokens)) {
+		    /* carried out with the following ones */
+		    retval = 0;
+		} else {
+		    if (batch_mode) {
+			errorcount += halcmd_batch_flush(keep_going);
+			if (( errorcount > 0 ) && ( keep_going == 0 )) {
+			    break;
+			}
+		    }
+		    /* process command */
+		    retval = halcmd_parse_cmd(tokens);
+		}
 	    }
 	    /* did a signal happen while we were busy? */
 	    if ( halcmd_done ) {
@@ -330,6 +345,9 @@ int main(int argc, char **argv)
             *eline = 0;
 	} //while get_input()
         extend_ct=0;
+        if (batch_mode) {
+            errorcount += halcmd_batch_flush(keep_going);
+        }
     }
     /* all done */
     halcmd_shutdown();
@@ -411,6 +429,8 @@ static void print_help_general(int showR)
     printf("\nUsage:   halcmd [options] [cmd [args]]\n\n");
     printf("\n         halcmd [options] -f [filename]\n\n");
     printf("options:\n\n");
+    printf("  -b             Batch - carry out runs of net, link, newsig, setp,\n");
+    printf("                 sets and addf commands together.  (Useful with -f)\n");
     printf("  -e             echo the commands from stdin to stderr\n");
     printf("  -f [filename]  Read commands from 'filename', not command\n");
     printf("                 line.  If no filename, read from stdin.\n");
@@ -152,6 +152,9 @@ def parse(filename):
 dirmap = {'r': 'HAL_RO', 'rw': 'HAL_RW', 'in': 'HAL_IN', 'out': 'HAL_OUT', 'io': 'HAL_IO' }
 typemap = {'signed': 's32', 'unsigned': 'u32'}
 deprmap = {'s32': 'signed', 'u32': 'unsigned'}
+# C types of the pin copies and params of 'option batched' components
+valtypemap = {'bit': 'bool', 'float': 'real_t', 'u32': 'rtapi_u32',
+              's32': 'rtapi_s32', 'u64': 'rtapi_u64', 's64': 'rtapi_s64'}
 deprecated = ['s32', 'u32']
 
 def initialize():
@@ -269,6 +272,352 @@ def to_c(name):
     name = name.replace("#", "").replace(".", "_").replace("-", "_")
     return re.sub("_+", "_", name)
 
+def check_batched():
+    if options.get("userspace"):
+        raise SystemExit("Userspace components may not be batched")
+    if options.get("constructable") and not options.get("singleton"):
+        raise SystemExit("Batched components may not be constructable")
+    if not options.get("rtapi_app", 1):
+        raise SystemExit("Batched components need the generated rtapi_app_main")
+    for name, type, array, dir, value, personality in pins + params:
+        if personality or isinstance(array, tuple):
+            raise SystemExit("Batched components may not have personality: %s" % name)
+        if type not in valtypemap:
+            raise SystemExit("Batched components may not have %s items: %s" % (type, name))
+
+def batch_count(array):
+    if isinstance(array, tuple): array = array[0]
+    return array or 1
+
+def batch_len(array):
+    if batch_count(array) == 1: return "n"
+    return "n * %d" % batch_count(array)
+
+def batch_var(name):
+    bare = name.lstrip("*")
+    return name[:len(name) - len(bare)], bare
+
+def batch_funct_name(name):
+    return to_hal(removeprefix(comp_name, "hal_") + ".all." + name)
+
+# With 'option batched' every item is an array over all instances instead
+# of a member of a per-instance struct, and the convenience defines index
+# it with the number of the instance, __comp_i.  Pins also get an array of
+# their values, which the batch functions gather before and scatter after
+# running the function of each instance, so the loop over the instances
+# only touches contiguous memory.  Array items are stored element by
+# element: item(j) of instance i is at [j * n + i].
+def batch_state(f):
+    print("", file=f)
+    print("struct __comp_batch {", file=f)
+    print("    long n;", file=f)
+    for name, type, array, dir, value, personality in pins:
+        print("    hal_%s_t **%s_p;" % (type, to_c(name)), file=f)
+        print("    %s *%s_v;" % (valtypemap[type], to_c(name)), file=f)
+    for name, type, array, dir, value, personality in params:
+        print("    %s *%s_v;" % (valtypemap[type], to_c(name)), file=f)
+    for type, name, array, value in variables:
+        stars, bare = batch_var(name)
+        if array:
+            print("    %s %s(*%s_v)[%d];" % (type, stars, bare, array), file=f)
+        else:
+            print("    %s %s*%s_v;" % (type, stars, bare), file=f)
+    if options.get("data"):
+        print("    void *_data;", file=f)
+    print("};", file=f)
+    print("static struct __comp_batch __comp_b;", file=f)
+    print("static long __comp_next;", file=f)
+    print("", file=f)
+
+    print("static void *__comp_batch_zalloc(long sz) {", file=f)
+    print("    void *p = hal_malloc(sz);", file=f)
+    print("    if(p) memset(p, 0, sz);", file=f)
+    print("    return p;", file=f)
+    print("}", file=f)
+    if options.get("data"):
+        print("static int __comp_get_data_size(void);", file=f)
+    print("static int __comp_batch_alloc(long n) {", file=f)
+    print("    __comp_b.n = n;", file=f)
+    print("    if(n < 1) return 0;", file=f)
+    fields = []
+    for name, type, array, dir, value, personality in pins:
+        fields.append(("%s_p" % to_c(name), batch_len(array)))
+        fields.append(("%s_v" % to_c(name), batch_len(array)))
+    for name, type, array, dir, value, personality in params:
+        fields.append(("%s_v" % to_c(name), batch_len(array)))
+    for type, name, array, value in variables:
+        fields.append(("%s_v" % batch_var(name)[1], "n"))
+    for field, size in fields:
+        print("    __comp_b.%s = __comp_batch_zalloc(%s * sizeof(*__comp_b.%s));" % (field, size, field), file=f)
+        print("    if(!__comp_b.%s) return -ENOMEM;" % field, file=f)
+    if options.get("data"):
+        print("    __comp_b._data = __comp_batch_zalloc(n * __comp_get_data_size());", file=f)
+        print("    if(!__comp_b._data) return -ENOMEM;", file=f)
+    print("    return 0;", file=f)
+    print("}", file=f)
+    print("", file=f)
+
+    for name, fp in functions:
+        print("static void __comp_batch_%s(void *arg, long period);" % to_c(name), file=f)
+    print("static int __comp_batch_export(void) {", file=f)
+    print("    int r = 0;", file=f)
+    for name, fp in functions:
+        print("    r = hal_export_funct(\"%s\", __comp_batch_%s, &__comp_b, %s, 0, comp_id);" % (
+            batch_funct_name(name), to_c(name), int(fp)), file=f)
+        print("    if(r != 0) return r;", file=f)
+    print("    return r;", file=f)
+    print("}", file=f)
+
+def batch_export(f):
+    has_array = [1 for item in pins + params if item[2]] or \
+                [1 for item in variables if item[2] and item[3] is not None]
+    print("static int export(char *prefix, long extra_arg) {", file=f)
+    print("    (void)extra_arg;", file=f)
+    print("    int r = 0;", file=f)
+    if has_array:
+        print("    int j = 0;", file=f)
+    print("    long i = __comp_next, n = __comp_b.n;", file=f)
+    print("    if(i >= n) return -ENOSPC;", file=f)
+    if options.get("extra_setup"):
+        print("    r = extra_setup(i, prefix, extra_arg);", file=f)
+        print("    if(r != 0) return r;", file=f)
+    for name, type, array, dir, value, personality in pins:
+        if array:
+            print("    for(j=0; j < %d; j++) {" % batch_count(array), file=f)
+            print("        r = hal_pin_%s_newf(%s, &(__comp_b.%s_p[j * n + i]), comp_id," % (
+                type, dirmap[dir], to_c(name)), file=f)
+            print("            \"%%s%s\", prefix, j);" % to_hal("." + name), file=f)
+            print("        if(r != 0) return r;", file=f)
+            if value is not None:
+                print("        __comp_b.%s_v[j * n + i] = %s;" % (to_c(name), value), file=f)
+                print("        *(__comp_b.%s_p[j * n + i]) = __comp_b.%s_v[j * n + i];" % (to_c(name), to_c(name)), file=f)
+            print("    }", file=f)
+        else:
+            print("    r = hal_pin_%s_newf(%s, &(__comp_b.%s_p[i]), comp_id," % (
+                type, dirmap[dir], to_c(name)), file=f)
+            print("        \"%%s%s\", prefix);" % to_hal("." + name), file=f)
+            print("    if(r != 0) return r;", file=f)
+            if value is not None:
+                print("    __comp_b.%s_v[i] = %s;" % (to_c(name), value), file=f)
+                print("    *(__comp_b.%s_p[i]) = __comp_b.%s_v[i];" % (to_c(name), to_c(name)), file=f)
+    for name, type, array, dir, value, personality in params:
+        if array:
+            print("    for(j=0; j < %d; j++) {" % batch_count(array), file=f)
+            print("        r = hal_param_%s_newf(%s, &(__comp_b.%s_v[j * n + i]), comp_id," % (
+                type, dirmap[dir], to_c(name)), file=f)
+            print("            \"%%s%s\", prefix, j);" % to_hal("." + name), file=f)
+            print("        if(r != 0) return r;", file=f)
+            if value is not None:
+                print("        __comp_b.%s_v[j * n + i] = %s;" % (to_c(name), value), file=f)
+            print("    }", file=f)
+        else:
+            print("    r = hal_param_%s_newf(%s, &(__comp_b.%s_v[i]), comp_id," % (
+                type, dirmap[dir], to_c(name)), file=f)
+            print("        \"%%s%s\", prefix);" % to_hal("." + name), file=f)
+            print("    if(r != 0) return r;", file=f)
+            if value is not None:
+                print("    __comp_b.%s_v[i] = %s;" % (to_c(name), value), file=f)
+    for type, name, array, value in variables:
+        if value is None: continue
+        bare = batch_var(name)[1]
+        if array:
+            print("    for(j=0; j < %s; j++) {" % array, file=f)
+            print("        __comp_b.%s_v[i][j] = %s;" % (bare, value), file=f)
+            print("    }", file=f)
+        else:
+            print("    __comp_b.%s_v[i] = %s;" % (bare, value), file=f)
+    print("    __comp_next++;", file=f)
+    print("    return 0;", file=f)
+    print("}", file=f)
+
+def batch_defines(f):
+    print("#undef FUNCTION", file=f)
+    if options.get("period"):
+        print("#define FUNCTION(name) static inline void __comp_one_##name(long __comp_i, long period)", file=f)
+    else:
+        print("#define FUNCTION(name) static inline void __comp_one_##name(long __comp_i)", file=f)
+    print("#undef EXTRA_SETUP", file=f)
+    print("#define EXTRA_SETUP() static int extra_setup(long __comp_i, char *prefix, long extra_arg)", file=f)
+    print("#undef EXTRA_CLEANUP", file=f)
+    print("#define EXTRA_CLEANUP() static void extra_cleanup(void)", file=f)
+    if options.get("period"):
+        print("#undef fperiod", file=f)
+        print("#define fperiod (period * 1e-9)", file=f)
+    for name, type, array, dir, value, personality in pins + params:
+        # in pins are not assignable, params have dir r or rw
+        zero = "0+" if dir == 'in' else ""
+        print("#undef %s" % to_c(name), file=f)
+        if array:
+            print("#define %s(j) (%s__comp_b.%s_v[(j) * __comp_b.n + __comp_i])" % (to_c(name), zero, to_c(name)), file=f)
+        else:
+            print("#define %s (%s__comp_b.%s_v[__comp_i])" % (to_c(name), zero, to_c(name)), file=f)
+    for type, name, array, value in variables:
+        bare = batch_var(name)[1]
+        print("#undef %s" % bare, file=f)
+        print("#define %s (__comp_b.%s_v[__comp_i])" % (bare, bare), file=f)
+    if options.get("data"):
+        print("#undef data", file=f)
+        print("#define data (((%s*)__comp_b._data)[__comp_i])" % options['data'], file=f)
+
+# The rest of prologue() for 'option batched' components, which are never
+# userspace, constructable or personality components
+def batch_prologue(f):
+    names = {}
+    for name, type, array, dir, value, personality in pins + params:
+        names[name] = 1
+    batch_state(f)
+
+    print("", file=f)
+    for name, fp in functions:
+        if name in names:
+            Error("Duplicate item name: %s" % name)
+        names[name] = 1
+    if options.get("extra_setup"):
+        print("static int extra_setup(long __comp_i, char *prefix, long extra_arg);", file=f)
+    if options.get("extra_cleanup"):
+        print("static void extra_cleanup(void);", file=f)
+
+    if not options.get("no_convenience_defines"):
+        print("#undef TRUE", file=f)
+        print("#define TRUE (1)", file=f)
+        print("#undef FALSE", file=f)
+        print("#define FALSE (0)", file=f)
+        print("#undef true", file=f)
+        print("#define true (1)", file=f)
+        print("#undef false", file=f)
+        print("#define false (0)", file=f)
+
+    print("", file=f)
+    batch_export(f)
+
+    if options.get("count_function"):
+        print("static int get_count(void);", file=f)
+    elif not options.get("singleton"):
+        print("static int default_count=%s, count=0;" \
+            % options.get("default_count", 1), file=f)
+        print("RTAPI_MP_INT(count, \"number of %s\");" % comp_name, file=f)
+        print("char *names = \"\"; // comma separated names", file=f)
+        print("RTAPI_MP_STRING(names, \"names of %s\");" % comp_name, file=f)
+
+    # the arrays are allocated for all instances before the first export()
+    print("int rtapi_app_main(void) {", file=f)
+    print("    int r = 0;", file=f)
+    if not options.get("singleton"):
+        print("    int i;", file=f)
+    if options.get("count_function"):
+        print("    int count = get_count();", file=f)
+
+    print("    comp_id = hal_init(\"%s\");" % comp_name, file=f)
+    print("    if(comp_id < 0) return comp_id;", file=f)
+
+    if options.get("singleton"):
+        print("    r = __comp_batch_alloc(1);", file=f)
+        print("    if(r == 0) r = export(\"%s\", 0);" % \
+                to_hal(removeprefix(comp_name, "hal_")), file=f)
+    elif options.get("count_function"):
+        print("    r = __comp_batch_alloc(count);", file=f)
+        print("    for(i=0; r == 0 && i<count; i++) {", file=f)
+        print("        char buf[HAL_NAME_LEN + 1];", file=f)
+        print("        rtapi_snprintf(buf, sizeof(buf), " \
+                                    "\"%s.%%d\", i);" % \
+                to_hal(removeprefix(comp_name, "hal_")), file=f)
+        print("        r = export(buf, i);", file=f)
+        print("    }", file=f)
+    else:
+        print("    if(count && names[0]) {", file=f)
+        print("        rtapi_print_msg(RTAPI_MSG_ERR," \
+                        "\"count= and names= are mutually exclusive\\n\");", file=f)
+        print("        return -EINVAL;", file=f)
+        print("    }", file=f)
+        print("    if(!count && !names[0]) count = default_count;", file=f)
+        print("    if(count) {", file=f)
+        print("        r = __comp_batch_alloc(count);", file=f)
+        print("        for(i=0; r == 0 && i<count; i++) {", file=f)
+        print("            char buf[HAL_NAME_LEN + 1];", file=f)
+        print("            rtapi_snprintf(buf, sizeof(buf), " \
+                                    "\"%s.%%d\", i);" % \
+                to_hal(removeprefix(comp_name, "hal_")), file=f)
+        print("            r = export(buf, i);", file=f)
+        print("        }", file=f)
+        print("    } else {", file=f)
+        print("        size_t i, j;", file=f)
+        print("        int idx;", file=f)
+        print("        long n = 1;", file=f)
+        print("        char buf[HAL_NAME_LEN+1];", file=f)
+        print("        const size_t length = strlen(names);", file=f)
+        print("        for (i = 0; i < length; i++) if (names[i] == ',') n++;", file=f)
+        print("        r = __comp_batch_alloc(n);", file=f)
+        print("        for (i = j = idx = 0; r == 0 && i <= length; i++) {", file=f)
+        print("            const char c = buf[j] = names[i];", file=f)
+        print("            if ((c == ',') || (c == '\\0')) {", file=f)
+        print("                buf[j] = '\\0';", file=f)
+        print("                r = export(buf, idx);", file=f)
+        print("                idx++;", file=f)
+        print("                j = 0;", file=f)
+        print("            } else {", file=f)
+        print("                if (++j == (sizeof(buf) / sizeof(buf[0]))) {", file=f)
+        print("                    buf[j - 1] = '\\0';", file=f)
+        print("                    rtapi_print_msg(RTAPI_MSG_ERR,\"names: \\\"%s\\\" too long\\n\", buf);", file=f)
+        print("                    r = -EINVAL;", file=f)
+        print("                }", file=f)
+        print("            }", file=f)
+        print("        }", file=f)
+        print("    }", file=f)
+
+    print("    if(r == 0) r = __comp_batch_export();", file=f)
+    print("    if(r) {", file=f)
+    if options.get("extra_cleanup"):
+        print("    extra_cleanup();", file=f)
+    print("        hal_exit(comp_id);", file=f)
+    print("    } else {", file=f)
+    print("        hal_ready(comp_id);", file=f)
+    print("    }", file=f)
+    print("    return r;", file=f)
+    print("}", file=f)
+
+    print("", file=f)
+    print("void rtapi_app_exit(void) {", file=f)
+    if options.get("extra_cleanup"):
+        print("    extra_cleanup();", file=f)
+    print("    hal_exit(comp_id);", file=f)
+    print("}", file=f)
+
+    print("", file=f)
+    if not options.get("no_convenience_defines"):
+        batch_defines(f)
+    print("", file=f)
+    print("", file=f)
+
+def batch_epilogue(f):
+    data = options.get('data')
+    print("", file=f)
+    if data:
+        print("static int __comp_get_data_size(void) { return sizeof(%s); }" % data, file=f)
+    for name, fp in functions:
+        print("", file=f)
+        if options.get("period"):
+            call = "__comp_one_%s(__comp_i, period)" % to_c(name)
+        else:
+            call = "__comp_one_%s(__comp_i)" % to_c(name)
+        print("static void __comp_batch_%s(void *arg, long period) {" % to_c(name), file=f)
+        print("    long __comp_i, i, n = __comp_b.n;", file=f)
+        print("    (void)arg;", file=f)
+        if not options.get("period"):
+            print("    (void)period;", file=f)
+        for pname, type, array, dir, value, personality in pins:
+            if dir == 'out': continue
+            print("    for(i = 0; i < %s; i++) __comp_b.%s_v[i] = *(__comp_b.%s_p[i]);" % (
+                batch_len(array), to_c(pname), to_c(pname)), file=f)
+        print("#if defined(__GNUC__) && !defined(__clang__)", file=f)
+        print("#pragma GCC ivdep", file=f)
+        print("#endif", file=f)
+        print("    for(__comp_i = 0; __comp_i < n; __comp_i++) %s;" % call, file=f)
+        for pname, type, array, dir, value, personality in pins:
+            if dir == 'in': continue
+            print("    for(i = 0; i < %s; i++) *(__comp_b.%s_p[i]) = __comp_b.%s_v[i];" % (
+                batch_len(array), to_c(pname), to_c(pname)), file=f)
+        print("}", file=f)
+
 def prologue(f):
     print("/* Autogenerated by %s on %s -- do not edit */" % (
         sys.argv[0], time.asctime()), file=f)
@@ -330,6 +679,10 @@ static int comp_id;
             else: print(";", file=f)
             print("%s(%s, %s);" % (decl, name, q(doc)), file=f)
 
+    if options.get("batched"):
+        batch_prologue(f)
+        return
+
     print("", file=f)
     print("struct __comp_state {", file=f)
     print("    struct __comp_state *_next;", file=f)
@@ -788,6 +1141,9 @@ int __comp_parse_names(int *argc, char **argv) {
     print("", file=f)
 
 def epilogue(f):
+    if options.get("batched"):
+        batch_epilogue(f)
+        return
     data = options.get('data')
     print("", file=f)
     if data:
@@ -982,7 +1338,10 @@ def document(filename, outfilebase):
     if functions:
         print("\n== FUNCTIONS\n", file=f)
         for _, name, fp, doc in finddocs('funct'):
-            print("%s" % to_hal_man(name), end='', file=f)
+            if options.get("batched"):
+                print("**%s**" % batch_funct_name(name), end='', file=f)
+            else:
+                print("%s" % to_hal_man(name), end='', file=f)
             if fp:
                 print(" (requires a floating-point thread)::", file=f)
             else:
@@ -1131,6 +1490,8 @@ def process(filename, mode, outfilename):
                 raise SystemExit("Userspace components may not have functions")
         if not pins:
             raise SystemExit("Component must have at least one pin")
+        if options.get("batched"):
+            check_batched()
         prologue(f)
         lineno = a.count("\n") + 3
 
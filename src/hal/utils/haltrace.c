@@ -0,0 +1,489 @@
+/** This file, 'haltrace.c', is a program that controls the HAL trace
+    points and exports what they recorded.  See hal_trace.h for the
+    trace points themselves.
+
+    Invoking:
+
+    haltrace [status]
+    haltrace start
+    haltrace stop
+    haltrace clear
+    haltrace dump [-f json|ctf] [dest]
+
+    'start' and 'stop' turn recording on and off for all trace points.
+    'clear' forgets what was recorded so far.  'status' lists the event
+    names and the trace buffers of the realtime tasks.
+
+    'dump' copies the buffers and writes them out.  The default format,
+    'json', is the Trace Event format read by ui.perfetto.dev and
+    chrome://tracing; it goes to 'dest', or stdout if omitted.  With
+    'ctf', 'dest' is a directory that gets a Common Trace Format 1.8
+    trace, with one stream per task, for babeltrace or Trace Compass.
+
+    The buffers keep the last HAL_TRACE_EVENTS events of each task, so
+    a dump can be taken while recording.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to https://linuxcnc.org.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "hal_trace.h"		/* trace buffer layout */
+
+/***********************************************************************
+*                         GLOBAL VARIABLES                             *
+************************************************************************/
+
+static int comp_id = -1;	/* -1 means hal_init() not called yet */
+static int shmem_id = -1;
+static hal_trace_t *trace;
+
+/* a copy of the valid part of one buffer */
+typedef struct {
+    char name[HAL_NAME_LEN + 8];
+    int count;
+    hal_trace_event_t *events;
+} snapshot_t;
+
+static snapshot_t snap[HAL_TRACE_BUFS];
+
+/***********************************************************************
+*                         LOCAL FUNCTIONS                              *
+************************************************************************/
+
+static int attach(void)
+{
+    void *mem;
+
+    comp_id = hal_init("haltrace");
+    if (comp_id < 0) {
+	fprintf(stderr, "ERROR: hal_init() failed: %d\n", comp_id);
+	return -1;
+    }
+    hal_ready(comp_id);
+    shmem_id = rtapi_shmem_new(HAL_TRACE_KEY, comp_id, sizeof(hal_trace_t));
+    if (shmem_id < 0 || rtapi_shmem_getptr(shmem_id, &mem) < 0) {
+	fprintf(stderr, "ERROR: could not attach to trace buffers\n");
+	return -1;
+    }
+    trace = mem;
+    if (trace->version == 0) {
+	fprintf(stderr, "ERROR: HAL was built without tracing,"
+	    " see './configure --enable-hal-trace'\n");
+	return -1;
+    }
+    if (trace->version != HAL_TRACE_VERSION) {
+	fprintf(stderr, "ERROR: trace buffer version %d, expected %d\n",
+	    trace->version, HAL_TRACE_VERSION);
+	return -1;
+    }
+    return 0;
+}
+
+static void detach(void)
+{
+    if (shmem_id >= 0) {
+	rtapi_shmem_delete(shmem_id, comp_id);
+    }
+    if (comp_id >= 0) {
+	hal_exit(comp_id);
+    }
+}
+
+/* Copies the events of buffer 'n' that were not overwritten while
+   copying, see hal_trace_buf_t.head.  All arithmetic is on the
+   unsigned counters so it survives them wrapping. */
+static int take_snapshot(int n)
+{
+    hal_trace_buf_t *buf = &(trace->bufs[n]);
+    snapshot_t *s = &snap[n];
+    rtapi_u32 h1, h2, keep, moved, first, k;
+
+    snprintf(s->name, sizeof(s->name), "%s", buf->name);
+    s->count = 0;
+    h1 = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+    keep = h1 - buf->start;
+    if (keep > HAL_TRACE_EVENTS) {
+	keep = HAL_TRACE_EVENTS;
+    }
+    s->events = malloc(keep * sizeof(hal_trace_event_t) + 1);
+    if (s->events == 0) {
+	fprintf(stderr, "ERROR: out of memory\n");
+	return -1;
+    }
+    first = h1 - keep;
+    for (k = 0; k < keep; k++) {
+	s->events[k] = buf->events[(first + k) % HAL_TRACE_EVENTS];
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    h2 = __atomic_load_n(&buf->head, __ATOMIC_RELAXED);
+    /* the writer was at most 'moved' events ahead of h1, so the ones it
+       may have written over are the oldest 'moved + 1' of the ring */
+    moved = h2 - h1;
+    if (moved >= HAL_TRACE_EVENTS - 1) {
+	return 0;
+    }
+    if (keep > HAL_TRACE_EVENTS - 1 - moved) {
+	k = keep - (HAL_TRACE_EVENTS - 1 - moved);
+	memmove(s->events, s->events + k,
+	    (keep - k) * sizeof(hal_trace_event_t));
+	keep -= k;
+    }
+    s->count = keep;
+    return 0;
+}
+
+static int take_snapshots(void)
+{
+    int n;
+
+    for (n = 0; n < HAL_TRACE_BUFS; n++) {
+	if (take_snapshot(n) < 0) {
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+static const char *phase_name(int phase)
+{
+    switch (phase) {
+    case HAL_TRACE_PH_BEGIN:
+	return "begin";
+    case HAL_TRACE_PH_END:
+	return "end";
+    default:
+	return "instant";
+    }
+}
+
+static const char *event_name(int event)
+{
+    if (event <= 0 || event >= trace->nnames) {
+	return "?";
+    }
+    return trace->names[event];
+}
+
+static void json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+	if (*s == '"' || *s == '\\') {
+	    fputc('\\', f);
+	}
+	if ((unsigned char) *s >= ' ') {
+	    fputc(*s, f);
+	}
+    }
+    fputc('"', f);
+}
+
+/* Trace Event format, times in microseconds */
+static int dump_json(const char *dest)
+{
+    FILE *f = stdout;
+    const char *sep = "\n";
+    int n, k;
+
+    if (dest != 0 && (f = fopen(dest, "w")) == 0) {
+	fprintf(stderr, "ERROR: could not open '%s': %s\n", dest,
+	    strerror(errno));
+	return -1;
+    }
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (n = 0; n < HAL_TRACE_BUFS; n++) {
+	snapshot_t *s = &snap[n];
+	if (s->name[0] == '\0') {
+	    continue;
+	}
+	fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+	    "\"tid\":%d,\"args\":{\"name\":", sep, n + 1);
+	json_string(f, s->name);
+	fprintf(f, "}}");
+	sep = ",\n";
+	for (k = 0; k < s->count; k++) {
+	    hal_trace_event_t *ev = &(s->events[k]);
+	    fprintf(f, ",\n{\"name\":");
+	    json_string(f, event_name(ev->event));
+	    fprintf(f, ",\"ph\":\"%s\",\"ts\":%lld.%03lld,\"pid\":1,"
+		"\"tid\":%d,\"args\":{\"arg\":%ld}}",
+		ev->phase == HAL_TRACE_PH_BEGIN ? "B" :
+		ev->phase == HAL_TRACE_PH_END ? "E" : "i\",\"s\":\"t",
+		(long long) (ev->time / 1000), (long long) (ev->time % 1000),
+		n + 1, (long) ev->arg);
+	}
+    }
+    fprintf(f, "\n]}\n");
+    if (f != stdout && fclose(f) != 0) {
+	fprintf(stderr, "ERROR: could not write '%s'\n", dest);
+	return -1;
+    }
+    return 0;
+}
+
+/* Common Trace Format 1.8: a 'metadata' file describing the layout in
+   TSDL, and one stream file per buffer holding a single packet of
+   packed events in the byte order of this machine. */
+#define CTF_MAGIC 0xC1FC1FC1
+
+static FILE *ctf_open(const char *dir, const char *name)
+{
+    char path[PATH_MAX];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    f = fopen(path, "w");
+    if (f == 0) {
+	fprintf(stderr, "ERROR: could not open '%s': %s\n", path,
+	    strerror(errno));
+    }
+    return f;
+}
+
+static int dump_ctf(const char *dir)
+{
+    union { rtapi_u16 u; char c[2]; } order = { 1 };
+    char file[32];
+    FILE *f;
+    int n, k;
+
+    if (dir == 0) {
+	fprintf(stderr, "ERROR: 'dump -f ctf' needs a directory\n");
+	return -1;
+    }
+    if (mkdir(dir, 0777) < 0 && errno != EEXIST) {
+	fprintf(stderr, "ERROR: could not create '%s': %s\n", dir,
+	    strerror(errno));
+	return -1;
+    }
+    if ((f = ctf_open(dir, "metadata")) == 0) {
+	return -1;
+    }
+    fprintf(f, "/* CTF 1.8 */\n\n"
+	"typealias integer { size = 8; align = 8; signed = false; } := uint8_t;\n"
+	"typealias integer { size = 16; align = 8; signed = false; } := uint16_t;\n"
+	"typealias integer { size = 32; align = 8; signed = false; } := uint32_t;\n"
+	"typealias integer { size = 32; align = 8; signed = true; } := int32_t;\n\n"
+	"trace {\n"
+	"\tmajor = 1;\n"
+	"\tminor = 8;\n"
+	"\tbyte_order = %s;\n"
+	"\tpacket.header := struct {\n"
+	"\t\tuint32_t magic;\n"
+	"\t\tuint32_t stream_id;\n"
+	"\t};\n"
+	"};\n\n"
+	"env {\n"
+	"\tdomain = \"linuxcnc-hal\";\n",
+	order.c[0] ? "le" : "be");
+    for (n = 0; n < HAL_TRACE_BUFS; n++) {
+	if (snap[n].name[0] != '\0') {
+	    fprintf(f, "\ttask_%d = \"%s\";\n", n, snap[n].name);
+	}
+    }
+    fprintf(f, "};\n\n"
+	"clock {\n"
+	"\tname = rtapi;\n"
+	"\tdescription = \"rtapi_get_time()\";\n"
+	"\tfreq = 1000000000;\n"
+	"};\n\n"
+	"typealias integer {\n"
+	"\tsize = 64; align = 8; signed = false;\n"
+	"\tmap = clock.rtapi.value;\n"
+	"} := uint64_clock_t;\n\n"
+	"typealias enum : uint8_t { begin = %d, end = %d, instant = %d }"
+	" := phase_t;\n\n"
+	"stream {\n"
+	"\tid = 0;\n"
+	"\tpacket.context := struct {\n"
+	"\t\tuint32_t cpu_id;\n"
+	"\t};\n"
+	"\tevent.header := struct {\n"
+	"\t\tuint64_clock_t timestamp;\n"
+	"\t\tuint16_t id;\n"
+	"\t};\n"
+	"};\n",
+	HAL_TRACE_PH_BEGIN, HAL_TRACE_PH_END, HAL_TRACE_PH_INSTANT);
+    for (k = 1; k < trace->nnames; k++) {
+	fprintf(f, "\nevent {\n"
+	    "\tname = \"%s\";\n"
+	    "\tid = %d;\n"
+	    "\tstream_id = 0;\n"
+	    "\tfields := struct {\n"
+	    "\t\tphase_t phase;\n"
+	    "\t\tint32_t arg;\n"
+	    "\t};\n"
+	    "};\n", trace->names[k], k);
+    }
+    if (fclose(f) != 0) {
+	fprintf(stderr, "ERROR: could not write '%s/metadata'\n", dir);
+	return -1;
+    }
+    for (n = 0; n < HAL_TRACE_BUFS; n++) {
+	snapshot_t *s = &snap[n];
+	rtapi_u32 header[3] = { CTF_MAGIC, 0, n };
+	if (s->name[0] == '\0') {
+	    continue;
+	}
+	snprintf(file, sizeof(file), "stream_%d", n);
+	if ((f = ctf_open(dir, file)) == 0) {
+	    return -1;
+	}
+	fwrite(header, sizeof(header), 1, f);
+	for (k = 0; k < s->count; k++) {
+	    hal_trace_event_t *ev = &(s->events[k]);
+	    rtapi_u8 phase = ev->phase;
+	    fwrite(&ev->time, sizeof(ev->time), 1, f);
+	    fwrite(&ev->event, sizeof(ev->event), 1, f);
+	    fwrite(&phase, sizeof(phase), 1, f);
+	    fwrite(&ev->arg, sizeof(ev->arg), 1, f);
+	}
+	if (fclose(f) != 0) {
+	    fprintf(stderr, "ERROR: could not write '%s/%s'\n", dir, file);
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+static int do_dump(int argc, char **argv)
+{
+    const char *format = "json", *dest = 0;
+    int n;
+
+    for (n = 0; n < argc; n++) {
+	if (strcmp(argv[n], "-f") == 0 && n + 1 < argc) {
+	    format = argv[++n];
+	} else if (argv[n][0] == '-' || dest != 0) {
+	    fprintf(stderr, "ERROR: unexpected argument '%s'\n", argv[n]);
+	    return -1;
+	} else {
+	    dest = argv[n];
+	}
+    }
+    if (strcmp(format, "json") != 0 && strcmp(format, "ctf") != 0) {
+	fprintf(stderr, "ERROR: unknown format '%s'\n", format);
+	return -1;
+    }
+    if (take_snapshots() < 0) {
+	return -1;
+    }
+    if (strcmp(format, "ctf") == 0) {
+	return dump_ctf(dest);
+    }
+    return dump_json(dest);
+}
+
+static int do_status(void)
+{
+    int n, k;
+
+    if (take_snapshots() < 0) {
+	return -1;
+    }
+    printf("Tracing is %s\n", trace->enabled ? "on" : "off");
+    printf("\nEvents:\n");
+    for (k = 1; k < trace->nnames; k++) {
+	printf("  %3d  %s\n", k, trace->names[k]);
+    }
+    printf("\nBuffers:\n");
+    for (n = 0; n < HAL_TRACE_BUFS; n++) {
+	snapshot_t *s = &snap[n];
+	if (s->name[0] == '\0') {
+	    continue;
+	}
+	printf("  %2d  %-*s  %s  %6d events", n, HAL_NAME_LEN, s->name,
+	    trace->bufs[n].task_id < 0 ? "gone  " : "active", s->count);
+	if (s->count > 0) {
+	    hal_trace_event_t *ev = &(s->events[s->count - 1]);
+	    printf(", last %s %s", event_name(ev->event),
+		phase_name(ev->phase));
+	}
+	printf("\n");
+    }
+    return 0;
+}
+
+static void do_clear(void)
+{
+    int n;
+
+    for (n = 0; n < HAL_TRACE_BUFS; n++) {
+	trace->bufs[n].start =
+	    __atomic_load_n(&trace->bufs[n].head, __ATOMIC_ACQUIRE);
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+	"Usage: haltrace [status]\n"
+	"       haltrace start|stop|clear\n"
+	"       haltrace dump [-f json|ctf] [dest]\n");
+}
+
+/***********************************************************************
+*                            MAIN PROGRAM                              *
+************************************************************************/
+
+int main(int argc, char **argv)
+{
+    const char *cmd = argc > 1 ? argv[1] : "status";
+    int retval = 0;
+
+    if (strcmp(cmd, "status") != 0 && strcmp(cmd, "start") != 0
+	&& strcmp(cmd, "stop") != 0 && strcmp(cmd, "clear") != 0
+	&& strcmp(cmd, "dump") != 0) {
+	usage();
+	return 1;
+    }
+    if (attach() < 0) {
+	detach();
+	return 1;
+    }
+    if (strcmp(cmd, "start") == 0) {
+	trace->enabled = 1;
+    } else if (strcmp(cmd, "stop") == 0) {
+	trace->enabled = 0;
+    } else if (strcmp(cmd, "clear") == 0) {
+	do_clear();
+    } else if (strcmp(cmd, "dump") == 0) {
+	retval = do_dump(argc - 2, argv + 2);
+    } else {
+	retval = do_status();
+    }
+    detach();
+    return retval < 0 ? 1 : 0;
+}
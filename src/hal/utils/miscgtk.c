@@ -267,6 +267,16 @@ void set_file_filter(GtkFileChooser *chooser, const char *str, const char *ext)
     gtk_file_chooser_set_filter(GTK_FILE_CHOOSER(chooser), filter_spes);
 }
 
+void add_file_filter(GtkFileChooser *chooser, const char *str, const char *ext)
+{
+    GtkFileFilter *filter;
+
+    filter = gtk_file_filter_new();
+    gtk_file_filter_set_name(filter, str);
+    gtk_file_filter_add_pattern(filter, ext);
+    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(chooser), filter);
+}
+
 /***********************************************************************
 *                        LOCAL FUNCTION CODE                           *
 ************************************************************************/
@@ -106,4 +106,7 @@ void mark_selected_row(GtkWidget *list, const int row);
 /* Set a file filter for the open and save dialog boxes. */
 void set_file_filter(GtkFileChooser *chooser, const char *str, const char *ext);
 
+/* Add another file filter after set_file_filter(), without selecting it. */
+void add_file_filter(GtkFileChooser *chooser, const char *str, const char *ext);
+
 #endif /* MISCGTK_H */
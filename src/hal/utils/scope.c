@@ -68,6 +68,8 @@ scope_shm_control_t *ctrl_shm;	/* ptr to shared mem control struct */
 *                         LOCAL VARIABLES                              *
 ************************************************************************/
 
+#define STREAM_CHUNK 256	/* samples drained from the buffer at once */
+
 static int comp_id;		/* component ID */
 static int shm_id;		/* shared memory ID */
 static scope_usr_control_t ctrl_struct;	/* scope control structure */
@@ -79,6 +81,10 @@ static scope_usr_control_t ctrl_struct;	/* scope control structure */
 /* init functions */
 static void init_usr_control_struct(void *shmem);
 
+/* streaming */
+static int start_stream(void);
+static void set_data_offsets(void);
+
 static void define_scope_windows(void);
 static void init_run_mode_window(void);
 
@@ -91,6 +97,7 @@ static int heartbeat(gpointer data);
 static void rm_normal_button_clicked(GtkWidget * widget, gpointer * gdata);
 static void rm_single_button_clicked(GtkWidget * widget, gpointer * gdata);
 static void rm_roll_button_clicked(GtkWidget * widget, gpointer * gdata);
+static void rm_stream_button_clicked(GtkWidget * widget, gpointer * gdata);
 static void rm_stop_button_clicked(GtkWidget * widget, gpointer * gdata);
 
 static void exit_on_signal(int signum) {
@@ -136,6 +143,7 @@ int main(int argc, gchar * argv[])
 {
     int retval;
     int num_samples = SCOPE_NUM_SAMPLES_DEFAULT;
+    long stream_samples = SCOPE_REC_LEN_DEFAULT;
     char *ifilename = "autosave.halscope";
     char *ofilename = "autosave.halscope";
 
@@ -151,13 +159,13 @@ int main(int argc, gchar * argv[])
 
     while(1) {
         int c;
-        c = getopt(argc, argv, "hi:o:");
+        c = getopt(argc, argv, "hi:o:r:");
         if(c == -1) break;
         switch(c) {
          case 'h':
             rtapi_print_msg(RTAPI_MSG_ERR,
             _("Usage:\n  halscope [-h] [-i infile] [-o outfile]"
-            " [num_samples]\n"));
+            " [-r stream_samples] [num_samples]\n"));
             return -1;
             break;
          case 'i':
@@ -166,6 +174,15 @@ int main(int argc, gchar * argv[])
          case 'o':
             ofilename = optarg;
             break;
+         case 'r':
+            stream_samples = atol(optarg);
+            if (stream_samples < SCOPE_NUM_SAMPLES_MIN) {
+                rtapi_print_msg(RTAPI_MSG_ERR,
+                    "SCOPE: stream_samples must be at least %d\n",
+                    SCOPE_NUM_SAMPLES_MIN);
+                return -1;
+            }
+            break;
         }
     }
     /* first try to read samples from config file */
@@ -252,6 +269,7 @@ int main(int argc, gchar * argv[])
     }
     /* store requested samples for saving to config */
     ctrl_usr->horiz.requested_samples = num_samples;
+    ctrl_usr->rec_len = stream_samples;
 
     /* init watchdog */
     ctrl_shm->watchdog = 10;
@@ -325,6 +343,7 @@ static int heartbeat(gpointer data)
             gtk_window_set_urgency_hint(GTK_WINDOW(ctrl_usr->main_win), TRUE);
 	capture_complete();
     } else if (ctrl_usr->run_mode == ROLL) capture_cont();
+    else if (ctrl_usr->stream_timer) redraw_window();
     return 1;
 }
 
@@ -352,7 +371,7 @@ void start_capture(void)
 
         gtk_message_dialog_format_secondary_text(
             GTK_MESSAGE_DIALOG(dialog),
-            _("Starting acquisition will clear the data loaded from the CSV file. Continue?"));
+            _("Starting acquisition will clear the data loaded from the log file. Continue?"));
 
         int response = gtk_dialog_run(GTK_DIALOG(dialog));
         gtk_widget_destroy(dialog);
@@ -426,13 +445,157 @@ void start_capture(void)
 	}
     }
     ctrl_shm->pre_trig = (ctrl_shm->rec_len-2) * ctrl_usr->trig.position;
+    if (ctrl_usr->run_mode == STREAM) {
+	if (start_stream() < 0) {
+	    set_run_mode(STOP);
+	    return;
+	}
+    } else {
+	stop_stream();
+	/* the display shows the shared buffer again */
+	scope_rec_free(&ctrl_usr->rec);
+    }
+    ctrl_shm->stream = (ctrl_usr->run_mode == STREAM);
     ctrl_shm->state = INIT;
 }
 
-void capture_copy_data(void) {
+/* Moves the samples the RT code has streamed into the shared buffer
+   over to the recording.  The buffer is a ring that the RT code keeps
+   writing, so a chunk is copied out first and only kept if the RT code
+   did not get around to overwriting it meanwhile.
+*/
+static void stream_drain(void)
+{
+    static scope_data_t chunk[STREAM_CHUNK * 16];
+    scope_rec_t *rec = &ctrl_usr->rec;
+    int samp_len = ctrl_shm->sample_len;
+    long ring = ctrl_shm->buf_len / samp_len;
+    unsigned long avail, next, lost = 0;
+    long n;
+
+    next = ctrl_usr->stream_read;
+    avail = __atomic_load_n(&ctrl_shm->stream_samples,
+	__ATOMIC_ACQUIRE);
+    while (next != avail) {
+	if (avail - next >= (unsigned long)ring) {
+	    /* overwritten before we got to them */
+	    n = avail - next - ring + 1;
+	    lost += n;
+	    next += n;
+	    ctrl_usr->stream_slot = (ctrl_usr->stream_slot + n) % ring;
+	}
+	n = avail - next;
+	if (n > STREAM_CHUNK) {
+	    n = STREAM_CHUNK;
+	}
+	if (n > ring - ctrl_usr->stream_slot) {
+	    n = ring - ctrl_usr->stream_slot;
+	}
+	memcpy(chunk, ctrl_usr->buffer + ctrl_usr->stream_slot * samp_len,
+	    n * samp_len * sizeof(scope_data_t));
+	__sync_synchronize();
+	avail = __atomic_load_n(&ctrl_shm->stream_samples,
+	    __ATOMIC_ACQUIRE);
+	if (avail - next >= (unsigned long)ring) {
+	    /* the oldest one changed while we copied, try again */
+	    continue;
+	}
+	scope_rec_append(rec, chunk, samp_len, n);
+	next += n;
+	ctrl_usr->stream_slot += n;
+	if (ctrl_usr->stream_slot == ring) {
+	    ctrl_usr->stream_slot = 0;
+	}
+    }
+    ctrl_usr->stream_read = next;
+    if (lost > 0) {
+	/* keep the sample numbers right, the time axis depends on them */
+	rec->total += lost;
+	rec->lost += lost;
+	rtapi_print_msg(RTAPI_MSG_WARN,
+	    "SCOPE: %lu samples lost while streaming, "
+	    "increase num_samples\n", lost);
+    }
+}
+
+static int stream_timer_tick(gpointer data)
+{
+    (void)data;
+    stream_drain();
+    if (ctrl_usr->run_mode == STREAM) {
+	return TRUE;
+    }
+    /* stopped, from now on only the recorded samples are shown */
+    ctrl_usr->stream_timer = 0;
+    set_horiz_zoom(ctrl_usr->horiz.zoom_setting);
+    redraw_window();
+    return FALSE;
+}
+
+static int start_stream(void)
+{
+    hal_type_t type[16];
+    scope_rec_chan_t *rc;
+    int n, nchan, retval;
+
+    stop_stream();
+    scope_rec_free(&ctrl_usr->rec);
+    nchan = 0;
+    for (n = 0; n < 16; n++) {
+	if (ctrl_shm->data_len[n] > 0) {
+	    type[nchan++] = ctrl_shm->data_type[n];
+	}
+    }
+    if (nchan == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "SCOPE: no channels to stream\n");
+	return -1;
+    }
+    retval = scope_rec_create(&ctrl_usr->rec, ctrl_usr->rec_len, nchan,
+	type);
+    if (retval < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "SCOPE: ERROR: could not create a recording of %ld samples: %s\n",
+	    ctrl_usr->rec_len, strerror(-retval));
+	return -1;
+    }
+    /* the recording keeps what its channels are, in case they are
+       changed while it is shown */
+    nchan = 0;
+    for (n = 0; n < 16; n++) {
+	if (ctrl_shm->data_len[n] > 0) {
+	    rc = &ctrl_usr->rec.hdr->chan[nchan++];
+	    if (ctrl_usr->chan[n].name != NULL) {
+		snprintf(rc->name, sizeof(rc->name), "%s",
+		    ctrl_usr->chan[n].name);
+	    }
+	    rc->type = ctrl_shm->data_type[n];
+	    rc->scale_index = ctrl_usr->chan[n].scale_index;
+	    rc->position = ctrl_usr->chan[n].position;
+	}
+    }
+    set_data_offsets();
+    /* the RT code is idle, so the old count can't be mistaken for new data */
+    __atomic_store_n(&ctrl_shm->stream_samples, 0, __ATOMIC_RELAXED);
+    ctrl_usr->stream_read = 0;
+    ctrl_usr->stream_slot = 0;
+    ctrl_usr->stream_timer = g_timeout_add(20, stream_timer_tick, NULL);
+    set_horiz_zoom(ctrl_usr->horiz.zoom_setting);
+    return 0;
+}
+
+void stop_stream(void)
+{
+    if (ctrl_usr->stream_timer) {
+	g_source_remove(ctrl_usr->stream_timer);
+	ctrl_usr->stream_timer = 0;
+    }
+}
+
+/* records where each acquired channel is within a sample */
+static void set_data_offsets(void)
+{
     int n, offs;
-    scope_data_t *src, *dst, *src_end;
-    int samp_len, samp_size;
 
     offs = 0;
     for (n = 0; n < 16; n++) {
@@ -445,6 +608,14 @@ void capture_copy_data(void) {
 	    ctrl_usr->vert.data_offset[n] = -1;
 	}
     }
+}
+
+void capture_copy_data(void) {
+    int n;
+    scope_data_t *src, *dst, *src_end;
+    int samp_len, samp_size;
+
+    set_data_offsets();
     /* copy data from shared buffer to display buffer */
     ctrl_usr->samples = ctrl_shm->samples;
     samp_len = ctrl_shm->sample_len;
@@ -553,6 +724,7 @@ void open_log_cb(GtkWindow *parent)
 
     chooser = GTK_FILE_CHOOSER(filew);
     set_file_filter(chooser, "Text CSV (.csv)", "*.csv");
+    add_file_filter(chooser, "Binary (.hsd)", "*.hsd");
 
     if (gtk_dialog_run(GTK_DIALOG(filew)) == GTK_RESPONSE_ACCEPT) {
         char *filename = gtk_file_chooser_get_filename(chooser);
@@ -815,6 +987,8 @@ static void init_run_mode_window(void)
             GTK_RADIO_BUTTON(ctrl_usr->rm_stop_button), _("Single"));
     ctrl_usr->rm_roll_button = gtk_radio_button_new_with_label_from_widget(
             GTK_RADIO_BUTTON(ctrl_usr->rm_stop_button), _("Roll"));
+    ctrl_usr->rm_stream_button = gtk_radio_button_new_with_label_from_widget(
+            GTK_RADIO_BUTTON(ctrl_usr->rm_stop_button), _("Stream"));
     /* now put them into the box */
     gtk_box_pack_start(GTK_BOX(ctrl_usr->run_mode_win),
 	ctrl_usr->rm_normal_button, FALSE, FALSE, 0);
@@ -822,6 +996,8 @@ static void init_run_mode_window(void)
 	ctrl_usr->rm_single_button, FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(ctrl_usr->run_mode_win),
 	ctrl_usr->rm_roll_button, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(ctrl_usr->run_mode_win),
+	ctrl_usr->rm_stream_button, FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(ctrl_usr->run_mode_win),
 	ctrl_usr->rm_stop_button, FALSE, FALSE, 0);
     /* hook callbacks to buttons */
@@ -831,12 +1007,15 @@ static void init_run_mode_window(void)
             G_CALLBACK(rm_single_button_clicked), NULL);
     g_signal_connect(ctrl_usr->rm_roll_button, "clicked",
             G_CALLBACK(rm_roll_button_clicked), NULL);
+    g_signal_connect(ctrl_usr->rm_stream_button, "clicked",
+            G_CALLBACK(rm_stream_button_clicked), NULL);
     g_signal_connect(ctrl_usr->rm_stop_button, "clicked",
             G_CALLBACK(rm_stop_button_clicked), NULL);
     /* and make them visible */
     gtk_widget_show(ctrl_usr->rm_normal_button);
     gtk_widget_show(ctrl_usr->rm_single_button);
     gtk_widget_show(ctrl_usr->rm_roll_button);
+    gtk_widget_show(ctrl_usr->rm_stream_button);
     gtk_widget_show(ctrl_usr->rm_stop_button);
 }
 
@@ -906,6 +1085,9 @@ int set_run_mode(int mode)
 	/* roll mode */
 	button = ctrl_usr->rm_roll_button;
 #endif
+    } else if ( mode == 4 ) {
+	/* streaming mode */
+	button = ctrl_usr->rm_stream_button;
     } else {
 	/* illegal mode */
 	return -1;
@@ -924,6 +1106,9 @@ static void rm_normal_button_clicked(GtkWidget * widget, gpointer * gdata)
     ctrl_usr->run_mode = NORMAL;
     if (ctrl_shm->state == IDLE) {
 	start_capture();
+    } else if (ctrl_shm->state == STREAMING) {
+	/* streaming never completes, start over */
+	prepare_scope_restart();
     }
 }
 
@@ -937,6 +1122,9 @@ static void rm_single_button_clicked(GtkWidget * widget, gpointer * gdata)
     ctrl_usr->run_mode = SINGLE;
     if (ctrl_shm->state == IDLE) {
 	start_capture();
+    } else if (ctrl_shm->state == STREAMING) {
+	/* streaming never completes, start over */
+	prepare_scope_restart();
     }
 }
 
@@ -950,6 +1138,25 @@ static void rm_roll_button_clicked(GtkWidget * widget, gpointer * gdata)
     ctrl_usr->run_mode = ROLL;
     if (ctrl_shm->state == IDLE) {
 	start_capture();
+    } else if (ctrl_shm->state == STREAMING) {
+	/* streaming never completes, start over */
+	prepare_scope_restart();
+    }
+}
+
+static void rm_stream_button_clicked(GtkWidget * widget, gpointer * gdata)
+{
+    (void)gdata;
+    if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget)) != TRUE) {
+	/* not pressed, ignore it */
+	return;
+    }
+    ctrl_usr->run_mode = STREAM;
+    if (ctrl_shm->state == IDLE) {
+	start_capture();
+    } else {
+	/* abandon the triggered capture */
+	prepare_scope_restart();
     }
 }
 
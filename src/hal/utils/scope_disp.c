@@ -65,6 +65,8 @@ static void update_readout(void);
 static void draw_grid(void);
 static void draw_baseline(int chan_num, int highlight);
 static void draw_waveform(int chan_num, int highlight);
+static void draw_waveform_minmax(int chan_num, int highlight);
+static void draw_waveform_label(int chan_num, int y);
 static void draw_triggerline(int chan_num, int highlight);
 static int handle_click(GtkWidget *widget, GdkEventButton *event, gpointer data);
 static int handle_release(GtkWidget *widget, GdkEventButton *event, gpointer data);
@@ -140,6 +142,43 @@ void redraw_window(void)
     gtk_widget_queue_draw(disp->drawing);
 }
 
+/* Returns the number of samples the display spans: the shared buffer,
+   or the recording when there is one.  While streaming that is the
+   whole ring, so the display does not rescale as it fills up.
+*/
+long disp_rec_len(void)
+{
+    if (ctrl_usr->rec.hdr == NULL) {
+	return ctrl_shm->rec_len;
+    }
+    if (ctrl_usr->stream_timer) {
+	return ctrl_usr->rec.len;
+    }
+    return ctrl_usr->rec.count;
+}
+
+/* returns sample n of the channel at 'offset' within each sample */
+static scope_data_t *disp_sample(int offset, long n)
+{
+    if (ctrl_usr->rec.hdr) {
+	return scope_rec_sample(&ctrl_usr->rec, n) + offset;
+    }
+    return ctrl_usr->disp_buf + n * ctrl_shm->sample_len + offset;
+}
+
+/* returns the time of sample n, relative to the trigger */
+static double disp_sample_time(long n)
+{
+    scope_rec_t *rec = &(ctrl_usr->rec);
+
+    if (rec->hdr) {
+	/* no trigger, relative to the start of the recording */
+	return (double)(rec->total - rec->count + n)
+	    * ctrl_usr->horiz.sample_period;
+    }
+    return (n - ctrl_shm->pre_trig) * ctrl_usr->horiz.sample_period;
+}
+
 static int motion_x = -1, motion_y = -1;
 
 static void calculate_offset(int chan_num) {
@@ -153,6 +192,18 @@ static void calculate_offset(int chan_num) {
 
     if(!chan->ac_offset) return;
 
+    if (ctrl_usr->rec.hdr) {
+	/* the recording keeps a running sum */
+	scope_rec_t *rec = &(ctrl_usr->rec);
+	if (rec->count == 0) {
+	    chan->vert_offset = 0;
+	} else {
+	    chan->vert_offset =
+		rec->sum[ctrl_usr->vert.data_offset[chan_num]] / rec->count;
+	}
+	return;
+    }
+
     for(n=0; n < ctrl_usr->samples; n++) {
 	switch (type) {
 	case HAL_BIT:
@@ -204,7 +255,7 @@ void refresh_display(void)
     pixels_per_div = disp->width * 0.1;
     pixels_per_sec = pixels_per_div / horiz->disp_scale;
     disp->pixels_per_sample = pixels_per_sec * horiz->sample_period;
-    overall_record_length = horiz->sample_period * ctrl_shm->rec_len;
+    overall_record_length = horiz->sample_period * disp_rec_len();
     screen_center_time = overall_record_length * horiz->pos_setting;
     screen_start_time = screen_center_time - (5.0 * horiz->disp_scale);
     disp->horiz_offset = screen_start_time * pixels_per_sec;
@@ -214,9 +265,12 @@ void refresh_display(void)
     }
     screen_end_time = screen_center_time + (5.0 * horiz->disp_scale);
     disp->end_sample = (screen_end_time / horiz->sample_period) + 1;
-    if (disp->end_sample > ctrl_shm->rec_len - 1) {
+    if (disp->end_sample > ctrl_shm->rec_len - 1 && !ctrl_usr->rec.hdr) {
 	disp->end_sample = ctrl_shm->rec_len - 1;
     }
+    if (disp->end_sample > ctrl_usr->rec.count - 1 && ctrl_usr->rec.hdr) {
+	disp->end_sample = ctrl_usr->rec.count - 1;
+    }
 
     DRAWING = 1;
     clear_display_window();
@@ -494,9 +548,9 @@ static void change_zoom(int dir, int x) {
 
     // how many samples away from the center of the window is this
     // pixel?
-    old_fraction = (x - disp->width / 2) / old_pixels_per_sample / ctrl_shm->rec_len;
+    old_fraction = (x - disp->width / 2) / old_pixels_per_sample / disp_rec_len();
     // and new?
-    new_fraction = (x - disp->width / 2) / new_pixels_per_sample / ctrl_shm->rec_len;
+    new_fraction = (x - disp->width / 2) / new_pixels_per_sample / disp_rec_len();
     // displace by the difference
     set_horiz_pos( horiz->pos_setting - new_fraction + old_fraction );
 }
@@ -549,7 +603,7 @@ static int handle_scroll(GtkWidget *widget, GdkEventScroll *event, gpointer data
 static void middle_drag(int dx) {
     scope_disp_t *disp = &(ctrl_usr->disp);
     scope_horiz_t *horiz = &(ctrl_usr->horiz);
-    double dt = (dx / disp->pixels_per_sample) / ctrl_shm->rec_len;
+    double dt = (dx / disp->pixels_per_sample) / disp_rec_len();
     set_horiz_pos(horiz->pos_setting + 5 * dt);
     redraw_window();
 }
@@ -774,11 +828,15 @@ void draw_waveform(int chan_num, int highlight)
     hal_type_t type;
     int x1, y1, x2, y2, miny, maxy, midx, ct, pn;
     int first=1;
-    scope_horiz_t *horiz = &(ctrl_usr->horiz);
 
     cursor_valid = 0;
     disp = &(ctrl_usr->disp);
     chan = &(ctrl_usr->chan[chan_num - 1]);
+    if (ctrl_usr->rec.hdr && disp->pixels_per_sample < 0.5) {
+	/* too many samples to draw them all */
+	draw_waveform_minmax(chan_num, highlight);
+	return;
+    }
     /* calculate a bunch of local vars */
     sample_len = ctrl_shm->sample_len;
     xscale = disp->pixels_per_sample;
@@ -789,16 +847,18 @@ void draw_waveform(int chan_num, int highlight)
     yscale = disp->height / (-10.0 * chan->scale);
     yfoffset = chan->vert_offset;
     ypoffset = chan->position * disp->height;
-    /* point to first sample in the record for this channel */
-    dptr = ctrl_usr->disp_buf + ctrl_usr->vert.data_offset[chan_num - 1];
     /* point to first one that gets displayed */
     start = disp->start_sample;
     end = disp->end_sample;
+    if (end < start) {
+	/* nothing recorded yet */
+	return;
+    }
     ct = end - start + 1;
     GdkPoint points[2*ct];
     pn = 0;
     n = start;
-    dptr += n * sample_len;
+    dptr = disp_sample(ctrl_usr->vert.data_offset[chan_num - 1], n);
 
 
     /* set color to draw */
@@ -877,7 +937,7 @@ void draw_waveform(int chan_num, int highlight)
 
                     cursor_prev_value = prev_fy;
                     cursor_value = fy;
-                    cursor_time = (n - ctrl_shm->pre_trig)*horiz->sample_period;
+                    cursor_time = disp_sample_time(n);
                     cursor_valid = 1;
 	    }
 	}
@@ -886,41 +946,151 @@ void draw_waveform(int chan_num, int highlight)
 	y1 = y2;
 
 	/* point to next sample */
-	dptr += sample_len;
+	if (ctrl_usr->rec.hdr) {
+	    dptr = disp_sample(ctrl_usr->vert.data_offset[chan_num - 1],
+		n + 1);
+	} else {
+	    dptr += sample_len;
+	}
 	n++;
         prev_fy = fy;
     }
     if(pn) {
         lines(chan_num, points, pn);
         if(DRAWING) {
-            PangoLayout *p;
-            int y = points[0].y;
-            char scale[HAL_NAME_LEN];
-            char buffer[2 * HAL_NAME_LEN];
-            int h;
-            PangoRectangle r;
-
-            format_scale_value(scale, sizeof(scale), chan->scale);
-            snprintf(buffer, sizeof(buffer), "%s\n%s", chan->name, scale);
-            p=gtk_widget_create_pango_layout(disp->drawing, buffer);
-            pango_layout_get_extents(p, NULL, &r);
-            h = PANGO_PIXELS(r.height);
-
-            if(y < 0 || y+h > disp->height)
-                // if the first sample isn't visible, try the zero value
-                y = (0-yfoffset) * yscale + ypoffset;
-            if(y < 0 || y+h > disp->height)
-                // if that's not visible either, try the offset value
-                y = ypoffset;
-
-            conflict_avoid(&y, h);
-            cairo_move_to(disp->context, 5, y);
-            pango_cairo_show_layout(disp->context, p);
-            g_object_unref(p);
+            draw_waveform_label(chan_num, points[0].y);
         }
     }
 }
 
+/* Draws a recording zoomed out to more than two samples per pixel.
+   Each column gets a vertical line from the smallest to the largest
+   sample it covers, which the recording looks up in its pyramids, so
+   this takes the same time no matter how many samples are shown.
+*/
+static void draw_waveform_minmax(int chan_num, int highlight)
+{
+    scope_rec_t *rec = &(ctrl_usr->rec);
+    scope_disp_t *disp = &(ctrl_usr->disp);
+    scope_chan_t *chan = &(ctrl_usr->chan[chan_num - 1]);
+    int offset = ctrl_usr->vert.data_offset[chan_num - 1];
+    double xscale, xoffset, yscale, yfoffset, ypoffset, min, max;
+    long start, end, s0, s1;
+    int x, x0, x1, ymin, ymax, miny, maxy, pn;
+    int first = 1;
+    GdkPoint *points;
+
+    xscale = disp->pixels_per_sample;
+    xoffset = disp->horiz_offset;
+    miny = -disp->height;
+    maxy = 2 * disp->height;
+    yscale = disp->height / (-10.0 * chan->scale);
+    yfoffset = chan->vert_offset;
+    ypoffset = chan->position * disp->height;
+    start = disp->start_sample;
+    end = disp->end_sample;
+    if (end < start) {
+	return;
+    }
+    x0 = floor(start * xscale - xoffset);
+    x1 = floor(end * xscale - xoffset);
+    if (x0 < 0) {
+	x0 = 0;
+    }
+    if (x1 > disp->width) {
+	x1 = disp->width;
+    }
+    if (x1 < x0) {
+	return;
+    }
+    points = g_new(GdkPoint, 2 * (x1 - x0 + 1));
+    pn = 0;
+
+    if (highlight) {
+        gdk_cairo_set_source_rgba(disp->context, &disp->color_selected[chan_num - 1]);
+    } else {
+        gdk_cairo_set_source_rgba(disp->context, &disp->color_normal[chan_num - 1]);
+    }
+
+    s0 = ceil((x0 + xoffset) / xscale);
+    if (s0 < start) {
+	s0 = start;
+    }
+    for (x = x0; x <= x1 && s0 <= end; x++, s0 = s1 + 1) {
+	/* samples that land in this column */
+	s1 = ceil((x + 1 + xoffset) / xscale) - 1;
+	if (s1 > end) {
+	    s1 = end;
+	}
+	if (s1 < s0) {
+	    continue;
+	}
+	scope_rec_minmax(rec, offset, s0, s1 + 1, &min, &max);
+	ymax = ((max - yfoffset) * yscale) + ypoffset;
+	ymin = ((min - yfoffset) * yscale) + ypoffset;
+	ymax = ymax < miny ? miny : ymax > maxy ? maxy : ymax;
+	ymin = ymin < miny ? miny : ymin > maxy ? maxy : ymin;
+	points[pn].x = x; points[pn].y = ymax; pn++;
+	if (ymin != ymax) {
+	    points[pn].x = x; points[pn].y = ymin; pn++;
+	}
+	if (first && highlight && DRAWING && x >= motion_x) {
+	    first = 0;
+	    cursor_value = scope_rec_value(scope_rec_sample(rec, s0) + offset,
+		chan->data_type);
+	    cursor_prev_value = s0 > 0 ? scope_rec_value(
+		scope_rec_sample(rec, s0 - 1) + offset, chan->data_type)
+		: cursor_value;
+	    cursor_time = disp_sample_time(s0);
+	    cursor_valid = 1;
+	    cairo_arc(disp->context, x,
+		((cursor_value - yfoffset) * yscale) + ypoffset,
+		5, 0.0, 2.0 * M_PI);
+	    cairo_fill(disp->context);
+	}
+    }
+    if (pn > 1) {
+	lines(chan_num, points, pn);
+	if (DRAWING) {
+	    draw_waveform_label(chan_num, points[0].y);
+	}
+    }
+    g_free(points);
+}
+
+/* draws the name and scale of a channel next to its waveform */
+static void draw_waveform_label(int chan_num, int y)
+{
+    scope_disp_t *disp = &(ctrl_usr->disp);
+    scope_chan_t *chan = &(ctrl_usr->chan[chan_num - 1]);
+    double yscale = disp->height / (-10.0 * chan->scale);
+    double yfoffset = chan->vert_offset;
+    double ypoffset = chan->position * disp->height;
+    PangoLayout *p;
+    char scale[HAL_NAME_LEN];
+    char buffer[2 * HAL_NAME_LEN];
+    int h;
+    PangoRectangle r;
+
+    format_scale_value(scale, sizeof(scale), chan->scale);
+    snprintf(buffer, sizeof(buffer), "%s\n%s", chan->name, scale);
+    p=gtk_widget_create_pango_layout(disp->drawing, buffer);
+    pango_layout_get_extents(p, NULL, &r);
+    h = PANGO_PIXELS(r.height);
+
+    if(y < 0 || y+h > disp->height)
+        // if the first sample isn't visible, try the zero value
+        y = (0-yfoffset) * yscale + ypoffset;
+    if(y < 0 || y+h > disp->height)
+        // if that's not visible either, try the offset value
+        y = ypoffset;
+
+    conflict_avoid(&y, h);
+    cairo_move_to(disp->context, 5, y);
+    pango_cairo_show_layout(disp->context, p);
+    g_object_unref(p);
+}
+
 static int ch=0;
 // X limits all windows to 16-bit heights, so this static array will be OK
 static char conflict_map[32768];
@@ -65,7 +65,7 @@
    THREAD <string>	name of thread to sample in
    MAXCHAN <int>	1,2,4,8,16, maximum channel count (ignored, kept for compatibility)
    HMULT <int>		multiplier, sample every N runs of thread
-   HZOOM <int>		1-9, horizontal zoom setting
+   HZOOM <int>		1-18, horizontal zoom setting
    HPOS <float>		0.0-1.0, horizontal position setting
    CHAN <int>		sets channel for subsequent commands
    PIN <string>		named pin becomes source for channel
@@ -81,7 +81,8 @@
    TPOS <float>		0.0-1.0, trigger position setting
    TPOLAR <enum>	trigger polarity, RISE or FALL
    TMODE <int>		0 = normal trigger, 1 = auto trigger
-   RMODE <int>		0 = stop, 1 = norm, 2 = single, 3 = roll
+   RMODE <int>		0 = stop, 1 = norm, 2 = single, 3 = roll,
+			4 = stream
 
 */
 
@@ -114,6 +115,13 @@ typedef struct {
 ************************************************************************/
 
 static void write_sample(FILE *fp, scope_data_t *dptr, hal_type_t type);
+static int is_binary_log(const char *filename);
+static void write_log_binary(char *filename);
+static void read_log_binary(char *filename);
+static void rec_channels(scope_rec_chan_t *chan);
+static void setup_log_channel(int i, const char *name, hal_type_t type,
+    const char *tag, double position, int scale_index);
+static void set_log_sample_period(long sample_period_ns);
 static int parse_command(char *in);
 /* the following functions implement halscope config items
    each is called with a pointer to a single argument (the parser
@@ -230,6 +238,8 @@ void write_config_file (char *filename)
 	fprintf(fp, "RMODE 1\n" );
     } else if ( ctrl_usr->run_mode == SINGLE ) {
 	fprintf(fp, "RMODE 2\n" );
+    } else if ( ctrl_usr->run_mode == STREAM ) {
+	fprintf(fp, "RMODE 4\n" );
 #if 0 /* FIXME - role mode not implemented yet */
     } else if ( ctrl_usr->run_mode == ROLL ) {
 	fprintf(fp, "RMODE 3\n" );
@@ -249,29 +259,50 @@ void write_log_file(char *filename)
     scope_data_t *dptr, *start;
     scope_horiz_t *horiz;
     scope_vert_t *vert;
+    scope_rec_chan_t rchan[16];
     hal_type_t type[16];
+    double position[16];
+    int scale_index[16];
 
     char *label[16] = {};
     char *old_locale, *saved_locale;
-    int sample_len, chan_active, chan_num, sample_period_ns, samples, n;
+    int sample_len, sep_len, chan_active, chan_num, sample_period_ns, samples, n;
     FILE *fp;
 
+    if (is_binary_log(filename)) {
+	write_log_binary(filename);
+	return;
+    }
     fp = fopen(filename, "w");
     if (fp == NULL) {
         fprintf(stderr, "ERROR: log file '%s' could not be created\n", filename);
         return;
     }
 
-    /* Get name and type of active channels. */
+    /* Get name and type of active channels.  A recording holds just the
+       channels it was made with, whatever is enabled now. */
     chan_active = 0;
     vert = &(ctrl_usr->vert);
-    for (chan_num = 0; chan_num < 16; chan_num++) {
-        if (vert->chan_enabled[chan_num] == 1) {
-            chan = &(ctrl_usr->chan[chan_num]);
-            label[chan_active] = chan->name;
-            type[chan_active] = chan->data_type;
+    if (ctrl_usr->rec.hdr) {
+        rec_channels(rchan);
+        for (chan_num = 0; chan_num < ctrl_usr->rec.nchan; chan_num++) {
+            label[chan_active] = rchan[chan_num].name;
+            type[chan_active] = ctrl_usr->rec.type[chan_num];
+            position[chan_active] = rchan[chan_num].position;
+            scale_index[chan_active] = rchan[chan_num].scale_index;
             chan_active++;
         }
+    } else {
+        for (chan_num = 0; chan_num < 16; chan_num++) {
+            if (vert->chan_enabled[chan_num] == 1) {
+                chan = &(ctrl_usr->chan[chan_num]);
+                label[chan_active] = chan->name;
+                type[chan_active] = chan->data_type;
+                position[chan_active] = chan->position;
+                scale_index[chan_active] = chan->scale_index;
+                chan_active++;
+            }
+        }
     }
 
     /* sample_len is really the number of channels, don't let it fool you */
@@ -296,32 +327,25 @@ void write_log_file(char *filename)
     }
     fprintf(fp, "\n");
 
+    /* separators follow all but the last of the channels in a sample */
+    sep_len = ctrl_usr->rec.hdr ? chan_active : sample_len;
+
     /* write channel positions */
     fprintf(fp, "# Position: ");
-    chan_active = 0;
-    for (chan_num = 0; chan_num < 16; chan_num++) {
-        if (vert->chan_enabled[chan_num] == 1) {
-            chan = &(ctrl_usr->chan[chan_num]);
-            fprintf(fp, "%.6f", chan->position);
-            chan_active++;
-            if (chan_active < sample_len) {
-                fprintf(fp, ";");
-            }
+    for (chan_num = 0; chan_num < chan_active; chan_num++) {
+        fprintf(fp, "%.6f", position[chan_num]);
+        if (chan_num + 1 < sep_len) {
+            fprintf(fp, ";");
         }
     }
     fprintf(fp, "\n");
 
     /* write channel scale indices */
     fprintf(fp, "# Scale: ");
-    chan_active = 0;
-    for (chan_num = 0; chan_num < 16; chan_num++) {
-        if (vert->chan_enabled[chan_num] == 1) {
-            chan = &(ctrl_usr->chan[chan_num]);
-            fprintf(fp, "%d", chan->scale_index);
-            chan_active++;
-            if (chan_active < sample_len) {
-                fprintf(fp, ";");
-            }
+    for (chan_num = 0; chan_num < chan_active; chan_num++) {
+        fprintf(fp, "%d", scale_index[chan_num]);
+        if (chan_num + 1 < sep_len) {
+            fprintf(fp, ";");
         }
     }
     fprintf(fp, "\n");
@@ -343,6 +367,17 @@ void write_log_file(char *filename)
     }
     setlocale(LC_NUMERIC, "C");
 
+    if (ctrl_usr->rec.hdr) {
+	/* a recording holds just the acquired channels */
+	samples = 0;
+	for (n = 0; n < ctrl_usr->rec.count; n++) {
+	    start = scope_rec_sample(&ctrl_usr->rec, n);
+	    for (chan_num = 0; chan_num < chan_active; chan_num++) {
+		write_sample(fp, start + chan_num, type[chan_num]);
+		fprintf(fp, chan_num < chan_active - 1 ? ";" : "\n");
+	    }
+	}
+    }
     n = 0;
     while (n < samples) {
         for (chan_num = 0; chan_num < sample_len; chan_num++) {
@@ -373,8 +408,6 @@ void write_log_file(char *filename)
 /* reads captured data from disk and loads it into display buffer */
 void read_log_file(char *filename)
 {
-    scope_chan_t *chan;
-    scope_horiz_t *horiz;
     scope_vert_t *vert;
 
     char line[16384];  /* buffer for reading lines */
@@ -383,8 +416,6 @@ void read_log_file(char *filename)
     hal_type_t channel_types[16];
     double channel_positions[16];
     int channel_scales[16];
-    int has_position_config = 0;
-    int has_scale_config = 0;
     int channel_count = 0;
     int sample_period_ns = 0;
     int sample_count = 0;
@@ -394,6 +425,10 @@ void read_log_file(char *filename)
     int i;
     scope_data_t *dptr;
 
+    if (is_binary_log(filename)) {
+	read_log_binary(filename);
+	return;
+    }
     /* Open file */
     fp = fopen(filename, "r");
     if (fp == NULL) {
@@ -469,9 +504,7 @@ void read_log_file(char *filename)
             token = strtok(pos_start, ";");
             i = 0;
             while (token != NULL && i < channel_count) {
-                if (sscanf(token, "%lf", &channel_positions[i]) == 1) {
-                    has_position_config = 1;
-                }
+                sscanf(token, "%lf", &channel_positions[i]);
                 i++;
                 token = strtok(NULL, ";");
             }
@@ -487,9 +520,7 @@ void read_log_file(char *filename)
                     token = strtok(scale_start, ";");
                     i = 0;
                     while (token != NULL && i < channel_count) {
-                        if (sscanf(token, "%d", &channel_scales[i]) == 1) {
-                            has_scale_config = 1;
-                        }
+                        sscanf(token, "%d", &channel_scales[i]);
                         i++;
                         token = strtok(NULL, ";");
                     }
@@ -561,143 +592,14 @@ void read_log_file(char *filename)
         ctrl_usr->chan[i].is_phantom = 0;
     }
 
-    for (i = 0; i < channel_count; i++) {
-        chan = &(ctrl_usr->chan[i]);
-        int matched = 0;
-
-        /* Try to find matching HAL pin */
-        hal_pin_t *pin = halpr_find_pin_by_name(channel_names[i]);
-        if (pin != NULL) {
-            chan->data_source_type = 0;
-            chan->data_source = SHMOFF(pin);
-            chan->data_type = pin->type;
-            chan->name = pin->name;
-            matched = 1;
-        } else {
-            /* Try to find matching HAL signal */
-            hal_sig_t *sig = halpr_find_sig_by_name(channel_names[i]);
-            if (sig != NULL) {
-                chan->data_source_type = 1;
-                chan->data_source = SHMOFF(sig);
-                chan->data_type = sig->type;
-                chan->name = sig->name;
-                matched = 1;
-            } else {
-                /* Try to find matching HAL parameter */
-                hal_param_t *param = halpr_find_param_by_name(channel_names[i]);
-                if (param != NULL) {
-                    chan->data_source_type = 2;
-                    chan->data_source = SHMOFF(param);
-                    chan->data_type = param->type;
-                    chan->name = param->name;
-                    matched = 1;
-                }
-            }
-        }
-
-        /* If no match found, create phantom channel */
-        if (!matched) {
-            char *phantom_name = malloc(strlen(channel_names[i]) + 8);
-            if (phantom_name != NULL) {
-                snprintf(phantom_name, strlen(channel_names[i]) + 8,
-                         "[CSV] %s", channel_names[i]);
-
-                chan->data_source_type = -1;  /* No source */
-                chan->data_source = 0;
-                chan->data_type = HAL_FLOAT;  /* Default to float for CSV data */
-                chan->name = phantom_name;
-                chan->is_phantom = 1;
-            }
-        }
-
-        /* Set up channel data length and scale limits based on type */
-        switch (chan->data_type) {
-        case HAL_BIT:
-            chan->data_len = sizeof(hal_bit_t);
-            chan->min_index = -2;
-            chan->max_index = 2;
-            break;
-        case HAL_FLOAT:
-            chan->data_len = sizeof(hal_float_t);
-            chan->min_index = -36;
-            chan->max_index = 36;
-            break;
-        case HAL_S32:
-            chan->data_len = sizeof(hal_s32_t);
-            chan->min_index = -2;
-            chan->max_index = 30;
-            break;
-        case HAL_U32:
-            chan->data_len = sizeof(hal_u32_t);
-            chan->min_index = -2;
-            chan->max_index = 30;
-            break;
-        default:
-            chan->data_len = 0;
-            chan->min_index = -1;
-            chan->max_index = 1;
-        }
-
-        /* Set default scale and offset */
-        chan->vert_offset = 0.0;
-        chan->ac_offset = 0;
-
-        /* Apply position and scale from CSV if available */
-        if (has_position_config) {
-            chan->position = channel_positions[i];
-        } else {
-            chan->position = 0.5;  /* Center position */
-        }
-
-        if (has_scale_config) {
-            chan->scale_index = channel_scales[i];
-            /* Clamp to valid range for this data type */
-            if (chan->scale_index < chan->min_index) {
-                chan->scale_index = chan->min_index;
-            }
-            if (chan->scale_index > chan->max_index) {
-                chan->scale_index = chan->max_index;
-            }
-        } else {
-            chan->scale_index = 0;
-        }
-
-        /* Compute the actual scale factor from scale_index */
-        {
-            double scale = 1.0;
-            int index = chan->scale_index;
-            while (index >= 3) {
-                scale *= 10.0;
-                index -= 3;
-            }
-            while (index <= -3) {
-                scale *= 0.1;
-                index += 3;
-            }
-            switch (index) {
-            case 2:
-                scale *= 5.0;
-                break;
-            case 1:
-                scale *= 2.0;
-                break;
-            case -1:
-                scale *= 0.5;
-                break;
-            case -2:
-                scale *= 0.2;
-                break;
-            default:
-                break;
-            }
-            chan->scale = scale;
-        }
-
-        /* Enable this channel */
-        vert->chan_enabled[i] = 1;
-        vert->data_offset[i] = i;  /* Sequential offsets */
+    /* the loaded data replaces any recording */
+    stop_stream();
+    scope_rec_free(&ctrl_usr->rec);
 
-        channel_types[i] = chan->data_type;
+    for (i = 0; i < channel_count; i++) {
+        setup_log_channel(i, channel_names[i], HAL_TYPE_UNSPECIFIED, "[CSV]",
+            channel_positions[i], channel_scales[i]);
+        channel_types[i] = ctrl_usr->chan[i].data_type;
     }
 
     /* Update channel selection buttons to show enabled state */
@@ -775,30 +677,7 @@ void read_log_file(char *filename)
     }
 
     /* Restore horizontal timing settings */
-    horiz = &(ctrl_usr->horiz);
-
-    /* Back-calculate thread period and multiplier
-     * We'll use a reasonable default thread period and calculate mult
-     * For example, assume 1ms (1000000ns) base thread period
-     */
-    if (horiz->thread_period_ns > 0) {
-        /* Use existing thread period */
-        ctrl_shm->mult = sample_period_ns / horiz->thread_period_ns;
-        if (ctrl_shm->mult < 1) ctrl_shm->mult = 1;
-    } else {
-        /* No thread selected, use a default */
-        horiz->thread_period_ns = 1000000;  /* 1ms default */
-        ctrl_shm->mult = sample_period_ns / horiz->thread_period_ns;
-        if (ctrl_shm->mult < 1) {
-            /* Sample period is shorter than thread period, adjust */
-            horiz->thread_period_ns = sample_period_ns;
-            ctrl_shm->mult = 1;
-        }
-    }
-
-    /* Update horizontal display settings */
-    horiz->sample_period_ns = sample_period_ns;
-    horiz->sample_period = (double)sample_period_ns * 1.0e-9;
+    set_log_sample_period(sample_period_ns);
 
     /* Mark that data is from log file */
     ctrl_usr->data_from_log_file = 1;
@@ -849,6 +728,324 @@ static void write_sample(FILE *fp, scope_data_t *dptr, hal_type_t type)
 	fprintf(fp, "%.14f", data_value);
 }
 
+/* binary data files are told apart by their suffix */
+static int is_binary_log(const char *filename)
+{
+    size_t len = strlen(filename);
+
+    return len >= 4 && strcasecmp(filename + len - 4, ".hsd") == 0;
+}
+
+/* writes the recording, or else the captured data, as a binary data file */
+static void write_log_binary(char *filename)
+{
+    scope_rec_hdr_t hdr;
+    scope_chan_t *chan;
+    scope_data_t *dptr;
+    FILE *fp;
+    int n, k, nchan, ok, retval;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.sample_period_ns = ctrl_usr->horiz.sample_period_ns;
+    if (ctrl_usr->rec.hdr) {
+	rec_channels(hdr.chan);
+	retval = scope_rec_save(&ctrl_usr->rec, &hdr, filename);
+	if (retval < 0) {
+	    fprintf(stderr, "ERROR: log file '%s' could not be written: %s\n",
+		filename, strerror(-retval));
+	    return;
+	}
+	printf("Log file '%s' written.\n", filename);
+	return;
+    }
+    /* describe the channels in the order they are in each sample */
+    nchan = 0;
+    for (n = 0; n < 16; n++) {
+	k = ctrl_usr->vert.data_offset[n];
+	if (k < 0 || k >= 16) {
+	    continue;
+	}
+	chan = &(ctrl_usr->chan[n]);
+	if (chan->name != NULL) {
+	    snprintf(hdr.chan[k].name, sizeof(hdr.chan[k].name), "%s",
+		chan->name);
+	}
+	hdr.chan[k].type = chan->data_type;
+	hdr.chan[k].scale_index = chan->scale_index;
+	hdr.chan[k].position = chan->position;
+	if (k >= nchan) {
+	    nchan = k + 1;
+	}
+    }
+    if (nchan == 0) {
+	fprintf(stderr, "ERROR: no data to write to log file '%s'\n", filename);
+	return;
+    }
+    memcpy(hdr.magic, SCOPE_REC_MAGIC, sizeof(hdr.magic));
+    hdr.version = SCOPE_REC_VERSION;
+    hdr.nchan = nchan;
+    hdr.samples = ctrl_usr->samples;
+    fp = fopen(filename, "wb");
+    if (fp == NULL) {
+	fprintf(stderr, "ERROR: log file '%s' could not be created\n", filename);
+	return;
+    }
+    ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+    /* the display buffer has room for 16 channels in each sample */
+    dptr = ctrl_usr->disp_buf;
+    for (n = 0; n < ctrl_usr->samples && ok; n++) {
+	ok = fwrite(dptr, sizeof(scope_data_t), nchan, fp) == (size_t) nchan;
+	dptr += ctrl_shm->sample_len;
+    }
+    if (fclose(fp) != 0 || !ok) {
+	fprintf(stderr, "ERROR: log file '%s' could not be written\n", filename);
+	return;
+    }
+    printf("Log file '%s' written.\n", filename);
+}
+
+/* the channels of the recording, as they were when it was made, with
+   the vertical settings of the channels that still show them */
+static void rec_channels(scope_rec_chan_t *chan)
+{
+    int n, k;
+
+    memcpy(chan, ctrl_usr->rec.hdr->chan, sizeof(ctrl_usr->rec.hdr->chan));
+    for (n = 0; n < 16; n++) {
+	k = ctrl_usr->vert.data_offset[n];
+	if (k >= 0 && k < ctrl_usr->rec.nchan) {
+	    chan[k].scale_index = ctrl_usr->chan[n].scale_index;
+	    chan[k].position = ctrl_usr->chan[n].position;
+	}
+    }
+}
+
+/* maps a binary data file and shows it as a recording */
+static void read_log_binary(char *filename)
+{
+    scope_vert_t *vert = &(ctrl_usr->vert);
+    scope_rec_hdr_t *hdr;
+    scope_rec_t rec;
+    char name[HAL_NAME_LEN + 1];
+    int i, retval;
+
+    retval = scope_rec_load(&rec, filename);
+    if (retval < 0) {
+	fprintf(stderr, "ERROR: log file '%s' could not be loaded: %s\n",
+	    filename, strerror(-retval));
+	return;
+    }
+    hdr = rec.hdr;
+    if (hdr->sample_period_ns == 0) {
+	fprintf(stderr, "ERROR: invalid sample period 0 ns\n");
+	scope_rec_free(&rec);
+	return;
+    }
+    /* the loaded data replaces any recording */
+    stop_stream();
+    scope_rec_free(&ctrl_usr->rec);
+    ctrl_usr->rec = rec;
+
+    for (i = 0; i < 16; i++) {
+        vert->chan_enabled[i] = 0;
+        vert->data_offset[i] = -1;
+        ctrl_usr->chan[i].data_source_type = -1;
+        ctrl_usr->chan[i].is_phantom = 0;
+    }
+    for (i = 0; i < rec.nchan; i++) {
+	snprintf(name, sizeof(name), "%.*s", HAL_NAME_LEN, hdr->chan[i].name);
+	setup_log_channel(i, name, hdr->chan[i].type, "[HSD]",
+	    hdr->chan[i].position, hdr->chan[i].scale_index);
+    }
+    for (i = 0; i < rec.nchan; i++) {
+        if (vert->chan_sel_buttons[i] != NULL) {
+            gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(vert->chan_sel_buttons[i]), TRUE);
+        }
+    }
+    set_log_sample_period(hdr->sample_period_ns);
+
+    ctrl_usr->data_from_log_file = 1;
+    set_run_mode(STOP);
+    vert->selected = 1;
+    /* start out showing all of it */
+    set_horiz_zoom(1);
+    set_horiz_pos(0.5);
+    channel_changed();
+    refresh_display();
+    redraw_window();
+
+    printf("Log file '%s' loaded: %d channels, %ld samples, %ld ns period\n",
+           filename, rec.nchan, rec.count, (long)hdr->sample_period_ns);
+}
+
+/* Sets up channel 'i' to show data loaded from a file.  The channel
+   gets the pin, signal or parameter called 'name' as its source if
+   there is one of the given type, or of any type if it is
+   HAL_TYPE_UNSPECIFIED.  Otherwise it becomes a phantom channel whose
+   name starts with 'tag'.
+*/
+static void setup_log_channel(int i, const char *name, hal_type_t type,
+    const char *tag, double position, int scale_index)
+{
+    scope_vert_t *vert = &(ctrl_usr->vert);
+    scope_chan_t *chan = &(ctrl_usr->chan[i]);
+    int matched = 0;
+
+    /* Try to find matching HAL pin */
+    hal_pin_t *pin = halpr_find_pin_by_name(name);
+    if (pin != NULL && (type == HAL_TYPE_UNSPECIFIED || pin->type == type)) {
+        chan->data_source_type = 0;
+        chan->data_source = SHMOFF(pin);
+        chan->data_type = pin->type;
+        chan->name = pin->name;
+        matched = 1;
+    } else {
+        /* Try to find matching HAL signal */
+        hal_sig_t *sig = halpr_find_sig_by_name(name);
+        if (sig != NULL && (type == HAL_TYPE_UNSPECIFIED || sig->type == type)) {
+            chan->data_source_type = 1;
+            chan->data_source = SHMOFF(sig);
+            chan->data_type = sig->type;
+            chan->name = sig->name;
+            matched = 1;
+        } else {
+            /* Try to find matching HAL parameter */
+            hal_param_t *param = halpr_find_param_by_name(name);
+            if (param != NULL
+                && (type == HAL_TYPE_UNSPECIFIED || param->type == type)) {
+                chan->data_source_type = 2;
+                chan->data_source = SHMOFF(param);
+                chan->data_type = param->type;
+                chan->name = param->name;
+                matched = 1;
+            }
+        }
+    }
+
+    /* If no match found, create phantom channel */
+    if (!matched) {
+        size_t len = strlen(tag) + strlen(name) + 2;
+        char *phantom_name = malloc(len);
+        if (phantom_name != NULL) {
+            snprintf(phantom_name, len, "%s %s", tag, name);
+
+            chan->data_source_type = -1;  /* No source */
+            chan->data_source = 0;
+            /* CSV data is just numbers, default to float */
+            chan->data_type = type == HAL_TYPE_UNSPECIFIED ? HAL_FLOAT : type;
+            chan->name = phantom_name;
+            chan->is_phantom = 1;
+        }
+    }
+
+    /* Set up channel data length and scale limits based on type */
+    switch (chan->data_type) {
+    case HAL_BIT:
+        chan->data_len = sizeof(hal_bit_t);
+        chan->min_index = -2;
+        chan->max_index = 2;
+        break;
+    case HAL_FLOAT:
+        chan->data_len = sizeof(hal_float_t);
+        chan->min_index = -36;
+        chan->max_index = 36;
+        break;
+    case HAL_S32:
+        chan->data_len = sizeof(hal_s32_t);
+        chan->min_index = -2;
+        chan->max_index = 30;
+        break;
+    case HAL_U32:
+        chan->data_len = sizeof(hal_u32_t);
+        chan->min_index = -2;
+        chan->max_index = 30;
+        break;
+    default:
+        chan->data_len = 0;
+        chan->min_index = -1;
+        chan->max_index = 1;
+    }
+
+    /* Set default scale and offset */
+    chan->vert_offset = 0.0;
+    chan->ac_offset = 0;
+
+    /* Apply position and scale from the file */
+    chan->position = position;
+    chan->scale_index = scale_index;
+    /* Clamp to valid range for this data type */
+    if (chan->scale_index < chan->min_index) {
+        chan->scale_index = chan->min_index;
+    }
+    if (chan->scale_index > chan->max_index) {
+        chan->scale_index = chan->max_index;
+    }
+
+    /* Compute the actual scale factor from scale_index */
+    {
+        double scale = 1.0;
+        int index = chan->scale_index;
+        while (index >= 3) {
+            scale *= 10.0;
+            index -= 3;
+        }
+        while (index <= -3) {
+            scale *= 0.1;
+            index += 3;
+        }
+        switch (index) {
+        case 2:
+            scale *= 5.0;
+            break;
+        case 1:
+            scale *= 2.0;
+            break;
+        case -1:
+            scale *= 0.5;
+            break;
+        case -2:
+            scale *= 0.2;
+            break;
+        default:
+            break;
+        }
+        chan->scale = scale;
+    }
+
+    /* Enable this channel */
+    vert->chan_enabled[i] = 1;
+    vert->data_offset[i] = i;  /* Sequential offsets */
+}
+
+/* sets the horizontal timing for data loaded from a file */
+static void set_log_sample_period(long sample_period_ns)
+{
+    scope_horiz_t *horiz = &(ctrl_usr->horiz);
+
+    /* Back-calculate thread period and multiplier
+     * We'll use a reasonable default thread period and calculate mult
+     * For example, assume 1ms (1000000ns) base thread period
+     */
+    if (horiz->thread_period_ns > 0) {
+        /* Use existing thread period */
+        ctrl_shm->mult = sample_period_ns / horiz->thread_period_ns;
+        if (ctrl_shm->mult < 1) ctrl_shm->mult = 1;
+    } else {
+        /* No thread selected, use a default */
+        horiz->thread_period_ns = 1000000;  /* 1ms default */
+        ctrl_shm->mult = sample_period_ns / horiz->thread_period_ns;
+        if (ctrl_shm->mult < 1) {
+            /* Sample period is shorter than thread period, adjust */
+            horiz->thread_period_ns = sample_period_ns;
+            ctrl_shm->mult = 1;
+        }
+    }
+
+    /* Update horizontal display settings */
+    horiz->sample_period_ns = sample_period_ns;
+    horiz->sample_period = (double)sample_period_ns * 1.0e-9;
+}
+
 
 /***********************************************************************
 *                         LOCAL FUNCTION CODE                          *
@@ -144,7 +144,7 @@ static void init_horiz_window(void)
     /* second column - sliders */
     vbox = gtk_vbox_new_in_box(TRUE, 0, 0, hbox, TRUE, TRUE, 3);
     /* add a slider for zoom level */
-    horiz->zoom_adj = gtk_adjustment_new(1, 1, 9, 1, 1, 0);
+    horiz->zoom_adj = gtk_adjustment_new(1, 1, 18, 1, 1, 0);
     horiz->zoom_slider = gtk_scale_new(
             GTK_ORIENTATION_HORIZONTAL, GTK_ADJUSTMENT(horiz->zoom_adj));
     gtk_scale_set_digits(GTK_SCALE(horiz->zoom_slider), 0);
@@ -300,11 +300,12 @@ void refresh_state_info(void)
 	"TRIGGER?",
 	"TRIGGERED",
 	"DONE",
-	"RESET"
+	"RESET",
+	"STREAMING"
     };
 
     horiz = &(ctrl_usr->horiz);
-    if (ctrl_shm->state > RESET) {
+    if (ctrl_shm->state > STREAMING) {
 	ctrl_shm->state = IDLE;
     }
     gtk_label_set_text_if(horiz->state_label, state_names[ctrl_shm->state]);
@@ -402,7 +403,7 @@ int set_horiz_zoom(int setting)
     GtkAdjustment *adj;
 
     /* range check setting */
-    if (( setting < 1 ) || ( setting > 9 )) {
+    if (( setting < 1 ) || ( setting > 18 )) {
 	return -1;
     }
     /* point to data */
@@ -791,9 +792,12 @@ static void log_popup(GtkWindow *parent)
                                         _("_Cancel"), GTK_RESPONSE_CANCEL,
                                         _("_Save"), GTK_RESPONSE_ACCEPT, NULL);
 
-    gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(filew), "halscope.csv");
+    /* long recordings are better kept in binary */
+    gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(filew),
+        ctrl_usr->rec.hdr ? "halscope.hsd" : "halscope.csv");
     chooser = GTK_FILE_CHOOSER(filew);
     set_file_filter(chooser, "Text CSV (.csv)", "*.csv");
+    add_file_filter(chooser, "Binary (.hsd)", "*.hsd");
     gtk_file_chooser_set_do_overwrite_confirmation(chooser, TRUE);
 
     if (gtk_dialog_run(GTK_DIALOG(filew)) == GTK_RESPONSE_ACCEPT) {
@@ -965,7 +969,7 @@ static void calc_horiz_scaling(void)
     }
     horiz->sample_period_ns = horiz->thread_period_ns * ctrl_shm->mult;
     horiz->sample_period = horiz->sample_period_ns / 1000000000.0;
-    total_rec_time = ctrl_shm->rec_len * horiz->sample_period;
+    total_rec_time = disp_rec_len() * horiz->sample_period;
     if (total_rec_time < 0.000010) {
 	/* out of range, set to 1 µs per div */
 	horiz->disp_scale = 0.000001;
@@ -1037,10 +1041,10 @@ static void refresh_horiz_info(void)
 	freqval = 1.0 / horiz->sample_period;
 	format_freq_value(rate, BUFLEN, freqval);
     }
-    if (ctrl_shm->rec_len == 0) {
+    if (disp_rec_len() == 0) {
 	snprintf(rec_len, BUFLEN, "----");
     } else {
-	snprintf(rec_len, BUFLEN, "%d", ctrl_shm->rec_len);
+	snprintf(rec_len, BUFLEN, "%ld", disp_rec_len());
     }
     snprintf(msg, BUFLEN, _("%s samples\nat %s"), rec_len, rate);
     gtk_label_set_text_if(horiz->thread_name_label, name);
@@ -1078,11 +1082,18 @@ static gboolean refresh_pos_disp(void)
     box_bot = rec_line_y + box_y_off;
 
     /* these need to be calculated */
-    pre_trig = ctrl_shm->rec_len * ctrl_usr->trig.position;
+    if (ctrl_usr->rec.hdr) {
+	/* a recording has no trigger */
+	pre_trig = 0;
+	rec_curr = ctrl_usr->rec.count * horiz->sample_period;
+    } else {
+	pre_trig = ctrl_shm->rec_len * ctrl_usr->trig.position;
+	rec_curr = ctrl_shm->samples * horiz->sample_period;
+    }
     /* times relative to trigger */
     rec_start = -pre_trig * horiz->sample_period;
-    rec_end = (ctrl_shm->rec_len - pre_trig) * horiz->sample_period;
-    rec_curr = rec_start + (ctrl_shm->samples * horiz->sample_period);
+    rec_end = (disp_rec_len() - pre_trig) * horiz->sample_period;
+    rec_curr += rec_start;
     disp_center = rec_start + horiz->pos_setting * (rec_end - rec_start);
     disp_start = disp_center - 5.0 * horiz->disp_scale;
     disp_end = disp_center + 5.0 * horiz->disp_scale;
@@ -1226,9 +1237,9 @@ static gint horiz_motion(GtkWidget *widget, GdkEventMotion *event) {
 
     motion = x - horiz->x0;
 
-    pre_trig = ctrl_shm->rec_len * ctrl_usr->trig.position;
+    pre_trig = ctrl_usr->rec.hdr ? 0 : ctrl_shm->rec_len * ctrl_usr->trig.position;
     rec_start = -pre_trig * horiz->sample_period;
-    rec_end = (ctrl_shm->rec_len - pre_trig) * horiz->sample_period;
+    rec_end = (disp_rec_len() - pre_trig) * horiz->sample_period;
     disp_center = rec_start + horiz->pos_setting * (rec_end - rec_start);
     disp_start = disp_center - 5.0 * horiz->disp_scale;
     disp_end = disp_center + 5.0 * horiz->disp_scale;
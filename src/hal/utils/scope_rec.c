@@ -0,0 +1,392 @@
+/** This file, 'scope_rec.c', contains the code that keeps the
+    recordings of halscope: the file backed ring that a streaming
+    capture is drained into, binary data files, and the min/max
+    decimation pyramids used to display them.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to https://linuxcnc.org.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "scope_rec.h"		/* recording declarations */
+
+/***********************************************************************
+*                     LOCAL FUNCTION PROTOTYPES                        *
+************************************************************************/
+
+static int alloc_pyramids(scope_rec_t *rec);
+static void update_pyramids(scope_rec_t *rec, long slot);
+static void range_minmax(scope_rec_t *rec, int chan, long lo, long hi,
+    double *min, double *max);
+
+/***********************************************************************
+*                       PUBLIC FUNCTION CODE                           *
+************************************************************************/
+
+/* Creates an empty recording of 'len' samples.  The samples live in
+   an unlinked temporary file, so a long recording is paged to disk
+   by the kernel instead of filling memory.
+*/
+int scope_rec_create(scope_rec_t *rec, long len, int nchan,
+    const hal_type_t *type)
+{
+    char path[4096];
+    const char *tmpdir;
+    int fd, n;
+
+    memset(rec, 0, sizeof(*rec));
+    if ((nchan < 1) || (nchan > 16) || (len < 1)) {
+	return -EINVAL;
+    }
+    tmpdir = getenv("TMPDIR");
+    if (tmpdir == NULL || *tmpdir == '\0') {
+	tmpdir = "/tmp";
+    }
+    snprintf(path, sizeof(path), "%s/halscope-XXXXXX", tmpdir);
+    fd = mkstemp(path);
+    if (fd < 0) {
+	return -errno;
+    }
+    unlink(path);
+    rec->map_size = sizeof(scope_rec_hdr_t) +
+	(size_t)len * nchan * sizeof(scope_data_t);
+    if (ftruncate(fd, rec->map_size) < 0) {
+	n = -errno;
+	close(fd);
+	return n;
+    }
+    rec->hdr = mmap(NULL, rec->map_size, PROT_READ | PROT_WRITE,
+	MAP_SHARED, fd, 0);
+    close(fd);
+    if (rec->hdr == MAP_FAILED) {
+	rec->hdr = NULL;
+	return -ENOMEM;
+    }
+    rec->data = (scope_data_t *) (rec->hdr + 1);
+    rec->nchan = nchan;
+    rec->len = len;
+    for (n = 0; n < nchan; n++) {
+	rec->type[n] = type[n];
+    }
+    if (alloc_pyramids(rec) < 0) {
+	scope_rec_free(rec);
+	return -ENOMEM;
+    }
+    return 0;
+}
+
+void scope_rec_free(scope_rec_t *rec)
+{
+    int n, k;
+
+    if (rec->hdr != NULL) {
+	munmap(rec->hdr, rec->map_size);
+    }
+    for (n = 0; n < 16; n++) {
+	for (k = 0; k < SCOPE_REC_LEVELS; k++) {
+	    free(rec->pyr[n][k]);
+	}
+    }
+    memset(rec, 0, sizeof(*rec));
+}
+
+/* Appends 'n' samples that are 'stride' values apart, dropping the
+   oldest ones once the recording is full.
+*/
+void scope_rec_append(scope_rec_t *rec, const scope_data_t *samples,
+    int stride, long n)
+{
+    scope_data_t *dptr;
+    int c;
+
+    while (n-- > 0) {
+	dptr = rec->data + rec->head * rec->nchan;
+	if (rec->count == rec->len) {
+	    /* the oldest sample is about to be overwritten */
+	    for (c = 0; c < rec->nchan; c++) {
+		rec->sum[c] -= scope_rec_value(&dptr[c], rec->type[c]);
+	    }
+	} else {
+	    rec->count++;
+	}
+	memcpy(dptr, samples, rec->nchan * sizeof(scope_data_t));
+	for (c = 0; c < rec->nchan; c++) {
+	    rec->sum[c] += scope_rec_value(&dptr[c], rec->type[c]);
+	}
+	update_pyramids(rec, rec->head);
+	if (++rec->head == rec->len) {
+	    rec->head = 0;
+	}
+	rec->total++;
+	samples += stride;
+    }
+}
+
+/* Finds the smallest and largest value of channel 'chan' in samples
+   'start' to 'end' - 1, counting from the oldest one.
+*/
+void scope_rec_minmax(scope_rec_t *rec, int chan, long start, long end,
+    double *min, double *max)
+{
+    long lo, hi;
+
+    *min = HUGE_VAL;
+    *max = -HUGE_VAL;
+    if (start < 0) {
+	start = 0;
+    }
+    if (end > rec->count) {
+	end = rec->count;
+    }
+    if (start >= end) {
+	return;
+    }
+    /* convert to slots, the range may wrap around the end of the ring */
+    lo = rec->head - rec->count + start;
+    if (lo < 0) {
+	lo += rec->len;
+    }
+    hi = lo + (end - start);
+    if (hi > rec->len) {
+	range_minmax(rec, chan, lo, rec->len, min, max);
+	lo = 0;
+	hi -= rec->len;
+    }
+    range_minmax(rec, chan, lo, hi, min, max);
+}
+
+/* Writes the recording to a binary data file.  The caller fills in
+   the sample period and the channel information in 'hdr'.
+*/
+int scope_rec_save(scope_rec_t *rec, scope_rec_hdr_t *hdr,
+    const char *filename)
+{
+    FILE *fp;
+    long first, n;
+    int ok;
+
+    memcpy(hdr->magic, SCOPE_REC_MAGIC, sizeof(hdr->magic));
+    hdr->version = SCOPE_REC_VERSION;
+    hdr->nchan = rec->nchan;
+    hdr->samples = rec->count;
+    hdr->first = rec->total - rec->count;
+    fp = fopen(filename, "wb");
+    if (fp == NULL) {
+	return -errno;
+    }
+    ok = fwrite(hdr, sizeof(*hdr), 1, fp) == 1;
+    /* oldest samples first, they may wrap around the end of the ring */
+    first = rec->head - rec->count;
+    if (first < 0) {
+	first += rec->len;
+	n = rec->len - first;
+	ok = ok && fwrite(rec->data + first * rec->nchan,
+	    sizeof(scope_data_t) * rec->nchan, n, fp) == (size_t) n;
+	first = 0;
+    }
+    n = rec->head - first;
+    ok = ok && fwrite(rec->data + first * rec->nchan,
+	sizeof(scope_data_t) * rec->nchan, n, fp) == (size_t) n;
+    if (fclose(fp) != 0) {
+	ok = 0;
+    }
+    return ok ? 0 : -EIO;
+}
+
+/* Maps a binary data file as a read-only recording */
+int scope_rec_load(scope_rec_t *rec, const char *filename)
+{
+    scope_rec_hdr_t *hdr;
+    struct stat st;
+    long slot;
+    int fd, n, retval;
+
+    memset(rec, 0, sizeof(*rec));
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+	return -errno;
+    }
+    if (fstat(fd, &st) < 0) {
+	retval = -errno;
+	close(fd);
+	return retval;
+    }
+    if ((size_t) st.st_size < sizeof(scope_rec_hdr_t)) {
+	close(fd);
+	return -EINVAL;
+    }
+    hdr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (hdr == MAP_FAILED) {
+	return -ENOMEM;
+    }
+    rec->hdr = hdr;
+    rec->map_size = st.st_size;
+    if (memcmp(hdr->magic, SCOPE_REC_MAGIC, sizeof(hdr->magic)) != 0
+	|| hdr->version != SCOPE_REC_VERSION
+	|| hdr->nchan < 1 || hdr->nchan > 16 || hdr->samples < 1
+	|| hdr->samples > (st.st_size - sizeof(*hdr)) /
+	    (hdr->nchan * sizeof(scope_data_t))) {
+	scope_rec_free(rec);
+	return -EINVAL;
+    }
+    rec->data = (scope_data_t *) (hdr + 1);
+    rec->nchan = hdr->nchan;
+    for (n = 0; n < rec->nchan; n++) {
+	rec->type[n] = hdr->chan[n].type;
+    }
+    rec->len = rec->count = hdr->samples;
+    rec->total = hdr->first + hdr->samples;
+    if (alloc_pyramids(rec) < 0) {
+	scope_rec_free(rec);
+	return -ENOMEM;
+    }
+    for (slot = 0; slot < rec->len; slot++) {
+	for (n = 0; n < rec->nchan; n++) {
+	    rec->sum[n] += scope_rec_value(&rec->data[slot * rec->nchan + n],
+		rec->type[n]);
+	}
+	update_pyramids(rec, slot);
+    }
+    return 0;
+}
+
+/***********************************************************************
+*                         LOCAL FUNCTION CODE                          *
+************************************************************************/
+
+static int alloc_pyramids(scope_rec_t *rec)
+{
+    long width, entries;
+    int n;
+
+    rec->levels = 1;
+    width = SCOPE_REC_FANOUT;
+    while ((rec->levels < SCOPE_REC_LEVELS) && (width <= rec->len)) {
+	entries = (rec->len + width - 1) / width;
+	for (n = 0; n < rec->nchan; n++) {
+	    rec->pyr[n][rec->levels] = malloc(entries * sizeof(scope_minmax_t));
+	    if (rec->pyr[n][rec->levels] == NULL) {
+		return -1;
+	    }
+	}
+	rec->levels++;
+	width *= SCOPE_REC_FANOUT;
+    }
+    return 0;
+}
+
+/* Adds the sample just written to 'slot' to the pyramid entries that
+   cover it.  Slots are written in order, so an entry is restarted by
+   the first slot it covers; until its last slot is written it only
+   covers part of its range, see range_minmax().
+*/
+static void update_pyramids(scope_rec_t *rec, long slot)
+{
+    scope_minmax_t *mm;
+    long width;
+    float value;
+    int n, k;
+
+    for (n = 0; n < rec->nchan; n++) {
+	value = scope_rec_value(&rec->data[slot * rec->nchan + n],
+	    rec->type[n]);
+	width = SCOPE_REC_FANOUT;
+	for (k = 1; k < rec->levels; k++) {
+	    mm = &rec->pyr[n][k][slot / width];
+	    if (slot % width == 0) {
+		mm->min = mm->max = value;
+	    } else {
+		if (value < mm->min) {
+		    mm->min = value;
+		}
+		if (value > mm->max) {
+		    mm->max = value;
+		}
+	    }
+	    width *= SCOPE_REC_FANOUT;
+	}
+    }
+}
+
+/* Merges slots 'lo' to 'hi' - 1 of channel 'chan' into min and max.
+   At each step it takes the largest aligned pyramid entry that starts
+   at 'lo' and fits in the range, so a range costs at most about
+   2 * FANOUT steps per level.  An entry that 'head' is in the middle
+   of is only partly rewritten and is not used.
+*/
+static void range_minmax(scope_rec_t *rec, int chan, long lo, long hi,
+    double *min, double *max)
+{
+    const scope_data_t *dptr;
+    scope_minmax_t *mm;
+    long width, next;
+    double value;
+    int k;
+
+    while (lo < hi) {
+	k = 0;
+	width = 1;
+	while (k + 1 < rec->levels) {
+	    next = width * SCOPE_REC_FANOUT;
+	    if ((lo % next != 0) || (lo + next > hi)
+		|| ((rec->head > lo) && (rec->head < lo + next))) {
+		break;
+	    }
+	    width = next;
+	    k++;
+	}
+	if (k == 0) {
+	    dptr = &rec->data[lo * rec->nchan + chan];
+	    value = scope_rec_value(dptr, rec->type[chan]);
+	    if (value < *min) {
+		*min = value;
+	    }
+	    if (value > *max) {
+		*max = value;
+	    }
+	} else {
+	    mm = &rec->pyr[chan][k][lo / width];
+	    if (mm->min < *min) {
+		*min = mm->min;
+	    }
+	    if (mm->max > *max) {
+		*max = mm->max;
+	    }
+	}
+	lo += width;
+    }
+}
@@ -0,0 +1,142 @@
+#ifndef SCOPE_REC_H
+#define SCOPE_REC_H
+/** This file, 'scope_rec.h', contains declarations for the
+    recordings used by the user space portion of the HAL
+    oscilloscope.  A recording holds the samples of a streaming
+    capture, or of a binary data file, in a file backed mapping,
+    so it is not limited by the size of the realtime buffer.  It
+    also keeps min/max decimation pyramids, which let the display
+    draw any part of it in time proportional to the width of the
+    window instead of the number of samples.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to https://linuxcnc.org.
+*/
+
+#include "scope_shm.h"
+
+/***********************************************************************
+*                         TYPEDEFS AND DEFINES                         *
+************************************************************************/
+
+#define SCOPE_REC_MAGIC "HALSCOPE"
+#define SCOPE_REC_VERSION 1
+#define SCOPE_REC_LEN_DEFAULT 4000000	/* samples in a streaming recording */
+#define SCOPE_REC_FANOUT 16		/* entries merged per pyramid level */
+#define SCOPE_REC_LEVELS 8		/* raw samples plus 7 pyramid levels */
+
+/* A binary data file ('.hsd') is this header followed by 'samples'
+   samples of 'nchan' scope_data_t each, in native byte order.  While
+   streaming, the recording is kept in the same layout, except that
+   the samples form a ring and, until it is saved, only the channels
+   of the header are filled in.
+*/
+
+typedef struct {
+    char name[HAL_NAME_LEN + 1];	/* pin, signal or param name */
+    rtapi_u32 type;		/* hal_type_t of the samples */
+    rtapi_s32 scale_index;	/* vertical scale setting */
+    double position;		/* vertical position setting */
+} scope_rec_chan_t;
+
+typedef struct {
+    char magic[8];		/* SCOPE_REC_MAGIC, not terminated */
+    rtapi_u32 version;		/* SCOPE_REC_VERSION */
+    rtapi_u32 nchan;		/* channels in each sample */
+    rtapi_u64 samples;		/* number of samples that follow */
+    rtapi_u64 first;		/* number of the first sample */
+    rtapi_u64 sample_period_ns;
+    scope_rec_chan_t chan[16];
+} scope_rec_hdr_t;
+
+/* one entry of a decimation pyramid */
+typedef struct {
+    float min, max;
+} scope_minmax_t;
+
+typedef struct {
+    scope_rec_hdr_t *hdr;	/* mapped file, NULL if no recording */
+    size_t map_size;		/* size of the mapping */
+    scope_data_t *data;		/* 'len' samples after the header */
+    int nchan;			/* channels in each sample */
+    hal_type_t type[16];	/* type of each channel */
+    long len;			/* capacity in samples */
+    long count;			/* valid samples, at most 'len' */
+    long head;			/* slot the next sample goes in */
+    unsigned long total;	/* samples appended, including lost ones */
+    unsigned long lost;		/* samples that were not appended */
+    int levels;			/* levels in use, including raw samples */
+    /* level k > 0 entry j covers slots j*FANOUT^k to (j+1)*FANOUT^k-1 */
+    scope_minmax_t *pyr[16][SCOPE_REC_LEVELS];
+    double sum[16];		/* sum of the valid samples, for AC offset */
+} scope_rec_t;
+
+/***********************************************************************
+*                          FUNCTIONS                                   *
+************************************************************************/
+
+/* returns the value of one sample as a double */
+static inline double scope_rec_value(const scope_data_t *dptr,
+    hal_type_t type)
+{
+    switch (type) {
+    case HAL_BIT:
+	return dptr->d_u8 ? 1.0 : 0.0;
+    case HAL_FLOAT:
+	return dptr->d_real;
+    case HAL_S32:
+	return dptr->d_s32;
+    case HAL_U32:
+	return dptr->d_u32;
+    default:
+	return 0.0;
+    }
+}
+
+/* returns sample 'n' of the recording, counting from the oldest one */
+static inline scope_data_t *scope_rec_sample(scope_rec_t *rec, long n)
+{
+    long slot = rec->head - rec->count + n;
+
+    if (slot < 0) {
+	slot += rec->len;
+    } else if (slot >= rec->len) {
+	slot -= rec->len;
+    }
+    return rec->data + slot * rec->nchan;
+}
+
+int scope_rec_create(scope_rec_t *rec, long len, int nchan,
+    const hal_type_t *type);
+void scope_rec_free(scope_rec_t *rec);
+void scope_rec_append(scope_rec_t *rec, const scope_data_t *samples,
+    int stride, long n);
+void scope_rec_minmax(scope_rec_t *rec, int chan, long start, long end,
+    double *min, double *max);
+int scope_rec_save(scope_rec_t *rec, scope_rec_hdr_t *hdr,
+    const char *filename);
+int scope_rec_load(scope_rec_t *rec, const char *filename);
+
+#endif /* SCOPE_REC_H */
@@ -198,7 +198,12 @@ static void sample(void *arg, long period)
 	    ctrl_rt->data_len[n] = ctrl_shm->data_len[n];
 	}
 	/* set next state */
-	ctrl_shm->state = PRE_TRIG;
+	if (ctrl_shm->stream) {
+	    __atomic_store_n(&ctrl_shm->stream_samples, 0, __ATOMIC_RELAXED);
+	    ctrl_shm->state = STREAMING;
+	} else {
+	    ctrl_shm->state = PRE_TRIG;
+	}
 	break;
     case PRE_TRIG:
 	/* acquire a sample */
@@ -244,6 +249,13 @@ static void sample(void *arg, long period)
 	    ctrl_shm->state = DONE;
 	}
 	break;
+    case STREAMING:
+	/* acquire a sample, the buffer is a ring that user space drains */
+	capture_sample();
+	/* publish it only after the data is written */
+	__atomic_store_n(&ctrl_shm->stream_samples,
+	    ctrl_shm->stream_samples + 1, __ATOMIC_RELEASE);
+	break;
     case DONE:
 	/* do nothing while GUI displays waveform */
 	break;
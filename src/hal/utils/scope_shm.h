@@ -53,7 +53,8 @@ typedef enum {
     TRIG_WAIT,			/* waiting for trigger */
     POST_TRIG,			/* acquiring post-trigger data */
     DONE,			/* data acquisition complete */
-    RESET			/* data acquisition interrupted */
+    RESET,			/* data acquisition interrupted */
+    STREAMING			/* acquiring continuously, no trigger */
 } scope_state_t;
 
 /* this struct holds a single value - one sample of one channel */
@@ -90,6 +91,9 @@ typedef struct {
     int curr;			/* R next sample to be acquired */
     int samples;		/* R number of valid samples */
     scope_state_t state;	/* RU current state */
+    int stream;			/* U nonzero to stream instead of trigger */
+    unsigned long stream_samples;	/* R samples acquired while streaming,
+				   written with __atomic_store_n() */
     int data_offset[16];	/* U data addr in shmem for each channel */
     hal_type_t data_type[16];	/* U data type for each channel */
     char data_len[16];		/* U data size, 0 if not to be acquired */
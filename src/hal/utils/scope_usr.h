@@ -38,6 +38,7 @@
 
 /* import the shared declarations */
 #include "scope_shm.h"
+#include "scope_rec.h"
 
 /***********************************************************************
 *                         TYPEDEFS AND DEFINES                         *
@@ -53,7 +54,7 @@ typedef struct {
     long sample_period_ns;	/* sample period in nano-secs */
     double sample_period;	/* sample period as a double */
     double disp_scale;		/* display scale (sec/div) */
-    int zoom_setting;		/* setting of zoom slider (1-9) */
+    int zoom_setting;		/* setting of zoom slider (1-18) */
     double pos_setting;		/* setting of position slider (0.0-1.0) */
     long x0;
     int width;			/* width in pixels */
@@ -188,7 +189,7 @@ typedef struct {
 
 /* this is the master user space control structure */
 
-typedef enum { STOP = 0, NORMAL, SINGLE, ROLL } scope_run_mode_t;
+typedef enum { STOP = 0, NORMAL, SINGLE, ROLL, STREAM } scope_run_mode_t;
 
 typedef struct {
     /* general data */
@@ -200,6 +201,11 @@ typedef struct {
     scope_run_mode_t old_run_mode;	/* run mode to restore*/
     int pending_restart;        /* nonzero if run mode to be restored */
     int data_from_log_file;	/* TRUE if current data loaded from CSV */
+    scope_rec_t rec;		/* recording, rec.hdr is NULL if none */
+    long rec_len;		/* samples in a streaming recording */
+    unsigned long stream_read;	/* samples drained from the shmem buffer */
+    long stream_slot;		/* where the next one is in the buffer */
+    guint stream_timer;		/* drain timer, nonzero while streaming */
     /* top level windows */
     GtkWidget *main_win;
     GtkWidget *horiz_info_win;
@@ -215,6 +221,7 @@ typedef struct {
     GtkWidget *rm_normal_button;
     GtkWidget *rm_single_button;
     GtkWidget *rm_roll_button;
+    GtkWidget *rm_stream_button;
     GtkWidget *rm_stop_button;
     /* subsection control data */
     scope_chan_t chan[16];	/* channel specific data */
@@ -245,7 +252,9 @@ void refresh_state_info(void);
 void capture_complete(void);
 void capture_cont(void);
 void start_capture(void);
+void stop_stream(void);
 void request_display_refresh(int delay);
+long disp_rec_len(void);
 void refresh_display(void);
 void refresh_trigger(void);
 void invalidate_channel(int chan);
@@ -23,6 +23,7 @@
 #include <sys/socket.h>		/* send(), recv(), socket(), accept(),
 				   bind(), listen() */
 #include <sys/time.h>		/* struct timeval */
+#include <poll.h>		/* poll() */
 #include "sendn.h"		/* sendn() */
 #include "rcs_print.hh"		/* rcs_print_error() */
 #include "_timer.h"		/* etime(), esleep() */
@@ -117,3 +118,84 @@ int sendn(int fd, const void *vptr, int n, int _flags, double _timeout)
     rcs_print_debug(PRINT_SOCKET_WRITE_SIZE, "wrote %d bytes to %d\n", n, fd);
     return (n);
 }
+
+/* Write all the bytes described by "iov" to a descriptor with as few
+   sendmsg() calls as possible, so a reply header and its payload leave
+   in a single segment without being copied into a staging buffer first. */
+int sendnv(int fd, const struct iovec *iov, int iovcnt, int _flags,
+    double _timeout)
+{
+    struct iovec iov_left[8];
+    struct msghdr msg;
+    struct pollfd pfd;
+    long nwritten;
+    int total = 0;
+    int i;
+    double start_time;
+
+    if (iovcnt < 1 || iovcnt > (int) (sizeof(iov_left) / sizeof(iov_left[0]))) {
+	rcs_print_error("sendnv(fd=%d, iovcnt=%d) bad vector count.\n",
+	    fd, iovcnt);
+	return -1;
+    }
+    for (i = 0; i < iovcnt; i++) {
+	iov_left[i] = iov[i];
+	total += (int) iov[i].iov_len;
+    }
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov_left;
+    msg.msg_iovlen = iovcnt;
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    start_time = etime();
+    while (msg.msg_iovlen > 0) {
+	if (_timeout > 1E-6) {
+	    double timeleft = start_time + _timeout - etime();
+	    if (timeleft <= 0.0) {
+		if (print_sendn_timeout_errors) {
+		    rcs_print_error
+			("sendnv(fd=%d, int iovcnt=%d, int flags=%d, double _timeout=%f) timed out.\n",
+			fd, iovcnt, _flags, _timeout);
+		}
+		sendn_timedout = 1;
+		return -1;
+	    }
+	    switch (poll(&pfd, 1, (int) (timeleft * 1000.0) + 1)) {
+	    case -1:
+		if (errno == EINTR) {
+		    continue;
+		}
+		rcs_print_error("Error in poll: %d -> %s\n", errno,
+		    strerror(errno));
+		return -1;
+
+	    case 0:
+		continue;
+
+	    default:
+		break;
+	    }
+	}
+	nwritten = sendmsg(fd, &msg, _flags | MSG_NOSIGNAL);
+	if (nwritten == -1) {
+	    if (errno == EINTR || errno == EAGAIN) {
+		continue;
+	    }
+	    rcs_print_error("Send error: %d = %s\n", errno, strerror(errno));
+	    return (-1);	/* error */
+	}
+	/* Drop the fully written entries and trim the partial one. */
+	while (msg.msg_iovlen > 0 && nwritten >= (long) msg.msg_iov->iov_len) {
+	    nwritten -= msg.msg_iov->iov_len;
+	    msg.msg_iov++;
+	    msg.msg_iovlen--;
+	}
+	if (msg.msg_iovlen > 0) {
+	    msg.msg_iov->iov_base = (char *) msg.msg_iov->iov_base + nwritten;
+	    msg.msg_iov->iov_len -= nwritten;
+	}
+    }
+    rcs_print_debug(PRINT_SOCKET_WRITE_SIZE, "wrote %d bytes to %d\n", total,
+	fd);
+    return (total);
+}
@@ -24,8 +24,11 @@ extern "C" {
 #endif
 
 #include <stddef.h>		/* size_t */
+#include <sys/uio.h>		/* struct iovec */
 
     int sendn(int fd, const void *vptr, int n, int flags, double timeout);
+    int sendnv(int fd, const struct iovec *iov, int iovcnt, int flags,
+	double timeout);
 
 #ifdef __cplusplus
 };
@@ -69,6 +69,7 @@ SHMEM::SHMEM(const char * /*n*/, long s, int /*nt*/, key_t k, int m)
     mutex_type(OS_SEM_MUTEX),
     shm_addr_offset(NULL),
     bsem(NULL),
+    futex(NULL),
     autokey_table_size(0)
 {
     /* open the shared mem buffer and create mutual exclusion semaphore */
@@ -89,6 +90,7 @@ SHMEM::SHMEM(const char *bufline, const char *procline, int set_to_server, int s
     mutex_type(OS_SEM_MUTEX),
     shm_addr_offset(NULL),
     bsem(NULL),
+    futex(NULL),
     autokey_table_size(0)
 {
     /* Set pointers to null so only properly opened pointers are closed. */
@@ -158,6 +160,13 @@ SHMEM::SHMEM(const char *bufline, const char *procline, int set_to_server, int s
 	use_os_sem_only = 0;
     }
 
+    /* The futex lock also provides blocking reads, so no BSEM= is needed. */
+    if (NULL != strstr(buflineupper, "MUTEX=FUTEX")) {
+	mutex_type = FUTEX_MUTEX;
+	use_os_sem = 0;
+	use_os_sem_only = 0;
+    }
+
     /* Open the shared memory buffer and create mutual exclusion semaphore. */
     open();
 }
@@ -177,6 +186,7 @@ int SHMEM::open()
     sem = NULL;
     shm = NULL;
     bsem = NULL;
+    futex = NULL;
     shm_addr_offset = NULL;
     second_read = 0;
     autokey_table_size = 0;
@@ -313,7 +323,25 @@ int SHMEM::open()
 	total_subdivisions = 1;
     }
 
+    /* 32 bytes of buffer name, followed by the futex block if used */
+    int header_size = 32;
+
+    /* Old style buffers have no header to keep the futex block in. */
+    if (mutex_type == FUTEX_MUTEX && min_compatible_version <= 2.57
+	&& min_compatible_version > 0) {
+	rcs_print_error("SHMEM: mutex=futex requires a buffer header.\n");
+	status = CMS_MISC_ERROR;
+	return -1;
+    }
+
     if (min_compatible_version > 2.57 || min_compatible_version <= 0) {
+	if (mutex_type == FUTEX_MUTEX) {
+	    header_size += sizeof(rcs_futex_block);
+	    futex = (rcs_futex_block *) ((char *) shm->addr + 32);
+	    if (master) {
+		memset(futex, 0, sizeof(rcs_futex_block));
+	    }
+	}
 	if (!shm->created) {
 	    char *cptr = (char *) shm->addr;
 	    cptr[31] = 0;
@@ -349,9 +377,9 @@ int SHMEM::open()
 								   for user */
 	} else {
 #endif
-	    shm_addr_offset = (void *) ((char *) (shm->addr) + 32);
-	    max_message_size -= 32;	/* size of cms buffer available for
-					   user */
+	    shm_addr_offset = (void *) ((char *) (shm->addr) + header_size);
+	    max_message_size -= header_size;	/* size of cms buffer
+						   available for user */
 /*! \todo Another #if 0 */
 #if 0				// PC Do we need to use autokey ?
 	}
@@ -359,18 +387,20 @@ int SHMEM::open()
 	/* messages = size - CMS Header space */
 	if (enc_max_size <= 0 || enc_max_size > size) {
 	    if (neutral) {
-		max_encoded_message_size -= 32;
+		max_encoded_message_size -= header_size;
 	    } else {
 		max_encoded_message_size -=
-		    (cms_encoded_data_explosion_factor * 32);
+		    (cms_encoded_data_explosion_factor * header_size);
 	    }
 	}
 	/* Maximum size of message after being encoded. */
-	guaranteed_message_space -= 32;	/* Largest size message before being
-					   encoded that can be guaranteed to
-					   fit after xdr. */
-	size -= 32;
-	size_without_diagnostics -= 32;
+	guaranteed_message_space -= header_size;	/* Largest size message
+							   before being encoded
+							   that can be
+							   guaranteed to fit
+							   after xdr. */
+	size -= header_size;
+	size_without_diagnostics -= header_size;
 	subdiv_size =
 	    (size_without_diagnostics -
 	    total_connections) / total_subdivisions;
@@ -381,7 +411,7 @@ int SHMEM::open()
 	}
 	shm_addr_offset = shm->addr;
     }
-    skip_area = 32 + total_connections + autokey_table_size;
+    skip_area = header_size + total_connections + autokey_table_size;
     mao.data = shm_addr_offset;
     mao.timeout = timeout;
     mao.total_connections = total_connections;
@@ -462,7 +492,7 @@ CMS_STATUS SHMEM::main_access(void *_local, int *serial_number)
 	return (status = CMS_MISC_ERROR);
     }
 
-    if (bsem == NULL && not_zero(blocking_timeout)) {
+    if (bsem == NULL && futex == NULL && not_zero(blocking_timeout)) {
 	rcs_print_error
 	    ("No blocking semaphore available. Can not call blocking_read(%f).\n",
 	    blocking_timeout);
@@ -470,6 +500,8 @@ CMS_STATUS SHMEM::main_access(void *_local, int *serial_number)
 	return (status = CMS_NO_BLOCKING_SEM_ERROR);
     }
 
+    uint32_t futex_seq = 0;
+
     mao.read_only = ((internal_access_type == CMS_CHECK_IF_READ_ACCESS) ||
 	(internal_access_type == CMS_PEEK_ACCESS) ||
 	(internal_access_type == CMS_READ_ACCESS));
@@ -533,6 +565,28 @@ CMS_STATUS SHMEM::main_access(void *_local, int *serial_number)
 	return (status = CMS_MISC_ERROR);
 	break;
 
+    case FUTEX_MUTEX:
+	switch (rcs_futex_lock(futex, timeout)) {
+	case -1:
+	    rcs_print_error("SHMEM: Can't take futex\n");
+	    second_read = 0;
+	    return (status = CMS_MISC_ERROR);
+	case -2:
+	    if (timeout > 0) {
+		rcs_print_error("SHMEM: Timed out waiting for futex.\n");
+		rcs_print_error("buffer = %s, timeout = %lf sec.\n",
+		    BufferName, timeout);
+	    }
+	    second_read = 0;
+	    return (status = CMS_TIMED_OUT);
+	default:
+	    break;
+	}
+	/* Taken under the lock, so any write that this read misses is
+	   guaranteed to bump the sequence afterwards. */
+	futex_seq = rcs_futex_seq(futex);
+	break;
+
     default:
 	rcs_print_error("SHMEM: Invalid mutex type.(%d)\n", mutex_type);
 	second_read = 0;
@@ -573,11 +627,47 @@ CMS_STATUS SHMEM::main_access(void *_local, int *serial_number)
     case NO_SWITCHING_MUTEX:
 	rcs_print_error("Can not restore interrupts.\n");
 	break;
+
+    case FUTEX_MUTEX:
+	rcs_futex_unlock(futex);
+	if (internal_access_type == CMS_WRITE_ACCESS
+	    || internal_access_type == CMS_WRITE_IF_READ_ACCESS) {
+	    rcs_futex_notify(futex);
+	}
+	break;
     }
 
     switch (internal_access_type) {
 
     case CMS_READ_ACCESS:
+	if (NULL != futex && status == CMS_READ_OLD &&
+	    not_zero(blocking_timeout)) {
+	    if (second_read > 10 && total_subdivisions <= 1) {
+		status = CMS_MISC_ERROR;
+		rcs_print_error
+		    ("CMS: Futex wait error. The wait has returned %d times but there is still no new data.\n",
+		    second_read);
+		second_read = 0;
+		return (status);
+	    }
+	    second_read++;
+	    /* A negative blocking_timeout means wait forever. */
+	    int futex_ret = rcs_futex_wait_seq(futex, futex_seq,
+		blocking_timeout);
+	    if (futex_ret == -2) {
+		status = CMS_TIMED_OUT;
+		second_read = 0;
+		return (status);
+	    }
+	    if (futex_ret == -1) {
+		rcs_print_error("CMS: Futex wait error.\n");
+		status = CMS_MISC_ERROR;
+		second_read = 0;
+		return (status);
+	    }
+	    main_access(_local, serial_number);
+	    break;
+	}
 	if (NULL != bsem && status == CMS_READ_OLD &&
 	    not_zero(blocking_timeout)) {
 	    if (second_read > 10 && total_subdivisions <= 1) {
@@ -33,6 +33,7 @@ extern "C" {
 #include "cms.hh"		/* class CMS */
 #include "shm.hh"		/* class RCS_SHAREDMEM */
 #include "memsem.hh"		/* struct mem_access_object */
+#include "_futex.h"		/* rcs_futex_block */
 
 class SHMEM:public CMS {
   public:
@@ -65,7 +66,8 @@ class SHMEM:public CMS {
 	MAO_MUTEX_W_OS_SEM,
 	OS_SEM_MUTEX,
 	NO_INTERRUPTS_MUTEX,
-	NO_SWITCHING_MUTEX
+	NO_SWITCHING_MUTEX,
+	FUTEX_MUTEX
     };
 
     int use_os_sem;
@@ -75,6 +77,7 @@ class SHMEM:public CMS {
     void *shm_addr_offset;
 
     RCS_SEMAPHORE *bsem;	// blocking semaphore
+    rcs_futex_block *futex;	// lock and write sequence for MUTEX=FUTEX
     int autokey_table_size;
 
 };
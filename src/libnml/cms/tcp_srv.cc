@@ -31,6 +31,8 @@ extern "C" {
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>		// epoll_create1(), epoll_wait()
+#include <sys/uio.h>		// struct iovec
 #include <errno.h>		/* errno */
 #include <signal.h>		// SIGPIPE, signal()
 
@@ -132,9 +134,7 @@ TCPSVR_BLOCKING_READ_REQUEST::~TCPSVR_BLOCKING_READ_REQUEST()
 CMS_SERVER_REMOTE_TCP_PORT::CMS_SERVER_REMOTE_TCP_PORT(CMS_SERVER * _cms_server)
   : CMS_SERVER_REMOTE_PORT(_cms_server),
     dtimeout(20.0),
-    read_fd_set{},
-    write_fd_set{},
-    maxfdpl(0),
+    epoll_fd(-1),
     subscription_buffers(NULL),
     connection_socket(0),
     connection_port(0),
@@ -142,7 +142,7 @@ CMS_SERVER_REMOTE_TCP_PORT::CMS_SERVER_REMOTE_TCP_PORT(CMS_SERVER * _cms_server)
     temp_buffer{},
     current_poll_interval_millis(30000),
     polling_enabled(0),
-    select_timeout{.tv_sec = 30, .tv_usec = 30}
+    next_poll_time(0.0)
 {
     memset(&server_socket_address, 0, sizeof(server_socket_address));
     server_socket_address.sin_family = AF_INET;
@@ -219,6 +219,10 @@ void CMS_SERVER_REMOTE_TCP_PORT::unregister_port()
 	close(connection_socket);
 	connection_socket = 0;
     }
+    if (epoll_fd >= 0) {
+	close(epoll_fd);
+	epoll_fd = -1;
+    }
 }
 
 int CMS_SERVER_REMOTE_TCP_PORT::accept_local_port_cms(CMS * _cms)
@@ -301,203 +305,178 @@ static void handle_pipe_error(int signum)
     rcs_print_error("SIGPIPE intercepted.\n");
 }
 
+int CMS_SERVER_REMOTE_TCP_PORT::watch_fd(int fd, CLIENT_TCP_PORT * clnt)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = clnt;		/* NULL marks the connection socket */
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+	rcs_print_error("server: epoll_ctl error.(errno = %d | %s)\n",
+	    errno, strerror(errno));
+	return -1;
+    }
+    return 0;
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::accept_client()
+{
+    socklen_t client_address_length;
+    CLIENT_TCP_PORT *new_client_port = new CLIENT_TCP_PORT();
+    client_address_length = sizeof(new_client_port->address);
+    new_client_port->socket_fd = accept(connection_socket,
+	(struct sockaddr *)
+	&new_client_port->address, &client_address_length);
+    if (new_client_port->socket_fd < 0) {
+	rcs_print_error("server: accept error -- %d %s \n", errno,
+	    strerror(errno));
+	delete new_client_port;
+	return;
+    }
+    current_clients++;
+    if (current_clients > max_clients) {
+	max_clients = current_clients;
+    }
+    rcs_print_debug(PRINT_SOCKET_CONNECT,
+	"Socket opened by host with IP address %s.\n",
+	inet_ntoa(new_client_port->address.sin_addr));
+    new_client_port->serial_number = 0;
+    new_client_port->blocking = 0;
+    if (watch_fd(new_client_port->socket_fd, new_client_port) < 0) {
+	delete new_client_port;
+	current_clients--;
+	return;
+    }
+    new_client_port->list_id =
+	client_ports->store_at_tail(new_client_port,
+	sizeof(new_client_port), 0);
+}
+
+void CMS_SERVER_REMOTE_TCP_PORT::remove_client(CLIENT_TCP_PORT * clnt)
+{
+    if (NULL != clnt->subscriptions) {
+	TCP_CLIENT_SUBSCRIPTION_INFO *clnt_sub_info =
+	    (TCP_CLIENT_SUBSCRIPTION_INFO *) clnt->subscriptions->get_head();
+	while (NULL != clnt_sub_info) {
+	    TCP_BUFFER_SUBSCRIPTION_INFO *buf_info =
+		clnt_sub_info->sub_buf_info;
+	    if (NULL != buf_info && NULL != buf_info->sub_clnt_info) {
+		buf_info->sub_clnt_info->delete_node(clnt_sub_info->
+		    buffer_list_id);
+		if (buf_info->sub_clnt_info->list_size < 1) {
+		    if (NULL != subscription_buffers) {
+			subscription_buffers->delete_node(buf_info->list_id);
+		    }
+		    delete buf_info;
+		}
+	    }
+	    clnt_sub_info->sub_buf_info = NULL;
+	    delete clnt_sub_info;
+	    clnt_sub_info =
+		(TCP_CLIENT_SUBSCRIPTION_INFO *) clnt->subscriptions->
+		get_next();
+	}
+	delete clnt->subscriptions;
+	clnt->subscriptions = NULL;
+	recalculate_polling_interval();
+    }
+    if (clnt->threadId > 0 && clnt->blocking) {
+	blocking_thread_kill(clnt->threadId);
+    }
+    if (clnt->socket_fd >= 0) {
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, clnt->socket_fd, NULL);
+	close(clnt->socket_fd);
+	clnt->socket_fd = -1;
+    }
+    current_clients--;
+    client_ports->delete_node(clnt->list_id);
+    delete clnt;
+}
+
+int CMS_SERVER_REMOTE_TCP_PORT::poll_timeout_millis()
+{
+    if (!polling_enabled) {
+	return -1;
+    }
+    int millis = (int) ((next_poll_time - etime()) * 1000.0);
+    if (millis < 0) {
+	return 0;
+    }
+    if (millis > current_poll_interval_millis) {
+	return current_poll_interval_millis;
+    }
+    return millis;
+}
+
 void CMS_SERVER_REMOTE_TCP_PORT::run()
 {
     int bytes_ready;
     int ready_descriptors;
+    struct epoll_event events[TCP_SRV_MAX_EPOLL_EVENTS];
     if (NULL == client_ports) {
 	rcs_print_error("CMS_SERVER: List of client ports is NULL.\n");
 	return;
     }
-    CLIENT_TCP_PORT *new_client_port, *client_port_to_check;
-    FD_ZERO(&read_fd_set);
-    FD_ZERO(&write_fd_set);
-    FD_SET(connection_socket, &read_fd_set);
-    maxfdpl = connection_socket + 1;
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+	rcs_print_error("server: epoll_create1 error.(errno = %d | %s)\n",
+	    errno, strerror(errno));
+	return;
+    }
+    if (watch_fd(connection_socket, NULL) < 0) {
+	return;
+    }
     signal(SIGPIPE, handle_pipe_error);
     rcs_print_debug(PRINT_CMS_CONFIG_INFO,
 	"running server for TCP port %d (connection_socket = %d).\n",
 	ntohs(server_socket_address.sin_port), connection_socket);
 
     cms_server_count++;
-    fd_set read_fd_set_copy, write_fd_set_copy;
-    FD_ZERO(&read_fd_set_copy);
-    FD_ZERO(&write_fd_set_copy);
-    FD_SET(connection_socket, &read_fd_set_copy);
 
     while (1) {
-	if (polling_enabled) {
-	    memcpy(&read_fd_set_copy, &read_fd_set, sizeof(fd_set));
-	    memcpy(&write_fd_set_copy, &write_fd_set, sizeof(fd_set));
-	    select_timeout.tv_sec = current_poll_interval_millis / 1000;
-	    select_timeout.tv_usec =
-		(current_poll_interval_millis % 1000) * 1000;
-	    ready_descriptors =
-		select(maxfdpl, &read_fd_set, &write_fd_set,
-		(fd_set *) NULL, (timeval *) & select_timeout);
-	    if (ready_descriptors == 0) {
-		update_subscriptions();
-		memcpy(&read_fd_set, &read_fd_set_copy, sizeof(fd_set));
-		memcpy(&write_fd_set, &write_fd_set_copy, sizeof(fd_set));
-		continue;
-	    }
-	} else {
-	    ready_descriptors =
-		select(maxfdpl, &read_fd_set, &write_fd_set,
-		(fd_set *) NULL, (timeval *) NULL);
-
-	}
+	ready_descriptors = epoll_wait(epoll_fd, events,
+	    TCP_SRV_MAX_EPOLL_EVENTS, poll_timeout_millis());
 	if (ready_descriptors < 0) {
-	    rcs_print_error("server: select error.(errno = %d | %s)\n",
-		errno, strerror(errno));
+	    if (errno != EINTR) {
+		rcs_print_error("server: epoll_wait error.(errno = %d | %s)\n",
+		    errno, strerror(errno));
+	    }
+	    continue;
 	}
 	if (NULL == client_ports) {
 	    rcs_print_error("CMS_SERVER: List of client ports is NULL.\n");
 	    return;
 	}
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (FD_ISSET(client_port_to_check->socket_fd, &read_fd_set)) {
-		ioctl(client_port_to_check->socket_fd, FIONREAD,
-		    (caddr_t) & bytes_ready);
-		if (bytes_ready <= 0) {
-		    rcs_print_debug(PRINT_SOCKET_CONNECT,
-			"Socket closed by host with IP address %s.\n",
-			inet_ntoa(client_port_to_check->address.sin_addr));
-		    if (NULL != client_port_to_check->subscriptions) {
-			TCP_CLIENT_SUBSCRIPTION_INFO *clnt_sub_info =
-			    (TCP_CLIENT_SUBSCRIPTION_INFO *)
-			    client_port_to_check->subscriptions->get_head();
-			while (NULL != clnt_sub_info) {
-			    if (NULL != clnt_sub_info->sub_buf_info &&
-				clnt_sub_info->subscription_list_id >= 0) {
-				if (NULL !=
-				    clnt_sub_info->sub_buf_info->
-				    sub_clnt_info) {
-				    clnt_sub_info->sub_buf_info->
-					sub_clnt_info->
-					delete_node(clnt_sub_info->
-					subscription_list_id);
-				    if (clnt_sub_info->sub_buf_info->
-					sub_clnt_info->list_size < 1) {
-					delete clnt_sub_info->sub_buf_info->
-					    sub_clnt_info;
-					clnt_sub_info->sub_buf_info->
-					    sub_clnt_info = NULL;
-					if (NULL != subscription_buffers
-					    && clnt_sub_info->sub_buf_info->
-					    list_id >= 0) {
-					    subscription_buffers->
-						delete_node(clnt_sub_info->
-						sub_buf_info->list_id);
-					    delete clnt_sub_info->
-						sub_buf_info;
-					    clnt_sub_info->sub_buf_info =
-						NULL;
-					}
-				    }
-				    clnt_sub_info->sub_buf_info = NULL;
-				}
-				delete clnt_sub_info;
-				clnt_sub_info =
-				    (TCP_CLIENT_SUBSCRIPTION_INFO *)
-				    client_port_to_check->subscriptions->
-				    get_next();
-			    }
-			    delete client_port_to_check->subscriptions;
-			    client_port_to_check->subscriptions = NULL;
-			    recalculate_polling_interval();
-			}
-		    }
-		    if (client_port_to_check->threadId > 0
-			&& client_port_to_check->blocking) {
-			blocking_thread_kill(client_port_to_check->threadId);
-		    }
-		    close(client_port_to_check->socket_fd);
-		    FD_CLR(client_port_to_check->socket_fd, &read_fd_set);
-		    client_port_to_check->socket_fd = -1;
-		    delete client_port_to_check;
-		    client_ports->delete_current_node();
-		} else {
-		    if (client_port_to_check->blocking) {
-			if (client_port_to_check->threadId > 0) {
-			    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
-				"Data received from %s:%d when it should be blocking (bytes_ready=%d).\n",
-				inet_ntoa
-				(client_port_to_check->address.
-				    sin_addr),
-				client_port_to_check->socket_fd, bytes_ready);
-			    rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
-				"Killing handler %d.\n",
-				client_port_to_check->threadId);
-
-			    blocking_thread_kill
-				(client_port_to_check->threadId);
-#if 0
-			    *((uint32_t *) temp_buffer) =
-				htonl(client_port_to_check->serial_number);
-			    *((uint32_t *) temp_buffer + 1) =
-				htonl((unsigned long)
-				CMS_SERVER_SIDE_ERROR);
-			    putbe32(temp_buffer + 8, 0);	/* size
-									 */
-			    putbe32(temp_buffer + 12, 0);	/* write_id
-									 */
-			    putbe32(temp_buffer + 16, 0);	/* was_read
-									 */
-			    sendn(client_port_to_check->socket_fd,
-				temp_buffer, 20, 0, dtimeout);
-#endif
-			    client_port_to_check->threadId = 0;
-			    client_port_to_check->blocking = 0;
-			}
-		    }
-		    handle_request(client_port_to_check);
-		}
-		ready_descriptors--;
-	    } else {
-		FD_SET(client_port_to_check->socket_fd, &read_fd_set);
-	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	if (FD_ISSET(connection_socket, &read_fd_set)
-	    && ready_descriptors > 0) {
-	    ready_descriptors--;
-	    socklen_t client_address_length;
-	    new_client_port = new CLIENT_TCP_PORT();
-	    client_address_length = sizeof(new_client_port->address);
-	    new_client_port->socket_fd = accept(connection_socket,
-		(struct sockaddr *)
-		&new_client_port->address, &client_address_length);
-	    current_clients++;
-	    if (current_clients > max_clients) {
-		max_clients = current_clients;
-	    }
-	    if (new_client_port->socket_fd < 0) {
-		rcs_print_error("server: accept error -- %d %s \n", errno,
-		    strerror(errno));
+	for (int i = 0; i < ready_descriptors; i++) {
+	    CLIENT_TCP_PORT *client_port_to_check =
+		(CLIENT_TCP_PORT *) events[i].data.ptr;
+	    if (NULL == client_port_to_check) {
+		accept_client();
 		continue;
 	    }
-	    rcs_print_debug(PRINT_SOCKET_CONNECT,
-		"Socket opened by host with IP address %s.\n",
-		inet_ntoa(new_client_port->address.sin_addr));
-	    new_client_port->serial_number = 0;
-	    new_client_port->blocking = 0;
-	    if (NULL != client_ports) {
-		client_ports->store_at_tail(new_client_port,
-		    sizeof(new_client_port), 0);
+	    bytes_ready = 0;
+	    ioctl(client_port_to_check->socket_fd, FIONREAD,
+		(caddr_t) & bytes_ready);
+	    if (bytes_ready <= 0) {
+		rcs_print_debug(PRINT_SOCKET_CONNECT,
+		    "Socket closed by host with IP address %s.\n",
+		    inet_ntoa(client_port_to_check->address.sin_addr));
+		remove_client(client_port_to_check);
+		continue;
 	    }
-	    if (maxfdpl < new_client_port->socket_fd + 1) {
-		maxfdpl = new_client_port->socket_fd + 1;
+	    if (client_port_to_check->blocking
+		&& client_port_to_check->threadId > 0) {
+		rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
+		    "Data received from %s:%d when it should be blocking (bytes_ready=%d).\n",
+		    inet_ntoa(client_port_to_check->address.sin_addr),
+		    client_port_to_check->socket_fd, bytes_ready);
+		rcs_print_debug(PRINT_SERVER_THREAD_ACTIVITY,
+		    "Killing handler %d.\n", client_port_to_check->threadId);
+		blocking_thread_kill(client_port_to_check->threadId);
+		client_port_to_check->threadId = 0;
+		client_port_to_check->blocking = 0;
 	    }
-	    FD_SET(new_client_port->socket_fd, &read_fd_set);
-	} else {
-	    FD_SET(connection_socket, &read_fd_set);
-	}
-	if (0 != ready_descriptors) {
-	    rcs_print_error("%d descriptors ready but not serviced.\n",
-		ready_descriptors);
+	    handle_request(client_port_to_check);
 	}
 	update_subscriptions();
     }
@@ -644,7 +623,6 @@ void *tcpsvr_handle_blocking_request(void *_req)
 void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
     _client_tcp_port)
 {
-    CLIENT_TCP_PORT *client_port_to_check = NULL;
     pid_t pid = getpid();
     pid_t tid = 0;
     CMS_SERVER *server;
@@ -663,20 +641,8 @@ void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
     if (_client_tcp_port->errors >= _client_tcp_port->max_errors) {
 	rcs_print_error("Too many errors - closing connection(%d)\n",
 	    _client_tcp_port->socket_fd);
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (client_port_to_check->socket_fd ==
-		_client_tcp_port->socket_fd) {
-		delete client_port_to_check;
-		client_ports->delete_current_node();
-	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	close(_client_tcp_port->socket_fd);
-	current_clients--;
-	FD_CLR(_client_tcp_port->socket_fd, &read_fd_set);
-	_client_tcp_port->socket_fd = -1;
+	remove_client(_client_tcp_port);
+	return;
     }
 
     if (recvn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, -1, NULL) < 0) {
@@ -713,6 +679,10 @@ void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
 
     switch_function(_client_tcp_port,
 	server, request_type, buffer_number, received_serial_number);
+    if (request_type == REMOTE_CMS_CLOSE_CHANNEL_REQUEST_TYPE) {
+	/* _client_tcp_port was deleted by remove_client() */
+	return;
+    }
 
     if (NULL != _client_tcp_port->diag_info &&
 	NULL != server->last_local_port_used && server->diag_enabled) {
@@ -733,7 +703,6 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
     long request_type, long buffer_number, long /*received_serial_number*/)
 {
     int total_subdivisions = 1;
-    CLIENT_TCP_PORT *client_port_to_check = NULL;
     switch (request_type) {
     case REMOTE_CMS_SET_DIAG_INFO_REQUEST_TYPE:
 	{
@@ -1372,24 +1341,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	break;
 
     case REMOTE_CMS_CLOSE_CHANNEL_REQUEST_TYPE:
-	client_port_to_check = (CLIENT_TCP_PORT *) client_ports->get_head();
-	while (NULL != client_port_to_check) {
-	    if (client_port_to_check->socket_fd ==
-		_client_tcp_port->socket_fd) {
-		break;
-	    }
-	    client_port_to_check =
-		(CLIENT_TCP_PORT *) client_ports->get_next();
-	}
-	FD_CLR(_client_tcp_port->socket_fd, &read_fd_set);
-	close(_client_tcp_port->socket_fd);
-	current_clients--;
-	if (NULL != _client_tcp_port->subscriptions) {
-	    remove_subscription_client(_client_tcp_port, buffer_number);
-	}
-	_client_tcp_port->socket_fd = -1;
-	delete _client_tcp_port;
-	client_ports->delete_current_node();
+	remove_client(_client_tcp_port);
 	break;
 
     case REMOTE_CMS_GET_KEYS_REQUEST_TYPE:
@@ -1551,7 +1503,8 @@ void CMS_SERVER_REMOTE_TCP_PORT::add_subscription_client(int buffer_number,
 	temp_clnt_info->subscription_list_id =
 	    clnt->subscriptions->store_at_tail(temp_clnt_info,
 	    sizeof(*temp_clnt_info), 0);
-	buf_info->sub_clnt_info->store_at_tail(temp_clnt_info,
+	temp_clnt_info->buffer_list_id =
+	    buf_info->sub_clnt_info->store_at_tail(temp_clnt_info,
 	    sizeof(*temp_clnt_info), 0);
     }
     temp_clnt_info->subscription_type = subscription_type;
@@ -1569,7 +1522,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::remove_subscription_client(CLIENT_TCP_PORT *
 	    if (NULL != temp_clnt_info->sub_buf_info) {
 		if (NULL != temp_clnt_info->sub_buf_info->sub_clnt_info) {
 		    temp_clnt_info->sub_buf_info->sub_clnt_info->
-			delete_node(temp_clnt_info->subscription_list_id);
+			delete_node(temp_clnt_info->buffer_list_id);
 		    if (temp_clnt_info->sub_buf_info->sub_clnt_info->
 			list_size == 0) {
 			subscription_buffers->delete_node(temp_clnt_info->
@@ -1581,6 +1534,7 @@ void CMS_SERVER_REMOTE_TCP_PORT::remove_subscription_client(CLIENT_TCP_PORT *
 		    }
 		}
 	    }
+	    clnt->subscriptions->delete_current_node();
 	    delete temp_clnt_info;
 	    temp_clnt_info = NULL;
 	    break;
@@ -1602,10 +1556,14 @@ void CMS_SERVER_REMOTE_TCP_PORT::recalculate_polling_interval()
 	    (TCP_CLIENT_SUBSCRIPTION_INFO *) buf_info->sub_clnt_info->
 	    get_head();
 	while (temp_clnt_info != NULL) {
+	    /* Variable subscriptions are sent whenever the buffer changes,
+	       which the server only notices when it wakes up to poll. */
 	    if (temp_clnt_info->poll_interval_millis <
 		min_poll_interval_millis
-		&& temp_clnt_info->subscription_type ==
-		CMS_POLLED_SUBSCRIPTION) {
+		&& (temp_clnt_info->subscription_type ==
+		    CMS_POLLED_SUBSCRIPTION
+		    || temp_clnt_info->subscription_type ==
+		    CMS_VARIABLE_SUBSCRIPTION)) {
 		min_poll_interval_millis =
 		    temp_clnt_info->poll_interval_millis;
 		polling_enabled = 1;
@@ -1621,14 +1579,36 @@ void CMS_SERVER_REMOTE_TCP_PORT::recalculate_polling_interval()
     } else {
 	current_poll_interval_millis = ((int) (clk_tck() * 1000.0));
     }
-    select_timeout.tv_sec = current_poll_interval_millis / 1000;
-    select_timeout.tv_usec = (current_poll_interval_millis % 1000) * 1000;
+    next_poll_time = etime() + current_poll_interval_millis / 1000.0;
     dtimeout = (current_poll_interval_millis + 10) * 1000.0;
     if (dtimeout < 0.5) {
 	dtimeout = 0.5;
     }
 }
 
+/* Returns nonzero when the client should be sent the next new message in
+   its subscribed buffer at cur_time. For polled subscriptions that are
+   not yet due, *next_due is lowered to the time they become due. */
+static int tcp_subscription_due(TCP_CLIENT_SUBSCRIPTION_INFO * clnt_info,
+    double cur_time, double *next_due)
+{
+    if (clnt_info->subscription_type == CMS_VARIABLE_SUBSCRIPTION) {
+	return 1;
+    }
+    if (clnt_info->subscription_type != CMS_POLLED_SUBSCRIPTION) {
+	return 0;
+    }
+    double due_time = clnt_info->last_sub_sent_time +
+	(clnt_info->poll_interval_millis - 10) / 1000.0;
+    if (cur_time >= due_time) {
+	return 1;
+    }
+    if (due_time < *next_due) {
+	*next_due = due_time;
+    }
+    return 0;
+}
+
 void CMS_SERVER_REMOTE_TCP_PORT::update_subscriptions()
 {
     pid_t pid = getpid();
@@ -1645,9 +1625,31 @@ void CMS_SERVER_REMOTE_TCP_PORT::update_subscriptions()
 	return;
     }
     double cur_time = etime();
+    next_poll_time = cur_time + current_poll_interval_millis / 1000.0;
+    char header[20];
+    struct iovec iov[2];
     TCP_BUFFER_SUBSCRIPTION_INFO *buf_info =
 	(TCP_BUFFER_SUBSCRIPTION_INFO *) subscription_buffers->get_head();
     while (NULL != buf_info) {
+	/* Only touch the buffer if at least one of its subscribers is due,
+	   so a slow poller does not cost a read on every wakeup. */
+	int any_due = 0;
+	TCP_CLIENT_SUBSCRIPTION_INFO *temp_clnt_info =
+	    (TCP_CLIENT_SUBSCRIPTION_INFO *) buf_info->sub_clnt_info->
+	    get_head();
+	while (temp_clnt_info != NULL) {
+	    if (tcp_subscription_due(temp_clnt_info, cur_time,
+		    &next_poll_time)) {
+		any_due = 1;
+	    }
+	    temp_clnt_info = (TCP_CLIENT_SUBSCRIPTION_INFO *)
+		buf_info->sub_clnt_info->get_next();
+	}
+	if (!any_due) {
+	    buf_info = (TCP_BUFFER_SUBSCRIPTION_INFO *)
+		subscription_buffers->get_next();
+	    continue;
+	}
 	server->read_req.buffer_number = buf_info->buffer_number;
 	server->read_req.access_type = CMS_READ_ACCESS;
 	server->read_req.last_id_read = buf_info->min_last_id;
@@ -1665,54 +1667,43 @@ void CMS_SERVER_REMOTE_TCP_PORT::update_subscriptions()
 		subscription_buffers->get_next();
 	    continue;
 	}
-	putbe32(temp_buffer, 0);
-	putbe32(temp_buffer + 4, server->read_reply->status);
-	putbe32(temp_buffer + 8, server->read_reply->size);
-	putbe32(temp_buffer + 12, server->read_reply->write_id);
-	putbe32(temp_buffer + 16, server->read_reply->was_read);
-	TCP_CLIENT_SUBSCRIPTION_INFO *temp_clnt_info =
+	/* The reply is encoded once; only the serial number differs
+	   between the clients it is fanned out to. */
+	putbe32(header + 4, server->read_reply->status);
+	putbe32(header + 8, server->read_reply->size);
+	putbe32(header + 12, server->read_reply->write_id);
+	putbe32(header + 16, server->read_reply->was_read);
+	iov[0].iov_base = header;
+	iov[0].iov_len = 20;
+	iov[1].iov_base = server->read_reply->data;
+	iov[1].iov_len = server->read_reply->size;
+	temp_clnt_info =
 	    (TCP_CLIENT_SUBSCRIPTION_INFO *) buf_info->sub_clnt_info->
 	    get_head();
 	buf_info->min_last_id = server->read_reply->write_id;
 	while (temp_clnt_info != NULL) {
-	    double time_diff = cur_time - temp_clnt_info->last_sub_sent_time;
-	    int time_diff_millis = (int) ((double) time_diff * 1000.0);
 	    rcs_print_debug(PRINT_SERVER_SUBSCRIPTION_ACTIVITY,
-		"Subscription time_diff_millis=%d\n", time_diff_millis);
-	    if (((temp_clnt_info->subscription_type == CMS_POLLED_SUBSCRIPTION
-			&& time_diff_millis + 10 >=
-			temp_clnt_info->poll_interval_millis)
-		    || temp_clnt_info->subscription_type ==
-		    CMS_VARIABLE_SUBSCRIPTION)
+		"Subscription time_diff_millis=%d\n",
+		(int) ((cur_time - temp_clnt_info->last_sub_sent_time) *
+		    1000.0));
+	    double unused_due = next_poll_time;
+	    if (tcp_subscription_due(temp_clnt_info, cur_time, &unused_due)
 		&& temp_clnt_info->last_id_read !=
 		server->read_reply->write_id) {
 		temp_clnt_info->last_id_read = server->read_reply->write_id;
 		temp_clnt_info->last_sub_sent_time = cur_time;
 		temp_clnt_info->clnt_port->serial_number++;
-		putbe32(temp_buffer, temp_clnt_info->clnt_port->serial_number);
-		if (server->read_reply->size < 0x2000 - 20
-		    && server->read_reply->size > 0) {
-		    memcpy(temp_buffer + 20, server->read_reply->data,
-			server->read_reply->size);
-		    if (sendn
-			(temp_clnt_info->clnt_port->socket_fd, temp_buffer,
-			    20 + server->read_reply->size, 0, dtimeout) < 0) {
-			temp_clnt_info->clnt_port->errors++;
-			return;
-		    }
-		} else {
-		    if (sendn(temp_clnt_info->clnt_port->socket_fd,
-			    temp_buffer, 20, 0, dtimeout) < 0) {
-			temp_clnt_info->clnt_port->errors++;
-			return;
-		    }
-		    if (server->read_reply->size > 0) {
-			if (sendn(temp_clnt_info->clnt_port->socket_fd,
-				server->read_reply->data,
-				server->read_reply->size, 0, dtimeout) < 0) {
-			    temp_clnt_info->clnt_port->errors++;
-			    return;
-			}
+		putbe32(header, temp_clnt_info->clnt_port->serial_number);
+		if (sendnv(temp_clnt_info->clnt_port->socket_fd, iov, 2, 0,
+			dtimeout) < 0) {
+		    temp_clnt_info->clnt_port->errors++;
+		}
+		if (temp_clnt_info->subscription_type ==
+		    CMS_POLLED_SUBSCRIPTION) {
+		    double due_time = cur_time +
+			(temp_clnt_info->poll_interval_millis - 10) / 1000.0;
+		    if (due_time < next_poll_time) {
+			next_poll_time = due_time;
 		    }
 		}
 	    }
@@ -1752,6 +1743,7 @@ TCP_CLIENT_SUBSCRIPTION_INFO::TCP_CLIENT_SUBSCRIPTION_INFO()
     poll_interval_millis = 30000;
     last_sub_sent_time = 0.0;
     subscription_list_id = -1;
+    buffer_list_id = -1;
     buffer_number = -1;
     subscription_paused = 0;
     last_id_read = 0;
@@ -1777,6 +1769,7 @@ CLIENT_TCP_PORT::CLIENT_TCP_PORT()
     errors(0),
     max_errors(50),
     socket_fd(-1),
+    list_id(-1),
     subscriptions(NULL),
     tid(-1),
     pid(-1),
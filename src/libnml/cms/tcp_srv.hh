@@ -42,6 +42,7 @@ extern "C" {
 #endif
 
 #define MAX_TCP_BUFFER_SIZE 16
+#define TCP_SRV_MAX_EPOLL_EVENTS 64
 class CLIENT_TCP_PORT;
 
 class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
@@ -57,9 +58,11 @@ class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
     void unregister_port();
     double dtimeout;
   protected:
-      fd_set read_fd_set, write_fd_set;
+    int epoll_fd;
+    int watch_fd(int fd, CLIENT_TCP_PORT *);
+    void accept_client();
+    void remove_client(CLIENT_TCP_PORT *);
     void handle_request(CLIENT_TCP_PORT *);
-    int maxfdpl;
     LinkedList *client_ports;
     LinkedList *subscription_buffers;
     int connection_socket;
@@ -69,7 +72,8 @@ class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
     char temp_buffer[0x2000];
     int current_poll_interval_millis;
     int polling_enabled;
-    struct timeval select_timeout;
+    double next_poll_time;
+    int poll_timeout_millis();
     void update_subscriptions();
     void add_subscription_client(int buffer_number, int subscription_type,
 	int poll_interval_millis, CLIENT_TCP_PORT * clnt);
@@ -100,6 +104,7 @@ class TCP_CLIENT_SUBSCRIPTION_INFO {
     int poll_interval_millis;
     double last_sub_sent_time;
     int subscription_list_id;
+    int buffer_list_id;
     int buffer_number;
     int subscription_paused;
     int last_id_read;
@@ -117,6 +122,7 @@ class CLIENT_TCP_PORT {
     int errors, max_errors;
     struct sockaddr_in address;
     int socket_fd;
+    int list_id;
     LinkedList *subscriptions;
     pid_t tid;
     pid_t pid;
@@ -0,0 +1,141 @@
+/********************************************************************
+* Description: nml_pingpong.cc
+*   Round trip latency benchmark for same-host NML SHMEM buffers.
+*
+*   Two processes bounce an NML_TEXT message back and forth through a
+*   pair of buffers using NML::blocking_read(), once with the SysV
+*   blocking semaphore (bsem=) and once with mutex=futex, and print the
+*   round trip time distribution for each.
+*
+*     nml-pingpong [count]
+*
+* Author:
+* License: GPL Version 2
+* System: Linux
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <vector>
+
+#include "nml.hh"
+#include "nml_oi.hh"
+#include "rcs_print.hh"
+
+static double now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+static int write_config(const char *path, const char *ping_opts,
+    const char *pong_opts)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) {
+	perror(path);
+	return -1;
+    }
+    fprintf(f,
+	"B ping SHMEM localhost 1024 0 0 1 16 18701 %s\n"
+	"B pong SHMEM localhost 1024 0 0 2 16 18702 %s\n"
+	"P ping ping LOCAL localhost RW 0 1.0 1 0\n"
+	"P ping pong LOCAL localhost RW 0 1.0 1 0\n"
+	"P pong ping LOCAL localhost RW 0 1.0 0 1\n"
+	"P pong pong LOCAL localhost RW 0 1.0 0 1\n", ping_opts, pong_opts);
+    fclose(f);
+    return 0;
+}
+
+static void ponger(const char *cfg, int count)
+{
+    NML in(nmlErrorFormat, "ping", "pong", cfg);
+    NML out(nmlErrorFormat, "pong", "pong", cfg);
+    NML_TEXT msg;
+    if (!in.valid() || !out.valid()) {
+	_exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+	while (in.blocking_read(1.0) == 0) {
+	}
+	msg = *(NML_TEXT *) in.get_address();
+	out.write(msg);
+    }
+    _exit(0);
+}
+
+static int run(const char *label, const char *ping_opts,
+    const char *pong_opts, int count)
+{
+    char cfg[] = "/tmp/nml-pingpong-XXXXXX";
+    int fd = mkstemp(cfg);
+    if (fd < 0) {
+	perror("mkstemp");
+	return -1;
+    }
+    close(fd);
+    if (write_config(cfg, ping_opts, pong_opts) < 0) {
+	return -1;
+    }
+
+    std::vector<double> rtt;
+    rtt.reserve(count);
+    {
+	NML out(nmlErrorFormat, "ping", "ping", cfg);
+	NML in(nmlErrorFormat, "pong", "ping", cfg);
+	if (!in.valid() || !out.valid()) {
+	    fprintf(stderr, "%s: could not open buffers\n", label);
+	    unlink(cfg);
+	    return -1;
+	}
+	pid_t pid = fork();
+	if (pid == 0) {
+	    ponger(cfg, count);
+	}
+	NML_TEXT msg;
+	for (int i = 0; i < count; i++) {
+	    snprintf(msg.text, sizeof(msg.text), "%d", i);
+	    double t0 = now_us();
+	    out.write(msg);
+	    while (in.blocking_read(1.0) == 0) {
+	    }
+	    rtt.push_back(now_us() - t0);
+	}
+	waitpid(pid, NULL, 0);
+    }
+    unlink(cfg);
+
+    std::sort(rtt.begin(), rtt.end());
+    double sum = 0;
+    for (double v : rtt) {
+	sum += v;
+    }
+    printf("%-6s round trip us: min %7.1f  avg %7.1f  p50 %7.1f  "
+	"p99 %7.1f  max %8.1f\n", label, rtt.front(), sum / rtt.size(),
+	rtt[rtt.size() / 2], rtt[(size_t) (rtt.size() * 0.99)],
+	rtt.back());
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 10000;
+    if (count < 1) {
+	fprintf(stderr, "usage: %s [count]\n", argv[0]);
+	return 1;
+    }
+    set_rcs_print_destination(RCS_PRINT_TO_STDERR);
+    if (run("bsem", "bsem=18711", "bsem=18712", count) < 0) {
+	return 1;
+    }
+    if (run("futex", "mutex=futex", "mutex=futex", count) < 0) {
+	return 1;
+    }
+    return 0;
+}
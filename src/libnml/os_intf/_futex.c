@@ -0,0 +1,149 @@
+/********************************************************************
+* Description: _futex.c
+*   Futex based mutex and change notification for buffers that live in
+*   memory shared between processes on the same host.
+*
+*   The mutex is the three state lock from Drepper's "Futexes Are
+*   Tricky". Writers bump a sequence number after each write and only
+*   enter the kernel when a reader has registered itself as waiting, so
+*   an uncontended access never makes a system call.
+*
+* Author:
+* License: LGPL Version 2
+* System: Linux
+********************************************************************/
+
+#include <errno.h>		/* errno */
+#include <limits.h>		/* INT_MAX */
+#include <string.h>		/* strerror() */
+#include <time.h>		/* struct timespec */
+#include <unistd.h>		/* syscall() */
+#include <sys/syscall.h>	/* SYS_futex */
+#include <linux/futex.h>	/* FUTEX_WAIT, FUTEX_WAKE */
+#include "_futex.h"
+#include "rcs_print.hh"		/* rcs_print_error() */
+
+/* The memory is shared between processes, so the non-private futex
+   operations have to be used. */
+static long sys_futex(uint32_t * uaddr, int op, uint32_t val,
+    const struct timespec *ts)
+{
+    return syscall(SYS_futex, uaddr, op, val, ts, NULL, 0);
+}
+
+/* Convert a timeout in seconds to an absolute CLOCK_MONOTONIC deadline,
+   so EINTR restarts and spurious wakeups do not extend the wait. */
+static void futex_deadline(struct timespec *deadline, double timeout)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += (time_t) timeout;
+    deadline->tv_nsec += (long) ((timeout - (time_t) timeout) * 1e9);
+    if (deadline->tv_nsec >= 1000000000L) {
+	deadline->tv_sec++;
+	deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+/* Sleep while *uaddr == val. Returns 0 when woken (or the value already
+   changed), -2 once the deadline passed and -1 on error. */
+static int futex_wait_until(uint32_t * uaddr, uint32_t val,
+    const struct timespec *deadline)
+{
+    struct timespec now, rel, *relp = NULL;
+
+    if (deadline) {
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	rel.tv_sec = deadline->tv_sec - now.tv_sec;
+	rel.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+	if (rel.tv_nsec < 0) {
+	    rel.tv_sec--;
+	    rel.tv_nsec += 1000000000L;
+	}
+	if (rel.tv_sec < 0) {
+	    return -2;
+	}
+	relp = &rel;
+    }
+    if (sys_futex(uaddr, FUTEX_WAIT, val, relp) == 0) {
+	return 0;
+    }
+    switch (errno) {
+    case EAGAIN:
+    case EINTR:
+	return 0;
+    case ETIMEDOUT:
+	return -2;
+    default:
+	rcs_print_error("futex wait failed: %d %s\n", errno,
+	    strerror(errno));
+	return -1;
+    }
+}
+
+int rcs_futex_lock(rcs_futex_block * fb, double timeout)
+{
+    struct timespec deadline, *dp = NULL;
+    uint32_t c = 0;
+    int ret;
+
+    if (__atomic_compare_exchange_n(&fb->lock, &c, 1, 0,
+	    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+	return 0;
+    }
+    if (timeout > 0) {
+	futex_deadline(&deadline, timeout);
+	dp = &deadline;
+    }
+    if (c != 2) {
+	c = __atomic_exchange_n(&fb->lock, 2, __ATOMIC_ACQUIRE);
+    }
+    while (c != 0) {
+	ret = futex_wait_until(&fb->lock, 2, dp);
+	if (ret < 0) {
+	    return ret;
+	}
+	c = __atomic_exchange_n(&fb->lock, 2, __ATOMIC_ACQUIRE);
+    }
+    return 0;
+}
+
+void rcs_futex_unlock(rcs_futex_block * fb)
+{
+    if (__atomic_fetch_sub(&fb->lock, 1, __ATOMIC_RELEASE) != 1) {
+	__atomic_store_n(&fb->lock, 0, __ATOMIC_RELEASE);
+	sys_futex(&fb->lock, FUTEX_WAKE, 1, NULL);
+    }
+}
+
+uint32_t rcs_futex_seq(rcs_futex_block * fb)
+{
+    return __atomic_load_n(&fb->seq, __ATOMIC_ACQUIRE);
+}
+
+void rcs_futex_notify(rcs_futex_block * fb)
+{
+    __atomic_fetch_add(&fb->seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&fb->waiters, __ATOMIC_SEQ_CST) != 0) {
+	sys_futex(&fb->seq, FUTEX_WAKE, INT_MAX, NULL);
+    }
+}
+
+int rcs_futex_wait_seq(rcs_futex_block * fb, uint32_t seen, double timeout)
+{
+    struct timespec deadline, *dp = NULL;
+    int ret = 0;
+
+    if (timeout > 0) {
+	futex_deadline(&deadline, timeout);
+	dp = &deadline;
+    }
+    __atomic_fetch_add(&fb->waiters, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&fb->seq, __ATOMIC_SEQ_CST) == seen) {
+	ret = futex_wait_until(&fb->seq, seen, dp);
+	if (ret < 0) {
+	    break;
+	}
+    }
+    __atomic_fetch_sub(&fb->waiters, 1, __ATOMIC_SEQ_CST);
+    return ret;
+}
@@ -0,0 +1,40 @@
+/********************************************************************
+* Description: _futex.h
+*   Futex based mutex and change notification for buffers that live in
+*   memory shared between processes on the same host.
+*
+* Author:
+* License: LGPL Version 2
+* System: Linux
+********************************************************************/
+
+#ifndef _RCS_FUTEX_H
+#define _RCS_FUTEX_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Control block kept in the shared memory segment itself. */
+    typedef struct rcs_futex_block {
+	uint32_t lock;		/* 0 free, 1 taken, 2 taken with waiters */
+	uint32_t seq;		/* bumped by every write */
+	uint32_t waiters;	/* readers sleeping on seq */
+	uint32_t reserved;
+    } rcs_futex_block;
+
+/* The lock/wait functions return 0 on success, -2 on timeout and -1 on
+   error, like rcs_sem_wait(). A timeout <= 0 waits forever. */
+    int rcs_futex_lock(rcs_futex_block * fb, double timeout);
+    void rcs_futex_unlock(rcs_futex_block * fb);
+    uint32_t rcs_futex_seq(rcs_futex_block * fb);
+    void rcs_futex_notify(rcs_futex_block * fb);
+    int rcs_futex_wait_seq(rcs_futex_block * fb, uint32_t seen,
+	double timeout);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
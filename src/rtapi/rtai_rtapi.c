@@ -827,6 +827,32 @@ int rtapi_task_start(int task_id, unsigned long int period_nsec)
     return retval;
 }
 
+int rtapi_task_set_cpus(int task_id, const char *cpus)
+{
+    /* validate task ID */
+    if ((task_id < 1) || (task_id > RTAPI_MAX_TASKS)) {
+	return -EINVAL;
+    }
+    /* only the default placement is supported */
+    if (cpus && *cpus) {
+	return -ENOSYS;
+    }
+    return 0;
+}
+
+int rtapi_task_set_sched(int task_id, const char *sched)
+{
+    /* validate task ID */
+    if ((task_id < 1) || (task_id > RTAPI_MAX_TASKS)) {
+	return -EINVAL;
+    }
+    /* only the RTAI scheduler is supported */
+    if (sched && *sched) {
+	return -ENOSYS;
+    }
+    return 0;
+}
+
 void rtapi_wait(void)
 {
     int result = rt_task_wait_period();
@@ -1723,6 +1749,8 @@ EXPORT_SYMBOL(rtapi_prio_next_lower);
 EXPORT_SYMBOL(rtapi_task_new);
 EXPORT_SYMBOL(rtapi_task_delete);
 EXPORT_SYMBOL(rtapi_task_start);
+EXPORT_SYMBOL(rtapi_task_set_cpus);
+EXPORT_SYMBOL(rtapi_task_set_sched);
 EXPORT_SYMBOL(rtapi_wait);
 EXPORT_SYMBOL(rtapi_task_resume);
 EXPORT_SYMBOL(rtapi_task_pause);
@@ -462,6 +462,48 @@ RTAPI_BEGIN_DECLS
  */
     extern int rtapi_task_start(int task_id, unsigned long int period_nsec);
 
+/**
+ * @brief Chooses the CPUs a task runs on.
+ *
+ * Without this call every realtime task goes to the same CPU, normally the
+ * highest numbered one this process may use (or @c RTAPI_CPU_NUMBER). @c cpus
+ * is either a list of CPU numbers and ranges like @c "3" or @c "2,4-5", or
+ * @c "spread", which gives each task asking for it the next CPU from the
+ * isolated CPUs (isolcpus=), or from all CPUs if none are isolated, starting
+ * with the highest. NULL or an empty string restores the default.
+ * @param task_id ID from a previous call to rtapi_task_new().
+ * @param cpus CPU list or policy, see above.
+ * @return 0 on success, @c -EINVAL for a bad task ID or CPU list, @c -ENOSYS
+ *         if the realtime system does not support CPU placement.
+ * @note Call after rtapi_task_new() and before rtapi_task_start(), only from
+ *       within init/cleanup code.
+ */
+    extern int rtapi_task_set_cpus(int task_id, const char *cpus);
+
+/**
+ * @brief Chooses how a task is scheduled and woken up each period.
+ *
+ * @c sched is a comma separated list of
+ *  - @c fifo: the normal realtime priority scheduling (the default),
+ *  - @c deadline[:runtime[:deadline]]: Linux SCHED_DEADLINE, where the kernel
+ *    reserves @c runtime ns of CPU time (default half the period) that must be
+ *    used within @c deadline ns (default the period) of the start of each
+ *    period, and refuses tasks that do not fit on the CPUs,
+ *  - @c nanosleep: sleep until the start of the next period (the default),
+ *  - @c timerfd: wake up from a periodic timer instead, missed periods are
+ *    skipped.
+ * NULL or an empty string restores the defaults.  Tasks that do not call this
+ * get the setting of the environment variable @c RTAPI_SCHED.  The task
+ * changes over at its next rtapi_wait(); if the kernel refuses, an error is
+ * printed and it keeps the old scheduling.
+ * @param task_id ID from a previous call to rtapi_task_new().
+ * @param sched Scheduling, see above.
+ * @return 0 on success, @c -EINVAL for a bad task ID or @c sched, @c -ENOSYS
+ *         if the realtime system does not support it.
+ * @note Call only from within init/cleanup code.
+ */
+    extern int rtapi_task_set_sched(int task_id, const char *sched);
+
 /**
  * @brief Suspends execution of the current task until the next period.
  *
@@ -525,6 +567,18 @@ RTAPI_BEGIN_DECLS
  * @return 0 on success, negative value on failure.
  */
     extern int rtapi_task_pll_set_correction(long value);
+
+/**
+ * @brief Gets how late the current task woke up at the start of this cycle.
+ *
+ * The time is taken in rtapi_wait() right after the wakeup, so it does not
+ * include anything the task did since.
+ * @param latency Set to the time in ns from the ideal start of the cycle to
+ *        the wakeup, negative if the task woke up early.
+ * @return 0 on success, @c -EINVAL if not called from a periodic task,
+ *         @c -ENOSYS if the realtime system cannot tell.
+ */
+    extern int rtapi_task_wakeup_latency(long *latency);
 #endif /* USPACE */
 
 #endif /* RTAPI */
@@ -0,0 +1,538 @@
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#ifndef RTAPI_MSGRING_H
+#define RTAPI_MSGRING_H
+
+/* A fixed size ring of messages that any number of realtime threads can
+   write without locks, and one non-realtime reader takes them out of in
+   order.  Writers never wait: when the ring is full the message is
+   counted in 'lost' and dropped.  The ring is position independent, so
+   it can live in shared memory.
+
+   Each slot has a sequence number.  A slot at position pos has seq ==
+   pos while it is free, pos + 1 once it is written, and pos + nslots
+   after it is read, which frees it for the next lap around the ring.
+
+   In user space, rtapi_msgring_vpush() stores a copy of the format and
+   the raw arguments, strings copied too, so a realtime thread does not
+   run printf; rtapi_msgring_format() turns it into text later, when
+   what they pointed to may be gone.
+
+   The __atomic builtins are used instead of rtapi_atomic.h so that this
+   can be included from C++ too. */
+
+#include "rtapi_stdint.h"
+#if !defined(__KERNEL__)
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#endif
+
+typedef struct {
+    rtapi_u32 seq;		/* see above */
+    rtapi_u32 level;		/* message level, or free for the user */
+    rtapi_s64 time;		/* rtapi_get_time() when it was pushed */
+} rtapi_msgring_slot_t;
+
+typedef struct {
+    rtapi_u32 head;		/* position the next claim gets */
+    rtapi_u32 tail;		/* position the reader takes next */
+    rtapi_u32 lost;		/* claims that found the ring full */
+    rtapi_u32 nslots;		/* a power of two */
+    rtapi_u32 slot_size;	/* bytes per slot, including its header */
+    rtapi_u32 reserved;
+} __attribute__((aligned(8))) rtapi_msgring_t;
+
+/* bytes per slot for 'payload' bytes of message */
+#define RTAPI_MSGRING_SLOT_SIZE(payload) \
+    ((sizeof(rtapi_msgring_slot_t) + (payload) + 7) & ~(size_t)7)
+/* bytes for a ring, including the rtapi_msgring_t it starts with */
+#define RTAPI_MSGRING_SIZE(nslots, payload) \
+    (sizeof(rtapi_msgring_t) + (nslots) * RTAPI_MSGRING_SLOT_SIZE(payload))
+
+static inline rtapi_msgring_slot_t *rtapi_msgring_slot(rtapi_msgring_t *r,
+    rtapi_u32 pos)
+{
+    return (rtapi_msgring_slot_t *)((char *)(r + 1)
+	+ (size_t)(pos & (r->nslots - 1)) * r->slot_size);
+}
+
+static inline void *rtapi_msgring_payload(rtapi_msgring_slot_t *s)
+{
+    return s + 1;
+}
+
+static inline size_t rtapi_msgring_payload_size(const rtapi_msgring_t *r)
+{
+    return r->slot_size - sizeof(rtapi_msgring_slot_t);
+}
+
+/* Sets up the ring at 'r', which must have RTAPI_MSGRING_SIZE(nslots,
+   payload) bytes.  Returns 0, or -1 if nslots is not a power of two. */
+static inline int rtapi_msgring_init(rtapi_msgring_t *r, rtapi_u32 nslots,
+    rtapi_u32 payload)
+{
+    rtapi_u32 i;
+
+    if (nslots == 0 || (nslots & (nslots - 1))) {
+	return -1;
+    }
+    r->head = 0;
+    r->tail = 0;
+    r->lost = 0;
+    r->nslots = nslots;
+    r->slot_size = RTAPI_MSGRING_SLOT_SIZE(payload);
+    r->reserved = 0;
+    for (i = 0; i < nslots; i++) {
+	rtapi_msgring_slot(r, i)->seq = i;
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return 0;
+}
+
+/* Claims the next slot for writing.  Returns NULL, and counts the
+   message as lost, if the ring is full.  Fill in the slot and its
+   payload, then hand it to the reader with rtapi_msgring_publish(). */
+static inline rtapi_msgring_slot_t *rtapi_msgring_claim(rtapi_msgring_t *r)
+{
+    rtapi_msgring_slot_t *s;
+    rtapi_u32 pos, seq;
+
+    if (r->nslots == 0) {
+	return 0;
+    }
+    pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    for (;;) {
+	s = rtapi_msgring_slot(r, pos);
+	seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+	if (seq == pos) {
+	    if (__sync_bool_compare_and_swap(&r->head, pos, pos + 1)) {
+		return s;
+	    }
+	} else if ((rtapi_s32)(seq - pos) < 0) {
+	    /* not read yet since the last lap */
+	    __sync_fetch_and_add(&r->lost, 1);
+	    return 0;
+	}
+	/* another writer got there first */
+	pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void rtapi_msgring_publish(rtapi_msgring_slot_t *s)
+{
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+}
+
+/* Returns the oldest message, or NULL if there is none.  Only one
+   thread may read, and it must call rtapi_msgring_release() when done
+   with the message. */
+static inline rtapi_msgring_slot_t *rtapi_msgring_peek(rtapi_msgring_t *r)
+{
+    rtapi_msgring_slot_t *s;
+
+    if (r->nslots == 0) {
+	return 0;
+    }
+    s = rtapi_msgring_slot(r, r->tail);
+    if (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != r->tail + 1) {
+	return 0;
+    }
+    return s;
+}
+
+static inline void rtapi_msgring_release(rtapi_msgring_t *r,
+    rtapi_msgring_slot_t *s)
+{
+    __atomic_store_n(&s->seq, r->tail + r->nslots, __ATOMIC_RELEASE);
+    r->tail++;
+}
+
+static inline rtapi_u32 rtapi_msgring_lost(rtapi_msgring_t *r)
+{
+    return __atomic_load_n(&r->lost, __ATOMIC_RELAXED);
+}
+
+#if !defined(__KERNEL__)
+
+/* payload of a message pushed with rtapi_msgring_vpush(): this, the
+   format with its '\0', then the arguments */
+typedef struct {
+    rtapi_u32 fmt_len;		/* bytes of the format */
+    rtapi_u32 len;		/* bytes of arguments */
+    rtapi_u32 truncated;	/* the format or arguments after those did
+				   not fit */
+    rtapi_u32 newline;		/* the whole format ends a line */
+} rtapi_msgring_msg_t;
+
+/* one printf conversion */
+typedef struct {
+    const char *start;		/* the '%' */
+    const char *len;		/* the length modifier */
+    int nlen;			/* its characters */
+    int nstar;			/* '*' width and precision */
+    int prec;			/* precision, -1 if none, -2 if '*' */
+    char conv;			/* conversion character */
+} rtapi_msgring_spec_t;
+
+static inline const char *rtapi_msgring_parse(const char *p,
+    rtapi_msgring_spec_t *sp)
+{
+    sp->start = p++;
+    sp->nstar = 0;
+    sp->prec = -1;
+    while (*p && strchr("-+ #0'I", *p)) p++;
+    if (*p == '*') {
+	sp->nstar++;
+	p++;
+    }
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+	p++;
+	sp->prec = 0;
+	if (*p == '*') {
+	    sp->nstar++;
+	    sp->prec = -2;
+	    p++;
+	}
+	while (*p >= '0' && *p <= '9') {
+	    sp->prec = sp->prec * 10 + (*p++ - '0');
+	}
+    }
+    sp->len = p;
+    while (*p && strchr("hlqLjzZt", *p)) p++;
+    sp->nlen = p - sp->len;
+    sp->conv = *p;
+    return *p ? p + 1 : p;
+}
+
+/* the length modifier as one character, 'H' for hh and 'q' for ll */
+static inline char rtapi_msgring_lenmod(const rtapi_msgring_spec_t *sp)
+{
+    if (sp->nlen == 0) {
+	return 0;
+    }
+    if (sp->nlen > 1 && sp->len[0] == sp->len[1]) {
+	return sp->len[0] == 'h' ? 'H' : 'q';
+    }
+    return sp->len[0] == 'Z' ? 'z' : sp->len[0];
+}
+
+#define RTAPI_MSGRING_PUT(type, val) do { \
+	type v_ = (val); \
+	if (pos + sizeof(v_) > size) goto full; \
+	memcpy(buf + pos, &v_, sizeof(v_)); \
+	pos += sizeof(v_); \
+    } while (0)
+
+/* Stores the arguments 'fmt' takes from 'ap' in 'buf', integers widened
+   to long long.  Returns the bytes used, and sets *truncated if they
+   did not all fit. */
+static inline size_t rtapi_msgring_vencode(char *buf, size_t size,
+    const char *fmt, va_list ap, rtapi_u32 *truncated)
+{
+    rtapi_msgring_spec_t sp;
+    const char *s;
+    size_t pos = 0, n;
+    int i, star = 0;
+
+    *truncated = 0;
+    while ((fmt = strchr(fmt, '%'))) {
+	fmt = rtapi_msgring_parse(fmt, &sp);
+	for (i = 0; i < sp.nstar; i++) {
+	    star = va_arg(ap, int);
+	    RTAPI_MSGRING_PUT(int, star);
+	}
+	if (sp.prec == -2) {
+	    /* a negative precision is taken as none */
+	    sp.prec = star < 0 ? -1 : star;
+	}
+	switch (sp.conv) {
+	case 'd': case 'i':
+	    switch (rtapi_msgring_lenmod(&sp)) {
+	    case 'H': RTAPI_MSGRING_PUT(long long, (signed char)va_arg(ap, int)); break;
+	    case 'h': RTAPI_MSGRING_PUT(long long, (short)va_arg(ap, int)); break;
+	    case 'l': RTAPI_MSGRING_PUT(long long, va_arg(ap, long)); break;
+	    case 'q': case 'L': RTAPI_MSGRING_PUT(long long, va_arg(ap, long long)); break;
+	    case 'j': RTAPI_MSGRING_PUT(long long, va_arg(ap, intmax_t)); break;
+	    case 'z': RTAPI_MSGRING_PUT(long long, va_arg(ap, ssize_t)); break;
+	    case 't': RTAPI_MSGRING_PUT(long long, va_arg(ap, ptrdiff_t)); break;
+	    default: RTAPI_MSGRING_PUT(long long, va_arg(ap, int)); break;
+	    }
+	    break;
+	case 'u': case 'o': case 'x': case 'X':
+	    switch (rtapi_msgring_lenmod(&sp)) {
+	    case 'H': RTAPI_MSGRING_PUT(unsigned long long, (unsigned char)va_arg(ap, unsigned)); break;
+	    case 'h': RTAPI_MSGRING_PUT(unsigned long long, (unsigned short)va_arg(ap, unsigned)); break;
+	    case 'l': RTAPI_MSGRING_PUT(unsigned long long, va_arg(ap, unsigned long)); break;
+	    case 'q': case 'L': RTAPI_MSGRING_PUT(unsigned long long, va_arg(ap, unsigned long long)); break;
+	    case 'j': RTAPI_MSGRING_PUT(unsigned long long, va_arg(ap, uintmax_t)); break;
+	    case 'z': RTAPI_MSGRING_PUT(unsigned long long, va_arg(ap, size_t)); break;
+	    case 't': RTAPI_MSGRING_PUT(unsigned long long, va_arg(ap, ptrdiff_t)); break;
+	    default: RTAPI_MSGRING_PUT(unsigned long long, va_arg(ap, unsigned)); break;
+	    }
+	    break;
+	case 'c':
+	    RTAPI_MSGRING_PUT(int, va_arg(ap, int));
+	    break;
+	case 'e': case 'E': case 'f': case 'F':
+	case 'g': case 'G': case 'a': case 'A':
+	    if (rtapi_msgring_lenmod(&sp) == 'L') {
+		RTAPI_MSGRING_PUT(long double, va_arg(ap, long double));
+	    } else {
+		RTAPI_MSGRING_PUT(double, va_arg(ap, double));
+	    }
+	    break;
+	case 'p':
+	    RTAPI_MSGRING_PUT(void *, va_arg(ap, void *));
+	    break;
+	case 's':
+	    s = va_arg(ap, const char *);
+	    if (s == 0) {
+		s = "(null)";
+	    }
+	    if (pos == size) goto full;
+	    /* like printf, read no more than the precision, the string
+	       need not be terminated within it */
+	    if (sp.prec >= 0 && (size_t)sp.prec < size - pos) {
+		n = strnlen(s, sp.prec);
+	    } else {
+		n = strnlen(s, size - pos);
+	    }
+	    if (n == size - pos) {
+		/* keep what fits */
+		memcpy(buf + pos, s, n - 1);
+		buf[size - 1] = '\0';
+		pos = size;
+		goto full;
+	    }
+	    memcpy(buf + pos, s, n);
+	    buf[pos + n] = '\0';
+	    pos += n + 1;
+	    break;
+	case 'n':
+	    (void)va_arg(ap, void *);
+	    break;
+	case 'm':
+	    RTAPI_MSGRING_PUT(int, errno);
+	    break;
+	default:
+	    /* %% and conversions this does not know take no argument */
+	    break;
+	}
+    }
+    return pos;
+full:
+    *truncated = 1;
+    return pos;
+}
+
+#undef RTAPI_MSGRING_PUT
+
+/* Pushes a message without formatting it.  'time' is stored with it.
+   Returns 0, or -1 if the ring was full. */
+static inline int rtapi_msgring_vpush(rtapi_msgring_t *r, int level,
+    rtapi_s64 time, const char *fmt, va_list ap)
+{
+    rtapi_msgring_slot_t *s = rtapi_msgring_claim(r);
+    rtapi_msgring_msg_t *m;
+    size_t size, n, total;
+    char *copy;
+
+    if (s == 0) {
+	return -1;
+    }
+    s->level = level;
+    s->time = time;
+    m = (rtapi_msgring_msg_t *)rtapi_msgring_payload(s);
+    copy = (char *)(m + 1);
+    size = rtapi_msgring_payload_size(r) - sizeof(*m);
+    /* keep half of the room for the arguments if the format is long;
+       the arguments are taken by what is kept of it */
+    n = strnlen(fmt, size / 2);
+    total = n + strlen(fmt + n);
+    memcpy(copy, fmt, n);
+    copy[n] = '\0';
+    m->fmt_len = n + 1;
+    m->newline = total > 0 && fmt[total - 1] == '\n';
+    m->len = rtapi_msgring_vencode(copy + m->fmt_len, size - m->fmt_len,
+	copy, ap, &m->truncated);
+    if (total > n) {
+	m->truncated = 1;
+    }
+    rtapi_msgring_publish(s);
+    return 0;
+}
+
+#define RTAPI_MSGRING_GET(type, var) do { \
+	if (pos + sizeof(type) > m->len) goto cut; \
+	memcpy(&(var), args + pos, sizeof(type)); \
+	pos += sizeof(type); \
+    } while (0)
+
+#define RTAPI_MSGRING_EMIT(val) do { \
+	if (sp.nstar == 0) { \
+	    n = snprintf(buf + o, size - o, spec, val); \
+	} else if (sp.nstar == 1) { \
+	    n = snprintf(buf + o, size - o, spec, star[0], val); \
+	} else { \
+	    n = snprintf(buf + o, size - o, spec, star[0], star[1], val); \
+	} \
+	o += n > 0 ? n : 0; \
+    } while (0)
+
+/* Formats a message pushed with rtapi_msgring_vpush() into 'buf', like
+   snprintf.  If its arguments were truncated, the text stops where they
+   do, with "..." added. */
+static inline int rtapi_msgring_format(char *buf, size_t size,
+    rtapi_msgring_slot_t *s)
+{
+    const rtapi_msgring_msg_t *m =
+	(const rtapi_msgring_msg_t *)rtapi_msgring_payload(s);
+    const char *mfmt = (const char *)(m + 1);
+    const char *args = mfmt + m->fmt_len;
+    const char *fmt = mfmt, *p;
+    rtapi_msgring_spec_t sp;
+    char spec[32], *q;
+    size_t o = 0, pos = 0, n0;
+    long long i;
+    double d;
+    long double ld;
+    void *ptr;
+    int n, c, star[2], k;
+
+    if (size == 0) {
+	return 0;
+    }
+    while (*fmt && o < size - 1) {
+	if (*fmt != '%') {
+	    for (p = fmt; *p && *p != '%'; p++) ;
+	    n0 = p - fmt;
+	    if (n0 > size - 1 - o) {
+		n0 = size - 1 - o;
+	    }
+	    memcpy(buf + o, fmt, n0);
+	    o += n0;
+	    fmt = p;
+	    continue;
+	}
+	p = rtapi_msgring_parse(fmt, &sp);
+	if (sp.conv == '%' || sp.len - sp.start > (int)sizeof(spec) - 4) {
+	    buf[o++] = '%';
+	    fmt = p;
+	    continue;
+	}
+	/* the flags, width and precision as written, then the length
+	   modifier and conversion for the stored argument */
+	memcpy(spec, sp.start, sp.len - sp.start);
+	q = spec + (sp.len - sp.start);
+	for (k = 0; k < sp.nstar; k++) {
+	    RTAPI_MSGRING_GET(int, star[k]);
+	}
+	switch (sp.conv) {
+	case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+	    RTAPI_MSGRING_GET(long long, i);
+	    *q++ = 'l';
+	    *q++ = 'l';
+	    *q++ = sp.conv;
+	    *q = '\0';
+	    RTAPI_MSGRING_EMIT(i);
+	    break;
+	case 'c':
+	    RTAPI_MSGRING_GET(int, c);
+	    *q++ = 'c';
+	    *q = '\0';
+	    RTAPI_MSGRING_EMIT(c);
+	    break;
+	case 'e': case 'E': case 'f': case 'F':
+	case 'g': case 'G': case 'a': case 'A':
+	    if (rtapi_msgring_lenmod(&sp) == 'L') {
+		RTAPI_MSGRING_GET(long double, ld);
+		*q++ = 'L';
+		*q++ = sp.conv;
+		*q = '\0';
+		RTAPI_MSGRING_EMIT(ld);
+	    } else {
+		RTAPI_MSGRING_GET(double, d);
+		*q++ = sp.conv;
+		*q = '\0';
+		RTAPI_MSGRING_EMIT(d);
+	    }
+	    break;
+	case 'p':
+	    RTAPI_MSGRING_GET(void *, ptr);
+	    *q++ = 'p';
+	    *q = '\0';
+	    RTAPI_MSGRING_EMIT(ptr);
+	    break;
+	case 's':
+	    if (pos >= m->len
+		|| (n0 = strnlen(args + pos, m->len - pos)) == m->len - pos) {
+		goto cut;
+	    }
+	    *q++ = 's';
+	    *q = '\0';
+	    RTAPI_MSGRING_EMIT(args + pos);
+	    pos += n0 + 1;
+	    break;
+	case 'm':
+	    RTAPI_MSGRING_GET(int, c);
+	    *q++ = 's';
+	    *q = '\0';
+	    RTAPI_MSGRING_EMIT(strerror(c));
+	    break;
+	case 'n':
+	    break;
+	default:
+	    /* not a conversion this knows, copy it as it is */
+	    n0 = p - fmt;
+	    if (n0 > size - 1 - o) {
+		n0 = size - 1 - o;
+	    }
+	    memcpy(buf + o, fmt, n0);
+	    o += n0;
+	    break;
+	}
+	fmt = p;
+	if (m->truncated && pos >= m->len) {
+	    goto cut;
+	}
+    }
+    if (m->truncated) {
+	goto cut;
+    }
+    if (o > size - 1) {
+	o = size - 1;
+    }
+    buf[o] = '\0';
+    return o;
+cut:
+    if (o > size - 1) {
+	o = size - 1;
+    }
+    buf[o] = '\0';
+    snprintf(buf + o, size - o, "...%s", m->newline ? "\n" : "");
+    return strlen(buf);
+}
+
+#undef RTAPI_MSGRING_GET
+#undef RTAPI_MSGRING_EMIT
+
+#endif /* !__KERNEL__ */
+
+#endif /* RTAPI_MSGRING_H */
@@ -437,17 +437,23 @@ int rtapi_request_firmware(const struct rtapi_firmware **fw, const char *name, s
         return -ENOMEM;
     }
 
-    /* Try to open the kernel-specific file */
-    r = uname(&sysinfo);
-    if (r >= 0) {
-        snprintf(path, sizeof(path), "/%s/%s/%s", basepath, sysinfo.release, name);
+    /* An absolute name is used as it is */
+    if (name[0] == '/') {
+        snprintf(path, sizeof(path), "%s", name);
         fd = open(path, O_RDONLY);
-    }
+    } else {
+        /* Try to open the kernel-specific file */
+        r = uname(&sysinfo);
+        if (r >= 0) {
+            snprintf(path, sizeof(path), "/%s/%s/%s", basepath, sysinfo.release, name);
+            fd = open(path, O_RDONLY);
+        }
 
-    /* If we don't have a valid file descriptor yet, try an alternate location */
-    if (fd < 0) {
-        snprintf(path, sizeof(path), "/%s/%s", basepath, name);
-        fd = open(path, O_RDONLY);
+        /* If we don't have a valid file descriptor yet, try an alternate location */
+        if (fd < 0) {
+            snprintf(path, sizeof(path), "/%s/%s", basepath, name);
+            fd = open(path, O_RDONLY);
+        }
     }
 
 
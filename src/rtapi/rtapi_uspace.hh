@@ -86,11 +86,14 @@ struct RtapiApp
     void unexpected_realtime_delay(rtapi_task *task, int nperiod=1);
     virtual int task_delete(int id) = 0;
     virtual int task_start(int task_id, unsigned long period_nsec) = 0;
+    virtual int task_set_cpus(int task_id, const char *cpus);
+    virtual int task_set_sched(int task_id, const char *sched);
     virtual int task_pause(int task_id) = 0;
     virtual int task_resume(int task_id) = 0;
     virtual int task_self() = 0;
     virtual long long task_pll_get_reference(void) = 0;
     virtual int task_pll_set_correction(long value) = 0;
+    virtual int task_wakeup_latency(long *latency);
     virtual void wait() = 0;
     virtual unsigned char do_inb(unsigned int port) = 0;
     virtual void do_outb(unsigned char value, unsigned int port) = 0;
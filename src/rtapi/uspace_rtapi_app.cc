@@ -34,6 +34,7 @@
 #include <string>
 #include <map>
 #include <algorithm>
+#include <atomic>
 #include <sys/time.h>
 #include <time.h>
 #include <stdlib.h>
@@ -46,6 +47,8 @@
 #ifdef __linux__
 #include <malloc.h>
 #include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
 #endif
 #ifdef __FreeBSD__
 #include <pthread_np.h>
@@ -55,8 +58,7 @@
 #include "hal.h"
 #include "hal/hal_priv.h"
 #include "rtapi_uspace.hh"
-
-#include <boost/lockfree/queue.hpp>
+#include "rtapi_msgring.h"
 
 std::atomic<int> WithRoot::level;
 static uid_t euid, ruid;
@@ -83,13 +85,34 @@ namespace
 {
 RtapiApp &App();
 
-struct message_t {
-    msg_level_t level;
-    char msg[1024-sizeof(level)];
-};
-
-boost::lockfree::queue<message_t, boost::lockfree::capacity<128>>
-rtapi_msg_queue;
+// messages from realtime threads, formatted by queue_function
+#define RTAPI_MSG_SLOTS 256
+#define RTAPI_MSG_PAYLOAD 488
+union {
+    rtapi_msgring_t ring;
+    char mem[RTAPI_MSGRING_SIZE(RTAPI_MSG_SLOTS, RTAPI_MSG_PAYLOAD)];
+} rtapi_msg_ring;
+pthread_mutex_t rtapi_msg_lock = PTHREAD_MUTEX_INITIALIZER;
+rtapi_u32 rtapi_msg_lost;
+
+// also called before a module is unloaded, so the messages of its tasks
+// come out before those of its exit
+static void drain_messages() {
+    rtapi_msgring_slot_t *s;
+    char buf[1024];
+    pthread_mutex_lock(&rtapi_msg_lock);
+    while((s = rtapi_msgring_peek(&rtapi_msg_ring.ring))) {
+        rtapi_msgring_format(buf, sizeof(buf), s);
+        fputs(buf, s->level == RTAPI_MSG_ALL ? stdout : stderr);
+        rtapi_msgring_release(&rtapi_msg_ring.ring, s);
+    }
+    rtapi_u32 lost = rtapi_msgring_lost(&rtapi_msg_ring.ring);
+    if(lost != rtapi_msg_lost) {
+        fprintf(stderr, "rtapi_app: %u messages lost\n", lost - rtapi_msg_lost);
+        rtapi_msg_lost = lost;
+    }
+    pthread_mutex_unlock(&rtapi_msg_lock);
+}
 
 static void set_namef(const char *fmt, ...) {
     char *buf = NULL;
@@ -118,9 +141,7 @@ void *queue_function(void * /*arg*/) {
     while(1) {
         pthread_testcancel();
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, nullptr);
-        rtapi_msg_queue.consume_all([](const message_t &m) {
-            fputs(m.msg, m.level == RTAPI_MSG_ALL ? stdout : stderr);
-        });
+        drain_messages();
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, nullptr);
         struct timespec ts = {0, 10000000};
         rtapi_clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, NULL, NULL);
@@ -323,6 +344,7 @@ static int do_unload_cmd(const string& name) {
         int (*stop)(void) = DLSYM<int(*)(void)>(w, "rtapi_app_exit");
 	if(stop) stop();
 	modules.erase(modules.find(name));
+        drain_messages();
         dlclose(w);
         instance_count --;
     }
@@ -460,6 +482,7 @@ static pthread_t main_thread{};
 static int master(int fd, const vector<string>& args) {
     main_thread = pthread_self();
     int result;
+    rtapi_msgring_init(&rtapi_msg_ring.ring, RTAPI_MSG_SLOTS, RTAPI_MSG_PAYLOAD);
     if((result = pthread_create(&queue_thread, nullptr, &queue_function, nullptr)) != 0) {
         errno = result;
         perror("pthread_create (queue function)");
@@ -477,9 +500,7 @@ static int master(int fd, const vector<string>& args) {
 out:
     pthread_cancel(queue_thread);
     pthread_join(queue_thread, nullptr);
-    rtapi_msg_queue.consume_all([](const message_t &m) {
-        fputs(m.msg, m.level == RTAPI_MSG_ALL ? stdout : stderr);
-    });
+    drain_messages();
     return result;
 }
 
@@ -620,10 +641,28 @@ namespace
 {
 struct PosixTask : rtapi_task
 {
-    PosixTask() : rtapi_task{}, thr{}
+    PosixTask() : rtapi_task{}, thr{}, cpus{},
+        deadline{}, dl_runtime{}, dl_deadline{}, use_timerfd{},
+        sched_set{}, sched_changed{}, dl_active{}, timer_fd(-1), timer_interval{},
+        wakeup_latency{}
     {}
 
     pthread_t thr;                /* thread's context */
+    std::vector<int> cpus;        /* from task_set_cpus(), empty for the default */
+
+    /* from task_set_sched(), applied by the task itself in its next wait() */
+    bool deadline;                /* SCHED_DEADLINE instead of the app's policy */
+    long dl_runtime;              /* its budget and relative deadline in ns, */
+    long dl_deadline;             /* 0 for half the period and the period */
+    bool use_timerfd;             /* wake up from a periodic timerfd */
+    bool sched_set;
+    std::atomic<bool> sched_changed;
+
+    bool dl_active;               /* the task runs with SCHED_DEADLINE */
+    int timer_fd;                 /* -1 when waiting with clock_nanosleep */
+    long timer_interval;          /* interval timer_fd was last armed with */
+
+    long wakeup_latency;          /* of the last wait(), see task_wakeup_latency() */
 };
 
 struct Posix : RtapiApp
@@ -636,11 +675,14 @@ struct Posix : RtapiApp
     }
     int task_delete(int id);
     int task_start(int task_id, unsigned long period_nsec);
+    int task_set_cpus(int task_id, const char *cpus);
+    int task_set_sched(int task_id, const char *sched);
     int task_pause(int task_id);
     int task_resume(int task_id);
     int task_self();
     long long task_pll_get_reference(void);
     int task_pll_set_correction(long value);
+    int task_wakeup_latency(long *latency);
     void wait();
     struct rtapi_task *do_task_new() {
         return new PosixTask;
@@ -649,6 +691,8 @@ struct Posix : RtapiApp
     void do_outb(unsigned char value, unsigned int port);
     int run_threads(int fd, int (*callback)(int fd));
     static void *wrapper(void *arg);
+    void apply_sched(PosixTask *task);
+    void wait_timer(PosixTask *task, long interval);
     bool do_thread_lock;
 
     static pthread_once_t key_once;
@@ -987,12 +1031,88 @@ int Posix::task_delete(int id)
 
   pthread_cancel(task->thr);
   pthread_join(task->thr, 0);
+  if(task->timer_fd >= 0) close(task->timer_fd);
   task->magic = 0;
   task_array[id] = 0;
   delete task;
   return 0;
 }
 
+int RtapiApp::task_set_cpus(int task_id, const char *cpus) {
+    if(!get_task(task_id)) return -EINVAL;
+    // realtime systems that do their own placement only have the default
+    if(cpus && *cpus) return -ENOSYS;
+    return 0;
+}
+
+// for realtime systems that only know when the cycle should have started
+int RtapiApp::task_wakeup_latency(long *latency) {
+    long long reference = task_pll_get_reference();
+    if(!reference) return -ENOSYS;
+    *latency = do_get_time() - reference;
+    return 0;
+}
+
+int RtapiApp::task_set_sched(int task_id, const char *sched) {
+    if(!get_task(task_id)) return -EINVAL;
+    // realtime systems with their own scheduler only have that one
+    if(sched && *sched) return -ENOSYS;
+    return 0;
+}
+
+#ifdef __linux__
+// parse a list of CPU numbers and ranges like "1,3-5", the format of
+// isolcpus= and /sys/devices/system/cpu/isolated
+static int parse_cpu_list(const char *s, std::vector<int> &cpus) {
+    while(*s && *s != '\n') {
+        char *end;
+        long first = strtol(s, &end, 10), last = first;
+        if(end == s) return -EINVAL;
+        s = end;
+        if(*s == '-') {
+            last = strtol(s + 1, &end, 10);
+            if(end == s + 1) return -EINVAL;
+            s = end;
+        }
+        if(first < 0 || last < first || last >= CPU_SETSIZE) return -EINVAL;
+        for(long i = first; i <= last; i++) cpus.push_back(i);
+        if(*s == ',') s++;
+        else if(*s && *s != '\n') return -EINVAL;
+    }
+    return 0;
+}
+
+// the CPUs this process may run on, after the affinity mask has been
+// widened by find_rt_cpu_number(), highest first
+static std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t cpuset;
+    if(sched_getaffinity(getpid(), sizeof(cpuset), &cpuset) < 0) return cpus;
+    for(int i=CPU_SETSIZE-1; i>=0; i--) {
+        if(CPU_ISSET(i, &cpuset)) cpus.push_back(i);
+    }
+    return cpus;
+}
+
+// the CPUs handed out by the "spread" policy, highest first: the
+// isolated ones if there are any, otherwise all of them
+static std::vector<int> find_spread_cpus() {
+    std::vector<int> allowed = allowed_cpus(), isolated, cpus;
+    FILE *f = fopen("/sys/devices/system/cpu/isolated", "r");
+    if(f) {
+        char buf[1024];
+        if(fgets(buf, sizeof(buf), f) && parse_cpu_list(buf, isolated) < 0)
+            isolated.clear();
+        fclose(f);
+    }
+    for(int cpu : allowed) {
+        if(std::find(isolated.begin(), isolated.end(), cpu) != isolated.end())
+            cpus.push_back(cpu);
+    }
+    return cpus.empty() ? allowed : cpus;
+}
+#endif
+
 static int find_rt_cpu_number() {
     if(getenv("RTAPI_CPU_NUMBER")) return atoi(getenv("RTAPI_CPU_NUMBER"));
 
@@ -1041,6 +1161,13 @@ static int find_rt_cpu_number() {
 #endif
 }
 
+// find_rt_cpu_number() widens the affinity mask of the whole process,
+// which is done once, before the first task is placed
+static int rt_cpu_number() {
+    const static int cpu = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? find_rt_cpu_number() : -1;
+    return cpu;
+}
+
 int Posix::task_start(int task_id, unsigned long int period_nsec)
 {
   auto task = ::rtapi_get_task<PosixTask>(task_id);
@@ -1058,7 +1185,10 @@ int Posix::task_start(int task_id, unsigned long int period_nsec)
   task->pll_correction_limit = period_nsec / 100;
   task->pll_correction = 0;
 
-  int nprocs = sysconf( _SC_NPROCESSORS_ONLN );
+  // RTAPI_SCHED is the default for tasks without task_set_sched()
+  const char *sched = getenv("RTAPI_SCHED");
+  if(!task->sched_set && sched && *sched && task_set_sched(task_id, sched) < 0)
+      rtapi_print_msg(RTAPI_MSG_ERR, "RTAPI_SCHED=%s not understood, ignored\n", sched);
 
   pthread_attr_t attr;
   int ret;
@@ -1072,16 +1202,25 @@ int Posix::task_start(int task_id, unsigned long int period_nsec)
       return -ret;
   if((ret = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED)) != 0)
       return -ret;
-  if(nprocs > 1) {
-      const static int rt_cpu_number = find_rt_cpu_number();
-      if(rt_cpu_number != -1) {
+  if(!task->cpus.empty()) {
+#ifdef __FreeBSD__
+      cpuset_t cpuset;
+#else
+      cpu_set_t cpuset;
+#endif
+      CPU_ZERO(&cpuset);
+      for(int cpu : task->cpus) CPU_SET(cpu, &cpuset);
+      if((ret = pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset)) != 0)
+           return -ret;
+  } else {
+      if(rt_cpu_number() != -1) {
 #ifdef __FreeBSD__
           cpuset_t cpuset;
 #else
           cpu_set_t cpuset;
 #endif
           CPU_ZERO(&cpuset);
-          CPU_SET(rt_cpu_number, &cpuset);
+          CPU_SET(rt_cpu_number(), &cpuset);
           if((ret = pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset)) != 0)
                return -ret;
       }
@@ -1092,13 +1231,215 @@ int Posix::task_start(int task_id, unsigned long int period_nsec)
   return 0;
 }
 
+int Posix::task_set_cpus(int task_id, const char *spec)
+{
+  auto task = ::rtapi_get_task<PosixTask>(task_id);
+  if(!task) return -EINVAL;
+
+  std::vector<int> cpus;
+  if(spec && *spec) {
+#ifdef __linux__
+      if(strcmp(spec, "spread") == 0) {
+          rt_cpu_number();
+          const static std::vector<int> spread_cpus = find_spread_cpus();
+          static unsigned next_spread;
+          if(spread_cpus.empty()) return -EINVAL;
+          cpus.push_back(spread_cpus[next_spread++ % spread_cpus.size()]);
+      } else {
+          int ret = parse_cpu_list(spec, cpus);
+          if(ret < 0 || cpus.empty()) return -EINVAL;
+      }
+#else
+      return -ENOSYS;
+#endif
+  }
+  task->cpus = cpus;
+
+  std::string names;
+  for(int cpu : cpus) names += (names.empty() ? "" : ",") + std::to_string(cpu);
+  rtapi_print_msg(RTAPI_MSG_INFO, "task %d cpus = %s\n", task->id,
+          names.empty() ? "default" : names.c_str());
+  return 0;
+}
+
 #define RTAPI_CLOCK (CLOCK_MONOTONIC)
 
+// a time in ns, > 0
+static bool parse_ns(const char *s, long &result) {
+    char *end;
+    errno = 0;
+    result = strtol(s, &end, 10);
+    return !errno && end != s && *end == '\0' && result > 0;
+}
+
+int Posix::task_set_sched(int task_id, const char *spec)
+{
+  auto task = ::rtapi_get_task<PosixTask>(task_id);
+  if(!task) return -EINVAL;
+
+  bool deadline = false, use_timerfd = false;
+  long runtime = 0, rel_deadline = 0;
+  std::string items = spec ? spec : "";
+  size_t pos = 0;
+  while(pos < items.size()) {
+      size_t end = items.find(',', pos);
+      if(end == std::string::npos) end = items.size();
+      std::string item = items.substr(pos, end - pos);
+      pos = end + 1;
+      if(item == "fifo") {
+          deadline = false;
+      } else if(item == "nanosleep") {
+          use_timerfd = false;
+      } else if(item == "timerfd") {
+#ifdef __linux__
+          use_timerfd = true;
+#else
+          return -ENOSYS;
+#endif
+      } else if(item.compare(0, 8, "deadline") == 0) {
+#if defined(__linux__) && defined(SYS_sched_setattr)
+          // deadline[:runtime[:deadline]]
+          deadline = true;
+          runtime = rel_deadline = 0;
+          std::string args = item.substr(8);
+          if(!args.empty()) {
+              size_t colon = args.find(':', 1);
+              if(args[0] != ':') return -EINVAL;
+              if(!parse_ns(args.substr(1, colon - 1).c_str(), runtime))
+                  return -EINVAL;
+              if(colon != std::string::npos
+                      && !parse_ns(args.substr(colon + 1).c_str(), rel_deadline))
+                  return -EINVAL;
+              if(rel_deadline && runtime > rel_deadline) return -EINVAL;
+          }
+#else
+          return -ENOSYS;
+#endif
+      } else if(!item.empty()) {
+          return -EINVAL;
+      }
+  }
+
+  task->deadline = deadline;
+  task->dl_runtime = runtime;
+  task->dl_deadline = rel_deadline;
+  task->use_timerfd = use_timerfd;
+  task->sched_set = true;
+  task->sched_changed.store(true, std::memory_order_release);
+
+  rtapi_print_msg(RTAPI_MSG_INFO, "task %d sched = %s\n", task->id,
+          items.empty() ? "default" : items.c_str());
+  return 0;
+}
+
+#if defined(__linux__) && defined(SYS_sched_setattr)
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+// struct sched_attr of the kernel, not declared by older C libraries
+struct rtapi_sched_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+#endif
+
+// called by the task itself, sched_setattr() and the timer are per thread
+void Posix::apply_sched(PosixTask *task)
+{
+  task->sched_changed.store(false, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+#if defined(__linux__) && defined(SYS_sched_setattr)
+  if(task->deadline || task->dl_active) {
+      struct rtapi_sched_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      if(task->deadline) {
+          attr.sched_policy = SCHED_DEADLINE;
+          attr.sched_period = task->period;
+          attr.sched_deadline = task->dl_deadline ? task->dl_deadline : task->period;
+          attr.sched_runtime = task->dl_runtime ? task->dl_runtime : task->period / 2;
+      } else {
+          attr.sched_policy = policy;
+          attr.sched_priority = policy == SCHED_FIFO ? task->prio : 0;
+      }
+      WITH_ROOT;
+      if(syscall(SYS_sched_setattr, 0, &attr, 0) < 0) {
+          int err = errno;
+          rtapi_print_msg(RTAPI_MSG_ERR,
+                  "task %d: SCHED_DEADLINE runtime %llu deadline %llu period %llu: %s\n",
+                  task->id, (unsigned long long)attr.sched_runtime,
+                  (unsigned long long)attr.sched_deadline,
+                  (unsigned long long)attr.sched_period, strerror(err));
+          if(err == EBUSY)
+              rtapi_print_msg(RTAPI_MSG_ERR,
+                      "the CPUs cannot take that much runtime (admission control)\n");
+          else if(err == EPERM)
+              rtapi_print_msg(RTAPI_MSG_ERR,
+                      "deadline tasks need root, and a task placed on some CPUs also an\n"
+                      "exclusive cpuset for them or kernel.sched_rt_runtime_us = -1\n");
+      } else {
+          task->dl_active = task->deadline;
+      }
+  }
+#endif
+
+#ifdef __linux__
+  if(task->use_timerfd && task->timer_fd < 0) {
+      task->timer_fd = timerfd_create(RTAPI_CLOCK, TFD_CLOEXEC);
+      if(task->timer_fd < 0)
+          rtapi_print_msg(RTAPI_MSG_ERR, "task %d: timerfd_create: %s\n",
+                  task->id, strerror(errno));
+      task->timer_interval = 0;
+  } else if(!task->use_timerfd && task->timer_fd >= 0) {
+      close(task->timer_fd);
+      task->timer_fd = -1;
+  }
+#endif
+}
+
+
 pthread_once_t Posix::key_once = PTHREAD_ONCE_INIT;
 pthread_once_t Posix::lock_once = PTHREAD_ONCE_INIT;
 pthread_key_t Posix::key;
 pthread_mutex_t Posix::thread_lock;
 
+// touch every page of the stack of the calling task, below the frames
+// in use, so that the task does not take page faults on its stack later,
+// when it calls deeper in realtime; mlockall() keeps the pages resident
+static void prefault_stack(int task_id)
+{
+#ifdef __linux__
+  pthread_attr_t attr;
+  void *addr;
+  size_t size;
+  if(pthread_getattr_np(pthread_self(), &attr) != 0) return;
+  int r = pthread_attr_getstack(&attr, &addr, &size);
+  pthread_attr_destroy(&attr);
+  if(r != 0) return;
+
+  // the stack grows down from addr + size; leave this page and the one
+  // below it alone, they hold this frame and the red zone
+  uintptr_t pagesize = sysconf(_SC_PAGESIZE);
+  uintptr_t bottom = reinterpret_cast<uintptr_t>(addr);
+  uintptr_t here = reinterpret_cast<uintptr_t>(&attr) & ~(pagesize - 1);
+  size_t touched = 0;
+  for(uintptr_t p = here - 2 * pagesize; p >= bottom && p < here; p -= pagesize) {
+      *reinterpret_cast<volatile char *>(p) = 0;
+      touched += pagesize;
+  }
+  rtapi_print_msg(RTAPI_MSG_DBG, "task %d: prefaulted %zu of %zu bytes of stack\n",
+          task_id, touched, size);
+#endif
+}
+
 void *Posix::wrapper(void *arg)
 {
   struct rtapi_task *task;
@@ -1114,6 +1455,7 @@ void *Posix::wrapper(void *arg)
 
   pthread_setspecific(key, arg);
   set_namef("rtapi_app:T#%d", task->id);
+  if(rtapi_is_realtime()) prefault_stack(task->id);
 
   Posix &papp = reinterpret_cast<Posix&>(App());
   if(papp.do_thread_lock)
@@ -1145,6 +1487,13 @@ int Posix::task_pll_set_correction(long value) {
     return 0;
 }
 
+int Posix::task_wakeup_latency(long *latency) {
+    auto task = reinterpret_cast<PosixTask*>(pthread_getspecific(key));
+    if(!task) return -EINVAL;
+    *latency = task->wakeup_latency;
+    return 0;
+}
+
 int Posix::task_pause(int) {
     return -ENOSYS;
 }
@@ -1163,24 +1512,71 @@ void Posix::wait() {
     if(do_thread_lock)
         pthread_mutex_unlock(&thread_lock);
     pthread_testcancel();
-    struct rtapi_task *task = reinterpret_cast<rtapi_task*>(pthread_getspecific(key));
-    rtapi_timespec_advance(task->nextstart, task->nextstart, task->period + task->pll_correction);
-    struct timespec now;
-    clock_gettime(RTAPI_CLOCK, &now);
-    if(rtapi_timespec_less(task->nextstart, now))
+    auto task = reinterpret_cast<PosixTask*>(pthread_getspecific(key));
+    long interval = task->period + task->pll_correction;
+    rtapi_timespec_advance(task->nextstart, task->nextstart, interval);
+    if(task->sched_changed.load(std::memory_order_relaxed))
+        apply_sched(task);
+    if(task->timer_fd >= 0)
     {
-        if(policy == SCHED_FIFO)
-            unexpected_realtime_delay(task);
+        wait_timer(task, interval);
     }
     else
     {
-        int res = rtapi_clock_nanosleep(RTAPI_CLOCK, TIMER_ABSTIME, &task->nextstart, nullptr, &now);
-        if(res < 0) perror("clock_nanosleep");
+        struct timespec now;
+        clock_gettime(RTAPI_CLOCK, &now);
+        if(rtapi_timespec_less(task->nextstart, now))
+        {
+            if(policy == SCHED_FIFO)
+                unexpected_realtime_delay(task);
+        }
+        else
+        {
+            int res = rtapi_clock_nanosleep(RTAPI_CLOCK, TIMER_ABSTIME, &task->nextstart, nullptr, &now);
+            if(res < 0) perror("clock_nanosleep");
+        }
     }
+    struct timespec woke;
+    clock_gettime(RTAPI_CLOCK, &woke);
+    task->wakeup_latency = (woke.tv_sec - task->nextstart.tv_sec) * 1000000000L
+        + (woke.tv_nsec - task->nextstart.tv_nsec);
     if(do_thread_lock)
         pthread_mutex_lock(&thread_lock);
 }
 
+// the timer runs on by itself with a fixed interval, so it is only armed
+// again when the PLL changes the period.  Periods that were missed are
+// skipped instead of being run back to back.
+void Posix::wait_timer(PosixTask *task, long interval)
+{
+#ifdef __linux__
+    if(interval != task->timer_interval) {
+        struct itimerspec its;
+        its.it_value = task->nextstart;
+        its.it_interval.tv_sec = interval / 1000000000;
+        its.it_interval.tv_nsec = interval % 1000000000;
+        if(timerfd_settime(task->timer_fd, TFD_TIMER_ABSTIME, &its, nullptr) < 0)
+            perror("timerfd_settime");
+        task->timer_interval = interval;
+    }
+    uint64_t expirations = 0;
+    ssize_t res;
+    do {
+        res = read(task->timer_fd, &expirations, sizeof(expirations));
+    } while(res < 0 && errno == EINTR);
+    if(res < 0) {
+        perror("read timerfd");
+        return;
+    }
+    if(expirations > 1) {
+        if(policy == SCHED_FIFO)
+            unexpected_realtime_delay(task, expirations - 1);
+        rtapi_timespec_advance(task->nextstart, task->nextstart,
+                (expirations - 1) * (unsigned long)interval);
+    }
+#endif
+}
+
 unsigned char Posix::do_inb(unsigned int port)
 {
 #ifdef HAVE_SYS_IO_H
@@ -1261,6 +1657,16 @@ int rtapi_task_start(int task_id, unsigned long period_nsec)
     return ret;
 }
 
+int rtapi_task_set_cpus(int task_id, const char *cpus)
+{
+    return App().task_set_cpus(task_id, cpus);
+}
+
+int rtapi_task_set_sched(int task_id, const char *sched)
+{
+    return App().task_set_sched(task_id, sched);
+}
+
 int rtapi_task_pause(int task_id)
 {
     return App().task_pause(task_id);
@@ -1286,6 +1692,11 @@ int rtapi_task_pll_set_correction(long value)
     return App().task_pll_set_correction(value);
 }
 
+int rtapi_task_wakeup_latency(long *latency)
+{
+    return App().task_wakeup_latency(latency);
+}
+
 void rtapi_wait(void)
 {
     App().wait();
@@ -1319,11 +1730,9 @@ long long rtapi_get_time() {
 }
 
 void default_rtapi_msg_handler(msg_level_t level, const char *fmt, va_list ap) {
-    if(main_thread && pthread_self() != main_thread) {
-        message_t m;
-        m.level = level;
-        vsnprintf(m.msg, sizeof(m.msg), fmt, ap);
-        rtapi_msg_queue.push(m);
+    // only realtime tasks leave the printing to queue_function
+    if(main_thread && pthread_self() != main_thread && rtapi_task_self() >= 0) {
+        rtapi_msgring_vpush(&rtapi_msg_ring.ring, level, rtapi_get_time(), fmt, ap);
     } else {
         vfprintf(level == RTAPI_MSG_ALL ? stdout : stderr, fmt, ap);
     }
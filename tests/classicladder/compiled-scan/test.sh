@@ -0,0 +1,59 @@
+#!/bin/sh
+# Runs bench.clp with the interpreted scan, then with the compiled scan,
+# for the same sequence of inputs, and checks the outputs are the same.
+# The longest refresh of each scan goes to stderr, to compare them.
+
+# Disable eatmydata, as it do not seem to work with classicladder
+if [ "libeatmydata.so" = "$LD_PRELOAD" ] ; then
+    unset LD_PRELOAD
+fi
+
+set_inputs () {
+    for i in 0 1 2 3 4 5 6 7; do
+        halcmd setp classicladder.0.in-0$i $(( ($1 >> $i) & 1 ))
+    done
+    halcmd setp classicladder.0.s32in-00 $2
+    halcmd setp classicladder.0.s32in-01 $3
+    halcmd setp classicladder.0.s32in-02 $4
+    halcmd setp classicladder.0.s32in-03 $5
+    sleep 0.1
+}
+
+run () {
+    halcmd setp classicladder.compiled-scan $1
+    halcmd setp classicladder.0.refresh.tmax 0
+    # all the operate blocks on first, so that both scans start the same
+    set_inputs 255 3 1 4 1
+    echo "compiled-scan=$1 out-00=$(halcmd getp classicladder.0.out-00)" \
+        "out-01=$(halcmd getp classicladder.0.out-01)" \
+        "out-40=$(halcmd getp classicladder.0.out-40)" \
+        "s32out-00=$(halcmd getp classicladder.0.s32out-00)" \
+        "s32out-01=$(halcmd getp classicladder.0.s32out-01)"
+    for pattern in "1 0 0 0 0" "37 2 -1 5 0" "74 -3 4 4 2" "111 1 1 -2 7" \
+            "148 6 0 1 -1" "185 -2 -2 3 3" "0 0 0 0 0"; do
+        set_inputs $pattern
+        halcmd -s show pin classicladder.0.out- >> outputs.$1
+        halcmd -s show pin classicladder.0.s32out- >> outputs.$1
+    done
+    echo "compiled-scan=$1 $(halcmd -s show param classicladder.0.refresh.tmax)" >&2
+}
+
+rm -f outputs.0 outputs.1
+$REALTIME start
+halcmd loadrt threads name1=fast period1=1000000
+halcmd loadrt classicladder_rt numRungs=40 numBits=20 numWords=20 numPhysInputs=8 numPhysOutputs=50 numArithmExpr=20 numSections=1 numS32in=4 numS32out=10
+halcmd loadusr -w classicladder --nogui bench.clp
+halcmd addf classicladder.0.refresh fast
+halcmd start
+run 0
+run 1
+halcmd stop
+halcmd unload all
+$REALTIME stop
+
+if cmp -s outputs.0 outputs.1; then
+    echo "same outputs"
+else
+    diff outputs.0 outputs.1
+fi
+rm -f outputs.0 outputs.1
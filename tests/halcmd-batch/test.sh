@@ -0,0 +1,9 @@
+#!/bin/sh
+$REALTIME start
+halcmd -b -f setup.hal
+halcmd save
+halcmd -b -f bad.hal 2>&1 || echo "bad.hal failed"
+halcmd -b -f badport.hal 2>&1 || echo "badport.hal failed"
+halcmd list sig
+halcmd unload all
+$REALTIME stop
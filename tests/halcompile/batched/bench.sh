@@ -0,0 +1,19 @@
+#!/bin/bash
+# Servo thread time of N instances of each test component as separate
+# functs, and of the same batched, run side by side for SECS seconds.
+# Needs the components installed by test.sh.
+# usage: bench.sh [N [SECS]]
+set -e
+cd "$(dirname "$0")"
+N=${1:-1000}
+SECS=${2:-10}
+
+./mkhal.sh $N inst-thread batch-thread > bench.hal
+cat >> bench.hal <<HAL
+start
+loadusr -w sleep $SECS
+stop
+show pin *-thread.time
+show param *-thread.tmax lowpassb.all.tmax biquadb.all.tmax pidb.all.tmax
+HAL
+halrun -s bench.hal
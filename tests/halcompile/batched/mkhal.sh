@@ -0,0 +1,56 @@
+#!/bin/bash
+# Writes a hal file with N instances of each test component, loaded once
+# as separate functs added to thread ITHREAD and once batched and added
+# to thread BTHREAD.  Both get the same inputs and per instance settings.
+# usage: mkhal.sh N ITHREAD BTHREAD
+N=$1
+IT=$2
+BT=$3
+
+if [ "$IT" = "$BT" ]; then
+    echo "loadrt threads name1=$IT period1=1000000"
+else
+    echo "loadrt threads name1=$IT period1=1000000 name2=$BT period2=1000000"
+fi
+echo "loadrt siggen names=sig-i,sig-b"
+for C in lowpass biquad pid; do
+    echo "loadrt ${C}i count=$N"
+    echo "loadrt ${C}b count=$N"
+done
+
+echo "addf sig-i.update $IT"
+for ((i = 0; i < N; i++)); do
+    for C in lowpass biquad pid; do
+        echo "addf ${C}i.$i $IT"
+    done
+done
+echo "addf sig-b.update $BT"
+for C in lowpass biquad pid; do
+    echo "addf ${C}b.all $BT"
+done
+
+for X in i b; do
+    echo "setp sig-$X.frequency 3"
+    for ((i = 0; i < N; i++)); do
+        echo "net sine-$X sig-$X.sine => lowpass$X.$i.in pid$X.$i.command"
+        echo "net triangle-$X sig-$X.triangle => biquad$X.$i.in"
+        echo "net feedback-$X-$i lowpass$X.$i.out => pid$X.$i.feedback"
+
+        echo "setp lowpass$X.$i.gain 0.$((i % 90 + 10))"
+        [ $((i % 7)) = 3 ] && echo "setp lowpass$X.$i.load 1"
+
+        echo "setp biquad$X.$i.n0 0.2"
+        echo "setp biquad$X.$i.n1 0.$((i % 5 + 1))"
+        echo "setp biquad$X.$i.n2 0.1"
+        echo "setp biquad$X.$i.d1 -0.5"
+        echo "setp biquad$X.$i.d2 0.0$((i % 10))"
+
+        [ $((i % 5)) = 0 ] || echo "setp pid$X.$i.enable 1"
+        echo "setp pid$X.$i.pgain $((i % 4 + 1)).5"
+        echo "setp pid$X.$i.igain 0.5"
+        echo "setp pid$X.$i.dgain 0.001"
+        echo "setp pid$X.$i.ff1 0.1"
+        [ $((i % 3)) = 0 ] && echo "setp pid$X.$i.maxoutput 0.5"
+    done
+done
+exit 0
@@ -0,0 +1,20 @@
+#!/bin/bash
+set -e
+cd "$(dirname "$0")"
+
+# the same components without option batched
+for C in lowpass biquad pid; do
+    sed -e '/^option batched;/d' -e "s/^component ${C}b /component ${C}i /" \
+        ${C}b.comp > ${C}i.comp
+    ${SUDO} halcompile --install ${C}b.comp
+    ${SUDO} halcompile --install ${C}i.comp
+done
+
+./mkhal.sh 64 servo-thread servo-thread > batched.hal
+cat >> batched.hal <<HAL
+start
+loadusr -w sleep 1
+stop
+show pin
+HAL
+halrun -s batched.hal
@@ -0,0 +1,195 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Streams one signal with scope_rt into a recording of 'len' samples,
+   the way halscope does, until 'count' samples came in, then checks
+   the decimation pyramids, saves the recording and loads it back.
+
+   usage: streamrec signal thread len count file */
+
+#include "rtapi.h"
+#include "hal.h"
+#include "hal_priv.h"
+#include "scope_rec.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static scope_shm_control_t *ctrl;
+static scope_data_t *buffer;
+
+/* takes what scope_rt streamed since 'next', at most up to 'count' */
+static unsigned long drain(scope_rec_t *rec, unsigned long next,
+    unsigned long count)
+{
+    long ring = ctrl->buf_len / ctrl->sample_len;
+    unsigned long avail;
+    long n, slot;
+
+    avail = __atomic_load_n(&ctrl->stream_samples, __ATOMIC_ACQUIRE);
+    if (avail - next >= (unsigned long) ring) {
+	fprintf(stderr, "samples were overwritten before they were read\n");
+	exit(1);
+    }
+    if (avail > count) {
+	avail = count;
+    }
+    while (next != avail) {
+	slot = next % ring;
+	n = avail - next;
+	if (n > ring - slot) {
+	    n = ring - slot;
+	}
+	scope_rec_append(rec, buffer + slot * ctrl->sample_len,
+	    ctrl->sample_len, n);
+	next += n;
+    }
+    return next;
+}
+
+/* the pyramids give what looking at every sample gives */
+static int check_minmax(scope_rec_t *rec)
+{
+    double min, max, want_min, want_max, v;
+    long start, end, n;
+
+    for (start = 0; start < rec->count; start += 37) {
+	for (end = start + 1; end <= rec->count; end += 1 + end / 3) {
+	    scope_rec_minmax(rec, 0, start, end, &min, &max);
+	    want_min = HUGE_VAL;
+	    want_max = -HUGE_VAL;
+	    for (n = start; n < end; n++) {
+		v = scope_rec_value(scope_rec_sample(rec, n), rec->type[0]);
+		want_min = fmin(want_min, v);
+		want_max = fmax(want_max, v);
+	    }
+	    /* the pyramids keep floats */
+	    if (fabs(min - want_min) > 1e-6 || fabs(max - want_max) > 1e-6) {
+		printf("samples %ld to %ld: min %g max %g, expected %g %g\n",
+		    start, end, min, max, want_min, want_max);
+		return -1;
+	    }
+	}
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    scope_rec_t rec, loaded;
+    scope_rec_hdr_t hdr;
+    hal_thread_t *thread;
+    hal_sig_t *sig;
+    hal_type_t type;
+    unsigned long next, count;
+    void *shm_base;
+    long len, n;
+    int comp_id, shm_id, retval;
+
+    if (argc != 6) {
+	fprintf(stderr, "usage: streamrec signal thread len count file\n");
+	return 1;
+    }
+    len = atol(argv[3]);
+    count = atol(argv[4]);
+
+    comp_id = hal_init("streamrec");
+    if (comp_id < 0) {
+	return 1;
+    }
+    hal_ready(comp_id);
+    shm_id = rtapi_shmem_new(SCOPE_SHM_KEY, comp_id,
+	sizeof(scope_shm_control_t));
+    if (shm_id < 0 || rtapi_shmem_getptr(shm_id, &shm_base) < 0) {
+	fprintf(stderr, "scope_rt is not loaded\n");
+	hal_exit(comp_id);
+	return 1;
+    }
+    ctrl = shm_base;
+    buffer = (scope_data_t *) ((char *) ctrl
+	+ ((sizeof(scope_shm_control_t) + 3) & ~3));
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    sig = halpr_find_sig_by_name(argv[1]);
+    thread = halpr_find_thread_by_name(argv[2]);
+    if (sig == 0 || thread == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	fprintf(stderr, "no signal %s or thread %s\n", argv[1], argv[2]);
+	return 1;
+    }
+    type = sig->type;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.sample_period_ns = thread->period;
+    snprintf(hdr.chan[0].name, sizeof(hdr.chan[0].name), "%s", sig->name);
+    hdr.chan[0].type = type;
+    /* one channel, as set up by halscope's capture code */
+    memset(ctrl->data_len, 0, sizeof(ctrl->data_len));
+    ctrl->data_offset[0] = sig->data_ptr;
+    ctrl->data_type[0] = type;
+    ctrl->data_len[0] = type == HAL_FLOAT ? sizeof(ireal_t)
+	: type == HAL_BIT ? 1 : 4;
+    rtapi_mutex_give(&(hal_data->mutex));
+
+    if (scope_rec_create(&rec, len, 1, &type) < 0) {
+	fprintf(stderr, "could not create the recording\n");
+	return 1;
+    }
+    ctrl->sample_len = 1;
+    ctrl->mult = 1;
+    ctrl->stream = 1;
+    __atomic_store_n(&ctrl->stream_samples, 0, __ATOMIC_RELAXED);
+    ctrl->state = INIT;
+    for (next = 0; next < count; ) {
+	usleep(10000);
+	next = drain(&rec, next, count);
+    }
+    ctrl->state = IDLE;
+    printf("streamed %lu samples, %ld kept\n", rec.total, rec.count);
+
+    if (check_minmax(&rec) == 0) {
+	printf("pyramids agree with the samples\n");
+    }
+    retval = scope_rec_save(&rec, &hdr, argv[5]);
+    if (retval < 0) {
+	fprintf(stderr, "%s: %s\n", argv[5], strerror(-retval));
+	return 1;
+    }
+    retval = scope_rec_load(&loaded, argv[5]);
+    if (retval < 0) {
+	fprintf(stderr, "%s: %s\n", argv[5], strerror(-retval));
+	return 1;
+    }
+    for (n = 0; n < rec.count; n++) {
+	if (memcmp(scope_rec_sample(&rec, n), scope_rec_sample(&loaded, n),
+		sizeof(scope_data_t)) != 0) {
+	    break;
+	}
+    }
+    if (n == rec.count && loaded.count == rec.count
+	&& loaded.total == rec.total) {
+	printf("loaded file agrees with the recording\n");
+    }
+    if (check_minmax(&loaded) == 0) {
+	printf("pyramids of the loaded file agree\n");
+    }
+    scope_rec_free(&loaded);
+    scope_rec_free(&rec);
+    rtapi_shmem_delete(shm_id, comp_id);
+    hal_exit(comp_id);
+    return 0;
+}
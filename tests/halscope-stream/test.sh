@@ -0,0 +1,26 @@
+#!/bin/bash -e
+
+SRC="$EMC2_HOME/src"
+gcc -DULAPI -std=gnu11 -I"$HEADERS" -I"$SRC/hal" -I"$SRC/hal/utils" \
+    -o streamrec streamrec.c "$SRC/hal/utils/scope_rec.c" \
+    -L"$LIBDIR" -Wl,-rpath,"$LIBDIR" -llinuxcnchal -lm
+
+realtime start
+halcmd loadrt threads name1=fast period1=1000000
+halcmd loadrt siggen
+halcmd loadrt scope_rt
+halcmd net saw siggen.0.sawtooth
+halcmd setp siggen.0.frequency 10
+halcmd addf siggen.0.update fast
+halcmd addf scope.sample fast
+halcmd start
+
+# a recording of 3000 samples that 5000 streamed samples wrap around
+./streamrec saw fast 3000 5000 out.hsd || result=$?
+
+halcmd stop
+halcmd unload all
+realtime stop
+
+[ -z "$result" ] || exit $result
+./checkrec out.hsd
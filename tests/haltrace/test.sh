@@ -0,0 +1,23 @@
+#!/bin/bash
+# Records a thread with one function for a moment, then checks the json
+# and ctf dumps of haltrace.
+
+TMPDIR=$(mktemp -d /tmp/haltrace.XXXXXX)
+trap 'rm -rf "$TMPDIR"' 0 1 2 3 15
+
+$REALTIME start
+halcmd loadrt threads name1=fast period1=1000000
+halcmd loadrt siggen
+halcmd addf siggen.0.update fast
+haltrace clear
+haltrace start
+halcmd start
+sleep 0.5
+haltrace stop
+halcmd stop
+haltrace dump "$TMPDIR/trace.json" || echo "json dump failed"
+haltrace dump -f ctf "$TMPDIR/ctf" || echo "ctf dump failed"
+halcmd unload all
+$REALTIME stop
+
+./checkdump "$TMPDIR/trace.json" "$TMPDIR/ctf"
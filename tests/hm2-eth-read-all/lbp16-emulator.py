@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+#
+# HostMot2 ethernet boards for hm2_eth, on loopback addresses:
+#
+#     lbp16-emulator.py readyfile 127.0.0.2 127.0.0.3 ...
+#
+# Each one answers LBP16 like a 7I92 whose firmware has only the two
+# IOPorts.  Reads of the IOPort data registers return what was last written
+# to them, so a GPIO output shows up on its input.  readyfile is created
+# once all the sockets are bound.  On SIGTERM it prints, for each board,
+# the number of datagrams with reads and how many of them also had writes
+# to the HostMot2 registers.
+
+import selectors
+import signal
+import socket
+import struct
+import sys
+
+LBP16_UDP_PORT = 27181
+
+def idrom_image():
+    hm2 = bytearray(0x10000)
+    def set32(addr, value):
+        struct.pack_into("<I", hm2, addr, value)
+    set32(0x100, 0x55AACAFE)                    # IOCookie
+    hm2[0x104:0x10C] = b"HOSTMOT2"              # ConfigName
+    set32(0x10C, 0x400)                         # IDROM offset
+
+    # IDROM: type, module and pin descriptor offsets, board name, FPGA
+    # size and pins, IOPorts, IOWidth, PortWidth, clocks, strides
+    struct.pack_into("<III8sIIIIIIIIIII", hm2, 0x400,
+        3, 0x40, 0x200, b"MESA7I92", 9, 144, 2, 34, 17,
+        int(100e6), int(200e6), 4, 0x40, 0x100, 4)
+
+    # one Module Descriptor, IOPort: 2 instances of 5 registers at 0x1000
+    struct.pack_into("<III", hm2, 0x440,
+        3 | (0 << 8) | (1 << 16) | (2 << 24), 0x1000 | (5 << 16), 0x1F)
+
+    # all 34 pins are IOPort pins
+    for pin in range(34):
+        set32(0x600 + 4 * pin, 3 << 24)
+    return hm2
+
+class Board:
+    def __init__(self, ip):
+        self.ip = ip
+        self.space = {
+            0: idrom_image(),                   # HostMot2
+            2: bytearray(b"\x00\x01\x02\x03\x04\x05" + bytes(250)),  # MAC
+            4: bytearray(256),                  # timer, scratch registers
+            6: bytearray(256),                  # comm control
+            7: bytearray(b"7I92".ljust(16, b"\0") + bytes(240)),
+        }
+        self.requests = 0
+        self.combined = 0
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind((ip, LBP16_UDP_PORT))
+
+    def handle(self):
+        packet, peer = self.sock.recvfrom(2048)
+        reply = bytearray()
+        wrote = False
+        i = 0
+        while i + 2 <= len(packet):
+            cmd, = struct.unpack_from("<H", packet, i)
+            i += 2
+            addr = 0
+            if cmd & 0x4000:
+                addr, = struct.unpack_from("<H", packet, i)
+                i += 2
+            space = (cmd >> 10) & 7
+            mem = self.space.get(space, bytearray(0x10000))
+            size = 1 << ((cmd >> 8) & 3)
+            count = cmd & 0x7F
+            for n in range(count):
+                a = addr + n * size if cmd & 0x80 else addr
+                if cmd & 0x8000:
+                    mem[a:a + size] = packet[i:i + size]
+                    i += size
+                    wrote |= space == 0
+                else:
+                    reply += mem[a:a + size]
+        # the comm control space counts the datagrams received
+        rx = self.space[6]
+        struct.pack_into("<H", rx, 8, (struct.unpack_from("<H", rx, 8)[0] + 1) & 0xFFFF)
+        if reply:
+            self.requests += 1
+            self.combined += wrote
+            self.sock.sendto(reply, peer)
+
+def main():
+    ready, ips = sys.argv[1], sys.argv[2:]
+    boards = [Board(ip) for ip in ips]
+    sel = selectors.DefaultSelector()
+    for board in boards:
+        sel.register(board.sock, selectors.EVENT_READ, board)
+
+    def report(signum, frame):
+        for board in boards:
+            print("lbp16 %s requests %d combined %d"
+                % (board.ip, board.requests, board.combined))
+        sys.exit(0)
+    signal.signal(signal.SIGTERM, report)
+
+    open(ready, "w").close()
+    while True:
+        for key, events in sel.select():
+            key.data.handle()
+
+main()
@@ -0,0 +1,14 @@
+#!/bin/bash
+rm -f emulator-ready
+./lbp16-emulator.py emulator-ready 127.0.0.2 127.0.0.3 > emulator.out &
+EMULATOR=$!
+while ! [ -e emulator-ready ]; do sleep 0.1; done
+
+halrun -f read-all.hal
+result=$?
+
+kill $EMULATOR
+wait $EMULATOR
+cat emulator.out
+rm -f emulator-ready emulator.out
+exit $result
@@ -0,0 +1,13 @@
+#!/bin/bash
+# Compiles a command file with mergeable reads and merging turned on, checks
+# which commands were merged and where the pins of the merged commands ended
+# up.
+
+TMPDIR=$(mktemp -d /tmp/mesambccc.XXXXXX)
+trap 'rm -rf "$TMPDIR"' 0 1 2 3 15
+
+mesambccc -v -o "$TMPDIR/merge.mbccb" merge.mbccs | sed "s|$TMPDIR/||"
+
+# Without merge="true" the command numbers stay as they are in the file
+sed 's/ merge="true"//' merge.mbccs > "$TMPDIR/nomerge.mbccs"
+echo "merged by default: $(mesambccc -v -o "$TMPDIR/nomerge.mbccb" "$TMPDIR/nomerge.mbccs" | grep -c 'merged from')"
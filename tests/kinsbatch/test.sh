@@ -0,0 +1,9 @@
+#!/bin/sh
+set -e
+# every module with its own batch kinematics gives what its single pose
+# kinematics give
+for so in "$EMC2_HOME"/rtlib/*.so; do
+    if nm -D --defined-only "$so" | grep -q ' kinematics\(Forward\|Inverse\)Batch$'; then
+        kins-bench -c -n 10000 "$(basename "$so" .so)"
+    fi
+done
@@ -0,0 +1,10 @@
+#!/bin/sh
+set -e
+# each path once with the kept jacobian factors and once with
+# jacobian-reuse=0, which factors in every iteration like Newton's method
+for r in 1 20; do
+    for m in genserkins genhexkins; do
+        echo "new $m $r $(kins-bench -s -n 10000 -r $r $m | tail -1)"
+        echo "old $m $r $(kins-bench -s -n 10000 -r $r -p $m.jacobian-reuse=0 $m | tail -1)"
+    done
+done
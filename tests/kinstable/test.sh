@@ -0,0 +1,12 @@
+#!/bin/sh
+set -e
+kins-table -F 1 -e 0.01 -g x=441:481:21 -g y=359:399:21 -g z=445:485:3 \
+    -j 20,40,25,10 -w 0,0,0,0,0,70 -o scara.tbl scarakins > /dev/null
+kins-bench -s -n 1000 scarakins kinstable=$PWD/scara.tbl
+
+$REALTIME start
+halcmd loadrt scarakins kinstable=$PWD/scara.tbl
+halcmd -s show pin scarakins.table
+halcmd unload all
+$REALTIME stop
+rm -f scara.tbl
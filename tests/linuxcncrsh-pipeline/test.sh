@@ -0,0 +1,58 @@
+#!/bin/bash
+
+rm -f telnet-output
+
+if nc -z localhost 5007; then
+    echo "Process already listening on port 5007. Exiting"
+    exit 1
+fi
+
+linuxcnc -r linuxcncrsh-test.ini &
+
+
+# let linuxcnc come up
+TOGO=80
+while [  $TOGO -gt 0 ]; do
+    echo "trying to connect to linuxcncrsh TOGO=$TOGO"
+    if nc -z localhost 5007; then
+        break
+    fi
+    sleep 0.25
+    TOGO=$((TOGO - 1))
+done
+if [  $TOGO -eq 0 ]; then
+    echo "connection to linuxcncrsh timed out"
+    exit 1
+fi
+
+
+(
+    # one write, so nothing gets echoed before echo is turned off
+    printf "hello EMC pipeline 1.0\r\nset echo off\r\n"
+    echo "set enable EMCTOO"
+    echo "set verbose on"
+    echo "set wait_mode done"
+
+    # all the commands go back to back, without waiting for any reply:
+    # they are answered in order and each reply carries the tag of its
+    # command, set commands once task is done with them
+    echo "@1 get estop"
+    # a watch answers right away and again when the value changes
+    echo "@w watch estop"
+    echo "@2 set estop off"
+    echo "@3 get estop"
+    echo "@4 set machine on"
+    echo "@5 get machine"
+    echo "@6 unwatch estop"
+    echo "@7 unwatch estop"
+    echo "@8 set machine off"
+    echo "@9 get machine"
+
+    echo "shutdown"
+) | nc localhost 5007 > telnet-output
+
+
+# wait for linuxcnc to finish
+wait
+
+exit 0
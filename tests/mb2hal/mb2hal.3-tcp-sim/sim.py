@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+# Minimal Modbus/TCP slave for the mb2hal tests.
+#
+# Holding register N reads N, input register N reads 1000 + N, coil N is
+# on when N is odd and discrete input N when N is a multiple of 3.  Writes
+# are accepted and dropped.  Requests are answered in order, so pipelined
+# requests queue up in the socket.
+#
+# The listening port is written to PORTFILE.  On SIGTERM the update rate of
+# every request seen is checked against the EXPECT arguments, given as
+# fc:addr:count:hz, and the result printed.  A rated request passes within
+# half and one and a half times its rate; an unrated one (hz 0) must run
+# faster than all the rated ones.
+
+import os
+import socket
+import signal
+import struct
+import sys
+import threading
+import time
+
+requests = {}
+lock = threading.Lock()
+
+
+def answer(fc, addr, count):
+    if fc in (1, 2):
+        bits = [(a % 2 == 1) if fc == 1 else (a % 3 == 0)
+                for a in range(addr, addr + count)]
+        data = bytearray((count + 7) // 8)
+        for i, b in enumerate(bits):
+            if b:
+                data[i // 8] |= 1 << (i % 8)
+        return bytes([fc, len(data)]) + bytes(data)
+    if fc in (3, 4):
+        base = 0 if fc == 3 else 1000
+        data = b"".join(struct.pack(">H", base + a)
+                        for a in range(addr, addr + count))
+        return bytes([fc, len(data)]) + data
+    if fc in (5, 6, 15, 16):
+        return bytes([fc]) + struct.pack(">HH", addr, count)
+    return bytes([fc | 0x80, 1])
+
+
+def recv_all(conn, n):
+    buf = b""
+    while len(buf) < n:
+        chunk = conn.recv(n - len(buf))
+        if not chunk:
+            raise EOFError
+        buf += chunk
+    return buf
+
+
+def serve(conn):
+    try:
+        while True:
+            tid, proto, length, unit = struct.unpack(">HHHB", recv_all(conn, 7))
+            pdu = recv_all(conn, length - 1)
+            fc = pdu[0]
+            addr, count = struct.unpack(">HH", pdu[1:5])
+            if fc == 5:
+                count = 1
+            with lock:
+                requests.setdefault((fc, addr, count), []).append(time.time())
+            rsp = answer(fc, addr, count)
+            if fc in (5, 6):
+                rsp = pdu[:5]
+            conn.sendall(struct.pack(">HHHB", tid, 0, len(rsp) + 1, unit) + rsp)
+    except (EOFError, OSError):
+        conn.close()
+
+
+def report(expect):
+    with lock:
+        seen = dict(requests)
+    rates = {}
+    for fc, addr, count, hz in expect:
+        times = seen.pop((fc, addr, count), [])
+        if len(times) >= 2:
+            rates[(fc, addr, count)] = (len(times) - 1) / (times[-1] - times[0])
+    # the rated requests only need to come near their rate on a loaded
+    # machine, but must run slower than the unrated ones
+    fastest = max([rates.get((fc, addr, count), 0)
+                   for fc, addr, count, hz in expect if hz != 0] + [0])
+    for fc, addr, count, hz in expect:
+        name = "fc %d addr %d count %d" % (fc, addr, count)
+        rate = rates.get((fc, addr, count))
+        if rate is None:
+            print("%s: not seen" % name)
+        elif hz != 0 and not 0.5 * hz <= rate <= 1.5 * hz:
+            print("%s: %.1f Hz, expected %g Hz" % (name, rate, hz))
+        elif hz == 0 and rate <= fastest:
+            print("%s: %.1f Hz, slower than a rated request" % (name, rate))
+        else:
+            print("%s: ok" % name)
+    for fc, addr, count in sorted(seen):
+        print("fc %d addr %d count %d: not expected" % (fc, addr, count))
+    sys.stdout.flush()
+
+
+def main():
+    portfile = sys.argv[1]
+    expect = [tuple(float(x) if i == 3 else int(x)
+                    for i, x in enumerate(arg.split(":")))
+              for arg in sys.argv[2:]]
+
+    srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    srv.bind(("127.0.0.1", 0))
+    srv.listen(4)
+
+    def quit(signum, frame):
+        report(expect)
+        sys.exit(0)
+    signal.signal(signal.SIGTERM, quit)
+
+    with open(portfile + ".tmp", "w") as f:
+        f.write("%d\n" % srv.getsockname()[1])
+    # the rename makes the file appear complete
+    os.rename(portfile + ".tmp", portfile)
+
+    while True:
+        conn, _ = srv.accept()
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        threading.Thread(target=serve, args=(conn,), daemon=True).start()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,32 @@
+#!/bin/bash
+# Runs mb2hal against a local Modbus/TCP simulator for a few seconds,
+# then checks which requests reached it and at what rate, and that the
+# values of merged transactions land on the right pins.
+
+TMPDIR=$(mktemp -d /tmp/mb2hal-sim.XXXXXX)
+trap 'rm -rf "$TMPDIR"' 0 1 2 3 15
+
+python3 sim.py "$TMPDIR/port" 3:0:8:50 3:10:2:50 4:100:2:20 2:0:8:20 \
+    1:0:16:20 16:200:2:10 4:300:1:0 > "$TMPDIR/report" &
+SIM=$!
+for i in $(seq 50); do
+    [ -f "$TMPDIR/port" ] && break
+    sleep 0.1
+done
+sed "s/@PORT@/$(cat "$TMPDIR/port")/" mb2hal.ini.in > "$TMPDIR/mb2hal.ini"
+
+$REALTIME start
+halcmd loadusr -W mb2hal config="$TMPDIR/mb2hal.ini"
+sleep 3
+for pin in hold_a.03 hold_b.01 hold_c.00 hold_d.01 input.01 busy.00; do
+    echo "$pin $(halcmd getp mb2hal.$pin.int)"
+done
+for pin in discrete.03 coils_a.00 coils_b.03; do
+    echo "$pin $(halcmd getp mb2hal.$pin.bit)"
+done
+halcmd unload all
+$REALTIME stop
+
+kill -TERM $SIM
+wait $SIM
+cat "$TMPDIR/report"
@@ -0,0 +1,34 @@
+#!/usr/bin/env python3
+
+import linuxcnc
+
+import sys
+
+
+#
+# connect to LinuxCNC
+#
+
+c = linuxcnc.command()
+s = linuxcnc.stat()
+e = linuxcnc.error_channel()
+
+
+#
+# Come out of E-stop, turn the machine on, and switch to Auto mode.
+#
+
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.mode(linuxcnc.MODE_AUTO)
+
+
+#
+# run the program that motion-logger captures
+#
+
+c.program_open('replay.ngc')
+c.auto(linuxcnc.AUTO_RUN, 0)
+c.wait_complete()
+
+sys.exit(0)
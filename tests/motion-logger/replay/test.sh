@@ -0,0 +1,14 @@
+#!/bin/bash -e
+# Captures the motion commands of replay.ngc with motion-logger -b, then
+# runs them through the real motion modules with motion-replay.
+
+rm -f out.motion-logger out.capture out.replay out.linuxcnc
+
+linuxcnc -r replay.ini > out.linuxcnc 2>&1 || { cat out.linuxcnc; exit 1; }
+
+motion-replay -m "num_joints=3" -k "trivkins coordinates=xyz" \
+    out.capture > out.replay 2>&1 || { cat out.replay; exit 1; }
+
+# the number of commands depends on what Task sends at startup
+sed -n 's/^\([0-9]*\) of \1 commands sent/all commands sent/p' out.replay
+awk '/^final position/ { printf "final position %.4f %.4f %.4f\n", $3 + 0, $4 + 0, $5 + 0 }' out.replay
@@ -0,0 +1,6 @@
+#!/bin/bash -xe
+
+g++ -DULAPI -I"${HEADERS}" -std=c++0x \
+    -DSIM -rdynamic -L"${LIBDIR}" -pthread \
+    -o test_rtapi_msgring test_rtapi_msgring.c
+./test_rtapi_msgring
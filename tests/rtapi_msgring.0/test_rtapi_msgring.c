@@ -0,0 +1,216 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "rtapi.h"
+#include "rtapi_msgring.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NSLOTS 64
+#define PAYLOAD 128
+
+union {
+    rtapi_msgring_t ring;
+    char mem[RTAPI_MSGRING_SIZE(NSLOTS, PAYLOAD)];
+} r;
+
+int fail;
+
+static int push(const char *fmt, ...)
+{
+    int retval;
+    va_list ap;
+    va_start(ap, fmt);
+    retval = rtapi_msgring_vpush(&r.ring, RTAPI_MSG_ERR, 0, fmt, ap);
+    va_end(ap);
+    return retval;
+}
+
+static void pop(char *buf, size_t size)
+{
+    rtapi_msgring_slot_t *s = rtapi_msgring_peek(&r.ring);
+    if(!s) {
+	snprintf(buf, size, "(empty)");
+	return;
+    }
+    rtapi_msgring_format(buf, size, s);
+    rtapi_msgring_release(&r.ring, s);
+}
+
+static void check(const char *what, const char *got, const char *want)
+{
+    printf("%-12s %s", what, got);
+    if(strcmp(got, want)) {
+	fail++;
+	printf(" ****fail**** expected %s", want);
+    }
+    printf("\n");
+}
+
+/* formats the same way snprintf does */
+#define SAME(fmt, ...) do { \
+	char got[256], want[256]; \
+	push(fmt, __VA_ARGS__); \
+	pop(got, sizeof(got)); \
+	snprintf(want, sizeof(want), fmt, __VA_ARGS__); \
+	check(fmt, got, want); \
+    } while(0)
+
+#define NTHREADS 4
+#define PERTHREAD 20000
+
+/* set by the reader when it gives up, so the writers do not wait for
+   room forever */
+int stop;
+/* writers that are done */
+int done;
+
+static void *producer(void *arg)
+{
+    long n = (long)arg, i;
+    for(i = 0; i < PERTHREAD; i++) {
+	while(push("%ld %ld", n, i) < 0) {
+	    if(__atomic_load_n(&stop, __ATOMIC_RELAXED)) goto out;
+	    sched_yield();
+	}
+    }
+out:
+    __atomic_add_fetch(&done, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int main()
+{
+    char buf[256], want[256], big[300], fmt[16];
+    struct {
+	char s[4];
+	char after[PAYLOAD * 2];
+    } unterminated;
+    long next[NTHREADS] = {0};
+    pthread_t t[NTHREADS];
+    long i, n, k, got;
+
+    if(rtapi_msgring_init(&r.ring, 48, PAYLOAD) == 0) {
+	fail++;
+	printf("****fail**** accepted 48 slots\n");
+    }
+    rtapi_msgring_init(&r.ring, NSLOTS, PAYLOAD);
+
+    SAME("%d %i %u %x %X %o", -1, 42, 3000000000u, 0xbeef, 0xbeef, 8);
+    SAME("%hhd %hd %ld %lld %lu %llx", (signed char)-3, (short)-30000,
+	-123456789L, -1234567890123LL, 4000000000UL, 0x123456789abcULL);
+    SAME("%zu %zd %jd %td", (size_t)12345, (ssize_t)-5, (intmax_t)-7,
+	(ptrdiff_t)-9);
+    SAME("%f %.3f %e %g %a %Lf", 3.14159, -2.5, 1e-10, 1e300, 0.5,
+	(long double)1.25);
+    SAME("[%5d] [%-5d] [%05d] [%+d] [%#x]", 1, 2, 3, 4, 255);
+    SAME("[%*d] [%-*.*f] [%.*s]", 6, 7, 10, 2, 1.0, 3, "abcdef");
+    SAME("%s:%c:%%:%s", "joint", 'x', "");
+    SAME("%p %s", (void *)&r, "end\n");
+    SAME("tail %d text", 5);
+    SAME("[%.3s] [%.*s] [%.*s] [%.0s]", "abcdef", 2, "xyz", -1, "neg", "q");
+
+    /* with a precision, a string need not be terminated */
+    memcpy(unterminated.s, "abcd", 4);
+    memset(unterminated.after, 'x', sizeof(unterminated.after) - 1);
+    unterminated.after[sizeof(unterminated.after) - 1] = 0;
+    push("%.4s|%.*s|%d", unterminated.s, 4, unterminated.s, 7);
+    pop(buf, sizeof(buf));
+    check("precision", buf, "abcd|abcd|7");
+
+    /* a string that does not fit is cut short */
+    memset(big, 'a', sizeof(big) - 1);
+    big[sizeof(big) - 1] = 0;
+    push("%d %s %d\n", 1, big, 2);
+    pop(buf, sizeof(buf));
+    n = strlen(buf);
+    check("cut", n > 4 && !strcmp(buf + n - 4, "...\n") && !strncmp(buf, "1 aaa", 5)
+	? "ok" : buf, "ok");
+
+    /* arguments after a full buffer are dropped */
+    push("%s %d %d", big + 300 - PAYLOAD + 8, 3, 4);
+    pop(buf, sizeof(buf));
+    n = strlen(buf);
+    check("cut2", n > 3 && !strcmp(buf + n - 3, "...") ? "ok" : buf, "ok");
+
+    /* the format is kept with the message, it may be gone by the time
+       the message is read */
+    snprintf(fmt, sizeof(fmt), "temp %%d\n");
+    push(fmt, 9);
+    memset(fmt, 'z', sizeof(fmt) - 1);
+    pop(buf, sizeof(buf));
+    check("fmt copy", buf, "temp 9\n");
+
+    /* so is as much of a long format as fits, and the line still ends */
+    big[200] = '\n';
+    big[201] = 0;
+    push(big);
+    pop(buf, sizeof(buf));
+    n = strlen(buf);
+    check("fmt cut", n > 4 && !strcmp(buf + n - 4, "...\n") && !strncmp(buf, "aaa", 3)
+	? "ok" : buf, "ok");
+
+    /* a full ring drops and counts */
+    for(i = 0; i < NSLOTS + 5; i++) {
+	push("%ld", i);
+    }
+    snprintf(want, sizeof(want), "%u", 5);
+    snprintf(buf, sizeof(buf), "%u", rtapi_msgring_lost(&r.ring));
+    check("lost", buf, want);
+    for(i = 0; i < NSLOTS; i++) {
+	pop(buf, sizeof(buf));
+	snprintf(want, sizeof(want), "%ld", i);
+	if(strcmp(buf, want)) break;
+    }
+    check("order", i == NSLOTS ? "ok" : buf, "ok");
+    pop(buf, sizeof(buf));
+    check("empty", buf, "(empty)");
+
+    /* several writers at once, each in order and nothing lost */
+    for(n = 0; n < NTHREADS; n++) {
+	pthread_create(&t[n], 0, producer, (void *)n);
+    }
+    for(k = 0; k < NTHREADS * PERTHREAD; ) {
+	rtapi_msgring_slot_t *s = rtapi_msgring_peek(&r.ring);
+	if(!s) {
+	    /* a message went missing */
+	    if(__atomic_load_n(&done, __ATOMIC_ACQUIRE) == NTHREADS
+		&& !rtapi_msgring_peek(&r.ring)) {
+		snprintf(buf, sizeof(buf), "%ld of %d messages", k,
+		    NTHREADS * PERTHREAD);
+		break;
+	    }
+	    sched_yield();
+	    continue;
+	}
+	rtapi_msgring_format(buf, sizeof(buf), s);
+	rtapi_msgring_release(&r.ring, s);
+	if(sscanf(buf, "%ld %ld", &n, &got) != 2 || n < 0 || n >= NTHREADS
+	    || got != next[n]) {
+	    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+	    break;
+	}
+	next[n]++;
+	k++;
+    }
+    for(n = 0; n < NTHREADS; n++) {
+	pthread_join(t[n], 0);
+    }
+    check("threads", k == NTHREADS * PERTHREAD ? "ok" : buf, "ok");
+
+    return fail ? 1 : 0;
+}
@@ -64,9 +64,49 @@ TEST pmCartCartAntiParallel_numerical() {
 }
 
 
+TEST findJointLimitedVelAcc_linear() {
+    // joint 0 moves twice as far as the path, joint 1 not at all, and
+    // joint 2 is not active
+    double q_s[3] = {2.0, 0.0, 5.0};
+    double q_ss[3] = {0.0, 0.0, 0.0};
+    double joint_vel[3] = {10.0, 1.0, 0.0};
+    double joint_acc[3] = {100.0, 1.0, 0.0};
+    double v_max = 50.0, a_max = 500.0;
+
+    ASSERT_EQ(findJointLimitedVelAcc(q_s, q_ss, joint_vel, joint_acc, 3, &v_max, &a_max), TP_ERR_OK);
+    ASSERT_IN_RANGE(5.0, v_max, 1e-12);
+    ASSERT_IN_RANGE(50.0, a_max, 1e-12);
+
+    // limits that are low enough already stay
+    v_max = 1.0;
+    a_max = 2.0;
+    findJointLimitedVelAcc(q_s, q_ss, joint_vel, joint_acc, 3, &v_max, &a_max);
+    ASSERT_IN_RANGE(1.0, v_max, 1e-12);
+    ASSERT_IN_RANGE(2.0, a_max, 1e-12);
+    PASS();
+}
+
+TEST findJointLimitedVelAcc_curved() {
+    double q_s[1] = {1.0};
+    double q_ss[1] = {2.0};
+    double joint_vel[1] = {100.0};
+    double joint_acc[1] = {100.0};
+    double v_max = 50.0, a_max = 500.0;
+
+    findJointLimitedVelAcc(q_s, q_ss, joint_vel, joint_acc, 1, &v_max, &a_max);
+    // the curvature may use up to half of the joint acceleration
+    double v_expect = sqrt((1.0 - BLEND_ACC_RATIO_TANGENTIAL) * 100.0 / 2.0);
+    ASSERT_IN_RANGE(v_expect, v_max, 1e-12);
+    // and the joint never accelerates more than its limit
+    ASSERT(q_s[0] * a_max + q_ss[0] * v_max * v_max <= joint_acc[0] + 1e-9);
+    PASS();
+}
+
  SUITE(blendmath) {
      RUN_TEST(pmCartCartParallel_numerical);
      RUN_TEST(pmCartCartAntiParallel_numerical);
+     RUN_TEST(findJointLimitedVelAcc_linear);
+     RUN_TEST(findJointLimitedVelAcc_curved);
 
  }
 